@@ -0,0 +1,438 @@
+/*
+ * Copyright (c) 1991-2016 Kawahara Lab., Kyoto University
+ * Copyright (c) 2000-2005 Shikano Lab., Nara Institute of Science and Technology
+ * Copyright (c) 2005-2016 Julius project team, Nagoya Institute of Technology
+ * All rights reserved
+ */
+
+/* gmm-bench --- measure GMM computation time per frame */
+
+/*
+ * The GMM scores computed by gmm_proceed() (all Gaussians packed in one
+ * table) are compared with the former per-GMM computation, which is
+ * kept here as a reference: each GMM is computed by walking its
+ * Gaussians one at a time with the safe pruning.  The input is read
+ * from an HTK parameter file, or generated from the GMM itself when
+ * not given.
+ */
+
+#include <julius/juliuslib.h>
+#include <time.h>
+
+static int gprune_num = 10;
+static int topk = 0;
+static int framenum = 3000;
+static int loopnum = 10;
+static unsigned int seed = 1;
+
+/**********************************************************************/
+/* reference: former per-GMM computation with safe pruning */
+
+typedef struct {
+  short nstream;
+  short veclen_stream[MAXSTREAMNUM];
+  VECT *vec_stream[MAXSTREAMNUM];
+  VECT *vec;
+  short veclen;
+  LOGPROB *calced_score;
+  int *calced_id;
+  int calced_num;
+  int gprune_num;
+} RefCalc;
+
+static int
+ref_find_insert_point(RefCalc *rc, LOGPROB score, int len)
+{
+  int left = 0;
+  int right = len - 1;
+  int mid;
+
+  while (left < right) {
+    mid = (left + right) / 2;
+    if (rc->calced_score[mid] > score) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return(left);
+}
+
+static int
+ref_cache_push(RefCalc *rc, int id, LOGPROB score, int len)
+{
+  int insertp;
+
+  if (len == 0) {
+    rc->calced_score[0] = score;
+    rc->calced_id[0] = id;
+    return(1);
+  }
+  if (rc->calced_score[len-1] >= score) {
+    if (len < rc->gprune_num) {
+      rc->calced_score[len] = score;
+      rc->calced_id[len] = id;
+      len++;
+    }
+    return len;
+  }
+  if (rc->calced_score[0] < score) {
+    insertp = 0;
+  } else {
+    insertp = ref_find_insert_point(rc, score, len);
+  }
+  if (len < rc->gprune_num) {
+    memmove(&(rc->calced_score[insertp+1]), &(rc->calced_score[insertp]), sizeof(LOGPROB)*(len - insertp));
+    memmove(&(rc->calced_id[insertp+1]), &(rc->calced_id[insertp]), sizeof(int)*(len - insertp));
+  } else if (insertp < len - 1) {
+    memmove(&(rc->calced_score[insertp+1]), &(rc->calced_score[insertp]), sizeof(LOGPROB)*(len - insertp - 1));
+    memmove(&(rc->calced_id[insertp+1]), &(rc->calced_id[insertp]), sizeof(int)*(len - insertp - 1));
+  }
+  rc->calced_score[insertp] = score;
+  rc->calced_id[insertp] = id;
+  if (len < rc->gprune_num) len++;
+  return(len);
+}
+
+static LOGPROB
+ref_compute_g_base(RefCalc *rc, HTK_HMM_Dens *binfo)
+{
+  VECT tmp, x;
+  VECT *mean;
+  VECT *var;
+  VECT *vec = rc->vec;
+  short veclen = rc->veclen;
+
+  if (binfo == NULL) return(LOG_ZERO);
+  mean = binfo->mean;
+  var = binfo->var->vec;
+  tmp = 0.0;
+  for (; veclen > 0; veclen--) {
+    x = *(vec++) - *(mean++);
+    tmp += x * x * *(var++);
+  }
+  return((tmp + binfo->gconst) * -0.5);
+}
+
+static LOGPROB
+ref_compute_g_safe(RefCalc *rc, HTK_HMM_Dens *binfo, LOGPROB thres)
+{
+  VECT tmp, x;
+  VECT *mean;
+  VECT *var;
+  VECT *vec = rc->vec;
+  short veclen = rc->veclen;
+  VECT fthres = thres * (-2.0);
+
+  if (binfo == NULL) return(LOG_ZERO);
+  mean = binfo->mean;
+  var = binfo->var->vec;
+  tmp = binfo->gconst;
+  for (; veclen > 0; veclen--) {
+    x = *(vec++) - *(mean++);
+    tmp += x * x * *(var++);
+    if (tmp > fthres)  return LOG_ZERO;
+  }
+  return(tmp * -0.5);
+}
+
+static void
+ref_gprune_safe(RefCalc *rc, HTK_HMM_Dens **g, int gnum)
+{
+  int i, num = 0;
+  LOGPROB score, thres;
+
+  thres = LOG_ZERO;
+  for (i = 0; i < gnum; i++) {
+    if (num < rc->gprune_num) {
+      score = ref_compute_g_base(rc, g[i]);
+    } else {
+      score = ref_compute_g_safe(rc, g[i], thres);
+      if (score <= thres) continue;
+    }
+    num = ref_cache_push(rc, i, score, num);
+    thres = rc->calced_score[num-1];
+  }
+  rc->calced_num = num;
+}
+
+static LOGPROB
+ref_calc_mix(RefCalc *rc, HTK_HMM_State *state)
+{
+  int i;
+  LOGPROB logprob, logprobsum;
+  int s;
+  PROB stream_weight;
+
+  logprobsum = 0.0;
+  for(s=0;s<rc->nstream;s++) {
+    if (state->w) stream_weight = state->w->weight[s];
+    else stream_weight = 1.0;
+    rc->vec = rc->vec_stream[s];
+    rc->veclen = rc->veclen_stream[s];
+    ref_gprune_safe(rc, state->pdf[s]->b, state->pdf[s]->mix_num);
+    for(i=0;i<rc->calced_num;i++) {
+      rc->calced_score[i] += state->pdf[s]->bweight[rc->calced_id[i]];
+    }
+    logprob = addlog_array(rc->calced_score, rc->calced_num);
+    if (logprob <= LOG_ZERO) continue;
+    logprobsum += logprob * stream_weight;
+  }
+  if (logprobsum == 0.0) return(LOG_ZERO);
+  if (logprobsum <= LOG_ZERO) return(LOG_ZERO);
+  return (logprob * INV_LOG_TEN);
+}
+
+/* compute scores of all GMMs at frame t by the reference */
+static void
+ref_proceed(RefCalc *rc, HTK_HMM_INFO *gmm, HTK_Param *param, int t, LOGPROB *score)
+{
+  HTK_HMM_Data *d;
+  int i, s, k;
+
+  for(k=0,s=0;s<rc->nstream;s++) {
+    rc->vec_stream[s] = &(param->parvec[t][k]);
+    k += rc->veclen_stream[s];
+  }
+  i = 0;
+  for(d=gmm->start;d;d=d->next) {
+    score[i++] = ref_calc_mix(rc, d->s[1]);
+  }
+}
+
+/**********************************************************************/
+
+/* standard normal random value */
+static double
+gauss_rand()
+{
+  double u1, u2;
+
+  u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+  u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+  return(sqrt(-2.0 * log(u1)) * cos(2.0 * PI * u2));
+}
+
+/* generate input frames from randomly chosen Gaussians of the GMM,
+   should be called before the variances are inversed */
+static HTK_Param *
+generate_param(HTK_HMM_INFO *gmm, int num)
+{
+  HTK_Param *param;
+  HTK_HMM_Data *d;
+  HTK_HMM_PDF *pdf;
+  HTK_HMM_Dens *b;
+  int t, c, s, k, dim;
+
+  param = new_param();
+  param->veclen = gmm->opt.vec_size;
+  param->samplenum = num;
+  param->header.samplenum = num;
+  param->header.samptype = gmm->opt.param_type;
+  param->header.sampsize = sizeof(VECT) * param->veclen;
+  param->header.wshift = 100000;
+  if (param_alloc(param, num, param->veclen) == FALSE) return NULL;
+  for(t=0;t<num;t++) {
+    c = rand() % gmm->totalhmmnum;
+    for(d=gmm->start;c>0;d=d->next) c--;
+    for(dim=0,s=0;s<gmm->opt.stream_info.num;s++) {
+      pdf = d->s[1]->pdf[s];
+      b = NULL;
+      while (b == NULL) b = pdf->b[rand() % pdf->mix_num];
+      for(k=0;k<gmm->opt.stream_info.vsize[s];k++) {
+	param->parvec[t][dim + k] = b->mean[k] + sqrt(b->var->vec[k]) * gauss_rand();
+      }
+      dim += gmm->opt.stream_info.vsize[s];
+    }
+  }
+  return param;
+}
+
+static float
+elapsed_ms(clock_t start)
+{
+  return((float)(clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+}
+
+static void
+usage(char *s)
+{
+  fprintf(stderr, "%s: measure GMM computation time per frame\n", s);
+  fprintf(stderr, "usage: %s [options] gmmdefs [paramfile]\n", s);
+  fprintf(stderr, "  paramfile: HTK parameter file as input (default: generated from GMM)\n");
+  fprintf(stderr, "options:\n");
+  fprintf(stderr, "   -gmmnum N          number of Gaussians computed per GMM (%d)\n", gprune_num);
+  fprintf(stderr, "   -gmmtopk N         also measure shared top-N pruning (off)\n");
+  fprintf(stderr, "   -frames N          number of frames to generate (%d)\n", framenum);
+  fprintf(stderr, "   -loop N            repeat N times over the input (%d)\n", loopnum);
+  fprintf(stderr, "   -seed N            random seed for generation (%u)\n", seed);
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  char *gmmfile = NULL, *paramfile = NULL;
+  HTK_HMM_INFO *gmm;
+  HTK_Param *param;
+  Jconf *jconf;
+  Recog *recog;
+  MFCCCalc *mfcc;
+  RefCalc rc;
+  LOGPROB *ref, *cur;
+  LOGPROB diff, maxdiff;
+  int i, c, t, l, n, nc, ngauss;
+  int argmax_ref, argmax_cur, mismatch;
+  clock_t start;
+  float ms_ref, ms_pack, ms_topk;
+
+  for(i=1;i<argc;i++) {
+    if (argv[i][0] == '-') {
+      if (i + 1 >= argc) usage(argv[0]);
+      if (strmatch(argv[i], "-gmmnum")) {
+	gprune_num = atoi(argv[++i]);
+      } else if (strmatch(argv[i], "-gmmtopk")) {
+	topk = atoi(argv[++i]);
+      } else if (strmatch(argv[i], "-frames")) {
+	framenum = atoi(argv[++i]);
+      } else if (strmatch(argv[i], "-loop")) {
+	loopnum = atoi(argv[++i]);
+      } else if (strmatch(argv[i], "-seed")) {
+	seed = atoi(argv[++i]);
+      } else {
+	usage(argv[0]);
+      }
+    } else if (gmmfile == NULL) {
+      gmmfile = argv[i];
+    } else if (paramfile == NULL) {
+      paramfile = argv[i];
+    } else {
+      usage(argv[0]);
+    }
+  }
+  if (gmmfile == NULL || gprune_num < 1 || framenum < 1 || loopnum < 1) usage(argv[0]);
+
+  jlog_set_output(NULL);
+  /* log addition table used by addlog_array() */
+  make_log_tbl();
+
+  /* read GMM */
+  gmm = hmminfo_new();
+  if (init_hmminfo(gmm, gmmfile, NULL, NULL) == FALSE) {
+    fprintf(stderr, "Error: failed to read GMM \"%s\"\n", gmmfile);
+    return -1;
+  }
+
+  /* read or generate input */
+  srand(seed);
+  if (paramfile) {
+    param = new_param();
+    if (rdparam(paramfile, param) == FALSE) {
+      fprintf(stderr, "Error: failed to read \"%s\"\n", paramfile);
+      return -1;
+    }
+    if (param->veclen != gmm->opt.vec_size) {
+      fprintf(stderr, "Error: vector length mismatch: input %d, GMM %d\n", param->veclen, gmm->opt.vec_size);
+      return -1;
+    }
+  } else {
+    if ((param = generate_param(gmm, framenum)) == NULL) return -1;
+  }
+
+  /* set up a minimal instance for gmm.c */
+  jconf = j_jconf_new();
+  jconf->reject.gmm_gprune_num = gprune_num;
+  jconf->reject.gmm_shared_topk = 0;
+  recog = j_recog_new();
+  recog->jconf = jconf;
+  recog->gmm = gmm;
+  mfcc = (MFCCCalc *)mymalloc(sizeof(MFCCCalc));
+  memset(mfcc, 0, sizeof(MFCCCalc));
+  mfcc->param = param;
+  mfcc->valid = TRUE;
+  recog->gmmmfcc = mfcc;
+  if (gmm_init(recog) == FALSE) return -1;
+
+  /* reference work area */
+  rc.nstream = gmm->opt.stream_info.num;
+  for(i=0;i<rc.nstream;i++) rc.veclen_stream[i] = gmm->opt.stream_info.vsize[i];
+  rc.gprune_num = gprune_num;
+  rc.calced_score = (LOGPROB *)mymalloc(sizeof(LOGPROB) * gmm->maxmixturenum * rc.nstream);
+  rc.calced_id = (int *)mymalloc(sizeof(int) * gmm->maxmixturenum * rc.nstream);
+
+  nc = gmm->totalhmmnum;
+  n = param->samplenum;
+  ngauss = 0;
+  for(i=0;i<rc.nstream;i++) ngauss += recog->gc->pack[i].num;
+  printf("GMM: %d models, %d Gaussians, %d dims\n", nc, ngauss, gmm->opt.vec_size);
+  printf("input: %d frames%s, %d loops, gmmnum = %d\n", n, paramfile ? "" : " (generated)", loopnum, gprune_num);
+
+  ref = (LOGPROB *)mymalloc(sizeof(LOGPROB) * nc);
+
+  /* timing */
+  start = clock();
+  for(l=0;l<loopnum;l++) {
+    for(t=0;t<n;t++) ref_proceed(&rc, gmm, param, t, ref);
+  }
+  ms_ref = elapsed_ms(start);
+  start = clock();
+  for(l=0;l<loopnum;l++) {
+    gmm_prepare(recog);
+    for(t=0;t<n;t++) {
+      mfcc->f = t;
+      gmm_proceed(recog);
+    }
+  }
+  ms_pack = elapsed_ms(start);
+  ms_topk = 0.0;
+  if (topk > 0) {
+    recog->gc->pack_topk = topk;
+    start = clock();
+    for(l=0;l<loopnum;l++) {
+      gmm_prepare(recog);
+      for(t=0;t<n;t++) {
+	mfcc->f = t;
+	gmm_proceed(recog);
+      }
+    }
+    ms_topk = elapsed_ms(start);
+  }
+
+  printf("reference (per GMM): %8.3f us/frame\n", ms_ref * 1000.0 / (n * loopnum));
+  printf("packed:              %8.3f us/frame  (x%.2f)\n", ms_pack * 1000.0 / (n * loopnum), ms_ref / ms_pack);
+  if (topk > 0) {
+    printf("packed, top %-4d     %8.3f us/frame  (x%.2f)\n", topk, ms_topk * 1000.0 / (n * loopnum), ms_ref / ms_topk);
+  }
+
+  /* compare frame scores with the reference */
+  for(l=0;l<=(topk > 0 ? 1 : 0);l++) {
+    recog->gc->pack_topk = (l == 0) ? 0 : topk;
+    gmm_prepare(recog);
+    maxdiff = 0.0;
+    mismatch = 0;
+    for(t=0;t<n;t++) {
+      ref_proceed(&rc, gmm, param, t, ref);
+      /* clear the accumulator to get the score of this frame */
+      for(c=0;c<nc;c++) recog->gc->gmm_score[c] = 0.0;
+      mfcc->f = t;
+      gmm_proceed(recog);
+      cur = recog->gc->gmm_score;
+      argmax_ref = argmax_cur = 0;
+      for(c=0;c<nc;c++) {
+	diff = cur[c] - ref[c];
+	if (diff < 0.0) diff = -diff;
+	if (maxdiff < diff) maxdiff = diff;
+	if (ref[c] > ref[argmax_ref]) argmax_ref = c;
+	if (cur[c] > cur[argmax_cur]) argmax_cur = c;
+      }
+      if (argmax_ref != argmax_cur) mismatch++;
+    }
+    if (l == 0) {
+      printf("packed: max frame score diff = %g, best model differs on %d frames\n", maxdiff, mismatch);
+    } else {
+      printf("top %d: max frame score diff = %g, best model differs on %d frames\n", topk, maxdiff, mismatch);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,477 @@
+/*
+ * Copyright (c) 1991-2016 Kawahara Lab., Kyoto University
+ * Copyright (c) 2000-2005 Shikano Lab., Nara Institute of Science and Technology
+ * Copyright (c) 2005-2016 Julius project team, Nagoya Institute of Technology
+ * All rights reserved
+ */
+
+/* module-bench --- compare XML and binary output of module mode */
+
+/*
+ * The given julius command is run twice in module mode, with a client
+ * that switches its output format to XML and to binary by the
+ * OUTPUTFORMAT command.  For each format, the bytes received, the CPU
+ * time of julius, and the time for the client to parse the received
+ * data are reported.  The XML data is parsed into tags and unescaped
+ * attribute values, and the binary data is decoded into values and
+ * word strings, as a client would do.
+ *
+ * Julius executes the command before, during or after the first input,
+ * so the output of the first input may be in either format.  Only the
+ * inputs that start after the switch in both sessions, i.e. the last
+ * ones, are measured.  The bytes before them, including the vocabulary
+ * sent at the switch in binary, are reported apart, and the vocabulary
+ * is decoded before the measurement.  The input should be two or more
+ * files (-input rawfile etc.) so that julius exits at the end of the
+ * input.  POSIX only.
+ */
+
+#include <julius/juliuslib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+static int port = 10599;
+static int loopnum = 100;
+
+/* frame types, should be the same as MODULE_BIN_* in julius/app.h */
+#define BIN_HEADLEN 8
+#define BIN_TEXT 1
+#define BIN_PASS1_INTERIM 2
+#define BIN_PASS1 3
+#define BIN_RESULT 4
+#define BIN_GRAPH 5
+#define BIN_GMM 6
+#define BIN_VOCA 7
+#define BIN_PASS1_DETERMINED 8
+
+/// Received data of a session
+typedef struct {
+  char *buf;			///< Data received after the format switch
+  int len;			///< Length of @a buf
+  int skip;			///< Offset of the measured inputs in @a buf
+  int inputnum;			///< Number of inputs started after the switch
+  int alloc;			///< Allocated size of @a buf
+  double cpu;			///< CPU time of julius in seconds
+} Session;
+
+/**********************************************************************/
+/* run julius and receive the output */
+
+static void
+append(Session *s, char *data, int len)
+{
+  if (s->len + len + 1 > s->alloc) {
+    while (s->len + len + 1 > s->alloc) s->alloc *= 2;
+    s->buf = (char *)myrealloc(s->buf, s->alloc);
+  }
+  memcpy(&(s->buf[s->len]), data, len);
+  s->len += len;
+  s->buf[s->len] = '\0';
+}
+
+static int
+connect_server()
+{
+  struct sockaddr_in addr;
+  int sd, i;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+  /* wait for julius to load models */
+  for(i=0;i<600;i++) {
+    if ((sd = socket(AF_INET, SOCK_STREAM, 0)) < 0) return -1;
+    if (connect(sd, (struct sockaddr *)&addr, sizeof(addr)) == 0) return sd;
+    close(sd);
+    usleep(100000);
+  }
+  return -1;
+}
+
+/* offset of the n-th input in data after the switch, or the number of
+   inputs if n < 0 */
+static int
+find_input(Session *s, boolean binary, int n)
+{
+  char *listen = "<INPUT STATUS=\"LISTEN\"";
+  char *p, *end;
+  int flen, k;
+
+  k = 0;
+  if (! binary) {
+    for(p = s->buf; (p = strstr(p, listen)) != NULL; p++) {
+      if (k++ == n) return(p - s->buf);
+    }
+    return(n < 0 ? k : -1);
+  }
+  end = s->buf + s->len;
+  for(p = s->buf; p + BIN_HEADLEN <= end; p += BIN_HEADLEN + flen) {
+    flen = (unsigned char)p[4] | ((unsigned char)p[5] << 8) | ((unsigned char)p[6] << 16) | ((unsigned char)p[7] << 24);
+    if (flen < 0 || flen > end - p - BIN_HEADLEN) break;
+    if (p[0] == BIN_TEXT && p[1] == 0 && p[2] == 0 && p[3] == 0
+	&& flen >= strlen(listen) && strncmp(p + BIN_HEADLEN, listen, strlen(listen)) == 0) {
+      if (k++ == n) return(p - s->buf);
+    }
+  }
+  return(n < 0 ? k : -1);
+}
+
+/* run julius with a client of the format, and store data after the
+   switch of the format */
+static boolean
+run_session(char **cmd, int cmdlen, char *format, Session *s)
+{
+  char **args;
+  char portstr[16], ack[64], cmdstr[64];
+  char rbuf[65536];
+  int i, sd, n, status;
+  pid_t pid;
+  struct rusage ru;
+  char *p;
+  Session raw;
+
+  args = (char **)mymalloc(sizeof(char *) * (cmdlen + 3));
+  for(i=0;i<cmdlen;i++) args[i] = cmd[i];
+  snprintf(portstr, 16, "%d", port);
+  args[cmdlen] = "-module";
+  args[cmdlen+1] = portstr;
+  args[cmdlen+2] = NULL;
+
+  if ((pid = fork()) < 0) {
+    perror("fork");
+    return FALSE;
+  }
+  if (pid == 0) {
+    freopen("/dev/null", "w", stdout);
+    freopen("/dev/null", "w", stderr);
+    execvp(args[0], args);
+    _exit(127);
+  }
+  free(args);
+
+  if ((sd = connect_server()) < 0) {
+    fprintf(stderr, "Error: failed to connect to julius at port %d\n", port);
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+    return FALSE;
+  }
+  snprintf(cmdstr, 64, "OUTPUTFORMAT\n%s\n", format);
+  if (send(sd, cmdstr, strlen(cmdstr), 0) < 0) {
+    perror("send");
+    return FALSE;
+  }
+  raw.alloc = 65536;
+  raw.len = 0;
+  raw.buf = (char *)mymalloc(raw.alloc);
+  while ((n = recv(sd, rbuf, sizeof(rbuf), 0)) > 0) append(&raw, rbuf, n);
+  close(sd);
+  if (wait4(pid, &status, 0, &ru) < 0) {
+    perror("wait4");
+    return FALSE;
+  }
+  s->cpu = ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000000.0;
+
+  /* the acknowledgement is the last message in XML */
+  snprintf(ack, 64, "<OUTPUTFORMAT TYPE=\"%s\"/>\n.\n", format);
+  if ((p = strstr(raw.buf, ack)) == NULL) {
+    fprintf(stderr, "Error: julius did not switch to %s\n", format);
+    free(raw.buf);
+    return FALSE;
+  }
+  p += strlen(ack);
+  s->alloc = raw.len - (p - raw.buf) + 1;
+  s->len = 0;
+  s->buf = (char *)mymalloc(s->alloc);
+  append(s, p, raw.len - (p - raw.buf));
+  free(raw.buf);
+  s->inputnum = find_input(s, strmatch(format, "BINARY"), -1);
+
+  return TRUE;
+}
+
+/**********************************************************************/
+/* parse XML: tags and unescaped attribute values */
+
+static int
+parse_xml(char *buf, int len)
+{
+  char *p, *end, *v, *a;
+  char name[64], attr[64], value[1024];
+  int n, resultnum;
+
+  resultnum = 0;
+  end = buf + len;
+  for(p = buf; p < end; p++) {
+    if (*p != '<') continue;
+    p++;
+    if (*p == '/') continue;
+    for(n=0;p < end && *p != ' ' && *p != '>' && *p != '/' && n < 63;p++) name[n++] = *p;
+    name[n] = '\0';
+    /* attributes */
+    while (p < end && *p != '>') {
+      while (p < end && *p == ' ') p++;
+      for(a=attr;p < end && *p != '=' && *p != '>' && a < attr + 63;p++) *a++ = *p;
+      *a = '\0';
+      if (p >= end || *p == '>') break;
+      p += 2;			/* '="' */
+      v = value;
+      while (p < end && *p != '"' && v < value + 1023) {
+	if (*p == '&') {
+	  if (strncmp(p, "&lt;", 4) == 0) { *v++ = '<'; p += 4; }
+	  else if (strncmp(p, "&gt;", 4) == 0) { *v++ = '>'; p += 4; }
+	  else if (strncmp(p, "&quot;", 6) == 0) { *v++ = '"'; p += 6; }
+	  else if (strncmp(p, "&apos;", 6) == 0) { *v++ = '\''; p += 6; }
+	  else if (strncmp(p, "&amp;", 5) == 0) { *v++ = '&'; p += 5; }
+	  else *v++ = *p++;
+	} else {
+	  *v++ = *p++;
+	}
+      }
+      *v = '\0';
+      p++;
+      /* sentences of the 2nd pass have RANK */
+      if (strmatch(name, "SHYPO") && strmatch(attr, "RANK")) resultnum++;
+    }
+  }
+  return resultnum;
+}
+
+/**********************************************************************/
+/* decode binary frames */
+
+static unsigned char *bp, *bend;
+static int berror;
+static int unknown;		///< Number of word IDs not in VOCA
+static char **voca = NULL;	///< Word strings of the last VOCA frame
+static int vocanum = 0;		///< Number of words in @a voca
+
+static void
+free_voca()
+{
+  int i;
+  for(i=0;i<vocanum;i++) free(voca[i]);
+  if (voca) free(voca);
+  voca = NULL;
+  vocanum = 0;
+}
+
+static int
+get_int()
+{
+  int v;
+  if (bp + 4 > bend) {
+    berror = 1;
+    return 0;
+  }
+  v = (int)((unsigned int)bp[0] | ((unsigned int)bp[1] << 8) | ((unsigned int)bp[2] << 16) | ((unsigned int)bp[3] << 24));
+  bp += 4;
+  return v;
+}
+
+static float
+get_float()
+{
+  int v;
+  float f;
+  v = get_int();
+  memcpy(&f, &v, 4);
+  return f;
+}
+
+/* word string of a word ID */
+static char *
+word_str(int wid)
+{
+  if (wid >= 0 && wid < vocanum) return voca[wid];
+  return NULL;
+}
+
+static int
+parse_binary(unsigned char *buf, int len)
+{
+  unsigned char *p, *end;
+  int type, flen, num, wnum, i, n, slen;
+  int resultnum;
+  char *w;
+
+  resultnum = 0;
+  berror = 0;
+  unknown = 0;
+  end = buf + len;
+  for(p = buf; p + BIN_HEADLEN <= end; p += flen) {
+    bp = p;
+    bend = p + BIN_HEADLEN;
+    type = get_int();
+    flen = get_int();
+    p += BIN_HEADLEN;
+    if (flen < 0 || flen > end - p) break;
+    bp = p;
+    bend = p + flen;
+    switch(type) {
+    case BIN_VOCA:
+      get_int();
+      num = get_int();
+      free_voca();
+      voca = (char **)mymalloc(sizeof(char *) * (num > 0 ? num : 1));
+      for(i=0;i<num && !berror;i++) {
+	slen = get_int();
+	if (slen < 0 || slen > bend - bp) { berror = 1; break; }
+	voca[i] = (char *)mymalloc(slen + 1);
+	memcpy(voca[i], bp, slen);
+	voca[i][slen] = '\0';
+	bp += slen;
+      }
+      vocanum = i;
+      break;
+    case BIN_PASS1_INTERIM:
+    case BIN_PASS1:
+    case BIN_PASS1_DETERMINED:
+      get_int();
+      if (type != BIN_PASS1) get_int();
+      if (type != BIN_PASS1_DETERMINED) get_float();
+      wnum = get_int();
+      for(i=0;i<wnum && !berror;i++) {
+	w = word_str(get_int());
+	if (w == NULL) unknown++;
+      }
+      break;
+    case BIN_RESULT:
+      get_int();
+      if (get_int() < 0) break;
+      get_int();
+      num = get_int();
+      for(n=0;n<num && !berror;n++) {
+	resultnum++;
+	get_float();
+	get_float();
+	get_float();
+	get_int();
+	wnum = get_int();
+	for(i=0;i<wnum && !berror;i++) {
+	  w = word_str(get_int());
+	  if (w == NULL) unknown++;
+	  get_float();
+	  get_int();
+	  get_int();
+	}
+      }
+      break;
+    case BIN_GRAPH:
+      get_int();
+      num = get_int();
+      wnum = get_int();
+      for(i=0;i<num && !berror;i++) {
+	get_int();
+	w = word_str(get_int());
+	if (w == NULL) unknown++;
+	get_int();
+	get_int();
+	get_float();
+	get_float();
+      }
+      for(i=0;i<wnum && !berror;i++) {
+	get_int();
+	get_int();
+      }
+      break;
+    default:
+      /* TEXT and GMM are not decoded */
+      break;
+    }
+    if (berror) {
+      fprintf(stderr, "Error: broken frame of type %d\n", type);
+      break;
+    }
+  }
+  return resultnum;
+}
+
+/**********************************************************************/
+
+static double
+elapsed_ms(clock_t start)
+{
+  return((double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+}
+
+static void
+usage(char *s)
+{
+  fprintf(stderr, "%s: compare XML and binary output of julius module mode\n", s);
+  fprintf(stderr, "usage: %s [-port N] [-loop N] julius [julius options...]\n", s);
+  fprintf(stderr, "   -port N            module port number (%d)\n", port);
+  fprintf(stderr, "   -loop N            times to parse the received data (%d)\n", loopnum);
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  Session xml, bin;
+  int i, l, xres, bres, num;
+  clock_t start;
+  double xms, bms;
+
+  xres = bres = 0;
+  for(i=1;i<argc;i++) {
+    if (argv[i][0] != '-') break;
+    if (i + 1 >= argc) usage(argv[0]);
+    if (strmatch(argv[i], "-port")) {
+      port = atoi(argv[++i]);
+    } else if (strmatch(argv[i], "-loop")) {
+      loopnum = atoi(argv[++i]);
+    } else {
+      usage(argv[0]);
+    }
+  }
+  if (i >= argc || loopnum < 1) usage(argv[0]);
+
+  if (run_session(&(argv[i]), argc - i, "XML", &xml) == FALSE) return -1;
+  if (run_session(&(argv[i]), argc - i, "BINARY", &bin) == FALSE) return -1;
+
+  /* the last inputs started after the switch in both sessions */
+  num = (xml.inputnum < bin.inputnum) ? xml.inputnum : bin.inputnum;
+  if (num < 1) {
+    fprintf(stderr, "Error: no input after the switch, give two or more input files\n");
+    return -1;
+  }
+  xml.skip = find_input(&xml, FALSE, xml.inputnum - num);
+  bin.skip = find_input(&bin, TRUE, bin.inputnum - num);
+  /* vocabulary sent at the switch */
+  parse_binary((unsigned char *)bin.buf, bin.skip);
+
+  start = clock();
+  for(l=0;l<loopnum;l++) xres = parse_xml(xml.buf + xml.skip, xml.len - xml.skip);
+  xms = elapsed_ms(start) / loopnum;
+  start = clock();
+  for(l=0;l<loopnum;l++) bres = parse_binary((unsigned char *)bin.buf + bin.skip, bin.len - bin.skip);
+  bms = elapsed_ms(start) / loopnum;
+
+  printf("%d inputs\n", num);
+  printf("                XML        binary\n");
+  printf("bytes     %10d    %10d  (x%.2f)\n", xml.len - xml.skip, bin.len - bin.skip, (double)(xml.len - xml.skip) / (double)(bin.len - bin.skip));
+  printf(" (before) %10d    %10d\n", xml.skip, bin.skip);
+  printf("julius CPU  %8.2f s    %8.2f s\n", xml.cpu, bin.cpu);
+  printf("parse       %8.3f ms   %8.3f ms\n", xms, bms);
+  printf("sentences %10d    %10d\n", xres, bres);
+  if (unknown > 0) {
+    printf("Warning: %d word IDs not found in VOCA\n", unknown);
+  }
+  if (xres != bres) {
+    printf("Warning: number of sentences differs\n");
+  }
+
+  free_voca();
+  free(bin.buf);
+  free(xml.buf);
+
+  return 0;
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 1991-2016 Kawahara Lab., Kyoto University
+ * Copyright (c) 2000-2005 Shikano Lab., Nara Institute of Science and Technology
+ * Copyright (c) 2005-2016 Julius project team, Nagoya Institute of Technology
+ * All rights reserved
+ */
+
+/* ngram-check --- compare ngram_prob_batch() with ngram_prob() */
+
+/*
+ * Every context tuple in the N-gram (up to -max of them) and random
+ * word sequences are set by ngram_context_set(), and the probabilities
+ * of the words following them by ngram_prob_batch() are compared with
+ * ngram_prob().  The words are the successors of the context plus
+ * random ones, given both in ascending and in shuffled order.  The
+ * results should be exactly the same.  Contexts that have no successor
+ * tuple are counted, since their back-off weight is handled apart from
+ * the successor range in the batch computation.  The successors are
+ * found by looking up every word, so a large N-gram takes a while.
+ */
+
+#include <julius/juliuslib.h>
+
+static int maxctx = 100000;
+static int randnum = 10000;
+static int wordnum = 32;
+static unsigned int seed = 1;
+
+static NGRAM_INFO *ngram;
+static NGRAM_CONTEXT ctx;
+static WORD_ID *wlist, *wshuf, *wbuf;
+static LOGPROB *pbatch;
+static int checked, lookups, mismatch, nosucc, nosucc_bo;
+
+/* random integer in [0..n-1] */
+static int
+rnd(int n)
+{
+  return((int)((double)rand() / ((double)RAND_MAX + 1.0) * n));
+}
+
+static int
+compare_wid(WORD_ID *a, WORD_ID *b)
+{
+  if (*a < *b) return -1;
+  if (*a > *b) return 1;
+  return 0;
+}
+
+/* compare the batch result of a word list with ngram_prob() */
+static void
+check_list(WORD_ID *c, int len, WORD_ID *w, int num)
+{
+  LOGPROB p;
+  int i, k;
+
+  ngram_prob_batch(ngram, &ctx, w, num, pbatch);
+  for(i=0;i<len;i++) wbuf[i] = c[i];
+  for(k=0;k<num;k++) {
+    wbuf[len] = w[k];
+    p = ngram_prob(ngram, len + 1, wbuf);
+    lookups++;
+    if (p != pbatch[k]) {
+      if (mismatch < 10) {
+	printf("mismatch: [");
+	for(i=0;i<len;i++) printf(" %s", ngram->wname[c[i]]);
+	printf(" ] %s: ngram_prob %f, batch %f\n", ngram->wname[w[k]], p, pbatch[k]);
+      }
+      mismatch++;
+    }
+  }
+}
+
+/* find words following a context in the N-gram */
+static int
+find_successors(WORD_ID *c, int len, WORD_ID *succ)
+{
+  WORD_ID w;
+  int num;
+
+  num = 0;
+  for(w=0;w<ngram->max_word_num;w++) {
+    c[len] = w;
+    if (search_ngram(ngram, len + 1, c) != NNID_INVALID) succ[num++] = w;
+  }
+  return num;
+}
+
+/* check a context with the given words and random words */
+static void
+check_context(WORD_ID *c, int len, WORD_ID *succ, int succnum)
+{
+  WORD_ID id;
+  int i, j, num;
+
+  ngram_context_set(&ctx, ngram, c, len);
+
+  num = 0;
+  for(i=0;i<succnum && i<wordnum;i++) wlist[num++] = succ[i];
+  for(i=0;i<wordnum;i++) wlist[num++] = rnd(ngram->max_word_num);
+  qsort(wlist, num, sizeof(WORD_ID), (int (*)(const void *, const void *))compare_wid);
+  for(i=1,j=1;i<num;i++) if (wlist[i] != wlist[j-1]) wlist[j++] = wlist[i];
+  num = j;
+
+  check_list(c, len, wlist, num);
+  /* unsorted list restarts the scan */
+  for(i=0;i<num;i++) wshuf[i] = wlist[i];
+  for(i=num-1;i>0;i--) {
+    j = rnd(i + 1);
+    id = wshuf[i]; wshuf[i] = wshuf[j]; wshuf[j] = id;
+  }
+  check_list(c, len, wshuf, num);
+  checked++;
+}
+
+/* enumerate context tuples in the N-gram by depth-first search */
+static void
+enum_context(WORD_ID *c, int len)
+{
+  WORD_ID *succ;
+  int i, num;
+
+  if (checked >= maxctx) return;
+  succ = (WORD_ID *)mymalloc(sizeof(WORD_ID) * ngram->max_word_num);
+  num = find_successors(c, len, succ);
+  if (num == 0) {
+    /* back-off weight is the difference from the shorter context */
+    nosucc++;
+    c[len] = 0;
+    if (ngram_prob(ngram, len + 1, c) != ngram_prob(ngram, len, &(c[1]))) nosucc_bo++;
+  }
+  check_context(c, len, succ, num);
+  if (len < ngram->n - 1) {
+    for(i=0;i<num;i++) {
+      c[len] = succ[i];
+      enum_context(c, len + 1);
+    }
+  }
+  free(succ);
+}
+
+static void
+usage(char *s)
+{
+  fprintf(stderr, "%s: compare ngram_prob_batch() with ngram_prob()\n", s);
+  fprintf(stderr, "usage: %s [options] {-d bingram | -nlr arpa | -nrl arpa}\n", s);
+  fprintf(stderr, "options:\n");
+  fprintf(stderr, "   -max N             number of context tuples to check (%d)\n", maxctx);
+  fprintf(stderr, "   -random N          number of random contexts to check (%d)\n", randnum);
+  fprintf(stderr, "   -words N           number of random words per context (%d)\n", wordnum);
+  fprintf(stderr, "   -seed N            random seed (%u)\n", seed);
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  char *binfile = NULL, *lrfile = NULL, *rlfile = NULL;
+  WORD_ID *c;
+  int i, j, len, tuples;
+
+  for(i=1;i<argc;i++) {
+    if (i + 1 >= argc) usage(argv[0]);
+    if (strmatch(argv[i], "-d")) {
+      binfile = argv[++i];
+    } else if (strmatch(argv[i], "-nlr")) {
+      lrfile = argv[++i];
+    } else if (strmatch(argv[i], "-nrl")) {
+      rlfile = argv[++i];
+    } else if (strmatch(argv[i], "-max")) {
+      maxctx = atoi(argv[++i]);
+    } else if (strmatch(argv[i], "-random")) {
+      randnum = atoi(argv[++i]);
+    } else if (strmatch(argv[i], "-words")) {
+      wordnum = atoi(argv[++i]);
+    } else if (strmatch(argv[i], "-seed")) {
+      seed = atoi(argv[++i]);
+    } else {
+      usage(argv[0]);
+    }
+  }
+  if ((binfile != NULL) + (lrfile != NULL) + (rlfile != NULL) != 1) usage(argv[0]);
+  if (maxctx < 0 || randnum < 0 || wordnum < 1) usage(argv[0]);
+
+  jlog_set_output(NULL);
+
+  ngram = ngram_info_new();
+  if (binfile) {
+    if (init_ngram_bin(ngram, binfile) == FALSE) return -1;
+  } else if (lrfile) {
+    if (init_ngram_arpa(ngram, lrfile, DIR_LR) == FALSE) return -1;
+  } else {
+    if (init_ngram_arpa(ngram, rlfile, DIR_RL) == FALSE) return -1;
+  }
+  printf("%d-gram, %d words\n", ngram->n, ngram->max_word_num);
+  if (ngram->n < 2) {
+    fprintf(stderr, "Error: 2-gram or longer is required\n");
+    return -1;
+  }
+
+  srand(seed);
+  ngram_context_init(&ctx, ngram);
+  c = (WORD_ID *)mymalloc(sizeof(WORD_ID) * (ngram->n + 1));
+  wbuf = (WORD_ID *)mymalloc(sizeof(WORD_ID) * ngram->n);
+  wlist = (WORD_ID *)mymalloc(sizeof(WORD_ID) * wordnum * 2);
+  wshuf = (WORD_ID *)mymalloc(sizeof(WORD_ID) * wordnum * 2);
+  pbatch = (LOGPROB *)mymalloc(sizeof(LOGPROB) * wordnum * 2);
+
+  /* context tuples in the N-gram */
+  for(i=0;i<ngram->max_word_num && checked<maxctx;i++) {
+    c[0] = i;
+    enum_context(c, 1);
+  }
+  tuples = checked;
+  /* random word sequences, mostly not in the N-gram */
+  for(i=0;i<randnum;i++) {
+    len = rnd(ngram->n - 1) + 1;
+    for(j=0;j<len;j++) c[j] = rnd(ngram->max_word_num);
+    check_context(c, len, NULL, 0);
+  }
+
+  printf("contexts: %d tuples, %d random\n", tuples, checked - tuples);
+  printf("  %d tuples have no successor, %d of them with back-off weight\n", nosucc, nosucc_bo);
+  printf("lookups: %d, mismatch: %d\n", lookups, mismatch);
+
+  free(pbatch);
+  free(wshuf);
+  free(wlist);
+  free(wbuf);
+  free(c);
+  ngram_context_free(&ctx);
+  ngram_info_free(ngram);
+
+  return(mismatch > 0 ? 1 : 0);
+}
@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 1991-2016 Kawahara Lab., Kyoto University
+ * Copyright (c) 2000-2005 Shikano Lab., Nara Institute of Science and Technology
+ * Copyright (c) 2005-2016 Julius project team, Nagoya Institute of Technology
+ * All rights reserved
+ */
+
+/* zc-check --- compare count_zc_e() with the former per-sample version */
+
+/*
+ * The samples of WAV files, and of synthetic noise when -synth is
+ * given, are passed to count_zc_e() and to the former sample-by-sample
+ * count_zc_e(), which is kept here as a reference.  Each run resets
+ * both work areas with a random cycle buffer length, level threshold
+ * and DC offset, and feeds the input in chunks of random size.  The
+ * whole ZEROCROSS state, including the cycle buffer and the zero-cross
+ * marks, is compared after every call.  The time spent in each
+ * version is also reported.
+ */
+
+#include <julius/juliuslib.h>
+#include <time.h>
+
+static int runnum = 20;
+static int synthlen = 0;
+static unsigned int seed = 1;
+
+/**********************************************************************/
+/* reference: former count_zc_e() that processes sample by sample */
+
+static int
+ref_count_zc_e(ZEROCROSS *zc, SP16 *buf, int step)
+{
+  int i;
+  SP16 tmp, level;
+
+  level = 0;
+  for (i=0; i<step; i++) {
+    if (zc->is_zc[zc->top] == TRUE) {
+      zc->zero_cross--;
+    }
+    zc->is_zc[zc->top] = FALSE;
+    /* exchange old data and buf */
+    tmp = buf[i] + zc->offset;
+    if (zc->is_trig) {
+      if (zc->sign == ZC_POSITIVE && tmp < 0) {
+	zc->zero_cross++;
+	zc->is_zc[zc->top] = TRUE;
+	zc->is_trig = FALSE;
+	zc->sign = ZC_NEGATIVE;
+      } else if (zc->sign == ZC_NEGATIVE && tmp > 0) {
+	zc->zero_cross++;
+	zc->is_zc[zc->top] = TRUE;
+	zc->is_trig = FALSE;
+	zc->sign = ZC_POSITIVE;
+      }
+    }
+    if (abs(tmp) > zc->trigger) {
+      zc->is_trig = TRUE;
+    }
+    if (abs(tmp) > level) level = abs(tmp);
+    zc->data[zc->top] = buf[i];
+    zc->top++;
+    if (zc->valid_len < zc->top) zc->valid_len = zc->top;
+    if (zc->top >= zc->length) {
+      zc->top = 0;
+    }
+  }
+  zc->level = (int)level;
+  return (zc->zero_cross);
+}
+
+/**********************************************************************/
+
+/* random integer in [0..n-1] */
+static int
+rnd(int n)
+{
+  return((int)((double)rand() / ((double)RAND_MAX + 1.0) * n));
+}
+
+static unsigned int
+get_le(unsigned char *p, int n)
+{
+  unsigned int v;
+  int i;
+
+  v = 0;
+  for(i=n-1;i>=0;i--) v = (v << 8) | p[i];
+  return v;
+}
+
+/* read samples of a 16-bit PCM WAV file, the first channel only */
+static SP16 *
+read_wav(char *filename, int *len_ret)
+{
+  FILE *fp;
+  unsigned char h[16];
+  unsigned int size;
+  int ch, i, num;
+  SP16 *s;
+
+  if ((fp = fopen(filename, "rb")) == NULL) {
+    fprintf(stderr, "Error: cannot open %s\n", filename);
+    return NULL;
+  }
+  if (fread(h, 1, 12, fp) != 12 || memcmp(h, "RIFF", 4) != 0 || memcmp(&(h[8]), "WAVE", 4) != 0) {
+    fprintf(stderr, "Error: %s: not a RIFF WAVE file\n", filename);
+    fclose(fp);
+    return NULL;
+  }
+  ch = 0;
+  for(;;) {
+    if (fread(h, 1, 8, fp) != 8) {
+      fprintf(stderr, "Error: %s: no data chunk\n", filename);
+      fclose(fp);
+      return NULL;
+    }
+    size = get_le(&(h[4]), 4);
+    if (memcmp(h, "fmt ", 4) == 0) {
+      if (size < 16 || fread(h, 1, 16, fp) != 16) break;
+      if (get_le(&(h[0]), 2) != 1 || get_le(&(h[14]), 2) != 16) {
+	fprintf(stderr, "Error: %s: not 16-bit PCM\n", filename);
+	fclose(fp);
+	return NULL;
+      }
+      ch = get_le(&(h[2]), 2);
+      if (fseek(fp, (size - 16) + (size & 1), SEEK_CUR) != 0) break;
+    } else if (memcmp(h, "data", 4) == 0) {
+      break;
+    } else {
+      if (fseek(fp, size + (size & 1), SEEK_CUR) != 0) break;
+    }
+  }
+  if (ch < 1) {
+    fprintf(stderr, "Error: %s: no valid format chunk\n", filename);
+    fclose(fp);
+    return NULL;
+  }
+  num = size / (2 * ch);
+  s = (SP16 *)mymalloc(sizeof(SP16) * ch * (num > 0 ? num : 1));
+  num = fread(s, 2 * ch, num, fp);
+  fclose(fp);
+#ifdef WORDS_BIGENDIAN
+  swap_sample_bytes(s, num * ch);
+#endif
+  for(i=0;i<num;i++) s[i] = s[i * ch];
+  *len_ret = num;
+  return s;
+}
+
+/* generate noise with random bursts and full-scale samples */
+static SP16 *
+make_synth(int len)
+{
+  SP16 *s;
+  int i, amp, dc;
+
+  s = (SP16 *)mymalloc(sizeof(SP16) * len);
+  amp = 0;
+  dc = 0;
+  for(i=0;i<len;i++) {
+    if (i % 1600 == 0) {
+      switch(rnd(4)) {
+      case 0: amp = 0; break;
+      case 1: amp = rnd(300); break;
+      case 2: amp = rnd(8000); break;
+      case 3: amp = 32767; break;
+      }
+      dc = rnd(401) - 200;
+    }
+    if (amp == 0) s[i] = 0;
+    else s[i] = dc + rnd(2 * amp + 1) - amp;
+    if (rnd(5000) == 0) s[i] = (rnd(2) == 0) ? -32768 : 32767;
+  }
+  return s;
+}
+
+/* compare the whole ZEROCROSS state */
+static boolean
+zc_same(ZEROCROSS *a, ZEROCROSS *b)
+{
+  int i;
+
+  if (a->trigger != b->trigger || a->length != b->length
+      || a->offset != b->offset || a->zero_cross != b->zero_cross
+      || a->is_trig != b->is_trig || a->sign != b->sign
+      || a->top != b->top || a->valid_len != b->valid_len
+      || a->level != b->level) return FALSE;
+  for(i=0;i<a->length;i++) {
+    if (a->is_zc[i] != b->is_zc[i]) return FALSE;
+  }
+  /* samples beyond valid_len are not written yet */
+  for(i=0;i<a->valid_len;i++) {
+    if (a->data[i] != b->data[i]) return FALSE;
+  }
+  return TRUE;
+}
+
+static void
+usage(char *s)
+{
+  fprintf(stderr, "%s: compare count_zc_e() with the former per-sample version\n", s);
+  fprintf(stderr, "usage: %s [-run N] [-synth N] [-seed N] [wavfile...]\n", s);
+  fprintf(stderr, "   -run N             random runs per input (%d)\n", runnum);
+  fprintf(stderr, "   -synth N           also test N samples of synthetic noise (%d)\n", synthlen);
+  fprintf(stderr, "   -seed N            random seed (%u)\n", seed);
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  char **files;
+  int filenum;
+  SP16 *speech, *bufa, *bufb;
+  int len, maxchunk;
+  int f, r, i, step;
+  int cycle, trigger, offset;
+  int ra, rb;
+  ZEROCROSS za, zb;
+  long calls, mismatch, samples;
+  clock_t start;
+  double ta, tb;
+
+  files = (char **)mymalloc(sizeof(char *) * argc);
+  filenum = 0;
+  for(i=1;i<argc;i++) {
+    if (argv[i][0] == '-') {
+      if (i + 1 >= argc) usage(argv[0]);
+      if (strmatch(argv[i], "-run")) {
+	runnum = atoi(argv[++i]);
+      } else if (strmatch(argv[i], "-synth")) {
+	synthlen = atoi(argv[++i]);
+      } else if (strmatch(argv[i], "-seed")) {
+	seed = atoi(argv[++i]);
+      } else {
+	usage(argv[0]);
+      }
+    } else {
+      files[filenum++] = argv[i];
+    }
+  }
+  if (filenum == 0 && synthlen <= 0) usage(argv[0]);
+
+  jlog_set_output(NULL);
+  srand(seed);
+
+  calls = mismatch = samples = 0;
+  ta = tb = 0.0;
+  for(f=0;f<=filenum;f++) {
+    if (f < filenum) {
+      if ((speech = read_wav(files[f], &len)) == NULL) return -1;
+    } else {
+      if (synthlen <= 0) break;
+      len = synthlen;
+      speech = make_synth(len);
+    }
+    for(r=0;r<runnum;r++) {
+      /* typical settings of adin_cut() mostly, and extreme ones */
+      cycle = (rnd(4) == 0) ? rnd(64) + 1 : rnd(8000) + 1;
+      switch(rnd(6)) {
+      case 0: trigger = rnd(3) - 1; break;
+      case 1: trigger = 32767 - rnd(3); break;
+      case 2: trigger = 32768 + rnd(100); break;
+      default: trigger = rnd(4000); break;
+      }
+      offset = (rnd(2) == 0) ? 0 : rnd(2001) - 1000;
+      maxchunk = (rnd(3) == 0) ? cycle * 2 : cycle;
+      init_count_zc_e(&za, cycle);
+      init_count_zc_e(&zb, cycle);
+      reset_count_zc_e(&za, trigger, cycle, offset);
+      reset_count_zc_e(&zb, trigger, cycle, offset);
+      bufa = (SP16 *)mymalloc(sizeof(SP16) * maxchunk);
+      bufb = (SP16 *)mymalloc(sizeof(SP16) * maxchunk);
+      for(i=0;i<len;i+=step) {
+	step = rnd(maxchunk) + 1;
+	if (step > len - i) step = len - i;
+	memcpy(bufa, &(speech[i]), sizeof(SP16) * step);
+	memcpy(bufb, &(speech[i]), sizeof(SP16) * step);
+	start = clock();
+	ra = count_zc_e(&za, bufa, step);
+	ta += (double)(clock() - start);
+	start = clock();
+	rb = ref_count_zc_e(&zb, bufb, step);
+	tb += (double)(clock() - start);
+	calls++;
+	samples += step;
+	if (ra != rb || !zc_same(&za, &zb)) {
+	  if (mismatch < 10) {
+	    printf("mismatch: %s, cycle=%d trigger=%d offset=%d, at sample %d (+%d): zc %d / %d, level %d / %d\n", (f < filenum) ? files[f] : "synth", cycle, trigger, offset, i, step, ra, rb, za.level, zb.level);
+	  }
+	  mismatch++;
+	  /* continue from the same state */
+	  free_count_zc_e(&za);
+	  za = zb;
+	  za.data = (SP16 *)mymalloc(sizeof(SP16) * cycle);
+	  za.is_zc = (int *)mymalloc(sizeof(int) * cycle);
+	  memcpy(za.data, zb.data, sizeof(SP16) * cycle);
+	  memcpy(za.is_zc, zb.is_zc, sizeof(int) * cycle);
+	}
+      }
+      free(bufb);
+      free(bufa);
+      free_count_zc_e(&zb);
+      free_count_zc_e(&za);
+    }
+    free(speech);
+  }
+
+  printf("%ld calls, %ld samples, mismatch: %ld\n", calls, samples, mismatch);
+  printf("count_zc_e:     %.1f ms\n", ta * 1000.0 / CLOCKS_PER_SEC);
+  printf("reference:      %.1f ms\n", tb * 1000.0 / CLOCKS_PER_SEC);
+
+  free(files);
+
+  return(mismatch > 0 ? 1 : 0);
+}
@@ -81,6 +81,14 @@ void do_disconnect(int sd);
 void do_sendf(int sd, char *fmt, ...);
 void do_send(int sd, char *buf);
 char *do_receive(int sd, char *buf, int maxlen);
+char *do_receive_data(int sd, char *buf, int len);
+
+/* jcontrol.c */
+extern int binary_mode;
+
+/* japi_binary.c */
+void japi_set_output_format(int sd, char *format);
+void japi_binary_output(int sd);
 
 /* japi_misc.c */
 void japi_die(int);
@@ -0,0 +1,368 @@
+/**
+ * @file   japi_binary.c
+ *
+ * <JA>
+ * @brief  バイナリ形式の認識結果の受信と表示
+ * </JA>
+ *
+ * <EN>
+ * @brief  Receive and print recognition results in binary format
+ * </EN>
+ *
+ * A reference decoder of the binary result output of Julius module
+ * mode.  See README.md for the frame format.
+ *
+ */
+/*
+ * Copyright (c) 2002-2013 Kawahara Lab., Kyoto University
+ * Copyright (c) 2002-2005 Shikano Lab., Nara Institute of Science and Technology
+ * Copyright (c) 2005-2013 Julius project team, Nagoya Institute of Technology
+ * All rights reserved
+ */
+
+#include "japi.h"
+
+/* frame types, should be the same as MODULE_BIN_* in julius/app.h */
+#define BIN_HEADLEN 8
+#define BIN_TEXT 1
+#define BIN_PASS1_INTERIM 2
+#define BIN_PASS1 3
+#define BIN_RESULT 4
+#define BIN_GRAPH 5
+#define BIN_GMM 6
+#define BIN_VOCA 7
+#define BIN_PASS1_DETERMINED 8
+
+#define MAXSRNUM 100		///< Maximum ID of recognition process
+
+/// Word output strings of each recognition process, set by BIN_VOCA
+static struct {
+  int num;
+  char **word;
+} voca[MAXSRNUM];
+
+static unsigned char *buf = NULL; ///< Payload of the current frame
+static int bufsize = 0;		  ///< Allocated size of @a buf
+static unsigned char *p;	  ///< Read pointer in @a buf
+static unsigned char *end;	  ///< End of payload in @a buf
+
+/* read integer and float in little endian from payload */
+static int
+get_int()
+{
+  int v;
+  if (p + 4 > end) {
+    fprintf(stderr, "Error: japi_binary: frame too short\n");
+    exit(1);
+  }
+  v = (int)((unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24));
+  p += 4;
+  return v;
+}
+
+static float
+get_float()
+{
+  int v;
+  float f;
+  v = get_int();
+  memcpy(&f, &v, 4);
+  return f;
+}
+
+/* read number of items of at least the given size that follow */
+static int
+get_count(int unitsize)
+{
+  int v;
+  v = get_int();
+  if (v < 0 || v > (end - p) / unitsize) {
+    fprintf(stderr, "Error: japi_binary: invalid count %d in frame\n", v);
+    exit(1);
+  }
+  return v;
+}
+
+/**
+ * <JA>
+ * 単語IDを単語出力文字列に変換する．
+ *
+ * @param id [in] 認識処理インスタンスのID
+ * @param wid [in] 単語ID
+ *
+ * @return 単語出力文字列
+ * </JA>
+ * <EN>
+ * Convert word ID to word output string.
+ *
+ * @param id [in] ID of recognition process
+ * @param wid [in] word ID
+ *
+ * @return the word output string.
+ * </EN>
+ */
+static char *
+word_str(int id, int wid)
+{
+  static char str[32];
+  if (id >= 0 && id < MAXSRNUM && wid >= 0 && wid < voca[id].num) {
+    return voca[id].word[wid];
+  }
+  sprintf(str, "#%d", wid);
+  return str;
+}
+
+/**
+ * <JA>
+ * 単語出力文字列のリストを格納する．
+ *
+ * </JA>
+ * <EN>
+ * Store the list of word output strings.
+ *
+ * </EN>
+ */
+static void
+read_voca()
+{
+  int id, num, i, len;
+
+  id = get_int();
+  num = get_count(4);
+  if (id < 0 || id >= MAXSRNUM) return;
+  for(i=0;i<voca[id].num;i++) free(voca[id].word[i]);
+  if (voca[id].word) free(voca[id].word);
+  voca[id].word = (char **)malloc(sizeof(char *) * (num > 0 ? num : 1));
+  for(i=0;i<num;i++) {
+    len = get_count(1);
+    voca[id].word[i] = (char *)malloc(len + 1);
+    memcpy(voca[id].word[i], p, len);
+    voca[id].word[i][len] = '\0';
+    p += len;
+  }
+  voca[id].num = num;
+  printf("> VOCA SR%02d: %d words\n", id, num);
+}
+
+/**
+ * <JA>
+ * 単語ID列を表示する．
+ *
+ * @param id [in] 認識処理インスタンスのID
+ * </JA>
+ * <EN>
+ * Print a word ID sequence.
+ *
+ * @param id [in] ID of recognition process
+ * </EN>
+ */
+static void
+print_words(int id)
+{
+  int i, num;
+
+  num = get_count(4);
+  for(i=0;i<num;i++) printf(" %s", word_str(id, get_int()));
+  printf("\n");
+}
+
+/**
+ * <JA>
+ * 最終結果を表示する．
+ *
+ * </JA>
+ * <EN>
+ * Print a final result.
+ *
+ * </EN>
+ */
+static void
+print_result()
+{
+  int id, status, frames, num, n, i, wnum, wid, b, e;
+  float score, am, lm, cm;
+  int gram;
+
+  id = get_int();
+  status = get_int();
+  frames = get_int();
+  num = get_count(20);
+  if (status < 0) {
+    printf("> RESULT SR%02d: status=%d (rejected or failed), %d frames\n", id, status, frames);
+    return;
+  }
+  for(n=0;n<num;n++) {
+    score = get_float();
+    am = get_float();
+    lm = get_float();
+    gram = get_int();
+    printf("> RESULT SR%02d #%d: score=%f am=%f lm=%f", id, n+1, score, am, lm);
+    if (gram >= 0) printf(" gram=%d", gram);
+    printf("\n>  ");
+    wnum = get_count(16);
+    for(i=0;i<wnum;i++) {
+      wid = get_int();
+      cm = get_float();
+      b = get_int();
+      e = get_int();
+      printf(" %s", word_str(id, wid));
+      if (b >= 0) printf("[%d-%d]", b, e);
+      printf("(%.3f)", cm);
+    }
+    printf("\n");
+  }
+}
+
+/**
+ * <JA>
+ * 単語グラフを表示する．
+ *
+ * </JA>
+ * <EN>
+ * Print a word graph.
+ *
+ * </EN>
+ */
+static void
+print_graph()
+{
+  int id, nodenum, arcnum, i, gid, wid, b, e, from, to;
+  float cm, amavg;
+
+  id = get_int();
+  nodenum = get_count(24);
+  arcnum = get_count(8);
+  if (arcnum > (end - p - nodenum * 24) / 8) {
+    fprintf(stderr, "Error: japi_binary: invalid count %d in frame\n", arcnum);
+    exit(1);
+  }
+  printf("> GRAPH SR%02d: %d nodes, %d arcs\n", id, nodenum, arcnum);
+  for(i=0;i<nodenum;i++) {
+    gid = get_int();
+    wid = get_int();
+    b = get_int();
+    e = get_int();
+    cm = get_float();
+    amavg = get_float();
+    printf(">   node %d: %s [%d-%d] cm=%.3f amavg=%f\n", gid, word_str(id, wid), b, e, cm, amavg);
+  }
+  for(i=0;i<arcnum;i++) {
+    from = get_int();
+    to = get_int();
+    printf(">   arc %d -> %d\n", from, to);
+  }
+}
+
+/**
+ * <JA>
+ * コマンド OUTPUTFORMAT: 認識結果の出力形式を変更する．
+ *
+ * @param sd [in] 送信ソケット
+ * @param format [in] "BINARY" または "XML"
+ * </JA>
+ * <EN>
+ * Command "OUTPUTFORMAT": change output format of recognition results.
+ *
+ * @param sd [in] socket to send data
+ * @param format [in] "BINARY" or "XML"
+ * </EN>
+ */
+void
+japi_set_output_format(int sd, char *format)
+{
+  do_sendf(sd, "OUTPUTFORMAT\n%s\n", format);
+}
+
+/**
+ * <JA>
+ * サーバからバイナリフレームを1つ受信して表示する．
+ * XML形式への切り替え応答を受け取ったら binary_mode を 0 にする．
+ *
+ * @param sd [in] 受信ソケット
+ * </JA>
+ * <EN>
+ * Receive a binary frame from server and print it.  When the response
+ * of switching to XML format is received, @a binary_mode is set to 0.
+ *
+ * @param sd [in] socket to receive data
+ * </EN>
+ */
+void
+japi_binary_output(int sd)
+{
+  unsigned char head[BIN_HEADLEN];
+  int type, len, id;
+  char *l, *q;
+
+  if (do_receive_data(sd, (char *)head, BIN_HEADLEN) == NULL) {
+    fprintf(stderr, "Error: connection closed\n");
+    exit(1);
+  }
+  p = head;
+  end = head + BIN_HEADLEN;
+  type = get_int();
+  len = get_int();
+  if (len < 0 || len >= 0x7fffffff) {
+    fprintf(stderr, "Error: japi_binary: invalid frame length %d\n", len);
+    exit(1);
+  }
+  if (len + 1 > bufsize) {
+    bufsize = len + 1;
+    if ((buf = (unsigned char *)realloc(buf, bufsize)) == NULL) {
+      fprintf(stderr, "Error: japi_binary: failed to allocate %d bytes\n", bufsize);
+      exit(1);
+    }
+  }
+  if (len > 0 && do_receive_data(sd, (char *)buf, len) == NULL) {
+    fprintf(stderr, "Error: connection closed\n");
+    exit(1);
+  }
+  p = buf;
+  end = buf + len;
+
+  switch(type) {
+  case BIN_TEXT:
+    buf[len] = '\0';
+    for(l = (char *)buf; *l != '\0'; l = q + 1) {
+      if ((q = strchr(l, '\n')) == NULL) q = l + strlen(l) - 1;
+      else *q = '\0';
+      printf("> %s\n", l);
+      if (strcmp(l, "<OUTPUTFORMAT TYPE=\"XML\"/>") == 0) binary_mode = 0;
+    }
+    break;
+  case BIN_PASS1_INTERIM:
+    id = get_int();
+    printf("> PASS1_INTERIM SR%02d: frame=%d", id, get_int());
+    printf(" score=%f\n>  ", get_float());
+    print_words(id);
+    break;
+  case BIN_PASS1_DETERMINED:
+    id = get_int();
+    printf("> PASS1_DETERMINED SR%02d: frame=%d\n>  ", id, get_int());
+    print_words(id);
+    break;
+  case BIN_PASS1:
+    id = get_int();
+    printf("> PASS1 SR%02d: score=%f\n>  ", id, get_float());
+    print_words(id);
+    break;
+  case BIN_RESULT:
+    print_result();
+    break;
+  case BIN_GRAPH:
+    print_graph();
+    break;
+  case BIN_GMM:
+    printf("> GMM: cm=%f", get_float());
+    len = get_count(1);
+    printf(" %.*s\n", len, (char *)p);
+    break;
+  case BIN_VOCA:
+    read_voca();
+    break;
+  default:
+    printf("> unknown frame type %d, %d bytes\n", type, len);
+    break;
+  }
+  fflush(stdout);
+}
@@ -27,6 +27,7 @@
 
 static char sbuf[MAXLINELEN]; ///< Local workarea for message string handling
 static char rbuf[MAXLINELEN]; ///< Local workarea for message string handling
+int binary_mode = 0;	      ///< 1 if receiving results in binary format
 
 /** 
  * <JA>
@@ -98,6 +99,10 @@ do_command(int sd)
       japi_deactivate_process(sd, arg1);
     } else if (strmatch(com, "addword")) {
       japi_add_words(sd, arg1, arg2);
+    } else if (strmatch(com, "binary")) {
+      japi_set_output_format(sd, "BINARY");
+    } else if (strmatch(com, "xml")) {
+      japi_set_output_format(sd, "XML");
     } else {
       fprintf(stderr,"No such command: [%s]\n", com);
     }
@@ -118,10 +123,19 @@ do_command(int sd)
 void
 do_output(int sd)
 {
+  int switch_binary = 0;
+
+  if (binary_mode) {
+    japi_binary_output(sd);
+    return;
+  }
   while(do_receive(sd, rbuf, MAXLINELEN) != NULL) {
     if (rbuf[0] == '.' && rbuf[1] == '\0') break;
     printf("> %s\n", rbuf);
+    /* messages after this will be sent in binary frames */
+    if (strmatch(rbuf, "<OUTPUTFORMAT TYPE=\"BINARY\"/>")) switch_binary = 1;
   }
+  if (switch_binary) binary_mode = 1;
   fflush(stdout);
 }
 
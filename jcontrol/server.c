@@ -244,3 +244,42 @@ do_receive(int sd, char *buf, int maxlen)
   }
   return buf;
 }
+
+/** 
+ * <JA>
+ * サーバーから指定バイト数のデータを受信する．
+ * 
+ * @param sd [in] 受信ソケット
+ * @param buf [out] 受信したデータを格納するバッファ
+ * @param len [in] 受信するバイト数
+ * 
+ * @return @a buf へのポインタ, あるいはエラー時はNULLを返す．
+ * </JA>
+ * <EN>
+ * Receive the specified length of data from server.
+ * 
+ * @param sd [in] socket descriptor to receive data
+ * @param buf [out] buffer to store the received data
+ * @param len [in] length of data to receive in bytes
+ * 
+ * @return pointer equal to @a buf, or NULL if error.
+ * </EN>
+ */
+char *
+do_receive_data(int sd, char *buf, int len)
+{
+  int cnt;
+  int n;
+  
+  n = 0;
+  while(n < len) {
+#ifdef WINSOCK
+    cnt = recv(sd, buf + n, len - n, 0);
+#else
+    cnt = read(sd, buf + n, len - n);
+#endif
+    if (cnt <= 0) return NULL;		/* eof or error */
+    n += cnt;
+  }
+  return buf;
+}
@@ -24,9 +24,39 @@
 
 /* recogloop.c */
 void main_recognition_stream_loop(Recog *recog);
+#ifdef HAVE_PTHREAD
+void main_recognition_batch_loop(Recog *recog, int num);
+#endif
+
+/**
+ * Output format of module clients
+ * 
+ */
+#define MODULE_FORMAT_ALL -1	///< All clients
+#define MODULE_FORMAT_XML 0	///< XML text messages (default)
+#define MODULE_FORMAT_BINARY 1	///< Length-prefixed binary frames
+
+/**
+ * Frame types of binary module output.  A frame consists of 32-bit
+ * type, 32-bit payload length and the payload, all integers and floats
+ * in little endian.  See jcontrol/README.md for the payload layouts.
+ * 
+ */
+#define MODULE_BIN_HEADLEN 8	///< Length of frame header
+#define MODULE_BIN_TEXT 1	///< XML text message other than results
+#define MODULE_BIN_PASS1_INTERIM 2 ///< 1st pass progressive output
+#define MODULE_BIN_PASS1 3	///< 1st pass result
+#define MODULE_BIN_RESULT 4	///< Final result
+#define MODULE_BIN_GRAPH 5	///< Word graph
+#define MODULE_BIN_GMM 6	///< GMM result
+#define MODULE_BIN_VOCA 7	///< Word output strings to decode word IDs
+#define MODULE_BIN_PASS1_DETERMINED 8 ///< Words committed on streaming input
 
 /* module.c */
 int module_send(char *fmt, ...);
+int module_send_frame(int type, char *data, int len);
+void module_send_format(int format);
+int module_client_num(int format);
 void module_add_option();
 boolean is_module_mode();
 void module_setup(Recog *recog, void *data);
@@ -36,6 +66,7 @@ void module_disconnect();
 /* output_module.c */
 void decode_output_selection(char *str);
 void send_gram_info(RecogProcess *r);
+void send_binary_voca(Recog *recog);
 void setup_output_msock(Recog *recog, void *data);
 void escape_xml(char *originstr, char *outbuf);
 
@@ -50,6 +81,7 @@ void outfile_set_fname(char *input_filename);
 /* record.c */
 void record_add_option();
 void record_setup(Recog *recog, void *data);
+boolean is_record_enabled();
 
 
 
@@ -28,6 +28,7 @@
 boolean separate_score_flag = FALSE;
 boolean outfile_enabled = FALSE;
 boolean noxmlescape_enabled = FALSE;
+int parallel_num = 1;
 
 static char *logfile = NULL;
 static boolean nolog = FALSE;
@@ -76,6 +77,71 @@ opt_noxmlescape(Jconf *jconf, char *arg[], int argnum)
   noxmlescape_enabled = TRUE;
   return TRUE;
 }
+static boolean
+opt_parallel(Jconf *jconf, char *arg[], int argnum)
+{
+  parallel_num = atoi(arg[0]);
+  if (parallel_num < 1) {
+    fprintf(stderr, "Error: -parallel: number of threads should be > 0\n");
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* check if parallel batch decoding is available for the configuration */
+static void
+check_parallel(Jconf *jconf)
+{
+  JCONF_SEARCH *s;
+
+  if (parallel_num <= 1) return;
+#ifndef HAVE_PTHREAD
+  fprintf(stderr, "Warning: -parallel needs pthread support, disabled now\n");
+  parallel_num = 1;
+  return;
+#endif
+  if (is_module_mode()) {
+    fprintf(stderr, "Warning: -parallel does not work in module mode, disabled now\n");
+    parallel_num = 1;
+    return;
+  }
+  if (jconf->input.speech_input != SP_RAWFILE && jconf->input.speech_input != SP_MFCFILE && jconf->input.speech_input != SP_OUTPROBFILE) {
+    fprintf(stderr, "Warning: -parallel works only for file input, disabled now\n");
+    parallel_num = 1;
+    return;
+  }
+  if (jconf->input.inputlist_filename == NULL) {
+    fprintf(stderr, "Warning: -parallel needs -filelist, disabled now\n");
+    parallel_num = 1;
+    return;
+  }
+#ifdef ENABLE_PLUGIN
+  if (jconf->input.plugin_source >= 0) {
+    fprintf(stderr, "Warning: -parallel does not work with input plugin, disabled now\n");
+    parallel_num = 1;
+    return;
+  }
+#endif
+  if (jconf->preprocess.use_zmean) {
+    fprintf(stderr, "Warning: -parallel does not work with -zmean, disabled now\n");
+    parallel_num = 1;
+    return;
+  }
+  /* per-input outputs that can not be shared among threads */
+  if (outfile_enabled) {
+    fprintf(stderr, "Warning: -outfile does not work with -parallel, disabled now\n");
+    outfile_enabled = FALSE;
+  }
+  for(s=jconf->search_root;s;s=s->next) {
+    if (s->output.progout_flag) {
+      fprintf(stderr, "Warning: -progout does not work with -parallel, disabled now\n");
+      break;
+    }
+  }
+  for(s=jconf->search_root;s;s=s->next) {
+    s->output.progout_flag = FALSE;
+  }
+}
    
 /**********************************************************************/
 int
@@ -108,6 +174,7 @@ main(int argc, char *argv[])
   j_add_option("-logfile", 1, 1, "output log to file", opt_logfile);
   j_add_option("-nolog", 0, 0, "not output any log", opt_nolog);
   j_add_option("-outfile", 0, 0, "save result in separate .out file", opt_outfile);
+  j_add_option("-parallel", 1, 1, "decode -filelist inputs by N threads in parallel", opt_parallel);
   j_add_option("-help", 0, 0, "display this help", opt_help);
   j_add_option("--help", 0, 0, "display this help", opt_help);
 
@@ -119,12 +186,18 @@ main(int argc, char *argv[])
     return -1;
   }
 
+  /* check if batch decoding is possible */
+  check_parallel(jconf);
+
   /* output system log to a file */
   if (nolog) {
     jlog_set_output(NULL);
   } else if (logfile) {
     fp = fopen(logfile, "w");
     jlog_set_output(fp);
+  } else if (parallel_num > 1) {
+    /* keep stdout for the results */
+    jlog_set_output(stderr);
   }
 
   /* here you can set/modify any parameter in the jconf before setup */
@@ -179,8 +252,9 @@ main(int argc, char *argv[])
     /* set up for module mode */
     /* register result output callback functions to network module */
     module_setup(recog, NULL);
-  } else {
+  } else if (parallel_num <= 1) {
     /* register result output callback functions to stdout */
+    /* (in batch mode, they are registered for each thread later) */
     setup_output_tty(recog, NULL);
   }
   /* if -outfile option specified, callbacks for file output will be
@@ -195,7 +269,11 @@ main(int argc, char *argv[])
   }
 
   /* setup recording if option was specified */
-  record_setup(recog, NULL);
+  if (parallel_num > 1 && is_record_enabled()) {
+    fprintf(stderr, "Warning: -record does not work with -parallel, disabled now\n");
+  } else {
+    record_setup(recog, NULL);
+  }
 
   /* on module connect with client */
   if (is_module_mode()) module_server();
@@ -234,7 +312,15 @@ main(int argc, char *argv[])
   }
 
   /* enter recongnition loop */
+#ifdef HAVE_PTHREAD
+  if (parallel_num > 1) {
+    main_recognition_batch_loop(recog, parallel_num);
+  } else {
+    main_recognition_stream_loop(recog);
+  }
+#else
   main_recognition_stream_loop(recog);
+#endif
 
   /* end proc */
   if (is_module_mode()) module_disconnect();
@@ -9,16 +9,98 @@
 
 #include <stdarg.h>
 
+/*
+ * Module server accepts multiple clients.  Result messages are sent
+ * to all connected clients, and replies to a command are sent only to
+ * the client that issued it.  Messages are put into per-client output
+ * queues by module_send() and written to non-blocking sockets by an
+ * event loop (msock_io()), so a slow client never blocks recognition.
+ * A client whose queue exceeds the limit is dropped.
+ *
+ * A client can switch its output to binary frames by the OUTPUTFORMAT
+ * command.  Then the results are sent in binary records by
+ * module_send_frame(), and other messages are sent as text frames.
+ *
+ * With pthread, the event loop runs in a dedicated thread and the
+ * recognition thread only appends to the queues.  Otherwise it is
+ * called from the poll callback and at the end of each message.
+ * Commands are always executed in the recognition thread.
+ */
+#if defined(HAVE_PTHREAD) && !defined(WINSOCK)
+#define MODULE_IO_THREAD	///< Run module socket I/O in a separate thread
+#include <pthread.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
 #define DEFAULT_MODULEPORT 10500
+#define DEFAULT_MODULE_MAXCLIENT 8 ///< Default maximum number of clients
+#define DEFAULT_MODULE_QUEUEKB 1024 ///< Default output queue limit per client in KBytes
+
+/// Status of a client slot
+enum {
+  MC_FREE,			///< Not used yet
+  MC_OPEN,			///< Connected
+  MC_CLOSED			///< Disconnected, can be reused
+};
+
+/// Connected client
+typedef struct {
+  int state;			///< Slot status, one of MC_*
+  int sd;			///< Socket descriptor
+  int id;			///< Serial number of the connection
+  boolean closing;		///< TRUE if requested to close
+  boolean finishing;		///< TRUE if to be closed after sending queued data
+  int format;			///< Output format, MODULE_FORMAT_XML or MODULE_FORMAT_BINARY
+  char *qbuf;			///< Output queue to be filled by module_send()
+  int qlen;			///< Length of data in @a qbuf
+  int qsize;			///< Allocated size of @a qbuf
+  char *sbuf;			///< Output data now being written to socket
+  int slen;			///< Length of data in @a sbuf
+  int spos;			///< Bytes already written in @a sbuf
+  int ssize;			///< Allocated size of @a sbuf
+  char *ibuf;			///< Received data not processed yet
+  int ilen;			///< Length of data in @a ibuf
+  int isize;			///< Allocated size of @a ibuf
+  char *tbuf;			///< Text message being built for binary output
+  int tlen;			///< Length of data in @a tbuf
+  int tsize;			///< Allocated size of @a tbuf
+  unsigned long cmd_num;	///< Number of received commands
+  unsigned long msg_num;	///< Number of queued messages
+  unsigned long byte_queued;	///< Number of queued bytes
+  unsigned long byte_sent;	///< Number of bytes written to socket
+} MODULE_CLIENT;
 
 static int module_mode = FALSE;
 static int module_port = DEFAULT_MODULEPORT;
+static int module_maxclient = DEFAULT_MODULE_MAXCLIENT;
+static int module_queuelimit = DEFAULT_MODULE_QUEUEKB * 1024;
 static int listen_sd = -1;
-static int module_sd = -1;
-static FILE *module_fp = NULL;
+static MODULE_CLIENT *client = NULL; ///< Client slots
+static int client_serial = 0;	///< Serial number of the last connection
+static int open_num = 0;	///< Number of connected clients
+static boolean client_lost = FALSE; ///< TRUE when the last client has gone
+static int reply_to = -1;	///< Client to reply to the command, or -1 to send all
+static int send_format = MODULE_FORMAT_ALL; ///< Format of clients to which module_send() sends
 static RecogProcess *cur = NULL;
 static Recog *local_recog = NULL;
 
+#ifdef MODULE_IO_THREAD
+static pthread_t io_thread;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER; ///< Signaled on connection and arrival of data
+static int wake_fd[2] = {-1, -1}; ///< Pipe to wake up I/O thread
+static boolean wake_pending = FALSE;
+static boolean io_quit = FALSE;
+#define MLOCK() pthread_mutex_lock(&mutex)
+#define MUNLOCK() pthread_mutex_unlock(&mutex)
+#else
+#define MLOCK()
+#define MUNLOCK()
+#endif
+
 #define MAXBUFLEN 4096 ///< Maximum line length of a message sent from a client
 static char mbuf[MAXBUFLEN];	///< Work buffer for message output
 static char buf[MAXBUFLEN];	///< Work buffer for exec
@@ -27,16 +109,437 @@ static char inbuf[MAXBUFLEN];
 static char outbuf[MAXBUFLEN];
 #endif
 
-static void module_connect();
+static void msock_io(struct timeval *tv);
 
+/**
+ * Append data to a growing buffer.
+ *
+ * @param b [i/o] buffer
+ * @param len [i/o] length of data in the buffer
+ * @param size [i/o] allocated size of the buffer
+ * @param data [in] data to append
+ * @param n [in] length of @a data
+ */
+static void
+buf_append(char **b, int *len, int *size, char *data, int n)
+{
+  if (*len + n > *size) {
+    if (*size == 0) *size = MAXBUFLEN;
+    while (*len + n > *size) *size *= 2;
+    *b = (char *)myrealloc(*b, *size);
+  }
+  memcpy(*b + *len, data, n);
+  *len += n;
+}
 
-/** 
- * Generic function to send a formatted message to client module.
+/**
+ * Set socket to non-blocking mode.
  *
  * @param sd [in] socket descriptor
+ */
+static void
+set_nonblock(int sd)
+{
+#ifdef WINSOCK
+  u_long mode = 1;
+  ioctlsocket(sd, FIONBIO, &mode);
+#else
+  fcntl(sd, F_SETFL, fcntl(sd, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+/**
+ * Check if the last socket error was caused by non-blocking operation.
+ *
+ * @return TRUE if the operation should be retried later.
+ */
+static boolean
+sock_wouldblock()
+{
+#ifdef WINSOCK
+  return(WSAGetLastError() == WSAEWOULDBLOCK);
+#else
+  return(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+#endif
+}
+
+/**
+ * Wake up the I/O loop to write the queued data.  Should be called
+ * with lock.
+ *
+ */
+static void
+msock_wakeup()
+{
+#ifdef MODULE_IO_THREAD
+  if (!wake_pending) {
+    wake_pending = TRUE;
+    if (write(wake_fd[1], "w", 1) < 0) {
+      /* pipe full: already waked up */
+    }
+  }
+#endif
+}
+
+/**
+ * Wait until something happens on the clients: connection,
+ * disconnection or arrival of data.  Should be called with lock.
+ *
+ */
+static void
+msock_wait()
+{
+#ifdef MODULE_IO_THREAD
+  pthread_cond_wait(&cond, &mutex);
+#else
+  msock_io(NULL);
+#endif
+}
+
+/**
+ * Assign a slot for a newly connected client.  Should be called with lock.
+ *
+ * @param sd [in] socket descriptor of the connection
+ */
+static void
+client_open(int sd)
+{
+  MODULE_CLIENT *c;
+  int i;
+
+  for(i=0;i<module_maxclient;i++) {
+    c = &(client[i]);
+    if (c->state == MC_FREE) break;
+    /* a closed slot whose command is still in progress is not reused */
+    if (c->state == MC_CLOSED && i != reply_to) break;
+  }
+  if (i >= module_maxclient) {
+    jlog("Warning: module: too many clients (max=%d), connection refused\n", module_maxclient);
+    close_socket(sd);
+    return;
+  }
+  set_nonblock(sd);
+  c->state = MC_OPEN;
+  c->sd = sd;
+  c->id = ++client_serial;
+  c->closing = FALSE;
+  c->finishing = FALSE;
+  c->format = MODULE_FORMAT_XML;
+  c->tlen = 0;
+  c->qlen = c->slen = c->spos = c->ilen = 0;
+  c->cmd_num = c->msg_num = c->byte_queued = c->byte_sent = 0;
+  open_num++;
+  jlog("Stat: module: client #%d connected (%d/%d)\n", c->id, open_num, module_maxclient);
+#ifdef MODULE_IO_THREAD
+  pthread_cond_broadcast(&cond);
+#endif
+}
+
+/**
+ * Close connection to a client and output its statistics.  Should be
+ * called with lock.
+ *
+ * @param c [i/o] client
+ */
+static void
+client_shutdown(MODULE_CLIENT *c)
+{
+  close_socket(c->sd);
+  c->sd = -1;
+  c->state = MC_CLOSED;
+  jlog("Stat: module: client #%d disconnected: %lu commands, %lu messages, %lu of %lu bytes sent\n", c->id, c->cmd_num, c->msg_num, c->byte_sent, c->byte_queued);
+  c->qlen = c->slen = c->spos = c->ilen = c->tlen = 0;
+  open_num--;
+  if (open_num == 0) client_lost = TRUE;
+#ifdef MODULE_IO_THREAD
+  pthread_cond_broadcast(&cond);
+#endif
+}
+
+/**
+ * Request to close a client.  The connection will be closed in the
+ * I/O loop after all the queued data has been sent.
+ *
+ * @param i [in] client slot index
+ */
+static void
+client_request_close(int i)
+{
+  if (i < 0) return;
+  MLOCK();
+  if (client[i].state == MC_OPEN) {
+    client[i].finishing = TRUE;
+    msock_wakeup();
+  }
+  MUNLOCK();
+}
+
+/**
+ * Pop a line from the received data of a client.  Should be called
+ * with lock.
+ *
+ * @param c [i/o] client
+ * @param buf [out] buffer to store the line, without newline
+ * @param maxlen [in] size of @a buf
+ *
+ * @return TRUE if a line was read, or FALSE if no complete line exists.
+ */
+static boolean
+client_getline(MODULE_CLIENT *c, char *buf, int maxlen)
+{
+  char *p;
+  int len, n;
+
+  if (c->ilen == 0) return FALSE;
+  if ((p = memchr(c->ibuf, '\n', c->ilen)) == NULL) return FALSE;
+  len = p - c->ibuf;
+  n = (len < maxlen) ? len : maxlen - 1;
+  memcpy(buf, c->ibuf, n);
+  buf[n] = '\0';
+  if (n > 0 && buf[n-1] == '\r') buf[n-1] = '\0';
+  len++;
+  c->ilen -= len;
+  if (c->ilen > 0) memmove(c->ibuf, c->ibuf + len, c->ilen);
+  return TRUE;
+}
+
+/**
+ * Read a line from the client which issued the current command.
+ * Blocks until a whole line arrives.
+ *
+ * @param buf [out] buffer to store the line, without newline
+ * @param maxlen [in] size of @a buf
+ *
+ * @return @a buf, or NULL when the client has been disconnected.
+ */
+static char *
+client_gets(char *buf, int maxlen)
+{
+  MODULE_CLIENT *c;
+  char *ret = NULL;
+
+  if (reply_to < 0) return NULL;
+  c = &(client[reply_to]);
+  MLOCK();
+  while(1) {
+    if (client_getline(c, buf, maxlen)) {
+      ret = buf;
+      break;
+    }
+    if (c->state != MC_OPEN || c->closing || c->finishing) break;
+    msock_wait();
+  }
+  MUNLOCK();
+  return ret;
+}
+
+/**
+ * Read a line from the client which issued the current command, skipping
+ * blank lines.
+ *
+ * @param buf [out] buffer to store the line, without newline
+ * @param maxlen [in] size of @a buf
+ *
+ * @return @a buf, or NULL when the client has been disconnected.
+ */
+static char *
+client_getl(char *buf, int maxlen)
+{
+  char *ret;
+
+  while((ret = client_gets(buf, maxlen)) != NULL) {
+    if (buf[0] != '\0') break;
+  }
+  return ret;
+}
+
+/**
+ * Queue data to be sent to a client.  If the queue exceeds the limit,
+ * the client is marked to be dropped.  Should be called with lock.
+ *
+ * @param c [i/o] client
+ * @param head [in] data to be sent first, or NULL
+ * @param headlen [in] length of @a head
+ * @param data [in] data to be sent
+ * @param len [in] length of @a data
+ * @param msgend [in] TRUE if this ends a message
+ */
+static void
+client_queue(MODULE_CLIENT *c, char *head, int headlen, char *data, int len, boolean msgend)
+{
+  if (c->qlen + c->slen - c->spos + headlen + len > module_queuelimit) {
+    jlog("Warning: module: client #%d too slow (%d bytes pending), dropped\n", c->id, c->qlen + c->slen - c->spos);
+    c->closing = TRUE;
+    return;
+  }
+  if (head) buf_append(&(c->qbuf), &(c->qlen), &(c->qsize), head, headlen);
+  buf_append(&(c->qbuf), &(c->qlen), &(c->qsize), data, len);
+  c->byte_queued += headlen + len;
+  if (msgend) c->msg_num++;
+}
+
+/**
+ * Queue a binary frame to a client.  Should be called with lock.
+ *
+ * @param c [i/o] client
+ * @param type [in] frame type, one of MODULE_BIN_*
+ * @param data [in] payload
+ * @param len [in] length of @a data
+ */
+static void
+client_queue_frame(MODULE_CLIENT *c, int type, char *data, int len)
+{
+  char head[MODULE_BIN_HEADLEN];
+  int i;
+
+  /* type and payload length in little endian */
+  for(i=0;i<4;i++) {
+    head[i] = (type >> (i * 8)) & 0xff;
+    head[i+4] = (len >> (i * 8)) & 0xff;
+  }
+  client_queue(c, head, MODULE_BIN_HEADLEN, data, len, TRUE);
+}
+
+/**
+ * One step of the event loop for the module clients.  Accept a new
+ * connection, read incoming data and write queued data.  Clients
+ * requested to close are also disconnected here.
+ *
+ * @param tv [in] timeout, or NULL to wait until something happens
+ */
+static void
+msock_io(struct timeval *tv)
+{
+  fd_set rfds, wfds;
+  MODULE_CLIENT *c;
+  char *tmp;
+  int i, n, sd, maxsd;
+  char rbuf[MAXBUFLEN];
+
+  FD_ZERO(&rfds);
+  FD_ZERO(&wfds);
+  FD_SET(listen_sd, &rfds);
+  maxsd = listen_sd;
+#ifdef MODULE_IO_THREAD
+  FD_SET(wake_fd[0], &rfds);
+  if (maxsd < wake_fd[0]) maxsd = wake_fd[0];
+#endif
+  MLOCK();
+  for(i=0;i<module_maxclient;i++) {
+    c = &(client[i]);
+    if (c->state != MC_OPEN) continue;
+    if (c->closing) {
+      client_shutdown(c);
+      continue;
+    }
+    if (c->finishing && c->spos >= c->slen && c->qlen == 0) {
+      client_shutdown(c);
+      continue;
+    }
+    if (c->spos >= c->slen && c->qlen > 0) {
+      /* swap buffers to write the queued data without lock */
+      tmp = c->sbuf; c->sbuf = c->qbuf; c->qbuf = tmp;
+      n = c->ssize; c->ssize = c->qsize; c->qsize = n;
+      c->slen = c->qlen;
+      c->spos = 0;
+      c->qlen = 0;
+    }
+    FD_SET(c->sd, &rfds);
+    if (c->spos < c->slen) FD_SET(c->sd, &wfds);
+    if (maxsd < c->sd) maxsd = c->sd;
+  }
+  MUNLOCK();
+
+  if (select(maxsd+1, &rfds, &wfds, NULL, tv) <= 0) return;
+
+#ifdef MODULE_IO_THREAD
+  if (FD_ISSET(wake_fd[0], &rfds)) {
+    MLOCK();
+    while(read(wake_fd[0], rbuf, MAXBUFLEN) > 0);
+    wake_pending = FALSE;
+    MUNLOCK();
+  }
+#endif
+
+  /* slots are opened and closed only here, so state can be read without lock */
+  for(i=0;i<module_maxclient;i++) {
+    c = &(client[i]);
+    if (c->state != MC_OPEN) continue;
+    if (FD_ISSET(c->sd, &wfds)) {
+      n = send(c->sd, c->sbuf + c->spos, c->slen - c->spos, MSG_NOSIGNAL);
+      if (n < 0 && !sock_wouldblock()) {
+	MLOCK();
+	client_shutdown(c);
+	MUNLOCK();
+	continue;
+      }
+      if (n > 0) {
+	MLOCK();
+	c->spos += n;
+	c->byte_sent += n;
+	MUNLOCK();
+      }
+    }
+    if (FD_ISSET(c->sd, &rfds)) {
+      n = recv(c->sd, rbuf, MAXBUFLEN, 0);
+      if (n == 0 || (n < 0 && !sock_wouldblock())) {
+	MLOCK();
+	client_shutdown(c);
+	MUNLOCK();
+	continue;
+      }
+      if (n > 0) {
+	MLOCK();
+	buf_append(&(c->ibuf), &(c->ilen), &(c->isize), rbuf, n);
+#ifdef MODULE_IO_THREAD
+	pthread_cond_broadcast(&cond);
+#endif
+	MUNLOCK();
+      }
+    }
+  }
+
+  if (FD_ISSET(listen_sd, &rfds)) {
+    if ((sd = accept_from(listen_sd)) >= 0) {
+      MLOCK();
+      client_open(sd);
+      MUNLOCK();
+    }
+  }
+}
+
+#ifdef MODULE_IO_THREAD
+/**
+ * Main function of the I/O thread.
+ *
+ * @param dummy [in] not used
+ *
+ * @return NULL
+ */
+static void *
+msock_io_thread(void *dummy)
+{
+  boolean quit;
+
+  while(1) {
+    MLOCK();
+    quit = io_quit;
+    MUNLOCK();
+    if (quit) break;
+    msock_io(NULL);
+  }
+  return NULL;
+}
+#endif
+
+/**
+ * Generic function to send a formatted message to client module.
+ * The message is queued to the client which issued the current
+ * command, or to all the clients when not executing a command.
+ *
  * @param fmt [in] format string, like printf.
  * @param ... [in] variable length argument like printf.
- * 
+ *
  * @return the same as printf, i.e. number of characters printed.
  */
 int
@@ -45,88 +548,185 @@ module_send(char *fmt, ...)
   va_list ap;
   int ret;
   char *buf;
+  int i, len;
+  boolean msgend;
+  MODULE_CLIENT *c;
+#ifndef MODULE_IO_THREAD
+  struct timeval tv;
+#endif
+
+  if (open_num == 0) return 0;
 
-  if (module_sd < 0) return 0;
-  
   va_start(ap,fmt);
   ret = vsnprintf(inbuf, MAXBUFLEN, fmt, ap);
   va_end(ap);
   if (ret > 0) {		/* success */
-    
+
 #ifdef CHARACTER_CONVERSION
     buf = charconv(inbuf, outbuf, MAXBUFLEN);
 #else
     buf = inbuf;
 #endif
-    if (
-#ifdef WINSOCK
-	send(module_sd, buf, strlen(buf), 0)
-#else
-	write(module_sd, buf, strlen(buf))
-#endif
-	< 0) {
-      perror("Error: module_send:");
-      module_disconnect();
-      if (local_recog)
-	j_request_pause(local_recog);
-      printf("socket error, connection closed\n");
+    len = strlen(buf);
+    /* a message ends with a line of single period */
+    msgend = (len >= 2 && buf[len-2] == '.' && buf[len-1] == '\n' && (len == 2 || buf[len-3] == '\n'));
+    MLOCK();
+    for(i=0;i<module_maxclient;i++) {
+      if (reply_to >= 0 && i != reply_to) continue;
+      c = &(client[i]);
+      if (c->state != MC_OPEN || c->closing || c->finishing) continue;
+      if (send_format != MODULE_FORMAT_ALL && c->format != send_format) continue;
+      if (c->format == MODULE_FORMAT_BINARY) {
+	/* send in a text frame when the message is completed */
+	buf_append(&(c->tbuf), &(c->tlen), &(c->tsize), buf, len);
+	if (msgend) {
+	  /* the last period line is not included */
+	  client_queue_frame(c, MODULE_BIN_TEXT, c->tbuf, c->tlen - 2);
+	  c->tlen = 0;
+	}
+      } else {
+	client_queue(c, NULL, 0, buf, len, msgend);
+      }
+    }
+    msock_wakeup();
+    MUNLOCK();
+#ifndef MODULE_IO_THREAD
+    if (msgend) {
+      tv.tv_sec = 0;
+      tv.tv_usec = 0;
+      msock_io(&tv);
     }
+#endif
   }
   return(ret);
 }
 
-static char *
-myfgets(char *buf, int maxlen, FILE *fp)
+/**
+ * Send a binary frame to the clients of binary output format.  The
+ * frame is sent to the client which issued the current command, or to
+ * all the binary clients when not executing a command.
+ *
+ * @param type [in] frame type, one of MODULE_BIN_*
+ * @param data [in] payload
+ * @param len [in] length of @a data
+ *
+ * @return the number of clients the frame was queued for.
+ */
+int
+module_send_frame(int type, char *data, int len)
 {
-  char *ret;
-  int len;
-  
-  if ((ret = fgets(buf, maxlen, fp)) != NULL) {
-    len = strlen(buf);
-    if (buf[len-1] == '\n') {
-      buf[len-1] = '\0';
-      if (len >= 2 && buf[len-2] == '\r') {
-	buf[len-2] = '\0';
-      }
-    }
+  int i, n;
+  MODULE_CLIENT *c;
+#ifndef MODULE_IO_THREAD
+  struct timeval tv;
+#endif
+
+  if (open_num == 0) return 0;
+
+  n = 0;
+  MLOCK();
+  for(i=0;i<module_maxclient;i++) {
+    if (reply_to >= 0 && i != reply_to) continue;
+    c = &(client[i]);
+    if (c->state != MC_OPEN || c->closing || c->finishing) continue;
+    if (c->format != MODULE_FORMAT_BINARY) continue;
+    client_queue_frame(c, type, data, len);
+    n++;
   }
-  return ret;
+  msock_wakeup();
+  MUNLOCK();
+#ifndef MODULE_IO_THREAD
+  tv.tv_sec = 0;
+  tv.tv_usec = 0;
+  msock_io(&tv);
+#endif
+  return n;
 }
 
-/** 
- * Read grammar (DFA and dictionary) from socket and returns newly allocated
- * grammars.
- * 
- * @param sd [in] socket descpriter
+/**
+ * Restrict the following module_send() to the clients of the format.
+ *
+ * @param format [in] MODULE_FORMAT_XML, MODULE_FORMAT_BINARY or
+ * MODULE_FORMAT_ALL to send to all clients
+ */
+void
+module_send_format(int format)
+{
+  send_format = format;
+}
+
+/**
+ * Count the clients of the output format.  When executing a command,
+ * only the client which issued it is counted.
+ *
+ * @param format [in] output format
+ *
+ * @return the number of connected clients of the format.
+ */
+int
+module_client_num(int format)
+{
+  int i, n;
+
+  if (open_num == 0) return 0;
+  n = 0;
+  MLOCK();
+  for(i=0;i<module_maxclient;i++) {
+    if (reply_to >= 0 && i != reply_to) continue;
+    if (client[i].state == MC_OPEN && client[i].format == format) n++;
+  }
+  MUNLOCK();
+  return n;
+}
+
+/**
+ * Read grammar (DFA and dictionary) from the client and returns newly
+ * allocated grammars.
+ *
  * @param ret_dfa [out] read DFA
  * @param ret_winfo [out] read dictionary
  * @param hmminfo [in] HMM definition
- * 
+ * @param r [in] recognition process to which the grammar will be added
+ *
  * @return TRUE on success, or FALSE on failure.
  * </EN>
  */
 static boolean
-read_grammar(FILE *fp, DFA_INFO **ret_dfa, WORD_INFO **ret_winfo, HTK_HMM_INFO *hmminfo, RecogProcess *r)
+read_grammar(DFA_INFO **ret_dfa, WORD_INFO **ret_winfo, HTK_HMM_INFO *hmminfo, RecogProcess *r)
 {
   DFA_INFO *dfa = NULL;
   WORD_INFO *winfo;
   JCONF_LM *lmconf;
+  int state_max, arc_num, terminal_max;
+  char line[MAXBUFLEN];
 
   /* load grammar: dfa and dict in turn */
   if (r->lmvar != LM_DFA_WORD) {
     dfa = dfa_info_new();
-    if (!rddfa_fp(fp, dfa)) {
-      return FALSE;
+    dfa_state_init(dfa);
+    state_max = arc_num = terminal_max = 0;
+    while(client_getl(line, MAXBUFLEN) != NULL) {
+      if (rddfa_line(line, dfa, &state_max, &arc_num, &terminal_max) == FALSE) break;
     }
+    dfa->state_num = state_max + 1;
+    dfa->arc_num = arc_num;
+    dfa->term_num = terminal_max + 1;
   }
   winfo = word_info_new();
+  voca_load_start(winfo, hmminfo, FALSE);
   if (r->lmvar == LM_DFA_WORD) {
     lmconf = r->lm->config;
-    if (!voca_load_wordlist_fp(fp, winfo, hmminfo, lmconf->wordrecog_head_silence_model_name, lmconf->wordrecog_tail_silence_model_name, (lmconf->wordrecog_silence_context_name[0] == '\0') ? NULL : lmconf->wordrecog_silence_context_name)) {
+    while(client_getl(line, MAXBUFLEN) != NULL) {
+      if (voca_load_word_line(line, winfo, hmminfo, lmconf->wordrecog_head_silence_model_name, lmconf->wordrecog_tail_silence_model_name, (lmconf->wordrecog_silence_context_name[0] == '\0') ? NULL : lmconf->wordrecog_silence_context_name) == FALSE) break;
+    }
+    if (!voca_load_end(winfo)) {
       return FALSE;
     }
   } else {
-    if (!voca_load_htkdict_fp(fp, winfo, hmminfo, FALSE)) {
+    while(client_getl(line, MAXBUFLEN) != NULL) {
+      if (voca_load_line(line, winfo, hmminfo) == FALSE) break;
+    }
+    if (!voca_load_end(winfo)) {
       dfa_info_free(dfa);
       return FALSE;
     }
@@ -219,20 +819,37 @@ msock_exec_command(char *command, Recog *recog)
       module_send("<SYSINFO PROCESS=\"SLEEP\"/>\n.\n");
     }
   } else if (strmatch(command, "DIE")) {
-    /* disconnect */
-    close_socket(module_sd);
-    module_sd = -1;
-#if defined(_WIN32) && !defined(__CYGWIN32__)
-    /* this is single process and has not forked, so
-       we just disconnect the connection here.  */
-#else
-    /* this is a forked process, so exit here. */
-
-#endif
+    /* disconnect this client, others are kept */
+    client_request_close(reply_to);
   } else if (strmatch(command, "VERSION")) {
     /* return version */
     module_send("<ENGINEINFO TYPE=\"%s\" VERSION=\"%s\" CONF=\"%s\"/>\n.\n",
 		JULIUS_PRODUCTNAME, JULIUS_VERSION, JULIUS_SETUP);
+  } else if (strmatch(command, "OUTPUTFORMAT")) {
+    /* change output format of this client */
+    if (
+	client_gets(buf, MAXBUFLEN)
+	== NULL) {
+      fprintf(stderr, "Error: msock(OUTPUTFORMAT): no argument\n");
+      return;
+    }
+    /* the reply is sent in the current format, and following ones in new */
+    if (strmatch(buf, "BINARY")) {
+      module_send("<OUTPUTFORMAT TYPE=\"BINARY\"/>\n.\n");
+      MLOCK();
+      client[reply_to].format = MODULE_FORMAT_BINARY;
+      MUNLOCK();
+      /* send the word lists to decode word IDs */
+      send_binary_voca(recog);
+    } else if (strmatch(buf, "XML")) {
+      module_send("<OUTPUTFORMAT TYPE=\"XML\"/>\n.\n");
+      MLOCK();
+      client[reply_to].format = MODULE_FORMAT_XML;
+      MUNLOCK();
+    } else {
+      fprintf(stderr, "Error: msock(OUTPUTFORMAT): unknown format [%s]\n", buf);
+      module_send("<OUTPUTFORMAT STATUS=\"ERROR\" REASON=\"UNKNOWN FORMAT\"/>\n.\n");
+    }
   } else if (strmatch(command, "PAUSE")) {
     /* pause recognition: will stop when the current input ends */
     j_request_pause(recog);
@@ -243,7 +860,7 @@ msock_exec_command(char *command, Recog *recog)
   } else if (strmatch(command, "INPUTONCHANGE")) {
     /* change grammar switching timing policy */
     if (
-	myfgets(buf, MAXBUFLEN, module_fp)
+	client_gets(buf, MAXBUFLEN)
 	== NULL) {
       fprintf(stderr, "Error: msock(INPUTONCHANGE): no argument\n");
       return;
@@ -273,7 +890,7 @@ msock_exec_command(char *command, Recog *recog)
       p = NULL;
     }
     /* read a new grammar via socket */
-    if (read_grammar(module_fp, &new_dfa, &new_winfo, cur->am->hmminfo, cur) == FALSE) {
+    if (read_grammar(&new_dfa, &new_winfo, cur->am->hmminfo, cur) == FALSE) {
       module_send("<GRAMMAR STATUS=\"ERROR\" REASON=\"WRONG DATA\"/>\n.\n");
     } else {
       if (cur->lmtype == LM_DFA) {
@@ -307,7 +924,7 @@ msock_exec_command(char *command, Recog *recog)
       p = NULL;
     }
     /* read a new grammar via socket */
-    if (read_grammar(module_fp, &new_dfa, &new_winfo, cur->am->hmminfo, cur) == FALSE) {
+    if (read_grammar(&new_dfa, &new_winfo, cur->am->hmminfo, cur) == FALSE) {
       module_send("<GRAMMAR STATUS=\"ERROR\" REASON=\"WRONG DATA\"/>\n.\n");
     } else {
       if (cur->lmtype == LM_DFA) {
@@ -329,7 +946,7 @@ msock_exec_command(char *command, Recog *recog)
     /* remove the grammar specified by ID or name */
     /* read a list of grammar IDs to be deleted */
     if (
-	myfgets(buf, MAXBUFLEN, module_fp)
+	client_gets(buf, MAXBUFLEN)
 	== NULL) {
       fprintf(stderr, "Error: msock(DELGRAM): no argument\n");
       return;
@@ -366,7 +983,7 @@ msock_exec_command(char *command, Recog *recog)
     /* activate grammar in this engine */
     /* read a list of grammar IDs or names to be activated */
     if (
-	myfgets(buf, MAXBUFLEN, module_fp)
+	client_gets(buf, MAXBUFLEN)
 	== NULL) {
       fprintf(stderr, "Error: msock(ACTIVATEGRAM): no argument\n");
       return;
@@ -403,7 +1020,7 @@ msock_exec_command(char *command, Recog *recog)
     /* deactivate grammar in this engine */
     /* read a list of grammar IDs or names to be de-activated */
     if (
-	myfgets(buf, MAXBUFLEN, module_fp)
+	client_gets(buf, MAXBUFLEN)
 	== NULL) {
       fprintf(stderr, "Error: msock(DEACTIVATEGRAM): no argument\n");
       return;
@@ -453,7 +1070,7 @@ msock_exec_command(char *command, Recog *recog)
     JCONF_SEARCH *sconf;
     RecogProcess *r;
     if (
-	myfgets(buf, MAXBUFLEN, module_fp)
+	client_gets(buf, MAXBUFLEN)
 	== NULL) {
       /* when no argument, just return current process */
       send_current_process(cur);
@@ -500,7 +1117,7 @@ msock_exec_command(char *command, Recog *recog)
     RecogProcess *r;
 
     if (
-	myfgets(buf, MAXBUFLEN, module_fp)
+	client_gets(buf, MAXBUFLEN)
 	== NULL) {
       fprintf(stderr, "Error: msock(ADDPROCESS): no argument\n");
       module_send("<RECOGPROCESS STATUS=\"ERROR\" REASON=\"NO ARGUMENT\"/>\n.\n");
@@ -538,7 +1155,7 @@ msock_exec_command(char *command, Recog *recog)
     RecogProcess *r;
 
     if (
-	myfgets(buf, MAXBUFLEN, module_fp)
+	client_gets(buf, MAXBUFLEN)
 	== NULL) {
       fprintf(stderr, "Error: msock(DELPROCESS): no argument\n");
       module_send("<RECOGPROCESS STATUS=\"ERROR\" REASON=\"NO ARGUMENT\"/>\n.\n");
@@ -585,7 +1202,7 @@ msock_exec_command(char *command, Recog *recog)
 
   else if (strmatch(command, "ACTIVATEPROCESS")) {
     if (
-	myfgets(buf, MAXBUFLEN, module_fp)
+	client_gets(buf, MAXBUFLEN)
 	== NULL) {
       fprintf(stderr, "Error: msock(ACTIVATEPROCESS): no argument\n");
       module_send("<RECOGPROCESS STATUS=\"ERROR\" REASON=\"NO ARGUMENT\"/>\n.\n");
@@ -599,7 +1216,7 @@ msock_exec_command(char *command, Recog *recog)
   }
   else if (strmatch(command, "DEACTIVATEPROCESS")) {
     if (
-	myfgets(buf, MAXBUFLEN, module_fp)
+	client_gets(buf, MAXBUFLEN)
 	== NULL) {
       fprintf(stderr, "Error: msock(DEACTIVATEPROCESS): no argument\n");
       module_send("<RECOGPROCESS STATUS=\"ERROR\" REASON=\"NO ARGUMENT\"/>\n.\n");
@@ -619,7 +1236,7 @@ msock_exec_command(char *command, Recog *recog)
 
     /* get gramamr ID to add */
     if (
-	myfgets(buf, MAXBUFLEN, module_fp)
+	client_gets(buf, MAXBUFLEN)
 	== NULL) {
       fprintf(stderr, "Error: msock(DEACTIVATEPROCESS): no argument\n");
       module_send("<RECOGPROCESS STATUS=\"ERROR\" REASON=\"NO ARGUMENT\"/>\n.\n");
@@ -631,7 +1248,7 @@ msock_exec_command(char *command, Recog *recog)
     words = word_info_new();
     voca_load_start(words, cur->am->hmminfo, FALSE);
     while (
-	myfgets(buf, MAXBUFLEN, module_fp)
+	client_gets(buf, MAXBUFLEN)
 	!= NULL) {
       if (cur->lmvar == LM_DFA_WORD) {
 	ret = voca_load_word_line(buf, words, cur->am->hmminfo, 
@@ -673,67 +1290,129 @@ msock_exec_command(char *command, Recog *recog)
   }
 }
 
-/** 
+/**
+ * Execute all the commands already received from clients.
+ *
+ * @param recog [i/o] engine instance
+ *
+ * @return the number of executed commands.
+ */
+static int
+msock_exec_received_commands(Recog *recog)
+{
+  int i, n;
+  boolean got;
+
+  n = 0;
+  for(i=0;i<module_maxclient;i++) {
+    while(1) {
+      MLOCK();
+      got = (client[i].state == MC_OPEN && !client[i].closing && !client[i].finishing && client_getline(&(client[i]), mbuf, MAXBUFLEN));
+      if (got) {
+	client[i].cmd_num++;
+	reply_to = i;
+      }
+      MUNLOCK();
+      if (!got) break;
+      msock_exec_command(mbuf, recog);
+      MLOCK();
+      reply_to = -1;
+      MUNLOCK();
+      n++;
+    }
+  }
+  return n;
+}
+
+/**
+ * Check if any client has a command to be processed.  Should be called
+ * with lock.
+ *
+ * @return TRUE if a command is waiting.
+ */
+static boolean
+msock_command_ready()
+{
+  MODULE_CLIENT *c;
+  int i;
+
+  for(i=0;i<module_maxclient;i++) {
+    c = &(client[i]);
+    if (c->state == MC_OPEN && !c->closing && !c->finishing && c->ilen > 0 && memchr(c->ibuf, '\n', c->ilen) != NULL) return TRUE;
+  }
+  return FALSE;
+}
+
+/**
+ * Wait until at least one client is connected.
+ *
+ */
+static void
+module_wait_client()
+{
+  printf  ("///////////////////////////////\n");
+  printf  ("///  Module mode ready\n");
+  printf  ("///  waiting client at %5d\n", module_port);
+  printf  ("///////////////////////////////\n");
+  printf  ("///  ");
+  fflush(stdout);
+
+  MLOCK();
+  while(open_num == 0) msock_wait();
+  client_lost = FALSE;
+  MUNLOCK();
+}
+
+/**
  * <JA>
  * 現在クライアントモジュールからの命令がバッファにあるか調べ，
- * もしあれば処理する. なければそのまま終了する. 
- * 
+ * もしあれば処理する. なければそのまま終了する.
+ *
  * </JA>
  * <EN>
- * Process one commands from client module.  If no command is in the buffer,
+ * Process commands from client modules.  If no command is in the buffer,
  * it will return without blocking.
- * 
+ *
  * </EN>
  */
 static void
 msock_check_and_process_command(Recog *recog, void *dummy)
 {
-  fd_set rfds;
-  int ret;
+#ifndef MODULE_IO_THREAD
   struct timeval tv;
-
-  if (module_sd < 0) return;
+#endif
 
   local_recog = recog;
 
-  /* check if some commands are waiting in queue */
-  FD_ZERO(&rfds);
-  FD_SET(module_sd, &rfds);
+#ifndef MODULE_IO_THREAD
   tv.tv_sec = 0;
   tv.tv_usec = 0;	      /* 0 msec timeout: return immediately */
-  ret = select(module_sd+1, &rfds, NULL, NULL, &tv);
-  if (ret < 0) {
-    perror("msock_check_and_process_command: cannot poll\n");
-  }
-  if (ret > 0) {
-    /* there is data to read */
-    /* process command and change status if necessaty */
-    while(select(module_sd+1, &rfds, NULL, NULL, &tv) > 0) {
-      if (myfgets(mbuf, MAXBUFLEN, module_fp) != NULL) {
-	msock_exec_command(mbuf, recog);
-      } else {
-	module_disconnect();
-	if (local_recog)
-	  j_request_pause(local_recog);
-	printf("socket error, connection closed\n");
-      }
-    }
+  msock_io(&tv);
+#endif
+
+  msock_exec_received_commands(recog);
+
+  if (client_lost) {
+    /* all clients have gone: pause until next connection */
+    client_lost = FALSE;
+    j_request_pause(recog);
+    printf("connection closed\n");
   }
 }
 
-/** 
+/**
  * <JA>
- * クライアントモジュールからの命令を読み込んで処理する. 
- * 命令が無い場合，次のコマンドが来るまで待つ. 
+ * クライアントモジュールからの命令を読み込んで処理する.
+ * 命令が無い場合，次のコマンドが来るまで待つ.
  * msock_exec_command() 内で j_request_resume() が呼ばれて
- * recog->process_active が TRUE になるまで繰り返す. 
+ * recog->process_active が TRUE になるまで繰り返す.
  * この関数が終わったときプロセスは resume |!する. |
- * 
+ *
  * </JA>
  * <EN>
- * Process one commands from client module.  If no command is in the buffer,
+ * Process commands from client modules.  If no command is in the buffer,
  * it will block until next command comes.
- * 
+ *
  * </EN>
  */
 static void
@@ -741,18 +1420,19 @@ msock_process_command(Recog *recog, void *dummy)
 {
   local_recog = recog;
 
-  if (module_sd < 0) {
-    module_connect();
+  if (open_num == 0) {
+    module_wait_client();
     j_request_resume(recog);
     return;
   }
   while(!recog->process_active) {
-    if (myfgets(mbuf, MAXBUFLEN, module_fp) != NULL) {
-      msock_exec_command(mbuf, recog);
-    } else {
-      module_disconnect();
-      printf("socket error, connection closed\n");
-      module_connect();
+    if (msock_exec_received_commands(recog) > 0) continue;
+    MLOCK();
+    while(open_num > 0 && !msock_command_ready()) msock_wait();
+    MUNLOCK();
+    if (open_num == 0) {
+      printf("connection closed\n");
+      module_wait_client();
     }
   }
 }
@@ -776,6 +1456,28 @@ opt_module(Jconf *jconf, char *arg[], int argnum)
   return TRUE;
 }
 
+static boolean
+opt_moduleclient(Jconf *jconf, char *arg[], int argnum)
+{
+  module_maxclient = atoi(arg[0]);
+  if (module_maxclient < 1) {
+    fprintf(stderr, "Error: -moduleclient should be larger than 0\n");
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static boolean
+opt_modulequeue(Jconf *jconf, char *arg[], int argnum)
+{
+  module_queuelimit = atoi(arg[0]) * 1024;
+  if (module_queuelimit < MAXBUFLEN) {
+    fprintf(stderr, "Error: -modulequeue should be at least %d\n", MAXBUFLEN / 1024);
+    return FALSE;
+  }
+  return TRUE;
+}
+
 static boolean
 opt_outcode(Jconf *jconf, char *arg[], int argnum)
 {
@@ -787,6 +1489,8 @@ void
 module_add_option()
 {
   j_add_option("-module", 1, 0, "run as a server module", opt_module);
+  j_add_option("-moduleclient", 1, 1, "maximum number of module clients", opt_moduleclient);
+  j_add_option("-modulequeue", 1, 1, "output queue size per module client in KB", opt_modulequeue);
   j_add_option("-outcode", 1, 1, "select info to output to the module: WLPSCwlps", opt_outcode);
 }
 
@@ -803,69 +1507,74 @@ module_setup(Recog *recog, void *data)
   module_regist_callback(recog, data);
   setup_output_msock(recog, data);
 }
-  
-static void
-module_connect()
-{
-#if defined(_WIN32) && !defined(__CYGWIN32__)
-  int sd;
-#endif
-
-  if (listen_sd < 0) return;
-  if (module_sd >= 0) return;
-  
-  printf  ("///////////////////////////////\n");
-  printf  ("///  Module mode ready\n");
-  printf  ("///  waiting client at %5d\n", module_port);
-  printf  ("///////////////////////////////\n");
-  printf  ("///  ");
-  
-  /* no fork, just wait for one connection and proceed */
-  if ((module_sd = accept_from(listen_sd)) < 0) {
-    fprintf(stderr, "Error: failed to accept connection\n");
-    return;
-  }
-#if defined(_WIN32) && !defined(__CYGWIN32__)
-  /* call winsock function to make the socket capable of reading/writing */
-  if ((sd = _open_osfhandle(module_sd, O_RDWR|O_BINARY)) < 0) {
-    fprintf(stderr, "Error: failed to open_osfhandle\n");
-    return;
-  }
-  if ((module_fp = fdopen(sd, "rb+")) == NULL) {
-    fprintf(stderr, "Error: failed to fdopen socket\n");
-    return;
-  }
-#else
-  if ((module_fp = fdopen(module_sd, "r+")) == NULL) {
-    fprintf(stderr, "Error; failed to fdopen socket\n");
-    return;
-  }
-#endif
-}
 
 void
 module_server()
 {
-#if defined(_WIN32) && !defined(__CYGWIN32__)
-  int sd;
-#endif
-
   /* prepare socket to listen */
   if ((listen_sd = ready_as_server(module_port)) < 0) {
     fprintf(stderr, "Error: failed to bind socket\n");
     return;
   }
-  module_connect();
+  set_nonblock(listen_sd);
+  client = (MODULE_CLIENT *)mymalloc(sizeof(MODULE_CLIENT) * module_maxclient);
+  memset(client, 0, sizeof(MODULE_CLIENT) * module_maxclient);
+#ifdef MODULE_IO_THREAD
+  if (pipe(wake_fd) < 0) {
+    fprintf(stderr, "Error: failed to create pipe\n");
+    return;
+  }
+  set_nonblock(wake_fd[0]);
+  set_nonblock(wake_fd[1]);
+  if (pthread_create(&io_thread, NULL, msock_io_thread, NULL) != 0) {
+    fprintf(stderr, "Error: failed to create module I/O thread\n");
+    return;
+  }
+#endif
+  module_wait_client();
 }
 
 void
 module_disconnect()
 {
-  /* disconnect control module */
-  if (module_sd >= 0) { /* connected now */
-    module_send("<SYSINFO PROCESS=\"ERREXIT\"/>\n.\n");
-    close_socket(module_sd);
-    module_sd = -1;
-    module_fp = NULL;
+  struct timeval tv;
+  int i, n;
+  boolean pending;
+
+  if (client == NULL) return;
+
+  /* tell all clients */
+  module_send("<SYSINFO PROCESS=\"ERREXIT\"/>\n.\n");
+
+#ifdef MODULE_IO_THREAD
+  /* stop I/O thread and flush the rest here */
+  MLOCK();
+  io_quit = TRUE;
+  msock_wakeup();
+  MUNLOCK();
+  pthread_join(io_thread, NULL);
+#endif
+  for(n=0;n<100;n++) {
+    pending = FALSE;
+    for(i=0;i<module_maxclient;i++) {
+      if (client[i].state == MC_OPEN && (client[i].qlen > 0 || client[i].spos < client[i].slen)) pending = TRUE;
+    }
+    if (!pending) break;
+    tv.tv_sec = 0;
+    tv.tv_usec = 10000;
+    msock_io(&tv);
+  }
+  for(i=0;i<module_maxclient;i++) {
+    if (client[i].state == MC_OPEN) client_shutdown(&(client[i]));
+  }
+  for(i=0;i<module_maxclient;i++) {
+    if (client[i].qbuf) free(client[i].qbuf);
+    if (client[i].sbuf) free(client[i].sbuf);
+    if (client[i].ibuf) free(client[i].ibuf);
+    if (client[i].tbuf) free(client[i].tbuf);
   }
+  free(client);
+  client = NULL;
+  close_socket(listen_sd);
+  listen_sd = -1;
 }
@@ -237,7 +237,7 @@ status_pass1_begin(Recog *recog, void *dummy)
  * </EN>
  */
 static void
-result_pass1_current(Recog *recog, void *dummy)
+result_pass1_current_xml(Recog *recog, void *dummy)
 {
   int i;
   WORD_INFO *winfo;
@@ -304,7 +304,7 @@ result_pass1_current(Recog *recog, void *dummy)
  * </EN>
  */
 static void
-result_pass1_final(Recog *recog, void *dummy)
+result_pass1_final_xml(Recog *recog, void *dummy)
 {
   int i;
   RecogProcess *r;
@@ -340,6 +340,54 @@ result_pass1_final(Recog *recog, void *dummy)
   }
 }
 
+/** 
+ * <JA>
+ * 第1パス：ストリーム入力で確定した単語を出力する（-streamcommit 指定時，
+ * 単語が確定するたびに呼ばれる）. 確定単語は最終結果に再度含まれないので，
+ * 最終結果と同じ出力項目で送る. 
+ * 
+ * </JA>
+ * <EN>
+ * 1st pass: output words committed on streaming input (will be called
+ * each time words are committed with -streamcommit).  The committed
+ * words will not appear again in the final result, so they are sent
+ * with the same output items as the final result.
+ * 
+ * </EN>
+ */
+static void
+result_pass1_determined_xml(Recog *recog, void *dummy)
+{
+  int i;
+  RecogProcess *r;
+  boolean multi;
+  static char exbuf[MAXSTRLEN];
+
+  if (out2_never) return;	/* no output specified */
+
+  if (recog->process_list->next != NULL) multi = TRUE;
+  else multi = FALSE;
+
+  for(r=recog->process_list;r;r=r->next) {
+    if (! r->live) continue;
+    if (! r->have_determine) continue;
+
+    if (multi) {
+      escape_xml(r->config->name, exbuf);
+      module_send("<RECOGOUT ID=\"SR%02d\" NAME=\"%s\">\n", r->config->id, exbuf);
+    } else {
+      module_send("<RECOGOUT>\n");
+    }
+    module_send("  <COMMIT PASS=\"1\" FRAME=\"%d\" TIME=\"%ld\">\n", r->result.num_frame, time(NULL));
+    for (i=0;i<r->result.pass1.word_num;i++) {
+      module_send("    <WHYPO");
+      msock_word_out2(r->result.pass1.word[i], r);
+      module_send("/>\n");
+    }
+    module_send("  </COMMIT>\n</RECOGOUT>\n.\n");
+  }
+}
+
 /** 
  * <JA>
  * 第1パス：終了時の出力（第1パスの終了時に必ず呼ばれる）
@@ -376,7 +424,7 @@ status_pass1_end(Recog *recog, void *dummy)
  * </EN>
  */
 static void
-result_pass2(Recog *recog, void *dummy)
+result_pass2_xml(Recog *recog, void *dummy)
 {
   int i, n, num;
   WORD_INFO *winfo;
@@ -517,7 +565,7 @@ result_pass2(Recog *recog, void *dummy)
  * </EN>
  */
 static void
-result_graph(Recog *recog, void *dummy)
+result_graph_xml(Recog *recog, void *dummy)
 {
   WordGraph *wg;
   int i;
@@ -656,7 +704,7 @@ status_param(Recog *recog, void *dummy)
  * </EN>
  */
 static void
-result_gmm(Recog *recog, void *dummy)
+result_gmm_xml(Recog *recog, void *dummy)
 {
   static char exbuf[MAXSTRLEN];
   escape_xml(recog->gc->max_d->name, exbuf);
@@ -667,6 +715,388 @@ result_gmm(Recog *recog, void *dummy)
   module_send("/>\n.\n");
 }
 
+/********************* BINARY RESULT OUTPUT *************************/
+
+static char *binbuf = NULL;	///< Work buffer to build a binary record
+static int binlen = 0;		///< Length of data in @a binbuf
+static int binsize = 0;		///< Allocated size of @a binbuf
+
+/** 
+ * <JA>
+ * バイナリレコードにデータを追加する. 
+ * 
+ * @param data [in] データ
+ * @param len [in] @a data の長さ
+ * </JA>
+ * <EN>
+ * Append data to the binary record.
+ * 
+ * @param data [in] data
+ * @param len [in] length of @a data
+ * </EN>
+ */
+static void
+bin_put(char *data, int len)
+{
+  if (binlen + len > binsize) {
+    if (binsize == 0) binsize = 4096;
+    while (binlen + len > binsize) binsize *= 2;
+    binbuf = (char *)myrealloc(binbuf, binsize);
+  }
+  memcpy(&(binbuf[binlen]), data, len);
+  binlen += len;
+}
+
+/* integers and floats are stored in little endian */
+static void
+bin_int(int v)
+{
+  char b[4];
+  b[0] = v & 0xff;
+  b[1] = (v >> 8) & 0xff;
+  b[2] = (v >> 16) & 0xff;
+  b[3] = (v >> 24) & 0xff;
+  bin_put(b, 4);
+}
+
+static void
+bin_float(float f)
+{
+  int v;
+  memcpy(&v, &f, 4);
+  bin_int(v);
+}
+
+static void
+bin_str(char *str)
+{
+  int len;
+  len = strlen(str);
+  bin_int(len);
+  bin_put(str, len);
+}
+
+/** 
+ * <JA>
+ * 第1パスの途中結果をバイナリで送信する. 
+ * 
+ * </JA>
+ * <EN>
+ * Send the progressive output of the 1st pass in binary.
+ * 
+ * </EN>
+ */
+static void
+result_pass1_current_bin(Recog *recog, void *dummy)
+{
+  int i;
+  RecogProcess *r;
+
+  if (out1_never) return;	/* no output specified */
+
+  for(r=recog->process_list;r;r=r->next) {
+    if (! r->live) continue;
+    if (! r->have_interim) continue;
+    binlen = 0;
+    bin_int(r->config->id);
+    bin_int(r->result.num_frame);
+    bin_float(r->result.pass1.score);
+    bin_int(r->result.pass1.word_num);
+    for (i=0;i<r->result.pass1.word_num;i++) bin_int(r->result.pass1.word[i]);
+    module_send_frame(MODULE_BIN_PASS1_INTERIM, binbuf, binlen);
+  }
+}
+
+/** 
+ * <JA>
+ * 第1パスの結果をバイナリで送信する. 
+ * 
+ * </JA>
+ * <EN>
+ * Send the result of the 1st pass in binary.
+ * 
+ * </EN>
+ */
+static void
+result_pass1_final_bin(Recog *recog, void *dummy)
+{
+  int i;
+  RecogProcess *r;
+
+  if (out1_never) return;	/* no output specified */
+
+  for(r=recog->process_list;r;r=r->next) {
+    if (! r->live) continue;
+    if (r->result.status < 0) continue;	/* search already failed  */
+    binlen = 0;
+    bin_int(r->config->id);
+    bin_float(r->result.pass1.score);
+    bin_int(r->result.pass1.word_num);
+    for (i=0;i<r->result.pass1.word_num;i++) bin_int(r->result.pass1.word[i]);
+    module_send_frame(MODULE_BIN_PASS1, binbuf, binlen);
+  }
+}
+
+/** 
+ * <JA>
+ * ストリーム入力で確定した単語をバイナリで送信する. 
+ * 
+ * </JA>
+ * <EN>
+ * Send the words committed on streaming input in binary.
+ * 
+ * </EN>
+ */
+static void
+result_pass1_determined_bin(Recog *recog, void *dummy)
+{
+  int i;
+  RecogProcess *r;
+
+  if (out2_never) return;	/* no output specified */
+
+  for(r=recog->process_list;r;r=r->next) {
+    if (! r->live) continue;
+    if (! r->have_determine) continue;
+    binlen = 0;
+    bin_int(r->config->id);
+    bin_int(r->result.num_frame);
+    bin_int(r->result.pass1.word_num);
+    for (i=0;i<r->result.pass1.word_num;i++) bin_int(r->result.pass1.word[i]);
+    module_send_frame(MODULE_BIN_PASS1_DETERMINED, binbuf, binlen);
+  }
+}
+
+/** 
+ * <JA>
+ * 最終結果をバイナリで送信する. 棄却・失敗時は文数0で送る. 
+ * 
+ * </JA>
+ * <EN>
+ * Send the final result in binary.  On rejection or failure, the
+ * status is sent with no sentence.
+ * 
+ * </EN>
+ */
+static void
+result_pass2_bin(Recog *recog, void *dummy)
+{
+  int i, n, num;
+  Sentence *s;
+  RecogProcess *r;
+  SentenceAlign *align;
+
+  for(r=recog->process_list;r;r=r->next) {
+    if (! r->live) continue;
+    num = (r->result.status < 0) ? 0 : r->result.sentnum;
+    binlen = 0;
+    bin_int(r->config->id);
+    bin_int(r->result.status);
+    bin_int(r->result.num_frame);
+    bin_int(num);
+    for(n=0;n<num;n++) {
+      s = &(r->result.sent[n]);
+      bin_float(s->score);
+      bin_float(s->score_am);
+      bin_float(s->score_lm);
+      bin_int((r->lmtype == LM_DFA) ? s->gram_id : -1);
+      bin_int(s->word_num);
+      /* word alignment if exist */
+      for (align = s->align; align; align = align->next) {
+	if (align->unittype == PER_WORD) break;
+      }
+      for (i=0;i<s->word_num;i++) {
+	bin_int(s->word[i]);
+#if defined(CONFIDENCE_MEASURE) && !defined(CM_MULTIPLE_ALPHA)
+	bin_float(s->confidence[i]);
+#else
+	bin_float(0.0);
+#endif
+	if (align) {
+	  bin_int(align->begin_frame[i]);
+	  bin_int(align->end_frame[i]);
+	} else {
+	  bin_int(-1);
+	  bin_int(-1);
+	}
+      }
+    }
+    module_send_frame(MODULE_BIN_RESULT, binbuf, binlen);
+  }
+}
+
+/** 
+ * <JA>
+ * 単語グラフをバイナリで送信する. 
+ * 
+ * </JA>
+ * <EN>
+ * Send the word graph in binary.
+ * 
+ * </EN>
+ */
+static void
+result_graph_bin(Recog *recog, void *dummy)
+{
+  WordGraph *wg;
+  int i;
+  int nodenum, arcnum;
+  RecogProcess *r;
+
+  for(r=recog->process_list;r;r=r->next) {
+    if (! r->live) continue;
+    if (r->result.wg == NULL) continue;	/* no graph obtained */
+    nodenum = arcnum = 0;
+    for(wg=r->result.wg;wg;wg=wg->next) {
+      nodenum++;
+      arcnum += wg->rightwordnum;
+    }
+    binlen = 0;
+    bin_int(r->config->id);
+    bin_int(nodenum);
+    bin_int(arcnum);
+    for(wg=r->result.wg;wg;wg=wg->next) {
+      bin_int(wg->id);
+      bin_int(wg->wid);
+      bin_int(wg->lefttime);
+      bin_int(wg->righttime);
+      bin_float(wg->graph_cm);
+      bin_float(wg->amavg);
+    }
+    for(wg=r->result.wg;wg;wg=wg->next) {
+      for(i=0;i<wg->rightwordnum;i++) {
+	bin_int(wg->id);
+	bin_int(wg->rightword[i]->id);
+      }
+    }
+    module_send_frame(MODULE_BIN_GRAPH, binbuf, binlen);
+  }
+}
+
+/** 
+ * <JA>
+ * GMMの結果をバイナリで送信する. 
+ * 
+ * </JA>
+ * <EN>
+ * Send the result of GMM in binary.
+ * 
+ * </EN>
+ */
+static void
+result_gmm_bin(Recog *recog, void *dummy)
+{
+  binlen = 0;
+#ifdef CONFIDENCE_MEASURE
+  bin_float(recog->gc->gmm_max_cm);
+#else
+  bin_float(0.0);
+#endif
+  bin_str(recog->gc->max_d->name);
+  module_send_frame(MODULE_BIN_GMM, binbuf, binlen);
+}
+
+/** 
+ * <JA>
+ * 単語IDを復号するため，各認識処理インスタンスの単語出力文字列の
+ * リストをバイナリで送信する. 
+ * 
+ * </JA>
+ * <EN>
+ * Send list of word output strings of each recognition process in
+ * binary, to decode word IDs in binary records.
+ * 
+ * </EN>
+ */
+void
+send_binary_voca(Recog *recog)
+{
+  WORD_INFO *winfo;
+  RecogProcess *r;
+  WORD_ID w;
+
+  for(r=recog->process_list;r;r=r->next) {
+    winfo = r->lm->winfo;
+    binlen = 0;
+    bin_int(r->config->id);
+    if (winfo == NULL) {
+      bin_int(0);
+    } else {
+      bin_int(winfo->num);
+      for(w=0;w<winfo->num;w++) bin_str(winfo->woutput[w]);
+    }
+    module_send_frame(MODULE_BIN_VOCA, binbuf, binlen);
+  }
+}
+
+/**********************************************************************/
+/* dispatch results to clients of each output format */
+
+/** 
+ * <JA>
+ * 結果をXMLクライアントとバイナリクライアントのそれぞれに送信する. 
+ * 
+ * @param recog [in] エンジンインスタンス
+ * @param xmlfunc [in] XML出力関数
+ * @param binfunc [in] バイナリ出力関数
+ * </JA>
+ * <EN>
+ * Send a result to XML clients and binary clients respectively.
+ * 
+ * @param recog [in] engine instance
+ * @param xmlfunc [in] function for XML output
+ * @param binfunc [in] function for binary output
+ * </EN>
+ */
+static void
+send_result(Recog *recog, void (*xmlfunc)(Recog *, void *), void (*binfunc)(Recog *, void *))
+{
+  if (module_client_num(MODULE_FORMAT_XML) > 0) {
+    module_send_format(MODULE_FORMAT_XML);
+    (*xmlfunc)(recog, NULL);
+    module_send_format(MODULE_FORMAT_ALL);
+  }
+  if (module_client_num(MODULE_FORMAT_BINARY) > 0) {
+    (*binfunc)(recog, NULL);
+  }
+}
+
+static void
+result_pass1_current(Recog *recog, void *dummy)
+{
+  send_result(recog, result_pass1_current_xml, result_pass1_current_bin);
+}
+
+static void
+result_pass1_determined(Recog *recog, void *dummy)
+{
+  send_result(recog, result_pass1_determined_xml, result_pass1_determined_bin);
+}
+
+static void
+result_pass1_final(Recog *recog, void *dummy)
+{
+  send_result(recog, result_pass1_final_xml, result_pass1_final_bin);
+}
+
+static void
+result_pass2(Recog *recog, void *dummy)
+{
+  send_result(recog, result_pass2_xml, result_pass2_bin);
+}
+
+static void
+result_graph(Recog *recog, void *dummy)
+{
+  send_result(recog, result_graph_xml, result_graph_bin);
+}
+
+static void
+result_gmm(Recog *recog, void *dummy)
+{
+  send_result(recog, result_gmm_xml, result_gmm_bin);
+}
+
 /** 
  * <JA>
  * 現在の保持している文法のリストをモジュールに送信する. 
@@ -749,6 +1179,7 @@ setup_output_msock(Recog *recog, void *data)
   callback_add(recog, CALLBACK_EVENT_PASS1_BEGIN, status_pass1_begin, data);
   callback_add(recog, CALLBACK_EVENT_PASS1_END, status_pass1_end, data);
   callback_add(recog, CALLBACK_RESULT_PASS1_INTERIM, result_pass1_current, data);
+  callback_add(recog, CALLBACK_RESULT_PASS1_DETERMINED, result_pass1_determined, data);
   callback_add(recog, CALLBACK_RESULT_PASS1, result_pass1_final, data);
 
   callback_add(recog, CALLBACK_STATUS_PARAM, status_param, data);
@@ -25,6 +25,7 @@
 #include "app.h"
 
 extern boolean separate_score_flag;
+extern int parallel_num;
 
 static boolean have_progout = FALSE;
 
@@ -422,8 +423,56 @@ result_pass1_current(Recog *recog, void *dummy)
   fflush(stdout);		/* flush */
 }
 
+/**
+ * <JA>
+ * 第1パス：入力途中で確定した単語列を出力する（"-streamcommit" 指定時に
+ * 単語が確定するたびに呼ばれる）.
+ * </JA>
+ * <EN>
+ * 1st pass: output words committed in the middle of input (called each
+ * time words are committed with "-streamcommit").
+ * </EN>
+ */
+static void
+result_pass1_determined(Recog *recog, void *dummy)
+{
+  int i;
+  WORD_INFO *winfo;
+  WORD_ID *seq;
+  int num;
+  RecogProcess *r;
 
-/** 
+  for(r=recog->process_list;r;r=r->next) {
+    if (! r->live) continue;
+    if (! r->have_determine) continue;
+
+    winfo = r->lm->winfo;
+    seq = r->result.pass1.word;
+    num = r->result.pass1.word_num;
+
+    if (r->config->output.progout_flag) {
+      /* clear the progressive output line */
+      printf("\r");
+      for(i=0;i<writelen;i++) printf(" ");
+      printf("\r");
+      writelen = 0;
+      wst = 0;
+    }
+    printf("pass1_commit:");
+    for (i=0;i<num;i++) {
+      myprintf(" %s",winfo->woutput[seq[i]]);
+    }
+    printf("\n");
+    if (verbose_flag) {
+      printf("pass1_commit_frame: %d\n", r->result.num_frame);
+    }
+  }
+
+  fflush(stdout);		/* flush */
+}
+
+
+/**
  * <JA>
  * 第1パス：終了時に第1パスの結果を出力する（第1パス終了後、第2パスが
  * 始まる前に呼ばれる. 認識に失敗した場合は呼ばれない）. 
@@ -1314,10 +1363,11 @@ setup_output_tty(Recog *recog, void *data)
       have_progout = TRUE;
     }
   }
-  if (!recog->jconf->decodeopt.realtime_flag && verbose_flag && ! have_progout) {
+  if (!recog->jconf->decodeopt.realtime_flag && verbose_flag && ! have_progout && parallel_num <= 1) {
     callback_add(recog, CALLBACK_EVENT_PASS1_FRAME, frame_indicator, data);
   }
   callback_add(recog, CALLBACK_RESULT_PASS1_INTERIM, result_pass1_current, data);
+  callback_add(recog, CALLBACK_RESULT_PASS1_DETERMINED, result_pass1_determined, data);
   callback_add(recog, CALLBACK_RESULT_PASS1, result_pass1, data);
 #ifdef WORD_GRAPH
   callback_add(recog, CALLBACK_RESULT_PASS1_GRAPH, result_pass1_graph, data);
@@ -24,6 +24,9 @@
  */
 
 #include "app.h"
+#ifdef HAVE_PTHREAD
+#include <stdarg.h>
+#endif
 
 extern boolean outfile_enabled;
 
@@ -185,3 +188,508 @@ main_recognition_stream_loop(Recog *recog)
   }
 
 }
+
+#ifdef HAVE_PTHREAD
+
+/**********************************/
+/** Parallel batch decoding loop **/
+/**********************************/
+
+/* per-thread decoder */
+typedef struct {
+  int id;			/* thread id */
+  Recog *recog;			/* engine instance of this thread */
+  pthread_t thread;		/* thread handle */
+  int capfd;			/* file to capture stdout output of an input */
+  char *name;			/* current input file name */
+  SP16 *speech;			/* whole samples of current input */
+  int len;			/* length of speech */
+  int pos;			/* read point of speech */
+  int alloc;			/* allocated length of speech */
+  int processed;		/* number of processed inputs */
+  double busy;			/* elapsed time in sec. for decoding */
+} BatchWorker;
+
+/* batch status shared among threads */
+typedef struct {
+  Recog *master;		/* owner of models, also runs as thread 0 */
+  BatchWorker *w;		/* decoder threads */
+  int wnum;			/* number of decoder threads */
+  char **name;			/* input file list */
+  char **out;			/* captured output of each input */
+  boolean *done;		/* TRUE when output of the input is ready */
+  double *sec;			/* input length in sec. */
+  int num;			/* number of inputs */
+  int next;			/* next input to be processed */
+  int flushed;			/* inputs already written to stdout */
+  int stdout_fd;		/* saved stdout */
+  pthread_mutex_t mutex;	/* lock for next */
+  pthread_mutex_t outmutex;	/* lock for stdout */
+  pthread_mutex_t readmutex;	/* lock for non-reentrant file readers */
+  /* input reader of the master instance */
+  boolean (*rd_begin)(char *);
+  boolean (*rd_end)();
+  int (*rd_read)(SP16 *, int);
+} BatchData;
+
+static BatchData batch;
+static pthread_key_t batch_key;
+
+/* A/D-in functions to read the pre-loaded samples of current thread */
+static boolean
+batch_adin_standby(int freq, void *arg)
+{
+  return TRUE;
+}
+
+static boolean
+batch_adin_begin(char *filename)
+{
+  BatchWorker *w = (BatchWorker *)pthread_getspecific(batch_key);
+  w->pos = 0;
+  return TRUE;
+}
+
+static boolean
+batch_adin_end()
+{
+  return TRUE;
+}
+
+static int
+batch_adin_read(SP16 *buf, int sampnum)
+{
+  BatchWorker *w = (BatchWorker *)pthread_getspecific(batch_key);
+  int cnt;
+
+  if (w->pos >= w->len) return -1; /* EOF */
+  cnt = w->len - w->pos;
+  if (cnt > sampnum) cnt = sampnum;
+  memcpy(buf, &(w->speech[w->pos]), sizeof(SP16) * cnt);
+  w->pos += cnt;
+  return cnt;
+}
+
+static char *
+batch_adin_input_name()
+{
+  BatchWorker *w = (BatchWorker *)pthread_getspecific(batch_key);
+  return(w->name);
+}
+
+/* redirect stdout to the capture file of current thread while output callbacks */
+static void
+batch_output_begin(Recog *recog, void *data)
+{
+  BatchWorker *w = (BatchWorker *)data;
+  pthread_mutex_lock(&(batch.outmutex));
+  fflush(stdout);
+  dup2(w->capfd, 1);
+}
+
+static void
+batch_output_end(Recog *recog, void *data)
+{
+  fflush(stdout);
+  dup2(batch.stdout_fd, 1);
+  pthread_mutex_unlock(&(batch.outmutex));
+}
+
+/* write a string to the capture file */
+static void
+batch_capture(BatchWorker *w, char *fmt, ...)
+{
+  va_list ap;
+  char buf[MAXPATHLEN + 64];
+  int len;
+
+  va_start(ap, fmt);
+  len = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (len >= (int)sizeof(buf)) len = sizeof(buf) - 1;
+  if (len > 0 && write(w->capfd, buf, len) < 0) {
+    fprintf(stderr, "Warning: failed to write output of %s\n", w->name);
+  }
+}
+
+/* read whole samples of a file using the input functions of the master */
+static boolean
+batch_load_speech(BatchWorker *w)
+{
+  int ret;
+
+  pthread_mutex_lock(&(batch.readmutex));
+  if ((*(batch.rd_begin))(w->name) == FALSE) {
+    pthread_mutex_unlock(&(batch.readmutex));
+    return FALSE;
+  }
+  w->len = 0;
+  for(;;) {
+    if (w->alloc - w->len < MAXSPEECHLEN / 8) {
+      w->alloc += MAXSPEECHLEN;
+      w->speech = (SP16 *)myrealloc(w->speech, sizeof(SP16) * w->alloc);
+    }
+    ret = (*(batch.rd_read))(&(w->speech[w->len]), w->alloc - w->len);
+    if (ret == -1) {		/* EOF */
+      (*(batch.rd_end))();
+      break;
+    }
+    if (ret < 0) {		/* error, already closed */
+      pthread_mutex_unlock(&(batch.readmutex));
+      return FALSE;
+    }
+    w->len += ret;
+  }
+  pthread_mutex_unlock(&(batch.readmutex));
+  w->pos = 0;
+
+  return TRUE;
+}
+
+/* move the captured output to the input and flush those ready in order */
+static void
+batch_output_collect(BatchWorker *w, int k)
+{
+  off_t len;
+  char *buf;
+
+  len = lseek(w->capfd, 0, SEEK_CUR);
+  buf = (char *)mymalloc(len + 1);
+  if (len > 0 && pread(w->capfd, buf, len, 0) != len) {
+    fprintf(stderr, "Warning: failed to read output of %s\n", batch.name[k]);
+    len = 0;
+  }
+  buf[len] = '\0';
+  if (ftruncate(w->capfd, 0) != 0 || lseek(w->capfd, 0, SEEK_SET) != 0) {
+    fprintf(stderr, "Warning: failed to reset output capture\n");
+  }
+
+  pthread_mutex_lock(&(batch.outmutex));
+  batch.out[k] = buf;
+  batch.done[k] = TRUE;
+  while (batch.flushed < batch.num && batch.done[batch.flushed]) {
+    fputs(batch.out[batch.flushed], stdout);
+    free(batch.out[batch.flushed]);
+    batch.out[batch.flushed] = NULL;
+    batch.flushed++;
+  }
+  fflush(stdout);
+  pthread_mutex_unlock(&(batch.outmutex));
+}
+
+static double
+batch_elapsed(struct timeval *from)
+{
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return((now.tv_sec - from->tv_sec) + (now.tv_usec - from->tv_usec) / 1000000.0);
+}
+
+/* decoding thread */
+static void *
+batch_worker_main(void *arg)
+{
+  BatchWorker *w = (BatchWorker *)arg;
+  Recog *recog = w->recog;
+  Jconf *jconf = recog->jconf;
+  PROCESS_AM *am;
+  HTK_Param *param;
+  struct timeval tstart;
+  int k, ret;
+
+  pthread_setspecific(batch_key, w);
+
+  for(;;) {
+    pthread_mutex_lock(&(batch.mutex));
+    k = batch.next++;
+    pthread_mutex_unlock(&(batch.mutex));
+    if (k >= batch.num) break;
+
+    gettimeofday(&tstart, NULL);
+    w->name = batch.name[k];
+    batch_capture(w, "\n");
+    if (verbose_flag) batch_capture(w, "------\n");
+
+    if (jconf->input.speech_input == SP_MFCFILE || jconf->input.speech_input == SP_OUTPROBFILE) {
+      if (verbose_flag) batch_capture(w, "\ninput MFCC file: %s\n", w->name);
+      /* file reader of parameter file is not reentrant */
+      pthread_mutex_lock(&(batch.readmutex));
+      ret = j_open_stream(recog, w->name);
+      if (ret == 0) {
+	param = recog->mfcclist->param;
+	batch.sec[k] = (double)param->samplenum * param->header.wshift / 10000000.0;
+      }
+      pthread_mutex_unlock(&(batch.readmutex));
+      if (ret == 0) {
+	do {
+	  ret = j_recognize_stream(recog);
+	} while (ret == 1);
+      }
+    } else {
+      if (batch_load_speech(w) == FALSE) {
+	ret = -1;
+      } else {
+	if (recog->adin->rs) {
+	  batch.sec[k] = (double)w->len / (double)recog->adin->rs->infreq;
+	} else {
+	  batch.sec[k] = (double)w->len / (recog->adin->down_sample ? 48000.0 : (double)jconf->input.sfreq);
+	}
+	ret = j_open_stream(recog, NULL);
+	if (ret == 0) ret = j_recognize_stream(recog);
+      }
+    }
+    if (ret == -1) {
+      jlog("ERROR: failed to process %s\n", w->name);
+    }
+
+    batch_output_collect(w, k);
+    w->processed++;
+    w->busy += batch_elapsed(&tstart);
+  }
+
+  /* let other threads go on without waiting for this one at DNN batch */
+  for(am=recog->amlist;am;am=am->next) {
+    if (am->dnn_batch) j_dnn_batch_detach(am);
+  }
+
+  return NULL;
+}
+
+/* read input file list */
+static boolean
+batch_read_list(char *filename)
+{
+  FILE *fp;
+  char buf[MAXPATHLEN];
+  int alloc;
+
+  if ((fp = fopen(filename, "r")) == NULL) {
+    fprintf(stderr, "Error: cannot open inputlist \"%s\"\n", filename);
+    return FALSE;
+  }
+  alloc = 0;
+  batch.num = 0;
+  batch.name = NULL;
+  while (getl_fp(buf, MAXPATHLEN, fp) != NULL) {
+    if (buf[0] == '\0' || buf[0] == '#') continue;
+    if (batch.num >= alloc) {
+      alloc += 256;
+      batch.name = (char **)myrealloc(batch.name, sizeof(char *) * alloc);
+    }
+    batch.name[batch.num++] = strcpy((char *)mymalloc(strlen(buf) + 1), buf);
+  }
+  fclose(fp);
+
+  return TRUE;
+}
+
+/* create a decoder instance sharing models with the master */
+static boolean
+batch_worker_setup(BatchWorker *w, int id)
+{
+  Recog *recog;
+  int code;
+  char tmpl[] = "/tmp/julius-batch-XXXXXX";
+
+  w->id = id;
+  if (id == 0) {
+    w->recog = recog = batch.master;
+  } else {
+    w->recog = recog = j_recog_new();
+    if (j_load_all_shared(recog, batch.master) == FALSE) return FALSE;
+    if (j_final_fusion(recog) == FALSE) return FALSE;
+  }
+
+  /* capture file for the output of an input */
+  if ((w->capfd = mkstemp(tmpl)) < 0) {
+    fprintf(stderr, "Error: failed to create temporary file for output\n");
+    return FALSE;
+  }
+  unlink(tmpl);
+
+  /* output callbacks, enclosed by capture begin / end */
+  for(code=CALLBACK_EVENT_PROCESS_ONLINE;code<=CALLBACK_RESULT_CONFNET;code++) {
+    if (code == CALLBACK_EVENT_PASS1_FRAME) continue;
+    callback_add(recog, code, batch_output_begin, w);
+  }
+  setup_output_tty(recog, NULL);
+  for(code=CALLBACK_EVENT_PROCESS_ONLINE;code<=CALLBACK_RESULT_CONFNET;code++) {
+    if (code == CALLBACK_EVENT_PASS1_FRAME) continue;
+    callback_add(recog, code, batch_output_end, w);
+  }
+
+  /* waveform input reads the pre-loaded samples */
+  if (recog->jconf->input.type == INPUT_WAVEFORM) {
+    recog->adin->ad_standby = batch_adin_standby;
+    recog->adin->ad_begin = batch_adin_begin;
+    recog->adin->ad_end = batch_adin_end;
+    recog->adin->ad_read = batch_adin_read;
+    recog->adin->ad_resume = NULL;
+    recog->adin->ad_pause = NULL;
+    recog->adin->ad_terminate = NULL;
+    recog->adin->ad_input_name = batch_adin_input_name;
+    if (id != 0) {
+      /* the master has been already set up by j_adin_init() */
+      recog->adin->silence_cut_default = batch.master->adin->silence_cut_default;
+      recog->adin->enable_thread = FALSE;
+      if (j_adin_init_user(recog, NULL) == FALSE) return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/** 
+ * <JA>
+ * 入力ファイルリストを複数スレッドで並列に認識する. 各スレッドは
+ * @a recog のモデルを共有するエンジンインスタンスを持ち, 入力ごとの
+ * 出力は入力順に標準出力へ書き出される. 
+ * 
+ * @param recog [i/o] 全モデルを読み込み済みのエンジンインスタンス
+ * @param num [in] スレッド数
+ * </JA>
+ * <EN>
+ * Recognize the input file list by multiple threads in parallel.
+ * Each thread has its own engine instance sharing the models of
+ * @a recog, and the output of each input is written to stdout in
+ * the order of the input list.
+ * 
+ * @param recog [i/o] engine instance with all models loaded
+ * @param num [in] number of threads
+ * </EN>
+ */
+void
+main_recognition_batch_loop(Recog *recog, int num)
+{
+  Jconf *jconf;
+  PROCESS_AM *am;
+  DNNBatch *dnnbatch;
+  struct timeval tstart;
+  double wall, speech, busy;
+  int i, files;
+
+  jconf = recog->jconf;
+  dnnbatch = NULL;
+
+  memset(&batch, 0, sizeof(BatchData));
+  batch.master = recog;
+  if (batch_read_list(jconf->input.inputlist_filename) == FALSE) return;
+  if (num > batch.num) num = batch.num;
+  if (num < 1) {
+    fprintf(stderr, "0 files processed\n");
+    return;
+  }
+  batch.out = (char **)mymalloc(sizeof(char *) * batch.num);
+  batch.done = (boolean *)mymalloc(sizeof(boolean) * batch.num);
+  batch.sec = (double *)mymalloc(sizeof(double) * batch.num);
+  for(i=0;i<batch.num;i++) {
+    batch.out[i] = NULL;
+    batch.done[i] = FALSE;
+    batch.sec[i] = 0.0;
+  }
+  pthread_mutex_init(&(batch.mutex), NULL);
+  pthread_mutex_init(&(batch.outmutex), NULL);
+  pthread_mutex_init(&(batch.readmutex), NULL);
+  pthread_key_create(&batch_key, NULL);
+  fflush(stdout);
+  batch.stdout_fd = dup(1);
+
+  /* keep the file reader of the master to load samples */
+  if (jconf->input.type == INPUT_WAVEFORM) {
+    batch.rd_begin = recog->adin->ad_begin;
+    batch.rd_end = recog->adin->ad_end;
+    batch.rd_read = recog->adin->ad_read;
+  }
+
+  /* set up decoder instances */
+  batch.w = (BatchWorker *)mymalloc(sizeof(BatchWorker) * num);
+  memset(batch.w, 0, sizeof(BatchWorker) * num);
+  batch.wnum = 0;
+  for(i=0;i<num;i++) {
+    batch.w[i].capfd = -1;
+    batch.wnum++;
+    if (batch_worker_setup(&(batch.w[i]), i) == FALSE) {
+      fprintf(stderr, "ERROR: failed to set up decoder for thread %d\n", i);
+      goto end_batch;
+    }
+  }
+  jlog("STAT: batch decoding of %d files by %d threads\n", batch.num, num);
+
+  /* DNN computation is shared among threads in batch */
+  for(am=recog->amlist;am;am=am->next) {
+    if (am->dnn) break;
+  }
+  if (am) {
+    if ((dnnbatch = j_dnn_batch_new(recog, num, 2)) == NULL) goto end_batch;
+    for(i=1;i<num;i++) {
+      if (j_dnn_batch_attach(dnnbatch, batch.w[i].recog) == FALSE) goto end_batch;
+    }
+  }
+
+  /* run */
+  gettimeofday(&tstart, NULL);
+  for(i=1;i<num;i++) {
+    if (pthread_create(&(batch.w[i].thread), NULL, batch_worker_main, &(batch.w[i])) != 0) {
+      fprintf(stderr, "ERROR: failed to create thread %d\n", i);
+      num = i;
+      break;
+    }
+  }
+  batch_worker_main(&(batch.w[0]));
+  for(i=1;i<num;i++) {
+    pthread_join(batch.w[i].thread, NULL);
+  }
+  wall = batch_elapsed(&tstart);
+  /* as the sequential loop does at the end of input */
+  printf("\n");
+  if (verbose_flag) printf("------\n");
+  fflush(stdout);
+
+  /* statistics */
+  files = 0;
+  busy = 0.0;
+  for(i=0;i<num;i++) {
+    files += batch.w[i].processed;
+    busy += batch.w[i].busy;
+  }
+  speech = 0.0;
+  for(i=0;i<batch.num;i++) speech += batch.sec[i];
+  fprintf(stderr, "%d files processed\n", files);
+  fprintf(stderr, "batch: %d threads, %.2f sec input in %.2f sec\n", num, speech, wall);
+  if (speech > 0.0) {
+    fprintf(stderr, "batch: RTF = %.4f (%.4f per thread), throughput = %.2f files/sec, %.2f input sec/sec\n", wall / speech, busy / speech, files / wall, speech / wall);
+  }
+#ifdef REPORT_MEMORY_USAGE
+  print_mem();
+#endif
+
+ end_batch:
+  /* release, leaving the master to the caller */
+  for(i=0;i<batch.wnum;i++) {
+    if (batch.w[i].capfd >= 0) close(batch.w[i].capfd);
+    if (batch.w[i].speech) free(batch.w[i].speech);
+    if (i != 0 && batch.w[i].recog) j_recog_free(batch.w[i].recog);
+  }
+  free(batch.w);
+  if (dnnbatch) {
+    for(am=recog->amlist;am;am=am->next) {
+      if (am->dnn_batch) j_dnn_batch_detach(am);
+    }
+    j_dnn_batch_free(dnnbatch);
+  }
+  close(batch.stdout_fd);
+  pthread_key_delete(batch_key);
+  pthread_mutex_destroy(&(batch.mutex));
+  pthread_mutex_destroy(&(batch.outmutex));
+  pthread_mutex_destroy(&(batch.readmutex));
+  for(i=0;i<batch.num;i++) {
+    free(batch.name[i]);
+    if (batch.out[i]) free(batch.out[i]);
+  }
+  free(batch.name);
+  free(batch.out);
+  free(batch.done);
+  free(batch.sec);
+}
+
+#endif /* HAVE_PTHREAD */
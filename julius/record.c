@@ -277,3 +277,9 @@ record_setup(Recog *recog, void *data)
     printf("Input speech data will be stored to = %s/\n", record_dirname);
   }
 }
+
+boolean
+is_record_enabled()
+{
+  return(record_dirname != NULL ? TRUE : FALSE);
+}
@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 1991-2016 Kawahara Lab., Kyoto University
+ * Copyright (c) 2000-2005 Shikano Lab., Nara Institute of Science and Technology
+ * Copyright (c) 2005-2016 Julius project team, Nagoya Institute of Technology
+ * All rights reserved
+ */
+
+/* lattice-rescore --- rescore Julius word graphs with another N-gram */
+
+#include "lattice-rescore.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif /* _OPENMP */
+
+#define DEFAULT_LM_WEIGHT 8.0
+#define DEFAULT_LM_PENALTY -2.0
+#define DEFAULT_CM_ALPHA 0.05
+#define DEFAULT_MAXSTATES 1000000
+#define BATCH_PER_THREAD 16	///< Number of lattices per thread in a batch
+static char *bos_default = "<s>";
+
+static RescoreConfig conf;
+static boolean verbose = FALSE;
+
+void
+usage(char *s)
+{
+  fprintf(stderr, "%s: rescore word graphs of Julius with N-gram\n", s);
+  fprintf(stderr, "usage: %s [options] {-d bingram | -nlr arpa} file...\n", s);
+  fprintf(stderr, "  file: output of julius with \"-lattice\" (stdout or \"-outfile\")\n");
+  fprintf(stderr, "options:\n");
+  fprintf(stderr, "   -d file            binary N-gram to rescore with\n");
+  fprintf(stderr, "   -nlr file          forward ARPA N-gram to rescore with\n");
+  fprintf(stderr, "   -N N               use N-gram (available max)\n");
+  fprintf(stderr, "   -lmp weight pen    LM weight and word insertion penalty (%.1f %.1f)\n", DEFAULT_LM_WEIGHT, DEFAULT_LM_PENALTY);
+  fprintf(stderr, "   -cmalpha value     scaling factor for posterior (%.2f)\n", DEFAULT_CM_ALPHA);
+  fprintf(stderr, "   -n num             number of N-best sentences to output (1)\n");
+  fprintf(stderr, "   -confnet           output confusion network\n");
+  fprintf(stderr, "   -bos string        beginning of sentence word (%s)\n", bos_default);
+  fprintf(stderr, "   -maxstates num     max. expanded states per lattice (%d)\n", DEFAULT_MAXSTATES);
+  fprintf(stderr, "   -threads num       number of threads (1)\n");
+  fprintf(stderr, "   -filelist file     read input file names from file\n");
+  fprintf(stderr, "   -v                 verbose output\n");
+  fprintf(stderr, "\nLibrary configuration: ");
+  confout_version(stderr);
+  confout_lm(stderr);
+  fprintf(stderr, "\n");
+  exit(1);
+}
+
+/* output rescoring result of a lattice */
+static void
+put_result(Lattice *lat, RescoreResult *res, boolean ok)
+{
+  int i, j;
+  RescoreSent *s;
+  RescoreCluster *c;
+
+  printf("lattice: %s\n", lat->name);
+  if (ok && res->n < conf.n) {
+    fprintf(stderr, "Warning: %s: too many states, history reduced to %d-gram\n", lat->name, res->n);
+  }
+  if (verbose) {
+    printf("STAT: %d words expanded to %d states by %d-gram\n", lat->num, res->states, res->n);
+  }
+  if (!ok) {
+    printf("<search failed>\n");
+    return;
+  }
+  for(i=0;i<res->sentnum;i++) {
+    s = &(res->sent[i]);
+    printf("sentence%d:", i+1);
+    for(j=0;j<s->len;j++) printf(" %s", lat->w[s->word[j]].name);
+    printf("\n");
+    printf("wseq%d:", i+1);
+    for(j=0;j<s->len;j++) printf(" %s", lat->w[s->word[j]].lname);
+    printf("\n");
+    printf("score%d: %f (AM: %f  LM: %f)\n", i+1, s->score, s->score - s->lmscore, s->lmscore);
+  }
+  if (conf.confnet) {
+    printf("---- begin confusion network ---\n");
+    for(i=0;i<res->clusternum;i++) {
+      c = &(res->cluster[i]);
+      for(j=0;j<c->num;j++) {
+	printf("(%s:%.3f)", (c->word[j] == -1) ? "-" : lat->w[c->word[j]].name, c->pp[j]);
+	if (j == 0) printf("  ");
+      }
+      printf("\n");
+    }
+    printf("---- end confusion network ---\n");
+  }
+}
+
+/* rescore lattices in parallel and output the results in order */
+static void
+process_batch(Lattice *lat, int num)
+{
+  RescoreResult *res;
+  boolean *ok;
+  int i;
+
+  res = (RescoreResult *)mymalloc(sizeof(RescoreResult) * num);
+  ok = (boolean *)mymalloc(sizeof(boolean) * num);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif /* _OPENMP */
+  for(i=0;i<num;i++) {
+    if (lattice_map_ngram(&(lat[i]), conf.ngram)) {
+      ok[i] = rescore_lattice(&(lat[i]), &conf, &(res[i]));
+    } else {
+      ok[i] = FALSE;
+      res[i].n = res[i].states = 0;
+      res[i].sent = NULL;
+      res[i].sentnum = 0;
+      res[i].cluster = NULL;
+      res[i].clusternum = 0;
+    }
+  }
+  for(i=0;i<num;i++) {
+    put_result(&(lat[i]), &(res[i]), ok[i]);
+    rescore_result_free(&(res[i]));
+    lattice_free(&(lat[i]));
+  }
+  free(ok);
+  free(res);
+}
+
+int
+main(int argc, char *argv[])
+{
+  char *binfile = NULL, *arpafile = NULL, *listfile = NULL;
+  char *bos_str = NULL;
+  char **files;
+  int filenum;
+  int i, n, nthread, batch, num, total;
+  Lattice *lat;
+  LatReader rd;
+  FILE *fp;
+  static char buf[MAXPATHLEN];
+
+  conf.lm_weight = DEFAULT_LM_WEIGHT;
+  conf.lm_penalty = DEFAULT_LM_PENALTY;
+  conf.cm_alpha = DEFAULT_CM_ALPHA;
+  conf.nbest = 1;
+  conf.confnet = FALSE;
+  conf.maxstates = DEFAULT_MAXSTATES;
+  n = 0;
+  nthread = 1;
+
+  /* option parsing */
+  files = (char **)mymalloc(sizeof(char *) * argc);
+  filenum = 0;
+  for(i=1;i<argc;i++) {
+    if (argv[i][0] == '-') {
+      if (strmatch(argv[i], "-d")) {
+	if (++i >= argc) usage(argv[0]);
+	binfile = argv[i];
+      } else if (strmatch(argv[i], "-nlr")) {
+	if (++i >= argc) usage(argv[0]);
+	arpafile = argv[i];
+      } else if (strmatch(argv[i], "-N")) {
+	if (++i >= argc) usage(argv[0]);
+	n = atoi(argv[i]);
+      } else if (strmatch(argv[i], "-lmp")) {
+	if (i + 2 >= argc) usage(argv[0]);
+	conf.lm_weight = atof(argv[++i]);
+	conf.lm_penalty = atof(argv[++i]);
+      } else if (strmatch(argv[i], "-cmalpha")) {
+	if (++i >= argc) usage(argv[0]);
+	conf.cm_alpha = atof(argv[i]);
+      } else if (strmatch(argv[i], "-n")) {
+	if (++i >= argc) usage(argv[0]);
+	conf.nbest = atoi(argv[i]);
+      } else if (strmatch(argv[i], "-confnet")) {
+	conf.confnet = TRUE;
+      } else if (strmatch(argv[i], "-bos")) {
+	if (++i >= argc) usage(argv[0]);
+	bos_str = argv[i];
+      } else if (strmatch(argv[i], "-maxstates")) {
+	if (++i >= argc) usage(argv[0]);
+	conf.maxstates = atoi(argv[i]);
+      } else if (strmatch(argv[i], "-threads")) {
+	if (++i >= argc) usage(argv[0]);
+	nthread = atoi(argv[i]);
+      } else if (strmatch(argv[i], "-filelist")) {
+	if (++i >= argc) usage(argv[0]);
+	listfile = argv[i];
+      } else if (strmatch(argv[i], "-v")) {
+	verbose = TRUE;
+      } else {
+	usage(argv[0]);
+      }
+    } else {
+      files[filenum++] = argv[i];
+    }
+  }
+  if ((binfile == NULL && arpafile == NULL) || (binfile != NULL && arpafile != NULL)) {
+    usage(argv[0]);
+  }
+  if (filenum == 0 && listfile == NULL) usage(argv[0]);
+  if (conf.nbest < 1) conf.nbest = 1;
+  if (nthread < 1) nthread = 1;
+  if (bos_str == NULL) bos_str = bos_default;
+
+  /* read in N-gram */
+  conf.ngram = ngram_info_new();
+  if (binfile) {
+    if (init_ngram_bin(conf.ngram, binfile) == FALSE) return -1;
+  } else {
+    if (init_ngram_arpa(conf.ngram, arpafile, DIR_LR) == FALSE) return -1;
+  }
+  if (verbose) print_ngram_info(stdout, conf.ngram);
+  if (conf.ngram->dir == DIR_RL) {
+    fprintf(stderr, "Error: backward N-gram cannot be used, forward N-gram required\n");
+    return -1;
+  }
+  if (n == 0) {
+    n = conf.ngram->n;
+  } else if (conf.ngram->n < n) {
+    fprintf(stderr, "Error: you requested %d-gram but this is %d-gram\n", n, conf.ngram->n);
+    return -1;
+  }
+  if (n > RESCORE_MAXN) {
+    fprintf(stderr, "Warning: history longer than %d words is not supported, use %d-gram\n", RESCORE_MAXN - 1, RESCORE_MAXN);
+    n = RESCORE_MAXN;
+  }
+  conf.n = n;
+  if ((conf.bos = ngram_lookup_word(conf.ngram, bos_str)) == WORD_INVALID) {
+    fprintf(stderr, "Error: word \"%s\" not found as beginning-of-sentence\n", bos_str);
+    return -1;
+  }
+
+#ifdef _OPENMP
+  omp_set_num_threads(nthread);
+#else
+  if (nthread > 1) {
+    fprintf(stderr, "Warning: not compiled with OpenMP, run with single thread\n");
+    nthread = 1;
+  }
+#endif /* _OPENMP */
+  if (verbose) {
+    printf("STAT: rescore by %d-gram, lm weight = %.1f, penalty = %.1f, %d threads\n", conf.n, conf.lm_weight, conf.lm_penalty, nthread);
+  }
+
+  /* read lattices and rescore them in batches */
+  batch = nthread * BATCH_PER_THREAD;
+  lat = (Lattice *)mymalloc(sizeof(Lattice) * batch);
+  num = total = 0;
+  fp = NULL;
+  if (listfile) {
+    if ((fp = fopen(listfile, "r")) == NULL) {
+      fprintf(stderr, "Error: failed to open \"%s\"\n", listfile);
+      return -1;
+    }
+  }
+  i = 0;
+  for(;;) {
+    /* next input file */
+    if (i < filenum) {
+      if (lattice_reader_open(&rd, files[i++]) == FALSE) continue;
+    } else if (fp != NULL && getl_fp(buf, MAXPATHLEN, fp) != NULL) {
+      if (lattice_reader_open(&rd, buf) == FALSE) continue;
+    } else {
+      break;
+    }
+    while (lattice_read(&rd, &(lat[num]))) {
+      num++;
+      if (num >= batch) {
+	process_batch(lat, num);
+	total += num;
+	num = 0;
+      }
+    }
+    lattice_reader_close(&rd);
+  }
+  if (num > 0) {
+    process_batch(lat, num);
+    total += num;
+  }
+  if (fp) fclose(fp);
+  if (verbose) printf("STAT: %d lattices rescored\n", total);
+
+  free(lat);
+  free(files);
+  ngram_info_free(conf.ngram);
+
+  return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 1991-2016 Kawahara Lab., Kyoto University
+ * Copyright (c) 2000-2005 Shikano Lab., Nara Institute of Science and Technology
+ * Copyright (c) 2005-2016 Julius project team, Nagoya Institute of Technology
+ * All rights reserved
+ */
+
+/* lattice-rescore --- rescore Julius word graphs with another N-gram */
+
+#include <sent/stddefs.h>
+#include <sent/ngram2.h>
+
+/// Maximum N of N-gram to be used for history expansion
+#define RESCORE_MAXN 10
+
+/// A word on the lattice, as read from the word graph output
+typedef struct {
+  int id;			///< Graph word ID in the word graph output
+  int lefttime;			///< Beginning frame
+  int righttime;		///< End frame
+  int *left;			///< Indexes of left context words
+  int leftnum;			///< Number of left context words
+  int *right;			///< Indexes of right context words
+  int rightnum;			///< Number of right context words
+  int wid;			///< Word ID in the dictionary of the recognizer
+  char *name;			///< Output string
+  char *lname;			///< N-gram entry name
+  LOGPROB am;			///< Acoustic score of the whole word
+  WORD_ID nid;			///< Word ID in the rescoring N-gram
+  LOGPROB post;			///< Posterior probability after rescoring
+} LatWord;
+
+/// A lattice
+typedef struct {
+  char *name;			///< Name of the lattice (input file name)
+  LatWord *w;			///< Words
+  int num;			///< Number of words
+  int framelen;			///< Length of the input in frames
+} Lattice;
+
+/// Reader of word graphs in recognition output files
+typedef struct {
+  FILE *fp;			///< File pointer opened by fopen_readfile()
+  char *filename;		///< File name
+  char *buf;			///< Line buffer
+  int buflen;			///< Allocated length of @a buf
+  char *input;			///< Input file name of the next lattice, if found
+  int count;			///< Number of lattices read so far
+} LatReader;
+
+/// Rescoring parameters, shared by all the lattices
+typedef struct {
+  NGRAM_INFO *ngram;		///< N-gram to rescore with
+  int n;			///< N of N-gram to be used
+  WORD_ID bos;			///< Beginning-of-sentence word in the N-gram
+  LOGPROB lm_weight;		///< LM weight
+  LOGPROB lm_penalty;		///< Word insertion penalty
+  LOGPROB cm_alpha;		///< Scaling factor for posterior computation
+  int nbest;			///< Number of sentences to output
+  boolean confnet;		///< TRUE if output confusion network
+  int maxstates;		///< Maximum number of expanded states per lattice
+} RescoreConfig;
+
+/// A sentence found by rescoring
+typedef struct {
+  int *word;			///< Lattice word indexes from left to right
+  int len;			///< Length of @a word
+  LOGPROB score;		///< Total score
+  LOGPROB lmscore;		///< LM score part of @a score
+} RescoreSent;
+
+/// A cluster of confusion network
+typedef struct {
+  int *word;			///< Representative lattice word index for each entry, -1 for skip
+  LOGPROB *pp;			///< Posterior probability of each entry
+  int num;			///< Number of entries
+} RescoreCluster;
+
+/// Rescoring result of a lattice
+typedef struct {
+  int n;			///< N actually used for the expansion
+  int states;			///< Number of expanded states
+  RescoreSent *sent;		///< N-best sentences
+  int sentnum;			///< Number of N-best sentences
+  RescoreCluster *cluster;	///< Confusion network
+  int clusternum;		///< Number of clusters
+} RescoreResult;
+
+/* lattice.c */
+boolean lattice_reader_open(LatReader *rd, char *filename);
+void lattice_reader_close(LatReader *rd);
+boolean lattice_read(LatReader *rd, Lattice *lat);
+boolean lattice_map_ngram(Lattice *lat, NGRAM_INFO *ngram);
+void lattice_free(Lattice *lat);
+
+/* rescore.c */
+boolean rescore_lattice(Lattice *lat, RescoreConfig *conf, RescoreResult *res);
+void rescore_result_free(RescoreResult *res);
@@ -0,0 +1,336 @@
+/*
+ * Copyright (c) 1991-2016 Kawahara Lab., Kyoto University
+ * Copyright (c) 2000-2005 Shikano Lab., Nara Institute of Science and Technology
+ * Copyright (c) 2005-2016 Julius project team, Nagoya Institute of Technology
+ * All rights reserved
+ */
+
+/* lattice.c --- read word graphs from recognition output of Julius */
+
+/*
+ * Word graphs are read from the text output of Julius with "-lattice",
+ * either the standard output or the files saved by "-outfile".  Each
+ * block between "--- begin wordgraph data ---" and "--- end wordgraph
+ * data ---" is one lattice, as written by wordgraph_dump().  The word
+ * graphs of the 1st pass are skipped.
+ */
+
+#include "lattice-rescore.h"
+
+#define LAT_BEGIN "--- begin wordgraph data ---"
+#define LAT_END "--- end wordgraph data ---"
+#define LAT_PASS1_BEGIN "--- begin wordgraph data pass1 ---"
+#define LAT_PASS1_END "--- end wordgraph data pass1 ---"
+
+/* read one line of any length into the reader buffer */
+static char *
+read_line(LatReader *rd)
+{
+  int c, len;
+
+  len = 0;
+  while ((c = myfgetc(rd->fp)) != EOF) {
+    if (c == '\n') break;
+    if (len + 1 >= rd->buflen) {
+      rd->buflen *= 2;
+      rd->buf = (char *)myrealloc(rd->buf, rd->buflen);
+    }
+    rd->buf[len++] = c;
+  }
+  if (c == EOF && len == 0) return NULL;
+  if (len > 0 && rd->buf[len-1] == '\r') len--;
+  rd->buf[len] = '\0';
+  return rd->buf;
+}
+
+/* parse comma-separated list of graph word IDs */
+static int
+parse_idlist(char *p, int **list)
+{
+  int num;
+  char *q;
+
+  num = 1;
+  for(q = p; *q != '\0' && *q != ' '; q++) if (*q == ',') num++;
+  *list = (int *)mymalloc(sizeof(int) * num);
+  num = 0;
+  for(;;) {
+    (*list)[num++] = strtol(p, &q, 10);
+    if (*q != ',') break;
+    p = q + 1;
+  }
+  return num;
+}
+
+/* extract a quoted value "key=\"...\"", the closing quote is found
+   by the following key */
+static char *
+parse_quoted(char *line, char *key, char *nextkey)
+{
+  char *p, *q;
+  char *s;
+
+  if ((p = strstr(line, key)) == NULL) return NULL;
+  p += strlen(key);
+  if ((q = strstr(p, nextkey)) == NULL) return NULL;
+  s = (char *)mymalloc(q - p + 1);
+  strncpy(s, p, q - p);
+  s[q - p] = '\0';
+  return s;
+}
+
+/* parse a word line of wordgraph_dump().  has_am is set to FALSE if
+   the line has no AMscore */
+static boolean
+parse_word(char *line, LatWord *w, boolean *has_am)
+{
+  char *p, *q, *namep;
+  char c;
+
+  w->left = w->right = NULL;
+  w->leftnum = w->rightnum = 0;
+  w->name = w->lname = NULL;
+  w->am = 0.0;
+  w->nid = WORD_INVALID;
+  w->post = 0.0;
+  if (sscanf(line, "%d: [%d..%d]", &(w->id), &(w->lefttime), &(w->righttime)) != 3) return FALSE;
+  if (w->id < 0) return FALSE;
+
+  /* output string may contain anything, so the fields before it are
+     searched in the part before it */
+  if ((namep = strstr(line, " name=\"")) == NULL) return FALSE;
+  c = *namep;
+  *namep = '\0';
+  if ((p = strstr(line, " left=")) != NULL) {
+    w->leftnum = parse_idlist(p + 6, &(w->left));
+  }
+  if ((p = strstr(line, " right=")) != NULL) {
+    w->rightnum = parse_idlist(p + 7, &(w->right));
+  }
+  if ((p = strstr(line, " wid=")) == NULL) {
+    *namep = c;
+    return FALSE;
+  }
+  w->wid = atoi(p + 5);
+  *namep = c;
+
+  w->name = parse_quoted(namep, " name=\"", "\" lname=\"");
+  w->lname = parse_quoted(namep, "\" lname=\"", "\" f=");
+  if (w->name == NULL || w->lname == NULL) return FALSE;
+  /* acoustic score is AMscore, computed by Julius with -graphamscore
+     on the final word segment.  The difference of g_head and g_prev
+     cannot be used: g_head is replaced by the score of the left word
+     when the word boundary is adjusted, so they cancel out along a
+     path.  Without AMscore, AMavg times the word length is used, which
+     is computed on the segment before the adjustment. */
+  if ((p = strstr(namep, "\" f=")) == NULL) return FALSE;
+  if ((q = strstr(p, " AMscore=")) != NULL) {
+    w->am = atof(q + 9);
+    *has_am = TRUE;
+  } else {
+    if ((q = strstr(p, " AMavg=")) != NULL) {
+      w->am = atof(q + 7) * (w->righttime - w->lefttime + 1);
+    }
+    *has_am = FALSE;
+  }
+
+  return TRUE;
+}
+
+/* convert graph word IDs to indexes, dropping unknown ones */
+static int
+convert_idlist(int *list, int num, int *id2idx, int maxid, char *name, int id)
+{
+  int i, n;
+
+  n = 0;
+  for(i=0;i<num;i++) {
+    if (list[i] < 0 || list[i] > maxid || id2idx[list[i]] == -1) {
+      jlog("Warning: lattice_read: %s: word %d has unknown context %d, ignored\n", name, id, list[i]);
+      continue;
+    }
+    list[n++] = id2idx[list[i]];
+  }
+  return n;
+}
+
+/* free a lattice word */
+static void
+free_word(LatWord *w)
+{
+  if (w->left) free(w->left);
+  if (w->right) free(w->right);
+  if (w->name) free(w->name);
+  if (w->lname) free(w->lname);
+}
+
+/**
+ * Open a recognition output file to read lattices.
+ *
+ * @param rd [out] reader
+ * @param filename [in] file name
+ *
+ * @return TRUE on success, FALSE on failure.
+ */
+boolean
+lattice_reader_open(LatReader *rd, char *filename)
+{
+  if ((rd->fp = fopen_readfile(filename)) == NULL) return FALSE;
+  rd->filename = strcpy((char *)mymalloc(strlen(filename) + 1), filename);
+  rd->buflen = 4096;
+  rd->buf = (char *)mymalloc(rd->buflen);
+  rd->input = NULL;
+  rd->count = 0;
+  return TRUE;
+}
+
+/**
+ * Close the reader.
+ *
+ * @param rd [i/o] reader
+ */
+void
+lattice_reader_close(LatReader *rd)
+{
+  fclose_readfile(rd->fp);
+  free(rd->filename);
+  free(rd->buf);
+  if (rd->input) free(rd->input);
+}
+
+/**
+ * Read the next lattice.  The lattice is named by the input file
+ * name found in the output ("input speechfile:" or "input MFCC file:"),
+ * or by the output file name if not found.
+ *
+ * @param rd [i/o] reader
+ * @param lat [out] lattice
+ *
+ * @return TRUE if a lattice was read, FALSE when reached end of file.
+ */
+boolean
+lattice_read(LatReader *rd, Lattice *lat)
+{
+  char *p;
+  boolean pass1;
+  int alloc, i, maxid, noam;
+  boolean has_am;
+  int *id2idx;
+  LatWord *w;
+  char buf[32];
+
+  /* find beginning of a lattice */
+  pass1 = FALSE;
+  for(;;) {
+    if ((p = read_line(rd)) == NULL) return FALSE;
+    if (strmatch(p, LAT_PASS1_BEGIN)) pass1 = TRUE;
+    else if (strmatch(p, LAT_PASS1_END)) pass1 = FALSE;
+    else if (!pass1 && strmatch(p, LAT_BEGIN)) break;
+    else if ((p = strstr(rd->buf, "input speechfile: ")) != NULL) {
+      if (rd->input) free(rd->input);
+      p += 18;
+      rd->input = strcpy((char *)mymalloc(strlen(p) + 1), p);
+    } else if ((p = strstr(rd->buf, "input MFCC file: ")) != NULL) {
+      if (rd->input) free(rd->input);
+      p += 17;
+      rd->input = strcpy((char *)mymalloc(strlen(p) + 1), p);
+    }
+  }
+  rd->count++;
+  if (rd->input) {
+    lat->name = rd->input;
+    rd->input = NULL;
+  } else if (rd->count == 1) {
+    lat->name = strcpy((char *)mymalloc(strlen(rd->filename) + 1), rd->filename);
+  } else {
+    snprintf(buf, 32, ":%d", rd->count);
+    lat->name = (char *)mymalloc(strlen(rd->filename) + strlen(buf) + 1);
+    sprintf(lat->name, "%s%s", rd->filename, buf);
+  }
+
+  /* read words */
+  alloc = 256;
+  lat->w = (LatWord *)mymalloc(sizeof(LatWord) * alloc);
+  lat->num = 0;
+  lat->framelen = 0;
+  maxid = -1;
+  noam = 0;
+  while ((p = read_line(rd)) != NULL) {
+    if (strmatch(p, LAT_END)) break;
+    if (lat->num >= alloc) {
+      alloc *= 2;
+      lat->w = (LatWord *)myrealloc(lat->w, sizeof(LatWord) * alloc);
+    }
+    w = &(lat->w[lat->num]);
+    if (parse_word(p, w, &has_am) == FALSE) {
+      jlog("Warning: lattice_read: %s: failed to parse, ignored: %s\n", lat->name, p);
+      free_word(w);
+      continue;
+    }
+    if (lat->framelen < w->righttime + 1) lat->framelen = w->righttime + 1;
+    if (maxid < w->id) maxid = w->id;
+    if (!has_am) noam++;
+    lat->num++;
+  }
+  if (noam > 0) {
+    jlog("Warning: lattice_read: %s: %d words have no AMscore, AMavg is used instead\n", lat->name, noam);
+    jlog("Warning: lattice_read: run julius with \"-graphamscore\" to get correct acoustic scores\n");
+  }
+
+  /* convert graph word IDs in the context to indexes */
+  id2idx = (int *)mymalloc(sizeof(int) * (maxid + 2));
+  for(i=0;i<=maxid;i++) id2idx[i] = -1;
+  for(i=0;i<lat->num;i++) id2idx[lat->w[i].id] = i;
+  for(i=0;i<lat->num;i++) {
+    w = &(lat->w[i]);
+    w->leftnum = convert_idlist(w->left, w->leftnum, id2idx, maxid, lat->name, w->id);
+    w->rightnum = convert_idlist(w->right, w->rightnum, id2idx, maxid, lat->name, w->id);
+  }
+  free(id2idx);
+
+  return TRUE;
+}
+
+/**
+ * Map the words in a lattice to the N-gram entries.  Words not in the
+ * N-gram are mapped to the unknown word entry if the N-gram has one.
+ *
+ * @param lat [i/o] lattice
+ * @param ngram [in] N-gram
+ *
+ * @return TRUE on success, FALSE if some words could not be mapped.
+ */
+boolean
+lattice_map_ngram(Lattice *lat, NGRAM_INFO *ngram)
+{
+  int i;
+  LatWord *w;
+
+  for(i=0;i<lat->num;i++) {
+    w = &(lat->w[i]);
+    w->nid = ngram_lookup_word(ngram, w->lname);
+    if (w->nid == WORD_INVALID) {
+      if (ngram->isopen == FALSE) {
+	jlog("Error: lattice_map_ngram: %s: \"%s\" not exist in N-gram\n", lat->name, w->lname);
+	return FALSE;
+      }
+      w->nid = ngram->unk_id;
+    }
+  }
+  return TRUE;
+}
+
+/**
+ * Free a lattice.
+ *
+ * @param lat [i/o] lattice
+ */
+void
+lattice_free(Lattice *lat)
+{
+  int i;
+
+  for(i=0;i<lat->num;i++) free_word(&(lat->w[i]));
+  free(lat->w);
+  free(lat->name);
+}
@@ -0,0 +1,684 @@
+/*
+ * Copyright (c) 1991-2016 Kawahara Lab., Kyoto University
+ * Copyright (c) 2000-2005 Shikano Lab., Nara Institute of Science and Technology
+ * Copyright (c) 2005-2016 Julius project team, Nagoya Institute of Technology
+ * All rights reserved
+ */
+
+/* rescore.c --- rescore a lattice with N-gram */
+
+/*
+ * The lattice words are expanded into states that hold the last N-1
+ * words of their history, so that every word on the expanded lattice
+ * has a unique N-gram context.  The new score of a path is the sum of
+ * the acoustic scores in the lattice and the new LM scores
+ * (lm_weight * log10 prob + lm_penalty).
+ *
+ * - The forward-backward on the expanded lattice gives the word
+ *   posterior probabilities, in the same manner as
+ *   graph_forward_backward() in libjulius.
+ * - The N-best sentences are found by A* search from the end of the
+ *   lattice, using the forward Viterbi scores as exact heuristics.
+ * - The confusion network is built by aligning all the words to the
+ *   words of the best sentence by time overlap (pivot alignment).
+ *
+ * When the expansion exceeds the maximum number of states, N is
+ * decreased until it fits.
+ */
+
+#include "lattice-rescore.h"
+
+/// Maximum number of popped hypotheses on N-best search
+#define RESCORE_MAXPOP 100000
+
+/* an expanded state: a lattice word with its N-gram context */
+typedef struct {
+  int word;			/* lattice word index */
+  WORD_ID hist[RESCORE_MAXN-1];	/* context after this word, the last is the word itself */
+  int histlen;			/* length of hist */
+  LOGPROB viterbi;		/* best score from the beginning to the end of this word */
+  LOGPROB alpha;		/* forward score for posterior */
+  LOGPROB beta;			/* backward score for posterior */
+  LOGPROB lm0;			/* LM score of the first word, for start states */
+  boolean start;		/* TRUE if this is a start state */
+  int arc;			/* first incoming arc */
+  int wnext;			/* next state of the same lattice word */
+  int hnext;			/* next state in the same hash bucket */
+} ExpState;
+
+/* an incoming arc of an expanded state */
+typedef struct {
+  int from;			/* previous state */
+  LOGPROB lm;			/* LM score of the transition */
+  int next;			/* next arc of the same state */
+} ExpArc;
+
+/* expanded lattice */
+typedef struct {
+  ExpState *s;
+  int snum, salloc;
+  ExpArc *a;
+  int anum, aalloc;
+  int *bucket;			/* hash buckets of states */
+  int bsize;			/* number of buckets, power of 2 */
+  int *whead;			/* first state of each lattice word */
+} Expansion;
+
+/* a partial sentence on N-best search, from a state to the end */
+typedef struct {
+  int state;			/* leftmost state */
+  LOGPROB g;			/* score after the state */
+  LOGPROB lm;			/* LM part of g */
+  int next;			/* hypothesis of the right state, -1 at end */
+} NbHypo;
+
+/* compute log10(10^x + 10^y) */
+static LOGPROB
+addlog10(LOGPROB x, LOGPROB y)
+{
+  if (x < y) {
+    return(y + log(1 + pow(10, x-y)) * INV_LOG_TEN);
+  } else {
+    return(x + log(1 + pow(10, y-x)) * INV_LOG_TEN);
+  }
+}
+
+/**********************************************************************/
+/* lattice expansion */
+
+/* hash of a state key */
+static unsigned int
+state_hash(int word, WORD_ID *hist, int histlen)
+{
+  unsigned int h;
+  int i;
+
+  h = word;
+  for(i=0;i<histlen;i++) h = h * 31 + hist[i];
+  return h;
+}
+
+/* double the hash buckets */
+static void
+expansion_rehash(Expansion *e)
+{
+  int i;
+  unsigned int h;
+
+  free(e->bucket);
+  e->bsize *= 2;
+  e->bucket = (int *)mymalloc(sizeof(int) * e->bsize);
+  for(i=0;i<e->bsize;i++) e->bucket[i] = -1;
+  for(i=0;i<e->snum;i++) {
+    h = state_hash(e->s[i].word, e->s[i].hist, e->s[i].histlen) & (e->bsize - 1);
+    e->s[i].hnext = e->bucket[h];
+    e->bucket[h] = i;
+  }
+}
+
+/* find a state, or create it if not exist */
+static int
+expansion_state(Expansion *e, int word, WORD_ID *hist, int histlen)
+{
+  unsigned int h;
+  int i;
+  ExpState *s;
+
+  h = state_hash(word, hist, histlen) & (e->bsize - 1);
+  for(i = e->bucket[h]; i != -1; i = e->s[i].hnext) {
+    s = &(e->s[i]);
+    if (s->word == word && s->histlen == histlen
+	&& memcmp(s->hist, hist, sizeof(WORD_ID) * histlen) == 0) {
+      return i;
+    }
+  }
+  if (e->snum >= e->salloc) {
+    e->salloc *= 2;
+    e->s = (ExpState *)myrealloc(e->s, sizeof(ExpState) * e->salloc);
+  }
+  i = e->snum++;
+  s = &(e->s[i]);
+  s->word = word;
+  memcpy(s->hist, hist, sizeof(WORD_ID) * histlen);
+  s->histlen = histlen;
+  s->viterbi = LOG_ZERO;
+  s->alpha = LOG_ZERO;
+  s->beta = LOG_ZERO;
+  s->lm0 = 0.0;
+  s->start = FALSE;
+  s->arc = -1;
+  s->wnext = e->whead[word];
+  e->whead[word] = i;
+  s->hnext = e->bucket[h];
+  e->bucket[h] = i;
+  if (e->snum > e->bsize) expansion_rehash(e);
+  return i;
+}
+
+/* add an incoming arc to a state */
+static void
+expansion_arc(Expansion *e, int to, int from, LOGPROB lm)
+{
+  ExpArc *a;
+
+  if (e->anum >= e->aalloc) {
+    e->aalloc *= 2;
+    e->a = (ExpArc *)myrealloc(e->a, sizeof(ExpArc) * e->aalloc);
+  }
+  a = &(e->a[e->anum]);
+  a->from = from;
+  a->lm = lm;
+  a->next = e->s[to].arc;
+  e->s[to].arc = e->anum;
+  e->anum++;
+}
+
+static void
+expansion_init(Expansion *e, int wnum)
+{
+  int i;
+
+  e->salloc = wnum * 4;
+  e->s = (ExpState *)mymalloc(sizeof(ExpState) * e->salloc);
+  e->snum = 0;
+  e->aalloc = wnum * 16;
+  e->a = (ExpArc *)mymalloc(sizeof(ExpArc) * e->aalloc);
+  e->anum = 0;
+  for(e->bsize = 256; e->bsize < wnum * 4; e->bsize *= 2);
+  e->bucket = (int *)mymalloc(sizeof(int) * e->bsize);
+  for(i=0;i<e->bsize;i++) e->bucket[i] = -1;
+  e->whead = (int *)mymalloc(sizeof(int) * wnum);
+  for(i=0;i<wnum;i++) e->whead[i] = -1;
+}
+
+static void
+expansion_free(Expansion *e)
+{
+  free(e->s);
+  free(e->a);
+  free(e->bucket);
+  free(e->whead);
+}
+
+/* sort lattice words so that all left words come before, by
+   depth-first search on left contexts.  Links that make a loop are
+   ignored. */
+static int *
+lattice_topo_order(Lattice *lat)
+{
+  int *order, *mark, *stack, *pos;
+  int i, n, sp, v, u;
+
+  order = (int *)mymalloc(sizeof(int) * lat->num);
+  mark = (int *)mymalloc(sizeof(int) * lat->num);
+  stack = (int *)mymalloc(sizeof(int) * lat->num);
+  pos = (int *)mymalloc(sizeof(int) * lat->num);
+  for(i=0;i<lat->num;i++) mark[i] = 0; /* 0: new, 1: visiting, 2: done */
+  n = 0;
+  for(i=0;i<lat->num;i++) {
+    if (mark[i] != 0) continue;
+    sp = 0;
+    stack[sp] = i; pos[sp] = 0; sp++;
+    mark[i] = 1;
+    while (sp > 0) {
+      v = stack[sp-1];
+      if (pos[sp-1] < lat->w[v].leftnum) {
+	u = lat->w[v].left[pos[sp-1]++];
+	if (mark[u] == 0) {
+	  mark[u] = 1;
+	  stack[sp] = u; pos[sp] = 0; sp++;
+	}
+      } else {
+	mark[v] = 2;
+	order[n++] = v;
+	sp--;
+      }
+    }
+  }
+  free(pos);
+  free(stack);
+  free(mark);
+
+  return order;
+}
+
+/* expand the lattice with N-gram context of n-1 words.  Returns FALSE
+   if exceeds the maximum number of states. */
+static boolean
+expand_lattice(Lattice *lat, int *order, RescoreConfig *conf, int n, Expansion *e)
+{
+  int i, j, k, v, si, ti;
+  LatWord *w;
+  ExpState *s, *t;
+  WORD_ID ctx[RESCORE_MAXN];
+  int len, histlen;
+  LOGPROB lm, score;
+
+  histlen = n - 1;
+  for(i=0;i<lat->num;i++) {
+    v = order[i];
+    w = &(lat->w[v]);
+    if (w->leftnum == 0) {
+      if (w->lefttime != 0) continue; /* unreachable */
+      /* start word: the context is the beginning of sentence */
+      if (w->nid == conf->bos) {
+	ctx[0] = conf->bos;
+	len = 1;
+	lm = 0.0;
+      } else {
+	ctx[0] = conf->bos;
+	ctx[1] = w->nid;
+	len = (n >= 2) ? 2 : 1;
+	lm = ngram_prob(conf->ngram, len, &(ctx[2-len])) * conf->lm_weight + conf->lm_penalty;
+	len = 2;
+      }
+      k = (len > histlen) ? len - histlen : 0;
+      ti = expansion_state(e, v, &(ctx[k]), len - k);
+      t = &(e->s[ti]);
+      t->start = TRUE;
+      t->lm0 = lm;
+      t->viterbi = lm + w->am;
+      t->alpha = (lm + w->am) * conf->cm_alpha;
+    } else {
+      for(j=0;j<w->leftnum;j++) {
+	if (w->left[j] == v) continue; /* loop */
+	for(si = e->whead[w->left[j]]; si != -1; si = e->s[si].wnext) {
+	  s = &(e->s[si]);
+	  memcpy(ctx, s->hist, sizeof(WORD_ID) * s->histlen);
+	  ctx[s->histlen] = w->nid;
+	  len = s->histlen + 1;
+	  lm = ngram_prob(conf->ngram, len, ctx) * conf->lm_weight + conf->lm_penalty;
+	  k = (len > histlen) ? len - histlen : 0;
+	  score = s->viterbi;
+	  ti = expansion_state(e, v, &(ctx[k]), len - k);
+	  /* e->s may be moved by expansion_state() */
+	  s = &(e->s[si]);
+	  t = &(e->s[ti]);
+	  expansion_arc(e, ti, si, lm);
+	  if (t->viterbi < score + lm + w->am) {
+	    t->viterbi = score + lm + w->am;
+	  }
+	  t->alpha = addlog10(t->alpha, s->alpha + (lm + w->am) * conf->cm_alpha);
+	}
+      }
+    }
+    /* with unigram the states are at most the words */
+    if (n > 1 && e->snum > conf->maxstates) return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**********************************************************************/
+/* posterior probability */
+
+/* forward-backward on the expanded lattice, sets posterior of each
+   lattice word.  Returns FALSE if no path reaches the end. */
+static boolean
+compute_posterior(Lattice *lat, RescoreConfig *conf, Expansion *e)
+{
+  int i, ai;
+  ExpState *s;
+  ExpArc *a;
+  LatWord *w;
+  LOGPROB sum;
+
+  sum = LOG_ZERO;
+  for(i=0;i<e->snum;i++) {
+    s = &(e->s[i]);
+    w = &(lat->w[s->word]);
+    if (w->rightnum == 0 && w->righttime == lat->framelen - 1 && s->alpha > LOG_ZERO) {
+      s->beta = 0.0;
+      sum = addlog10(sum, s->alpha);
+    }
+  }
+  if (sum <= LOG_ZERO) return FALSE;
+
+  /* states are created in topological order */
+  for(i=e->snum-1;i>=0;i--) {
+    s = &(e->s[i]);
+    if (s->beta <= LOG_ZERO) continue;
+    w = &(lat->w[s->word]);
+    for(ai = s->arc; ai != -1; ai = a->next) {
+      a = &(e->a[ai]);
+      e->s[a->from].beta = addlog10(e->s[a->from].beta, s->beta + (a->lm + w->am) * conf->cm_alpha);
+    }
+  }
+
+  for(i=0;i<lat->num;i++) lat->w[i].post = 0.0;
+  for(i=0;i<e->snum;i++) {
+    s = &(e->s[i]);
+    if (s->alpha <= LOG_ZERO || s->beta <= LOG_ZERO) continue;
+    lat->w[s->word].post += pow(10, s->alpha + s->beta - sum);
+  }
+
+  return TRUE;
+}
+
+/**********************************************************************/
+/* N-best search */
+
+/* binary heap of hypotheses ordered by f = viterbi + g */
+static LOGPROB
+hypo_f(NbHypo *pool, int h, Expansion *e)
+{
+  return(e->s[pool[h].state].viterbi + pool[h].g);
+}
+
+static void
+heap_push(int *heap, int *num, int h, NbHypo *pool, Expansion *e)
+{
+  int i, p, tmp;
+
+  i = (*num)++;
+  heap[i] = h;
+  while (i > 0) {
+    p = (i - 1) / 2;
+    if (hypo_f(pool, heap[p], e) >= hypo_f(pool, heap[i], e)) break;
+    tmp = heap[p]; heap[p] = heap[i]; heap[i] = tmp;
+    i = p;
+  }
+}
+
+static int
+heap_pop(int *heap, int *num, NbHypo *pool, Expansion *e)
+{
+  int ret, i, c, tmp;
+
+  ret = heap[0];
+  heap[0] = heap[--(*num)];
+  i = 0;
+  for(;;) {
+    c = i * 2 + 1;
+    if (c >= *num) break;
+    if (c + 1 < *num && hypo_f(pool, heap[c+1], e) > hypo_f(pool, heap[c], e)) c++;
+    if (hypo_f(pool, heap[i], e) >= hypo_f(pool, heap[c], e)) break;
+    tmp = heap[c]; heap[c] = heap[i]; heap[i] = tmp;
+    i = c;
+  }
+  return ret;
+}
+
+/* store a found sentence if it differs from the ones already found */
+static boolean
+nbest_store(Lattice *lat, Expansion *e, NbHypo *pool, int h, RescoreResult *res)
+{
+  int len, i, j, k;
+  int *word;
+  RescoreSent *sent;
+
+  len = 0;
+  for(i = h; i != -1; i = pool[i].next) len++;
+  word = (int *)mymalloc(sizeof(int) * len);
+  len = 0;
+  for(i = h; i != -1; i = pool[i].next) word[len++] = e->s[pool[i].state].word;
+
+  for(k=0;k<res->sentnum;k++) {
+    sent = &(res->sent[k]);
+    if (sent->len != len) continue;
+    for(j=0;j<len;j++) {
+      if (lat->w[sent->word[j]].wid != lat->w[word[j]].wid) break;
+    }
+    if (j == len) {		/* same word sequence */
+      free(word);
+      return FALSE;
+    }
+  }
+  sent = &(res->sent[res->sentnum++]);
+  sent->word = word;
+  sent->len = len;
+  sent->score = hypo_f(pool, h, e);
+  sent->lmscore = pool[h].lm + e->s[pool[h].state].lm0;
+  return TRUE;
+}
+
+/* find N-best sentences by A* search from the end */
+static void
+nbest_search(Lattice *lat, RescoreConfig *conf, Expansion *e, RescoreResult *res)
+{
+  NbHypo *pool;
+  int pnum, palloc;
+  int *heap, hnum, halloc;
+  int i, h, ai, popped;
+  ExpState *s;
+  ExpArc *a;
+  LatWord *w;
+
+  res->sent = (RescoreSent *)mymalloc(sizeof(RescoreSent) * conf->nbest);
+  res->sentnum = 0;
+
+  palloc = halloc = 4096;
+  pool = (NbHypo *)mymalloc(sizeof(NbHypo) * palloc);
+  heap = (int *)mymalloc(sizeof(int) * halloc);
+  pnum = hnum = 0;
+
+  /* initial hypotheses at the end states */
+  for(i=0;i<e->snum;i++) {
+    s = &(e->s[i]);
+    w = &(lat->w[s->word]);
+    if (w->rightnum != 0 || w->righttime != lat->framelen - 1 || s->viterbi <= LOG_ZERO) continue;
+    if (pnum >= palloc) {
+      palloc *= 2;
+      pool = (NbHypo *)myrealloc(pool, sizeof(NbHypo) * palloc);
+    }
+    if (hnum >= halloc) {
+      halloc *= 2;
+      heap = (int *)myrealloc(heap, sizeof(int) * halloc);
+    }
+    pool[pnum].state = i;
+    pool[pnum].g = 0.0;
+    pool[pnum].lm = 0.0;
+    pool[pnum].next = -1;
+    heap_push(heap, &hnum, pnum++, pool, e);
+  }
+
+  popped = 0;
+  while (hnum > 0 && res->sentnum < conf->nbest && popped < RESCORE_MAXPOP) {
+    h = heap_pop(heap, &hnum, pool, e);
+    popped++;
+    s = &(e->s[pool[h].state]);
+    if (s->start) {
+      nbest_store(lat, e, pool, h, res);
+      continue;
+    }
+    /* extend to left */
+    w = &(lat->w[s->word]);
+    for(ai = s->arc; ai != -1; ai = a->next) {
+      a = &(e->a[ai]);
+      if (e->s[a->from].viterbi <= LOG_ZERO) continue;
+      if (pnum >= palloc) {
+	palloc *= 2;
+	pool = (NbHypo *)myrealloc(pool, sizeof(NbHypo) * palloc);
+      }
+      if (hnum >= halloc) {
+	halloc *= 2;
+	heap = (int *)myrealloc(heap, sizeof(int) * halloc);
+      }
+      pool[pnum].state = a->from;
+      pool[pnum].g = pool[h].g + a->lm + w->am;
+      pool[pnum].lm = pool[h].lm + a->lm;
+      pool[pnum].next = h;
+      heap_push(heap, &hnum, pnum++, pool, e);
+    }
+  }
+
+  free(heap);
+  free(pool);
+}
+
+/**********************************************************************/
+/* confusion network */
+
+/* an entry of confusion network cluster under construction */
+typedef struct {
+  int word;			/* lattice word index, -1 for skip */
+  LOGPROB pp;			/* posterior probability */
+} CnEntry;
+
+/* qsort callback to sort cluster entries by posterior */
+static int
+compare_entry(const void *x, const void *y)
+{
+  const CnEntry *a = (const CnEntry *)x;
+  const CnEntry *b = (const CnEntry *)y;
+
+  if (a->pp < b->pp) return 1;
+  if (a->pp > b->pp) return -1;
+  return 0;
+}
+
+/* build confusion network by aligning words to the best sentence */
+static void
+make_confnet(Lattice *lat, RescoreResult *res)
+{
+  RescoreSent *best;
+  RescoreCluster *c;
+  LatWord *w, *p;
+  int i, j, k, ov, bestov, bestk, dist, bestdist, neark;
+  int *cnum;
+  CnEntry **ent;
+  LOGPROB sum;
+
+  best = &(res->sent[0]);
+  res->clusternum = best->len;
+  res->cluster = (RescoreCluster *)mymalloc(sizeof(RescoreCluster) * best->len);
+  cnum = (int *)mymalloc(sizeof(int) * best->len);
+  ent = (CnEntry **)mymalloc(sizeof(CnEntry *) * best->len);
+  for(k=0;k<best->len;k++) {
+    cnum[k] = 0;
+    ent[k] = (CnEntry *)mymalloc(sizeof(CnEntry) * (lat->num + 1));
+  }
+
+  /* assign each word to the pivot with the largest overlap, or to the
+     nearest one if no overlap */
+  for(i=0;i<lat->num;i++) {
+    w = &(lat->w[i]);
+    if (w->post <= 0.0) continue;
+    bestk = neark = -1;
+    bestov = bestdist = 0;
+    for(k=0;k<best->len;k++) {
+      p = &(lat->w[best->word[k]]);
+      ov = ((w->righttime < p->righttime) ? w->righttime : p->righttime)
+	- ((w->lefttime > p->lefttime) ? w->lefttime : p->lefttime) + 1;
+      if (ov > bestov) {
+	bestov = ov;
+	bestk = k;
+      }
+      dist = abs((w->lefttime + w->righttime) - (p->lefttime + p->righttime));
+      if (neark == -1 || dist < bestdist) {
+	bestdist = dist;
+	neark = k;
+      }
+    }
+    if (bestk == -1) bestk = neark;
+    /* merge the same word */
+    for(j=0;j<cnum[bestk];j++) {
+      if (lat->w[ent[bestk][j].word].wid == w->wid) break;
+    }
+    if (j < cnum[bestk]) {
+      ent[bestk][j].pp += w->post;
+    } else {
+      ent[bestk][j].word = i;
+      ent[bestk][j].pp = w->post;
+      cnum[bestk]++;
+    }
+  }
+
+  for(k=0;k<best->len;k++) {
+    sum = 0.0;
+    for(j=0;j<cnum[k];j++) sum += ent[k][j].pp;
+    if (sum > 1.0) {
+      for(j=0;j<cnum[k];j++) ent[k][j].pp /= sum;
+    } else if (1.0 - sum >= 0.001) {
+      /* skip */
+      ent[k][cnum[k]].word = -1;
+      ent[k][cnum[k]].pp = 1.0 - sum;
+      cnum[k]++;
+    }
+    qsort(ent[k], cnum[k], sizeof(CnEntry), compare_entry);
+    c = &(res->cluster[k]);
+    c->num = cnum[k];
+    c->word = (int *)mymalloc(sizeof(int) * c->num);
+    c->pp = (LOGPROB *)mymalloc(sizeof(LOGPROB) * c->num);
+    for(j=0;j<c->num;j++) {
+      c->word[j] = ent[k][j].word;
+      c->pp[j] = ent[k][j].pp;
+    }
+    free(ent[k]);
+  }
+  free(ent);
+  free(cnum);
+}
+
+/**********************************************************************/
+
+/**
+ * Rescore a lattice with N-gram.  The posterior of each word is stored
+ * in the lattice, and the N-best sentences and confusion network are
+ * stored in the result.
+ *
+ * @param lat [i/o] lattice, the words should be mapped to the N-gram
+ * @param conf [in] rescoring parameters
+ * @param res [out] result
+ *
+ * @return TRUE on success, FALSE if no sentence was found.
+ */
+boolean
+rescore_lattice(Lattice *lat, RescoreConfig *conf, RescoreResult *res)
+{
+  int *order;
+  int n;
+  Expansion e;
+  boolean ok;
+
+  res->n = 0;
+  res->states = 0;
+  res->sent = NULL;
+  res->sentnum = 0;
+  res->cluster = NULL;
+  res->clusternum = 0;
+  if (lat->num == 0) return FALSE;
+
+  order = lattice_topo_order(lat);
+  for(n = conf->n; ; n--) {
+    expansion_init(&e, lat->num);
+    if (expand_lattice(lat, order, conf, n, &e)) break;
+    expansion_free(&e);
+  }
+  free(order);
+  res->n = n;
+  res->states = e.snum;
+
+  ok = compute_posterior(lat, conf, &e);
+  if (ok) {
+    nbest_search(lat, conf, &e, res);
+    if (res->sentnum == 0) ok = FALSE;
+  }
+  if (ok && conf->confnet) make_confnet(lat, res);
+  expansion_free(&e);
+
+  return ok;
+}
+
+/**
+ * Free the rescoring result.
+ *
+ * @param res [i/o] result
+ */
+void
+rescore_result_free(RescoreResult *res)
+{
+  int i;
+
+  if (res->sent) {
+    for(i=0;i<res->sentnum;i++) free(res->sent[i].word);
+    free(res->sent);
+  }
+  if (res->cluster) {
+    for(i=0;i<res->clusternum;i++) {
+      free(res->cluster[i].word);
+      free(res->cluster[i].pp);
+    }
+    free(res->cluster);
+  }
+}
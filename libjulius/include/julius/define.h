@@ -109,6 +109,8 @@
 #endif /* LOWMEM */
 
 /*#define HASH_CACHE_IW*/
+/* number of ways of the set-associative cross-word cache (HASH_CACHE_IW) */
+#define IW_CACHE_WAYS 4
 /* "./configure --enable-lowmem" defines NO_SEPARATE_SHORT_WORD instead */
 
 /* default language model weight and insertion penalty for pass1 and pass2 */
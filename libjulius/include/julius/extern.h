@@ -34,11 +34,12 @@ void bt_prepare(BACKTRELLIS *bt);
 void bt_free(BACKTRELLIS *bt);
 TRELLIS_ATOM *bt_new(BACKTRELLIS *bt);
 void bt_store(BACKTRELLIS *bt, TRELLIS_ATOM *aotm);
+void bt_evict(BACKTRELLIS *bt, TRELLIS_ATOM *tre, TRELLIS_ATOM *root, LOGPROB base);
 void bt_relocate_rw(BACKTRELLIS *bt);
 void set_terminal_words(RecogProcess *r);
 void bt_discount_pescore(WCHMM_INFO *wchmm, BACKTRELLIS *bt, HTK_Param *param);
 void bt_discount_lm(BACKTRELLIS *bt);
-void bt_sort_rw(BACKTRELLIS *bt);
+void bt_sort_rw_ngram(BACKTRELLIS *bt, WORD_INFO *winfo);
 TRELLIS_ATOM *bt_binsearch_atom(BACKTRELLIS *bt, int time, WORD_ID wkey);
 
 /* factoring_sub.c */
@@ -46,7 +47,7 @@ void make_iwcache_index(WCHMM_INFO *wchmm);
 void adjust_sc_index(WCHMM_INFO *wchmm);
 void make_successor_list(WCHMM_INFO *wchmm);
 void make_successor_list_unigram_factoring(WCHMM_INFO *wchmm);
-void max_successor_cache_init(WCHMM_INFO *wchmm);
+void max_successor_cache_init(WCHMM_INFO *wchmm, JCONF_SEARCH *sconf);
 void max_successor_cache_free(WCHMM_INFO *wchmm);
 LOGPROB max_successor_prob(WCHMM_INFO *wchmm, WORD_ID lastword, int node);
 LOGPROB *max_successor_prob_iw(WCHMM_INFO *wchmm, WORD_ID lastword);
@@ -57,6 +58,7 @@ boolean can_succeed(WCHMM_INFO *wchmm, WORD_ID lastword, int node);
 boolean get_back_trellis_init(HTK_Param *param, RecogProcess *r);
 boolean get_back_trellis_proceed(int t, HTK_Param *param, RecogProcess *r, boolean final_for_multipath);
 void get_back_trellis_end(HTK_Param *param, RecogProcess *r);
+int stream_commit_words(RecogProcess *r, int t);
 void fsbeam_free(FSBeam *d);
 void finalize_1st_pass(RecogProcess *r, int len);
 
@@ -69,6 +71,19 @@ void decode_end_segmented(Recog *recog);
 void decode_end(Recog *recog);
 boolean get_back_trellis(Recog *recog);
 
+/* sr_parallel.c */
+void sr_parallel_exec(Recog *recog, void (*func)(RecogProcess *, void *), void *data);
+void sr_parallel_free(Recog *recog);
+
+/* pass2_async.c */
+double pass2_time_now();
+void pass2_latency_log(double start_time, double pass2_time);
+boolean pass2_async_start(Recog *recog, boolean pass2_p, double start_time);
+boolean pass2_async_defer_end(Recog *recog, boolean segment_end, boolean recognition_end);
+void pass2_async_poll(Recog *recog);
+void pass2_async_wait(Recog *recog);
+void pass2_async_free(Recog *recog);
+
 /* spsegment.c */
 boolean is_sil(WORD_ID w, RecogProcess *r);
 void mfcc_copy_to_rest_and_shrink(MFCCCalc *mfcc, int start, int end);
@@ -86,6 +101,7 @@ void spsegment_restart_mfccs(Recog *recog, int rewind_frame, boolean reprocess);
 void outprob_style_cache_init(WCHMM_INFO *wchmm);
 CD_Set *lcdset_lookup_with_category(WCHMM_INFO *wchmm, HMM_Logical *hmm, WORD_ID category);
 void lcdset_register_with_category_all(WCHMM_INFO *wchmm);
+void lcdset_register_with_category_words(WCHMM_INFO *wchmm, WORD_ID *newword, int newnum);
 void lcdset_remove_with_category_all(WCHMM_INFO *wchmm);
 #endif
 LOGPROB outprob_style(WCHMM_INFO *wchmm, int node, int last_wid, int t, HTK_Param *param);
@@ -136,10 +152,12 @@ void wchmm_free(WCHMM_INFO *w);
 void print_wchmm_info(WCHMM_INFO *wchmm);
 boolean build_wchmm(WCHMM_INFO *wchmm, JCONF_LM *lmconf);
 boolean build_wchmm2(WCHMM_INFO *wchmm, JCONF_LM *lmconf);
+boolean wchmm_update(WCHMM_INFO *wchmm, WORD_INFO *winfo, DFA_INFO *dfa, DFA_INFO *dfa_forward, WORD_ID *wmap, int old_wnum, WORD_ID *cmap, int old_cnum, JCONF_LM *lmconf);
 
 /* wchmm_check.c */
 void wchmm_check_interactive(WCHMM_INFO *wchmm);
 void check_wchmm(WCHMM_INFO *wchmm);
+boolean wchmm_check_update(WCHMM_INFO *wchmm, JCONF_LM *lmconf);
 
 /* realtime.c --- callback for adin_cut() */
 boolean RealTimeInit(Recog *recog);
@@ -188,10 +206,12 @@ void print_engine_info(Recog *recog);
 void system_bootup(Recog *recog);
 /* m_adin.c */
 boolean adin_initialize(Recog *recog);
+boolean adin_initialize_user(Recog *recog, void *arg);
 /* m_fusion.c */
 boolean j_load_am(Recog *recog, JCONF_AM *amconf);
 boolean j_load_lm(Recog *recog, JCONF_LM *lmconf);
 boolean j_load_all(Recog *recog, Jconf *jconf);
+boolean j_load_all_shared(Recog *recog, Recog *src);
 boolean j_launch_recognition_instance(Recog *recog, JCONF_SEARCH *sconf);
 boolean j_final_fusion(Recog *recog);
 void create_mfcc_calc_instances(Recog *recog);
@@ -227,8 +247,10 @@ void wordgraph_dump(FILE *fp, WordGraph *root, WORD_INFO *winfo);
 WordGraph *wordgraph_assign(WORD_ID wid, WORD_ID wid_left, WORD_ID wid_right, int leftframe, int rightframe, LOGPROB fscore_head, LOGPROB fscore_tail, LOGPROB gscore_head, LOGPROB gscore_tail, LOGPROB lscore, LOGPROB cmscore, RecogProcess *r);
 boolean wordgraph_check_and_add_rightword(WordGraph *wg, WordGraph *right, LOGPROB lscore);
 boolean wordgraph_check_and_add_leftword(WordGraph *wg, WordGraph *left, LOGPROB lscore);
-void wordgraph_save(WordGraph *wg, WordGraph *right, WordGraph **root);
-WordGraph *wordgraph_check_merge(WordGraph *now, WordGraph **root, WORD_ID next_wid, boolean *merged_p, JCONF_SEARCH *jconf);
+void wordgraph_index_init(WordGraphIndex *idx, int width);
+void wordgraph_index_free(WordGraphIndex *idx);
+void wordgraph_save(WordGraph *wg, WordGraph *right, WordGraph **root, WordGraphIndex *index);
+WordGraph *wordgraph_check_merge(WordGraph *now, WordGraph **root, WordGraphIndex *index, WORD_ID next_wid, boolean *merged_p, JCONF_SEARCH *jconf);
 WordGraph *wordgraph_dup(WordGraph *wg, WordGraph **root);
 void wordgraph_purge_leaf_nodes(WordGraph **rootp, RecogProcess *r);
 void wordgraph_depth_cut(WordGraph **rootp, RecogProcess *r);
@@ -237,6 +259,7 @@ void wordgraph_clean(WordGraph **rootp);
 void wordgraph_compaction_thesame(WordGraph **rootp);
 void wordgraph_compaction_exacttime(WordGraph **rootp, RecogProcess *r);
 void wordgraph_compaction_neighbor(WordGraph **rootp, RecogProcess *r);
+void wordgraph_compute_amscore(WordGraph *root, RecogProcess *r);
 int wordgraph_sort_and_annotate_id(WordGraph **rootp, RecogProcess *r);
 void wordgraph_check_coherence(WordGraph *rootp, RecogProcess *r);
 void graph_forward_backward(WordGraph *root, RecogProcess *r);
@@ -309,6 +332,8 @@ void result_align_free(SentenceAlign *a);
 void result_sentence_malloc(RecogProcess *r, int num);
 void result_sentence_free(RecogProcess *r);
 void clear_result(RecogProcess *r);
+void pass2_process(RecogProcess *r, void *data);
+void pass2_output(Recog *recog, boolean pass2_p);
 
 /* plugin.c */
 int plugin_get_id(char *name);
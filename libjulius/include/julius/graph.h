@@ -55,6 +55,7 @@ typedef struct __word_graph__ {
   LOGPROB cmscore;		///< Confidence score obtained while search
 #endif
   LOGPROB amavg;		///< average acoustic score of matched frame
+  LOGPROB amscore;		///< Acoustic score re-computed on the final word segment (-graphamscore), LOG_ZERO if not computed
   HMM_Logical *headphone;	///< Applied phone HMM at the head of the word 
   HMM_Logical *tailphone;	///< Applied phone HMM at the end of the word 
   struct __word_graph__ **leftword; ///< List of left context
@@ -73,8 +74,34 @@ typedef struct __word_graph__ {
   boolean purged;		///< Purged mark for graph generation
 #endif
   LOGPROB graph_cm;		///< Confidense score computed from the graph
+  struct __word_graph__ *hashnext; ///< Next word in the same bucket of WordGraphIndex
+  int seq;			///< Position in the word list when indexed
 } WordGraph;
 
+/**
+ * <JA>
+ * 単語グラフ中の単語を高速に検索するためのハッシュインデックス. 
+ * 単語ID と始終端時刻をキーとする. 時刻幅 width が 1 より大きい場合，
+ * 始端時刻を width フレームごとのバケツにまとめ，近傍単語の検索に用いる. 
+ * </JA>
+ * <EN>
+ * Hash index of graph words for fast lookup of the same word at the
+ * same position.  The key is word ID and boundary frames.  When
+ * @a width is larger than 1, the left time is bucketed by @a width
+ * frames (right time ignored) for neighbor word search.
+ * </EN>
+ */
+typedef struct __word_graph_index__ {
+  WordGraph **bucket;		///< Hash buckets, chained by WordGraph::hashnext in list order
+  int size;			///< Number of buckets (power of 2)
+  int num;			///< Number of indexed words
+  int width;			///< Time width of a bucket, 1 means exact (wid, left, right) key
+  int lookups;			///< Number of lookups performed (statistics)
+  int probes;			///< Number of words examined in lookups (statistics)
+} WordGraphIndex;
+
+#define WGINDEX_INITSIZE 256	///< Initial number of buckets in WordGraphIndex
+
 /**
  * Word Cluster for confusion network generation
  * 
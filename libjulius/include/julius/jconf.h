@@ -517,6 +517,23 @@ typedef struct __jconf_search__ {
      */
 #endif
     LOGPROB score_pruning_width;
+
+    /**
+     * Number of frames for phone lookahead pruning with GS HMM
+     * (-lookahead).  0 disables it.
+     */
+    int lookahead_frames;
+
+    /**
+     * Score width for phone lookahead pruning (-lookahead).
+     */
+    LOGPROB lookahead_width;
+
+    /**
+     * Interval in frames to commit the converged words and drop the
+     * past input on on-the-fly decoding (-streamcommit).  0 disables it.
+     */
+    int stream_commit;
     
 #if defined(WPAIR) && defined(WPAIR_KEEP_NLIMIT)
     /**
@@ -530,6 +547,10 @@ typedef struct __jconf_search__ {
      * Inter-word LM cache size rate (-iwcache)
      */
     int iw_cache_rate;
+    /**
+     * Inter-word LM cache size in MB, overrides @a iw_cache_rate (-iwcachemb)
+     */
+    int iw_cache_mb;
 #endif
 
     /**
@@ -595,6 +616,12 @@ typedef struct __jconf_search__ {
      * at 2nd pass of DFA for speedup (-looktrellis)
      */
     boolean looktrellis_flag;
+
+    /**
+     * Memory size in MB of the hypothesis recombination cache at 2nd
+     * pass.  0 disables recombination (-recombine)
+     */
+    int recombine_mb;
     
   } pass2;
 
@@ -629,6 +656,12 @@ typedef struct __jconf_search__ {
      */
     int graph_merge_neighbor_range;
 
+    /**
+     * GraphOut: re-compute acoustic score of each word on its final
+     * segment in the graph (-graphamscore)
+     */
+    boolean amscore;
+
 #ifdef   GRAPHOUT_DEPTHCUT
     /**
      * GraphOut: density threshold to cut word graph at post-processing.
@@ -758,6 +791,10 @@ typedef struct __jconf_search__ {
      * Forced alignment: per state (-salign)
      */
     boolean align_result_state_flag;
+    /**
+     * Number of threads to compute forced alignment of N-best results (-alignthreads)
+     */
+    int align_threads;
 
   } annotate;
 
@@ -808,6 +845,11 @@ typedef struct __jconf_search__ {
      * Enter lexicon structure consulting mode after boot (-check wchmm)
      */
     boolean wchmm_check_flag;
+    /**
+     * Compare incrementally updated lexicon tree with the one built
+     * from scratch at each grammar change (-check update)
+     */
+    boolean wchmm_update_check_flag;
     /**
      * should be set to TRUE at startup when this process should start
      * with inactive status
@@ -907,6 +949,11 @@ typedef struct __Jconf__ {
      * Use 48kHz input and perform down sampling to 16kHz (-48)
      */
     boolean use_ds48to16;
+    /**
+     * Sampling rate of input device, resampled to @a sfreq if differs
+     * (-infreq), 0 if same as @a sfreq
+     */
+    int infreq;
     /**
      * List of input files for rawfile / mfcfile input (-filelist) 
      */
@@ -1053,6 +1100,10 @@ typedef struct __Jconf__ {
      * Number of Gaussians to be computed on GMM calculation (-gmmnum)
      */
     int gmm_gprune_num;
+    /**
+     * Number of Gaussians shared among all GMMs per frame (-gmmtopk)
+     */
+    int gmm_shared_topk;
     /**
      * Comma-separated list of GMM model name to be rejected (-gmmreject)
      */
@@ -1104,6 +1155,24 @@ typedef struct __Jconf__ {
      */
     boolean segment;
 
+    /**
+     * Number of threads to run recognition process instances in
+     * parallel (-srthreads)
+     */
+    int sr_threads;
+
+    /**
+     * Comma-separated list of CPUs to bind the threads of @a sr_threads
+     * (-cpuaffinity)
+     */
+    char *cpu_affinity;
+
+    /**
+     * TRUE if the 2nd pass runs in background while the 1st pass of
+     * the next input segment (-pass2async)
+     */
+    boolean pass2_async;
+
   } decodeopt;
 
   /**
@@ -1224,6 +1293,7 @@ from_code ->jconf.output.from_code
 gmm ->model.gmm
 gmm_filename ->jconf.reject.gmm_filename
 gmm_gprune_num ->jconf.reject.gmm_gprune_num
+gmm_shared_topk ->jconf.reject.gmm_shared_topk
 gmm_reject_cmn_string ->jconf.reject.gmm_reject_cmn_string
 gprune_method ->jconf.am.gprune_method
 gramlist ->model.grammars
@@ -1241,7 +1311,9 @@ hmm_gs_filename ->jconf.am.hmm_gs_filename
 hmmfilename ->jconf.am.hmmfilename
 hmminfo ->model.hmminfo
 hypo_overflow ->jconf.search.pass2.hypo_overflow
+infreq ->jconf.input.infreq
 inputlist_filename ->jconf.input.inputlist_filename
+iw_cache_mb ->jconf.search.pass1.iw_cache_mb
 iw_cache_rate ->jconf.search.pass1.iw_cache_rate
 iwcdmaxn ->jconf.search.pass1.iwcdmaxn
 iwcdmethod ->jconf.search.pass1.iwcdmethod
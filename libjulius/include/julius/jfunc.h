@@ -60,6 +60,7 @@ Jconf *j_config_load_file_new(char *filename);
 void j_add_dict(JCONF_LM *lm, char *dictfile);
 void j_add_word(JCONF_LM *lm, char *wordentry);
 boolean j_adin_init(Recog *recog);
+boolean j_adin_init_user(Recog *recog, void *arg);
 char *j_get_current_filename(Recog *recog);
 void j_recog_info(Recog *recog);
 Recog *j_create_instance_from_jconf(Jconf *jconf);
@@ -115,6 +116,12 @@ void j_jconf_free(Jconf *jconf);
 Recog *j_recog_new();
 void j_recog_free(Recog *recog);
 
+/* dnn_batch.c */
+DNNBatch *j_dnn_batch_new(Recog *recog, int maxbatch, int maxwait_msec);
+boolean j_dnn_batch_attach(DNNBatch *batch, Recog *recog);
+void j_dnn_batch_detach(PROCESS_AM *am);
+void j_dnn_batch_free(DNNBatch *batch);
+
 #ifdef __cplusplus
 }
 #endif
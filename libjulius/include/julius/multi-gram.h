@@ -43,6 +43,10 @@ typedef struct __multi_gram__ {
   int cate_begin;		///< Location of category entries in the global grammar
   int word_begin;		///< Location of words in the dictionary of global grammar
   int state_begin_forward;      ///< Location of forward DFA states in the global forward grammar
+  int word_num;			///< Number of words installed in the global grammar
+  int prev_word_begin;		///< @a word_begin before the last update, or -1 if not installed
+  int prev_word_num;		///< @a word_num before the last update
+  int prev_cate_begin;		///< @a cate_begin before the last update
   struct __multi_gram__ *next;	///< Link to the next grammar entry
 } MULTIGRAM;
 
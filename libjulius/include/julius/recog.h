@@ -129,6 +129,19 @@ typedef struct __FSBeam__ {
   LOGPROB score_pruning_threshold;///< Score threshold for score pruning
   int score_pruning_count;	  ///< Number of tokens pruned by score (debug)
 #endif
+  /* for phone lookahead pruning */
+  int la_frames;	///< Lookahead length in frames, 0 if disabled
+  LOGPROB la_width;	///< Score width for lookahead pruning
+  short *la_phone;	///< Lookahead phone ID of phone head nodes, -1 for others [node]
+  int la_nodenum;	///< Number of nodes in @a la_phone
+  int la_version;	///< Grammar version of the lexicon @a la_phone was made from
+  int la_phonenum;	///< Number of lookahead phones
+  LOGPROB *la_frame_max; ///< Best score of each phone per frame, ring of @a la_frames frames
+  int *la_frame_time;	///< Frame stored at each slot of @a la_frame_max
+  LOGPROB *la_score;	///< Lookahead score of each phone at current frame
+  LOGPROB la_thres;	///< Lookahead pruning threshold at current frame
+  int la_pruned;	///< Number of expansions pruned by lookahead
+  int la_scored;	///< Number of tokens whose output probabilities are computed
     
   /* Active token list */
   TOKENID *token;       ///< Active token list that holds currently assigned tokens for each tree node
@@ -171,6 +184,11 @@ typedef struct __FSBeam__ {
   char *pausemodelnames;        ///< pause model name string to detect segment
   char **pausemodel;            ///< each pause model name to detect segment
   int pausemodelnum;            ///< num of pausemodel
+  /* for streaming commit */
+  TRELLIS_ATOM commit_root;     ///< Copy of the last committed word, as the root of the following trellis words
+  int commit_next;              ///< Frame to check convergence next
+  int commit_offset;            ///< Number of frames already committed and discarded in the current input
+  int commit_wnum;              ///< Number of words already committed in the current input
 } FSBeam;
 
 
@@ -240,6 +258,8 @@ typedef struct __StackDecode__ {
   HMM_Logical **phmmseq;        ///< Phoneme sequence to be computed
   int phmmlen_max;              ///< Maximum length of @a phmmseq.
   boolean *has_sp;              ///< Mark which phoneme allow short pause for multi-path mode
+  LOGPROB *lr_self_a;		///< Self-loop log prob. of each state for left-to-right word HMM
+  LOGPROB *lr_next_a;		///< Log prob. to the next state of each state for left-to-right word HMM
 #ifdef GRAPHOUT_PRECISE_BOUNDARY
   short *wend_token_frame[2]; ///< Propagating token of word-end frame to detect corresponding end-of-words at word head
   LOGPROB *wend_token_gscore[2]; ///< Propagating token of scores at word-end to detect corresponding end-of-words at word head
@@ -248,6 +268,16 @@ typedef struct __StackDecode__ {
 #endif
   WORD_ID *cnword;		///< Work area for N-gram computation
   WORD_ID *cnwordrev;		///< Work area for N-gram computation
+  int cnlen;			///< Number of context words in @a cnword or @a cnwordrev
+  NGRAM_CONTEXT cnctx;		///< Word context of the hypothesis being expanded, for batch N-gram computation
+  LOGPROB cnp1;			///< Context-only part of backward probability from forward N-gram
+  boolean *cnsel;		///< Work area to mark trellis words to be scored at a frame
+  WORD_ID *cnnword;		///< Work area to hold N-gram word IDs to be scored at a frame
+  int *cnidx;			///< Work area to hold the trellis word index of each in @a cnnword
+  LOGPROB *cnprob;		///< Work area to hold the computed N-gram probabilities
+  int cnalloc;			///< Allocated length of the work areas above
+  WordGraphIndex graph_index;	///< Index of saved graph words on graph generation
+  RecombCache recomb;		///< Hypothesis recombination cache (-recombine)
 
 } StackDecode;
 
@@ -261,6 +291,24 @@ typedef struct {
   LOGPROB (*lmprob)(WORD_INFO *, WORD_ID *, int, WORD_ID, LOGPROB); ///< Pointer to function returning LM probability
 } LMFunc;
 
+/**
+ * Packed Gaussian table of all GMMs for a stream, for batched computation
+ * 
+ */
+typedef struct __gmm_pack__ {
+  int num;			///< Number of packed Gaussians
+  int stride;			///< Row length of @a mean and @a var
+  VECT *mean;			///< Means in dimension-major order [veclen][stride]
+  VECT *var;			///< Inverse variances in dimension-major order [veclen][stride]
+  VECT *init;			///< Initial value of distance accumulator (0 or gconst)
+  VECT *add;			///< Value added to the accumulated distance (gconst or 0)
+  VECT *acc;			///< Work area: accumulated distance of each Gaussian
+  boolean *isnull;		///< TRUE for undefined Gaussians
+  LOGPROB *score;		///< Work area: score of each Gaussian at current frame
+  LOGPROB *sorted;		///< Work area for shared top-K selection
+  int *begin;			///< Index of the first Gaussian of each GMM
+} GMMPack;
+
 /**
  * Work area for GMM calculation
  * 
@@ -281,6 +329,8 @@ typedef struct __gmm_calc__{
   int OP_gprune_num; ///< Number of Gaussians to be computed in Gaussian pruning
   VECT *OP_vec;         ///< Local workarea to hold the input vector of current frame
   short OP_veclen;              ///< Local workarea to hold the length of above
+  GMMPack *pack;		///< Packed Gaussian tables for each stream
+  int pack_topk;		///< Number of Gaussians shared by all GMMs per frame, 0 to disable
   HTK_HMM_Data *max_d;  ///< Hold model of the maximum score
   int max_i;                    ///< Index of max_d
 #ifdef CONFIDENCE_MEASURE
@@ -424,8 +474,9 @@ typedef struct __adin__ {
   int bp;                       ///< Current point to store the next data
   int current_len;              ///< Current length of stored samples
   SP16 *cbuf;           ///< Buffer for flushing cycle buffer just after detecting trigger 
-  boolean down_sample; ///< TRUE if perform down sampling from 48kHz to 16kHz
-  SP16 *buffer48; ///< Another temporary buffer to hold 48kHz inputs
+  boolean down_sample; ///< TRUE if perform down sampling from 48kHz to 16kHz, or resampling by @a rs
+  SP16 *buffer48; ///< Another temporary buffer to hold 48kHz (or @a rs input rate) inputs
+  int buffer48_len; ///< Length of @a buffer48
   int io_rate; ///< frequency rate (should be 3 always for 48/16 conversion
 
   boolean is_valid_data;        ///< TRUE if we are now triggered
@@ -434,6 +485,7 @@ typedef struct __adin__ {
   boolean need_init;    ///< if TRUE, initialize buffer on startup
 
   DS_BUFFER *ds;           ///< Filter buffer for 48-to-16 conversion
+  RESAMPLER *rs;	   ///< Polyphase resampler from -infreq to sfreq
 
   boolean rehash; ///< TRUE is want rehash at rewinding on decoder-based VAD
 
@@ -759,6 +811,87 @@ typedef struct __mfcc_calc__ {
 
 } MFCCCalc;
 
+/**
+ * Scheduler to compute DNN outputs of many recognizers in a batch.
+ * 
+ */
+typedef struct __dnn_batch__ {
+  DNNData *dnn;			///< DNN shared by all attached AMs
+  int maxbatch;			///< Maximum number of frames in a batch
+  int maxwait;			///< Maximum wait time for a batch in microseconds
+  int members;			///< Number of attached AM instances
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t mutex;	///< Lock for the fields below
+  pthread_cond_t cond;		///< Signalled when a batch finishes or a frame comes
+#endif
+  int num;			///< Number of frames waiting in the current batch
+  float **invec;		///< Input vectors of the waiting frames
+  LOGPROB **outcache;		///< Output buffers of the waiting frames
+  int statenum;			///< Number of states to be stored
+  float **run_invec;		///< Input vectors of the batch being computed
+  LOGPROB **run_outcache;	///< Output buffers of the batch being computed
+  boolean busy;			///< TRUE while a batch is being computed
+  unsigned long next_id;	///< ID of the current batch
+  unsigned long done_id;	///< Batches with smaller IDs have been computed
+  /* statistics */
+  unsigned long batches;	///< Number of computed batches
+  unsigned long frames;		///< Number of computed frames
+  unsigned long timeouts;	///< Number of batches started by time out
+} DNNBatch;
+
+/**
+ * Worker threads to run recognition process instances of an engine in
+ * parallel.  Processes sharing an AM are run on the same thread in order.
+ * 
+ */
+typedef struct __sr_pool__ {
+  int num;			///< Number of threads including the caller
+#ifdef HAVE_PTHREAD
+  pthread_t *threads;		///< Worker threads [0..num-2]
+  pthread_mutex_t mutex;	///< Lock for the fields below
+  pthread_cond_t cond_start;	///< Signalled when a new job set is given
+  pthread_cond_t cond_done;	///< Signalled when all jobs are done
+#endif
+  struct __process_am__ **am;	///< AM of each job
+  int jobnum;			///< Number of jobs
+  int jobmax;			///< Allocated length of @a am
+  int next;			///< Next job to be taken
+  int done;			///< Number of finished jobs
+  unsigned long gen;		///< ID of the current job set
+  boolean quit;			///< TRUE to terminate the workers
+  void (*func)(struct __recogprocess__ *, void *); ///< Function to run on each process
+  void *data;			///< User data for @a func
+  struct __Recog__ *recog;	///< Engine instance
+} SRPool;
+
+/**
+ * Background thread to run the 2nd pass of an input segment while the
+ * 1st pass of the next segment proceeds.  The job works on copies of
+ * the process instances, with their own back trellis, stack decoding
+ * work area, result storage and outprob cache.
+ *
+ */
+typedef struct __pass2_async__ {
+#ifdef HAVE_PTHREAD
+  pthread_t thread;		///< Worker thread
+  pthread_mutex_t mutex;	///< Lock for the fields below
+  pthread_cond_t cond;		///< Signalled when a job is given or finished
+#endif
+  boolean running;		///< TRUE while a job is given and not output yet
+  boolean done;			///< TRUE when the worker has finished the job
+  boolean quit;			///< TRUE to terminate the worker
+  boolean warned;		///< TRUE if fallback to synchronous mode was told
+  struct __recogprocess__ *process_list; ///< Copies of the live processes for the job
+  struct __process_am__ *am;	///< Copies of the AMs for the job [amnum]
+  struct __mfcc_calc__ *mfcc;	///< MFCC instances holding a copy of the input of the job [amnum]
+  int amnum;			///< Number of AMs
+  boolean pass2_p;		///< TRUE if any process in the job executes the 2nd pass
+  boolean segment_end;		///< TRUE if segment end should be notified after the result
+  boolean recognition_end;	///< TRUE if recognition end should be notified after the result
+  double start_time;		///< Time when the job was given, at the end of the 1st pass
+  double pass2_time;		///< Time spent by the worker on the job
+} Pass2Async;
+
 /**
  * instance for an AM.
  * 
@@ -797,6 +930,18 @@ typedef struct __process_am__ {
    */
   DNNData *dnn;
 
+  /**
+   * Batch scheduler this AM is attached to, or NULL.  When set,
+   * @a dnn is shared and owned by the scheduler.
+   */
+  DNNBatch *dnn_batch;
+
+  /**
+   * TRUE if the models above are shared with another engine instance
+   * and should not be freed with this instance
+   */
+  boolean shared;
+
   /**
    * pointer to next
    * 
@@ -877,12 +1022,38 @@ typedef struct __process_lm__ {
    */
   boolean global_modified;
 
+  /**
+   * Version number of the global grammar, incremented at each
+   * modification in multigram_update()
+   * 
+   */
+  int global_version;
+
+  /**
+   * Word ID mapping from the previous version of the global grammar
+   * to the current one, used to update the tree lexicon incrementally.
+   * Deleted words are mapped to WORD_INVALID.
+   * 
+   */
+  WORD_ID *lexmap_word;
+  int lexmap_word_num;		///< Length of @a lexmap_word
+  WORD_ID *lexmap_cate;		///< Category ID mapping, as @a lexmap_word
+  int lexmap_cate_num;		///< Length of @a lexmap_cate
+  boolean lexmap_valid;		///< TRUE if lexmap_* maps version @a global_version - 1 to @a global_version
+
   /**
    * LM User function entry point
    * 
    */
   LMFunc lmfunc;
 
+  /**
+   * TRUE if the models and grammars above are shared with another
+   * engine instance.  They are not modified nor freed with this
+   * instance.
+   */
+  boolean shared;
+
   /**
    * pointer to next
    * 
@@ -1050,15 +1221,27 @@ typedef struct __recogprocess__ {
   LOGPROB determine_maxnodescore;
   boolean determined;
   LOGPROB determine_last_wid;
-  boolean have_determine;
 #endif
 
+  /**
+   * TRUE if has something to output at CALLBACK_RESULT_PASS1_DETERMINED.
+   *
+   */
+  boolean have_determine;
+
   /**
    * TRUE if has something to output at CALLBACK_RESULT_PASS1_INTERIM.
    * 
    */
   boolean have_interim;
 
+  /**
+   * Status of the last frame processed by decode_proceed(): 0 on
+   * success, 1 when segmented, -1 on error.
+   * 
+   */
+  int proceed_status;
+
   /**
    * User-defined data hook.  JuliusLib does not concern about its content.
    * 
@@ -1086,6 +1269,13 @@ typedef struct __Recog__ {
    */
   Jconf *jconf;
 
+  /**
+   * TRUE if @a jconf and models are shared with another engine instance
+   * by j_load_all_shared()
+   * 
+   */
+  boolean shared;
+
   /*******************************************/
   /**
    * A/D-in buffers
@@ -1265,6 +1455,18 @@ typedef struct __Recog__ {
    */
   int callback_num;
 
+  /**
+   * Worker threads to run the recognition processes in parallel (-srthreads)
+   * 
+   */
+  SRPool *srpool;
+
+  /**
+   * Worker thread to run the 2nd pass in background (-pass2async)
+   *
+   */
+  Pass2Async *pass2async;
+
   /*******************************************/
 
   /**
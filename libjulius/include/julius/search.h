@@ -167,6 +167,65 @@ seq[seqnum-3] |                      \______             |<--g_prev[0..T-1]
 ===============================================================	      
 */
 
+/// Maximum number of context words to be kept in a recombination key
+#define RECOMB_CTX_MAX 8
+
+/**
+ * <JA>
+ * 第2パスの仮説再結合キャッシュのエントリ. 以降の展開に影響する仮説の
+ * 状態 (言語制約上の文脈，末尾音素，単語トレリス上の位置) をキーとし，
+ * Viterbi 計算の元となった前向きスコアを保持する. 
+ * </JA>
+ * <EN>
+ * Entry of hypothesis recombination cache on the 2nd pass.  The key is
+ * the state of a hypothesis that affects its further expansion (context
+ * on the language constraint, last phone and position on the word
+ * trellis), and it holds the forward scores from which the Viterbi
+ * of the last word was computed.
+ * </EN>
+ */
+typedef struct __recomb_entry__ {
+  unsigned int hash;		///< Hash value of the key
+  WORD_ID ctx[RECOMB_CTX_MAX];	///< Last words of the hypothesis, in backward order
+  short ctxlen;			///< Length of @a ctx
+  int state;			///< (dfa) DFA state ID
+  HMM_Logical *last_ph;		///< Last applied triphone
+  boolean last_ph_sp_attached;	///< Short-pause attachment of @a last_ph (multipath)
+  LOGPROB lscore;		///< N-gram score of the last word
+  short bestt;			///< Best connection frame of the last word
+  short estimated_next_t;	///< Estimated next connection frame
+  TRELLIS_ATOM *tre;		///< Trellis word of the last word
+  LOGPROB *g;			///< Source forward scores of the Viterbi [0..peseqlen-1]
+  struct __recomb_entry__ *hashnext; ///< Next entry in the same bucket
+  struct __recomb_entry__ *lru_prev; ///< More recently used entry
+  struct __recomb_entry__ *lru_next; ///< Less recently used entry
+} RecombEntry;
+
+/**
+ * <JA>
+ * 第2パスの仮説再結合キャッシュ. 入力ごとに確保され，メモリ上限を
+ * 超えると最も長く使われていないエントリから置き換える. 
+ * </JA>
+ * <EN>
+ * Hypothesis recombination cache on the 2nd pass.  It is allocated per
+ * input, and the least recently used entry will be replaced when it
+ * reaches the memory limit.
+ * </EN>
+ */
+typedef struct {
+  RecombEntry *pool;		///< Entry pool
+  LOGPROB *gpool;		///< Score buffer for @a pool
+  int num;			///< Number of entries in @a pool
+  int used;			///< Number of used entries in @a pool
+  RecombEntry **bucket;		///< Hash buckets
+  int size;			///< Number of buckets (power of 2)
+  RecombEntry *lru_head;	///< Most recently used entry
+  RecombEntry *lru_tail;	///< Least recently used entry
+  int lookups;			///< Number of lookups (statistics)
+  int hits;			///< Number of hypotheses found dominated (statistics)
+  int evicts;			///< Number of evicted entries (statistics)
+} RecombCache;
+
 #ifdef USE_MBR
 /**
  * <JA>
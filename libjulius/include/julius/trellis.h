@@ -37,18 +37,37 @@ typedef struct __trellis_atom__ {
   boolean within_context;	///< TRUE if any of its following word was once survived in beam while search
 #endif
   struct __trellis_atom__ *last_tre; ///< Pointer to previous context trellis word
-  struct __trellis_atom__ *next; ///< Temporary link to store generated trellis word on 1st pass
 } TRELLIS_ATOM;
 
+/// Number of trellis words in an arena chunk of backtrellis, in power of 2
+#define BT_CHUNK_BITS 12
+
+/// Access the @a n-th trellis word stored in backtrellis @a bt
+#define BT_ATOM(bt, n) (&((bt)->chunk[(n) >> BT_CHUNK_BITS][(n) & ((1 << BT_CHUNK_BITS) - 1)]))
+
 /**
  * Whole word trellis (aka backtrellis) generated as a result of 1st pass.
+ *
+ * Trellis words are appended to an arena in the order they are stored
+ * on the 1st pass, i.e. in frame order.  The arena chunks are kept and
+ * reused for the following inputs.  After the 1st pass, they are indexed
+ * per frame in ascending order of word IDs, with the word IDs also
+ * stored in separate arrays for binary search on the 2nd pass.
  * 
  */
 typedef struct __backtrellis__ {
   int framelen;			///< Frame length
   int *num;			///< Number of trellis words at frame [t]
-  TRELLIS_ATOM ***rw;		///< List to trellis words at frame [t]: rw[t][0..num[t]]
-  TRELLIS_ATOM *list;		///< Temporary storage point used in 1st pass
+  TRELLIS_ATOM ***rw;		///< List to trellis words at frame [t]: rw[t][0..num[t]], in ascending order of word ID
+  WORD_ID **wid;		///< Word IDs of rw[t][0..num[t]]
+  WORD_ID **nword;		///< N-gram word IDs of trellis words at frame [t] in ascending order, set by bt_sort_rw_ngram()
+  int **nwidx;			///< Index in rw[t] of each word in @a nword
+  TRELLIS_ATOM **chunk;		///< Arena of trellis words: chunk[c][0..(1 << BT_CHUNK_BITS)-1]
+  int chunknum;			///< Number of allocated arena chunks
+  int atomnum;			///< Number of trellis words stored in the arena
+  int totalnum;			///< Number of trellis words indexed by bt_relocate_rw()
+  size_t indexsize;		///< Bytes used by the index of the current input
+  float buildtime;		///< Time in msec used to build the index of the current input
   BMALLOC_BASE *root;		///< memory allocation base for mybmalloc2()
 } BACKTRELLIS;
 
@@ -144,6 +144,28 @@ typedef struct {
   int iw_cache_num;
 #ifdef HASH_CACHE_IW
   WORD_ID *iw_lw_cache; ///< Maps hash cache id [x] to corresponding last word
+  unsigned int *iw_lru;	///< Time of last access of cache id [x], for LRU replacement
+  unsigned int iw_tick;	///< Access counter to give time to @a iw_lru
+#endif
+  int iw_hit;			///< Number of cache hits on the current input (stat)
+  int iw_fill;			///< Number of cache fills on the current input (stat)
+#ifdef UNIGRAM_FACTORING
+  /**
+   * @brief Words on the isolated word-head nodes sorted by N-gram word ID.
+   *
+   * Used to fill the cross-word factoring cache for a last word by
+   * a batch 2-gram computation.  Built at the first use.
+   */
+  WORD_ID *iw_nword;
+  WORD_ID *iw_word;		///< Word ID of each in @a iw_nword
+  int *iw_index;		///< Index in the cross-word factoring cache of each in @a iw_nword
+  LOGPROB *iw_prob;		///< Work area to hold the computed 2-gram probabilities
+  int *iw_nbgn;			///< Beginning index in @a iw_nword of each N-gram word ID [0..max_word_num]
+  WORD_ID *iw_cword;		///< Word ID of each isolated word-head node, in cache order
+  LOGPROB *iw_uni;		///< 1-gram probability of each isolated word-head node, in cache order
+#ifdef CLASS_NGRAM
+  LOGPROB *iw_cprob;		///< Class probability of each isolated word-head node, in cache order
+#endif
 #endif
   
 } LM_PROB_CACHE;
@@ -212,6 +234,7 @@ typedef struct wchmm_info {
   int lmtype;			///< LM type
   int lmvar;			///< LM variant
   boolean category_tree;	///< TRUE if category_tree is used
+  int gram_version;		///< Version of global grammar the tree was built from (multi-gram)
   HTK_HMM_INFO *hmminfo;	///< HMM definitions used to construct this lexicon
   NGRAM_INFO *ngram;		///< N-gram used to construct this lexicon
   DFA_INFO *dfa;		///< Grammar used to construct this lexicon
@@ -256,6 +279,7 @@ typedef struct wchmm_info {
 #ifdef PASS1_IWCD
   APATNODE *lcdset_category_root; ///< Index of lexicon-dependent category-aware pseudo phone set when used on Julian
   BMALLOC_BASE *lcdset_mroot;
+  HMM_CTX_TABLE lcdset_category_index; ///< Phone context index of the category-aware pseudo phone set, keyed by (lc, c, category)
 #endif /* PASS1_IWCD */
 
   HMMWork *hmmwrk;		///< Work area for HMM computation in wchmm
@@ -201,8 +201,14 @@ adin_setup_param(ADIn *adin, Jconf *jconf)
   adin->cbuf = (SP16 *)mymalloc(sizeof(SP16) * adin->c_length);
   adin->swapbuf = (SP16 *)mymalloc(sizeof(SP16) * adin->sbsize);
   if (adin->down_sample) {
-    adin->io_rate = 3;		/* 48 / 16 (fixed) */
-    adin->buffer48 = (SP16 *)mymalloc(sizeof(SP16) * MAXSPEECHLEN * adin->io_rate);
+    if (adin->rs) {
+      /* enough for MAXSPEECHLEN outputs, with margin for filter history */
+      adin->buffer48_len = (long)MAXSPEECHLEN * adin->rs->down / adin->rs->up + adin->rs->taps + 1;
+    } else {
+      adin->io_rate = 3;		/* 48 / 16 (fixed) */
+      adin->buffer48_len = MAXSPEECHLEN * adin->io_rate;
+    }
+    adin->buffer48 = (SP16 *)mymalloc(sizeof(SP16) * adin->buffer48_len);
   }
   if (adin->adin_cut_on) {
     init_count_zc_e(&(adin->zc), adin->c_length);
@@ -467,7 +473,12 @@ adin_cut(int (*ad_process)(SP16 *, int, Recog *), int (*ad_check)(Recog *), Reco
 	receive end ack from tcpip client), it will return -1.
 	If error, returns -2. If the device requests segmentation, returns -3.
       */
-      if (a->down_sample) {
+      if (a->rs) {
+	/* get samples of device rate, as many as the output fits */
+	cnt = resample_inlen(a->rs, a->bpmax - a->bp);
+	if (cnt > a->buffer48_len) cnt = a->buffer48_len;
+	cnt = (*(a->ad_read))(a->buffer48, cnt);
+      } else if (a->down_sample) {
 	/* get 48kHz samples to temporal buffer */
 	cnt = (*(a->ad_read))(a->buffer48, (a->bpmax - a->bp) * a->io_rate);
       } else {
@@ -498,8 +509,12 @@ adin_cut(int (*ad_process)(SP16 *, int, Recog *), int (*ad_check)(Recog *), Reco
 	if (a->bp == 0) break;
       }
       if (a->down_sample && cnt != 0) {
-	/* convert to 16kHz  */
-	cnt = ds48to16(&(a->buffer[a->bp]), a->buffer48, cnt, a->bpmax - a->bp, a->ds);
+	/* convert to 16kHz, or to the target rate */
+	if (a->rs) {
+	  cnt = resample(&(a->buffer[a->bp]), a->buffer48, cnt, a->bpmax - a->bp, a->rs);
+	} else {
+	  cnt = ds48to16(&(a->buffer[a->bp]), a->buffer48, cnt, a->bpmax - a->bp, a->ds);
+	}
 	if (cnt < 0) {		/* conversion error */
 	  jlog("ERROR: adin_cut: error in down sampling\n");
 	  end_status = -1;
@@ -1442,6 +1457,7 @@ adin_begin(ADIn *a, char *file_or_dev_name)
     a->total_captured_len = 0;
     a->last_trigger_len = 0;
     if (a->need_zmean) zmean_reset();
+    if (a->rs) resample_reset(a->rs);
     if (a->ad_begin != NULL) return(a->ad_begin(file_or_dev_name));
   }
   return TRUE;
@@ -1496,6 +1512,10 @@ adin_free_param(Recog *recog)
     ds48to16_free(a->ds);
     a->ds = NULL;
   }
+  if (a->rs) {
+    resample_free(a->rs);
+    a->rs = NULL;
+  }
   if (a->adin_cut_on) {
     free_count_zc_e(&(a->zc));
   }
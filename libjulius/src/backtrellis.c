@@ -80,19 +80,28 @@ bt_init(BACKTRELLIS *bt)
 {
   bt->num  = NULL;
   bt->rw   = NULL;
-  bt->list = NULL;
+  bt->wid  = NULL;
+  bt->nword = NULL;
+  bt->nwidx = NULL;
+  bt->chunk = NULL;
+  bt->chunknum = 0;
+  bt->atomnum = 0;
+  bt->totalnum = 0;
+  bt->indexsize = 0;
+  bt->buildtime = 0.0;
   bt->root = NULL;
 }
 
 /** 
  * <JA>
  * 次回の認識用に 単語トレリス 構造体を準備する (認識開始時ごとに実行). 
+ * トレリス単語の領域は解放せずに再利用する. 
  * 
  * @param bt [in] 対象とする単語トレリス構造体へのポインタ
  * </JA>
  * <EN>
  * Prepare backtrellis for the next input (called at beginning of each
- * speech segment).
+ * speech segment).  The arena of trellis words is kept for reuse.
  * 
  * @param bt [in] pointer to the word trellis structure
  * </EN>
@@ -109,8 +118,16 @@ bt_prepare(BACKTRELLIS *bt)
   /* reset entry point */
   bt->num = NULL;
   bt->rw = NULL;
-  bt->list = NULL;
+  bt->wid = NULL;
+  bt->nword = NULL;
+  bt->nwidx = NULL;
   bt->root = NULL;
+
+  /* rewind the arena */
+  bt->atomnum = 0;
+  bt->totalnum = 0;
+  bt->indexsize = 0;
+  bt->buildtime = 0.0;
 }  
 
 /** 
@@ -130,16 +147,22 @@ bt_prepare(BACKTRELLIS *bt)
 void
 bt_free(BACKTRELLIS *bt)
 {
+  int c;
+
   if (bt->root) mybfree2(&(bt->root));
+  for(c = 0; c < bt->chunknum; c++) free(bt->chunk[c]);
+  if (bt->chunk) free(bt->chunk);
   free(bt);
 }
 
 /** 
  * <EN>
- * Allocate a new trellis word atom.
+ * Allocate a new trellis word atom at the tail of the arena.  The atom
+ * is kept by the following bt_store().
  * </EN>
  * <JA>
- * トレリス単語を新たに割り付ける. 
+ * トレリス単語を領域の末尾に新たに割り付ける. 続く bt_store() で
+ * 確定される. 
  * </JA>
  * 
  * @param bt [out] pointer to the word trellis structure.
@@ -153,10 +176,17 @@ bt_free(BACKTRELLIS *bt)
 TRELLIS_ATOM *
 bt_new(BACKTRELLIS *bt)
 {
-  TRELLIS_ATOM *new;
+  int c;
 
-  new = (TRELLIS_ATOM *)mybmalloc2(sizeof(TRELLIS_ATOM), &(bt->root));
-  return new;
+  c = bt->atomnum >> BT_CHUNK_BITS;
+  if (c >= bt->chunknum) {
+    if (c % 16 == 0) {
+      bt->chunk = (TRELLIS_ATOM **)myrealloc(bt->chunk, sizeof(TRELLIS_ATOM *) * (c + 16));
+    }
+    bt->chunk[c] = (TRELLIS_ATOM *)mymalloc(sizeof(TRELLIS_ATOM) << BT_CHUNK_BITS);
+    bt->chunknum++;
+  }
+  return(BT_ATOM(bt, bt->atomnum));
 }
 
 
@@ -166,7 +196,8 @@ bt_new(BACKTRELLIS *bt)
  * 第1パスで出現したトレリス単語（単語終端のトレリス情報）を格納する. 
  *
  * ここでは格納だけ行い，第1パス終了後に bt_relocate_rw() で
- * フレーム順に再配置する. 
+ * フレーム順に再配置する. @a tatom は直前の bt_new() で割り付けられた
+ * ものでなければならない. 
  * 
  * @param bt [i/o] トレリス単語を格納するバックトレリス構造体
  * @param tatom [in] 出現したトレリス単語へのポインタ
@@ -176,7 +207,8 @@ bt_new(BACKTRELLIS *bt)
  *
  * This function just store the new atom into backtrellis.
  * They will be re-located per frame after 1st pass for quick access
- * in the 2nd pass.
+ * in the 2nd pass.  @a tatom should be the one given by the last
+ * bt_new().
  * 
  * @param bt [i/o] backtrellis structure to store the trellis word
  * @param tatom [in] the trellis word to be stored
@@ -193,19 +225,101 @@ bt_store(BACKTRELLIS *bt, TRELLIS_ATOM *tatom)
   tatom->within_context = FALSE;
   tatom->within_wordgraph = FALSE;
 #endif
-  tatom->next = bt->list;
-  bt->list = tatom;
+  bt->atomnum++;
+}
+
+/** 
+ * <JA>
+ * 確定した単語までのトレリス単語を捨てる. @a tre の終端フレームまでに
+ * 終わる単語を捨て，それ以降の単語のフレームを @a tre の終端の次が
+ * 0 になるようにずらし，累積スコアから @a base を引く. 
+ * @a tre を指す単語は代わりに @a root を指す. @a tre から派生しない
+ * 単語も，途絶えた仮説上にあるので捨てる. 
+ * 捨てた単語のみを含むチャンクは，アリーナの末尾に回して再利用する. 
+ * 
+ * @param bt [i/o] 単語トレリス構造体
+ * @param tre [in] 確定した最後のトレリス単語
+ * @param root [in] @a tre の複製
+ * @param base [in] 累積スコアから引く値
+ * </JA>
+ * <EN>
+ * Discard trellis words up to a committed word.  The words ending at or
+ * before the end frame of @a tre are discarded, and the frames of the
+ * rest are shifted so that the frame next to the end of @a tre becomes
+ * 0, and @a base is subtracted from their accumulated scores.  Words
+ * linked to @a tre are re-linked to @a root, and the words not derived
+ * from @a tre are also discarded as they are on dead paths.  The chunks
+ * that hold only discarded words are moved to the tail of the arena for
+ * reuse.
+ * 
+ * @param bt [i/o] word trellis structure
+ * @param tre [in] the last committed trellis word
+ * @param root [in] copy of @a tre
+ * @param base [in] value to be subtracted from the accumulated scores
+ * </EN>
+ *
+ * @callergraph
+ * @callgraph
+ * 
+ */
+void
+bt_evict(BACKTRELLIS *bt, TRELLIS_ATOM *tre, TRELLIS_ATOM *root, LOGPROB base)
+{
+  TRELLIS_ATOM *a;
+  TRELLIS_ATOM **tmp;
+  int n, m, c, shift;
+
+  shift = tre->endtime + 1;
+
+  /* live atoms are stored in time frame order.  Atoms discarded by
+     the former calls are left among them with negative end frame */
+  for (m = bt->atomnum; m > 0; m--) {
+    a = BT_ATOM(bt, m - 1);
+    if (a->endtime >= 0 && a->endtime < shift) break;
+  }
+  /* words not derived from tre are on dead paths: discard them */
+  for (n = m; n < bt->atomnum; n++) {
+    a = BT_ATOM(bt, n);
+    if (a->endtime < 0) continue;
+    if (a->last_tre != tre && a->last_tre->endtime < shift) a->endtime = -1;
+  }
+  for (n = m; n < bt->atomnum; n++) {
+    a = BT_ATOM(bt, n);
+    if (a->endtime < 0) continue;
+    if (a->last_tre == tre) a->last_tre = root;
+    a->backscore -= base;
+    a->begintime -= shift;
+    a->endtime -= shift;
+  }
+  /* mark the rest in the same chunk as discarded */
+  c = m >> BT_CHUNK_BITS;
+  for (n = m - 1; n >= (c << BT_CHUNK_BITS); n--) {
+    BT_ATOM(bt, n)->endtime = -1;
+  }
+
+  /* rotate the chunks of discarded atoms to the tail */
+  if (c > 0) {
+    tmp = (TRELLIS_ATOM **)mymalloc(sizeof(TRELLIS_ATOM *) * c);
+    memcpy(tmp, bt->chunk, sizeof(TRELLIS_ATOM *) * c);
+    memmove(bt->chunk, &(bt->chunk[c]), sizeof(TRELLIS_ATOM *) * (bt->chunknum - c));
+    memcpy(&(bt->chunk[bt->chunknum - c]), tmp, sizeof(TRELLIS_ATOM *) * c);
+    free(tmp);
+    bt->atomnum -= c << BT_CHUNK_BITS;
+  }
 }
 
 /** 
  * <JA>
- * 第1パス終了後, 格納された単語トレリス情報をフレーム順に再配置する. 
+ * 第1パス終了後, 格納された単語トレリス情報をフレームごとに単語IDの
+ * 昇順で再配置する. 全トレリス単語を単語IDで計数ソートした後，
+ * フレームごとに安定に振り分ける. 
  * 
  * @param bt [i/o] 単語トレリス構造体
  * </JA>
  * <EN>
- * Re-locate the stored atom lists per frame (will be called after the
- * 1st pass).
+ * Re-locate the stored atoms per frame in ascending order of word IDs
+ * (will be called after the 1st pass).  All the atoms are counting-sorted
+ * by word ID, and then distributed to frames keeping the order.
  * 
  * @param bt [i/o] word trellis structure
  * </EN>
@@ -218,24 +332,34 @@ void
 bt_relocate_rw(BACKTRELLIS *bt)
 {
   TRELLIS_ATOM *tre;
-  int t;
-  int totalnum, n;
-  TRELLIS_ATOM **tmp;
+  int t, i, n;
+  int totalnum, maxwid;
+  int *count;
+  TRELLIS_ATOM **tmp, **rwlist;
+  WORD_ID *widlist;
+  clock_t start;
 
+  bt->totalnum = 0;
   if (bt->framelen == 0) {
     bt->num = NULL;
     return;
   }
 
+  start = clock();
+
   bt->num = (int *)mybmalloc2(sizeof(int) * bt->framelen, &(bt->root));
 
   /* count number of trellis atom (= survived word end) for each frame */
   for (t=0;t<bt->framelen;t++) bt->num[t] = 0;
   totalnum = 0;
-  for (tre=bt->list;tre;tre=tre->next) {
+  maxwid = 0;
+  for (n=0;n<bt->atomnum;n++) {
+    tre = BT_ATOM(bt, n);
     /* the last frame (when triggered from sp to non-sp) should be discarded */
-    if (tre->endtime >= bt->framelen) continue;
+    /* atoms discarded by bt_evict() have negative end frame */
+    if (tre->endtime < 0 || tre->endtime >= bt->framelen) continue;
     bt->num[tre->endtime]++;
+    if (maxwid < tre->wid) maxwid = tre->wid;
     totalnum++;
   }
   /* if no atom found, return here with all bt->num[t] set to 0 */
@@ -244,29 +368,55 @@ bt_relocate_rw(BACKTRELLIS *bt)
     return;
   }
   
+  /* sort all the atoms by word ID */
+  count = (int *)mymalloc(sizeof(int) * (maxwid + 1));
+  memset(count, 0, sizeof(int) * (maxwid + 1));
+  for (n=0;n<bt->atomnum;n++) {
+    tre = BT_ATOM(bt, n);
+    if (tre->endtime < 0 || tre->endtime >= bt->framelen) continue;
+    count[tre->wid]++;
+  }
+  for (i=0, n=0;i<=maxwid;i++) {
+    t = count[i];
+    count[i] = n;
+    n += t;
+  }
+  tmp = (TRELLIS_ATOM **)mymalloc(sizeof(TRELLIS_ATOM *) * totalnum);
+  for (n=0;n<bt->atomnum;n++) {
+    tre = BT_ATOM(bt, n);
+    if (tre->endtime < 0 || tre->endtime >= bt->framelen) continue;
+    tmp[count[tre->wid]++] = tre;
+  }
+  free(count);
+
   /* allocate area */
   bt->rw  = (TRELLIS_ATOM ***)mybmalloc2(sizeof(TRELLIS_ATOM **) * bt->framelen, &(bt->root));
-  tmp = (TRELLIS_ATOM **)mybmalloc2(sizeof(TRELLIS_ATOM *) * totalnum, &(bt->root));
+  bt->wid = (WORD_ID **)mybmalloc2(sizeof(WORD_ID *) * bt->framelen, &(bt->root));
+  rwlist = (TRELLIS_ATOM **)mybmalloc2(sizeof(TRELLIS_ATOM *) * totalnum, &(bt->root));
+  widlist = (WORD_ID *)mybmalloc2(sizeof(WORD_ID) * totalnum, &(bt->root));
   n = 0;
   for (t=0;t<bt->framelen;t++) {
-    if (bt->num[t] > 0) {
-      bt->rw[t] = (TRELLIS_ATOM **)&(tmp[n]);
-      n += bt->num[t];
-    }
+    bt->rw[t] = &(rwlist[n]);
+    bt->wid[t] = &(widlist[n]);
+    n += bt->num[t];
   }
-  /* then store the atoms */
+  /* then distribute the atoms to frames, keeping the order of word ID */
   for (t=0;t<bt->framelen;t++) bt->num[t] = 0;
-  for (tre=bt->list;tre;tre=tre->next) {
-    /* the last frame (when triggered from sp to non-sp) should be discarded */
-    if (tre->endtime >= bt->framelen) continue;
+  for (n=0;n<totalnum;n++) {
+    tre = tmp[n];
     t = tre->endtime;
-    
     bt->rw[t][bt->num[t]] = tre;
+    bt->wid[t][bt->num[t]] = tre->wid;
     bt->num[t]++;
   }
+  free(tmp);
+
+  bt->totalnum = totalnum;
+  bt->indexsize = (sizeof(int) + sizeof(TRELLIS_ATOM **) + sizeof(WORD_ID *)) * bt->framelen + (sizeof(TRELLIS_ATOM *) + sizeof(WORD_ID)) * totalnum;
+  bt->buildtime += (float)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
 }
 
-
+
 /* 以下の関数は bt_relocate_rw 実行後にのみ使用可能となる. */
 /* functions below this line should be called after bt_relocate_rw() */
 
@@ -415,49 +565,30 @@ bt_discount_lm(BACKTRELLIS *bt)
   }
 }
 
-/** 
- * <JA>
- * bt_sort_rw()用のqsortコールバック. 
- * 
- * @param a [in] 要素１
- * @param b [in] 要素２
- * 
- * @return 昇順ソートに必要な値
- * </JA>
- * <EN>
- * qsort callback for bt_sort_rw().
- * 
- * @param a [in] first element
- * @param b [in] second element
- * 
- * @return a value needed to do upward sort.
- * </EN>
- *
- * 
- */
-static int
-compare_wid(TRELLIS_ATOM **a, TRELLIS_ATOM **b)
-{
-  if ((*a)->wid > (*b)->wid) return 1;
-  if ((*a)->wid < (*b)->wid) return -1;
-  return 0;
-}
+/// Location of a trellis word in the index, for sorting
+typedef struct {
+  int t;			///< Frame
+  int idx;			///< Index in rw[t]
+} NW_INDEX;
 
 /** 
  * <JA>
- * bt_relocate_rw() 終了後, 高速アクセスのために
- * バックトレリス構造体内のトレリス単語をフレームごとに
- * 単語IDでソートしておく. 
+ * bt_relocate_rw() 終了後, 第2パスの N-gram 一括計算のために，
+ * 各フレームのトレリス単語を N-gram 上の単語IDの順に並べた索引を作る. 
+ * bt_relocate_rw() と同様に計数ソートで作成する. 
  * 
  * @param bt [i/o] 単語トレリス構造体
+ * @param winfo [in] 単語辞書
  * 
  * </JA>
  * <EN>
- * Sort the trellis words in the backtrellis by the word IDs per each frame,
- * for rapid access on the 2nd pass.  This should be called just after
- * bt_relocate_rw() was called.
+ * Build an index of the trellis words per frame in the order of their
+ * N-gram word IDs, for batch N-gram computation on the 2nd pass.  As in
+ * bt_relocate_rw(), it is built by counting sort.  This should be called
+ * after bt_relocate_rw().
  * 
  * @param bt [i/o] word trellis structure
+ * @param winfo [in] word dictionary
  * 
  * </EN>
  * @callergraph
@@ -465,20 +596,81 @@ compare_wid(TRELLIS_ATOM **a, TRELLIS_ATOM **b)
  * 
  */
 void
-bt_sort_rw(BACKTRELLIS *bt)
+bt_sort_rw_ngram(BACKTRELLIS *bt, WORD_INFO *winfo)
 {
-  int t;
+  int t, i, n, k, maxnw;
+  int *count, *fill;
+  NW_INDEX *tmp;
+  WORD_ID *nwordlist;
+  int *nwidxlist;
+  clock_t start;
 
   if (bt->num == NULL) return;
 
+  start = clock();
+
+  /* sort all the atoms by N-gram word ID, keeping the order of frame
+     and index in a tie */
+  maxnw = 0;
+  for (t=0;t<bt->framelen;t++) {
+    for (i=0;i<bt->num[t];i++) {
+      if (maxnw < winfo->wton[bt->wid[t][i]]) maxnw = winfo->wton[bt->wid[t][i]];
+    }
+  }
+  count = (int *)mymalloc(sizeof(int) * (maxnw + 1));
+  memset(count, 0, sizeof(int) * (maxnw + 1));
+  for (t=0;t<bt->framelen;t++) {
+    for (i=0;i<bt->num[t];i++) count[winfo->wton[bt->wid[t][i]]]++;
+  }
+  for (k=0, n=0;k<=maxnw;k++) {
+    i = count[k];
+    count[k] = n;
+    n += i;
+  }
+  tmp = (NW_INDEX *)mymalloc(sizeof(NW_INDEX) * bt->totalnum);
+  for (t=0;t<bt->framelen;t++) {
+    for (i=0;i<bt->num[t];i++) {
+      n = count[winfo->wton[bt->wid[t][i]]]++;
+      tmp[n].t = t;
+      tmp[n].idx = i;
+    }
+  }
+  free(count);
+
+  /* distribute them to frames */
+  bt->nword = (WORD_ID **)mybmalloc2(sizeof(WORD_ID *) * bt->framelen, &(bt->root));
+  bt->nwidx = (int **)mybmalloc2(sizeof(int *) * bt->framelen, &(bt->root));
+  nwordlist = (WORD_ID *)mybmalloc2(sizeof(WORD_ID) * bt->totalnum, &(bt->root));
+  nwidxlist = (int *)mybmalloc2(sizeof(int) * bt->totalnum, &(bt->root));
+  fill = (int *)mymalloc(sizeof(int) * bt->framelen);
+  n = 0;
   for (t=0;t<bt->framelen;t++) {
-    qsort(bt->rw[t], bt->num[t], sizeof(TRELLIS_ATOM *),
-	  (int (*)(const void *,const void *))compare_wid);
+    if (bt->num[t] == 0) {
+      bt->nword[t] = NULL;
+      bt->nwidx[t] = NULL;
+    } else {
+      bt->nword[t] = &(nwordlist[n]);
+      bt->nwidx[t] = &(nwidxlist[n]);
+    }
+    fill[t] = 0;
+    n += bt->num[t];
   }
+  for (n=0;n<bt->totalnum;n++) {
+    t = tmp[n].t;
+    i = tmp[n].idx;
+    bt->nword[t][fill[t]] = winfo->wton[bt->wid[t][i]];
+    bt->nwidx[t][fill[t]] = i;
+    fill[t]++;
+  }
+  free(fill);
+  free(tmp);
+
+  bt->indexsize += (sizeof(WORD_ID *) + sizeof(int *)) * bt->framelen + (sizeof(WORD_ID) + sizeof(int)) * bt->totalnum;
+  bt->buildtime += (float)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
 }
 
-/* 以下の関数は事前にbt_sort_rw() が呼ばれていること(第2パス用) */
-/* functions below should be called after bt_sort_rw() */
+/* 以下の関数は事前にbt_relocate_rw() が呼ばれていること(第2パス用) */
+/* functions below should be called after bt_relocate_rw() */
 
 /** 
  * <JA>
@@ -524,14 +716,15 @@ bt_binsearch_atom(BACKTRELLIS *bt, int t, WORD_ID wkey)
   right = bt->num[t] - 1;
   while (left < right) {
     mid = (left + right) / 2;
-    if ((bt->rw[t][mid])->wid < wkey) {
+    if (bt->wid[t][mid] < wkey) {
       left = mid + 1;
     } else {
       right = mid;
     }
   }
-  tmp = bt->rw[t][left];
-  if (tmp->wid == wkey) {
+  /* compare on the word ID array, not to touch the atoms on miss */
+  if (bt->wid[t][left] == wkey) {
+    tmp = bt->rw[t][left];
 #ifdef WPAIR
     /* same word with different context will be found:
        most likely one will be returned */
@@ -539,8 +732,8 @@ bt_binsearch_atom(BACKTRELLIS *bt, int t, WORD_ID wkey)
     maxtre = NULL;
     i = left;
     while (i >= 0) {
+      if (bt->wid[t][i] != wkey) break;
       tmp = bt->rw[t][i];
-      if (tmp->wid != wkey) break;
 #ifdef WORD_GRAPH
       /* only words on a graph path should be counted */
       if (!tmp->within_wordgraph) {
@@ -555,8 +748,8 @@ bt_binsearch_atom(BACKTRELLIS *bt, int t, WORD_ID wkey)
     }
     i = left;
     while (i < bt->num[t]) {
+      if (bt->wid[t][i] != wkey) break;
       tmp = bt->rw[t][i];
-      if (tmp->wid != wkey) break;
 #ifdef WORD_GRAPH
       /* only words on a graph path should be counted */
       if (!tmp->within_wordgraph) {
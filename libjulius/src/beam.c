@@ -153,6 +153,7 @@ generate_lattice(int frame, RecogProcess *r)
 #endif
       new->saved = FALSE;
       new->graph_cm = 0.0;
+      new->amscore = LOG_ZERO;
       new->mark = FALSE;
 
       new->next = r->result.wg1;
@@ -756,10 +757,10 @@ determine_word(RecogProcess *r, int t, TRELLIS_ATOM *tremax, LOGPROB thres, int
   /* get confidence score of the maximum word hypothesis */
 /* 
  *   sum = 0.0;
- *   tre = recog->backtrellis->list;
- *   while (tre != NULL && tre->endtime == t) {
+ *   for (n = recog->backtrellis->atomnum - 1; n >= 0; n--) {
+ *     tre = BT_ATOM(recog->backtrellis, n);
+ *     if (tre->endtime != t) break;
  *     sum += pow(10, recog->jconf->annotate.cm_alpha * (tre->backscore - tremax->backscore));
- *     tre = tre->next;
  *   }
  *   cm = 1.0 / sum;
  */
@@ -820,20 +821,21 @@ determine_word(RecogProcess *r, int t, TRELLIS_ATOM *tremax, LOGPROB thres, int
 static void
 check_determine_word(RecogProcess *r, int t)
 {
+  int n;
   TRELLIS_ATOM *tre;
   TRELLIS_ATOM *tremax;
   LOGPROB maxscore;
 
-  /* bt->list is ordered by time frame */
+  /* atoms in backtrellis are stored in time frame order */
   maxscore = LOG_ZERO;
   tremax = NULL;
-  tre = r->backtrellis->list;
-  while (tre != NULL && tre->endtime == t) {
+  for (n = r->backtrellis->atomnum - 1; n >= 0; n--) {
+    tre = BT_ATOM(r->backtrellis, n);
+    if (tre->endtime != t) break;
     if (maxscore < tre->backscore) {
       maxscore = tre->backscore;
       tremax = tre;
     }
-    tre = tre->next;
   }
 
   r->result.status = J_RESULT_STATUS_SUCCESS;
@@ -875,22 +877,23 @@ check_determine_word(RecogProcess *r, int t)
 static void
 bt_current_max(RecogProcess *r, int t)
 {
+  int n;
   int wordlen;
   TRELLIS_ATOM *tre;
   TRELLIS_ATOM *tremax;
   LOGPROB maxscore;
   LOGPROB lscore;
 
-  /* bt->list is ordered by time frame */
+  /* atoms in backtrellis are stored in time frame order */
   maxscore = LOG_ZERO;
   tremax = NULL;
-  tre = r->backtrellis->list;
-  while (tre != NULL && tre->endtime == t) {
+  for (n = r->backtrellis->atomnum - 1; n >= 0; n--) {
+    tre = BT_ATOM(r->backtrellis, n);
+    if (tre->endtime != t) break;
     if (maxscore < tre->backscore) {
       maxscore = tre->backscore;
       tremax = tre;
     }
-    tre = tre->next;
   }
 
   r->result.status = J_RESULT_STATUS_SUCCESS;
@@ -935,22 +938,23 @@ static void
 bt_current_max_word(RecogProcess *r, int t)
 {
 
+  int n;
   TRELLIS_ATOM *tre;
   TRELLIS_ATOM *tremax;
   LOGPROB maxscore;
   WORD_ID w;
 
-  /* bt->list は時間順に格納されている */
-  /* bt->list is order by time */
+  /* bt のトレリス単語は時間順に格納されている */
+  /* atoms in backtrellis are stored in time frame order */
   maxscore = LOG_ZERO;
   tremax = NULL;
-  tre = r->backtrellis->list;
-  while (tre != NULL && tre->endtime == t) {
+  for (n = r->backtrellis->atomnum - 1; n >= 0; n--) {
+    tre = BT_ATOM(r->backtrellis, n);
+    if (tre->endtime != t) break;
     if (maxscore < tre->backscore) {
       maxscore = tre->backscore;
       tremax = tre;
     }
-    tre = tre->next;
   }
 
   if (maxscore != LOG_ZERO) {
@@ -1792,6 +1796,178 @@ init_nodescore(HTK_Param *param, RecogProcess *r)
 
 }
 
+/*************************************/
+/* 音素先読みによる枝刈り            */
+/* pruning by phone lookahead        */
+/*************************************/
+
+/** 
+ * <JA>
+ * 音素先読み用のワークエリアを準備する. 木構造化辞書の各音素先頭ノードに
+ * 対応する GS HMM の音素IDを割り付ける. 
+ * 
+ * @param r [i/o] 音声認識処理インスタンス
+ * </JA>
+ * <EN>
+ * Prepare work area for phone lookahead.  The GS HMM phone ID is
+ * assigned to each phone head node on the tree lexicon.
+ * 
+ * @param r [i/o] recognition process instance
+ * </EN>
+ */
+static void
+lookahead_init(RecogProcess *r)
+{
+  FSBeam *d;
+  WCHMM_INFO *wchmm;
+  WORD_INFO *winfo;
+  HMMWork *wrk;
+  WORD_ID w;
+  int i, p, n;
+
+  d = &(r->pass1);
+  wchmm = r->wchmm;
+  winfo = wchmm->winfo;
+  wrk = &(r->am->hmmwrk);
+
+  d->la_frames = r->config->pass1.lookahead_frames;
+  d->la_width = r->config->pass1.lookahead_width;
+  if (d->la_frames <= 0) {
+    d->la_frames = 0;
+    return;
+  }
+  if (r->am->hmm_gs == NULL) {
+    jlog("WARNING: %02d %s: phone lookahead requires GS HMM (-gshmm), disabled\n", r->config->id, r->config->name);
+    d->la_frames = 0;
+    return;
+  }
+  if (wchmm->hmminfo->multipath) {
+    jlog("WARNING: %02d %s: phone lookahead is not supported on multi-path mode, disabled\n", r->config->id, r->config->name);
+    d->la_frames = 0;
+    return;
+  }
+
+  if (d->la_phone == NULL || d->la_nodenum != wchmm->n || d->la_version != wchmm->gram_version || d->la_phonenum != wrk->gs_phone_num) {
+    n = gms_lookahead_init(wrk);
+    if (d->la_phone != NULL) {
+      free(d->la_phone);
+      free(d->la_frame_max);
+      free(d->la_frame_time);
+      free(d->la_score);
+    }
+    d->la_nodenum = wchmm->n;
+    d->la_version = wchmm->gram_version;
+    d->la_phonenum = n;
+    d->la_phone = (short *)mymalloc(sizeof(short) * d->la_nodenum);
+    for (i = 0; i < d->la_nodenum; i++) d->la_phone[i] = -1;
+    for (w = 0; w < winfo->num; w++) {
+      for (i = 0; i < winfo->wlen[w]; i++) {
+	if ((p = gms_lookahead_phone(wrk, winfo->wseq[w][i])) < 0) continue;
+	d->la_phone[wchmm->offset[w][i]] = p;
+      }
+    }
+    d->la_frame_max = (LOGPROB *)mymalloc(sizeof(LOGPROB) * d->la_phonenum * d->la_frames);
+    d->la_frame_time = (int *)mymalloc(sizeof(int) * d->la_frames);
+    d->la_score = (LOGPROB *)mymalloc(sizeof(LOGPROB) * d->la_phonenum);
+  }
+
+  for (i = 0; i < d->la_frames; i++) d->la_frame_time[i] = -1;
+  d->la_thres = LOG_ZERO;
+  d->la_pruned = 0;
+  d->la_scored = 0;
+}
+
+/** 
+ * <JA>
+ * 現フレームの音素先読みスコアと枝刈り閾値を求める. 先読みの各フレームの
+ * GS HMM スコアは一度だけ計算される. 
+ * 
+ * @param d [i/o] 第1パスワークエリア
+ * @param wrk [i/o] HMM計算用ワークエリア
+ * @param t [in] 現在のフレーム
+ * @param param [in] 入力ベクトル列
+ * </JA>
+ * <EN>
+ * Compute phone lookahead scores and pruning threshold for the current
+ * frame.  GS HMM scores of each lookahead frame are computed only once.
+ * 
+ * @param d [i/o] work area for the 1st pass
+ * @param wrk [i/o] HMM computation work area
+ * @param t [in] current frame
+ * @param param [in] input vectors
+ * </EN>
+ */
+static void
+lookahead_prepare(FSBeam *d, HMMWork *wrk, int t, HTK_Param *param)
+{
+  int tt, end, slot, p, j;
+  LOGPROB *fmax;
+  LOGPROB best, x;
+  TOKEN2 *tk;
+
+  d->la_thres = LOG_ZERO;
+  if (t >= param->samplenum) return;
+
+  for (p = 0; p < d->la_phonenum; p++) d->la_score[p] = 0.0;
+  end = t + d->la_frames;
+  if (end > param->samplenum) end = param->samplenum;
+  for (tt = t; tt < end; tt++) {
+    slot = tt % d->la_frames;
+    fmax = &(d->la_frame_max[slot * d->la_phonenum]);
+    if (d->la_frame_time[slot] != tt) {
+      gms_lookahead_frame(wrk, param, tt, fmax);
+      d->la_frame_time[slot] = tt;
+    }
+    for (p = 0; p < d->la_phonenum; p++) d->la_score[p] += fmax[p];
+  }
+  x = LOG_ZERO;
+  for (p = 0; p < d->la_phonenum; p++) {
+    if (x < d->la_score[p]) x = d->la_score[p];
+  }
+
+  /* best score at previous frame */
+  best = LOG_ZERO;
+  for (j = d->n_start; j <= d->n_end; j++) {
+    tk = &(d->tlist[d->tl][d->tindex[d->tl][j]]);
+    if (best < tk->score) best = tk->score;
+  }
+  if (best <= LOG_ZERO) return;
+
+  d->la_thres = best + x - d->la_width;
+}
+
+/** 
+ * <JA>
+ * 音素先頭ノードへの遷移を先読みスコアで枝刈りするか判定する. 
+ * 
+ * @param d [i/o] 第1パスワークエリア
+ * @param node [in] 遷移先ノード
+ * @param score [in] 遷移後のスコア（出力確率を含まない）
+ * 
+ * @return 枝刈りする場合 TRUE. 
+ * </JA>
+ * <EN>
+ * Check if a transition to a phone head node should be pruned by
+ * phone lookahead.
+ * 
+ * @param d [i/o] work area for the 1st pass
+ * @param node [in] destination node
+ * @param score [in] score after transition, without output probability
+ * 
+ * @return TRUE if the transition should be pruned.
+ * </EN>
+ */
+static boolean
+lookahead_prune(FSBeam *d, int node, LOGPROB score)
+{
+  int p;
+
+  if ((p = d->la_phone[node]) < 0) return FALSE;
+  if (score + d->la_score[p] >= d->la_thres) return FALSE;
+  d->la_pruned++;
+  return TRUE;
+}
+
 /******************************************************/
 /* フレーム同期ビーム探索の実行 --- 最初のフレーム用  */
 /* frame synchronous beam search --- first frame only */
@@ -1872,6 +2048,9 @@ get_back_trellis_init(HTK_Param *param,	RecogProcess *r)
     malloc_nodes(d, wchmm->n, r->trellis_beam_width * 2 + wchmm->startnum);
   }
   prepare_nodes(d, r->trellis_beam_width);
+
+  /* reset statistics of cross-word factoring cache */
+  wchmm->lmcache.iw_hit = wchmm->lmcache.iw_fill = 0;
   
   /* 初期スコアを nodescore[tn] にセット */
   /* set initial score to nodescore[tn] */
@@ -1909,11 +2088,20 @@ get_back_trellis_init(HTK_Param *param,	RecogProcess *r)
   }
 #endif
 
+  /* initialize streaming commit */
+  d->commit_next = r->config->pass1.stream_commit;
+  d->commit_offset = 0;
+  d->commit_wnum = 0;
+
 #ifdef SCORE_PRUNING
   d->score_pruning_threshold = LOG_ZERO;
   d->score_pruning_count = 0;
 #endif
 
+  /* 音素先読みの準備 */
+  /* prepare phone lookahead */
+  lookahead_init(r);
+
   return TRUE;
 }
 
@@ -2110,6 +2298,12 @@ beam_intra_word_core(WCHMM_INFO *wchmm, FSBeam *d, TOKEN2 **tk_ret, int j, int n
     }
   }
   /* factoring not needed when DFA mode and uses category-tree */
+
+  /* 音素先頭への遷移を先読みスコアで枝刈り */
+  /* prune transition to a phone head by phone lookahead */
+  if (d->la_frames > 0 && next_node != node) {
+    if (lookahead_prune(d, next_node, tmpsum)) return;
+  }
   
   /****************************************/
   /* 2.1.2 遷移先ノードへトークン伝搬     */
@@ -2499,6 +2693,8 @@ beam_inter_word(WCHMM_INFO *wchmm, FSBeam *d, TOKEN2 **tk_ret, TRELLIS_ATOM *tre
 	}
       }
     } else {
+      /* prune by phone lookahead */
+      if (d->la_frames > 0 && lookahead_prune(d, next_node, tmpsum)) continue;
       propagate_token(d, next_node, tmpsum, tre, last_word, ngram_score_cache, next_state);
       if (d->expanded) {
 	/* if work area has been expanded at 'create_token()' above,
@@ -2606,6 +2802,8 @@ beam_inter_word_factoring(WCHMM_INFO *wchmm, FSBeam *d)
       }
       
     } else {
+      /* prune by phone lookahead */
+      if (d->la_frames > 0 && lookahead_prune(d, next_node, tmpsum)) continue;
       propagate_token(d, next_node, tmpsum, d->wordend_best_tre, last_word, ngram_score_cache, -1);
       if (d->expanded) {
 	d->expanded = FALSE;
@@ -2735,6 +2933,12 @@ get_back_trellis_proceed(int t, HTK_Param *param, RecogProcess *r, boolean final
   /* initialize token buffer: for speedup, only ones used in the last call will be cleared */
   clear_tokens(d, tl);
 
+  /* 音素先読みスコアを計算 */
+  /* compute phone lookahead scores for this frame */
+  if (d->la_frames > 0) {
+    lookahead_prepare(d, &(r->am->hmmwrk), t, param);
+  }
+
   /**************************/
   /* 2. Viterbi計算         */
   /*    Viterbi computation */
@@ -2941,6 +3145,7 @@ get_back_trellis_proceed(int t, HTK_Param *param, RecogProcess *r, boolean final
       }
     }
   } else {
+    d->la_scored += d->tnum[tn];
     for (j = 0; j < d->tnum[tn]; j++) {
       tk = &(d->tlist[tn][d->tindex[tn][j]]);
       tk->score += outprob_style(wchmm, tk->node, tk->last_tre->wid, t, param);
@@ -3018,6 +3223,136 @@ get_back_trellis_proceed(int t, HTK_Param *param, RecogProcess *r, boolean final
     
 }
 
+/** 
+ * <JA>
+ * @brief  収束した単語の確定と過去の入力の破棄
+ *
+ * ビーム内の全トークンの単語履歴をたどり，共通の祖先となるトレリス単語が
+ * 見つかれば，そこまでの単語列を確定として r->result.pass1 に格納し，
+ * r->have_determine を TRUE にする. 出力文字列を持つ単語が無い場合は
+ * TRUE にしない. 確定した単語の終端までのトレリス単語を
+ * 捨て，以降のフレームとスコアをずらす. 呼出元は返り値のフレーム数だけ
+ * 特徴量列と出力確率キャッシュを詰める必要がある. 
+ * 
+ * @param r [i/o] 音声認識処理インスタンス
+ * @param t [in] 現在の入力フレーム
+ * 
+ * @return 詰めたフレーム数. 確定しなかった場合は 0. 
+ * </JA>
+ * <EN>
+ * @brief  Commit converged words and discard the past input
+ *
+ * The word histories of all the tokens in the beam are traced back, and
+ * if they meet at a trellis word, the word sequence up to the word is
+ * stored to r->result.pass1 as committed and r->have_determine is set to
+ * TRUE.  It is not set when none of the words has output string.  The
+ * trellis words up to the end of the committed word are discarded and
+ * the following frames and scores are shifted.  The caller should
+ * shift the input vectors and the output probability cache by the
+ * returned number of frames.
+ * 
+ * @param r [i/o] recognition process instance
+ * @param t [in] current input frame
+ * 
+ * @return the number of shifted frames, or 0 if nothing was committed.
+ * </EN>
+ *
+ * @callergraph
+ * @callgraph
+ * 
+ */
+int
+stream_commit_words(RecogProcess *r, int t)
+{
+  FSBeam *d;
+  TOKEN2 *tk;
+  TRELLIS_ATOM *tre, *a, *last;
+  int j, i, wordlen, shift;
+  LOGPROB lscore, base;
+
+  d = &(r->pass1);
+
+  if (t < d->commit_next) return 0;
+  /* the result area is in use by the interim output at this frame */
+  if (r->have_interim) return 0;
+  d->commit_next = t + r->config->pass1.stream_commit;
+
+  /* find the common ancestor of the word histories in the beam */
+  tre = last = NULL;
+  for (j = d->n_start; j <= d->n_end; j++) {
+    tk = &(d->tlist[d->tn][d->tindex[d->tn][j]]);
+    a = tk->last_tre;
+    if (a == last) continue;
+    last = a;
+    if (tre == NULL) {
+      tre = a;
+      continue;
+    }
+    while (a != tre) {
+      if (a->endtime > tre->endtime) {
+	a = a->last_tre;
+      } else if (tre->endtime < 0) {
+	/* not converged yet */
+	return 0;
+      } else {
+	tre = tre->last_tre;
+      }
+    }
+  }
+  if (tre == NULL || tre->endtime < 0) return 0;
+
+  /* store the committed words */
+  lscore = trace_backptr(r->result.pass1.word, &wordlen, tre, r->lm->winfo);
+  shift = tre->endtime + 1;
+  r->result.status = J_RESULT_STATUS_SUCCESS;
+  r->result.num_frame = d->commit_offset + shift;
+  r->result.pass1.word_num = wordlen;
+  r->result.pass1.score = tre->backscore;
+  r->result.pass1.score_lm = lscore;
+  r->result.pass1.score_am = tre->backscore - lscore;
+  /* notify only when some of the words have output string, not for the
+     head silence alone */
+  for (i = 0; i < wordlen; i++) {
+    if (r->lm->winfo->woutput[r->result.pass1.word[i]][0] != '\0') break;
+  }
+  if (i < wordlen) r->have_determine = TRUE;
+
+  /* the committed word becomes the root of the rest.  When the scores
+     are getting close to LOG_ZERO on a long input, they are made relative
+     to it.  Since this changes the rounding of the following scores, it
+     is done only beyond the input length that can be decoded without
+     committing */
+  base = (tre->backscore < LOG_ZERO * 0.5) ? tre->backscore : 0.0;
+  d->commit_root = *tre;
+  d->commit_root.backscore = tre->backscore - base;
+  d->commit_root.begintime -= shift;
+  d->commit_root.endtime = -1;
+  d->commit_root.last_tre = NULL;
+  for (j = d->n_start; j <= d->n_end; j++) {
+    tk = &(d->tlist[d->tn][d->tindex[d->tn][j]]);
+    if (tk->last_tre == tre) tk->last_tre = &(d->commit_root);
+    tk->score -= base;
+  }
+#ifdef SCORE_PRUNING
+  if (d->score_pruning_threshold > LOG_ZERO) {
+    d->score_pruning_threshold -= base;
+    d->score_pruning_max -= base;
+  }
+#endif
+  bt_evict(r->backtrellis, tre, &(d->commit_root), base);
+
+  d->commit_next -= shift;
+  d->commit_offset += shift;
+  d->commit_wnum += wordlen;
+  for (i = 0; i < d->la_frames; i++) d->la_frame_time[i] = -1;
+
+  if (debug2_flag) {
+    jlog("DEBUG: %02d %s: committed %d words, %d frames discarded\n", r->config->id, r->config->name, wordlen, shift);
+  }
+
+  return shift;
+}
+
 /*************************************************/
 /* frame synchronous beam search --- last frame  */
 /* フレーム同期ビーム探索の実行 --- 最終フレーム */
@@ -3088,6 +3423,12 @@ get_back_trellis_end(HTK_Param *param, RecogProcess *r)
 #ifdef SCORE_PRUNING
   if (debug2_flag) jlog("STAT: %d tokens pruned by score beam\n", d->score_pruning_count);
 #endif
+  if (d->la_frames > 0 && verbose_flag) {
+    jlog("STAT: %02d %s: lookahead: %d expansions pruned, %d tokens scored (%.1f per frame)\n", r->config->id, r->config->name, d->la_pruned, d->la_scored, (param->samplenum > 0) ? (float)d->la_scored / (float)param->samplenum : 0.0);
+  }
+  if (r->lmtype == LM_PROB && verbose_flag) {
+    jlog("STAT: %02d %s: inter-word LM cache: %d hits, %d fills\n", r->config->id, r->config->name, r->wchmm->lmcache.iw_hit, r->wchmm->lmcache.iw_fill);
+  }
     
 }
 
@@ -3142,7 +3483,13 @@ finalize_1st_pass(RecogProcess *r, int len)
   /* re-arrange backtrellis: index them by frame, and sort by word ID */
 
   bt_relocate_rw(backtrellis);
-  bt_sort_rw(backtrellis);
+  if (r->lmtype == LM_PROB && r->lm->ngram) {
+    /* index them by N-gram word ID for batch N-gram computation */
+    bt_sort_rw_ngram(backtrellis, r->lm->winfo);
+  }
+  if (verbose_flag && backtrellis->num != NULL) {
+    jlog("STAT: %02d %s: back trellis: %d words, %lu KB (%lu KB index), indexed in %.2f msec\n", r->config->id, r->config->name, backtrellis->totalnum, (unsigned long)(backtrellis->chunknum * (sizeof(TRELLIS_ATOM) << BT_CHUNK_BITS) + backtrellis->indexsize) / 1024, (unsigned long)backtrellis->indexsize / 1024, backtrellis->buildtime);
+  }
   if (backtrellis->num == NULL) {
     if (backtrellis->framelen > 0) {
       jlog("WARNING: %02d %s: input processed, but no survived word found\n", r->config->id, r->config->name);
@@ -3186,6 +3533,13 @@ fsbeam_free(FSBeam *d)
   if (d->boslist != NULL) {
     free(d->boslist);
   }
+  if (d->la_phone != NULL) {
+    free(d->la_phone);
+    free(d->la_frame_max);
+    free(d->la_frame_time);
+    free(d->la_score);
+    d->la_phone = NULL;
+  }
 }
 
 /* end of file */
@@ -65,6 +65,7 @@ jconf_set_default_values(Jconf *j)
   j->input.framesize			= DEF_FRAMESIZE;
   j->input.frameshift			= DEF_FRAMESHIFT;
   j->input.use_ds48to16			= FALSE;
+  j->input.infreq			= 0;
   j->input.inputlist_filename		= NULL;
   j->input.adinnet_port			= ADINNET_PORT;
 #ifdef USE_NETAUDIO
@@ -95,6 +96,7 @@ jconf_set_default_values(Jconf *j)
 
   j->reject.gmm_filename		= NULL;
   j->reject.gmm_gprune_num		= 10;
+  j->reject.gmm_shared_topk		= 0;
   j->reject.gmm_reject_cmn_string	= NULL;
   j->reject.rejectshortlen		= 0;
   j->reject.rejectlonglen		= -1;
@@ -105,6 +107,9 @@ jconf_set_default_values(Jconf *j)
   j->decodeopt.forced_realtime		= FALSE;
   j->decodeopt.force_realtime_flag	= FALSE;
   j->decodeopt.segment			= FALSE;
+  j->decodeopt.sr_threads		= 1;
+  j->decodeopt.cpu_affinity		= NULL;
+  j->decodeopt.pass2_async		= FALSE;
 
   j->optsection				= JCONF_OPT_DEFAULT;
   j->optsectioning			= TRUE;
@@ -268,11 +273,15 @@ jconf_set_default_values_search(JCONF_SEARCH *j)
 #ifdef SCORE_PRUNING
   j->pass1.score_pruning_width		= -1.0;
 #endif
+  j->pass1.lookahead_frames		= 0;
+  j->pass1.lookahead_width		= 150.0;
+  j->pass1.stream_commit		= 0;
 #if defined(WPAIR) && defined(WPAIR_KEEP_NLIMIT)
   j->pass1.wpair_keep_nlimit		= 3;
 #endif
 #ifdef HASH_CACHE_IW
   j->pass1.iw_cache_rate		= 10;
+  j->pass1.iw_cache_mb		= 0;
 #endif
   j->pass1.old_tree_function_flag = FALSE;
 #ifdef DETERMINE
@@ -293,11 +302,13 @@ jconf_set_default_values_search(JCONF_SEARCH *j)
   j->pass2.stack_size		= 500;
   j->pass2.lookup_range		= 5;
   j->pass2.looktrellis_flag	= FALSE; /* dfa */
+  j->pass2.recombine_mb		= 0;
 
   j->graph.enabled			= FALSE;
   j->graph.lattice			= FALSE;
   j->graph.confnet			= FALSE;
   j->graph.graph_merge_neighbor_range	= 0;
+  j->graph.amscore			= FALSE;
 #ifdef   GRAPHOUT_DEPTHCUT
   j->graph.graphout_cut_depth		= 80;
 #endif
@@ -332,6 +343,7 @@ jconf_set_default_values_search(JCONF_SEARCH *j)
   j->annotate.align_result_word_flag	= FALSE;
   j->annotate.align_result_phoneme_flag	= FALSE;
   j->annotate.align_result_state_flag	= FALSE;
+  j->annotate.align_threads		= 1;
 
   j->output.output_hypo_maxnum		= 1;
   j->output.progout_flag		= FALSE;
@@ -341,6 +353,7 @@ jconf_set_default_values_search(JCONF_SEARCH *j)
   j->sw.trellis_check_flag		= FALSE;
   j->sw.triphone_check_flag		= FALSE;
   j->sw.wchmm_check_flag		= FALSE;
+  j->sw.wchmm_update_check_flag		= FALSE;
   j->sw.start_inactive			= FALSE;
   j->sw.fallback_pass1_flag		= FALSE;
 
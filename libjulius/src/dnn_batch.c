@@ -0,0 +1,374 @@
+/**
+ * @file   dnn_batch.c
+ *
+ * <JA>
+ * @brief  複数の認識インスタンス間での DNN 出力確率のバッチ計算
+ *
+ * 同一の DNN を用いる複数の Recog インスタンス（それぞれ別スレッドで
+ * 動作）から，未計算フレームの出力確率計算要求を集め，まとめて1回の
+ * 順伝搬で計算してそれぞれの出力確率キャッシュへ返す.
+ *
+ * 要求を出したスレッドはバッチが満杯になるか，全メンバーが要求を出すか，
+ * 最大待ち時間を過ぎるまで待つ. 条件を満たしたスレッドがリーダーとなり
+ * バッチ全体を計算する. 計算結果はフレームごとの計算と同一である.
+ * </JA>
+ *
+ * <EN>
+ * @brief  Batched DNN output computation across recognizer instances
+ *
+ * Pending frames from several Recog instances, each running on its own
+ * thread and sharing the same DNN, are collected into a batch and computed
+ * by one feed-forward pass.  The results are delivered back to each
+ * stream's output probability cache.
+ *
+ * A thread that requests a frame waits until the batch is full, all
+ * attached members have queued a frame, or the maximum wait time has
+ * passed.  The thread that meets the condition becomes the leader and
+ * computes the whole batch.  Results are identical to per-frame
+ * computation.
+ * </EN>
+ *
+ * @author Akinobu Lee
+ * @date   Mon Oct 19 11:03:12 2026
+ *
+ * $Revision: 1.1 $
+ *
+ */
+/*
+ * Copyright (c) 1991-2013 Kawahara Lab., Kyoto University
+ * Copyright (c) 2000-2005 Shikano Lab., Nara Institute of Science and Technology
+ * Copyright (c) 2005-2013 Julius project team, Nagoya Institute of Technology
+ * All rights reserved
+ */
+
+#include <julius/juliuslib.h>
+
+#ifdef HAVE_PTHREAD
+
+/* return TRUE if two DNN has the same structure and parameters */
+static boolean
+dnn_layer_same(DNNLayer *a, DNNLayer *b)
+{
+  if (a->in != b->in || a->out != b->out) return FALSE;
+  if (memcmp(a->w, b->w, sizeof(float) * a->in * a->out) != 0) return FALSE;
+  if (memcmp(a->b, b->b, sizeof(float) * a->out) != 0) return FALSE;
+  return TRUE;
+}
+
+static boolean
+dnn_same(DNNData *a, DNNData *b)
+{
+  int i;
+
+  if (a->hnum != b->hnum) return FALSE;
+  if (a->inputnodenum != b->inputnodenum) return FALSE;
+  if (a->hiddennodenum != b->hiddennodenum) return FALSE;
+  if (a->outputnodenum != b->outputnodenum) return FALSE;
+  if (a->state_prior_num != b->state_prior_num) return FALSE;
+  for (i = 0; i < a->hnum; i++) {
+    if (! dnn_layer_same(&(a->h[i]), &(b->h[i]))) return FALSE;
+  }
+  if (! dnn_layer_same(&(a->o), &(b->o))) return FALSE;
+  if (memcmp(a->state_prior, b->state_prior, sizeof(float) * a->state_prior_num) != 0) return FALSE;
+  return TRUE;
+}
+
+/* compute absolute deadline from now */
+static void
+get_deadline(struct timespec *ts, int usec)
+{
+  struct timeval now;
+
+  gettimeofday(&now, NULL);
+  ts->tv_sec = now.tv_sec + usec / 1000000;
+  ts->tv_nsec = (now.tv_usec + usec % 1000000) * 1000;
+  if (ts->tv_nsec >= 1000000000) {
+    ts->tv_sec++;
+    ts->tv_nsec -= 1000000000;
+  }
+}
+
+/* compute the waiting batch as leader, called with lock held */
+static void
+dnn_batch_run(DNNBatch *b)
+{
+  float **ftmp;
+  LOGPROB **ltmp;
+  int num;
+  unsigned long id;
+
+  /* take the waiting frames and let new ones queue while computing */
+  ftmp = b->run_invec; b->run_invec = b->invec; b->invec = ftmp;
+  ltmp = b->run_outcache; b->run_outcache = b->outcache; b->outcache = ltmp;
+  num = b->num;
+  b->num = 0;
+  id = b->next_id++;
+  b->busy = TRUE;
+  /* wake those waiting for a free slot */
+  pthread_cond_broadcast(&(b->cond));
+  pthread_mutex_unlock(&(b->mutex));
+
+  dnn_calc_outprob_batch(b->dnn, num, b->run_invec, b->run_outcache, b->statenum);
+
+  pthread_mutex_lock(&(b->mutex));
+  b->batches++;
+  b->frames += num;
+  b->done_id = id + 1;
+  b->busy = FALSE;
+  pthread_cond_broadcast(&(b->cond));
+}
+
+/* outprob hook: queue the current frame and wait for its result */
+static void
+dnn_batch_calc(HMMWork *wrk)
+{
+  DNNBatch *b = (DNNBatch *)wrk->dnn_batch_data;
+  unsigned long myid;
+  struct timespec deadline;
+  boolean timeout = FALSE;
+
+  pthread_mutex_lock(&(b->mutex));
+
+  /* wait while the waiting batch is full */
+  while (b->num >= b->maxbatch) {
+    pthread_cond_wait(&(b->cond), &(b->mutex));
+  }
+  b->invec[b->num] = &(wrk->OP_param->parvec[wrk->OP_time][0]);
+  b->outcache[b->num] = wrk->last_cache;
+  b->num++;
+  myid = b->next_id;
+  if (b->num >= b->maxbatch || b->num >= b->members) {
+    /* wake a possible leader */
+    pthread_cond_broadcast(&(b->cond));
+  }
+  get_deadline(&deadline, b->maxwait);
+
+  while (b->done_id <= myid) {
+    if (! b->busy && b->next_id == myid
+	&& (b->num >= b->maxbatch || b->num >= b->members || timeout)) {
+      if (timeout && b->num < b->maxbatch && b->num < b->members) b->timeouts++;
+      dnn_batch_run(b);
+      continue;
+    }
+    if (b->next_id != myid || b->busy) {
+      /* my batch is being computed by other thread, or wait for the
+	 previous batch to finish */
+      pthread_cond_wait(&(b->cond), &(b->mutex));
+    } else if (pthread_cond_timedwait(&(b->cond), &(b->mutex), &deadline) == ETIMEDOUT) {
+      timeout = TRUE;
+    }
+  }
+
+  pthread_mutex_unlock(&(b->mutex));
+}
+
+#endif /* HAVE_PTHREAD */
+
+/**
+ * <JA>
+ * DNN バッチスケジューラを生成する. 指定した Recog 中の最初の DNN を
+ * 共有 DNN とし，その所有権はスケジューラへ移る. 当該 Recog は自動的に
+ * アタッチされる.
+ * </JA>
+ * <EN>
+ * Create a DNN batch scheduler.  The first DNN found in the given
+ * recognizer becomes the shared DNN, and its ownership moves to the
+ * scheduler.  The recognizer will be attached automatically.
+ * </EN>
+ *
+ * @param recog [i/o] engine instance, should be already prepared by j_final_fusion()
+ * @param maxbatch [in] maximum number of frames in a batch
+ * @param maxwait_msec [in] maximum wait time in milliseconds before computing a partial batch
+ *
+ * @return the new scheduler, or NULL on error.
+ *
+ * @callgraph
+ * @callergraph
+ */
+DNNBatch *
+j_dnn_batch_new(Recog *recog, int maxbatch, int maxwait_msec)
+{
+#ifdef HAVE_PTHREAD
+  DNNBatch *b;
+  PROCESS_AM *am;
+
+  for (am = recog->amlist; am; am = am->next) {
+    if (am->dnn != NULL) break;
+  }
+  if (am == NULL) {
+    jlog("ERROR: j_dnn_batch_new: no DNN in the instance\n");
+    return NULL;
+  }
+  if (am->dnn_batch != NULL) {
+    jlog("ERROR: j_dnn_batch_new: DNN already attached to another scheduler\n");
+    return NULL;
+  }
+  if (maxbatch < 1) maxbatch = 1;
+  if (maxwait_msec < 0) maxwait_msec = 0;
+
+  b = (DNNBatch *)mymalloc(sizeof(DNNBatch));
+  memset(b, 0, sizeof(DNNBatch));
+  b->dnn = am->dnn;
+  b->maxbatch = maxbatch;
+  b->maxwait = maxwait_msec * 1000;
+  b->statenum = am->hmmwrk.statenum;
+  b->invec = (float **)mymalloc(sizeof(float *) * maxbatch);
+  b->outcache = (LOGPROB **)mymalloc(sizeof(LOGPROB *) * maxbatch);
+  b->run_invec = (float **)mymalloc(sizeof(float *) * maxbatch);
+  b->run_outcache = (LOGPROB **)mymalloc(sizeof(LOGPROB *) * maxbatch);
+  pthread_mutex_init(&(b->mutex), NULL);
+  pthread_cond_init(&(b->cond), NULL);
+
+  if (j_dnn_batch_attach(b, recog) == FALSE) {
+    /* the DNN is still owned by the AM */
+    b->dnn = NULL;
+    j_dnn_batch_free(b);
+    return NULL;
+  }
+
+  jlog("STAT: DNN batch: max %d frames, max wait %d msec\n", maxbatch, maxwait_msec);
+
+  return b;
+#else
+  jlog("ERROR: j_dnn_batch_new: DNN batch computation needs pthread support\n");
+  return NULL;
+#endif /* HAVE_PTHREAD */
+}
+
+/**
+ * <JA>
+ * Recog の全 DNN を DNN バッチスケジューラにアタッチする.
+ * 共有 DNN と異なる DNN を持つ場合，構造とパラメータが同一であることを
+ * 確認したうえで自身のコピーを解放し共有 DNN を用いる.
+ * 各 Recog は別スレッドで認識を行う必要がある.
+ * </JA>
+ * <EN>
+ * Attach all DNN of a recognizer to a DNN batch scheduler.  If the
+ * recognizer has its own copy of the DNN, it is checked to be identical
+ * to the shared one, then freed to use the shared one.  Each attached
+ * recognizer should run on its own thread.
+ * </EN>
+ *
+ * @param batch [i/o] DNN batch scheduler
+ * @param recog [i/o] engine instance, should be already prepared by j_final_fusion()
+ *
+ * @return TRUE on success, FALSE on error.
+ *
+ * @callgraph
+ * @callergraph
+ */
+boolean
+j_dnn_batch_attach(DNNBatch *batch, Recog *recog)
+{
+#ifdef HAVE_PTHREAD
+  PROCESS_AM *am;
+
+  /* check all first */
+  for (am = recog->amlist; am; am = am->next) {
+    if (am->dnn == NULL) continue;
+    if (am->dnn_batch != NULL && am->dnn_batch != batch) {
+      jlog("ERROR: j_dnn_batch_attach: AM%02d %s already attached to another scheduler\n", am->config->id, am->config->name);
+      return FALSE;
+    }
+    if (am->dnn != batch->dnn && ! dnn_same(am->dnn, batch->dnn)) {
+      jlog("ERROR: j_dnn_batch_attach: AM%02d %s: DNN differs from the shared one\n", am->config->id, am->config->name);
+      return FALSE;
+    }
+    if (am->hmmwrk.statenum != batch->statenum) {
+      jlog("ERROR: j_dnn_batch_attach: AM%02d %s: number of states differs (%d != %d)\n", am->config->id, am->config->name, am->hmmwrk.statenum, batch->statenum);
+      return FALSE;
+    }
+  }
+
+  for (am = recog->amlist; am; am = am->next) {
+    if (am->dnn == NULL || am->dnn_batch != NULL) continue;
+    if (am->dnn != batch->dnn) {
+      /* drop own copy and use the shared one */
+      dnn_free(am->dnn);
+      am->dnn = batch->dnn;
+      am->hmmwrk.OP_dnn = batch->dnn;
+    }
+    am->dnn_batch = batch;
+    am->hmmwrk.dnn_batch_func = dnn_batch_calc;
+    am->hmmwrk.dnn_batch_data = batch;
+    pthread_mutex_lock(&(batch->mutex));
+    batch->members++;
+    pthread_mutex_unlock(&(batch->mutex));
+  }
+
+  return TRUE;
+#else
+  return FALSE;
+#endif /* HAVE_PTHREAD */
+}
+
+/**
+ * <JA>
+ * AM を DNN バッチスケジューラから切り離す. 共有 DNN はスケジューラが
+ * 所有するため，AM からは参照が外される.
+ * </JA>
+ * <EN>
+ * Detach an AM from its DNN batch scheduler.  Since the shared DNN is
+ * owned by the scheduler, the AM loses its reference to the DNN.
+ * </EN>
+ *
+ * @param am [i/o] AM process instance
+ *
+ * @callgraph
+ * @callergraph
+ */
+void
+j_dnn_batch_detach(PROCESS_AM *am)
+{
+#ifdef HAVE_PTHREAD
+  DNNBatch *b = am->dnn_batch;
+
+  if (b == NULL) return;
+  pthread_mutex_lock(&(b->mutex));
+  b->members--;
+  /* remaining members may be waiting for this one */
+  pthread_cond_broadcast(&(b->cond));
+  pthread_mutex_unlock(&(b->mutex));
+  am->dnn_batch = NULL;
+  am->dnn = NULL;
+  am->hmmwrk.OP_dnn = NULL;
+  am->hmmwrk.dnn_batch_func = NULL;
+  am->hmmwrk.dnn_batch_data = NULL;
+#endif /* HAVE_PTHREAD */
+}
+
+/**
+ * <JA>
+ * DNN バッチスケジューラと共有 DNN を解放する. アタッチされた Recog は
+ * 先に解放しておくこと.
+ * </JA>
+ * <EN>
+ * Free a DNN batch scheduler and the shared DNN.  Attached recognizers
+ * should be freed beforehand.
+ * </EN>
+ *
+ * @param batch [i/o] DNN batch scheduler
+ *
+ * @callgraph
+ * @callergraph
+ */
+void
+j_dnn_batch_free(DNNBatch *batch)
+{
+#ifdef HAVE_PTHREAD
+  if (batch->members > 0) {
+    jlog("WARNING: j_dnn_batch_free: %d AM still attached\n", batch->members);
+  }
+  if (verbose_flag && batch->batches > 0) {
+    jlog("STAT: DNN batch: %lu frames in %lu batches (%.1f frames/batch), %lu batches by timeout\n", batch->frames, batch->batches, (float)batch->frames / (float)batch->batches, batch->timeouts);
+  }
+  pthread_mutex_destroy(&(batch->mutex));
+  pthread_cond_destroy(&(batch->cond));
+  free(batch->invec);
+  free(batch->outcache);
+  free(batch->run_invec);
+  free(batch->run_outcache);
+  if (batch->dnn) dnn_free(batch->dnn);
+  free(batch);
+#endif /* HAVE_PTHREAD */
+}
@@ -570,12 +570,14 @@ adjust_sc_index(WCHMM_INFO *wchmm)
  * この関数はプログラム開始時に一度だけ呼ばれる. 
  * 
  * @param wchmm [i/o] 木構造化辞書
+ * @param sconf [in] 探索設定パラメータ
  * </JA>
  * <EN>
  * Initialize factoring cache for a tree lexicon, allocating memory for
  * cache.  This should be called only once on start up.
  * 
  * @param wchmm [i/o] tree lexicon
+ * @param sconf [in] search configuration parameters
  * </EN>
  *
  * @callgraph
@@ -583,11 +585,14 @@ adjust_sc_index(WCHMM_INFO *wchmm)
  * 
  */
 void
-max_successor_cache_init(WCHMM_INFO *wchmm)
+max_successor_cache_init(WCHMM_INFO *wchmm, JCONF_SEARCH *sconf)
 {
   int i;
   LM_PROB_CACHE *l;
   WORD_ID wnum;
+#ifdef HASH_CACHE_IW
+  int len;
+#endif
 
   /* for word-internal */
   l = &(wchmm->lmcache);
@@ -604,8 +609,22 @@ max_successor_cache_init(WCHMM_INFO *wchmm)
     wnum = wchmm->winfo->num;
   }
 #ifdef HASH_CACHE_IW
-  l->iw_cache_num = wnum * jconf.search.pass1.iw_cache_rate / 100;
+  if (sconf->pass1.iw_cache_mb > 0) {
+    /* as many as fit in the given memory */
+#ifdef UNIGRAM_FACTORING
+    len = wchmm->isolatenum;
+#else
+    len = wchmm->startnum;
+#endif
+    if (len < 1) len = 1;
+    l->iw_cache_num = (int)((double)sconf->pass1.iw_cache_mb * 1000.0 * 1000.0 / (len * sizeof(LOGPROB)));
+    if (l->iw_cache_num > wnum) l->iw_cache_num = wnum;
+  } else {
+    l->iw_cache_num = wnum * sconf->pass1.iw_cache_rate / 100;
+  }
   if (l->iw_cache_num < 10) l->iw_cache_num = 10;
+  /* round up to a whole set */
+  l->iw_cache_num = (l->iw_cache_num + IW_CACHE_WAYS - 1) / IW_CACHE_WAYS * IW_CACHE_WAYS;
 #else
   l->iw_cache_num = wnum;
 #endif /* HASH_CACHE_IW */
@@ -615,9 +634,25 @@ max_successor_cache_init(WCHMM_INFO *wchmm)
   }
 #ifdef HASH_CACHE_IW
   l->iw_lw_cache = (WORD_ID *)mymalloc(sizeof(WORD_ID) * l->iw_cache_num);
+  l->iw_lru = (unsigned int *)mymalloc(sizeof(unsigned int) * l->iw_cache_num);
   for (i=0;i<l->iw_cache_num;i++) {
     l->iw_lw_cache[i] = WORD_INVALID;
+    l->iw_lru[i] = 0;
   }
+  l->iw_tick = 0;
+#endif
+  l->iw_hit = l->iw_fill = 0;
+#ifdef UNIGRAM_FACTORING
+  l->iw_nword = NULL;
+  l->iw_word = NULL;
+  l->iw_index = NULL;
+  l->iw_prob = NULL;
+  l->iw_nbgn = NULL;
+  l->iw_cword = NULL;
+  l->iw_uni = NULL;
+#ifdef CLASS_NGRAM
+  l->iw_cprob = NULL;
+#endif
 #endif
 }
 
@@ -642,6 +677,10 @@ max_successor_prob_iw_free(WCHMM_INFO *wchmm)
   for (i=0;i<l->iw_cache_num;i++) {
     if (l->iw_sc_cache[i] != NULL) free(l->iw_sc_cache[i]);
     l->iw_sc_cache[i] = NULL;
+#ifdef HASH_CACHE_IW
+    l->iw_lw_cache[i] = WORD_INVALID;
+    l->iw_lru[i] = 0;
+#endif
   }
 }
 
@@ -670,6 +709,21 @@ max_successor_cache_free(WCHMM_INFO *wchmm)
   free(wchmm->lmcache.iw_sc_cache);
 #ifdef HASH_CACHE_IW
   free(wchmm->lmcache.iw_lw_cache);
+  free(wchmm->lmcache.iw_lru);
+#endif
+#ifdef UNIGRAM_FACTORING
+  if (wchmm->lmcache.iw_nword != NULL) {
+    free(wchmm->lmcache.iw_nword);
+    free(wchmm->lmcache.iw_word);
+    free(wchmm->lmcache.iw_index);
+    free(wchmm->lmcache.iw_prob);
+    free(wchmm->lmcache.iw_nbgn);
+    free(wchmm->lmcache.iw_cword);
+    free(wchmm->lmcache.iw_uni);
+#ifdef CLASS_NGRAM
+    free(wchmm->lmcache.iw_cprob);
+#endif
+  }
 #endif
 }
 
@@ -1011,6 +1065,176 @@ max_successor_prob(WCHMM_INFO *wchmm, WORD_ID lastword, int node)
 
 }
 
+#ifdef UNIGRAM_FACTORING
+
+/// Pair of N-gram word ID and isolated node index, for sorting
+typedef struct {
+  WORD_ID nw;			///< N-gram word ID
+  WORD_ID w;			///< Word ID
+  int i;			///< Index in the cross-word factoring cache
+} IW_WORD;
+
+/** 
+ * qsort callback to sort isolated word-head words by N-gram word ID.
+ * 
+ * @param a [in] first element
+ * @param b [in] second element
+ * 
+ * @return a value needed to do upward sort.
+ */
+static int
+compare_iw_word(IW_WORD *a, IW_WORD *b)
+{
+  if (a->nw > b->nw) return 1;
+  if (a->nw < b->nw) return -1;
+  return(a->i - b->i);
+}
+
+/** 
+ * <JA>
+ * 単語間 factoring 値を一括計算するために，独立した単語先頭ノードの
+ * 単語を N-gram 上の単語IDでソートしたリストを作成する. 
+ * 
+ * @param wchmm [i/o] 木構造化辞書
+ * </JA>
+ * <EN>
+ * Make a list of words on the isolated word-head nodes sorted by N-gram
+ * word ID, for batch computation of cross-word factoring values.
+ * Also the 1-gram probabilities of the nodes are stored in cache order
+ * to fill the back-off values at once.
+ * 
+ * @param wchmm [i/o] tree lexicon
+ * </EN>
+ */
+static void
+make_iwcache_batch_index(WCHMM_INFO *wchmm)
+{
+  LM_PROB_CACHE *l;
+  IW_WORD *tmp;
+  int i, j, k, node;
+  WORD_ID nw, wnum;
+
+  l = &(wchmm->lmcache);
+  tmp = (IW_WORD *)mymalloc(sizeof(IW_WORD) * (wchmm->isolatenum > 0 ? wchmm->isolatenum : 1));
+  k = 0;
+  for (j=0;j<wchmm->startnum;j++) {
+    i = wchmm->start2isolate[j];
+    if (i == -1) continue;
+    node = wchmm->startnode[j];
+    if (wchmm->state[node].scid <= 0) {
+      /* should not happen!!! below is just for debugging */
+      j_internal_error("make_iwcache_batch_index: isolated (not shared) tree root node has unigram factoring value??\n");
+    }
+    tmp[k].w = wchmm->scword[wchmm->state[node].scid];
+    tmp[k].nw = wchmm->winfo->wton[tmp[k].w];
+    tmp[k].i = i;
+    k++;
+  }
+  qsort(tmp, k, sizeof(IW_WORD), (int (*)(const void *,const void *))compare_iw_word);
+  l->iw_nword = (WORD_ID *)mymalloc(sizeof(WORD_ID) * (k > 0 ? k : 1));
+  l->iw_word = (WORD_ID *)mymalloc(sizeof(WORD_ID) * (k > 0 ? k : 1));
+  l->iw_index = (int *)mymalloc(sizeof(int) * (k > 0 ? k : 1));
+  l->iw_prob = (LOGPROB *)mymalloc(sizeof(LOGPROB) * (k > 0 ? k : 1));
+  for (j=0;j<k;j++) {
+    l->iw_nword[j] = tmp[j].nw;
+    l->iw_word[j] = tmp[j].w;
+    l->iw_index[j] = tmp[j].i;
+  }
+  free(tmp);
+
+  /* index of N-gram word ID to the sorted list */
+  wnum = wchmm->ngram->max_word_num;
+  l->iw_nbgn = (int *)mymalloc(sizeof(int) * (wnum + 1));
+  j = 0;
+  for (nw=0;nw<wnum;nw++) {
+    l->iw_nbgn[nw] = j;
+    while (j < k && l->iw_nword[j] == nw) j++;
+  }
+  l->iw_nbgn[wnum] = j;
+
+  /* per-node values in cache order */
+  l->iw_cword = (WORD_ID *)mymalloc(sizeof(WORD_ID) * (k > 0 ? k : 1));
+  l->iw_uni = (LOGPROB *)mymalloc(sizeof(LOGPROB) * (k > 0 ? k : 1));
+#ifdef CLASS_NGRAM
+  l->iw_cprob = (LOGPROB *)mymalloc(sizeof(LOGPROB) * (k > 0 ? k : 1));
+#endif
+  for (j=0;j<k;j++) {
+    i = l->iw_index[j];
+    l->iw_cword[i] = l->iw_word[j];
+    l->iw_uni[i] = wchmm->ngram->d[0].prob[l->iw_nword[j]];
+#ifdef CLASS_NGRAM
+    l->iw_cprob[i] = wchmm->winfo->cprob[l->iw_word[j]];
+#endif
+  }
+}
+
+/** 
+ * <JA>
+ * 直前単語に対する単語間 factoring 値を，バックオフ値の一括代入と
+ * 明示的な 2-gram のみの上書きで計算する. 2-gram が左文脈で
+ * インデックスされていない場合は何もしない. 
+ * 
+ * @param wchmm [in] 木構造化辞書
+ * @param lastword [in] 直前単語
+ * @param last_nword [in] 直前単語の N-gram 上の単語ID
+ * @param c [out] factoring 値を格納するキャッシュ
+ * 
+ * @return 計算した場合 TRUE，できない場合 FALSE.
+ * </JA>
+ * <EN>
+ * Fill the cross-word factoring values for a last word by writing the
+ * back-off values for all the isolated word-head nodes at once, and then
+ * overwriting only the nodes of the explicit 2-gram successors of the
+ * last word.  The values are the same as computed by bigram_prob().
+ * Does nothing if the 2-gram is not indexed by the left context.
+ * 
+ * @param wchmm [in] tree lexicon
+ * @param lastword [in] last word
+ * @param last_nword [in] N-gram word ID of the last word
+ * @param c [out] cache to store the factoring values
+ * 
+ * @return TRUE when filled, or FALSE if not available.
+ * </EN>
+ */
+static boolean
+max_successor_prob_iw_fill(WCHMM_INFO *wchmm, WORD_ID lastword, WORD_ID last_nword, LOGPROB *c)
+{
+  LM_PROB_CACHE *l;
+  NGRAM_INFO *ngram;
+  WORD_ID *wlist, nw;
+  LOGPROB *plist, bo, *uni;
+  int i, j, k, num, n;
+
+  l = &(wchmm->lmcache);
+  ngram = wchmm->ngram;
+  if ((num = bi_prob_successor(ngram, last_nword, &wlist, &plist, &bo)) < 0) return FALSE;
+
+  /* back-off to 1-gram for all nodes */
+  n = wchmm->isolatenum;
+  uni = l->iw_uni;
+  for (i=0;i<n;i++) c[i] = bo + uni[i];
+  /* overwrite nodes of explicit 2-gram */
+  for (k=0;k<num;k++) {
+    nw = wlist[k];
+    for (j=l->iw_nbgn[nw];j<l->iw_nbgn[nw+1];j++) c[l->iw_index[j]] = plist[k];
+  }
+  if (ngram->unk_id < ngram->max_word_num) {
+    nw = ngram->unk_id;
+    for (j=l->iw_nbgn[nw];j<l->iw_nbgn[nw+1];j++) c[l->iw_index[j]] -= ngram->unk_num_log;
+  }
+#ifdef CLASS_NGRAM
+  for (i=0;i<n;i++) c[i] += l->iw_cprob[i];
+#endif
+  if (wchmm->lmvar == LM_NGRAM_USER) {
+    for (i=0;i<n;i++) {
+      c[i] = (*(wchmm->bi_prob_user))(wchmm->winfo, lastword, l->iw_cword[i], c[i]);
+    }
+  }
+  return TRUE;
+}
+
+#endif /* UNIGRAM_FACTORING */
+
 /** 
  * <JA>
  * @brief  単語間の factoring 値のリストを返す. 
@@ -1049,6 +1273,9 @@ LOGPROB *
 max_successor_prob_iw(WCHMM_INFO *wchmm, WORD_ID lastword)
 {
   int i, j, x, node;
+#ifdef HASH_CACHE_IW
+  int s;
+#endif
   int last_nword;
   WORD_ID w;
   LM_PROB_CACHE *l;
@@ -1063,12 +1290,20 @@ max_successor_prob_iw(WCHMM_INFO *wchmm, WORD_ID lastword)
   }
 
 #ifdef HASH_CACHE_IW
-  x = last_nword % l->iw_cache_num;
-  if (l->iw_lw_cache[x] == last_nword) { /* cache hit */
-    return(l->iw_sc_cache[x]);
+  /* set-associative: look up the set, or replace the least recently used */
+  s = (last_nword % (l->iw_cache_num / IW_CACHE_WAYS)) * IW_CACHE_WAYS;
+  x = s;
+  for (i=s;i<s+IW_CACHE_WAYS;i++) {
+    if (l->iw_lw_cache[i] == last_nword) { /* cache hit */
+      l->iw_lru[i] = ++l->iw_tick;
+      l->iw_hit++;
+      return(l->iw_sc_cache[i]);
+    }
+    if (l->iw_lru[i] < l->iw_lru[x]) x = i;
   }
 #else  /* full cache */
   if (l->iw_sc_cache[last_nword] != NULL) { /* cache hit */
+    l->iw_hit++;
     return(l->iw_sc_cache[last_nword]);
   }
   x = last_nword;
@@ -1105,28 +1340,41 @@ max_successor_prob_iw(WCHMM_INFO *wchmm, WORD_ID lastword)
 
   /* calc prob for all startid */
 #ifdef UNIGRAM_FACTORING
-  for (j=0;j<wchmm->startnum;j++) {
-    i = wchmm->start2isolate[j];
-    if (i == -1) continue;
-    node = wchmm->startnode[j];
-    if (wchmm->state[node].scid <= 0) {
-      /* should not happen!!! below is just for debugging */
-      j_internal_error("max_successor_prob_iw: isolated (not shared) tree root node has unigram factoring value??\n");
-    } else {
-      w = wchmm->scword[wchmm->state[node].scid];
-      if (wchmm->ngram) {
-	p = (*(wchmm->ngram->bigram_prob))(wchmm->ngram, last_nword, wchmm->winfo->wton[w])
+  if (wchmm->ngram) {
+    if (l->iw_nword == NULL) make_iwcache_batch_index(wchmm);
+    /* fill back-off values and overwrite explicit 2-gram */
+    if (max_successor_prob_iw_fill(wchmm, lastword, last_nword, l->iw_sc_cache[x]) == FALSE) {
+      /* 2-gram is indexed by right context: compute them at once */
+      bi_prob_batch(wchmm->ngram, last_nword, l->iw_nword, wchmm->isolatenum, l->iw_prob);
+      for (j=0;j<wchmm->isolatenum;j++) {
+	w = l->iw_word[j];
+	p = l->iw_prob[j]
 #ifdef CLASS_NGRAM
 	  + wchmm->winfo->cprob[w]
 #endif
 	  ;
+	if (wchmm->lmvar == LM_NGRAM_USER) {
+	  p = (*(wchmm->bi_prob_user))(wchmm->winfo, lastword, w, p);
+	}
+	l->iw_sc_cache[x][l->iw_index[j]] = p;
+      }
+    }
+  } else {
+    for (j=0;j<wchmm->startnum;j++) {
+      i = wchmm->start2isolate[j];
+      if (i == -1) continue;
+      node = wchmm->startnode[j];
+      if (wchmm->state[node].scid <= 0) {
+	/* should not happen!!! below is just for debugging */
+	j_internal_error("max_successor_prob_iw: isolated (not shared) tree root node has unigram factoring value??\n");
       } else {
+	w = wchmm->scword[wchmm->state[node].scid];
 	p = LOG_ZERO;
+	if (wchmm->lmvar == LM_NGRAM_USER) {
+	  p = (*(wchmm->bi_prob_user))(wchmm->winfo, lastword, w, p);
+	}
+	l->iw_sc_cache[x][i] = p;
       }
-      if (wchmm->lmvar == LM_NGRAM_USER) {
-	p = (*(wchmm->bi_prob_user))(wchmm->winfo, lastword, w, p);
-      }
-      l->iw_sc_cache[x][i] = p;
     }
   }
 #else  /* ~UNIGRAM_FACTORING */
@@ -1137,7 +1385,9 @@ max_successor_prob_iw(WCHMM_INFO *wchmm, WORD_ID lastword)
 #endif
 #ifdef HASH_CACHE_IW
   l->iw_lw_cache[x] = last_nword;
+  l->iw_lru[x] = ++l->iw_tick;
 #endif
+  l->iw_fill++;
 
   return(l->iw_sc_cache[x]);
 }
@@ -155,158 +155,296 @@ gmm_cache_push(GMMCalc *gc, int id, LOGPROB score, int len)
 
 /** 
  * <JA>
- * 現在のフレームの入力ベクトルに対する Gaussian の出力確率を計算する. 
- * Gaussian pruning は行なわない. 
+ * GMM計算における Gaussian pruning のためのワークエリアを確保する
  * 
  * @param gc [i/o] GMM計算用ワークエリア
- * @param binfo [in] Gaussian
- * 
- * @return 出力確率の対数値
+ * @param hmminfo [in] HMM 構造体
+ * @param prune_num [in] Gaussian pruning において計算する上位ガウス分布数
  * </JA>
  * <EN>
- * Compute an output probability of a Gaussian for the input vector of
- * current frame.  No Gaussian pruning is performed in this function.
+ * Allocate work area for Gaussian pruning for GMM calculation.
  * 
  * @param gc [i/o] work area for GMM calculation
- * @param binfo [in] Gaussian
- * 
- * @return the log output probability.
+ * @param hmminfo [in] HMM structure
+ * @param prune_num [in] number of top Gaussians to be computed at the pruning
  * </EN>
  */
-static LOGPROB
-gmm_compute_g_base(GMMCalc *gc, HTK_HMM_Dens *binfo)
+static void
+gmm_gprune_safe_init(GMMCalc *gc, HTK_HMM_INFO *hmminfo, int prune_num)
 {
-  VECT tmp, x;
-  VECT *mean;
-  VECT *var;
-  VECT *vec = gc->OP_vec;
-  short veclen = gc->OP_veclen;
-
-  if (binfo == NULL) return(LOG_ZERO);
-  mean = binfo->mean;
-  var = binfo->var->vec;
-  tmp = 0.0;
-  for (; veclen > 0; veclen--) {
-    x = *(vec++) - *(mean++);
-    tmp += x * x * *(var++);
-  }
-  return((tmp + binfo->gconst) * -0.5);
+  /* store the pruning num to local area */
+  gc->OP_gprune_num = prune_num;
+  /* maximum Gaussian set size = maximum mixture size * nstream */
+  gc->OP_calced_maxnum = hmminfo->maxmixturenum * gc->OP_nstream;
+  /* allocate memory for storing list of currently computed Gaussian in a frame */
+  gc->OP_calced_score = (LOGPROB *)mymalloc(sizeof(LOGPROB) * gc->OP_calced_maxnum);
+  gc->OP_calced_id = (int *)mymalloc(sizeof(int) * gc->OP_calced_maxnum);
 }
 
 /** 
  * <JA>
- * 現在のフレームの入力ベクトルに対する Gaussian の出力確率を計算する. 
- * 計算時には固定しきい値による safe pruning を行なう. 
+ * 全GMMのガウス分布を各ストリームごとに一つの表にまとめる. 平均と分散は
+ * 次元ごとに全ガウス分布を並べて格納し，1フレームの全ガウス分布を
+ * ベクトル演算で一度に計算できるようにする. 
+ *
+ * Gaussian pruning の safe algorithm と同じ値を得るため，混合分布内で
+ * 先頭から gprune_num 個のガウス分布は距離を 0 から累積して最後に gconst を
+ * 加え，それ以降は gconst から累積する. 
  * 
  * @param gc [i/o] GMM計算用ワークエリア
- * @param binfo [in] Gaussian
- * @param thres [in] safe pruning のための枝刈りしきい値
- * 
- * @return 出力確率の対数値
+ * @param gmm [in] GMM
  * </JA>
  * <EN>
- * Compute an output probability of a Gaussian for the input vector of
- * current frame.  Safe pruning is performed in this function.
+ * Pack Gaussians of all GMMs into a table for each stream.  Means and
+ * variances are stored in dimension-major order so that all Gaussians of
+ * a frame can be computed at once by vector operations.
+ *
+ * To get exactly the same values as the safe algorithm of Gaussian
+ * pruning, the first gprune_num Gaussians in a mixture accumulate
+ * the distance from zero and add gconst at last, and the rest accumulate
+ * it from gconst.
  * 
  * @param gc [i/o] work area for GMM calculation
- * @param binfo [in] Gaussian
- * @param thres [in] pruning threshold for safe pruning
- * 
- * @return the log output probability.
+ * @param gmm [in] GMM
  * </EN>
  */
-static LOGPROB
-gmm_compute_g_safe(GMMCalc *gc, HTK_HMM_Dens *binfo, LOGPROB thres)
+static void
+gmm_pack_init(GMMCalc *gc, HTK_HMM_INFO *gmm)
 {
-  VECT tmp, x;
-  VECT *mean;
-  VECT *var;
-  VECT *vec = gc->OP_vec;
-  short veclen = gc->OP_veclen;
-  VECT fthres = thres * (-2.0);
-
-  if (binfo == NULL) return(LOG_ZERO);
-  mean = binfo->mean;
-  var = binfo->var->vec;
-  tmp = binfo->gconst;
-  for (; veclen > 0; veclen--) {
-    x = *(vec++) - *(mean++);
-    tmp += x * x * *(var++);
-    if (tmp > fthres)  return LOG_ZERO;
-  }
-  return(tmp * -0.5);
+  HTK_HMM_Data *d;
+  HTK_HMM_PDF *pdf;
+  HTK_HMM_Dens *b;
+  GMMPack *pk;
+  int s, c, i, g, k, veclen;
+
+  gc->pack = (GMMPack *)mymalloc(sizeof(GMMPack) * gc->OP_nstream);
+  for(s=0;s<gc->OP_nstream;s++) {
+    pk = &(gc->pack[s]);
+    veclen = gc->OP_veclen_stream[s];
+    /* count Gaussians */
+    pk->num = 0;
+    for(d=gmm->start;d;d=d->next) pk->num += d->s[1]->pdf[s]->mix_num;
+    pk->stride = (pk->num + 7) & ~7;
+    pk->mean = (VECT *)mymalloc(sizeof(VECT) * veclen * pk->stride);
+    pk->var = (VECT *)mymalloc(sizeof(VECT) * veclen * pk->stride);
+    pk->init = (VECT *)mymalloc(sizeof(VECT) * pk->stride);
+    pk->add = (VECT *)mymalloc(sizeof(VECT) * pk->stride);
+    pk->acc = (VECT *)mymalloc(sizeof(VECT) * pk->stride);
+    pk->isnull = (boolean *)mymalloc(sizeof(boolean) * pk->stride);
+    pk->score = (LOGPROB *)mymalloc(sizeof(LOGPROB) * pk->stride);
+    pk->sorted = (LOGPROB *)mymalloc(sizeof(LOGPROB) * pk->stride);
+    pk->begin = (int *)mymalloc(sizeof(int) * (gmm->totalhmmnum + 1));
+    for(i=0;i<veclen*pk->stride;i++) {
+      pk->mean[i] = 0.0;
+      pk->var[i] = 0.0;
+    }
+    for(g=0;g<pk->stride;g++) {
+      pk->init[g] = pk->add[g] = 0.0;
+      pk->isnull[g] = TRUE;
+    }
+    /* store */
+    g = 0;
+    c = 0;
+    for(d=gmm->start;d;d=d->next) {
+      pk->begin[c++] = g;
+      pdf = d->s[1]->pdf[s];
+      for(i=0;i<pdf->mix_num;i++) {
+	b = pdf->b[i];
+	if (b != NULL) {
+	  for(k=0;k<veclen;k++) {
+	    pk->mean[k * pk->stride + g] = b->mean[k];
+	    pk->var[k * pk->stride + g] = b->var->vec[k];
+	  }
+	  /* the first gprune_num Gaussians in a mixture are computed fully,
+	     and the rest are computed with safe pruning from gconst */
+	  if (i < gc->OP_gprune_num) {
+	    pk->init[g] = 0.0;
+	    pk->add[g] = b->gconst;
+	  } else {
+	    pk->init[g] = b->gconst;
+	    pk->add[g] = 0.0;
+	  }
+	  pk->isnull[g] = FALSE;
+	}
+	g++;
+      }
+    }
+    pk->begin[c] = g;
+  }
 }
 
 /** 
  * <JA>
- * GMM計算における Gaussian pruning のためのワークエリアを確保する
+ * パック済みガウス分布表を解放する. 
  * 
  * @param gc [i/o] GMM計算用ワークエリア
- * @param hmminfo [in] HMM 構造体
- * @param prune_num [in] Gaussian pruning において計算する上位ガウス分布数
  * </JA>
  * <EN>
- * Allocate work area for Gaussian pruning for GMM calculation.
+ * Free the packed Gaussian tables.
  * 
  * @param gc [i/o] work area for GMM calculation
- * @param hmminfo [in] HMM structure
- * @param prune_num [in] number of top Gaussians to be computed at the pruning
  * </EN>
  */
 static void
-gmm_gprune_safe_init(GMMCalc *gc, HTK_HMM_INFO *hmminfo, int prune_num)
+gmm_pack_free(GMMCalc *gc)
 {
-  /* store the pruning num to local area */
-  gc->OP_gprune_num = prune_num;
-  /* maximum Gaussian set size = maximum mixture size * nstream */
-  gc->OP_calced_maxnum = hmminfo->maxmixturenum * gc->OP_nstream;
-  /* allocate memory for storing list of currently computed Gaussian in a frame */
-  gc->OP_calced_score = (LOGPROB *)mymalloc(sizeof(LOGPROB) * gc->OP_calced_maxnum);
-  gc->OP_calced_id = (int *)mymalloc(sizeof(int) * gc->OP_calced_maxnum);
+  int s;
+  GMMPack *pk;
+
+  if (gc->pack == NULL) return;
+  for(s=0;s<gc->OP_nstream;s++) {
+    pk = &(gc->pack[s]);
+    free(pk->begin);
+    free(pk->sorted);
+    free(pk->score);
+    free(pk->isnull);
+    free(pk->acc);
+    free(pk->add);
+    free(pk->init);
+    free(pk->var);
+    free(pk->mean);
+  }
+  free(gc->pack);
+  gc->pack = NULL;
 }
 
 /** 
  * <JA>
- * @brief  ガウス分布集合内の各ガウス分布の現フレームに対する出力確率を計算する. 
- *
- * Gaussian pruning により，実際には上位 N 個のみを保証する枝刈りが行なわれ，
- * スコアの低いガウス分布は計算されない. 
- *
- * 計算結果は計算済みGaussianリスト (OP_calced_score, OP_calced_id) に
- * 格納される. 
+ * 現フレームの入力ベクトルに対して，パック済み表の全ガウス分布の
+ * スコアを一度に計算する. 
+ * 
+ * @param pk [i/o] パック済みガウス分布表
+ * @param vec [in] 入力ベクトル
+ * @param veclen [in] @a vec の長さ
+ * </JA>
+ * <EN>
+ * Compute scores of all Gaussians in a packed table for the input vector
+ * of current frame at once.
+ * 
+ * @param pk [i/o] packed Gaussian table
+ * @param vec [in] input vector
+ * @param veclen [in] length of @a vec
+ * </EN>
+ */
+static void
+gmm_pack_compute(GMMPack *pk, VECT *vec, short veclen)
+{
+  int k, g, num;
+  VECT x, y;
+  VECT *mean, *var, *acc;
+
+  num = pk->num;
+  acc = pk->acc;
+  memcpy(acc, pk->init, sizeof(VECT) * num);
+  for(k=0;k<veclen;k++) {
+    x = vec[k];
+    mean = &(pk->mean[k * pk->stride]);
+    var = &(pk->var[k * pk->stride]);
+    /* this loop runs over all Gaussians and can be vectorized */
+    for(g=0;g<num;g++) {
+      y = x - mean[g];
+      acc[g] += y * y * var[g];
+    }
+  }
+  for(g=0;g<num;g++) {
+    pk->score[g] = (acc[g] + pk->add[g]) * -0.5;
+  }
+  for(g=0;g<num;g++) {
+    if (pk->isnull[g]) pk->score[g] = LOG_ZERO;
+  }
+}
+
+/** 
+ * <JA>
+ * 配列中で k 番目に大きい値を返す. 配列の内容は並べ替えられる. 
+ * 
+ * @param a [i/o] 値の配列
+ * @param n [in] @a a の長さ
+ * @param k [in] 順位 (0 が最大)
+ * 
+ * @return k 番目に大きい値
+ * </JA>
+ * <EN>
+ * Return the k-th largest value in an array.  The array will be reordered.
+ * 
+ * @param a [i/o] array of values
+ * @param n [in] length of @a a
+ * @param k [in] rank (0 for the largest)
+ * 
+ * @return the k-th largest value.
+ * </EN>
+ */
+static LOGPROB
+gmm_select_kth(LOGPROB *a, int n, int k)
+{
+  int left, right, i, j;
+  LOGPROB pivot, tmp;
+
+  left = 0;
+  right = n - 1;
+  while (left < right) {
+    pivot = a[(left + right) / 2];
+    i = left;
+    j = right;
+    while (i <= j) {
+      while (a[i] > pivot) i++;
+      while (a[j] < pivot) j--;
+      if (i <= j) {
+	tmp = a[i]; a[i] = a[j]; a[j] = tmp;
+	i++; j--;
+      }
+    }
+    if (k <= j) right = j;
+    else if (k >= i) left = i;
+    else break;
+  }
+  return(a[k]);
+}
+
+/** 
+ * <JA>
+ * 計算済みのスコアを用いて，Gaussian pruning の safe algorithm と
+ * 同じ手順で計算済みGaussianリストを作成する. 上位 N 個のみを保証し，
+ * 結果は OP_calced_score, OP_calced_id に格納される. 
  * 
  * @param gc [i/o] GMM計算用ワークエリア
- * @param g [in] ガウス分布集合
- * @param gnum [in] @a g の長さ
+ * @param score [in] 混合分布内の各ガウス分布のスコア
+ * @param gnum [in] @a score の長さ
+ * @param topthres [in] 全GMM共通の上位Kしきい値 (LOG_ZERO で無効)
  * </JA>
  * <EN>
- * @brief  Compute scores for a set of Gaussians with Gaussian pruning for
- * the current frame.
- *
- * Gaussian pruning will be performed to guarantee only the top N Gaussians
- * to be fully computed.  The results will be stored in the list of
- * computed Gaussians in OP_calced_score and OP_calced_id.
+ * Make the list of computed Gaussians from already computed scores, in
+ * the same way as the safe algorithm of Gaussian pruning.  Only the
+ * top N Gaussians are guaranteed, and the results will be stored in
+ * OP_calced_score and OP_calced_id.
  * 
  * @param gc [i/o] work area for GMM calculation
- * @param g [in] set of Gaussians
- * @param gnum [in] length of @a g
+ * @param score [in] scores of Gaussians in a mixture
+ * @param gnum [in] length of @a score
+ * @param topthres [in] threshold of shared top-K among all GMMs, or LOG_ZERO to disable
  * </EN>
  */
 static void
-gmm_gprune_safe(GMMCalc *gc, HTK_HMM_Dens **g, int gnum)
+gmm_gprune_packed(GMMCalc *gc, LOGPROB *score, int gnum, LOGPROB topthres)
 {
   int i, num = 0;
-  LOGPROB score, thres;
+  LOGPROB thres;
+
+  if (topthres > LOG_ZERO) {
+    /* keep at least the best one in this mixture */
+    thres = LOG_ZERO;
+    for (i = 0; i < gnum; i++) if (thres < score[i]) thres = score[i];
+    if (topthres > thres) topthres = thres;
+  }
 
   thres = LOG_ZERO;
   for (i = 0; i < gnum; i++) {
-    if (num < gc->OP_gprune_num) {
-      score = gmm_compute_g_base(gc, g[i]);
-    } else {
-      score = gmm_compute_g_safe(gc, g[i], thres);
-      if (score <= thres) continue;
+    if (score[i] < topthres) continue;
+    if (num >= gc->OP_gprune_num) {
+      /* safe pruning: the distance exceeds the current N-th best */
+      if (score[i] <= thres) continue;
     }
-    num = gmm_cache_push(gc, i, score, num);
+    num = gmm_cache_push(gc, i, score[i], num);
     thres = gc->OP_calced_score[num-1];
   }
   gc->OP_calced_num = num;
@@ -314,46 +452,46 @@ gmm_gprune_safe(GMMCalc *gc, HTK_HMM_Dens **g, int gnum)
 
 /** 
  * <JA>
- * あるGMM状態の現フレームに対する出力確率を計算する. 
+ * パック済み表で計算済みのスコアから，あるGMM状態の出力確率を求める. 
+ * 複数ストリームの場合はストリーム重みを考慮する. 
  * 
  * @param gc [i/o] GMM計算用ワークエリア
+ * @param c [in] GMM の番号
  * @param state [in] GMM 状態
+ * @param topthres [in] 各ストリームの上位Kしきい値
  * 
  * @return 出力確率の対数スコア
  * </JA>
  * <EN>
- * Compute the output probability of a GMM state for the current frame.
+ * Compute the output probability of a GMM state from the scores computed
+ * on the packed tables.  Stream weights are applied for multi-stream GMM.
  * 
  * @param gc [i/o] work area for GMM calculation
+ * @param c [in] index of the GMM
  * @param state [in] GMM state
+ * @param topthres [in] threshold of shared top-K for each stream
  * 
  * @return the log probability.
  * </EN>
  */
 static LOGPROB
-gmm_calc_mix(GMMCalc *gc, HTK_HMM_State *state)
+gmm_calc_mix_packed(GMMCalc *gc, int c, HTK_HMM_State *state, LOGPROB *topthres)
 {
   int i;
   LOGPROB logprob, logprobsum;
   int s;
   PROB stream_weight;
+  GMMPack *pk;
 
-
-  /* compute Gaussian set */
   logprobsum = 0.0;
   for(s=0;s<gc->OP_nstream;s++) {
+    pk = &(gc->pack[s]);
     /* set stream weight */
     if (state->w) stream_weight = state->w->weight[s];
     else stream_weight = 1.0;
-    /* setup storage pointer for this mixture pdf */
-    gc->OP_vec = gc->OP_vec_stream[s];
-    gc->OP_veclen = gc->OP_veclen_stream[s];
-    /* compute output probabilities */
-    gmm_gprune_safe(gc, state->pdf[s]->b, state->pdf[s]->mix_num);
-    /* computed Gaussians will be set in:
-       score ... OP_calced_score[0..OP_calced_num]
-       id    ... OP_calced_id[0..OP_calced_num] */
-  /* sum */
+    /* pick up the Gaussians of this mixture */
+    gmm_gprune_packed(gc, &(pk->score[pk->begin[c]]), state->pdf[s]->mix_num, topthres[s]);
+    /* sum */
     for(i=0;i<gc->OP_calced_num;i++) {
       gc->OP_calced_score[i] += state->pdf[s]->bweight[gc->OP_calced_id[i]];
     }
@@ -363,7 +501,6 @@ gmm_calc_mix(GMMCalc *gc, HTK_HMM_State *state)
     if (logprob <= LOG_ZERO) continue;
     /* sum all the obtained mixture scores */
     logprobsum += logprob * stream_weight;
-
   }
   if (logprobsum == 0.0) return(LOG_ZERO); /* no valid stream */
   if (logprobsum <= LOG_ZERO) return(LOG_ZERO);	/* lowest == LOG_ZERO */
@@ -372,37 +509,43 @@ gmm_calc_mix(GMMCalc *gc, HTK_HMM_State *state)
 
 /** 
  * <JA>
- * 入力の指定フレームにおけるGMM状態のスコアを求めるメイン関数. 
+ * 入力の指定フレームについて，全GMMのガウス分布をまとめて計算する. 
+ * 共通上位Kが指定されている場合はそのしきい値を求める. 
  * 
  * @param gc [i/o] GMM計算用ワークエリア
  * @param t [in] 計算するフレーム
- * @param stateinfo [in] GMM状態
  * @param param [in] 入力ベクトル系列
- * 
- * @return 出力確率の対数スコア
+ * @param topthres [out] 各ストリームの上位Kしきい値
  * </JA>
  * <EN>
- * Main function to compute the output probability of a GMM state for
- * the specified input frame.
+ * Compute Gaussians of all GMMs at once for the specified input frame.
+ * If shared top-K is specified, the threshold will also be computed.
  * 
  * @param gc [i/o] work area for GMM calculation
  * @param t [in] time frame on which the output probability should be computed
- * @param stateinfo [in] GMM state
  * @param param [in] input vector sequence
- * 
- * @return the log output probability.
+ * @param topthres [out] threshold of shared top-K for each stream
  * </EN>
  */
-static LOGPROB
-outprob_state_nocache(GMMCalc *gc, int t, HTK_HMM_State *stateinfo, HTK_Param *param)
+static void
+gmm_pack_proceed(GMMCalc *gc, int t, HTK_Param *param, LOGPROB *topthres)
 {
-  int d, i;
-  /* set global values for outprob functions to access them */
-  for(d=0,i=0;i<gc->OP_nstream;i++) {
-    gc->OP_vec_stream[i] = &(param->parvec[t][d]);
-    d += gc->OP_veclen_stream[i];
+  int d, s;
+  GMMPack *pk;
+
+  for(d=0,s=0;s<gc->OP_nstream;s++) {
+    gc->OP_vec_stream[s] = &(param->parvec[t][d]);
+    d += gc->OP_veclen_stream[s];
+  }
+  for(s=0;s<gc->OP_nstream;s++) {
+    pk = &(gc->pack[s]);
+    gmm_pack_compute(pk, gc->OP_vec_stream[s], gc->OP_veclen_stream[s]);
+    topthres[s] = LOG_ZERO;
+    if (gc->pack_topk > 0 && gc->pack_topk < pk->num) {
+      memcpy(pk->sorted, pk->score, sizeof(LOGPROB) * pk->num);
+      topthres[s] = gmm_select_kth(pk->sorted, pk->num, gc->pack_topk - 1);
+    }
   }
-  return(gmm_calc_mix(gc, stateinfo));
 }
 
 /************************************************************************/
@@ -499,6 +642,10 @@ gmm_init(Recog *recog)
     gmm->variance_inversed = TRUE;
   }
 
+  /* pack all Gaussians for batched computation */
+  gmm_pack_init(gc, gmm);
+  gc->pack_topk = recog->jconf->reject.gmm_shared_topk;
+
   return TRUE;
 }
 
@@ -578,6 +725,7 @@ gmm_proceed(Recog *recog)
   int i;
   MFCCCalc *mfcc;
   LOGPROB score;
+  LOGPROB topthres[MAXSTREAMNUM];
 #ifdef GMM_VAD
   LOGPROB max_n;
   LOGPROB max_v;
@@ -594,9 +742,12 @@ gmm_proceed(Recog *recog)
   max_n = max_v = LOG_ZERO;
 #endif
 
+  /* compute Gaussians of all GMMs at once */
+  gmm_pack_proceed(gc, mfcc->f, mfcc->param, topthres);
+
   i = 0;
   for(d=recog->gmm->start;d;d=d->next) {
-    score = outprob_state_nocache(gc, mfcc->f, d->s[1], mfcc->param);
+    score = gmm_calc_mix_packed(gc, i, d->s[1], topthres);
     gc->gmm_score[i] += score;
 #ifdef GMM_VAD
     if (gc->is_voice[i]) {
@@ -758,6 +909,7 @@ void
 gmm_free(Recog *recog)
 {
   if (recog->gc) {
+    gmm_pack_free(recog->gc);
     free(recog->gc->OP_calced_score);
     free(recog->gc->OP_calced_id);
     free(recog->gc->is_voice);
@@ -120,6 +120,7 @@ wordgraph_new(WORD_ID wid, HMM_Logical *headphone, HMM_Logical *tailphone, int l
     //new->amavg = (gscore_head - gscore_tail - lscore) / (float)(rightframe - leftframe + 1);
     new->amavg = (gscore_head - gscore_tail) / (float)(rightframe - leftframe + 1);
   }
+  new->amscore = LOG_ZERO;
   new->headphone = headphone;
   new->tailphone = tailphone;
   new->leftwordmaxnum = FANOUTSTEP;
@@ -140,6 +141,9 @@ wordgraph_new(WORD_ID wid, HMM_Logical *headphone, HMM_Logical *tailphone, int l
 
   new->graph_cm = 0.0;
 
+  new->hashnext = NULL;
+  new->seq = 0;
+
 #ifdef GDEBUG
  {
    int i;
@@ -187,6 +191,220 @@ wordgraph_free(WordGraph *wg)
   free(wg);
 }
 
+/**************************************************************/
+/* hash index of graph words */
+
+/** 
+ * <JA>
+ * インデックスのバケツ番号を求める. 
+ * 
+ * @param idx [in] インデックス
+ * @param wid [in] 単語ID
+ * @param lefttime [in] 始端時刻
+ * @param righttime [in] 終端時刻
+ * 
+ * @return バケツ番号
+ * </JA>
+ * <EN>
+ * Compute bucket number of the index.
+ * 
+ * @param idx [in] index
+ * @param wid [in] word ID
+ * @param lefttime [in] beginning frame
+ * @param righttime [in] end frame
+ * 
+ * @return the bucket number.
+ * </EN>
+ */
+static int
+wgindex_hash(WordGraphIndex *idx, WORD_ID wid, int lefttime, int righttime)
+{
+  unsigned int h;
+
+  if (idx->width > 1) {
+    /* time-bucketed key: right time is not used */
+    h = (unsigned int)wid * 7919 + (unsigned int)(lefttime / idx->width);
+  } else {
+    h = ((unsigned int)wid * 7919 + (unsigned int)lefttime) * 31 + (unsigned int)righttime;
+  }
+  h ^= (h >> 13);
+  return(h & (idx->size - 1));
+}
+
+/** 
+ * <JA>
+ * 単語グラフリストからインデックスを作り直す. 各バケツ内の単語は
+ * リストと同じ順序で並ぶ. また各単語の seq にリスト上の順番を付与する. 
+ * 
+ * @param idx [i/o] インデックス
+ * @param root [in] 単語グラフのルートノード
+ * @param size [in] バケツ数 (2のべき乗)
+ * </JA>
+ * <EN>
+ * Rebuild the index from the word list.  Words in each bucket are chained
+ * in the same order as the list, and @a seq of each word is set to its
+ * position in the list.
+ * 
+ * @param idx [i/o] index
+ * @param root [in] root node of the word graph
+ * @param size [in] number of buckets (power of 2)
+ * </EN>
+ */
+static void
+wgindex_rebuild(WordGraphIndex *idx, WordGraph *root, int size)
+{
+  WordGraph *wg, *prev, *next;
+  int i, h;
+
+  if (idx->size != size) {
+    if (idx->bucket != NULL) free(idx->bucket);
+    idx->bucket = (WordGraph **)mymalloc(sizeof(WordGraph *) * size);
+    idx->size = size;
+  }
+  for(i=0;i<size;i++) idx->bucket[i] = NULL;
+
+  /* chain words in reverse order ... */
+  idx->num = 0;
+  for(wg=root;wg;wg=wg->next) {
+    wg->seq = idx->num++;
+    h = wgindex_hash(idx, wg->wid, wg->lefttime, wg->righttime);
+    wg->hashnext = idx->bucket[h];
+    idx->bucket[h] = wg;
+  }
+  /* ... and then reverse each chain to get the list order */
+  for(i=0;i<size;i++) {
+    prev = NULL;
+    for(wg=idx->bucket[i];wg;wg=next) {
+      next = wg->hashnext;
+      wg->hashnext = prev;
+      prev = wg;
+    }
+    idx->bucket[i] = prev;
+  }
+}
+
+/** 
+ * <JA>
+ * 単語グラフのインデックスを初期化する. 
+ * 
+ * @param idx [out] インデックス
+ * @param width [in] 始端時刻のバケツ幅 (1 で完全一致用)
+ * </JA>
+ * <EN>
+ * Initialize an empty word graph index.
+ * 
+ * @param idx [out] index
+ * @param width [in] time width of bucket for left time (1 for exact match)
+ * </EN>
+ *
+ * @callgraph
+ * @callergraph
+ * 
+ */
+void
+wordgraph_index_init(WordGraphIndex *idx, int width)
+{
+  int i;
+
+  idx->size = WGINDEX_INITSIZE;
+  idx->bucket = (WordGraph **)mymalloc(sizeof(WordGraph *) * idx->size);
+  for(i=0;i<idx->size;i++) idx->bucket[i] = NULL;
+  idx->num = 0;
+  idx->width = (width > 1) ? width : 1;
+  idx->lookups = idx->probes = 0;
+}
+
+/** 
+ * <JA>
+ * 単語グラフのインデックスを解放する. 単語自体は解放しない. 
+ * 
+ * @param idx [i/o] インデックス
+ * </JA>
+ * <EN>
+ * Free the word graph index.  The indexed words are not freed.
+ * 
+ * @param idx [i/o] index
+ * </EN>
+ *
+ * @callgraph
+ * @callergraph
+ * 
+ */
+void
+wordgraph_index_free(WordGraphIndex *idx)
+{
+  if (idx->bucket != NULL) free(idx->bucket);
+  idx->bucket = NULL;
+  idx->size = idx->num = 0;
+}
+
+/** 
+ * <JA>
+ * 単語グラフ全体からインデックスを構築する. 
+ * 
+ * @param idx [out] インデックス
+ * @param root [in] 単語グラフのルートノード
+ * @param width [in] 始端時刻のバケツ幅 (1 で完全一致用)
+ * </JA>
+ * <EN>
+ * Build an index of all words in a word graph.
+ * 
+ * @param idx [out] index
+ * @param root [in] root node of the word graph
+ * @param width [in] time width of bucket for left time (1 for exact match)
+ * </EN>
+ */
+static void
+wordgraph_index_build(WordGraphIndex *idx, WordGraph *root, int width)
+{
+  WordGraph *wg;
+  int count, size;
+
+  count = 0;
+  for(wg=root;wg;wg=wg->next) count++;
+  size = WGINDEX_INITSIZE;
+  while(size < count) size *= 2;
+
+  idx->bucket = NULL;
+  idx->size = 0;
+  idx->width = (width > 1) ? width : 1;
+  idx->lookups = idx->probes = 0;
+  wgindex_rebuild(idx, root, size);
+}
+
+/** 
+ * <JA>
+ * 単語グラフリストの先頭に追加された単語をインデックスに登録する. 
+ * 
+ * @param idx [i/o] インデックス
+ * @param wg [in] 追加された単語 (= @a root)
+ * @param root [in] 単語グラフのルートノード
+ * </JA>
+ * <EN>
+ * Register a word just prepended to the word list to the index.
+ * 
+ * @param idx [i/o] index
+ * @param wg [in] the prepended word (= @a root)
+ * @param root [in] root node of the word graph
+ * </EN>
+ */
+static void
+wordgraph_index_add_head(WordGraphIndex *idx, WordGraph *wg, WordGraph *root)
+{
+  int h;
+
+  if (idx->num >= idx->size * 2) {
+    /* too crowded: expand buckets and re-index whole list including wg */
+    wgindex_rebuild(idx, root, idx->size * 2);
+    return;
+  }
+  h = wgindex_hash(idx, wg->wid, wg->lefttime, wg->righttime);
+  wg->hashnext = idx->bucket[h];
+  idx->bucket[h] = wg;
+  idx->num++;
+}
+
+
 /**************************************************************/
 /* Handling contexts */
 
@@ -764,6 +982,30 @@ wordgraph_exec_erase(WordGraph **rootp)
   return(count);
 }
 
+/** 
+ * <JA>
+ * インデックス付与時のリスト上の順番で並べるための qsort コールバック
+ * 
+ * @param x [in] 要素１
+ * @param y [in] 要素２
+ * 
+ * @return x が後なら正, x が前なら負, 同じなら 0 を返す. 
+ * </JA>
+ * <EN>
+ * qsort callback to sort words by their list order at indexing.
+ * 
+ * @param x [in] element 1
+ * @param y [in] element 2
+ * 
+ * @return positive if x comes later, negative if earlier, 0 if the same.
+ * </EN>
+ */
+static int
+compare_seq(WordGraph **x, WordGraph **y)
+{
+  return((*x)->seq - (*y)->seq);
+}
+
 /** 
  * <JA>
  * グラフソート用 qsort コールバック
@@ -1503,13 +1745,17 @@ wordgraph_compaction_thesame_sub(WordGraph **rootp, int *rest_ret, int *merged_r
 {
   WordGraph *wg, *we;
   int i, count, erased, merged;
+  WordGraphIndex idx;
+
+  /* candidates are words in the same bucket after wg */
+  wordgraph_index_build(&idx, *rootp, 1);
 
   count = 0;
   merged = 0;
   for(wg=*rootp;wg;wg=wg->next) {
     count++;
     if (wg->mark == TRUE) continue;
-    for(we=wg->next;we;we=we->next) {
+    for(we=wg->hashnext;we;we=we->hashnext) {
       if (we->mark == TRUE) continue;
       /* find the word with exactly the same time and score */
       if (wg->wid == we->wid &&
@@ -1537,6 +1783,7 @@ wordgraph_compaction_thesame_sub(WordGraph **rootp, int *rest_ret, int *merged_r
       }
     }
   }
+  wordgraph_index_free(&idx);
 
   erased = wordgraph_exec_erase(rootp);
 
@@ -1710,6 +1957,7 @@ wordgraph_compaction_exacttime(WordGraph **rootp, RecogProcess *r)
 {
   WordGraph *wg, *we;
   int i, count, erased;
+  WordGraphIndex idx;
 
   if (r->config->graph.graph_merge_neighbor_range < 0) {
     if (verbose_flag) jlog("STAT: graphout: step 4: SKIP (merge the same words with same boundary to the most likely one\n");
@@ -1718,11 +1966,15 @@ wordgraph_compaction_exacttime(WordGraph **rootp, RecogProcess *r)
 
   if (verbose_flag) jlog("STAT: graphout: step 4: merge same words with same boundary to the most likely one\n");
 
+  /* candidates are words in the same bucket after wg */
+  wordgraph_index_build(&idx, *rootp, 1);
+
   count = 0;
   for(wg=*rootp;wg;wg=wg->next) {
     count++;
     if (wg->mark == TRUE) continue;
-    for(we=wg->next;we;we=we->next) {
+    for(we=wg->hashnext;we;we=we->hashnext) {
+      idx.probes++;
       if (we->mark == TRUE) continue;
       /* find same words at same position */
       if (wg->wid == we->wid &&
@@ -1755,6 +2007,8 @@ wordgraph_compaction_exacttime(WordGraph **rootp, RecogProcess *r)
       }
     }
   }
+  if (verbose_flag) jlog("STAT: graphout: %d words examined by index\n", idx.probes);
+  wordgraph_index_free(&idx);
   erased = wordgraph_exec_erase(rootp);
   if (verbose_flag) jlog("STAT: graphout: %d words merged, %d words left in lattice\n", erased, count-erased);
 
@@ -1795,51 +2049,90 @@ void
 wordgraph_compaction_neighbor(WordGraph **rootp, RecogProcess *r)
 {
   WordGraph *wg, *we;
-  int i, count, erased;
+  int i, j, k, count, erased;
+  int range;
+  WordGraphIndex idx;
+  int h[3];
+  WordGraph **cand;
+  int candnum, candmax;
+
+  range = r->config->graph.graph_merge_neighbor_range;
 
-  if (r->config->graph.graph_merge_neighbor_range <= 0) {
+  if (range <= 0) {
     if (verbose_flag) jlog("STAT: graphout: step 5: SKIP (merge the same words around)\n");
     return;
   }
 
-  if (verbose_flag) jlog("STAT: graphout: step 5: merge same words around, with %d frame margin\n", r->config->graph.graph_merge_neighbor_range);
+  if (verbose_flag) jlog("STAT: graphout: step 5: merge same words around, with %d frame margin\n", range);
+
+  /* index by left time in (range+1) frame buckets: words whose left time
+     is within the range always fall in the same or adjacent buckets */
+  wordgraph_index_build(&idx, *rootp, range + 1);
+  candmax = FANOUTSTEP;
+  cand = (WordGraph **)mymalloc(sizeof(WordGraph *) * candmax);
 
   count = 0;
   for(wg=*rootp;wg;wg=wg->next) {
     count++;
     if (wg->mark == TRUE) continue;
-    for(we=wg->next;we;we=we->next) {
-      if (we->mark == TRUE) continue;
-      if (wg->wid == we->wid &&
-	  abs(wg->lefttime - we->lefttime) <= r->config->graph.graph_merge_neighbor_range &&
-	  abs(wg->righttime - we->righttime) <= r->config->graph.graph_merge_neighbor_range) {
-	/* merge contexts */
-	merge_contexts(wg, we);
-	/* swap contexts of left / right contexts */
-	for(i=0;i<we->leftwordnum;i++) {
-	  swap_rightword(we->leftword[i], we, wg, we->left_lscore[i]);
-	}
-	for(i=0;i<we->rightwordnum;i++) {
-	  swap_leftword(we->rightword[i], we, wg, we->right_lscore[i]);
+    /* gather words after wg in the list from the neighbor buckets */
+    candnum = 0;
+    for(k=0;k<3;k++) {
+      h[k] = -1;
+      if (wg->lefttime + (k - 1) * idx.width < 0) continue;
+      h[k] = wgindex_hash(&idx, wg->wid, wg->lefttime + (k - 1) * idx.width, 0);
+      for(j=0;j<k;j++) if (h[j] == h[k]) break;
+      if (j < k) continue;	/* already scanned */
+      for(we=idx.bucket[h[k]];we;we=we->hashnext) {
+	idx.probes++;
+	if (we->seq <= wg->seq) continue;
+	if (we->mark == TRUE) continue;
+	if (wg->wid == we->wid &&
+	    abs(wg->lefttime - we->lefttime) <= range &&
+	    abs(wg->righttime - we->righttime) <= range) {
+	  if (candnum >= candmax) {
+	    candmax += FANOUTSTEP;
+	    cand = (WordGraph **)myrealloc(cand, sizeof(WordGraph *) * candmax);
+	  }
+	  cand[candnum++] = we;
 	}
-	/* keep the max score */
-	if (wg->fscore_head < we->fscore_head) {
-	  wg->headphone = we->headphone;
-	  wg->tailphone = we->tailphone;
-	  wg->fscore_head = we->fscore_head;
-	  wg->fscore_tail = we->fscore_tail;
-	  wg->gscore_head = we->gscore_head;
-	  wg->gscore_tail = we->gscore_tail;
-	  wg->lscore_tmp = we->lscore_tmp;
+      }
+    }
+    /* merge them in the list order */
+    if (candnum > 1) {
+      qsort(cand, candnum, sizeof(WordGraph *), (int (*)(const void *, const void *))compare_seq);
+    }
+    for(j=0;j<candnum;j++) {
+      we = cand[j];
+      /* merge contexts */
+      merge_contexts(wg, we);
+      /* swap contexts of left / right contexts */
+      for(i=0;i<we->leftwordnum;i++) {
+	swap_rightword(we->leftword[i], we, wg, we->left_lscore[i]);
+      }
+      for(i=0;i<we->rightwordnum;i++) {
+	swap_leftword(we->rightword[i], we, wg, we->right_lscore[i]);
+      }
+      /* keep the max score */
+      if (wg->fscore_head < we->fscore_head) {
+	wg->headphone = we->headphone;
+	wg->tailphone = we->tailphone;
+	wg->fscore_head = we->fscore_head;
+	wg->fscore_tail = we->fscore_tail;
+	wg->gscore_head = we->gscore_head;
+	wg->gscore_tail = we->gscore_tail;
+	wg->lscore_tmp = we->lscore_tmp;
 #ifdef CM_SEARCH
-	  wg->cmscore = we->cmscore;
+	wg->cmscore = we->cmscore;
 #endif
-	  wg->amavg = we->amavg;
-	}
-	we->mark = TRUE;
+	wg->amavg = we->amavg;
       }
+      we->mark = TRUE;
     }
   }
+  if (verbose_flag) jlog("STAT: graphout: %d words examined by index\n", idx.probes);
+  free(cand);
+  wordgraph_index_free(&idx);
   erased = wordgraph_exec_erase(rootp);
   if (verbose_flag) jlog("STAT: graphout: %d words merged, %d words left in lattice\n", erased, count-erased);
 
@@ -1850,6 +2143,136 @@ wordgraph_compaction_neighbor(WordGraph **rootp, RecogProcess *r)
  
 }
 
+/** 
+ * <JA>
+ * 単語の音響スコアを，指定区間に対する Viterbi 照合で求める. 
+ * 
+ * @param wg [in] グラフ単語
+ * @param r [in] 認識処理インスタンス
+ * 
+ * @return 区間 [lefttime..righttime] に対する単語の音響スコア
+ * </JA>
+ * <EN>
+ * Compute the acoustic score of a graph word by Viterbi matching on
+ * its segment.
+ * 
+ * @param wg [in] graph word
+ * @param r [in] recognition process instance
+ * 
+ * @return acoustic score of the word on [lefttime..righttime].
+ * </EN>
+ */
+static LOGPROB
+wordgraph_word_viterbi(WordGraph *wg, RecogProcess *r)
+{
+  HTK_HMM_INFO *hmminfo;
+  WORD_INFO *winfo;
+  HTK_Param *param;
+  HMMWork *wrk;
+  HMM_Logical **phones;
+  HMM *whmm;
+  A_CELL *ac;
+  LOGPROB *cur, *nxt, *tmp;
+  LOGPROB score;
+  int len, n, t, endt;
+
+  hmminfo = r->am->hmminfo;
+  winfo = r->lm->winfo;
+  param = r->am->mfcc->param;
+  wrk = r->wchmm->hmmwrk;
+
+  /* phone sequence with the context dependent phones at head and tail */
+  len = winfo->wlen[wg->wid];
+  phones = (HMM_Logical **)mymalloc(sizeof(HMM_Logical *) * len);
+  for(n=0;n<len;n++) phones[n] = winfo->wseq[wg->wid][n];
+  phones[0] = wg->headphone;
+  phones[len-1] = wg->tailphone;
+  whmm = new_make_word_hmm(hmminfo, phones, len, NULL);
+  free(phones);
+  if (whmm == NULL) return LOG_ZERO;
+
+  cur = (LOGPROB *)mymalloc(sizeof(LOGPROB) * whmm->len);
+  nxt = (LOGPROB *)mymalloc(sizeof(LOGPROB) * whmm->len);
+  for(n=0;n<whmm->len;n++) cur[n] = LOG_ZERO;
+  if (hmminfo->multipath) {
+    cur[0] = 0.0;
+    t = wg->lefttime;
+    endt = wg->righttime + 1;
+  } else {
+    cur[0] = outprob(wrk, wg->lefttime, &(whmm->state[0]), param);
+    t = wg->lefttime + 1;
+    endt = wg->righttime;
+  }
+  for(;t<=endt;t++) {
+    for(n=0;n<whmm->len;n++) nxt[n] = LOG_ZERO;
+    for(n=0;n<whmm->len;n++) {
+      if (cur[n] <= LOG_ZERO) continue;
+      for(ac=whmm->state[n].ac;ac;ac=ac->next) {
+	if (nxt[ac->arc] < cur[n] + ac->a) nxt[ac->arc] = cur[n] + ac->a;
+      }
+    }
+    tmp = cur; cur = nxt; nxt = tmp;
+    /* transition to the exit state after the last frame */
+    if (hmminfo->multipath && t == endt) break;
+    for(n=0;n<whmm->len;n++) {
+      if (hmminfo->multipath && whmm->state[n].out.state == NULL) continue;
+      if (cur[n] > LOG_ZERO) cur[n] += outprob(wrk, t, &(whmm->state[n]), param);
+    }
+  }
+  score = cur[whmm->len-1];
+
+  free(cur);
+  free(nxt);
+  free_hmm(whmm);
+
+  return score;
+}
+
+/** 
+ * <JA>
+ * @brief  グラフ後処理その６：音響スコアの再計算
+ * 
+ * 各グラフ単語の最終的な単語区間に対して Viterbi 照合を行い，単語の
+ * 音響スコアを amscore に求める. 探索中に求めた amavg は境界の調整や
+ * 単語の束ねによって区間が変わると正しくなくなるため，グラフを別の
+ * 言語モデルで再評価する場合に用いる. amavg および事後確率の計算は
+ * 変更しない. -graphamscore 指定時のみ行う. 
+ * 
+ * @param root [i/o] 単語グラフのルートノード
+ * @param r [in] 認識処理インスタンス
+ * </JA>
+ * <EN>
+ * @brief  Post-processing step 6: Re-compute acoustic scores
+ * 
+ * The acoustic score of each graph word is re-computed into amscore
+ * by Viterbi matching of the word on its final segment.  The amavg
+ * given on search is no longer valid after the boundary has been
+ * adjusted or the words have been bundled, so this is for rescoring
+ * the graph with another language model afterwards.  The amavg and
+ * the posterior computation are not changed.  Performed only when
+ * -graphamscore is specified.
+ * 
+ * @param root [i/o] root node of a word graph
+ * @param r [in] recognition process instance
+ * </EN>
+ *
+ * @callgraph
+ * @callergraph
+ * 
+ */
+void
+wordgraph_compute_amscore(WordGraph *root, RecogProcess *r)
+{
+  WordGraph *wg;
+
+  if (verbose_flag) jlog("STAT: graphout: step 6: re-compute acoustic scores on the word segments\n");
+
+  for(wg=root;wg;wg=wg->next) {
+    if (wg->righttime - wg->lefttime + 1 <= 0) continue;
+    wg->amscore = wordgraph_word_viterbi(wg, r);
+  }
+}
+
 /**************************************************************/
 /* generation of graph word candidates while search */
 
@@ -1909,7 +2332,7 @@ wordgraph_assign(WORD_ID wid, WORD_ID wid_left, WORD_ID wid_right, int leftframe
   /* find context dependent phones at head and tail */
   l = winfo->wseq[wid][winfo->wlen[wid]-1];
   if (wid_right != WORD_INVALID) {
-    ret = get_right_context_HMM(l, winfo->wseq[wid_right][0]->name, r->am->hmminfo);
+    ret = get_right_context_logical(l, winfo->wseq[wid_right][0], r->am->hmminfo);
     if (ret != NULL) l = ret;
   }
   if (winfo->wlen[wid] > 1) {
@@ -1917,7 +2340,7 @@ wordgraph_assign(WORD_ID wid, WORD_ID wid_left, WORD_ID wid_right, int leftframe
     l = winfo->wseq[wid][0];
   }
   if (wid_left != WORD_INVALID) {
-    ret = get_left_context_HMM(l, winfo->wseq[wid_left][winfo->wlen[wid_left]-1]->name, r->am->hmminfo);
+    ret = get_left_context_logical(l, winfo->wseq[wid_left][winfo->wlen[wid_left]-1], r->am->hmminfo);
     if (ret != NULL) l = ret;
   }
   head = l;
@@ -1939,6 +2362,7 @@ wordgraph_assign(WORD_ID wid, WORD_ID wid_left, WORD_ID wid_right, int leftframe
  * @param wg [i/o] 登録するグラフ単語候補
  * @param right [i/o] @a wg の右コンテキストとなる単語
  * @param root [i/o] 確定済み単語グラフのルートノードへのポインタ
+ * @param index [i/o] 確定済み単語グラフのインデックス (NULL なら使用しない)
  * </JA>
  * <EN>
  * Register a graph word candidate to the word graph as a member.
@@ -1947,6 +2371,7 @@ wordgraph_assign(WORD_ID wid, WORD_ID wid_left, WORD_ID wid_right, int leftframe
  * @param wg [i/o] graph word candidate to be registered
  * @param right [i/o] right context graph word
  * @param root [i/o] pointer to root node of already registered word graph
+ * @param index [i/o] index of the registered word graph, or NULL if not used
  * </EN>
  *
  * @callgraph
@@ -1954,11 +2379,12 @@ wordgraph_assign(WORD_ID wid, WORD_ID wid_left, WORD_ID wid_right, int leftframe
  * 
  */
 void
-wordgraph_save(WordGraph *wg, WordGraph *right, WordGraph **root)
+wordgraph_save(WordGraph *wg, WordGraph *right, WordGraph **root, WordGraphIndex *index)
 {
   if (wg != NULL) {
     wg->next = *root;
     *root = wg;
+    if (index != NULL) wordgraph_index_add_head(index, wg, *root);
     wg->saved = TRUE;
     wordgraph_add_leftword(right, wg, wg->lscore_tmp);
     wordgraph_add_rightword(wg, right, wg->lscore_tmp);
@@ -1979,6 +2405,7 @@ wordgraph_save(WordGraph *wg, WordGraph *right, WordGraph **root)
  * 
  * @param now [i/o] 単語グラフ候補
  * @param root [i/o] 確定済み単語グラフのルートノードへのポインタ
+ * @param index [i/o] 確定済み単語グラフのインデックス (NULL ならリストを走査)
  * @param next_wid [in] 次単語仮説
  * @param merged_p [out] 探索を中止すべきなら TRUE，続行してよければ
  * FALSE が格納される (GRAPHOUT_SEARCH 定義時)
@@ -2002,6 +2429,7 @@ wordgraph_save(WordGraph *wg, WordGraph *right, WordGraph **root)
  * 
  * @param now [i/o] graph word candidate
  * @param root [i/o] pointer to root node of already registered word graph
+ * @param index [i/o] index of the registered word graph, or NULL to scan the whole list
  * @param next_wid [in] next word on search
  * @param merged_p [out] will be set to TRUE if search should be terminated,
  * or FALSE if search should be proceeded (when GRAPHOUT_SEARCH defined)
@@ -2017,7 +2445,7 @@ wordgraph_save(WordGraph *wg, WordGraph *right, WordGraph **root)
  * 
  */
 WordGraph *
-wordgraph_check_merge(WordGraph *now, WordGraph **root, WORD_ID next_wid, boolean *merged_p, JCONF_SEARCH *jconf)
+wordgraph_check_merge(WordGraph *now, WordGraph **root, WordGraphIndex *index, WORD_ID next_wid, boolean *merged_p, JCONF_SEARCH *jconf)
 {
   WordGraph *wg;
   int i;
@@ -2043,7 +2471,15 @@ wordgraph_check_merge(WordGraph *now, WordGraph **root, WORD_ID next_wid, boolea
   }
 #endif
 
-  for(wg=*root;wg;wg=wg->next) {
+  if (index != NULL) {
+    /* only words in the same bucket need to be checked */
+    index->lookups++;
+    wg = index->bucket[wgindex_hash(index, now->wid, now->lefttime, now->righttime)];
+  } else {
+    wg = *root;
+  }
+  for(;wg;wg=(index != NULL) ? wg->hashnext : wg->next) {
+    if (index != NULL) index->probes++;
     if (wg == now) continue;
 #ifdef GRAPHOUT_DYNAMIC
     /* skip already merged word */
@@ -2155,6 +2591,7 @@ wordgraph_check_merge(WordGraph *now, WordGraph **root, WORD_ID next_wid, boolea
  *   g_prev=右端での累積Viterbiスコア g(n-1) + LM(n)
  *   lscore=言語スコア LM(n)   (Julius の場合のみ)
  *   AMavg=フレーム平均音響尤度
+ *   AMscore=最終区間で再計算した単語の音響尤度 (-graphamscore 指定時)
  *   cmscore=単語信頼度
  * </pre>
  *
@@ -2178,6 +2615,7 @@ wordgraph_check_merge(WordGraph *now, WordGraph **root, WORD_ID next_wid, boolea
  *   g_prev="accumulated viterbi score at right edge (g(n-1) + LM(n)"
  *   lscore="language score LM(n)  (Julius only)"
  *   AMavg="average acoustic likelihood per frame"
+ *   AMscore="acoustic likelihood of the word re-computed on its final segment (with -graphamscore)"
  *   cmscore="confidence score"
  * </pre>
  * @param fp [in] file pointer to which output should go
@@ -2218,6 +2656,9 @@ put_wordgraph(FILE *fp, WordGraph *wg, WORD_INFO *winfo)
     if (wg->righttime - wg->lefttime + 1 != 0) {
       fprintf(fp, " AMavg=%f", wg->amavg);
     }
+    if (wg->amscore != LOG_ZERO) {
+      fprintf(fp, " AMscore=%f", wg->amscore);
+    }
 #ifdef CM_SEARCH
     fprintf(fp, " cmscore=%f", wg->cmscore);
 #endif
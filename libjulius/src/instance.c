@@ -170,9 +170,14 @@ j_process_am_free(PROCESS_AM *am)
 {
   /* HMMWork hmmwrk */
   outprob_free(&(am->hmmwrk));
-  if (am->hmminfo) hmminfo_free(am->hmminfo);
-  if (am->hmm_gs) hmminfo_free(am->hmm_gs);
-  if (am->dnn) dnn_free(am->dnn);
+  if (am->dnn_batch) {
+    j_dnn_batch_detach(am);
+  }
+  if (! am->shared) {
+    if (am->hmminfo) hmminfo_free(am->hmminfo);
+    if (am->hmm_gs) hmminfo_free(am->hmm_gs);
+    if (am->dnn) dnn_free(am->dnn);
+  }
   /* not free am->jconf  */
   free(am);
 }
@@ -210,6 +215,10 @@ j_process_lm_new(Recog *recog, JCONF_LM *lmconf)
   new->lmvar = lmconf->lmvar;
   new->gram_maxid = 0;
   new->global_modified = FALSE;
+  new->global_version = 0;
+  new->lexmap_word = NULL;
+  new->lexmap_cate = NULL;
+  new->lexmap_valid = FALSE;
 
   /* append to last */
   new->next = NULL;
@@ -239,11 +248,15 @@ j_process_lm_new(Recog *recog, JCONF_LM *lmconf)
 void
 j_process_lm_free(PROCESS_LM *lm)
 {
-  if (lm->winfo) word_info_free(lm->winfo);
-  if (lm->ngram) ngram_info_free(lm->ngram);
-  if (lm->grammars) multigram_free_all(lm->grammars);
-  if (lm->dfa) dfa_info_free(lm->dfa);
-  if (lm->dfa_forward) dfa_info_free(lm->dfa_forward);
+  if (! lm->shared) {
+    if (lm->winfo) word_info_free(lm->winfo);
+    if (lm->ngram) ngram_info_free(lm->ngram);
+    if (lm->grammars) multigram_free_all(lm->grammars);
+    if (lm->dfa) dfa_info_free(lm->dfa);
+    if (lm->dfa_forward) dfa_info_free(lm->dfa_forward);
+  }
+  if (lm->lexmap_word) free(lm->lexmap_word);
+  if (lm->lexmap_cate) free(lm->lexmap_cate);
   /* not free lm->jconf  */
   free(lm);
 }
@@ -856,7 +869,11 @@ j_recog_new()
 void
 j_recog_free(Recog *recog)
 {
-  if (recog->gmm) hmminfo_free(recog->gmm);
+  /* stop threads of recognition processes if any */
+  sr_parallel_free(recog);
+  pass2_async_free(recog);
+
+  if (recog->gmm && ! recog->shared) hmminfo_free(recog->gmm);
 
   if (recog->speech) free(recog->speech);
 
@@ -913,7 +930,7 @@ j_recog_free(Recog *recog)
   }
 
   /* jconf */
-  if (recog->jconf) {
+  if (recog->jconf && ! recog->shared) {
     j_jconf_free(recog->jconf);
   }
 
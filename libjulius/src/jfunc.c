@@ -648,6 +648,39 @@ j_adin_init(Recog *recog)
   return(ret);
 }
 
+/** 
+ * <EN>
+ * Initialize A/D-in with user-defined input functions.  The functions
+ * (ad_standby, ad_begin, ad_read, ...) should be set to recog->adin
+ * before calling this.  The speech detection parameters are set up
+ * from the configuration as j_adin_init() does.
+ * </EN>
+ * <JA>
+ * 利用者定義の入力関数で A/D-in を初期化する. 入力関数 (ad_standby,
+ * ad_begin, ad_read など) はこの関数を呼ぶ前に recog->adin に
+ * 設定しておくこと. 音声区間検出のパラメータは j_adin_init() と
+ * 同様に設定から与えられる. 
+ * </JA>
+ * 
+ * @param recog [in] engine instance
+ * @param arg [in] argument to be passed to ad_standby
+ * 
+ * @return TRUE on success, FALSE on failure.
+ * 
+ * @callgraph
+ * @callergraph
+ * @ingroup engine
+ */
+boolean
+j_adin_init_user(Recog *recog, void *arg)
+{
+  if (recog->jconf->input.type != INPUT_WAVEFORM) {
+    jlog("ERROR: j_adin_init_user: input is not waveform\n");
+    return FALSE;
+  }
+  return(adin_initialize_user(recog, arg));
+}
+
 /** 
  * <EN>
  * Return current input speech file name.  return NULL if the current
@@ -1345,6 +1378,9 @@ j_process_remove(Recog *recog, JCONF_SEARCH *sconf)
   RecogProcess *r, *r_prev;
   JCONF_SEARCH *sc, *sc_prev;
 
+  /* the 2nd pass running in background may refer to it */
+  pass2_async_wait(recog);
+
   if (sconf == NULL) {
     jlog("ERROR: j_process_remove: sconf == NULL\n");
     return FALSE;
@@ -1424,6 +1460,9 @@ j_process_lm_remove(Recog *recog, JCONF_LM *lmconf)
   PROCESS_LM *lm, *lm_prev;
   JCONF_LM *l, *l_prev;
 
+  /* the 2nd pass running in background may refer to it */
+  pass2_async_wait(recog);
+
   if (lmconf == NULL) {
     jlog("ERROR: j_process_lm_remove: lmconf == NULL\n");
     return FALSE;
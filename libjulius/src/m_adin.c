@@ -220,6 +220,18 @@ adin_setup_all(ADIn *adin, Jconf *jconf, void *arg)
       jlog("ERROR: m_adin: failed to ready input device\n");
       return FALSE;
     }
+  } else if (jconf->input.infreq > 0 && jconf->input.infreq != jconf->input.sfreq) {
+    /* setup for resampling from the device rate */
+    adin->ds = NULL;
+    if ((adin->rs = resample_new(jconf->input.infreq, jconf->input.sfreq)) == NULL) {
+      jlog("ERROR: m_adin: failed to set up resampling\n");
+      return FALSE;
+    }
+    adin->down_sample = TRUE;
+    if (adin_standby(adin, jconf->input.infreq, arg) == FALSE) { /* fail */
+      jlog("ERROR: m_adin: failed to ready input device\n");
+      return FALSE;
+    }
   } else {
     adin->ds = NULL;
     adin->down_sample = FALSE;
@@ -343,4 +355,44 @@ adin_initialize(Recog *recog)
   return TRUE;
 }
 
+/** 
+ * <JA>
+ * 利用者が recog->adin に与えた入力関数で音声入力をセットアップする. 
+ * ad_read ほかの関数と silence_cut_default, enable_thread はあらかじめ
+ * recog->adin に設定しておくこと. 
+ *
+ * @param recog [i/o] エンジンインスタンス
+ * @param arg [in] ad_standby に渡す引数
+ * 
+ * </JA>
+ * <EN>
+ * Set up audio input with input functions given by user in recog->adin.
+ * ad_read and other functions, silence_cut_default and enable_thread
+ * should be set to recog->adin beforehand.
+ * 
+ * @param recog [i/o] engine instance
+ * @param arg [in] argument to be passed to ad_standby
+ * </EN>
+ *
+ * @return TRUE on success, FALSE on failure.
+ *
+ * @callgraph
+ * @callergraph
+ */
+boolean
+adin_initialize_user(Recog *recog, void *arg)
+{
+  jlog("STAT: ###### initialize input device (user function)\n");
+
+  if (recog->adin->ad_read == NULL) {
+    jlog("ERROR: m_adin: no adin_read function given\n");
+    return FALSE;
+  }
+  if (adin_setup_all(recog->adin, recog->jconf, arg) == FALSE) {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 /* end of file */
@@ -290,6 +290,54 @@ j_jconf_finalize(Jconf *jconf)
 
   }
 
+  /* check for streaming commit of the 1st pass */
+  for(s=jconf->search_root;s;s=s->next) {
+    if (s->pass1.stream_commit <= 0) continue;
+    if (jconf->decodeopt.realtime_flag == FALSE) {
+      jlog("WARNING: m_chkparam: \"-streamcommit\" works only on on-the-fly decoding, ignored\n");
+      s->pass1.stream_commit = 0;
+      continue;
+    }
+    if (jconf->search_root->next != NULL) {
+      jlog("WARNING: m_chkparam: \"-streamcommit\" works only with a single recognition process, ignored\n");
+      s->pass1.stream_commit = 0;
+      continue;
+    }
+    if (s->successive.enabled || (s->lmconf->lmtype == LM_DFA && s->lmconf->lmvar == LM_DFA_WORD)) {
+      jlog("WARNING: m_chkparam: \"-streamcommit\" cannot be used with short-pause segmentation or isolated word recognition, ignored\n");
+      s->pass1.stream_commit = 0;
+      continue;
+    }
+    if (! s->compute_only_1pass) {
+      /* the 2nd pass cannot run on the partly discarded input */
+      jlog("WARNING: m_chkparam: \"-1pass\" is enabled for \"-streamcommit\"\n");
+      s->compute_only_1pass = TRUE;
+    }
+  }
+
+  /* check for hypothesis recombination of the 2nd pass */
+  for(s=jconf->search_root;s;s=s->next) {
+    if (s->pass2.recombine_mb <= 0) continue;
+    if (s->graph.lattice || s->graph.confnet) {
+      /* dropped hypotheses would be missing in the graph */
+      jlog("WARNING: m_chkparam: \"-recombine\" cannot be used with word graph output, ignored\n");
+      s->pass2.recombine_mb = 0;
+      continue;
+    }
+    if (s->pass2.nbest > 1 || s->output.output_hypo_maxnum > 1) {
+      /* dropped hypotheses may lead to other valid sentences */
+      jlog("WARNING: m_chkparam: \"-recombine\" cannot be used with N-best search (\"-n\" or \"-output\" > 1), ignored\n");
+      s->pass2.recombine_mb = 0;
+      continue;
+    }
+    if (s->lmconf->lmtype == LM_PROB && s->lmconf->lmvar == LM_NGRAM_USER) {
+      /* user LM may refer to the whole word history */
+      jlog("WARNING: m_chkparam: \"-recombine\" cannot be used with user-defined LM, ignored\n");
+      s->pass2.recombine_mb = 0;
+      continue;
+    }
+  }
+
   /* check option validity with the current lm type */
   /* just a warning message for user */
   for(s=jconf->search_root;s;s=s->next) {
@@ -322,6 +370,9 @@ j_jconf_finalize(Jconf *jconf)
       if (s->pass1.iw_cache_rate != 10) {
 	jlog("WARNING: m_chkparam: \"-iwcache\" only for N-gram, ignored\n");
       }
+      if (s->pass1.iw_cache_mb != 0) {
+	jlog("WARNING: m_chkparam: \"-iwcachemb\" only for N-gram, ignored\n");
+      }
 #endif
 #ifdef SEPARATE_BY_UNIGRAM
       if (lm->separate_wnum != 150) {
@@ -847,6 +847,96 @@ j_load_all(Recog *recog, Jconf *jconf)
   return TRUE;
 }
 
+/** 
+ * <JA>
+ * @brief  他のエンジンインスタンスとモデルを共有してセットアップする. 
+ *
+ * @a src に読み込み済みの音響モデル，言語モデル，辞書，文法，GMM を
+ * 読み込み直さずに参照する AM/LM 処理インスタンスを @a recog 内に生成する. 
+ * 設定 jconf も共有される. この後 j_final_fusion() を呼ぶことで，
+ * 木構造化辞書やワークエリアは @a recog 独自に確保され，二つの
+ * インスタンスを別スレッドで同時に認識に用いることができる. 
+ * DNN を用いる場合は，DNN バッチスケジューラにアタッチしてから
+ * 同時に用いること. 
+ *
+ * 共有されたモデルは @a recog の解放時には解放されない. @a recog は
+ * @a src より先に解放すること. また @a recog からは文法の変更は行えない. 
+ * </JA>
+ * <EN>
+ * @brief  Set up an engine instance sharing models with another.
+ *
+ * AM/LM process instances are created in @a recog, which refer to the
+ * acoustic models, language models, dictionaries, grammars and GMM
+ * already loaded in @a src instead of loading them again.  The jconf
+ * is also shared.  After this, j_final_fusion() will allocate the tree
+ * lexicon and work areas for @a recog only, so the two instances can
+ * run recognition at the same time on separate threads.  When DNN is
+ * used, attach both instances to a DNN batch scheduler before doing so.
+ *
+ * The shared models are not freed with @a recog, and @a recog should
+ * be freed before @a src.  Grammars cannot be modified from @a recog.
+ * </EN>
+ *
+ * @param recog [i/o] engine instance newly created by j_recog_new()
+ * @param src [in] engine instance whose models are already set up by j_final_fusion()
+ *
+ * @return TRUE on success, FALSE on failure.
+ *
+ * @callgraph
+ * @callergraph
+ * @ingroup instance
+ */
+boolean
+j_load_all_shared(Recog *recog, Recog *src)
+{
+  PROCESS_AM *am, *sam, *atmp;
+  PROCESS_LM *lm, *slm;
+
+  if (recog->amlist != NULL || recog->lmlist != NULL) {
+    jlog("ERROR: j_load_all_shared: models already loaded in the instance\n");
+    return FALSE;
+  }
+
+  /* share global jconf */
+  recog->jconf = src->jconf;
+  recog->shared = TRUE;
+
+  /* acoustic models */
+  for(sam=src->amlist;sam;sam=sam->next) {
+    am = j_process_am_new(recog, sam->config);
+    am->hmminfo = sam->hmminfo;
+    am->hmm_gs = sam->hmm_gs;
+    am->dnn = sam->dnn;
+    am->shared = TRUE;
+  }
+
+  /* language models */
+  for(slm=src->lmlist;slm;slm=slm->next) {
+    lm = j_process_lm_new(recog, slm->config);
+    /* assign AM process instance at the same position */
+    for(sam=src->amlist,atmp=recog->amlist;sam;sam=sam->next,atmp=atmp->next) {
+      if (sam == slm->am) break;
+    }
+    lm->am = atmp;
+    lm->winfo = slm->winfo;
+    lm->ngram = slm->ngram;
+    lm->grammars = slm->grammars;
+    lm->gram_maxid = slm->gram_maxid;
+    lm->dfa = slm->dfa;
+    lm->dfa_forward = slm->dfa_forward;
+    lm->global_version = slm->global_version;
+    lm->lmfunc = slm->lmfunc;
+    lm->shared = TRUE;
+  }
+
+  /* GMM */
+  recog->gmm = src->gmm;
+
+  jlog("STAT: models shared with another engine instance\n");
+
+  return TRUE;
+}
+
 /** 
  * <EN>
  * Check if parameter extraction configuration is the same between an AM
@@ -1218,7 +1308,7 @@ j_launch_recognition_instance(Recog *recog, JCONF_SEARCH *sconf)
     p->trellis_beam_width = set_beam_width(p->wchmm, p->config->pass1.specified_trellis_beam_width);
 
     /* initialize cache for factoring */
-    max_successor_cache_init(p->wchmm);
+    max_successor_cache_init(p->wchmm, p->config);
   }
 
   /* backtrellis initialization */
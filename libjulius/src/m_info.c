@@ -316,6 +316,9 @@ print_engine_info(Recog *recog)
     jlog("\n");
     jlog("     GMM definition file = %s\n", jconf->reject.gmm_filename);
     jlog("          GMM gprune num = %d\n", jconf->reject.gmm_gprune_num);
+    if (jconf->reject.gmm_shared_topk > 0) {
+      jlog("   shared top-K Gaussians = %d\n", jconf->reject.gmm_shared_topk);
+    }
     if (jconf->reject.gmm_reject_cmn_string != NULL) {
       jlog("     GMM names to reject = %s\n", jconf->reject.gmm_reject_cmn_string);
     }
@@ -565,8 +568,8 @@ print_engine_info(Recog *recog)
 	jlog("\troot node to be cached = %d (all)\n", len);
 #endif
 #ifdef HASH_CACHE_IW
-	num = (r->config->pass1.iw_cache_rate * r->lm->ngram->max_word_num) / 100;
-	jlog("\tword ends to be cached = %d / %d\n", num, r->lm->ngram->max_word_num);
+	num = r->wchmm->lmcache.iw_cache_num;
+	jlog("\tword ends to be cached = %d / %d (%d-way LRU)\n", num, r->lm->ngram->max_word_num, IW_CACHE_WAYS);
 #else
 	num = r->lm->ngram->max_word_num;
 	jlog("\tword ends to be cached = %d (all)\n", num);
@@ -637,6 +640,16 @@ print_engine_info(Recog *recog)
       jlog("\t(-bs)score pruning thres= %f\n", r->config->pass1.score_pruning_width);
     }
 #endif
+    if (r->config->pass1.lookahead_frames > 0) {
+      jlog("\t(-lookahead)phone lookahead= %d frames, width %f\n", r->config->pass1.lookahead_frames, r->config->pass1.lookahead_width);
+    } else {
+      jlog("\t(-lookahead)phone lookahead= disabled\n");
+    }
+    if (r->config->pass1.stream_commit > 0) {
+      jlog("\t(-streamcommit)word commit= every %d frames\n", r->config->pass1.stream_commit);
+    } else {
+      jlog("\t(-streamcommit)word commit= disabled\n");
+    }
     jlog("\t(-n)search candidate num= %d\n", r->config->pass2.nbest);
     jlog("\t(-s)  search stack size = %d\n", r->config->pass2.stack_size);
     jlog("\t(-m)    search overflow = after %d hypothesis poped\n", r->config->pass2.hypo_overflow);
@@ -658,9 +671,15 @@ print_engine_info(Recog *recog)
       jlog("\t(-b2)  pass2 beam width = %d\n", r->config->pass2.enveloped_bestfirst_width);
     }
     jlog("\t(-lookuprange)lookup range= %d  (tm-%d <= t <tm+%d)\n",r->config->pass2.lookup_range,r->config->pass2.lookup_range,r->config->pass2.lookup_range);
+    jlog("\t   back trellis word size = %d bytes, allocated per %d words\n", (int)sizeof(TRELLIS_ATOM), 1 << BT_CHUNK_BITS);
 #ifdef SCAN_BEAM
     jlog("\t(-sb)2nd scan beamthres = %.1f (in logscore)\n", r->config->pass2.scan_beam_thres);
 #endif
+    if (r->config->pass2.recombine_mb > 0) {
+      jlog("\t(-recombine)recombination= %d MB cache\n", r->config->pass2.recombine_mb);
+    } else {
+      jlog("\t(-recombine)recombination= disabled\n");
+    }
     jlog("\t(-n)        search till = %d candidates found\n", r->config->pass2.nbest);
     jlog("\t(-output)    and output = %d candidates out of above\n", r->config->output.output_hypo_maxnum);
 
@@ -706,6 +725,13 @@ print_engine_info(Recog *recog)
     if (r->config->annotate.align_result_state_flag) {
       jlog("\t output state alignments\n");
     }
+    if (r->config->annotate.align_result_word_flag
+	|| r->config->annotate.align_result_phoneme_flag
+	|| r->config->annotate.align_result_state_flag) {
+      if (r->config->annotate.align_threads > 1) {
+	jlog("\t alignment computed by %d threads\n", r->config->annotate.align_threads);
+      }
+    }
     if (r->lmtype == LM_DFA && r->lmvar == LM_DFA_GRAMMAR) {
       if (r->config->pass2.looktrellis_flag) {
 	jlog("\t only words in backtrellis will be expanded in 2nd pass\n");
@@ -750,6 +776,7 @@ print_engine_info(Recog *recog)
 	} else {
 	  jlog(" (merge same words around this margin)\n");
 	}
+	jlog("\t(-graphamscore)  AM re-score = %s\n", r->config->graph.amscore ? "yes" : "no");
       }
 #ifdef GRAPHOUT_DEPTHCUT
       jlog("\t(-graphcut)cutoff depth      = ");
@@ -840,6 +867,14 @@ print_engine_info(Recog *recog)
   jlog("based on search-time scores\n");
 #endif
 #endif /* CONFIDENCE_MEASURE */
+  if (jconf->decodeopt.sr_threads > 1) {
+    jlog("\trecognition processes run by %d threads", jconf->decodeopt.sr_threads);
+    if (jconf->decodeopt.cpu_affinity) jlog(" on CPU %s", jconf->decodeopt.cpu_affinity);
+    jlog("\n");
+  }
+  if (jconf->decodeopt.pass2_async) {
+    jlog("\t2nd pass runs in background during the next input\n");
+  }
   
   jlog("\n");
 
@@ -916,12 +951,16 @@ print_engine_info(Recog *recog)
     if (jconf->input.speech_input == SP_RAWFILE || jconf->input.speech_input == SP_STDIN || jconf->input.speech_input == SP_ADINNET) {
       if (jconf->input.use_ds48to16) {
 	jlog("\t          sampling freq. = assume 48000Hz, then down to %dHz\n", jconf->input.sfreq);
+      } else if (jconf->input.infreq > 0 && jconf->input.infreq != jconf->input.sfreq) {
+	jlog("\t          sampling freq. = assume %dHz, then resampled to %dHz\n", jconf->input.infreq, jconf->input.sfreq);
       } else {
 	jlog("\t          sampling freq. = %d Hz required\n", jconf->input.sfreq);
       }
     } else {
       if (jconf->input.use_ds48to16) {
 	jlog("\t          sampling freq. = 48000Hz, then down to %d Hz\n", jconf->input.sfreq);
+      } else if (jconf->input.infreq > 0 && jconf->input.infreq != jconf->input.sfreq) {
+	jlog("\t          sampling freq. = %dHz, then resampled to %d Hz\n", jconf->input.infreq, jconf->input.sfreq);
       } else {
  	jlog("\t          sampling freq. = %d Hz\n", jconf->input.sfreq);
       }
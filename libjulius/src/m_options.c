@@ -467,6 +467,25 @@ opt_parse(int argc, char *argv[], char *cwd, Jconf *jconf)
       jconf->decodeopt.forced_realtime = FALSE;
       jconf->decodeopt.force_realtime_flag = TRUE;
       continue;
+    } else if (strmatch(argv[i],"-srthreads")) { /* run processes in parallel */
+      if (!check_section(jconf, argv[i], JCONF_OPT_GLOBAL)) return FALSE; 
+      GET_TMPARG;
+      jconf->decodeopt.sr_threads = atoi(tmparg);
+      if (jconf->decodeopt.sr_threads < 1) {
+	jlog("ERROR: m_options: \"-srthreads\" should be larger than 0\n");
+	return FALSE;
+      }
+      continue;
+    } else if (strmatch(argv[i],"-cpuaffinity")) { /* CPUs to bind threads */
+      if (!check_section(jconf, argv[i], JCONF_OPT_GLOBAL)) return FALSE; 
+      FREE_MEMORY(jconf->decodeopt.cpu_affinity);
+      GET_TMPARG;
+      jconf->decodeopt.cpu_affinity = strcpy((char*)mymalloc(strlen(tmparg)+1),tmparg);
+      continue;
+    } else if (strmatch(argv[i],"-pass2async")) { /* 2nd pass in background */
+      if (!check_section(jconf, argv[i], JCONF_OPT_GLOBAL)) return FALSE; 
+      jconf->decodeopt.pass2_async = TRUE;
+      continue;
     } else if (strmatch(argv[i],"-forcedict")) { /* skip dict error */
       if (!check_section(jconf, argv[i], JCONF_OPT_LM)) return FALSE; 
       jconf->lmnow->forcedict_flag = TRUE;
@@ -480,6 +499,8 @@ opt_parse(int argc, char *argv[], char *cwd, Jconf *jconf)
 	jconf->searchnow->sw.trellis_check_flag = TRUE;
       } else if (strmatch(tmparg, "triphone")) {
 	jconf->searchnow->sw.triphone_check_flag = TRUE;
+      } else if (strmatch(tmparg, "update")) {
+	jconf->searchnow->sw.wchmm_update_check_flag = TRUE;
       } else {
 	jlog("ERROR: m_options: invalid argument for \"-check\": %s\n", tmparg);
 	return FALSE;
@@ -534,6 +555,14 @@ opt_parse(int argc, char *argv[], char *cwd, Jconf *jconf)
       GET_TMPARG;
       jconf->searchnow->graph.graph_merge_neighbor_range = atoi(tmparg);
       continue;
+    } else if (strmatch(argv[i],"-graphamscore")) { /* re-compute acoustic score of graph words */
+      if (!check_section(jconf, argv[i], JCONF_OPT_SR)) return FALSE; 
+      jconf->searchnow->graph.amscore = TRUE;
+      continue;
+    } else if (strmatch(argv[i],"-nographamscore")) { /* disable it */
+      if (!check_section(jconf, argv[i], JCONF_OPT_SR)) return FALSE; 
+      jconf->searchnow->graph.amscore = FALSE;
+      continue;
 #ifdef GRAPHOUT_DEPTHCUT
     } else if (strmatch(argv[i],"-graphcut")) { /* cut graph word by depth */
       if (!check_section(jconf, argv[i], JCONF_OPT_SR)) return FALSE; 
@@ -562,6 +591,12 @@ opt_parse(int argc, char *argv[], char *cwd, Jconf *jconf)
       if (!check_section(jconf, argv[i], JCONF_OPT_SR)) return FALSE; 
       jconf->searchnow->pass2.looktrellis_flag = TRUE;
       continue;
+    } else if (strmatch(argv[i],"-recombine")) { /* hypothesis recombination cache size in MB */
+      if (!check_section(jconf, argv[i], JCONF_OPT_SR)) return FALSE; 
+      GET_TMPARG;
+      jconf->searchnow->pass2.recombine_mb = atoi(tmparg);
+      if (jconf->searchnow->pass2.recombine_mb < 0) jconf->searchnow->pass2.recombine_mb = 0;
+      continue;
     } else if (strmatch(argv[i],"-multigramout")) { /* enable per-grammar decoding on 2nd pass */
       if (!check_section(jconf, argv[i], JCONF_OPT_SR)) return FALSE; 
       jconf->searchnow->output.multigramout_flag = TRUE;
@@ -590,6 +625,18 @@ opt_parse(int argc, char *argv[], char *cwd, Jconf *jconf)
       jconf->searchnow->pass1.score_pruning_width = atof(tmparg);
       continue;
 #endif
+    } else if (strmatch(argv[i],"-lookahead")) { /* phone lookahead for 1st pass */
+      if (!check_section(jconf, argv[i], JCONF_OPT_SR)) return FALSE;
+      GET_TMPARG;
+      jconf->searchnow->pass1.lookahead_frames = atoi(tmparg);
+      GET_TMPARG;
+      jconf->searchnow->pass1.lookahead_width = atof(tmparg);
+      continue;
+    } else if (strmatch(argv[i],"-streamcommit")) { /* commit converged words on streaming input */
+      if (!check_section(jconf, argv[i], JCONF_OPT_SR)) return FALSE;
+      GET_TMPARG;
+      jconf->searchnow->pass1.stream_commit = atoi(tmparg);
+      continue;
     } else if (strmatch(argv[i],"-discount")) {	/* (bogus) */
       jlog("WARNING: m_options: option \"-discount\" is now bogus, ignored\n");
       continue;
@@ -752,6 +799,15 @@ opt_parse(int argc, char *argv[], char *cwd, Jconf *jconf)
       if (!check_section(jconf, argv[i], JCONF_OPT_GLOBAL)) return FALSE; 
       jconf->input.use_ds48to16 = TRUE;
       continue;
+    } else if (strmatch(argv[i],"-infreq")) { /* input rate to be resampled */
+      if (!check_section(jconf, argv[i], JCONF_OPT_GLOBAL)) return FALSE; 
+      GET_TMPARG;
+      jconf->input.infreq = atoi(tmparg);
+      if (jconf->input.infreq < 0) {
+	jlog("ERROR: m_options: -infreq should be >= 0\n");
+	return FALSE;
+      }
+      continue;
     } else if (strmatch(argv[i],"-version") || strmatch(argv[i], "--version") || strmatch(argv[i], "-setting") || strmatch(argv[i], "--setting")) { /* print version and exit */
       j_put_header(stderr);
       j_put_compile_defs(stderr);
@@ -792,6 +848,11 @@ opt_parse(int argc, char *argv[], char *cwd, Jconf *jconf)
       if (!check_section(jconf, argv[i], JCONF_OPT_SR)) return FALSE; 
       jconf->searchnow->annotate.align_result_state_flag = TRUE;
       continue;
+    } else if (strmatch(argv[i],"-alignthreads")) { /* threads for forced alignment */
+      if (!check_section(jconf, argv[i], JCONF_OPT_SR)) return FALSE; 
+      GET_TMPARG;
+      jconf->searchnow->annotate.align_threads = atoi(tmparg);
+      continue;
     } else if (strmatch(argv[i],"-output")) { /* output up to N candidate */
       if (!check_section(jconf, argv[i], JCONF_OPT_SR)) return FALSE; 
       GET_TMPARG;
@@ -955,7 +1016,19 @@ opt_parse(int argc, char *argv[], char *cwd, Jconf *jconf)
       if (jconf->searchnow->pass1.iw_cache_rate > 100) jconf->searchnow->pass1.iw_cache_rate = 100;
       if (jconf->searchnow->pass1.iw_cache_rate < 1) jconf->searchnow->pass1.iw_cache_rate = 1;
 #else
+      GET_TMPARG;
       jlog("WARNING: m_options: HASH_CACHE_IW disabled, \"-iwcache\" ignored\n");
+#endif
+      continue;
+    } else if (strmatch(argv[i],"-iwcachemb")) { /* cross-word LM cache size in MB */
+#ifdef HASH_CACHE_IW
+      if (!check_section(jconf, argv[i], JCONF_OPT_SR)) return FALSE; 
+      GET_TMPARG;
+      jconf->searchnow->pass1.iw_cache_mb = atoi(tmparg);
+      if (jconf->searchnow->pass1.iw_cache_mb < 0) jconf->searchnow->pass1.iw_cache_mb = 0;
+#else
+      GET_TMPARG;
+      jlog("WARNING: m_options: HASH_CACHE_IW disabled, \"-iwcachemb\" ignored\n");
 #endif
       continue;
     } else if (strmatch(argv[i],"-sepnum")) { /* N-best frequent word will be separated from tree */
@@ -1226,6 +1299,11 @@ opt_parse(int argc, char *argv[], char *cwd, Jconf *jconf)
       GET_TMPARG;
       jconf->reject.gmm_gprune_num = atoi(tmparg);
       continue;
+    } else if (strmatch(argv[i],"-gmmtopk")) { /* num of Gaussians shared among GMMs */
+      if (!check_section(jconf, argv[i], JCONF_OPT_GLOBAL)) return FALSE; 
+      GET_TMPARG;
+      jconf->reject.gmm_shared_topk = atoi(tmparg);
+      continue;
     } else if (strmatch(argv[i],"-gmmreject")) {
       if (!check_section(jconf, argv[i], JCONF_OPT_GLOBAL)) return FALSE; 
       GET_TMPARG;
@@ -1535,6 +1613,7 @@ opt_release(Jconf *jconf)
   FREE_MEMORY(jconf->reject.gmm_filename);
   FREE_MEMORY(jconf->reject.gmm_reject_cmn_string);
   FREE_MEMORY(jconf->outprob_outfile);
+  FREE_MEMORY(jconf->decodeopt.cpu_affinity);
 
   for(am=jconf->am_root;am;am=am->next) {
     FREE_MEMORY(am->hmmfilename);
@@ -120,6 +120,7 @@ j_output_argument_help(FILE *fp)
 #endif
   fprintf(fp, "    [-adport portnum]   adinnet port number to listen         (%d)\n", jconf->input.adinnet_port);
   fprintf(fp, "    [-48]               enable 48kHz sampling with internal down sampler (OFF)\n");
+  fprintf(fp, "    [-infreq freq]      resample input of this rate to -smpFreq (OFF)\n");
   fprintf(fp, "    [-zmean/-nozmean]   enable/disable DC offset removal      (OFF)\n");
   fprintf(fp, "    [-lvscale]          input level scaling factor (1.0: OFF) (%.1f)\n", jconf->preprocess.level_coef);
   fprintf(fp, "    [-nostrip]          disable stripping off zero samples\n");
@@ -148,6 +149,7 @@ j_output_argument_help(FILE *fp)
   fprintf(fp, "\n GMM utterance verification:\n");
   fprintf(fp, "    -gmm filename       GMM definition file\n");
   fprintf(fp, "    -gmmnum num         GMM Gaussian pruning num              (%d)\n", jconf->reject.gmm_gprune_num);
+  fprintf(fp, "    -gmmtopk num        num of Gaussians shared by all GMMs   (%d)\n", jconf->reject.gmm_shared_topk);
   fprintf(fp, "    -gmmreject string   comma-separated list of noise model name to reject\n");
 #ifdef GMM_VAD
   fprintf(fp, "\n GMM-based VAD:\n");
@@ -159,6 +161,11 @@ j_output_argument_help(FILE *fp)
   fprintf(fp, "\n On-the-fly Decoding: (default: on=mic/net off=files)\n");
   fprintf(fp, "    [-realtime]         turn on, input streamed with MAP-CMN\n");
   fprintf(fp, "    [-norealtime]       turn off, input buffered with sentence CMN\n");
+  fprintf(fp, "    [-pass2async]       run 2nd pass in background during next input\n");
+
+  fprintf(fp, "\n Multiple Recognition Processes:\n");
+  fprintf(fp, "    [-srthreads N]      run processes of different AMs by N threads (%d)\n", jconf->decodeopt.sr_threads);
+  fprintf(fp, "    [-cpuaffinity list] comma-separated CPU list to bind the threads\n");
 
   fprintf(fp, "\n Others:\n");
   fprintf(fp, "    [-C jconffile]      load options from jconf file\n");
@@ -168,6 +175,7 @@ j_output_argument_help(FILE *fp)
   fprintf(fp, "    [-callbackdebug]    (for debug) output message per callback\n");
   fprintf(fp, "    [-check (wchmm|trellis)] (for debug) check internal structure\n");
   fprintf(fp, "    [-check triphone]   triphone mapping check\n");
+  fprintf(fp, "    [-check update]     verify incremental lexicon update on grammar change\n");
   fprintf(fp, "    [-outprobout file]  Output state probabilities to file\n");
   fprintf(fp, "    [-setting]          print engine configuration and exit\n");
   fprintf(fp, "    [-help]             print this message and exit\n");
@@ -313,6 +321,8 @@ j_output_argument_help(FILE *fp)
   fprintf(fp, "    [-bs score_width]   beam width (by score offset)          (disabled)\n");
   fprintf(fp, "                        (-1: disable)\n");
 #endif
+  fprintf(fp, "    [-lookahead N width] prune by GS HMM phone lookahead of N frames (disabled)\n");
+  fprintf(fp, "    [-streamcommit N]   commit converged words every N frames (disabled)\n");
 #ifdef WPAIR
 # ifdef WPAIR_KEEP_NLIMIT
   fprintf(fp, "    [-nlimit N]         keeps only N tokens on each state     (%d)\n", jconf->search_root->pass1.wpair_keep_nlimit);
@@ -323,6 +333,7 @@ j_output_argument_help(FILE *fp)
 #endif
 #ifdef HASH_CACHE_IW
   fprintf(fp, "    [-iwcache percent]  (n-gram) amount of inter-word LM cache (%3d)\n", jconf->search_root->pass1.iw_cache_rate);
+  fprintf(fp, "    [-iwcachemb MB]     (n-gram) inter-word LM cache size in MB, overrides -iwcache (%d)\n", jconf->search_root->pass1.iw_cache_mb);
 #endif
   fprintf(fp, "    [-1pass]            do 1st pass only, omit 2nd pass\n");
   fprintf(fp, "    [-inactive]         recognition process not active on startup\n");
@@ -339,6 +350,7 @@ j_output_argument_help(FILE *fp)
 
   fprintf(fp, "    [-lookuprange N]    frame lookup range in word expansion  (%d)\n", jconf->search_root->pass2.lookup_range);
   fprintf(fp, "    [-looktrellis]      (dfa) expand only backtrellis words\n");
+  fprintf(fp, "    [-recombine MB]     hypothesis recombination cache size in MB (disabled)\n");
   fprintf(fp, "    [-[no]multigramout] (dfa) output per-grammar results\n");
   fprintf(fp, "    [-oldtree]          (dfa) use old build_wchmm()\n");
 #ifdef PASS1_IWCD
@@ -364,6 +376,8 @@ j_output_argument_help(FILE *fp)
   fprintf(fp, "                        -1: not merge, leave same loc. with diff. score\n");
   fprintf(fp, "                         0: merge same words at same location\n");
   fprintf(fp, "                        >0: merge same words around the margin\n");
+  fprintf(fp, "    [-graphamscore]     re-compute AM score of graph words on their segments\n");
+  fprintf(fp, "    [-nographamscore]   disable it (default)\n");
 #ifdef GRAPHOUT_DEPTHCUT
   fprintf(fp, "    [-graphcut num]     graph cut depth at postprocess (-1: disable)(%d)\n", jconf->search_root->graph.graphout_cut_depth);
 #endif
@@ -379,6 +393,7 @@ j_output_argument_help(FILE *fp)
   fprintf(fp, "    [-walign]           optionally output word alignments\n");
   fprintf(fp, "    [-palign]           optionally output phoneme alignments\n");
   fprintf(fp, "    [-salign]           optionally output state alignments\n");
+  fprintf(fp, "    [-alignthreads N]   number of threads for alignment of N-best (%d)\n", jconf->search_root->annotate.align_threads);
 
 #ifdef USE_MBR
   fprintf(fp, "\n Minimum Bayes Risk Decoding:\n");
@@ -70,7 +70,8 @@
  * 与えられた文法で認識を行うために，認識処理インスタンスが現在持つ
  * グローバル文法から木構造化辞書を（再）構築します. また， 
  * 起動時にビーム幅が明示的に指示されていない場合やフルサーチの場合，
- * ビーム幅の再設定も行います.
+ * ビーム幅の再設定も行います. 現在の木構造化辞書が直前のグローバル
+ * 文法から作られたものであれば，wchmm_update() で差分更新します. 
  * 
  * @param r [i/o] 認識処理インスタンス
  * </JA>
@@ -80,7 +81,9 @@
  * This function will re-construct the tree lexicon using the global grammar
  * in the recognition process instance.  If the beam width was not explicitly
  * specified on startup, the the beam width will be guessed
- * according to the size of the new lexicon.
+ * according to the size of the new lexicon.  If the current tree lexicon
+ * was built from the previous global grammar, it is updated incrementally
+ * by wchmm_update() instead.
  * 
  * @param r [i/o] recognition process instance
  * </EN>
@@ -89,6 +92,24 @@ static boolean
 multigram_rebuild_wchmm(RecogProcess *r)
 {
   boolean ret;
+  PROCESS_LM *lm = r->lm;
+
+  /* update the current tree lexicon if it was built from the previous
+     global grammar */
+  if (r->wchmm != NULL
+      && lm->lexmap_valid
+      && r->wchmm->gram_version == lm->global_version - 1
+      && ! r->config->pass1.old_tree_function_flag) {
+    if (wchmm_update(r->wchmm, lm->winfo, lm->dfa, lm->dfa_forward, lm->lexmap_word, lm->lexmap_word_num, lm->lexmap_cate, lm->lexmap_cate_num, lm->config)) {
+      r->wchmm->gram_version = lm->global_version;
+      jlog("STAT: multi-gram: lexicon tree updated incrementally\n");
+      if (r->config->sw.wchmm_update_check_flag) {
+	wchmm_check_update(r->wchmm, lm->config);
+      }
+      goto set_beam;
+    }
+    jlog("STAT: multi-gram: incremental update not applicable, re-build lexicon tree\n");
+  }
 
   /* re-build wchmm */
   if (r->wchmm != NULL) {
@@ -101,18 +122,19 @@ multigram_rebuild_wchmm(RecogProcess *r)
   r->wchmm->category_tree = TRUE;
   r->wchmm->hmmwrk = &(r->am->hmmwrk);
   /* assign models */
-  r->wchmm->dfa = r->lm->dfa;
-  r->wchmm->dfa_forward = r->lm->dfa_forward;
-  r->wchmm->winfo = r->lm->winfo;
+  r->wchmm->dfa = lm->dfa;
+  r->wchmm->dfa_forward = lm->dfa_forward;
+  r->wchmm->winfo = lm->winfo;
   r->wchmm->hmminfo = r->am->hmminfo;
+  r->wchmm->gram_version = lm->global_version;
   if (r->wchmm->category_tree) {
     if (r->config->pass1.old_tree_function_flag) {
-      ret = build_wchmm(r->wchmm, r->lm->config);
+      ret = build_wchmm(r->wchmm, lm->config);
     } else {
-      ret = build_wchmm2(r->wchmm, r->lm->config);
+      ret = build_wchmm2(r->wchmm, lm->config);
     }
   } else {
-    ret = build_wchmm2(r->wchmm, r->lm->config);
+    ret = build_wchmm2(r->wchmm, lm->config);
   }
 
   /* 起動時 -check でチェックモードへ */
@@ -125,6 +147,7 @@ multigram_rebuild_wchmm(RecogProcess *r)
     return FALSE;
   }
   
+ set_beam:
   /* guess beam width from models, when not specified */
   r->trellis_beam_width = set_beam_width(r->wchmm, r->config->pass1.specified_trellis_beam_width);
   switch(r->config->pass1.specified_trellis_beam_width) {
@@ -138,7 +161,7 @@ multigram_rebuild_wchmm(RecogProcess *r)
   /* re-allocate factoring cache for the tree lexicon*/
   /* for n-gram only?? */
   //max_successor_cache_free(recog->wchmm);
-  //max_successor_cache_init(recog->wchmm);
+  //max_successor_cache_init(recog->wchmm, r->config);
 
   /* finished! */
 
@@ -228,6 +251,7 @@ multigram_append_to_global(DFA_INFO *gdfa, WORD_INFO *gwinfo, DFA_INFO *gdfa_for
   if (voca_append(gwinfo, m->winfo, m->cate_begin, m->word_begin) == FALSE) {
     return FALSE;
   }
+  m->word_num = gwinfo->num - m->word_begin;
   /* append category->word mapping table */
   terminfo_append(&(gdfa->term), &(m->dfa->term), m->cate_begin, m->word_begin);
   /* append catergory-pair information */
@@ -299,6 +323,10 @@ multigram_add(DFA_INFO *dfa, WORD_INFO *winfo, char *name, PROCESS_LM *lm, DFA_I
   new->hook = MULTIGRAM_DEFAULT | MULTIGRAM_ACTIVATE;
   new->newbie = TRUE;		/* need to setup */
   new->active = FALSE;		/* default: inactive */
+  new->word_num = 0;
+  new->prev_word_begin = -1;
+  new->prev_word_num = 0;
+  new->prev_cate_begin = 0;
 
   /* the new grammar is now added to gramlist */
   new->next = lm->grammars;
@@ -590,6 +618,90 @@ multigram_exec_activate(PROCESS_LM *lm)
   return(modified);
 }
  
+/** 
+ * <JA>
+ * 文法更新前のグローバル文法上での各文法の位置を記録する. 
+ * 
+ * @param lm [i/o] 言語処理インスタンス
+ * 
+ * @return 更新前後の対応付けが作成可能であれば TRUE を返す. 
+ * </JA>
+ * <EN>
+ * Remember the location of each installed grammar in the current
+ * global grammar, to make word / category mapping after update.
+ * 
+ * @param lm [i/o] LM processing instance
+ * 
+ * @return TRUE if the mapping can be made after the update.
+ * </EN>
+ */
+static boolean
+multigram_lexmap_prepare(PROCESS_LM *lm)
+{
+  MULTIGRAM *m;
+
+  lm->lexmap_valid = FALSE;
+  for(m=lm->grammars;m;m=m->next) {
+    if (m->newbie) {
+      m->prev_word_begin = -1;
+    } else {
+      m->prev_word_begin = m->word_begin;
+      m->prev_word_num = m->word_num;
+      m->prev_cate_begin = m->cate_begin;
+    }
+  }
+  /* the tree lexicon has not been built from the current global grammar */
+  if (lm->global_modified) return FALSE;
+  if (lm->lmvar != LM_DFA_GRAMMAR) return FALSE;
+  if (lm->winfo == NULL || lm->dfa == NULL) return FALSE;
+
+  /* allocate map with the current sizes */
+  lm->lexmap_word_num = lm->winfo->num;
+  lm->lexmap_word = (WORD_ID *)myrealloc(lm->lexmap_word, sizeof(WORD_ID) * (lm->lexmap_word_num > 0 ? lm->lexmap_word_num : 1));
+  lm->lexmap_cate_num = lm->dfa->term_num;
+  lm->lexmap_cate = (WORD_ID *)myrealloc(lm->lexmap_cate, sizeof(WORD_ID) * (lm->lexmap_cate_num > 0 ? lm->lexmap_cate_num : 1));
+
+  return TRUE;
+}
+
+/** 
+ * <JA>
+ * 文法更新前後の単語IDとカテゴリIDの対応表を作成する. 
+ * 
+ * @param lm [i/o] 言語処理インスタンス
+ * </JA>
+ * <EN>
+ * Make word ID and category ID mapping between the global grammars
+ * before and after the update, for incremental update of tree lexicon.
+ * Words and categories of deleted grammars are mapped to WORD_INVALID.
+ * 
+ * @param lm [i/o] LM processing instance
+ * </EN>
+ */
+static void
+multigram_lexmap_make(PROCESS_LM *lm)
+{
+  MULTIGRAM *m;
+  int i, k;
+
+  for(i=0;i<lm->lexmap_word_num;i++) lm->lexmap_word[i] = WORD_INVALID;
+  for(i=0;i<lm->lexmap_cate_num;i++) lm->lexmap_cate[i] = WORD_INVALID;
+  for(m=lm->grammars;m;m=m->next) {
+    if (m->prev_word_begin < 0) continue;
+    for(i=0;i<m->prev_word_num;i++) {
+      k = m->prev_word_begin + i;
+      if (k >= lm->lexmap_word_num || i >= m->word_num) return;
+      lm->lexmap_word[k] = m->word_begin + i;
+    }
+    for(i=0;i<m->dfa->term_num;i++) {
+      k = m->prev_cate_begin + i;
+      if (k >= lm->lexmap_cate_num) return;
+      lm->lexmap_cate[k] = m->cate_begin + i;
+    }
+  }
+  lm->lexmap_valid = TRUE;
+}
+
 /** 
  * <JA>
  * @brief  グローバル文法の更新
@@ -629,6 +741,13 @@ multigram_update(PROCESS_LM *lm)
   MULTIGRAM *m;
   boolean active_changed = FALSE;
   boolean rebuild_flag;
+  boolean lexmap_ok;
+
+  /* grammars of a shared LM are managed by the owner instance */
+  if (lm->shared) return FALSE;
+
+  /* remember current grammar locations for incremental lexicon update */
+  lexmap_ok = multigram_lexmap_prepare(lm);
 
   if (lm->lmvar == LM_DFA_GRAMMAR) {
     /* setup additional grammar info of new ones */
@@ -711,17 +830,20 @@ multigram_update(PROCESS_LM *lm)
 	  /* mark as delete */
 	  m->hook |= MULTIGRAM_DELETE;
 	}
+	m->word_num = lm->winfo->num - m->word_begin;
       } else {
 	if (multigram_append_to_global(lm->dfa, lm->winfo, lm->dfa_forward, m) == FALSE) {
 	  jlog("ERROR: multi-gram: failed to add grammar #%d to recognition network\n", m->id);
 	  /* mark as delete */
 	  m->hook |= MULTIGRAM_DELETE;
+	  lexmap_ok = FALSE;
 	}
       }
     }
     /* delete the error grammars if exist */
     if (multigram_exec_delete(lm)) {
       jlog("ERROR: errorous grammar deleted\n");
+      lexmap_ok = FALSE;
     }
     lm->global_modified = TRUE;
   } else {			/* global not need changed by the deletion */
@@ -749,11 +871,13 @@ multigram_update(PROCESS_LM *lm)
 	    /* mark as delete */
 	    m->hook |= MULTIGRAM_DELETE;
 	  }
+	  m->word_num = lm->winfo->num - m->word_begin;
 	} else {
 	  if (multigram_append_to_global(lm->dfa, lm->winfo, lm->dfa_forward, m) == FALSE) {
 	    jlog("ERROR: multi-gram: failed to add grammar #%d to recognition network\n", m->id);
 	    /* mark as delete */
 	    m->hook |= MULTIGRAM_DELETE;
+	    lexmap_ok = FALSE;
 	  }
 	}
 	lm->global_modified = TRUE;
@@ -766,6 +890,9 @@ multigram_update(PROCESS_LM *lm)
 
   if (lm->global_modified) {		/* if global lexicon has changed */
     /* now global grammar info has been updated */
+    lm->global_version++;
+    /* make word / category mapping from the previous global grammar */
+    if (lexmap_ok) multigram_lexmap_make(lm);
     /* check if no grammar */
     if (lm->lmvar == LM_DFA_GRAMMAR) {
       if (lm->dfa == NULL || lm->winfo == NULL) {
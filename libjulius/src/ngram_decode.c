@@ -131,21 +131,17 @@ search_nw(NEXTWORD **nw, WORD_ID w, int num)
  * @param ngram [in] N-gram data structure
  * @param w [in] word sequence
  * @param wlen [in] length of @a w
+ * @param p1 [in] the part of context words w[1..], computed by set_ngram_context()
  * 
  * @return the backward probability of the word w[0].
  * 
  */
 static LOGPROB
-ngram_forw2back(NGRAM_INFO *ngram, WORD_ID *w, int wlen)
+ngram_forw2back(NGRAM_INFO *ngram, WORD_ID *w, int wlen, LOGPROB p1)
 {
   int i;
-  LOGPROB p1, p2;
+  LOGPROB p2;
 
-  p1 = 0.0;
-  for(i = 1; i < ngram->n; i++) {
-    if (i >= wlen) break;
-    p1 += ngram_prob(ngram, i, &(w[1]));
-  }
   p2 = 0.0;
   for(i = 0; i < ngram->n; i++) {
     if (i >= wlen) break;
@@ -155,13 +151,80 @@ ngram_forw2back(NGRAM_INFO *ngram, WORD_ID *w, int wlen)
   return(p2 - p1);
 }
 
+/** 
+ * <JA>
+ * 展開元の文仮説の単語履歴を N-gram の文脈として設定する. 
+ * 全ての次単語候補に共通する計算はここで一度だけ行う. 
+ * 
+ * @param r [in] 認識処理インスタンス
+ * @param hypo [in] 展開元の文仮説
+ * </JA>
+ * <EN>
+ * Set the word history of the source hypothesis as N-gram context.
+ * Computation common to all the next word candidates is done here once.
+ * 
+ * @param r [in] recognition process instance
+ * @param hypo [in] the source sentence hypothesis
+ * </EN>
+ */
+static void
+set_ngram_context(RecogProcess *r, NODE *hypo)
+{
+  int i;
+  int cnnum;		///< Num of found non-transparent words (<=2)
+  int last_trans;		///< Num of skipped transparent words
+  StackDecode *dwrk;
+  WORD_INFO *winfo;
+  NGRAM_INFO *ngram;
+  LOGPROB p1;
+
+  winfo = r->lm->winfo;
+  ngram = r->lm->ngram;
+  dwrk = &(r->pass2);
+
+  /* set word contexts to cnword[] from 1 considering transparent words */
+  cnnum = 0;
+  last_trans = 0;
+  for(i=hypo->seqnum-1;i>=0;i--) {
+    if (! winfo->is_transparent[hypo->seq[i]]) {
+      dwrk->cnword[cnnum+1] = hypo->seq[i];
+      cnnum++;
+      if (cnnum >= ngram->n - 1) break;
+    } else {
+      last_trans++;
+    }
+  }
+  if (ngram->dir == DIR_RL) {
+    for(i=0;i<cnnum;i++) {
+      dwrk->cnwordrev[cnnum-1-i] = dwrk->cnword[i+1];
+    }
+  }
+  /* use ngram id */
+  if (ngram->dir == DIR_RL) {
+    for(i=0;i<cnnum;i++) dwrk->cnwordrev[i] = winfo->wton[dwrk->cnwordrev[i]];
+    /* resolve the context once for all candidates */
+    ngram_context_set(&(dwrk->cnctx), ngram, dwrk->cnwordrev, cnnum);
+  } else {
+    for(i=0;i<cnnum;i++) dwrk->cnword[i+1] = winfo->wton[dwrk->cnword[i+1]];
+    /* the probability of the context words does not depend on candidates */
+    p1 = 0.0;
+    for(i = 1; i < ngram->n; i++) {
+      if (i >= cnnum + 1) break;
+      p1 += ngram_prob(ngram, i, &(dwrk->cnword[1]));
+    }
+    dwrk->cnp1 = p1;
+  }
+  dwrk->cnlen = cnnum;
+}
+
 /** 
  * <JA>
  * @brief  単語トレリスから次単語候補を抽出する. 
  *
  * 単語トレリス上の指定したフレーム上に終端が存在するトレリス単語
  * のリストを抽出し，それらの次単語としての N-gram 接続確率を計算する. 
- * そのリストを次単語情報構造体に追加して返す. 
+ * そのリストを次単語情報構造体に追加して返す. 後向き N-gram では
+ * 確率は set_ngram_context() で設定した文脈に対して一括で計算される. 
  * 
  * @param r [in] 認識処理インスタンス
  * @param nw [i/o] 次単語候補リスト（抽出結果は @a oldnum 以降に追加される）
@@ -177,7 +240,9 @@ ngram_forw2back(NGRAM_INFO *ngram, WORD_ID *w, int wlen)
  * This function extracts the list of trellis words whose word end
  * has survived in the word trellis at the specified frame.
  * The N-gram probabilities of them are then computed and added to
- * the current next word candidates data.
+ * the current next word candidates data.  On backward N-gram, the
+ * probabilities are computed at once for the context set by
+ * set_ngram_context().
  * 
  * @param r [in] recognition process instance
  * @param nw [in] list of next word candidates (new words will be appended at @a oldnum)
@@ -191,15 +256,14 @@ ngram_forw2back(NGRAM_INFO *ngram, WORD_ID *w, int wlen)
 static int
 pick_backtrellis_words(RecogProcess *r, NEXTWORD **nw, int oldnum, NODE *hypo, short t)
 {
-  int i;
+  int i, j, k, n;
   WORD_ID w;
   LOGPROB rawscore;
 #ifdef WPAIR
   int w_old = WORD_INVALID;
 #endif
   int num;
-  int cnnum;		///< Num of found non-transparent words (<=2)
-  int last_trans;		///< Num of skipped transparent words
+  boolean batch;
   StackDecode *dwrk;
 
   BACKTRELLIS *bt;
@@ -216,34 +280,17 @@ pick_backtrellis_words(RecogProcess *r, NEXTWORD **nw, int oldnum, NODE *hypo, s
   lm_penalty_trans = r->config->lmp.lm_penalty_trans;
   dwrk = &(r->pass2);
 
-  /* set word contexts to cnword[] from 1 considering transparent words */
-  if (ngram) {
-    cnnum = 0;
-    last_trans = 0;
-    for(i=hypo->seqnum-1;i>=0;i--) {
-      if (! winfo->is_transparent[hypo->seq[i]]) {
-	dwrk->cnword[cnnum+1] = hypo->seq[i];
-	cnnum++;
-	if (cnnum >= ngram->n - 1) break;
-      } else {
-	last_trans++;
-      }
-    }
-    if (ngram->dir == DIR_RL) {
-      for(i=0;i<cnnum;i++) {
-	dwrk->cnwordrev[cnnum-1-i] = dwrk->cnword[i+1];
-      }
-    }
-    /* use ngram id */
-    if (ngram->dir == DIR_RL) {
-      for(i=0;i<cnnum;i++) dwrk->cnwordrev[i] = winfo->wton[dwrk->cnwordrev[i]];
-    } else {
-      for(i=0;i<cnnum;i++) dwrk->cnword[i+1] = winfo->wton[dwrk->cnword[i+1]];
-    }
+  if (dwrk->cnalloc < bt->num[t]) {
+    dwrk->cnalloc = bt->num[t];
+    dwrk->cnsel = (boolean *)myrealloc(dwrk->cnsel, sizeof(boolean) * dwrk->cnalloc);
+    dwrk->cnnword = (WORD_ID *)myrealloc(dwrk->cnnword, sizeof(WORD_ID) * dwrk->cnalloc);
+    dwrk->cnidx = (int *)myrealloc(dwrk->cnidx, sizeof(int) * dwrk->cnalloc);
+    dwrk->cnprob = (LOGPROB *)myrealloc(dwrk->cnprob, sizeof(LOGPROB) * dwrk->cnalloc);
   }
 
   /* lookup survived words in backtrellis on time frame 't' */
   for (i=0;i<bt->num[t];i++) {
+    dwrk->cnsel[i] = FALSE;
     w = (bt->rw[t][i])->wid;
 #ifdef WORD_GRAPH
     /* only words on the word graphs are expanded */
@@ -258,17 +305,37 @@ pick_backtrellis_words(RecogProcess *r, NEXTWORD **nw, int oldnum, NODE *hypo, s
 #endif /* WPAIR */
     /* skip if already exist */
     if (search_nw(nw, w, oldnum) != NULL) continue;
+    dwrk->cnsel[i] = TRUE;
+  }
+
+  /* list the selected words, in the order of N-gram word ID when
+     computing their probabilities at once */
+  batch = (ngram && ngram->dir == DIR_RL);
+  n = 0;
+  for (k=0;k<bt->num[t];k++) {
+    i = batch ? bt->nwidx[t][k] : k;
+    if (dwrk->cnsel[i]) {
+      dwrk->cnidx[n] = i;
+      if (batch) dwrk->cnnword[n] = bt->nword[t][k];
+      n++;
+    }
+  }
+  if (batch) {
+    ngram_prob_batch(ngram, &(dwrk->cnctx), dwrk->cnnword, n, dwrk->cnprob);
+  }
+
+  for (j=0;j<n;j++) {
+    i = dwrk->cnidx[j];
+    w = (bt->rw[t][i])->wid;
 
     /* compute LM probability of the word */
     if (ngram) {
       /* compute N-gram probability */
-      if (ngram->dir == DIR_RL) {
-	/* just compute N-gram prob of the word candidate */
-	dwrk->cnwordrev[cnnum] = winfo->wton[w];
-	rawscore = ngram_prob(ngram, cnnum + 1, dwrk->cnwordrev);
+      if (batch) {
+	rawscore = dwrk->cnprob[j];
       } else {
 	dwrk->cnword[0] = winfo->wton[w];
-	rawscore = ngram_forw2back(ngram, dwrk->cnword, cnnum + 1);
+	rawscore = ngram_forw2back(ngram, dwrk->cnword, dwrk->cnlen + 1, dwrk->cnp1);
       }
 #ifdef CLASS_NGRAM
       rawscore += winfo->cprob[w];
@@ -345,6 +412,9 @@ get_backtrellis_words(RecogProcess *r, NEXTWORD **nw, NODE *hypo, short tm, shor
   bt = r->backtrellis;
   lookup_range = r->config->pass2.lookup_range;
 
+  /* resolve word context of the hypothesis for all frames */
+  if (r->lm->ngram) set_ngram_context(r, hypo);
+
 #ifdef PREFER_CENTER_ON_TRELLIS_LOOKUP
   /* fix for 3.2 (01/10/18 by ri) */
   /* before and after (one near center frame has high priority) */
@@ -145,6 +145,10 @@ lcdset_lookup_with_category(WCHMM_INFO *wchmm, HMM_Logical *hmm, WORD_ID categor
 {
   CD_Set *cd;
 
+  if (wchmm->hmminfo->ctxindex.enabled) {
+    /* look up by phone context IDs and category */
+    return(ctxtable_lookup(&(wchmm->lcdset_category_index), hmm->lcid, hmm->cid, category));
+  }
   leftcenter_name(hmm->name, wchmm->lccbuf);
   sprintf(wchmm->lccbuf2, "%s::%04d", wchmm->lccbuf, category);
   if (wchmm->lcdset_category_root != NULL) {
@@ -207,6 +211,7 @@ lcdset_register_with_category(WCHMM_INFO *wchmm, HMM_Logical *hmm, WORD_ID categ
 {
   WORD_ID c2, i, w;
   HMM_Logical *ltmp;
+  CD_Set *cd;
 
   int cnt_c, cnt_w, cnt_p;
 
@@ -224,7 +229,7 @@ lcdset_register_with_category(WCHMM_INFO *wchmm, HMM_Logical *hmm, WORD_ID categ
 	 is the beginning phones  */
       for(i=0;i<wchmm->dfa->term.wnum[c2];i++) {
 	w = wchmm->dfa->term.tw[c2][i];
-	ltmp = get_right_context_HMM(hmm, wchmm->winfo->wseq[w][0]->name, wchmm->hmminfo);
+	ltmp = get_right_context_logical(hmm, wchmm->winfo->wseq[w][0], wchmm->hmminfo);
 	if (ltmp == NULL) {
 	  ltmp = hmm;
 	  if (ltmp->is_pseudo) {
@@ -243,6 +248,13 @@ lcdset_register_with_category(WCHMM_INFO *wchmm, HMM_Logical *hmm, WORD_ID categ
     if (debug2_flag) {
       jlog("%d categories (%d words) can follow, %d HMMs registered\n", cnt_c, cnt_w, cnt_p);
     }
+    /* add the new set to the phone context index */
+    if (wchmm->hmminfo->ctxindex.enabled && wchmm->lcdset_category_root != NULL) {
+      cd = aptree_search_data(wchmm->lccbuf2, wchmm->lcdset_category_root);
+      if (cd != NULL && strmatch(wchmm->lccbuf2, cd->name)) {
+	ctxtable_add(&(wchmm->lcdset_category_index), hmm->lcid, hmm->cid, category, cd);
+      }
+    }
   }
 }
 
@@ -287,7 +299,7 @@ lcdset_register_with_category_all(WCHMM_INFO *wchmm)
       if (! dfa_cp(wchmm->dfa, c1, winfo->wton[w])) continue;
       for(i=0;i<wchmm->dfa->term.wnum[c1];i++) {
 	w_prev = wchmm->dfa->term.tw[c1][i];
-	ltmp = get_left_context_HMM(winfo->wseq[w][0], winfo->wseq[w_prev][winfo->wlen[w_prev]-1]->name, wchmm->hmminfo);
+	ltmp = get_left_context_logical(winfo->wseq[w][0], winfo->wseq[w_prev][winfo->wlen[w_prev]-1], wchmm->hmminfo);
 	if (ltmp == NULL) continue; /* 1音素自身のlcd_setは(1)で作成済 */
 	if (ltmp->is_pseudo) continue; /* pseudo phone ならlcd_setはいらない */
 	lcdset_register_with_category(wchmm, ltmp, winfo->wton[w]);
@@ -296,6 +308,168 @@ lcdset_register_with_category_all(WCHMM_INFO *wchmm)
   }
 }
 
+/** 
+ * <JA>
+ * 既存の単語末用カテゴリ付き pseudo phone set に，与えられた単語集合の
+ * 先頭音素を右コンテキストとするトライフォンを追加する. set が
+ * 存在しない場合は新たに生成する. 
+ * 
+ * @param wchmm [i/o] 木構造化辞書
+ * @param hmm [in] 単語の終端の論理HMM
+ * @param category [in] 単語の文法カテゴリID
+ * @param wlist [in] 後続しうる単語のリスト
+ * @param wnum [in] @a wlist の長さ
+ * </JA>
+ * <EN>
+ * Add triphones whose right contexts are the head phones of the given
+ * words to an existing category-indexed pseudo state set.  Words that
+ * cannot follow the category are skipped.  If the set does not exist
+ * yet, it will be generated as a whole.
+ * 
+ * @param wchmm [i/o] tree lexicon
+ * @param hmm [in] logical HMM at the end of a word
+ * @param category [in] category ID of the word
+ * @param wlist [in] list of words that may follow
+ * @param wnum [in] length of @a wlist
+ * </EN>
+ */
+static void
+lcdset_add_with_category(WCHMM_INFO *wchmm, HMM_Logical *hmm, WORD_ID category, WORD_ID *wlist, int wnum)
+{
+  WORD_ID w;
+  int i;
+  HMM_Logical *ltmp;
+  CD_Set *cd;
+
+  if ((cd = lcdset_lookup_with_category(wchmm, hmm, category)) == NULL) {
+    lcdset_register_with_category(wchmm, hmm, category);
+    return;
+  }
+  for(i=0;i<wnum;i++) {
+    w = wlist[i];
+    if (! dfa_cp(wchmm->dfa, category, wchmm->winfo->wton[w])) continue;
+    ltmp = get_right_context_logical(hmm, wchmm->winfo->wseq[w][0], wchmm->hmminfo);
+    if (ltmp == NULL) {
+      ltmp = hmm;
+      if (ltmp->is_pseudo) {
+	error_missing_right_triphone(hmm, wchmm->winfo->wseq[w][0]->name);
+      }
+    }
+    if (! ltmp->is_pseudo) {
+      regist_cdset(&(wchmm->lcdset_category_root), ltmp->body.defined, cd->name, &(wchmm->lcdset_mroot));
+    }
+  }
+}
+
+/** 
+ * <JA>
+ * 単語の追加に伴って必要となる単語末用カテゴリ付き pseudo phone set を
+ * 生成・更新する. 既存の単語のカテゴリIDが変化していないときのみ使用できる. 
+ * 
+ * @param wchmm [i/o] 木構造化辞書情報
+ * @param newword [in] 追加された単語のリスト
+ * @param newnum [in] @a newword の長さ
+ * </JA>
+ * <EN>
+ * Generate or extend the category-indexed pseudo phone sets needed by
+ * newly added words, without re-generating all the sets.  This can be
+ * used only when category IDs of existing words are not changed.
+ * 
+ * @param wchmm [i/o] tree lexicon
+ * @param newword [in] list of added words
+ * @param newnum [in] length of @a newword
+ * </EN>
+ * @callgraph
+ * @callergraph
+ */
+void
+lcdset_register_with_category_words(WCHMM_INFO *wchmm, WORD_ID *newword, int newnum)
+{
+  WORD_INFO *winfo;
+  DFA_INFO *dfa;
+  WORD_ID c, c1, w, w_prev;
+  int i, j;
+  HMM_Logical *ltmp;
+  boolean *isnew, *cate_new, *cate_prec, *cate_succ;
+
+  winfo = wchmm->winfo;
+  dfa = wchmm->dfa;
+
+  isnew = (boolean *)mymalloc(sizeof(boolean) * winfo->num);
+  for(w=0;w<winfo->num;w++) isnew[w] = FALSE;
+  for(j=0;j<newnum;j++) isnew[newword[j]] = TRUE;
+  /* categories consisting of new words only, categories preceding
+     new words, and categories following new words */
+  cate_new = (boolean *)mymalloc(sizeof(boolean) * dfa->term_num * 3);
+  cate_prec = &(cate_new[dfa->term_num]);
+  cate_succ = &(cate_new[dfa->term_num * 2]);
+  for(c=0;c<dfa->term_num;c++) {
+    cate_new[c] = (dfa->term.wnum[c] > 0) ? TRUE : FALSE;
+    for(i=0;i<dfa->term.wnum[c];i++) {
+      if (! isnew[dfa->term.tw[c][i]]) {
+	cate_new[c] = FALSE;
+	break;
+      }
+    }
+    cate_prec[c] = cate_succ[c] = FALSE;
+  }
+  for(j=0;j<newnum;j++) {
+    c = winfo->wton[newword[j]];
+    for(c1=0;c1<dfa->term_num;c1++) {
+      if (dfa_cp(dfa, c1, c)) cate_prec[c1] = TRUE;
+      if (dfa_cp(dfa, c, c1)) cate_succ[c1] = TRUE;
+    }
+  }
+
+  /* (1) word end phone of new words */
+  for(j=0;j<newnum;j++) {
+    w = newword[j];
+    ltmp = winfo->wseq[w][winfo->wlen[w]-1];
+    lcdset_register_with_category(wchmm, ltmp, winfo->wton[w]);
+  }
+  /* (2) possible left context of one-phoneme words, when the word or
+     its predecessor is new */
+  for(w=0;w<winfo->num;w++) {
+    if (winfo->wlen[w] > 1) continue;
+    if (! isnew[w] && ! cate_succ[winfo->wton[w]]) continue;
+    for(c1=0;c1<dfa->term_num;c1++) {
+      if (! dfa_cp(dfa, c1, winfo->wton[w])) continue;
+      for(i=0;i<dfa->term.wnum[c1];i++) {
+	w_prev = dfa->term.tw[c1][i];
+	if (! isnew[w] && ! isnew[w_prev]) continue;
+	ltmp = get_left_context_logical(winfo->wseq[w][0], winfo->wseq[w_prev][winfo->wlen[w_prev]-1], wchmm->hmminfo);
+	if (ltmp == NULL) continue;
+	if (ltmp->is_pseudo) continue;
+	lcdset_register_with_category(wchmm, ltmp, winfo->wton[w]);
+      }
+    }
+  }
+  /* (3) sets of words that may be followed by the new words should
+     have the new head phones as right context */
+  for(c=0;c<dfa->term_num;c++) {
+    if (! cate_prec[c] || cate_new[c]) continue;
+    for(i=0;i<dfa->term.wnum[c];i++) {
+      w = dfa->term.tw[c][i];
+      ltmp = winfo->wseq[w][winfo->wlen[w]-1];
+      lcdset_add_with_category(wchmm, ltmp, c, newword, newnum);
+      if (winfo->wlen[w] > 1) continue;
+      for(c1=0;c1<dfa->term_num;c1++) {
+	if (! dfa_cp(dfa, c1, c)) continue;
+	for(j=0;j<dfa->term.wnum[c1];j++) {
+	  w_prev = dfa->term.tw[c1][j];
+	  ltmp = get_left_context_logical(winfo->wseq[w][0], winfo->wseq[w_prev][winfo->wlen[w_prev]-1], wchmm->hmminfo);
+	  if (ltmp == NULL) continue;
+	  if (ltmp->is_pseudo) continue;
+	  lcdset_add_with_category(wchmm, ltmp, c, newword, newnum);
+	}
+      }
+    }
+  }
+
+  free(cate_new);
+  free(isnew);
+}
+
 /** 
  * <JA>
  * カテゴリ付き pseudo phone set をすべて消去する. この関数は Julian で文法が
@@ -317,6 +491,7 @@ void
 lcdset_remove_with_category_all(WCHMM_INFO *wchmm)
 {
   free_cdset(&(wchmm->lcdset_category_root), &(wchmm->lcdset_mroot));
+  ctxtable_free(&(wchmm->lcdset_category_index));
 }
 
 #endif /* PASS1_IWCD */
@@ -353,8 +528,6 @@ lcdset_remove_with_category_all(WCHMM_INFO *wchmm)
 LOGPROB
 outprob_style(WCHMM_INFO *wchmm, int node, int last_wid, int t, HTK_Param *param)
 {
-  char rbuf[MAX_HMMNAME_LEN]; ///< Local workarea for HMM name conversion
-
 #ifndef PASS1_IWCD
   
   /* if cross-word triphone handling is disabled, we simply compute the
@@ -364,7 +537,7 @@ outprob_style(WCHMM_INFO *wchmm, int node, int last_wid, int t, HTK_Param *param
 #else  /* PASS1_IWCD */
 
   /* state type and context cache is considered */
-  HMM_Logical *ohmm, *rhmm;
+  HMM_Logical *ohmm, *rhmm, *lhmm;
   RC_INFO *rset;
   LRC_INFO *lrset;
   CD_Set *lcd;
@@ -392,7 +565,7 @@ outprob_style(WCHMM_INFO *wchmm, int node, int last_wid, int t, HTK_Param *param
       /* rset contains either defined biphone or pseudo biphone */
       if (last_wid != WORD_INVALID) {
 	/* lookup triphone with left-context (= last phoneme) */
-	if ((ohmm = get_left_context_HMM(rset->hmm, (winfo->wseq[last_wid][winfo->wlen[last_wid]-1])->name, hmminfo)) != NULL) {
+	if ((ohmm = get_left_context_logical(rset->hmm, winfo->wseq[last_wid][winfo->wlen[last_wid]-1], hmminfo)) != NULL) {
 	  rhmm = ohmm;
 	} else {
 	  /* if triphone not found, try to use the bi-phone itself */
@@ -441,24 +614,21 @@ outprob_style(WCHMM_INFO *wchmm, int node, int last_wid, int t, HTK_Param *param
       /* cache miss...calculate */
       rhmm = lrset->hmm;
       /* lookup cdset for given left context (= last phoneme) */
-      strcpy(rbuf, rhmm->name);
-      if (last_wid != WORD_INVALID) {
-	add_left_context(rbuf, (winfo->wseq[last_wid][winfo->wlen[last_wid]-1])->name);
-      }
+      lhmm = (last_wid != WORD_INVALID) ? winfo->wseq[last_wid][winfo->wlen[last_wid]-1] : NULL;
       if (wchmm->category_tree) {
 #ifdef USE_OLD_IWCD
-	lcd = lcdset_lookup_by_hmmname(hmminfo, rbuf);
+	lcd = lcdset_lookup_by_logical(hmminfo, rhmm, lhmm);
 #else
 	/* use category-indexed cdset */
-	if (last_wid != WORD_INVALID &&
-	    (ohmm = get_left_context_HMM(rhmm, (winfo->wseq[last_wid][winfo->wlen[last_wid]-1])->name, hmminfo)) != NULL) {
+	if (lhmm != NULL &&
+	    (ohmm = get_left_context_logical(rhmm, lhmm, hmminfo)) != NULL) {
 	  lcd = lcdset_lookup_with_category(wchmm, ohmm, lrset->category);
 	} else {
 	  lcd = lcdset_lookup_with_category(wchmm, rhmm, lrset->category);
 	}
 #endif
       } else {
-	lcd = lcdset_lookup_by_hmmname(hmminfo, rbuf);
+	lcd = lcdset_lookup_by_logical(hmminfo, rhmm, lhmm);
       }
       if (lcd != NULL) {	/* found, set to cache */
 	lrset->last_is_lset  = TRUE;
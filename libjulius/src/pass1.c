@@ -55,6 +55,86 @@
 /* the pipeline processing is not here: see realtime_1stpass.c      */
 /********************************************************************/
 
+/** 
+ * <EN>
+ * Process one input frame for a recognition process instance.  The
+ * result is stored in p->proceed_status.  This may be called on a
+ * worker thread, in parallel with instances of other AMs.
+ * </EN>
+ * <JA>
+ * 1つの認識処理インスタンスの処理を1フレーム分進める. 結果は
+ * p->proceed_status に格納される. 他の音響モデルのインスタンスと
+ * 並列にワーカースレッド上で呼ばれることがある. 
+ * </JA>
+ * 
+ * @param p [i/o] recognition process instance
+ * @param data [in] not used
+ * 
+ */
+static void
+decode_proceed_process(RecogProcess *p, void *data)
+{
+  MFCCCalc *mfcc;
+
+  p->proceed_status = 0;
+  mfcc = p->am->mfcc;
+  if (!mfcc->valid) {
+    /* このフレームの処理をスキップ */
+    /* skip processing the frame */
+    return;
+  }
+
+  /* mfcc-f のフレームについて認識処理(フレーム同期ビーム探索)を進める */
+  /* proceed beam search for mfcc->f */
+  if (mfcc->f == 0) {
+    /* 最初のフレーム: 探索処理を初期化 */
+    /* initial frame: initialize search process */
+    if (get_back_trellis_init(mfcc->param, p) == FALSE) {
+      p->proceed_status = -1;
+      return;
+    }
+  }
+  if (mfcc->f > 0 || p->am->hmminfo->multipath) {
+    /* 1フレーム探索を進める */
+    /* proceed search for 1 frame */
+    if (get_back_trellis_proceed(mfcc->f, mfcc->param, p, FALSE) == FALSE) {
+      p->proceed_status = 1;
+    }
+    if (p->config->successive.enabled) {
+      if (detect_end_of_segment(p, mfcc->f - 1)) {
+	/* セグメント終了検知: 第１パスここで中断 */
+	p->proceed_status = 1;
+      }
+    }
+  }
+}
+
+/**
+ * Discard the first frames of the input already committed by
+ * stream_commit_words(), and move the current frame pointer back.
+ * The output probability cache of the rest frames is moved with them.
+ *
+ * @param recog [i/o] engine instance
+ * @param shift [in] number of frames to discard
+ */
+static void
+decode_shift(Recog *recog, int shift)
+{
+  MFCCCalc *mfcc;
+  PROCESS_AM *am;
+
+  for (mfcc = recog->mfcclist; mfcc; mfcc = mfcc->next) {
+    mfcc->param->header.samplenum = mfcc->f + 1;
+    mfcc->param->samplenum = mfcc->f + 1;
+    mfcc_shrink(mfcc, shift);
+    mfcc->f -= shift;
+  }
+  for(am = recog->amlist; am; am = am->next) {
+    outprob_cache_keep(&(am->hmmwrk), shift, am->mfcc->f + 1);
+    outprob_prepare(&(am->hmmwrk), recog->real.maxframelen);
+  }
+}
+
 /** 
  * <EN>
  * @brief  Process one input frame for all recognition process instance.
@@ -67,6 +147,9 @@
  * If an instance's mfcc->invalid is set to TRUE, its processing will
  * be skipped.
  *
+ * With -srthreads, instances of different AMs are processed in parallel
+ * and this function waits for all of them.
+ *
  * When using GMM, GMM computation will also be executed here.
  * If GMM_VAD is defined, GMM-based voice detection will be performed
  * inside this function, by using a scheme of short-pause segmentation.
@@ -77,6 +160,9 @@
  * application.  When segmented, it stores current frame and return with
  * that status.
  *
+ * With -streamcommit, converged words are committed and the input
+ * frames before them are discarded here.
+ *
  * The frame-wise callbacks will be executed inside this function,
  * when at least one valid recognition process instances exists.
  * 
@@ -116,6 +202,7 @@ decode_proceed(Recog *recog)
   boolean break_decode;
   RecogProcess *p;
   boolean ok_p;
+  int shift;
 #ifdef GMM_VAD
   GMMCalc *gmm;
   boolean break_gmm;
@@ -124,9 +211,7 @@ decode_proceed(Recog *recog)
   break_decode = FALSE;
 
   for(p = recog->process_list; p; p = p->next) {
-#ifdef DETERMINE
     p->have_determine = FALSE;
-#endif
     p->have_interim = FALSE;
   }
   for (mfcc = recog->mfcclist; mfcc; mfcc = mfcc->next) {
@@ -217,39 +302,19 @@ decode_proceed(Recog *recog)
 #endif /* GMM_VAD */
   }
 
+  /* proceed all processes for the frame, in parallel if enabled */
+  sr_parallel_exec(recog, decode_proceed_process, NULL);
+
   for(p = recog->process_list; p; p = p->next) {
     if (!p->live) continue;
-    mfcc = p->am->mfcc;
-    if (!mfcc->valid) {
-      /* このフレームの処理をスキップ */
-      /* skip processing the frame */
-      continue;
-    }
-
-    /* mfcc-f のフレームについて認識処理(フレーム同期ビーム探索)を進める */
-    /* proceed beam search for mfcc->f */
-    if (mfcc->f == 0) {
-      /* 最初のフレーム: 探索処理を初期化 */
-      /* initial frame: initialize search process */
-      if (get_back_trellis_init(mfcc->param, p) == FALSE) {
-	jlog("ERROR: %02d %s: failed to initialize the 1st pass\n", p->config->id, p->config->name);
-	return -1;
-      }
-    }
-    if (mfcc->f > 0 || p->am->hmminfo->multipath) {
-      /* 1フレーム探索を進める */
-      /* proceed search for 1 frame */
-      if (get_back_trellis_proceed(mfcc->f, mfcc->param, p, FALSE) == FALSE) {
-	mfcc->segmented = TRUE;
-	break_decode = TRUE;
-      }
-      if (p->config->successive.enabled) {
-	if (detect_end_of_segment(p, mfcc->f - 1)) {
-	  /* セグメント終了検知: 第１パスここで中断 */
-	  mfcc->segmented = TRUE;
-	  break_decode = TRUE;
-	}
-      }
+    switch(p->proceed_status) {
+    case -1:
+      jlog("ERROR: %02d %s: failed to initialize the 1st pass\n", p->config->id, p->config->name);
+      return -1;
+    case 1:
+      p->am->mfcc->segmented = TRUE;
+      break_decode = TRUE;
+      break;
     }
   }
 
@@ -293,8 +358,17 @@ decode_proceed(Recog *recog)
     return 1;
   }
 
+  /* commit converged words and discard the past input on streaming */
+  for(p = recog->process_list; p; p = p->next) {
+    if (!p->live) continue;
+    if (p->config->pass1.stream_commit <= 0) continue;
+    if (!p->am->mfcc->valid) continue;
+    if ((shift = stream_commit_words(p, p->am->mfcc->f)) > 0) {
+      decode_shift(recog, shift);
+    }
+  }
+
   /* call frame-wise callback for the processing results if any */
-#ifdef DETERMINE
   ok_p = FALSE;
   for(p=recog->process_list;p;p=p->next) {
     if (!p->live) continue;
@@ -303,7 +377,6 @@ decode_proceed(Recog *recog)
     }
   }
   if (ok_p) callback_exec(CALLBACK_RESULT_PASS1_DETERMINED, recog);
-#endif
   ok_p = FALSE;
   for(p=recog->process_list;p;p=p->next) {
     if (!p->live) continue;
@@ -376,6 +449,9 @@ decode_end_segmented(Recog *recog)
   RecogProcess *p;
   int last_status;
 
+  /* output the result of the previous segment before those of this one */
+  pass2_async_wait(recog);
+
   /* rejectshort 指定時, 入力が短ければここで第1パス結果を出力しない */
   /* suppress 1st pass output if -rejectshort and input shorter than specified */
   ok_p = TRUE;
@@ -462,6 +538,9 @@ decode_end(Recog *recog)
   RecogProcess *p;
   int last_status;
 
+  /* output the result of the previous segment before those of this one */
+  pass2_async_wait(recog);
+
   for (mfcc = recog->mfcclist; mfcc; mfcc = mfcc->next) {
     mfcc->segmented = FALSE;
   }
@@ -705,6 +784,10 @@ get_back_trellis(Recog *recog)
 #endif
 
     if (spsegment_need_restart(recog, &rewind_frame, &reprocess) == TRUE) {
+      /* keep outprob cache of the remaining frames */
+      for(am=recog->amlist;am;am=am->next) {
+	outprob_cache_keep(&(am->hmmwrk), rewind_frame, am->mfcc->param->samplenum - rewind_frame);
+      }
       /* do rewind for all mfcc here */
       spsegment_restart_mfccs(recog, rewind_frame, reprocess);
       /* reset outprob cache for all AM */
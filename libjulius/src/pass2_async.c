@@ -0,0 +1,599 @@
+/**
+ * @file   pass2_async.c
+ *
+ * <JA>
+ * @brief  第2パスのバックグラウンド実行
+ *
+ * 入力区間の第1パス終了後，その第2パスをワーカースレッドで実行し，
+ * その間に次の入力区間の第1パスを進める. ジョブは認識処理インスタンスの
+ * 複製の上で実行され，複製はバックトレリス，スタックデコーディングの
+ * ワークエリア，結果格納場所，出力確率キャッシュを独自に持つ. 結果は
+ * 第2パスの終了後，メインスレッドから入力順に出力される.
+ * N-gram を用いるインスタンスのみ対応し，それ以外の場合は従来通り
+ * 同期的に実行する.
+ * </JA>
+ *
+ * <EN>
+ * @brief  Background execution of the 2nd pass
+ *
+ * After the 1st pass of an input segment, its 2nd pass is executed on a
+ * worker thread while the 1st pass of the next segment proceeds.  The
+ * job works on copies of the recognition process instances, each with
+ * its own back trellis, stack decoding work area, result storage and
+ * outprob cache.  The results are output from the main thread in input
+ * order after the 2nd pass finishes.  Only instances using N-gram are
+ * supported: otherwise the 2nd pass is executed synchronously as before.
+ * </EN>
+ *
+ * @author Akinobu Lee
+ * @date   Mon Oct 19 17:05:12 2026
+ *
+ * $Revision: 1.1 $
+ *
+ */
+/*
+ * Copyright (c) 1991-2013 Kawahara Lab., Kyoto University
+ * Copyright (c) 2000-2005 Shikano Lab., Nara Institute of Science and Technology
+ * Copyright (c) 2005-2013 Julius project team, Nagoya Institute of Technology
+ * All rights reserved
+ */
+
+#include <julius/julius.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <sys/time.h>
+#endif
+
+/**
+ * <JA>
+ * 現在時刻を秒単位で返す.
+ *
+ * @return 現在時刻 (秒)
+ * </JA>
+ * <EN>
+ * Return the current time in seconds.
+ *
+ * @return the current time in seconds.
+ * </EN>
+ *
+ * @callgraph
+ * @callergraph
+ */
+double
+pass2_time_now()
+{
+#ifdef HAVE_PTHREAD
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return((double)tv.tv_sec + (double)tv.tv_usec / 1000000.0);
+#else
+  return((double)time(NULL));
+#endif
+}
+
+/**
+ * <JA>
+ * 第2パスの処理時間と，第1パス終了から結果出力までの遅延を出力する.
+ *
+ * @param start_time [in] 第1パス終了時刻
+ * @param pass2_time [in] 第2パスの処理時間
+ * </JA>
+ * <EN>
+ * Output the processing time of the 2nd pass, and the latency from the
+ * end of the 1st pass to the result output.
+ *
+ * @param start_time [in] time at the end of the 1st pass
+ * @param pass2_time [in] processing time of the 2nd pass
+ * </EN>
+ *
+ * @callgraph
+ * @callergraph
+ */
+void
+pass2_latency_log(double start_time, double pass2_time)
+{
+  jlog("STAT: 2nd pass: %.3f sec, result latency %.3f sec from end of 1st pass\n", pass2_time, pass2_time_now() - start_time);
+}
+
+/**
+ * Check if the 2nd pass of the current live processes can run in
+ * background.  Grammars may be changed while the job runs, and the
+ * DNN computation uses work area shared within the AM, so only N-gram
+ * based processes on GMM-based AMs are allowed.
+ *
+ * @param recog [in] engine instance
+ *
+ * @return TRUE if possible, FALSE if not.
+ */
+static boolean
+pass2_async_possible(Recog *recog)
+{
+  RecogProcess *r;
+  PROCESS_AM *am;
+
+  for(am = recog->amlist; am; am = am->next) {
+    if (am->dnn != NULL) return FALSE;
+  }
+  for(r = recog->process_list; r; r = r->next) {
+    if (!r->live) continue;
+    if (r->lmtype != LM_PROB) return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ * Free the process copies of a job.
+ *
+ * @param a [i/o] background 2nd pass work area
+ */
+static void
+pass2_async_release(Pass2Async *a)
+{
+  RecogProcess *s, *next;
+
+  for(s = a->process_list; s; s = next) {
+    next = s->next;
+    wchmm_fbs_free(s);
+    bt_free(s->backtrellis);
+    free(s->wchmm);
+    free(s);
+  }
+  a->process_list = NULL;
+}
+
+#ifdef HAVE_PTHREAD
+
+/**
+ * Main function of the worker thread: execute the 2nd pass and
+ * alignment on the process copies of each given job.
+ *
+ * @param arg [in] background 2nd pass work area
+ *
+ * @return NULL.
+ */
+static void *
+pass2_async_worker(void *arg)
+{
+  Pass2Async *a = (Pass2Async *)arg;
+  RecogProcess *s;
+  double t;
+
+  while(1) {
+    pthread_mutex_lock(&(a->mutex));
+    while (!a->quit && (!a->running || a->done)) {
+      pthread_cond_wait(&(a->cond), &(a->mutex));
+    }
+    if (a->quit) {
+      pthread_mutex_unlock(&(a->mutex));
+      break;
+    }
+    pthread_mutex_unlock(&(a->mutex));
+
+    t = pass2_time_now();
+    for(s = a->process_list; s; s = s->next) {
+      pass2_process(s, NULL);
+    }
+    for(s = a->process_list; s; s = s->next) {
+      if (s->result.status < 0) continue;
+      do_alignment_all(s, s->am->mfcc->param);
+    }
+
+    pthread_mutex_lock(&(a->mutex));
+    a->pass2_time = pass2_time_now() - t;
+    a->done = TRUE;
+    pthread_cond_broadcast(&(a->cond));
+    pthread_mutex_unlock(&(a->mutex));
+  }
+  return NULL;
+}
+
+#endif /* HAVE_PTHREAD */
+
+/**
+ * Create the work area and the worker thread.  Spare outprob caches and
+ * input storages are prepared for each AM.
+ *
+ * @param recog [in] engine instance
+ *
+ * @return the new work area, or NULL on failure.
+ */
+static Pass2Async *
+pass2_async_new(Recog *recog)
+{
+#ifdef HAVE_PTHREAD
+  Pass2Async *a;
+  PROCESS_AM *am;
+  HMMWork *wrk;
+  int i;
+
+  a = (Pass2Async *)mymalloc(sizeof(Pass2Async));
+  memset(a, 0, sizeof(Pass2Async));
+  for(am = recog->amlist; am; am = am->next) a->amnum++;
+  a->am = (PROCESS_AM *)mymalloc(sizeof(PROCESS_AM) * a->amnum);
+  memset(a->am, 0, sizeof(PROCESS_AM) * a->amnum);
+  a->mfcc = (MFCCCalc *)mymalloc(sizeof(MFCCCalc) * a->amnum);
+  memset(a->mfcc, 0, sizeof(MFCCCalc) * a->amnum);
+
+  for(am = recog->amlist, i = 0; am; am = am->next, i++) {
+    wrk = &(a->am[i].hmmwrk);
+    wrk->compute_gaussset = am->hmmwrk.compute_gaussset;
+    wrk->compute_gaussset_init = am->hmmwrk.compute_gaussset_init;
+    wrk->compute_gaussset_free = am->hmmwrk.compute_gaussset_free;
+    if (am->config->hmm_gs_filename != NULL) {/* with GMS */
+      if (outprob_init(wrk, am->hmminfo, am->hmm_gs, am->config->gs_statenum, am->config->gprune_method, am->config->mixnum_thres, am->dnn) == FALSE) {
+	return NULL;
+      }
+    } else {
+      if (outprob_init(wrk, am->hmminfo, NULL, 0, am->config->gprune_method, am->config->mixnum_thres, am->dnn) == FALSE) {
+	return NULL;
+      }
+    }
+    outprob_set_batch_computation(wrk, FALSE);
+    a->mfcc[i].param = new_param();
+  }
+
+  pthread_mutex_init(&(a->mutex), NULL);
+  pthread_cond_init(&(a->cond), NULL);
+  if (pthread_create(&(a->thread), NULL, pass2_async_worker, a) != 0) {
+    return NULL;
+  }
+  jlog("STAT: pass2_async: 2nd pass runs in background\n");
+
+  return a;
+#else
+  return NULL;
+#endif
+}
+
+/**
+ * Copy the input of an AM to the input storage of a job.
+ *
+ * @param dst [out] input storage of the job
+ * @param src [in] input to be copied
+ */
+static void
+pass2_async_copy_param(HTK_Param *dst, HTK_Param *src)
+{
+  unsigned int t;
+
+  param_free_content(dst);
+  param_init_content(dst);
+  memcpy(&(dst->header), &(src->header), sizeof(HTK_Param_Header));
+  dst->samplenum = src->samplenum;
+  dst->veclen = src->veclen;
+  dst->is_outprob = src->is_outprob;
+  if (param_alloc(dst, dst->samplenum, dst->veclen) == FALSE) {
+    j_internal_error("ERROR: pass2_async: failed to allocate memory for input\n");
+  }
+  for(t = 0; t < src->samplenum; t++) {
+    memcpy(dst->parvec[t], src->parvec[t], sizeof(VECT) * dst->veclen);
+  }
+}
+
+/**
+ * On short-pause segmentation, set the word context of the next segment
+ * from the 1st pass result, since the 2nd pass result which gives it in
+ * synchronous mode is not available yet.
+ *
+ * @param r [i/o] recognition process instance
+ * @param s [in] 1st pass result of the segment
+ */
+static void
+pass2_async_set_last_nword(RecogProcess *r, Sentence *s)
+{
+  int i;
+  WORD_ID w;
+
+  if (r->sp_break_last_nword_allow_override) {
+    for(i = s->word_num - 1; i >= 0; i--) {
+      w = s->word[i];
+      if (w != r->sp_break_last_word
+	  && !is_sil(w, r)
+	  && !r->lm->winfo->is_transparent[w]
+	  ) {
+	r->sp_break_last_nword = w;
+	break;
+      }
+    }
+  } else {
+    r->sp_break_last_nword = WORD_INVALID;
+  }
+}
+
+/**
+ * Wait for the job to finish, and output its result.
+ *
+ * @param recog [in] engine instance
+ * @param wait [in] TRUE to wait for the job, FALSE to return immediately
+ * if it has not finished yet
+ */
+static void
+pass2_async_flush(Recog *recog, boolean wait)
+{
+  Pass2Async *a;
+  RecogProcess *list;
+
+  if ((a = recog->pass2async) == NULL) return;
+  if (! a->running) return;
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&(a->mutex));
+  if (!wait && !a->done) {
+    pthread_mutex_unlock(&(a->mutex));
+    return;
+  }
+  while (!a->done) {
+    pthread_cond_wait(&(a->cond), &(a->mutex));
+  }
+  a->running = FALSE;
+  pthread_mutex_unlock(&(a->mutex));
+#endif
+
+  /* output the results of the copies as those of the processes */
+  list = recog->process_list;
+  recog->process_list = a->process_list;
+  pass2_output(recog, a->pass2_p);
+  recog->process_list = list;
+  if (verbose_flag) pass2_latency_log(a->start_time, a->pass2_time);
+
+  /* events deferred at the end of the input */
+  if (a->segment_end) callback_exec(CALLBACK_EVENT_SEGMENT_END, recog);
+  if (a->recognition_end) callback_exec(CALLBACK_EVENT_RECOGNITION_END, recog);
+  jlog_flush();
+
+  pass2_async_release(a);
+}
+
+/**
+ * <JA>
+ * -pass2async 指定時，第1パスの終わった入力の第2パスをワーカースレッドで
+ * 開始する. 各インスタンスの複製を作成し，バックトレリス・結果格納場所・
+ * 出力確率キャッシュ・入力パラメータを複製側へ移す. 元のインスタンスは
+ * 新しいものを使って次の入力を処理できる.
+ *
+ * @param recog [in] エンジンインスタンス
+ * @param pass2_p [in] いずれかのインスタンスで第2パスを行うならTRUE
+ * @param start_time [in] 第1パス終了時刻
+ *
+ * @return バックグラウンドで開始したら TRUE，同期的に実行すべき場合 FALSE
+ * </JA>
+ * <EN>
+ * When -pass2async is specified, start the 2nd pass of the input whose
+ * 1st pass has finished on the worker thread.  A copy of each process
+ * instance is made, and the back trellis, result storage, outprob cache
+ * and input parameters are handed over to the copy.  The original
+ * instances go on to the next input with new ones.
+ *
+ * @param recog [in] engine instance
+ * @param pass2_p [in] TRUE if any instance executes the 2nd pass
+ * @param start_time [in] time at the end of the 1st pass
+ *
+ * @return TRUE if started in background, or FALSE if the 2nd pass should
+ * be executed synchronously.
+ * </EN>
+ *
+ * @callgraph
+ * @callergraph
+ */
+boolean
+pass2_async_start(Recog *recog, boolean pass2_p, double start_time)
+{
+  Pass2Async *a;
+  PROCESS_AM *am, *sam;
+  RecogProcess *r, *s, *last;
+  HMMWork wrk;
+  int i;
+
+  if (! recog->jconf->decodeopt.pass2_async) return FALSE;
+
+  if (recog->pass2async == NULL) {
+    if ((recog->pass2async = pass2_async_new(recog)) == NULL) {
+      jlog("WARNING: pass2_async: failed to start worker thread, 2nd pass runs synchronously\n");
+      recog->jconf->decodeopt.pass2_async = FALSE;
+      return FALSE;
+    }
+  }
+  a = recog->pass2async;
+  if (! pass2_async_possible(recog)) {
+    if (! a->warned) {
+      jlog("WARNING: pass2_async: only for N-gram with GMM-based AM, 2nd pass runs synchronously\n");
+      a->warned = TRUE;
+    }
+    return FALSE;
+  }
+
+  /* the previous result should have been output at the end of the 1st pass */
+  pass2_async_flush(recog, TRUE);
+
+  /* hand over the outprob cache and input of each AM to the job */
+  for(am = recog->amlist, i = 0; am; am = am->next, i++) {
+    sam = &(a->am[i]);
+    wrk = sam->hmmwrk;
+    *sam = *am;
+    am->hmmwrk = wrk;
+    /* the overlap of segmented input goes on to the next decoding */
+    outprob_cache_carry(&(am->hmmwrk), &(sam->hmmwrk));
+    sam->mfcc = &(a->mfcc[i]);
+    sam->next = NULL;
+    pass2_async_copy_param(sam->mfcc->param, am->mfcc->param);
+  }
+
+  /* make copies of the live processes */
+  a->process_list = last = NULL;
+  for(r = recog->process_list; r; r = r->next) {
+    if (!r->live) continue;
+    s = (RecogProcess *)mymalloc(sizeof(RecogProcess));
+    *s = *r;
+    for(am = recog->amlist, i = 0; am != r->am; am = am->next, i++);
+    s->am = &(a->am[i]);
+    /* lexicon tree refers to the outprob cache of the job */
+    s->wchmm = (WCHMM_INFO *)mymalloc(sizeof(WCHMM_INFO));
+    memcpy(s->wchmm, r->wchmm, sizeof(WCHMM_INFO));
+    s->wchmm->hmmwrk = &(s->am->hmmwrk);
+    /* back trellis and result go to the copy */
+    r->backtrellis = (BACKTRELLIS *)mymalloc(sizeof(BACKTRELLIS));
+    bt_init(r->backtrellis);
+    memset(&(r->result), 0, sizeof(Output));
+    memset(&(s->pass2), 0, sizeof(StackDecode));
+    wchmm_fbs_prepare(s);
+    s->next = NULL;
+    if (last) last->next = s;
+    else a->process_list = s;
+    last = s;
+
+    if (r->config->successive.enabled
+	&& !r->config->compute_only_1pass
+	&& s->result.status >= 0) {
+      pass2_async_set_last_nword(r, &(s->result.pass1));
+    }
+  }
+
+  a->pass2_p = pass2_p;
+  a->start_time = start_time;
+  a->segment_end = FALSE;
+  a->recognition_end = FALSE;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&(a->mutex));
+  a->running = TRUE;
+  a->done = FALSE;
+  pthread_cond_broadcast(&(a->cond));
+  pthread_mutex_unlock(&(a->mutex));
+#endif
+
+  return TRUE;
+}
+
+/**
+ * <JA>
+ * バックグラウンドの第2パスが実行中の場合，入力の終了時のイベントを
+ * その結果出力の後まで遅らせる.
+ *
+ * @param recog [in] エンジンインスタンス
+ * @param segment_end [in] 区間終了を通知するなら TRUE
+ * @param recognition_end [in] 認識終了を通知するなら TRUE
+ *
+ * @return 遅らせた場合 TRUE，すぐに通知すべき場合 FALSE
+ * </JA>
+ * <EN>
+ * When the 2nd pass is running in background, defer the events at the
+ * end of the input until its result is output.
+ *
+ * @param recog [in] engine instance
+ * @param segment_end [in] TRUE if segment end should be notified
+ * @param recognition_end [in] TRUE if recognition end should be notified
+ *
+ * @return TRUE if deferred, or FALSE if they should be notified now.
+ * </EN>
+ *
+ * @callgraph
+ * @callergraph
+ */
+boolean
+pass2_async_defer_end(Recog *recog, boolean segment_end, boolean recognition_end)
+{
+  Pass2Async *a;
+
+  if ((a = recog->pass2async) == NULL) return FALSE;
+  if (! a->running) return FALSE;
+  a->segment_end = segment_end;
+  a->recognition_end = recognition_end;
+  return TRUE;
+}
+
+/**
+ * <JA>
+ * バックグラウンドの第2パスが終わっていれば結果を出力する. 終わって
+ * いなければ何もしない.
+ *
+ * @param recog [in] エンジンインスタンス
+ * </JA>
+ * <EN>
+ * Output the result of the background 2nd pass if it has finished.
+ * Do nothing if not.
+ *
+ * @param recog [in] engine instance
+ * </EN>
+ *
+ * @callgraph
+ * @callergraph
+ */
+void
+pass2_async_poll(Recog *recog)
+{
+  pass2_async_flush(recog, FALSE);
+}
+
+/**
+ * <JA>
+ * バックグラウンドの第2パスの終了を待ち，結果を出力する.
+ *
+ * @param recog [in] エンジンインスタンス
+ * </JA>
+ * <EN>
+ * Wait for the background 2nd pass to finish, and output its result.
+ *
+ * @param recog [in] engine instance
+ * </EN>
+ *
+ * @callgraph
+ * @callergraph
+ */
+void
+pass2_async_wait(Recog *recog)
+{
+  pass2_async_flush(recog, TRUE);
+}
+
+/**
+ * <JA>
+ * 第2パスのバックグラウンド実行用のスレッドを終了し，解放する.
+ * 実行中のジョブの結果は破棄される.
+ *
+ * @param recog [in] エンジンインスタンス
+ * </JA>
+ * <EN>
+ * Terminate and free the thread for background execution of the 2nd
+ * pass.  The result of a running job is discarded.
+ *
+ * @param recog [in] engine instance
+ * </EN>
+ *
+ * @callgraph
+ * @callergraph
+ */
+void
+pass2_async_free(Recog *recog)
+{
+  Pass2Async *a;
+  RecogProcess *s;
+  int i;
+
+  if ((a = recog->pass2async) == NULL) return;
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&(a->mutex));
+  while (a->running && !a->done) {
+    pthread_cond_wait(&(a->cond), &(a->mutex));
+  }
+  a->quit = TRUE;
+  pthread_cond_broadcast(&(a->cond));
+  pthread_mutex_unlock(&(a->mutex));
+  pthread_join(a->thread, NULL);
+  pthread_cond_destroy(&(a->cond));
+  pthread_mutex_destroy(&(a->mutex));
+#endif
+  for(s = a->process_list; s; s = s->next) clear_result(s);
+  pass2_async_release(a);
+  for(i = 0; i < a->amnum; i++) {
+    outprob_free(&(a->am[i].hmmwrk));
+    free_param(a->mfcc[i].param);
+  }
+  free(a->mfcc);
+  free(a->am);
+  free(a);
+  recog->pass2async = NULL;
+}
+
+/* end of file */
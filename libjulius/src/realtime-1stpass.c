@@ -681,6 +681,10 @@ proceed_one_frame(Recog *recog)
       mfcc->param->header.samplenum = mfcc->f + 1;
       mfcc->param->samplenum = mfcc->f + 1;
     }
+    /* keep outprob cache of the remaining frames */
+    for(am=recog->amlist;am;am=am->next) {
+      outprob_cache_keep(&(am->hmmwrk), rewind_frame, am->mfcc->param->samplenum - rewind_frame);
+    }
     /* do rewind for all mfcc here */
     spsegment_restart_mfccs(recog, rewind_frame, reprocess);
     /* also tell adin module to rehash the concurrent audio input */
@@ -991,6 +995,9 @@ RealTimeResume(Recog *recog)
   /* prepare cache area for acoustic computation of HMM states and mixtures */
   for(am=recog->amlist;am;am=am->next) {
     outprob_prepare(&(am->hmmwrk), r->maxframelen);
+    if (verbose_flag && am->hmmwrk.cache_kept_frames > 0) {
+      jlog("STAT: AM%02d %s: reused %d cached outprobs in %d overlapped frames\n", am->config->id, am->config->name, am->hmmwrk.cache_kept, am->hmmwrk.cache_kept_frames);
+    }
   }
 
   /* param にある全パラメータを処理する準備 */
@@ -442,6 +442,8 @@ adin_cut_callback_store_buffer(SP16 *now, int len, Recog *recog)
 static int
 callback_check_in_adin(Recog *recog)
 {
+  /* output the result of the 2nd pass running in background if finished */
+  pass2_async_poll(recog);
   /* module: check command and terminate recording when requested */
   callback_exec(CALLBACK_POLL, recog);
   /* With audio input via adinnet, TERMINATE command will issue terminate
@@ -657,6 +659,9 @@ result_error(Recog *recog, int status)
   RecogProcess *r;
   boolean ok_p;
 
+  /* output the result of the previous segment first */
+  pass2_async_wait(recog);
+
   for(r=recog->process_list;r;r=r->next) r->result.status = status;
 
   ok_p = FALSE;
@@ -675,6 +680,121 @@ result_error(Recog *recog, int status)
   }
 }
 
+/** 
+ * <EN>
+ * Execute the 2nd pass for a recognition process instance.  This may be
+ * called on a worker thread, in parallel with instances of other AMs,
+ * or in background of the next input (-pass2async).
+ * </EN>
+ * <JA>
+ * 1つの認識処理インスタンスの第2パスを実行する. 他の音響モデルの
+ * インスタンスと並列に，あるいは次の入力の処理と並行して
+ * (-pass2async) ワーカースレッド上で呼ばれることがある. 
+ * </JA>
+ * 
+ * @param r [i/o] recognition process instance
+ * @param data [in] not used
+ * 
+ * @callgraph
+ * @callergraph
+ */
+void
+pass2_process(RecogProcess *r, void *data)
+{
+  /* if [-1pass] is specified, just copy from 1st pass result */
+  if (r->config->compute_only_1pass) return;
+  /* if search already failed on 1st pass, skip 2nd pass */
+  if (r->result.status < 0) return;
+  /* prepare result storage */
+  if (r->lmtype == LM_DFA && r->config->output.multigramout_flag) {
+    result_sentence_malloc(r, r->config->output.output_hypo_maxnum * multigram_get_all_num(r->lm));
+  } else {
+    result_sentence_malloc(r, r->config->output.output_hypo_maxnum);
+  }
+  /* do 2nd pass */
+  if (r->lmtype == LM_PROB) {
+    wchmm_fbs(r->am->mfcc->param, r, 0, 0);
+  } else if (r->lmtype == LM_DFA) {
+    if (r->config->output.multigramout_flag) {
+      /* execute 2nd pass multiple times for each grammar sequencially */
+      /* to output result for each grammar */
+      MULTIGRAM *m;
+      boolean has_success = FALSE;
+      for(m = r->lm->grammars; m; m = m->next) {
+	if (m->active) {
+	  jlog("STAT: execute 2nd pass limiting words for gram #%d\n", m->id);
+	  wchmm_fbs(r->am->mfcc->param, r, m->cate_begin, m->dfa->term_num);
+	  if (r->result.status == J_RESULT_STATUS_SUCCESS) {
+	    has_success = TRUE;
+	  }
+	}
+      }
+      r->result.status = (has_success == TRUE) ? J_RESULT_STATUS_SUCCESS : J_RESULT_STATUS_FAIL;
+    } else {
+      /* only the best among all grammar will be output */
+      wchmm_fbs(r->am->mfcc->param, r, 0, r->lm->dfa->term_num);
+    }
+  }
+}
+
+/** 
+ * <EN>
+ * Output the final results of all the live recognition process instances
+ * after the 2nd pass, and clear the result storages.
+ * </EN>
+ * <JA>
+ * 第2パス終了後に，全ての有効な認識処理インスタンスの最終結果を
+ * 出力し，結果の格納場所をクリアする. 
+ * </JA>
+ * 
+ * @param recog [in] engine instance
+ * @param pass2_p [in] TRUE if the 2nd pass was executed for any instance
+ * 
+ * @callgraph
+ * @callergraph
+ */
+void
+pass2_output(Recog *recog, boolean pass2_p)
+{
+  RecogProcess *r;
+  boolean ok_p;
+
+  /* output result */
+  callback_exec(CALLBACK_RESULT, recog);
+#ifdef ENABLE_PLUGIN
+  plugin_exec_process_result(recog);
+#endif
+  /* output graph */
+  /* r->result.wg == NULL should be skipped inside the callback */
+  ok_p = FALSE;
+  for(r=recog->process_list;r;r=r->next) {
+    if (!r->live) continue;
+    if (r->config->compute_only_1pass) continue;
+    if (r->result.status < 0) continue;
+    if (r->config->graph.lattice) ok_p = TRUE;
+  }
+  if (ok_p) callback_exec(CALLBACK_RESULT_GRAPH, recog);
+  /* output confnet */
+  /* r->result.confnet == NULL should be skipped inside the callback */
+  ok_p = FALSE;
+  for(r=recog->process_list;r;r=r->next) {
+    if (!r->live) continue;
+    if (r->config->compute_only_1pass) continue;
+    if (r->result.status < 0) continue;
+    if (r->config->graph.confnet) ok_p = TRUE;
+  }
+  if (ok_p) callback_exec(CALLBACK_RESULT_CONFNET, recog);
+
+  /* clear work area for output */
+  for(r=recog->process_list;r;r=r->next) {
+    if (!r->live) continue;
+    clear_result(r);
+  }
+  
+  /* output end of 2nd pass */
+  if (pass2_p) callback_exec(CALLBACK_EVENT_PASS2_END, recog);
+}
+
 /** 
  * <EN>
  * @brief  Execute recognition.
@@ -724,6 +844,8 @@ j_recognize_stream_core(Recog *recog)
   boolean process_segment_last;
   boolean on_the_fly;
   boolean pass2_p;
+  boolean segment_end_p, recognition_end_p;
+  double start_time, pass2_time;
 
   jconf = recog->jconf;
 
@@ -1154,6 +1276,9 @@ j_recognize_stream_core(Recog *recog)
 	/* assume all MFCCCalc has params of the same sample num */
 	for(am=recog->amlist;am;am=am->next) {
 	  outprob_prepare(&(am->hmmwrk), am->mfcc->param->samplenum);
+	  if (verbose_flag && am->hmmwrk.cache_kept_frames > 0) {
+	    jlog("STAT: AM%02d %s: reused %d cached outprobs in %d overlapped frames\n", am->config->id, am->config->name, am->hmmwrk.cache_kept, am->hmmwrk.cache_kept_frames);
+	  }
 	}
       }
       
@@ -1196,6 +1321,9 @@ j_recognize_stream_core(Recog *recog)
     /* end processing of the 1st-pass */
     /**********************************/
     /* on-the-fly 1st pass processing will join here */
+
+    /* latency of the final result is measured from here */
+    start_time = pass2_time_now();
     
     /* -rejectshort 指定時, 入力が指定時間以下であれば探索失敗として */
     /* 第２パスを実行せずにここで終了する */
@@ -1308,88 +1436,28 @@ j_recognize_stream_core(Recog *recog)
     }
 #endif
     
-    /* execute stack-decoding search */
-    for(r=recog->process_list;r;r=r->next) {
-      if (!r->live) continue;
-      /* if [-1pass] is specified, just copy from 1st pass result */
-      if (r->config->compute_only_1pass) continue;
-      /* if search already failed on 1st pass, skip 2nd pass */
-      if (r->result.status < 0) continue;
-      /* prepare result storage */
-      if (r->lmtype == LM_DFA && r->config->output.multigramout_flag) {
-	result_sentence_malloc(r, r->config->output.output_hypo_maxnum * multigram_get_all_num(r->lm));
-      } else {
-	result_sentence_malloc(r, r->config->output.output_hypo_maxnum);
-      }
-      /* do 2nd pass */
-      if (r->lmtype == LM_PROB) {
-	wchmm_fbs(r->am->mfcc->param, r, 0, 0);
-      } else if (r->lmtype == LM_DFA) {
-	if (r->config->output.multigramout_flag) {
-	  /* execute 2nd pass multiple times for each grammar sequencially */
-	  /* to output result for each grammar */
-	  MULTIGRAM *m;
-	  boolean has_success = FALSE;
-	  for(m = r->lm->grammars; m; m = m->next) {
-	    if (m->active) {
-	      jlog("STAT: execute 2nd pass limiting words for gram #%d\n", m->id);
-	      wchmm_fbs(r->am->mfcc->param, r, m->cate_begin, m->dfa->term_num);
-	      if (r->result.status == J_RESULT_STATUS_SUCCESS) {
-		has_success = TRUE;
-	      }
-	    }
-	  }
-	  r->result.status = (has_success == TRUE) ? J_RESULT_STATUS_SUCCESS : J_RESULT_STATUS_FAIL;
-	} else {
-	  /* only the best among all grammar will be output */
-	  wchmm_fbs(r->am->mfcc->param, r, 0, r->lm->dfa->term_num);
-	}
-      }
-    }
+    /* execute stack-decoding search in background, and go on to the
+       next input.  The result will be output when it finishes */
+    if (! pass2_async_start(recog, pass2_p, start_time)) {
 
-    /* do forced alignment if needed */
-    for(r=recog->process_list;r;r=r->next) {
-      if (!r->live) continue;
-      /* if search failed on 2nd pass, skip this */
-      if (r->result.status < 0) continue;
-      /* do needed alignment */
-      do_alignment_all(r, r->am->mfcc->param);
-    }
+      /* execute stack-decoding search, in parallel if enabled */
+      sr_parallel_exec(recog, pass2_process, NULL);
 
-    /* output result */
-    callback_exec(CALLBACK_RESULT, recog);
-#ifdef ENABLE_PLUGIN
-    plugin_exec_process_result(recog);
-#endif
-    /* output graph */
-    /* r->result.wg == NULL should be skipped inside the callback */
-    ok_p = FALSE;
-    for(r=recog->process_list;r;r=r->next) {
-      if (!r->live) continue;
-      if (r->config->compute_only_1pass) continue;
-      if (r->result.status < 0) continue;
-      if (r->config->graph.lattice) ok_p = TRUE;
-    }
-    if (ok_p) callback_exec(CALLBACK_RESULT_GRAPH, recog);
-    /* output confnet */
-    /* r->result.confnet == NULL should be skipped inside the callback */
-    ok_p = FALSE;
-    for(r=recog->process_list;r;r=r->next) {
-      if (!r->live) continue;
-      if (r->config->compute_only_1pass) continue;
-      if (r->result.status < 0) continue;
-      if (r->config->graph.confnet) ok_p = TRUE;
-    }
-    if (ok_p) callback_exec(CALLBACK_RESULT_CONFNET, recog);
+      /* do forced alignment if needed */
+      for(r=recog->process_list;r;r=r->next) {
+	if (!r->live) continue;
+	/* if search failed on 2nd pass, skip this */
+	if (r->result.status < 0) continue;
+	/* do needed alignment */
+	do_alignment_all(r, r->am->mfcc->param);
+      }
+      pass2_time = pass2_time_now() - start_time;
 
-    /* clear work area for output */
-    for(r=recog->process_list;r;r=r->next) {
-      if (!r->live) continue;
-      clear_result(r);
+      /* output result */
+      pass2_output(recog, pass2_p);
+
+      if (verbose_flag) pass2_latency_log(start_time, pass2_time);
     }
-    
-    /* output end of 2nd pass */
-    if (pass2_p) callback_exec(CALLBACK_EVENT_PASS2_END, recog);
 
 #ifdef DEBUG_VTLN_ALPHA_TEST
     if (r->am->mfcc->para->vtln_alpha == 1.0) {
@@ -1433,14 +1501,21 @@ j_recognize_stream_core(Recog *recog)
     /* callback of recognition end */
     if (jconf->decodeopt.segment) {
 #ifdef BACKEND_VAD
-      if (recog->triggered) callback_exec(CALLBACK_EVENT_SEGMENT_END, recog);
-      if (process_segment_last && !recog->process_segment) callback_exec(CALLBACK_EVENT_RECOGNITION_END, recog);
+      segment_end_p = recog->triggered;
+      recognition_end_p = (process_segment_last && !recog->process_segment);
 #else
-      callback_exec(CALLBACK_EVENT_SEGMENT_END, recog);
-      if (!recog->process_segment) callback_exec(CALLBACK_EVENT_RECOGNITION_END, recog);
+      segment_end_p = TRUE;
+      recognition_end_p = !recog->process_segment;
 #endif
     } else {
-      callback_exec(CALLBACK_EVENT_RECOGNITION_END, recog);
+      segment_end_p = FALSE;
+      recognition_end_p = TRUE;
+    }
+    /* when the 2nd pass of this input is running in background, they
+       will be called after its result */
+    if (! pass2_async_defer_end(recog, segment_end_p, recognition_end_p)) {
+      if (segment_end_p) callback_exec(CALLBACK_EVENT_SEGMENT_END, recog);
+      if (recognition_end_p) callback_exec(CALLBACK_EVENT_RECOGNITION_END, recog);
     }
 
 
@@ -1530,6 +1605,9 @@ j_recognize_stream(Recog *recog)
     
     ret = j_recognize_stream_core(recog);
 
+    /* output the result of the 2nd pass running in background if any */
+    pass2_async_wait(recog);
+
     switch(ret) {
     case 1:	      /* paused by a callback (stream will continue) */
       /* call pause event callbacks */
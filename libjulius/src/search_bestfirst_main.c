@@ -876,6 +876,309 @@ envl_update(StackDecode *s, NODE *n, int framenum)
 }
 #endif /* SCAN_BEAM */
 
+/*
+ * 3. Hypothesis recombination
+ *
+ * 履歴の遠い部分のみが異なる仮説が何度も取り出され，同じ単語の
+ * Viterbi 計算と展開が繰り返されるのを防ぐ. 以降の展開に影響する
+ * 仮説の状態 (言語制約上の文脈，末尾音素，単語トレリス上の位置) が
+ * 同じで，Viterbi 計算の元となる前向きスコアが全フレームで既に展開した
+ * 仮説以下であれば，Viterbi 計算と展開を行わずに捨てる. 捨てた仮説からは
+ * 別の単語列の文が得られるため，N-best 探索では使用できない. また
+ * 探索順が変わるため，第1候補が変わることもある.
+ *
+ * Avoid repeating the Viterbi and expansion of the same word for
+ * hypotheses that differ only in distant history.  If a popped
+ * hypothesis has the same state that affects further expansion
+ * (context on the language constraint, last phone and position on the
+ * word trellis) as an already expanded one, and its forward scores from
+ * which the Viterbi will be computed are not better than those of the
+ * expanded one on all frames, it is discarded without Viterbi and
+ * expansion.  Since the discarded one would lead to sentences of other
+ * word sequences, this cannot be used with N-best search.  The change of
+ * search order may also alter the first result.
+ *
+ */
+
+/** 
+ * <JA>
+ * 仮説再結合キャッシュを確保する. 入力ごとに第2パスの開始時に呼ばれる. 
+ * 
+ * @param c [out] 仮説再結合キャッシュ
+ * @param mb [in] メモリ上限 (MB)
+ * @param framenum [in] 入力フレーム長
+ * </JA>
+ * <EN>
+ * Allocate the hypothesis recombination cache.  This will be called at
+ * the beginning of 2nd pass for each input.
+ * 
+ * @param c [out] hypothesis recombination cache
+ * @param mb [in] memory limit in MB
+ * @param framenum [in] input frame length
+ * </EN>
+ */
+static void
+recomb_init(RecombCache *c, int mb, int framenum)
+{
+  int i;
+
+  c->num = (int)((double)mb * 1000.0 * 1000.0 / (sizeof(RecombEntry) + sizeof(RecombEntry *) * 2 + sizeof(LOGPROB) * framenum));
+  if (c->num < 1) c->num = 1;
+  c->pool = (RecombEntry *)mymalloc(sizeof(RecombEntry) * c->num);
+  c->gpool = (LOGPROB *)mymalloc(sizeof(LOGPROB) * framenum * c->num);
+  for(c->size = 1; c->size < c->num; c->size <<= 1);
+  c->bucket = (RecombEntry **)mymalloc(sizeof(RecombEntry *) * c->size);
+  for(i=0;i<c->size;i++) c->bucket[i] = NULL;
+  c->used = 0;
+  c->lru_head = c->lru_tail = NULL;
+  c->lookups = c->hits = c->evicts = 0;
+}
+
+/** 
+ * <JA>
+ * 仮説再結合キャッシュを解放する. 
+ * 
+ * @param c [i/o] 仮説再結合キャッシュ
+ * </JA>
+ * <EN>
+ * Free the hypothesis recombination cache.
+ * 
+ * @param c [i/o] hypothesis recombination cache
+ * </EN>
+ */
+static void
+recomb_free(RecombCache *c)
+{
+  free(c->pool);
+  free(c->gpool);
+  free(c->bucket);
+  c->pool = NULL;
+  c->gpool = NULL;
+  c->bucket = NULL;
+}
+
+/** 
+ * <JA>
+ * 仮説から再結合のキーを作る. N-gram では末尾の N-1 語 (透過語はその
+ * 先まで含める)，文法では末尾の単語と DFA 状態を文脈とする. 
+ * 
+ * @param e [out] キーを格納するエントリ
+ * @param n [in] 仮説
+ * @param r [in] 認識処理インスタンス
+ * 
+ * @return キーを作れた場合 TRUE，文脈が長すぎる場合 FALSE を返す. 
+ * </JA>
+ * <EN>
+ * Set the recombination key from a hypothesis.  The context is the last
+ * N-1 words (extended over transparent words) for N-gram, or the last
+ * word and the DFA state for grammar.
+ * 
+ * @param e [out] entry to store the key
+ * @param n [in] hypothesis
+ * @param r [in] recognition process instance
+ * 
+ * @return TRUE on success, or FALSE if the context is too long to be kept.
+ * </EN>
+ */
+static boolean
+recomb_set_key(RecombEntry *e, NODE *n, RecogProcess *r)
+{
+  int i, cnnum;
+  unsigned int h;
+
+  e->ctxlen = 0;
+  if (r->lmtype == LM_PROB) {
+    cnnum = 0;
+    for(i=n->seqnum-1;i>=0;i--) {
+      if (e->ctxlen >= RECOMB_CTX_MAX) return FALSE;
+      e->ctx[e->ctxlen++] = n->seq[i];
+      if (! r->lm->winfo->is_transparent[n->seq[i]]) {
+	if (++cnnum >= r->lm->ngram->n - 1) break;
+      }
+    }
+    e->state = 0;
+  } else {
+    e->ctx[e->ctxlen++] = n->seq[n->seqnum-1];
+    e->state = n->state;
+  }
+  e->last_ph = n->last_ph;
+  e->last_ph_sp_attached = n->last_ph_sp_attached;
+  e->lscore = n->lscore;
+  e->bestt = n->bestt;
+  e->estimated_next_t = n->estimated_next_t;
+  e->tre = n->tre;
+
+  h = 0;
+  for(i=0;i<e->ctxlen;i++) h = h * 31 + e->ctx[i];
+  h = h * 31 + e->state;
+  h = h * 31 + (unsigned int)((size_t)e->last_ph >> 3);
+  h = h * 31 + (unsigned int)((size_t)e->tre >> 3);
+  h = h * 31 + e->bestt;
+  h = h * 31 + e->estimated_next_t;
+  e->hash = h;
+
+  return TRUE;
+}
+
+/** 
+ * <JA>
+ * 2つのエントリのキーが等しいかどうか調べる. 
+ * 
+ * @param a [in] エントリ
+ * @param b [in] エントリ
+ * 
+ * @return 等しければ TRUE を返す. 
+ * </JA>
+ * <EN>
+ * Check if the keys of two entries are the same.
+ * 
+ * @param a [in] entry
+ * @param b [in] entry
+ * 
+ * @return TRUE if the same.
+ * </EN>
+ */
+static boolean
+recomb_key_equal(RecombEntry *a, RecombEntry *b)
+{
+  int i;
+
+  if (a->hash != b->hash
+      || a->ctxlen != b->ctxlen
+      || a->state != b->state
+      || a->last_ph != b->last_ph
+      || a->last_ph_sp_attached != b->last_ph_sp_attached
+      || a->lscore != b->lscore
+      || a->bestt != b->bestt
+      || a->estimated_next_t != b->estimated_next_t
+      || a->tre != b->tre) return FALSE;
+  for(i=0;i<a->ctxlen;i++) {
+    if (a->ctx[i] != b->ctx[i]) return FALSE;
+  }
+  return TRUE;
+}
+
+/** 
+ * <JA>
+ * エントリを最近使われたものとしてLRUリストの先頭に移す. 
+ * 
+ * @param c [i/o] 仮説再結合キャッシュ
+ * @param e [in] エントリ
+ * </JA>
+ * <EN>
+ * Move an entry to the head of the LRU list as the most recently used.
+ * 
+ * @param c [i/o] hypothesis recombination cache
+ * @param e [in] entry
+ * </EN>
+ */
+static void
+recomb_touch(RecombCache *c, RecombEntry *e)
+{
+  if (c->lru_head == e) return;
+  /* unlink */
+  if (e->lru_prev) e->lru_prev->lru_next = e->lru_next;
+  if (e->lru_next) e->lru_next->lru_prev = e->lru_prev;
+  if (c->lru_tail == e) c->lru_tail = e->lru_prev;
+  /* push to head */
+  e->lru_prev = NULL;
+  e->lru_next = c->lru_head;
+  if (c->lru_head) c->lru_head->lru_prev = e;
+  c->lru_head = e;
+  if (c->lru_tail == NULL) c->lru_tail = e;
+}
+
+/** 
+ * <JA>
+ * 取り出した仮説が，既に展開した同じ状態の仮説に支配されているか
+ * 調べる. 支配されていなければ，この仮説をキャッシュに登録する. 
+ * 
+ * @param c [i/o] 仮説再結合キャッシュ
+ * @param n [in] 取り出した仮説
+ * @param framenum [in] 入力フレーム長
+ * @param r [in] 認識処理インスタンス
+ * 
+ * @return 支配されていれば TRUE，そうでなければ FALSE を返す. 
+ * </JA>
+ * <EN>
+ * Check if the popped hypothesis is dominated by an already expanded
+ * one with the same state.  If not, the hypothesis is registered to the
+ * cache.
+ * 
+ * @param c [i/o] hypothesis recombination cache
+ * @param n [in] popped hypothesis
+ * @param framenum [in] input frame length
+ * @param r [in] recognition process instance
+ * 
+ * @return TRUE if dominated, or FALSE if not.
+ * </EN>
+ */
+static boolean
+recomb_check(RecombCache *c, NODE *n, int framenum, RecogProcess *r)
+{
+  RecombEntry key, *e, **p;
+  LOGPROB *g;
+  boolean le, ge;
+  int t;
+
+  c->lookups++;
+  if (recomb_set_key(&key, n, r) == FALSE) return FALSE;
+
+  /* scan_word() computes from g_prev[] when rescanning the last phone */
+#ifdef PASS2_STRICT_IWCD
+  g = n->g;
+#else
+  g = (r->ccd_flag && n->last_ph != NULL) ? n->g_prev : n->g;
+#endif
+
+  for(e = c->bucket[key.hash & (c->size - 1)]; e; e = e->hashnext) {
+    if (! recomb_key_equal(e, &key)) continue;
+    le = ge = TRUE;
+    for(t=0;t<framenum;t++) {
+      if (g[t] > e->g[t]) le = FALSE;
+      if (g[t] < e->g[t]) ge = FALSE;
+      if (!le && !ge) break;
+    }
+    if (le) {
+      /* dominated */
+      recomb_touch(c, e);
+      c->hits++;
+      return TRUE;
+    }
+    if (ge) {
+      /* this one dominates the cached one: replace it */
+      memcpy(e->g, g, sizeof(LOGPROB) * framenum);
+      recomb_touch(c, e);
+      return FALSE;
+    }
+  }
+
+  /* register as a new entry */
+  if (c->used < c->num) {
+    e = &(c->pool[c->used]);
+    e->g = &(c->gpool[framenum * c->used]);
+    c->used++;
+  } else {
+    /* replace the least recently used entry */
+    e = c->lru_tail;
+    c->lru_tail = e->lru_prev;
+    if (c->lru_tail) c->lru_tail->lru_next = NULL;
+    else c->lru_head = NULL;
+    for(p = &(c->bucket[e->hash & (c->size - 1)]); *p != e; p = &((*p)->hashnext));
+    *p = e->hashnext;
+    c->evicts++;
+  }
+  g = memcpy(e->g, g, sizeof(LOGPROB) * framenum);
+  *e = key;
+  e->g = g;
+  e->hashnext = c->bucket[key.hash & (c->size - 1)];
+  c->bucket[key.hash & (c->size - 1)] = e;
+  e->lru_prev = e->lru_next = NULL;
+  recomb_touch(c, e);
+
+  return FALSE;
+}
+
 
 /**********************************************************************/
 /********** Short pause segmentation **********************************/
@@ -1263,6 +1566,7 @@ wchmm_fbs(HTK_Param *param, RecogProcess *r, int cate_bgn, int cate_num)
   /* for graph generation */
   LOGPROB prev_score;
   WordGraph *wordgraph_root = NULL;
+  WordGraphIndex *wordgraph_index = NULL;
   boolean merged_p;
 #ifdef GRAPHOUT_DYNAMIC
   int dynamic_merged_num = 0;
@@ -1317,6 +1621,11 @@ wchmm_fbs(HTK_Param *param, RecogProcess *r, int cate_bgn, int cate_num)
   /* 前向きスコア計算用の領域を確保 */
   /* malloc are for forward viterbi (scan_word()) */
   malloc_wordtrellis(r);		/* scan_word用領域 */
+  /* 仮説再結合キャッシュを確保 */
+  /* allocate hypothesis recombination cache */
+  if (jconf->pass2.recombine_mb > 0) {
+    recomb_init(&(dwrk->recomb), jconf->pass2.recombine_mb, peseqlen);
+  }
   /* 仮説スタック初期化 */
   /* initialize hypothesis stack */
   start = bottom = NULL;
@@ -1355,6 +1664,11 @@ wchmm_fbs(HTK_Param *param, RecogProcess *r, int cate_bgn, int cate_num)
   if (jconf->graph.enabled) {
     wordgraph_init(r->wchmm);
   }
+  if (r->graphout) {
+    /* per-utterance index of saved graph words for merging */
+    wordgraph_index = &(dwrk->graph_index);
+    wordgraph_index_init(wordgraph_index, 1);
+  }
 
   /* 
    * 初期仮説(1単語からなる)を得, 文仮説スタックにいれる
@@ -1544,7 +1858,7 @@ wchmm_fbs(HTK_Param *param, RecogProcess *r, int cate_bgn, int cate_num)
 
 #ifdef GRAPHOUT_DYNAMIC
       /* merge last word in popped hypo if possible */
-      wtmp = wordgraph_check_merge(now->prevgraph, &wordgraph_root, now->seq[now->seqnum-1], &merged_p, jconf);
+      wtmp = wordgraph_check_merge(now->prevgraph, &wordgraph_root, wordgraph_index, now->seq[now->seqnum-1], &merged_p, jconf);
       if (wtmp != NULL) {		/* wtmp holds merged word */
 	dynamic_merged_num++;
 
@@ -1581,7 +1895,7 @@ wchmm_fbs(HTK_Param *param, RecogProcess *r, int cate_bgn, int cate_num)
 	/*printf("last word merged\n");*/
 	/* previous still remains at memory here... (will be purged later) */
       } else {
-	wordgraph_save(now->prevgraph, now->lastcontext, &wordgraph_root);
+	wordgraph_save(now->prevgraph, now->lastcontext, &wordgraph_root, wordgraph_index);
       }
 #ifdef GRAPHOUT_SEARCH
       /* if recent hypotheses are included in the existing graph, terminate */
@@ -1599,7 +1913,7 @@ wchmm_fbs(HTK_Param *param, RecogProcess *r, int cate_bgn, int cate_num)
 #endif
 #else  /* ~GRAPHOUT_DYNAMIC */
       /* always save */
-      wordgraph_save(now->prevgraph, now->lastcontext, &wordgraph_root);
+      wordgraph_save(now->prevgraph, now->lastcontext, &wordgraph_root, wordgraph_index);
 #endif /* ~GRAPHOUT_DYNAMIC */
     }
 
@@ -1687,6 +2001,19 @@ wchmm_fbs(HTK_Param *param, RecogProcess *r, int cate_bgn, int cate_num)
     }
 #endif
 
+    /* 同じ状態の展開済み仮説に支配されていれば，この仮説は展開しない */
+    /* discard this hypothesis if dominated by an expanded one of the same state */
+    if (jconf->pass2.recombine_mb > 0) {
+      if (recomb_check(&(dwrk->recomb), now, peseqlen, r)) {
+	if (debug2_flag) {
+	  jlog("DEBUG: popped but recombined:");
+	  put_hypo_woutput(now, r->lm->winfo);
+	}
+	free_node(now);
+	continue;
+      }
+    }
+
     /*
      * 前向きスコアを更新する： 最後の単語の部分の前向きスコアを計算する. 
      * update forward score: compute forward trellis for the last word
@@ -2183,6 +2510,11 @@ wchmm_fbs(HTK_Param *param, RecogProcess *r, int cate_bgn, int cate_num)
     jlog("STAT: %02d %s: %d generated, %d pushed, %d nodes popped in %d\n",
 	 r->config->id, r->config->name,
 	 dwrk->genectr, dwrk->pushctr, dwrk->popctr, backtrellis->framelen);
+    if (jconf->pass2.recombine_mb > 0) {
+      jlog("STAT: %02d %s: recombination: %d of %d hypotheses recombined, %d entries of %d evicted\n",
+	   r->config->id, r->config->name,
+	   dwrk->recomb.hits, dwrk->recomb.lookups, dwrk->recomb.evicts, dwrk->recomb.num);
+    }
     jlog_flush();
 #ifdef GRAPHOUT_DYNAMIC
     if (r->graphout) {
@@ -2191,9 +2523,12 @@ wchmm_fbs(HTK_Param *param, RecogProcess *r, int cate_bgn, int cate_num)
       jlog("S, %d terminated", terminate_search_num);
 #endif
       jlog(" in %d\n", dwrk->popctr);
+      jlog("STAT: %02d %s: graph: %d lookups examined %d words in index\n", r->config->id, r->config->name, wordgraph_index->lookups, wordgraph_index->probes);
     }
 #endif
   }
+  /* index of saved graph words is not needed after search */
+  if (wordgraph_index != NULL) wordgraph_index_free(wordgraph_index);
     
   if (dwrk->finishnum > 0 && r->graphout) {
     if (verbose_flag) jlog("STAT: ------ wordgraph post-processing begin ------\n");
@@ -2222,6 +2557,8 @@ wchmm_fbs(HTK_Param *param, RecogProcess *r, int cate_bgn, int cate_num)
       wordgraph_check_coherence(wordgraph_root, r);
       /* compute graph CM by forward-backward processing */
       graph_forward_backward(wordgraph_root, r);
+      /* acoustic scores on the final word segments for rescoring */
+      if (r->config->graph.amscore) wordgraph_compute_amscore(wordgraph_root, r);
       if (verbose_flag) jlog("STAT: ------ wordgraph post-processing end ------\n");
 
       r->result.wg = wordgraph_root;
@@ -2258,6 +2595,8 @@ wchmm_fbs(HTK_Param *param, RecogProcess *r, int cate_bgn, int cate_num)
       wordgraph_check_coherence(wordgraph_root, r);
       /* compute graph CM by forward-backward processing */
       graph_forward_backward(wordgraph_root, r);
+      /* acoustic scores on the final word segments for rescoring */
+      if (r->config->graph.amscore) wordgraph_compute_amscore(wordgraph_root, r);
       if (verbose_flag) jlog("STAT: ------ wordgraph post-processing end ------\n");
       /* output graph */
       r->result.wg = wordgraph_root;
@@ -2277,6 +2616,7 @@ wchmm_fbs(HTK_Param *param, RecogProcess *r, int cate_bgn, int cate_num)
   nw_free(nextword, nwroot);
   free_all_nodes(start);
   free_wordtrellis(dwrk);
+  if (jconf->pass2.recombine_mb > 0) recomb_free(&(dwrk->recomb));
 #ifdef SCAN_BEAM
   free(dwrk->framemaxscore);
 #endif
@@ -2311,9 +2651,15 @@ wchmm_fbs_prepare(RecogProcess *r)
   if (r->lmtype == LM_PROB && r->lm->ngram) {
     dwrk->cnword = (WORD_ID *)mymalloc(sizeof(WORD_ID) * r->lm->ngram->n);
     dwrk->cnwordrev = (WORD_ID *)mymalloc(sizeof(WORD_ID) * r->lm->ngram->n);
+    ngram_context_init(&(dwrk->cnctx), r->lm->ngram);
   } else {
     dwrk->cnword = dwrk->cnwordrev = NULL;
   }
+  dwrk->cnsel = NULL;
+  dwrk->cnnword = NULL;
+  dwrk->cnidx = NULL;
+  dwrk->cnprob = NULL;
+  dwrk->cnalloc = 0;
   dwrk->stocker_root = NULL;
 #ifdef CONFIDENVE_MEASURE
 #ifdef CM_MULTIPLE_ALPHA
@@ -2352,6 +2698,14 @@ wchmm_fbs_free(RecogProcess *r)
     free(dwrk->cnword);
     free(dwrk->cnwordrev);
     dwrk->cnword = dwrk->cnwordrev = NULL;
+    ngram_context_free(&(dwrk->cnctx));
+  }
+  if (dwrk->cnalloc > 0) {
+    free(dwrk->cnsel);
+    free(dwrk->cnnword);
+    free(dwrk->cnidx);
+    free(dwrk->cnprob);
+    dwrk->cnalloc = 0;
   }
 
 #ifdef CONFIDENVE_MEASURE
@@ -438,6 +438,8 @@ malloc_wordtrellis(RecogProcess *r)
 
   dwrk->wordtrellis[0] = (LOGPROB *)mymalloc(sizeof(LOGPROB) * maxwn);
   dwrk->wordtrellis[1] = (LOGPROB *)mymalloc(sizeof(LOGPROB) * maxwn);
+  dwrk->lr_self_a = (LOGPROB *)mymalloc(sizeof(LOGPROB) * maxwn);
+  dwrk->lr_next_a = (LOGPROB *)mymalloc(sizeof(LOGPROB) * maxwn);
 
   dwrk->g = (LOGPROB *)mymalloc(sizeof(LOGPROB) * r->peseqlen);
 
@@ -483,6 +485,8 @@ free_wordtrellis(StackDecode *dwrk)
 
   free(dwrk->wordtrellis[0]);
   free(dwrk->wordtrellis[1]);
+  free(dwrk->lr_self_a);
+  free(dwrk->lr_next_a);
   free(dwrk->g);
   free(dwrk->phmmseq);
   if (dwrk->has_sp) {
@@ -564,6 +568,88 @@ max_out_arc(HMM_Logical *l)
   return(get_max_out_arc(hmm_logical_trans(l), hmm_logical_state_num(l)));
 }
 
+/** 
+ * <JA>
+ * 単語HMMが単純な left-to-right 型 (最終状態以外の各状態が自己遷移と
+ * 次状態への遷移のみを持つ) かどうか調べ，そうであれば遷移確率を
+ * 配列に展開する. 
+ * 
+ * @param whmm [in] 単語HMM
+ * @param self_a [out] 各状態の自己遷移確率を格納するバッファ
+ * @param next_a [out] 各状態の次状態への遷移確率を格納するバッファ
+ * 
+ * @return 展開できた場合 TRUE, 一般の遷移を含む場合 FALSE を返す. 
+ * </JA>
+ * <EN>
+ * Check if the word HMM is a plain left-to-right model, in which every
+ * state except the last one has only a self-loop and a transition to the
+ * next state, and if so, flatten the transition probabilities into arrays.
+ * 
+ * @param whmm [in] word HMM
+ * @param self_a [out] buffer to store self-loop probability of each state
+ * @param next_a [out] buffer to store probability to the next state of each state
+ * 
+ * @return TRUE if flattened, or FALSE if the HMM has other transitions.
+ * </EN>
+ */
+static boolean
+wordtrellis_lr_flatten(HMM *whmm, LOGPROB *self_a, LOGPROB *next_a)
+{
+  int i;
+  A_CELL *ac;
+
+  for(i=0;i<whmm->len-1;i++) {
+    /* new_make_word_hmm() prepends arcs, so the arc to the next state
+       comes first and wins ties in the generic loop */
+    ac = whmm->state[i].ac;
+    if (ac == NULL || ac->arc != i + 1) return FALSE;
+    if (ac->next == NULL || ac->next->arc != i || ac->next->next != NULL) return FALSE;
+    next_a[i] = ac->a;
+    self_a[i] = ac->next->a;
+  }
+  return TRUE;
+}
+
+/** 
+ * <JA>
+ * left-to-right 単語HMMの1フレーム分の遷移を max-plus 演算で一括計算する. 
+ * 各状態の値は，自己遷移と次状態からの遷移のうち大きい方 (同点なら
+ * 次状態側) となる. 出力確率は含まない. 
+ * 
+ * @param dst [out] 計算結果 [0..len-1]
+ * @param src [in] 前フレームのトレリス [0..len]
+ * @param self_a [in] 各状態の自己遷移確率
+ * @param next_a [in] 各状態の次状態への遷移確率
+ * @param len [in] 計算する状態数
+ * </JA>
+ * <EN>
+ * Compute transitions of a frame on a left-to-right word HMM at once as
+ * a max-plus operation.  Each state takes the larger of the self-loop and
+ * the transition from the next state, preferring the latter on ties, as
+ * the generic loop does.  Output probabilities are not included.  The
+ * loop has no branch nor dependency between states, so the compiler can
+ * vectorize it.
+ * 
+ * @param dst [out] result [0..len-1]
+ * @param src [in] trellis of the previous frame [0..len]
+ * @param self_a [in] self-loop probability of each state
+ * @param next_a [in] probability to the next state of each state
+ * @param len [in] number of states to compute
+ * </EN>
+ */
+static void
+wordtrellis_lr_maxplus(LOGPROB *dst, LOGPROB *src, LOGPROB *self_a, LOGPROB *next_a, int len)
+{
+  int i;
+  LOGPROB s, n;
+
+  for(i=0;i<len;i++) {
+    s = src[i] + self_a[i];
+    n = src[i+1] + next_a[i];
+    dst[i] = (s > n) ? s : n;
+  }
+}
+
 /** 
  * <JA>
  * 最後の1単語の前向きトレリスを計算して，文仮説の前向き尤度を更新する. 
@@ -603,6 +689,7 @@ scan_word(NODE *now, HTK_Param *param, RecogProcess *r)
   int crossword_point = 0;
   boolean back_rescan = FALSE;
   boolean node_exist_p;
+  boolean lr_p;			/* TRUE if plain left-to-right word HMM */
   int tn;		       ///< Temporal pointer to current buffer
   int tl;		       ///< Temporal pointer to previous buffer
 
@@ -681,7 +768,7 @@ scan_word(NODE *now, HTK_Param *param, RecogProcess *r)
       /* 最終単語と last_ph 間の単語間triphoneを考慮 */
       /* consider cross-word context dependency between the last word and now->last_ph */
       wend = winfo->wseq[word][winfo->wlen[word]-1];
-      ret = get_right_context_HMM(wend, now->last_ph->name, hmminfo);
+      ret = get_right_context_logical(wend, now->last_ph, hmminfo);
       if (ret == NULL) {	/* triphone not found */
 	/* fallback to the original bi/mono-phone */
 	/* error if the original is pseudo phone (not explicitly defined
@@ -694,7 +781,7 @@ scan_word(NODE *now, HTK_Param *param, RecogProcess *r)
       } else {
 	dwrk->phmmseq[phmmlen-2] = ret;
       }
-      ret = get_left_context_HMM(now->last_ph, wend->name, hmminfo);
+      ret = get_left_context_logical(now->last_ph, wend, hmminfo);
       if (ret == NULL) {
 	/* fallback to the original bi/mono-phone */
 	/* error if the original is pseudo phone (not explicitly defined
@@ -860,6 +947,10 @@ scan_word(NODE *now, HTK_Param *param, RecogProcess *r)
     j_internal_error("scan_word: word too long (>%d)\n", winfo->maxwn + 10);
   }
 
+  /* 単純な left-to-right 単語HMMなら遷移確率を配列に展開しておく */
+  /* flatten transitions if the word HMM is a plain left-to-right one */
+  lr_p = (! hmminfo->multipath && wordtrellis_lr_flatten(whmm, dwrk->lr_self_a, dwrk->lr_next_a));
+
 #ifndef GRAPHOUT_PRECISE_BOUNDARY
   if (r->graphout) {
     if (ccd_flag) {
@@ -1044,50 +1135,29 @@ scan_word(NODE *now, HTK_Param *param, RecogProcess *r)
 
     } /* end of ~multipath */
 
-    /* ノード [t][wordhmmnum-2..0] についてトレリスを計算 */
-    /* expand trellis for node [t][wordhmmnum-2..0] */
-    for(i=wordhmmnum-2;i>=0;i--) {
-
-      if (ccd_flag) {
-
-	/* 最尤パスと最尤スコア tmpmax を見つける */
-	/* tmpmax2 は次回用 g_prev[] のための最大値(自己遷移を除いた最大値) */
-	/* find most likely path and the max score 'tmpmax' */
-	/* 'tmpmax2' is max score excluding self transition, for next g_prev[] */
-	if (! hmminfo->multipath) {
-	  if (i == store_point) {
-	    tmpmax2 = LOG_ZERO;
+    if (lr_p) {
+
+      /* 単純な left-to-right 単語HMM: 全状態の遷移をまとめて計算し，
+	 枝刈りと出力確率の加算のみ状態ごとに行う */
+      /* plain left-to-right word HMM: compute transitions of all states
+	 at once, then prune and add output probabilities per state */
+      wordtrellis_lr_maxplus(dwrk->wordtrellis[tn], dwrk->wordtrellis[tl], dwrk->lr_self_a, dwrk->lr_next_a, wordhmmnum - 1);
+      for(i=wordhmmnum-2;i>=0;i--) {
+	tmpmax = dwrk->wordtrellis[tn][i];
+	j = i + 1;
+	if (r->graphout || (ccd_flag && (i == crossword_point || i == store_point))) {
+	  /* re-evaluate the arcs where the chosen arc or the cross-word
+	     LM score matters */
+	  score1 = dwrk->wordtrellis[tl][i+1] + dwrk->lr_next_a[i];
+	  if (ccd_flag) {
+	    if (i == crossword_point) score1 += now->lscore;
+	    if (i == store_point) tmpmax2 = (LOG_ZERO < score1) ? score1 : LOG_ZERO;
 	  }
-	}
-	tmpmax = LOG_ZERO;
-	for (ac=whmm->state[i].ac;ac;ac=ac->next) {
-	  if (hmminfo->multipath) {
-	    if (ac->arc == wordhmmnum-1) score1 = dwrk->g[t];
-	    else if (t + 1 > startt) score1 = LOG_ZERO;
-	    else score1 = dwrk->wordtrellis[tl][ac->arc];
-	    score1 += ac->a;
+	  tmpmax = dwrk->wordtrellis[tl][i] + dwrk->lr_self_a[i];
+	  if (tmpmax > score1) {
+	    j = i;
 	  } else {
-	    score1 = dwrk->wordtrellis[tl][ac->arc] + ac->a;
-	  }
-	  if (i <= crossword_point && ac->arc > crossword_point) {
-	    /* これは単語を越える遷移 (backscan 実行時) */
-	    /* this is a transition across word (when backscan is enabled) */
-	    score1 += now->lscore; /* add LM score */
-	  }
-
-	  if (hmminfo->multipath) {
-	    if (i <= store_point && ac->arc > store_point) {
-	      if (tmpmax_store < score1) tmpmax_store = score1;
-	    }
-	  } else {
-	    if (i == store_point && i != ac->arc) {
-	      if (tmpmax2 < score1) tmpmax2 = score1;
-	    }
-	  }
-
-	  if (tmpmax < score1) {
 	    tmpmax = score1;
-	    j = ac->arc;
 	  }
 	}
 
@@ -1098,7 +1168,8 @@ scan_word(NODE *now, HTK_Param *param, RecogProcess *r)
 	    tmpmax <= framemaxscore[t] - scan_beam_thres ||
 #endif
 	    tmpmax <= LOG_ZERO
-	    ) {  /* invalid node */
+	    ) {
+	  /* invalid node */
 	  dwrk->wordtrellis[tn][i] = LOG_ZERO;
 #ifdef GRAPHOUT_PRECISE_BOUNDARY
 	  if (r->graphout) {
@@ -1106,115 +1177,201 @@ scan_word(NODE *now, HTK_Param *param, RecogProcess *r)
 	    dwrk->wend_token_gscore[tn][i] = LOG_ZERO;
 	  }
 #endif
-	  if (! hmminfo->multipath) {
-	    if (i == store_point) now->g_prev[t] = LOG_ZERO;
+	  if (ccd_flag && i == store_point) now->g_prev[t] = LOG_ZERO;
+	} else {
+	  /* survived node */
+	  if (ccd_flag && i == store_point) now->g_prev[t] = tmpmax2;
+#ifdef GRAPHOUT_PRECISE_BOUNDARY
+	  if (r->graphout) {
+	    if (ccd_flag && i == crossword_point && j > crossword_point) {
+	      dwrk->wend_token_frame[tn][i] = t;
+	      dwrk->wend_token_gscore[tn][i] = tmpmax;
+	    } else {
+	      dwrk->wend_token_frame[tn][i] = dwrk->wend_token_frame[tl][j];
+	      dwrk->wend_token_gscore[tn][i] = dwrk->wend_token_gscore[tl][j];
+	    }
 	  }
-	} else { /* survived node */
+#endif
+	  node_exist_p = TRUE;
+	  dwrk->wordtrellis[tn][i] = tmpmax + outprob(&(r->am->hmmwrk), t, &(whmm->state[i]), param);
+	}
+      }
+
+    } else {
+
+      /* ノード [t][wordhmmnum-2..0] についてトレリスを計算 */
+      /* expand trellis for node [t][wordhmmnum-2..0] */
+      for(i=wordhmmnum-2;i>=0;i--) {
+
+	if (ccd_flag) {
+
+	  /* 最尤パスと最尤スコア tmpmax を見つける */
+	  /* tmpmax2 は次回用 g_prev[] のための最大値(自己遷移を除いた最大値) */
+	  /* find most likely path and the max score 'tmpmax' */
+	  /* 'tmpmax2' is max score excluding self transition, for next g_prev[] */
 	  if (! hmminfo->multipath) {
-	    if (i == store_point) now->g_prev[t] = tmpmax2;
+	    if (i == store_point) {
+	      tmpmax2 = LOG_ZERO;
+	    }
 	  }
-#ifdef GRAPHOUT_PRECISE_BOUNDARY
-	  if (r->graphout) {
+	  tmpmax = LOG_ZERO;
+	  for (ac=whmm->state[i].ac;ac;ac=ac->next) {
+	    if (hmminfo->multipath) {
+	      if (ac->arc == wordhmmnum-1) score1 = dwrk->g[t];
+	      else if (t + 1 > startt) score1 = LOG_ZERO;
+	      else score1 = dwrk->wordtrellis[tl][ac->arc];
+	      score1 += ac->a;
+	    } else {
+	      score1 = dwrk->wordtrellis[tl][ac->arc] + ac->a;
+	    }
+	    if (i <= crossword_point && ac->arc > crossword_point) {
+	      /* これは単語を越える遷移 (backscan 実行時) */
+	      /* this is a transition across word (when backscan is enabled) */
+	      score1 += now->lscore; /* add LM score */
+	    }
 
 	    if (hmminfo->multipath) {
-	      if ((back_rescan && i <= crossword_point && j > crossword_point)
-		  || j == wordhmmnum-1) {
-		dwrk->wend_token_frame[tn][i] = t;
-		dwrk->wend_token_gscore[tn][i] = tmpmax;
-	      } else {
-		dwrk->wend_token_frame[tn][i] = dwrk->wend_token_frame[tl][j];
-		dwrk->wend_token_gscore[tn][i] = dwrk->wend_token_gscore[tl][j];
+	      if (i <= store_point && ac->arc > store_point) {
+		if (tmpmax_store < score1) tmpmax_store = score1;
 	      }
 	    } else {
-	      if (i <= crossword_point && j > crossword_point) {
-		dwrk->wend_token_frame[tn][i] = t;
-		dwrk->wend_token_gscore[tn][i] = tmpmax;
-	      } else {
-		dwrk->wend_token_frame[tn][i] = dwrk->wend_token_frame[tl][j];
-		dwrk->wend_token_gscore[tn][i] = dwrk->wend_token_gscore[tl][j];
+	      if (i == store_point && i != ac->arc) {
+		if (tmpmax2 < score1) tmpmax2 = score1;
 	      }
 	    }
+
+	    if (tmpmax < score1) {
+	      tmpmax = score1;
+	      j = ac->arc;
+	    }
 	  }
+
+	  /* スコアエンベロープチェック: 一定幅外なら落とす */
+	  /* check if score of this node is within the score envelope */
+	  if (
+#ifdef SCAN_BEAM
+	      tmpmax <= framemaxscore[t] - scan_beam_thres ||
 #endif
-	  node_exist_p = TRUE;	/* at least one node survive in this frame */
+	      tmpmax <= LOG_ZERO
+	      ) {  /* invalid node */
+	    dwrk->wordtrellis[tn][i] = LOG_ZERO;
+#ifdef GRAPHOUT_PRECISE_BOUNDARY
+	    if (r->graphout) {
+	      dwrk->wend_token_frame[tn][i] = -1;
+	      dwrk->wend_token_gscore[tn][i] = LOG_ZERO;
+	    }
+#endif
+	    if (! hmminfo->multipath) {
+	      if (i == store_point) now->g_prev[t] = LOG_ZERO;
+	    }
+	  } else { /* survived node */
+	    if (! hmminfo->multipath) {
+	      if (i == store_point) now->g_prev[t] = tmpmax2;
+	    }
+#ifdef GRAPHOUT_PRECISE_BOUNDARY
+	    if (r->graphout) {
+
+	      if (hmminfo->multipath) {
+		if ((back_rescan && i <= crossword_point && j > crossword_point)
+		    || j == wordhmmnum-1) {
+		  dwrk->wend_token_frame[tn][i] = t;
+		  dwrk->wend_token_gscore[tn][i] = tmpmax;
+		} else {
+		  dwrk->wend_token_frame[tn][i] = dwrk->wend_token_frame[tl][j];
+		  dwrk->wend_token_gscore[tn][i] = dwrk->wend_token_gscore[tl][j];
+		}
+	      } else {
+		if (i <= crossword_point && j > crossword_point) {
+		  dwrk->wend_token_frame[tn][i] = t;
+		  dwrk->wend_token_gscore[tn][i] = tmpmax;
+		} else {
+		  dwrk->wend_token_frame[tn][i] = dwrk->wend_token_frame[tl][j];
+		  dwrk->wend_token_gscore[tn][i] = dwrk->wend_token_gscore[tl][j];
+		}
+	      }
+	    }
+#endif
+	    node_exist_p = TRUE;	/* at least one node survive in this frame */
 
-	  dwrk->wordtrellis[tn][i] = tmpmax;
-	  if (! hmminfo->multipath || i > 0) {
-	    /* compute output probability */
-	    dwrk->wordtrellis[tn][i] += outprob(&(r->am->hmmwrk), t, &(whmm->state[i]), param);
+	    dwrk->wordtrellis[tn][i] = tmpmax;
+	    if (! hmminfo->multipath || i > 0) {
+	      /* compute output probability */
+	      dwrk->wordtrellis[tn][i] += outprob(&(r->am->hmmwrk), t, &(whmm->state[i]), param);
+	    }
 	  }
-	}
 	
-      } else {			/* not triphone */
+	} else {			/* not triphone */
 
-	/* backscan 無し: store_point, crossword_point は無関係 */
-	/* no backscan: store_point, crossword_point ignored */
-	tmpmax = LOG_ZERO;
-	if (hmminfo->multipath) {
-	  for (ac=whmm->state[i].ac;ac;ac=ac->next) {
-	    if (ac->arc == wordhmmnum-1) score1 = dwrk->g[t];
-	    else if (t + 1 > startt) score1 = LOG_ZERO;
-	    else score1 = dwrk->wordtrellis[tl][ac->arc];
-	    score1 += ac->a;
-	    if (tmpmax < score1) {
-	      tmpmax = score1;
-	      j = ac->arc;
+	  /* backscan 無し: store_point, crossword_point は無関係 */
+	  /* no backscan: store_point, crossword_point ignored */
+	  tmpmax = LOG_ZERO;
+	  if (hmminfo->multipath) {
+	    for (ac=whmm->state[i].ac;ac;ac=ac->next) {
+	      if (ac->arc == wordhmmnum-1) score1 = dwrk->g[t];
+	      else if (t + 1 > startt) score1 = LOG_ZERO;
+	      else score1 = dwrk->wordtrellis[tl][ac->arc];
+	      score1 += ac->a;
+	      if (tmpmax < score1) {
+		tmpmax = score1;
+		j = ac->arc;
+	      }
 	    }
-	  }
-	} else {
-	  for (ac=whmm->state[i].ac;ac;ac=ac->next) {
-	    score1 = dwrk->wordtrellis[tl][ac->arc] + ac->a;
-	    if (tmpmax < score1) {
-	      tmpmax = score1;
-	      j = ac->arc;
+	  } else {
+	    for (ac=whmm->state[i].ac;ac;ac=ac->next) {
+	      score1 = dwrk->wordtrellis[tl][ac->arc] + ac->a;
+	      if (tmpmax < score1) {
+		tmpmax = score1;
+		j = ac->arc;
+	      }
 	    }
 	  }
-	}
 
-	/* スコアエンベロープチェック: 一定幅外なら落とす */
-	/* check if score of this node is within the score envelope */
-	if (
+	  /* スコアエンベロープチェック: 一定幅外なら落とす */
+	  /* check if score of this node is within the score envelope */
+	  if (
 #ifdef SCAN_BEAM
-	    tmpmax <= framemaxscore[t] - scan_beam_thres ||
+	      tmpmax <= framemaxscore[t] - scan_beam_thres ||
 #endif
-	    tmpmax <= LOG_ZERO
-	    ) {
-	  /* invalid node */
-	  dwrk->wordtrellis[tn][i] = LOG_ZERO;
+	      tmpmax <= LOG_ZERO
+	      ) {
+	    /* invalid node */
+	    dwrk->wordtrellis[tn][i] = LOG_ZERO;
 #ifdef GRAPHOUT_PRECISE_BOUNDARY
-	  if (r->graphout) {
-	    dwrk->wend_token_frame[tn][i] = -1;
-	    dwrk->wend_token_gscore[tn][i] = LOG_ZERO;
-	  }
+	    if (r->graphout) {
+	      dwrk->wend_token_frame[tn][i] = -1;
+	      dwrk->wend_token_gscore[tn][i] = LOG_ZERO;
+	    }
 #endif
-	} else {
-	  /* survived node */
-	  node_exist_p = TRUE;
+	  } else {
+	    /* survived node */
+	    node_exist_p = TRUE;
 #ifdef GRAPHOUT_PRECISE_BOUNDARY
-	  if (r->graphout) {
-	    if (hmminfo->multipath) {
-	      if (j == wordhmmnum-1) {
-		dwrk->wend_token_frame[tn][i] = t;
-		dwrk->wend_token_gscore[tn][i] = tmpmax;
+	    if (r->graphout) {
+	      if (hmminfo->multipath) {
+		if (j == wordhmmnum-1) {
+		  dwrk->wend_token_frame[tn][i] = t;
+		  dwrk->wend_token_gscore[tn][i] = tmpmax;
+		} else {
+		  dwrk->wend_token_frame[tn][i] = dwrk->wend_token_frame[tl][j];
+		  dwrk->wend_token_gscore[tn][i] = dwrk->wend_token_gscore[tl][j];
+		}
 	      } else {
 		dwrk->wend_token_frame[tn][i] = dwrk->wend_token_frame[tl][j];
 		dwrk->wend_token_gscore[tn][i] = dwrk->wend_token_gscore[tl][j];
 	      }
-	    } else {
-	      dwrk->wend_token_frame[tn][i] = dwrk->wend_token_frame[tl][j];
-	      dwrk->wend_token_gscore[tn][i] = dwrk->wend_token_gscore[tl][j];
 	    }
-	  }
 #endif
-	  /* score of node [t][i] has been determined here */
-	  dwrk->wordtrellis[tn][i] = tmpmax;
-	  if (! hmminfo->multipath || i > 0) {
-	    dwrk->wordtrellis[tn][i] += outprob(&(r->am->hmmwrk), t, &(whmm->state[i]), param);
+	    /* score of node [t][i] has been determined here */
+	    dwrk->wordtrellis[tn][i] = tmpmax;
+	    if (! hmminfo->multipath || i > 0) {
+	      dwrk->wordtrellis[tn][i] += outprob(&(r->am->hmmwrk), t, &(whmm->state[i]), param);
+	    }
 	  }
-	}
 	
-      }
-    } /* end of node loop */
+	}
+      } /* end of node loop */
+
+    }
 
     /* 時間 t のViterbi計算終了. 前向きスコアはscanした単語の始端 */
     /* Viterbi end for frame [t].  the forward score is the score of word
@@ -1440,7 +1597,7 @@ next_word(NODE *now, NODE *new,	NEXTWORD *nword, HTK_Param *param, RecogProcess
        元仮説 now との単語間の音素環境依存性を考慮する */
     /* set the triphone at the connection point to 'newphone', considering
        cross-word context dependency to 'now' */
-    newphone = get_right_context_HMM(winfo->wseq[word][winfo->wlen[word]-1], now->last_ph->name, hmminfo);
+    newphone = get_right_context_logical(winfo->wseq[word][winfo->wlen[word]-1], now->last_ph, hmminfo);
     if (newphone == NULL) {	/* triphone not found */
       /* fallback to the original bi/mono-phone */
       /* error if the original is pseudo phone (not explicitly defined
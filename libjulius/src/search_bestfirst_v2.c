@@ -369,6 +369,8 @@ malloc_wordtrellis(RecogProcess *r)
 
   dwrk->wordtrellis[0] = (LOGPROB *)mymalloc(sizeof(LOGPROB) * maxwn);
   dwrk->wordtrellis[1] = (LOGPROB *)mymalloc(sizeof(LOGPROB) * maxwn);
+  dwrk->lr_self_a = (LOGPROB *)mymalloc(sizeof(LOGPROB) * maxwn);
+  dwrk->lr_next_a = (LOGPROB *)mymalloc(sizeof(LOGPROB) * maxwn);
 
   dwrk->g = (LOGPROB *)mymalloc(sizeof(LOGPROB) * r->peseqlen);
 
@@ -415,6 +417,8 @@ free_wordtrellis(StackDecode *dwrk)
 {
   free(dwrk->wordtrellis[0]);
   free(dwrk->wordtrellis[1]);
+  free(dwrk->lr_self_a);
+  free(dwrk->lr_next_a);
   free(dwrk->g);
   free(dwrk->phmmseq);
   if (dwrk->has_sp) {
@@ -440,6 +444,88 @@ free_wordtrellis(StackDecode *dwrk)
 /************ Compute forward score of a hypothesis *******************/
 /**********************************************************************/
 
+/** 
+ * <JA>
+ * 単語HMMが単純な left-to-right 型 (最終状態以外の各状態が自己遷移と
+ * 次状態への遷移のみを持つ) かどうか調べ，そうであれば遷移確率を
+ * 配列に展開する. 
+ * 
+ * @param whmm [in] 単語HMM
+ * @param self_a [out] 各状態の自己遷移確率を格納するバッファ
+ * @param next_a [out] 各状態の次状態への遷移確率を格納するバッファ
+ * 
+ * @return 展開できた場合 TRUE, 一般の遷移を含む場合 FALSE を返す. 
+ * </JA>
+ * <EN>
+ * Check if the word HMM is a plain left-to-right model, in which every
+ * state except the last one has only a self-loop and a transition to the
+ * next state, and if so, flatten the transition probabilities into arrays.
+ * 
+ * @param whmm [in] word HMM
+ * @param self_a [out] buffer to store self-loop probability of each state
+ * @param next_a [out] buffer to store probability to the next state of each state
+ * 
+ * @return TRUE if flattened, or FALSE if the HMM has other transitions.
+ * </EN>
+ */
+static boolean
+wordtrellis_lr_flatten(HMM *whmm, LOGPROB *self_a, LOGPROB *next_a)
+{
+  int i;
+  A_CELL *ac;
+
+  for(i=0;i<whmm->len-1;i++) {
+    /* new_make_word_hmm() prepends arcs, so the arc to the next state
+       comes first and wins ties in the generic loop */
+    ac = whmm->state[i].ac;
+    if (ac == NULL || ac->arc != i + 1) return FALSE;
+    if (ac->next == NULL || ac->next->arc != i || ac->next->next != NULL) return FALSE;
+    next_a[i] = ac->a;
+    self_a[i] = ac->next->a;
+  }
+  return TRUE;
+}
+
+/** 
+ * <JA>
+ * left-to-right 単語HMMの1フレーム分の遷移を max-plus 演算で一括計算する. 
+ * 各状態の値は，自己遷移と次状態からの遷移のうち大きい方 (同点なら
+ * 次状態側) となる. 出力確率は含まない. 
+ * 
+ * @param dst [out] 計算結果 [0..len-1]
+ * @param src [in] 前フレームのトレリス [0..len]
+ * @param self_a [in] 各状態の自己遷移確率
+ * @param next_a [in] 各状態の次状態への遷移確率
+ * @param len [in] 計算する状態数
+ * </JA>
+ * <EN>
+ * Compute transitions of a frame on a left-to-right word HMM at once as
+ * a max-plus operation.  Each state takes the larger of the self-loop and
+ * the transition from the next state, preferring the latter on ties, as
+ * the generic loop does.  Output probabilities are not included.  The
+ * loop has no branch nor dependency between states, so the compiler can
+ * vectorize it.
+ * 
+ * @param dst [out] result [0..len-1]
+ * @param src [in] trellis of the previous frame [0..len]
+ * @param self_a [in] self-loop probability of each state
+ * @param next_a [in] probability to the next state of each state
+ * @param len [in] number of states to compute
+ * </EN>
+ */
+static void
+wordtrellis_lr_maxplus(LOGPROB *dst, LOGPROB *src, LOGPROB *self_a, LOGPROB *next_a, int len)
+{
+  int i;
+  LOGPROB s, n;
+
+  for(i=0;i<len;i++) {
+    s = src[i] + self_a[i];
+    n = src[i+1] + next_a[i];
+    dst[i] = (s > n) ? s : n;
+  }
+}
+
 /* 与えられた音素のならび phmmseq[0..phmmlen-1]に対してviterbi計算を行う. 
    g[0..framelen-1] のスコアを初期値として g_new[0..framelen-1]に更新値を代入. 
    最低 least_frame まではscanする. */
@@ -498,6 +584,7 @@ do_viterbi(LOGPROB *g, LOGPROB *g_new, HMM_Logical **phmmseq, boolean *has_sp, i
   A_CELL *ac;
   int t,i,j;
   boolean node_exist_p;
+  boolean lr_p;			/* TRUE if plain left-to-right word HMM */
   int tn;		       ///< Temporal pointer to current buffer
   int tl;		       ///< Temporal pointer to previous buffer
 
@@ -538,6 +625,10 @@ do_viterbi(LOGPROB *g, LOGPROB *g_new, HMM_Logical **phmmseq, boolean *has_sp, i
     j_internal_error("do_viterbi: word too long (>%d)\n", winfo->maxwn + 10);
   }
 
+  /* 単純な left-to-right 単語HMMなら遷移確率を配列に展開しておく */
+  /* flatten transitions if the word HMM is a plain left-to-right one */
+  lr_p = (! hmminfo->multipath && wordtrellis_lr_flatten(whmm, dwrk->lr_self_a, dwrk->lr_next_a));
+
   /* scan開始点を検索 -> starttへ*/
   /* search for the start frame -> set to startt */
   for(t = framelen-1; t >=0 ; t--) {
@@ -673,69 +764,114 @@ do_viterbi(LOGPROB *g, LOGPROB *g_new, HMM_Logical **phmmseq, boolean *has_sp, i
 
     }
 
-    /* node[wordhmmnum-2..0]についてトレリスを展開 */
-    /* expand trellis for node [t][wordhmmnum-2..0] */
-    for(i=wordhmmnum-2;i>=0;i--) {
-      
-      /* 最尤パスと最尤スコア tmpmax を見つける */
-      /* find most likely path and the max score 'tmpmax' */
-      tmpmax = LOG_ZERO;
-      for (ac=whmm->state[i].ac;ac;ac=ac->next) {
-	if (hmminfo->multipath) {
-	  if (ac->arc == wordhmmnum-1) tmpscore = g[t];
-	  else if (t + 1 > startt) tmpscore = LOG_ZERO;
-	  else tmpscore = dwrk->wordtrellis[tl][ac->arc];
-	  tmpscore += ac->a;
+    if (lr_p) {
+
+      /* 単純な left-to-right 単語HMM: 全状態の遷移をまとめて計算し，
+	 枝刈りと出力確率の加算のみ状態ごとに行う */
+      /* plain left-to-right word HMM: compute transitions of all states
+	 at once, then prune and add output probabilities per state */
+      wordtrellis_lr_maxplus(dwrk->wordtrellis[tn], dwrk->wordtrellis[tl], dwrk->lr_self_a, dwrk->lr_next_a, wordhmmnum - 1);
+      for(i=wordhmmnum-2;i>=0;i--) {
+	tmpmax = dwrk->wordtrellis[tn][i];
+
+	/* スコアエンベロープチェック: 一定幅外なら落とす */
+	/* check if score of this node is within the score envelope */
+	if (
+#ifdef SCAN_BEAM
+	    tmpmax <= framemaxscore[t] - scan_beam_thres ||
+#endif
+	    tmpmax <= LOG_ZERO
+	    ) {
+	  /* invalid node */
+	  dwrk->wordtrellis[tn][i] = LOG_ZERO;
+#ifdef GRAPHOUT_PRECISE_BOUNDARY
+	  if (r->graphout) {
+	    dwrk->wend_token_frame[tn][i] = -1;
+	    dwrk->wend_token_gscore[tn][i] = LOG_ZERO;
+	  }
+#endif
 	} else {
-	  tmpscore = dwrk->wordtrellis[tl][ac->arc] + ac->a;
-	}
-	if (tmpmax < tmpscore) {
-	  tmpmax = tmpscore;
-	  j = ac->arc;
+	  /* survived node */
+	  node_exist_p = TRUE;
+	  dwrk->wordtrellis[tn][i] = tmpmax + outprob(&(r->am->hmmwrk), t, &(whmm->state[i]), param);
+#ifdef GRAPHOUT_PRECISE_BOUNDARY
+	  if (r->graphout) {
+	    /* the arc to the next state wins ties */
+	    j = (dwrk->wordtrellis[tl][i] + dwrk->lr_self_a[i] > dwrk->wordtrellis[tl][i+1] + dwrk->lr_next_a[i]) ? i : i + 1;
+	    dwrk->wend_token_frame[tn][i] = dwrk->wend_token_frame[tl][j];
+	    dwrk->wend_token_gscore[tn][i] = dwrk->wend_token_gscore[tl][j];
+	  }
+#endif
 	}
       }
+
+    } else {
+
+      /* node[wordhmmnum-2..0]についてトレリスを展開 */
+      /* expand trellis for node [t][wordhmmnum-2..0] */
+      for(i=wordhmmnum-2;i>=0;i--) {
       
-      /* スコアエンベロープチェック: 一定幅外なら落とす */
-      /* check if score of this node is within the score envelope */
-      if (
+	/* 最尤パスと最尤スコア tmpmax を見つける */
+	/* find most likely path and the max score 'tmpmax' */
+	tmpmax = LOG_ZERO;
+	for (ac=whmm->state[i].ac;ac;ac=ac->next) {
+	  if (hmminfo->multipath) {
+	    if (ac->arc == wordhmmnum-1) tmpscore = g[t];
+	    else if (t + 1 > startt) tmpscore = LOG_ZERO;
+	    else tmpscore = dwrk->wordtrellis[tl][ac->arc];
+	    tmpscore += ac->a;
+	  } else {
+	    tmpscore = dwrk->wordtrellis[tl][ac->arc] + ac->a;
+	  }
+	  if (tmpmax < tmpscore) {
+	    tmpmax = tmpscore;
+	    j = ac->arc;
+	  }
+	}
+      
+	/* スコアエンベロープチェック: 一定幅外なら落とす */
+	/* check if score of this node is within the score envelope */
+	if (
 #ifdef SCAN_BEAM
-	  tmpmax <= framemaxscore[t] - scan_beam_thres ||
+	    tmpmax <= framemaxscore[t] - scan_beam_thres ||
 #endif
-	  tmpmax <= LOG_ZERO
-	  ) {
-	/* invalid node */
-	dwrk->wordtrellis[tn][i] = LOG_ZERO;
+	    tmpmax <= LOG_ZERO
+	    ) {
+	  /* invalid node */
+	  dwrk->wordtrellis[tn][i] = LOG_ZERO;
 #ifdef GRAPHOUT_PRECISE_BOUNDARY
-	if (r->graphout) {
-	  dwrk->wend_token_frame[tn][i] = -1;
-	  dwrk->wend_token_gscore[tn][i] = LOG_ZERO;
-	}
+	  if (r->graphout) {
+	    dwrk->wend_token_frame[tn][i] = -1;
+	    dwrk->wend_token_gscore[tn][i] = LOG_ZERO;
+	  }
 #endif
-      } else {
-	/* survived node */
-	node_exist_p = TRUE;
- 	dwrk->wordtrellis[tn][i] = tmpmax;
-	if (! hmminfo->multipath || i > 0) {
-	  dwrk->wordtrellis[tn][i] += outprob(&(r->am->hmmwrk), t, &(whmm->state[i]), param);
-	}
+	} else {
+	  /* survived node */
+	  node_exist_p = TRUE;
+	  dwrk->wordtrellis[tn][i] = tmpmax;
+	  if (! hmminfo->multipath || i > 0) {
+	    dwrk->wordtrellis[tn][i] += outprob(&(r->am->hmmwrk), t, &(whmm->state[i]), param);
+	  }
 #ifdef GRAPHOUT_PRECISE_BOUNDARY
-	if (r->graphout) {
-	  if (hmminfo->multipath) {
-	    if (j == wordhmmnum-1) {
-	      dwrk->wend_token_frame[tn][i] = wordend_frame_src[t];
-	      dwrk->wend_token_gscore[tn][i] = wordend_gscore_src[t];
+	  if (r->graphout) {
+	    if (hmminfo->multipath) {
+	      if (j == wordhmmnum-1) {
+		dwrk->wend_token_frame[tn][i] = wordend_frame_src[t];
+		dwrk->wend_token_gscore[tn][i] = wordend_gscore_src[t];
+	      } else {
+		dwrk->wend_token_frame[tn][i] = dwrk->wend_token_frame[tl][j];
+		dwrk->wend_token_gscore[tn][i] = dwrk->wend_token_gscore[tl][j];
+	      }
 	    } else {
 	      dwrk->wend_token_frame[tn][i] = dwrk->wend_token_frame[tl][j];
 	      dwrk->wend_token_gscore[tn][i] = dwrk->wend_token_gscore[tl][j];
 	    }
-	  } else {
-	    dwrk->wend_token_frame[tn][i] = dwrk->wend_token_frame[tl][j];
-	    dwrk->wend_token_gscore[tn][i] = dwrk->wend_token_gscore[tl][j];
 	  }
-	}
 #endif
-      }
-    } /* end of node loop */
+	}
+      } /* end of node loop */
+
+    }
 
     /* 時間 t のViterbi計算終了. 新たな前向きスコア g_new[t] をセット */
     /* Viterbi end for frame [t].  set the new forward score g_new[t] */
@@ -965,7 +1101,7 @@ scan_word(NODE *now, HTK_Param *param, RecogProcess *r)
     
     /* the tail triphone of the last word varies by context */
     if (now->last_ph != NULL) {
-      tailph = get_right_context_HMM(winfo->wseq[word][winfo->wlen[word]-1], now->last_ph->name, hmminfo);
+      tailph = get_right_context_logical(winfo->wseq[word][winfo->wlen[word]-1], now->last_ph, hmminfo);
       if (tailph == NULL) {
 	/* fallback to the original bi/mono-phone */
 	/* error if the original is pseudo phone (not explicitly defined
@@ -1151,7 +1287,7 @@ next_word(NODE *now, NODE *new, NEXTWORD *nword, HTK_Param *param, RecogProcess
   if (ccd_flag) {
     /* 最終音素 triphone を接続単語に会わせて変化 */
     /* modify triphone of last phone according to the next word */
-    lastphone = get_left_context_HMM(now->last_ph, winfo->wseq[word][winfo->wlen[word]-1]->name, hmminfo);
+    lastphone = get_left_context_logical(now->last_ph, winfo->wseq[word][winfo->wlen[word]-1], hmminfo);
     if (lastphone == NULL) {
       /* fallback to the original bi/mono-phone */
       /* error if the original is pseudo phone (not explicitly defined
@@ -1167,7 +1303,7 @@ next_word(NODE *now, NODE *new, NEXTWORD *nword, HTK_Param *param, RecogProcess
   /* newphone (接続単語の末尾音素) を準備 */
   /* prepare newphone (tail phone of next word) */
   if (ccd_flag) {
-    newphone = get_right_context_HMM(winfo->wseq[word][winfo->wlen[word]-1], now->last_ph->name, hmminfo);
+    newphone = get_right_context_logical(winfo->wseq[word][winfo->wlen[word]-1], now->last_ph, hmminfo);
     if (newphone == NULL) {
       /* fallback to the original bi/mono-phone */
       /* error if the original is pseudo phone (not explicitly defined
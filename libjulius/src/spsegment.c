@@ -268,6 +268,7 @@ detect_end_of_segment(RecogProcess *r, int time)
   LOGPROB maxscore = LOG_ZERO;
   TRELLIS_ATOM *tremax = NULL;
   int count = 0;
+  int n;
   boolean detected = FALSE;
 #ifdef SPSEGMENT_NAIST
   MFCCCalc *mfcc;
@@ -375,7 +376,9 @@ detect_end_of_segment(RecogProcess *r, int time)
 #endif /* SPSEGMENT_NAIST */
 
   /* look for the best trellis word on the given time frame */
-  for(tre = r->backtrellis->list; tre != NULL && tre->endtime == time; tre = tre->next) {
+  for(n = r->backtrellis->atomnum - 1; n >= 0; n--) {
+    tre = BT_ATOM(r->backtrellis, n);
+    if (tre->endtime != time) break;
     if (maxscore < tre->backscore) {
       maxscore = tre->backscore;
       tremax = tre;
@@ -611,7 +614,8 @@ detect_end_of_segment(RecogProcess *r, int time)
  * そのセグメントの第１パスの終了処理を行う. 具体的には，
  * 続く第２パスのための始終端単語のセット，および
  * 次回デコーディングを再開するときのために，入力ベクトル列の未処理部分の
- * コピーを rest_param に残す. 
+ * コピーを rest_param に残す. 重複部分の状態出力確率のキャッシュも
+ * 次回のために保持する. 
  * 
  * @param recog [in] エンジンインスタンス
  * </JA>
@@ -623,7 +627,8 @@ detect_end_of_segment(RecogProcess *r, int time)
  * of the last segment.  The beginning and ending words for the 2nd pass
  * will be set according to the 1st pass result.  Then the current
  * input will be shrinked to the segmented length and the unprocessed
- * region are copied to rest_param for the next decoding.
+ * region are copied to rest_param for the next decoding.  The cached
+ * state outprobs of the overlapped region are also kept for it.
  * 
  * @param recog [in] engine instance
  * </EN>
@@ -636,6 +641,7 @@ finalize_segment(Recog *recog)
   int spstart;
   RecogProcess *r;
   MFCCCalc *mfcc;
+  PROCESS_AM *am;
   boolean ok_p;
 
   /* トレリス始終端における最尤単語を第2パスの始終端単語として格納 */
@@ -675,6 +681,12 @@ finalize_segment(Recog *recog)
     /* for each mfcc */
     if (verbose_flag) jlog("STAT: segmented: next decoding will restart from %d\n", spstart);
 
+    /* the overlapped frames will be decoded again from the same vectors,
+       so keep their state outprobs for the next decoding */
+    for (am = recog->amlist; am; am = am->next) {
+      outprob_cache_keep(&(am->hmmwrk), spstart, am->mfcc->last_time - spstart);
+    }
+
     for (mfcc = recog->mfcclist; mfcc; mfcc = mfcc->next) {
       if (verbose_flag) jlog("STAT: MFCC%02d: segmented: processed length=%d\n", mfcc->id, mfcc->last_time);
 
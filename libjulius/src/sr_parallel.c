@@ -0,0 +1,326 @@
+/**
+ * @file   sr_parallel.c
+ *
+ * <JA>
+ * @brief  複数の認識処理インスタンスの並列実行
+ *
+ * 同一入力に対する複数の認識処理インスタンス（-SR）の処理を，
+ * ワーカースレッドで並列に実行する. 同じ音響モデルを用いる
+ * インスタンスは出力確率キャッシュを共有するため，同一スレッド上で
+ * 順に処理される. 呼び出し側は全インスタンスの処理が終わるまで待つので，
+ * コールバックの呼び出し順は逐次実行と同じになる.
+ * </JA>
+ *
+ * <EN>
+ * @brief  Parallel execution of multiple recognition process instances
+ *
+ * The processing of recognition process instances (-SR) on the same
+ * input is executed in parallel on worker threads.  Instances that use
+ * the same acoustic model share its output probability cache, so they
+ * are processed in turn on the same thread.  The caller waits until all
+ * the instances finish, so the callbacks are called in the same order
+ * as sequential execution.
+ * </EN>
+ *
+ * @author Akinobu Lee
+ * @date   Mon Oct 19 14:20:41 2026
+ *
+ * $Revision: 1.1 $
+ *
+ */
+/*
+ * Copyright (c) 1991-2013 Kawahara Lab., Kyoto University
+ * Copyright (c) 2000-2005 Shikano Lab., Nara Institute of Science and Technology
+ * Copyright (c) 2005-2013 Julius project team, Nagoya Institute of Technology
+ * All rights reserved
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE		/* for pthread_setaffinity_np() */
+#endif
+#include <julius/julius.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#if defined(__linux__)
+#include <sched.h>
+#define HAVE_CPU_AFFINITY
+#endif
+#endif
+
+/**
+ * Run a function for all the live processes that use the AM of a job,
+ * in the order of the process list.
+ *
+ * @param pool [in] thread pool
+ * @param am [in] AM of the job
+ */
+static void
+sr_pool_run_job(SRPool *pool, PROCESS_AM *am)
+{
+  RecogProcess *p;
+
+  for(p = pool->recog->process_list; p; p = p->next) {
+    if (!p->live) continue;
+    if (p->am != am) continue;
+    (*(pool->func))(p, pool->data);
+  }
+}
+
+#ifdef HAVE_PTHREAD
+
+/**
+ * Take and run jobs of the current job set until no job is left.
+ *
+ * @param pool [i/o] thread pool
+ */
+static void
+sr_pool_take_jobs(SRPool *pool)
+{
+  int i;
+
+  pthread_mutex_lock(&(pool->mutex));
+  while (pool->next < pool->jobnum) {
+    i = pool->next++;
+    pthread_mutex_unlock(&(pool->mutex));
+    sr_pool_run_job(pool, pool->am[i]);
+    pthread_mutex_lock(&(pool->mutex));
+    pool->done++;
+    if (pool->done == pool->jobnum) pthread_cond_broadcast(&(pool->cond_done));
+  }
+  pthread_mutex_unlock(&(pool->mutex));
+}
+
+/**
+ * Main function of a worker thread.
+ *
+ * @param arg [in] thread pool
+ *
+ * @return NULL.
+ */
+static void *
+sr_pool_worker(void *arg)
+{
+  SRPool *pool = (SRPool *)arg;
+  unsigned long gen = 0;
+
+  while(1) {
+    pthread_mutex_lock(&(pool->mutex));
+    while (!pool->quit && pool->gen == gen) {
+      pthread_cond_wait(&(pool->cond_start), &(pool->mutex));
+    }
+    if (pool->quit) {
+      pthread_mutex_unlock(&(pool->mutex));
+      break;
+    }
+    gen = pool->gen;
+    pthread_mutex_unlock(&(pool->mutex));
+    sr_pool_take_jobs(pool);
+  }
+  return NULL;
+}
+
+/**
+ * Bind a thread to the n-th CPU in a comma-separated CPU list.
+ * The list is used cyclically.
+ *
+ * @param th [in] thread
+ * @param list [in] comma-separated list of CPU numbers
+ * @param n [in] index of the thread
+ */
+static void
+sr_pool_bind(pthread_t th, char *list, int n)
+{
+#ifdef HAVE_CPU_AFFINITY
+  int num, cpu;
+  char *p;
+  cpu_set_t set;
+
+  num = 1;
+  for(p = list; *p != '\0'; p++) if (*p == ',') num++;
+  n %= num;
+  for(p = list; n > 0; p++) if (*p == ',') n--;
+  cpu = atoi(p);
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (pthread_setaffinity_np(th, sizeof(cpu_set_t), &set) != 0) {
+    jlog("WARNING: sr_parallel: failed to bind thread to CPU %d\n", cpu);
+  }
+#else
+  if (n == 0) jlog("WARNING: sr_parallel: CPU affinity not supported, \"-cpuaffinity\" ignored\n");
+#endif
+}
+
+#endif /* HAVE_PTHREAD */
+
+/**
+ * Create a thread pool for an engine instance.
+ *
+ * @param recog [in] engine instance
+ *
+ * @return the new thread pool.
+ */
+static SRPool *
+sr_pool_new(Recog *recog)
+{
+  SRPool *pool;
+#ifdef HAVE_PTHREAD
+  int i;
+  char *list;
+#endif
+
+  pool = (SRPool *)mymalloc(sizeof(SRPool));
+  memset(pool, 0, sizeof(SRPool));
+  pool->recog = recog;
+  pool->num = recog->jconf->decodeopt.sr_threads;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_init(&(pool->mutex), NULL);
+  pthread_cond_init(&(pool->cond_start), NULL);
+  pthread_cond_init(&(pool->cond_done), NULL);
+  list = recog->jconf->decodeopt.cpu_affinity;
+  if (list) sr_pool_bind(pthread_self(), list, 0);
+  pool->threads = (pthread_t *)mymalloc(sizeof(pthread_t) * pool->num);
+  for(i = 0; i < pool->num - 1; i++) {
+    if (pthread_create(&(pool->threads[i]), NULL, sr_pool_worker, pool) != 0) {
+      jlog("WARNING: sr_parallel: failed to create thread, run with %d threads\n", i + 1);
+      pool->num = i + 1;
+      break;
+    }
+    if (list) sr_pool_bind(pool->threads[i], list, i + 1);
+  }
+  jlog("STAT: sr_parallel: recognition processes run by %d threads\n", pool->num);
+#else
+  jlog("WARNING: sr_parallel: no thread support, \"-srthreads\" ignored\n");
+  pool->num = 1;
+#endif
+
+  return pool;
+}
+
+/**
+ * <JA>
+ * 全ての有効な認識処理インスタンスに対して関数を実行する.
+ * -srthreads が2以上の場合，音響モデルごとにワーカースレッドで並列に
+ * 実行する. 全ての実行が終わるまで戻らない.
+ *
+ * @param recog [in] エンジンインスタンス
+ * @param func [in] 各インスタンスに対して実行する関数
+ * @param data [in] @a func に渡すデータ
+ * </JA>
+ * <EN>
+ * Execute a function for all live recognition process instances.  When
+ * -srthreads is more than 1, they are executed in parallel per AM on
+ * worker threads.  Returns after all of them have finished.
+ *
+ * @param recog [in] engine instance
+ * @param func [in] function to be executed for each instance
+ * @param data [in] data to be passed to @a func
+ * </EN>
+ *
+ * @callgraph
+ * @callergraph
+ */
+void
+sr_parallel_exec(Recog *recog, void (*func)(RecogProcess *, void *), void *data)
+{
+  SRPool *pool;
+  PROCESS_AM *am;
+  RecogProcess *p;
+  int n;
+
+  if (recog->jconf->decodeopt.sr_threads > 1 && recog->srpool == NULL) {
+    recog->srpool = sr_pool_new(recog);
+  }
+  pool = recog->srpool;
+
+  /* list AMs used by live processes as jobs */
+  n = 0;
+  if (pool != NULL && pool->num > 1) {
+    for(am = recog->amlist; am; am = am->next) {
+      for(p = recog->process_list; p; p = p->next) {
+	if (p->live && p->am == am) break;
+      }
+      if (p == NULL) continue;
+      if (n >= pool->jobmax) {
+	pool->jobmax += 4;
+	pool->am = (PROCESS_AM **)myrealloc(pool->am, sizeof(PROCESS_AM *) * pool->jobmax);
+      }
+      pool->am[n++] = am;
+    }
+  }
+
+  if (n <= 1) {
+    /* sequential */
+    for(p = recog->process_list; p; p = p->next) {
+      if (!p->live) continue;
+      (*func)(p, data);
+    }
+    return;
+  }
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&(pool->mutex));
+  pool->func = func;
+  pool->data = data;
+  pool->jobnum = n;
+  pool->next = 0;
+  pool->done = 0;
+  pool->gen++;
+  pthread_cond_broadcast(&(pool->cond_start));
+  pthread_mutex_unlock(&(pool->mutex));
+
+  /* the caller also works */
+  sr_pool_take_jobs(pool);
+
+  /* wait for all jobs */
+  pthread_mutex_lock(&(pool->mutex));
+  while (pool->done < pool->jobnum) {
+    pthread_cond_wait(&(pool->cond_done), &(pool->mutex));
+  }
+  pthread_mutex_unlock(&(pool->mutex));
+#endif
+}
+
+/**
+ * <JA>
+ * 認識処理インスタンス並列実行用のスレッドを終了し，解放する.
+ *
+ * @param recog [in] エンジンインスタンス
+ * </JA>
+ * <EN>
+ * Terminate and free the threads for parallel execution of
+ * recognition process instances.
+ *
+ * @param recog [in] engine instance
+ * </EN>
+ *
+ * @callgraph
+ * @callergraph
+ */
+void
+sr_parallel_free(Recog *recog)
+{
+  SRPool *pool;
+#ifdef HAVE_PTHREAD
+  int i;
+#endif
+
+  if ((pool = recog->srpool) == NULL) return;
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&(pool->mutex));
+  pool->quit = TRUE;
+  pthread_cond_broadcast(&(pool->cond_start));
+  pthread_mutex_unlock(&(pool->mutex));
+  for(i = 0; i < pool->num - 1; i++) pthread_join(pool->threads[i], NULL);
+  pthread_cond_destroy(&(pool->cond_done));
+  pthread_cond_destroy(&(pool->cond_start));
+  pthread_mutex_destroy(&(pool->mutex));
+  free(pool->threads);
+#endif
+  if (pool->am) free(pool->am);
+  free(pool);
+  recog->srpool = NULL;
+}
+
+/* end of file */
@@ -77,10 +77,12 @@ wchmm_new()
   w->dfa = NULL;
   w->dfa_forward = NULL;
   w->winfo = NULL;
+  w->gram_version = 0;
   w->malloc_root = NULL;
 #ifdef PASS1_IWCD
   w->lcdset_category_root = NULL;
   w->lcdset_mroot = NULL;
+  ctxtable_init(&(w->lcdset_category_index));
 #endif /* PASS1_IWCD */
   w->wrk.out_from_len = 0;
   /* reset user function entry point */
@@ -1067,7 +1069,7 @@ wchmm_add_word(WCHMM_INFO *wchmm, int word, int matchlen, int matchword, boolean
 	  if (wchmm->winfo->wlen[word] > 1 && j == wchmm->winfo->wlen[word] - 1) {
 	    if (wchmm->category_tree) {
 #ifdef USE_OLD_IWCD
-	      lcd = lcdset_lookup_by_hmmname(wchmm->hmminfo, ltmp->name);
+	      lcd = lcdset_lookup_by_logical(wchmm->hmminfo, ltmp, NULL);
 #else
 	      lcd = lcdset_lookup_with_category(wchmm, ltmp, wchmm->winfo->wton[word]);
 	      if (lcd == NULL) {
@@ -1075,11 +1077,11 @@ wchmm_add_word(WCHMM_INFO *wchmm, int word, int matchlen, int matchword, boolean
 		   can follow this word grammatically.
 		   so fallback to normal state */
 		jlog("WARNING: wchmm: no lcdset found for [%s::%04d], fallback to [%s]\n", ltmp->name, wchmm->winfo->wton[word], ltmp->name);
-		lcd = lcdset_lookup_by_hmmname(wchmm->hmminfo, ltmp->name);
+		lcd = lcdset_lookup_by_logical(wchmm->hmminfo, ltmp, NULL);
 	      }
 #endif
 	    } else {
-	      lcd = lcdset_lookup_by_hmmname(wchmm->hmminfo, ltmp->name);
+	      lcd = lcdset_lookup_by_logical(wchmm->hmminfo, ltmp, NULL);
 	    }
 	    if (lcd == NULL) {
 	      jlog("ERROR: wchmm: at word #%d: no lcdset found for [%s]\n", word, ltmp->name);
@@ -2063,6 +2065,532 @@ build_wchmm2(WCHMM_INFO *wchmm, JCONF_LM *lmconf)
 
 }
 
+/**************************************************************/
+/************ incremental update on grammar change ************/
+/**************************************************************/
+
+/** 
+ * <JA>
+ * 文法変更に伴い，木構造化辞書上の単語ID・カテゴリIDを付け替え，
+ * 削除された単語のノードを取り除く. 
+ * 
+ * @param wchmm [i/o] 木構造化辞書
+ * @param new_wnum [in] 新しい語彙数
+ * @param wmap [in] 旧単語IDから新単語IDへの対応
+ * @param old_wnum [in] @a wmap の長さ
+ * @param cmap [in] 旧カテゴリIDから新カテゴリIDへの対応
+ * @param remove_flag [in] 削除された単語がある場合 TRUE
+ * </JA>
+ * <EN>
+ * Renumber word IDs and category IDs on the tree lexicon after
+ * grammar change, and remove nodes that belong only to deleted words.
+ * The arrays are compacted in the node order, so the relative order
+ * of the remaining nodes are kept.  The areas of removed nodes allocated
+ * by mybmalloc2() are kept until the tree is freed.
+ * 
+ * @param wchmm [i/o] tree lexicon
+ * @param new_wnum [in] new vocabulary size
+ * @param wmap [in] mapping from old word ID to new word ID
+ * @param old_wnum [in] length of @a wmap
+ * @param cmap [in] mapping from old category ID to new category ID
+ * @param remove_flag [in] TRUE if some words are deleted
+ * </EN>
+ */
+static void
+wchmm_update_remap(WCHMM_INFO *wchmm, int new_wnum, WORD_ID *wmap, int old_wnum, WORD_ID *cmap, boolean remove_flag)
+{
+  int **offset;
+  int *wordend, *wordbegin;
+  LOGPROB *wordend_a;
+  int *newid, *stack;
+  int n, m, i, j, sp, k;
+  WORD_ID w, nw;
+  A_CELL2 *ac;
+
+  /* mark nodes reachable from the start nodes of remaining words */
+  newid = (int *)mymalloc(sizeof(int) * (wchmm->n > 0 ? wchmm->n : 1));
+  if (remove_flag) {
+    stack = (int *)mymalloc(sizeof(int) * (wchmm->n > 0 ? wchmm->n : 1));
+    for(n=0;n<wchmm->n;n++) newid[n] = -1;
+    sp = 0;
+    for(i=0;i<wchmm->startnum;i++) {
+      if (wmap[wchmm->start2wid[i]] == WORD_INVALID) continue;
+      n = wchmm->startnode[i];
+      if (newid[n] == -1) {
+	newid[n] = 0;
+	stack[sp++] = n;
+      }
+    }
+    while(sp > 0) {
+      n = stack[--sp];
+      if (n + 1 < wchmm->n && wchmm->next_a[n] != LOG_ZERO && newid[n+1] == -1) {
+	newid[n+1] = 0;
+	stack[sp++] = n + 1;
+      }
+      for(ac=wchmm->ac[n];ac;ac=ac->next) {
+	for(j=0;j<ac->n;j++) {
+	  if (newid[ac->arc[j]] == -1) {
+	    newid[ac->arc[j]] = 0;
+	    stack[sp++] = ac->arc[j];
+	  }
+	}
+      }
+    }
+    free(stack);
+  } else {
+    for(n=0;n<wchmm->n;n++) newid[n] = 0;
+  }
+
+  /* compact node arrays */
+  m = 0;
+  for(n=0;n<wchmm->n;n++) {
+    if (newid[n] == -1) continue;
+    newid[n] = m;
+    if (m != n) {
+      wchmm->state[m] = wchmm->state[n];
+      wchmm->self_a[m] = wchmm->self_a[n];
+      wchmm->next_a[m] = wchmm->next_a[n];
+      wchmm->ac[m] = wchmm->ac[n];
+      wchmm->stend[m] = wchmm->stend[n];
+#ifdef PASS1_IWCD
+      wchmm->outstyle[m] = wchmm->outstyle[n];
+#endif
+    }
+    if (wchmm->stend[m] != WORD_INVALID) {
+      wchmm->stend[m] = wmap[wchmm->stend[m]];
+    }
+#ifdef PASS1_IWCD
+    if (wchmm->ccd_flag && wchmm->state[m].out.state != NULL && wchmm->outstyle[m] == AS_LRSET) {
+      (wchmm->state[m].out.lrset)->category = cmap[(wchmm->state[m].out.lrset)->category];
+    }
+#endif
+    m++;
+  }
+  for(n=0;n<m;n++) {
+    for(ac=wchmm->ac[n];ac;ac=ac->next) {
+      for(j=0;j<ac->n;j++) ac->arc[j] = newid[ac->arc[j]];
+    }
+  }
+  wchmm->n = m;
+
+  /* start nodes */
+  k = 0;
+  for(i=0;i<wchmm->startnum;i++) {
+    nw = wmap[wchmm->start2wid[i]];
+    if (nw == WORD_INVALID) continue;
+    wchmm->startnode[k] = newid[wchmm->startnode[i]];
+    wchmm->start2wid[k] = nw;
+    k++;
+  }
+  wchmm->startnum = k;
+
+  /* word-indexed arrays */
+  offset = (int **)mymalloc(sizeof(int *) * new_wnum);
+  wordend = (int *)mymalloc(sizeof(int) * new_wnum);
+  wordbegin = NULL;
+  wordend_a = NULL;
+  if (wchmm->hmminfo->multipath) {
+    wordbegin = (int *)mymalloc(sizeof(int) * new_wnum);
+  } else {
+    wordend_a = (LOGPROB *)mymalloc(sizeof(LOGPROB) * new_wnum);
+  }
+  for(w=0;w<new_wnum;w++) offset[w] = NULL;
+  for(w=0;w<old_wnum;w++) {
+    nw = wmap[w];
+    if (nw == WORD_INVALID) continue;
+    offset[nw] = wchmm->offset[w];
+    for(i=0;i<wchmm->winfo->wlen[nw];i++) {
+      offset[nw][i] = newid[offset[nw][i]];
+    }
+    wordend[nw] = newid[wchmm->wordend[w]];
+    if (wchmm->hmminfo->multipath) {
+      wordbegin[nw] = newid[wchmm->wordbegin[w]];
+    } else {
+      wordend_a[nw] = wchmm->wordend_a[w];
+    }
+  }
+  free(wchmm->offset);
+  free(wchmm->wordend);
+  wchmm->offset = offset;
+  wchmm->wordend = wordend;
+  if (wchmm->hmminfo->multipath) {
+    free(wchmm->wordbegin);
+    wchmm->wordbegin = wordbegin;
+  } else {
+    free(wchmm->wordend_a);
+    wchmm->wordend_a = wordend_a;
+  }
+
+  free(newid);
+}
+
+#ifdef PASS1_IWCD
+/** 
+ * <JA>
+ * 単語末尾音素の状態に割り付けられた単語末用カテゴリ付き pseudo phone set
+ * へのポインタを，現在の登録内容に再設定する. 
+ * 
+ * @param wchmm [i/o] 木構造化辞書
+ * @param w [in] 単語ID
+ * 
+ * @return 該当する set が見つからない場合 FALSE を返す. 
+ * </JA>
+ * <EN>
+ * Re-assign the category-indexed pseudo phone set on the word-end phone
+ * of a word on the tree lexicon, to follow re-registered or expanded sets.
+ * 
+ * @param wchmm [i/o] tree lexicon
+ * @param w [in] word ID
+ * 
+ * @return FALSE when no set was found.
+ * </EN>
+ */
+static boolean
+wchmm_update_relink_lset(WCHMM_INFO *wchmm, WORD_ID w)
+{
+  HMM_Logical *ltmp;
+  CD_Set *lcd;
+  int k, n, len;
+
+  len = wchmm->winfo->wlen[w];
+  if (len <= 1) return TRUE;
+  ltmp = wchmm->winfo->wseq[w][len-1];
+  lcd = lcdset_lookup_with_category(wchmm, ltmp, wchmm->winfo->wton[w]);
+  if (lcd == NULL) lcd = lcdset_lookup_by_logical(wchmm->hmminfo, ltmp, NULL);
+  if (lcd == NULL) return FALSE;
+  for(k = 1; k < hmm_logical_state_num(ltmp) - 1; k++) {
+    n = wchmm->offset[w][len-1] + k - 1;
+    if (! wchmm->hmminfo->multipath && k == hmm_logical_state_num(ltmp) - 2) {
+      /* the last state may be isolated for homophones */
+      n = wchmm->wordend[w];
+    }
+    if (wchmm->outstyle[n] == AS_LSET) {
+      wchmm->state[n].out.lset = &(lcd->stateset[k]);
+    }
+  }
+  return TRUE;
+}
+#endif /* PASS1_IWCD */
+
+/** 
+ * <JA>
+ * 新語彙中で，ある単語と最も長く先頭音素が一致する木構造化辞書上の
+ * 単語を探す. 
+ * 
+ * @param wchmm [in] 木構造化辞書
+ * @param windex [in] カテゴリ内で音素列順にソートされた単語リスト
+ * @param bgn [in] 対象単語のカテゴリの @a windex 上の開始位置
+ * @param k [in] 対象単語の @a windex 上の位置
+ * @param pred [in] @a k より前で木に含まれる最後の単語の位置, なければ -1
+ * @param succ [in] @a k より後ろで木に含まれる最初の単語の位置, なければ -1
+ * @param intree [in] 木に含まれる単語に TRUE
+ * @param matchword [out] 一致した単語
+ * 
+ * @return 一致音素数を返す. 
+ * </JA>
+ * <EN>
+ * Find the word on the tree lexicon that has the longest match with
+ * a word from the head phone.  Since @a windex is sorted by phone
+ * sequence, the longest match is one of the neighbors.  On tie, a
+ * word that continues beyond the matched part is preferred, since the
+ * last node of homophones may have been isolated by
+ * wchmm_duplicate_leafnode().  Among homophones, the one holding the
+ * original node (smallest ID) is chosen.
+ * 
+ * @param wchmm [in] tree lexicon
+ * @param windex [in] word list sorted by category and phone sequence
+ * @param bgn [in] location of the first word of the category in @a windex
+ * @param k [in] location of the target word in @a windex
+ * @param pred [in] last location before @a k whose word is on the tree, or -1
+ * @param succ [in] first location after @a k whose word is on the tree, or -1
+ * @param intree [in] TRUE for words on the tree
+ * @param matchword [out] the matched word
+ * 
+ * @return the number of matched phones.
+ * </EN>
+ */
+static int
+wchmm_update_find_match(WCHMM_INFO *wchmm, WORD_ID *windex, int bgn, int k, int pred, int succ, boolean *intree, int *matchword)
+{
+  WORD_INFO *winfo;
+  int l1, l2, len, i, w, mw;
+
+  winfo = wchmm->winfo;
+  w = windex[k];
+  l1 = (pred >= 0) ? wchmm_check_match(winfo, w, windex[pred]) : 0;
+  l2 = (succ >= 0) ? wchmm_check_match(winfo, w, windex[succ]) : 0;
+  len = (l1 > l2) ? l1 : l2;
+  *matchword = 0;
+  if (len == 0) return 0;
+
+  if (l2 == len && winfo->wlen[windex[succ]] > len) {
+    *matchword = windex[succ];
+  } else if (l1 == len && winfo->wlen[windex[pred]] > len) {
+    *matchword = windex[pred];
+  } else {
+    /* only words ending at the matched part: choose the original node */
+    mw = -1;
+    if (l2 == len) mw = windex[succ];
+    for(i=pred;i>=bgn;i--) {
+      if (! intree[windex[i]]) continue;
+      if (wchmm_check_match(winfo, w, windex[i]) < len) break;
+      if (mw == -1 || wchmm->offset[windex[i]][len-1] < wchmm->offset[mw][len-1]) {
+	mw = windex[i];
+      }
+    }
+    *matchword = mw;
+  }
+  return len;
+}
+
+/** 
+ * <JA>
+ * @brief  文法変更に合わせて木構造化辞書を差分更新する. 
+ *
+ * 文法の追加・削除・単語追加によってグローバル文法が変更されたとき，
+ * 木構造化辞書を一から作り直す代わりに，削除された単語のノードを
+ * 取り除き，単語・カテゴリIDを付け替えたのち，新たな単語のみを
+ * 木に挿入する. 単語の挿入位置は build_wchmm2() と同じく音素列の
+ * 最長一致で決めるため，得られる木は一から構築したものと同じ形になる. 
+ * 差分更新ができない場合は FALSE を返すので，呼び出し側は木構造化辞書を
+ * 一から再構築すること. 
+ * 
+ * @param wchmm [i/o] 木構造化辞書
+ * @param winfo [in] 新しいグローバル辞書
+ * @param dfa [in] 新しいグローバル文法
+ * @param dfa_forward [in] 新しいグローバル前向き文法
+ * @param wmap [in] 旧単語IDから新単語IDへの対応 (削除語は WORD_INVALID)
+ * @param old_wnum [in] @a wmap の長さ
+ * @param cmap [in] 旧カテゴリIDから新カテゴリIDへの対応 (削除は WORD_INVALID)
+ * @param old_cnum [in] @a cmap の長さ
+ * @param lmconf [in] 言語モデル設定
+ * 
+ * @return 更新できた場合 TRUE，一から構築する必要がある場合 FALSE. 
+ * </JA>
+ * <EN>
+ * @brief  Update the tree lexicon incrementally for the grammar change.
+ *
+ * When the global grammar is changed by adding or deleting grammars or
+ * by adding words, this function updates the current tree lexicon
+ * instead of building a new one from scratch: nodes of deleted words
+ * are removed, word and category IDs are renumbered, and only the
+ * new words are inserted.  Insertion point of each word is determined
+ * by the longest phone match as in build_wchmm2(), so the resulting
+ * tree has the same shape as the one built from scratch.
+ * 
+ * When FALSE is returned, the tree lexicon is not usable and the
+ * caller should re-build it from scratch.  This happens when a new
+ * word should be embedded in an existing word on multi-path mode with
+ * inter-word short pause, where the short pause of the new word can not
+ * be inserted into the current tree.
+ * 
+ * @param wchmm [i/o] tree lexicon
+ * @param winfo [in] new global dictionary
+ * @param dfa [in] new global grammar
+ * @param dfa_forward [in] new global forward grammar
+ * @param wmap [in] mapping from old word ID to new one (WORD_INVALID if deleted)
+ * @param old_wnum [in] length of @a wmap
+ * @param cmap [in] mapping from old category ID to new one (WORD_INVALID if deleted)
+ * @param old_cnum [in] length of @a cmap
+ * @param lmconf [in] LM configuration
+ * 
+ * @return TRUE on success, or FALSE if the tree should be built from scratch.
+ * </EN>
+ * @callgraph
+ * @callergraph
+ */
+boolean
+wchmm_update(WCHMM_INFO *wchmm, WORD_INFO *winfo, DFA_INFO *dfa, DFA_INFO *dfa_forward, WORD_ID *wmap, int old_wnum, WORD_ID *cmap, int old_cnum, JCONF_LM *lmconf)
+{
+  boolean *intree, *catemark;
+  WORD_ID *windex, *newword;
+  int *succ;
+  int num, newnum, i, k, pred, len, bgn, c;
+  int mw;
+  WORD_ID w;
+  boolean remove_flag, cate_flag;
+  boolean ok_p;
+  int num_duplicated;
+#ifdef PASS1_IWCD
+  APATNODE *old_root;
+  BMALLOC_BASE *old_mroot;
+#endif
+
+  if (! wchmm->category_tree || wchmm->lmtype != LM_DFA || wchmm->lmvar != LM_DFA_GRAMMAR) return FALSE;
+  if (winfo == NULL || dfa == NULL || winfo->num == 0) return FALSE;
+
+  /* classify words */
+  intree = (boolean *)mymalloc(sizeof(boolean) * winfo->num);
+  for(w=0;w<winfo->num;w++) intree[w] = FALSE;
+  remove_flag = cate_flag = FALSE;
+  for(w=0;w<old_wnum;w++) {
+    if (wmap[w] == WORD_INVALID) {
+      remove_flag = TRUE;
+    } else {
+      intree[wmap[w]] = TRUE;
+    }
+  }
+  for(c=0;c<old_cnum;c++) {
+    if (cmap[c] != c) cate_flag = TRUE;
+  }
+  newword = (WORD_ID *)mymalloc(sizeof(WORD_ID) * winfo->num);
+  newnum = 0;
+  for(w=0;w<winfo->num;w++) {
+    if (! intree[w]) newword[newnum++] = w;
+  }
+
+  /* list up all words in categories that have new words, sorted by
+     category and phone sequence as in build_wchmm2() */
+  catemark = (boolean *)mymalloc(sizeof(boolean) * dfa->term_num);
+  for(c=0;c<dfa->term_num;c++) catemark[c] = FALSE;
+  for(i=0;i<newnum;i++) catemark[winfo->wton[newword[i]]] = TRUE;
+  num = 0;
+  for(c=0;c<dfa->term_num;c++) {
+    if (catemark[c]) num += dfa->term.wnum[c];
+  }
+  windex = (WORD_ID *)mymalloc(sizeof(WORD_ID) * (num > 0 ? num : 1));
+  succ = (int *)mymalloc(sizeof(int) * (num > 0 ? num : 1));
+  num = 0;
+  for(c=0;c<dfa->term_num;c++) {
+    if (! catemark[c]) continue;
+    bgn = num;
+    for(i=0;i<dfa->term.wnum[c];i++) windex[num++] = dfa->term.tw[c][i];
+    wchmm_sort_idx_by_wseq(winfo, windex, bgn, num - bgn);
+    /* location of next word already on tree */
+    k = -1;
+    for(i=num-1;i>=bgn;i--) {
+      succ[i] = k;
+      if (intree[windex[i]]) k = i;
+    }
+  }
+  free(catemark);
+
+  /* check if all the new words can be inserted */
+  if (wchmm->hmminfo->multipath && lmconf->enable_iwsp) {
+    ok_p = TRUE;
+    pred = -1;
+    for(i=0;i<num;i++) {
+      w = windex[i];
+      if (i > 0 && winfo->wton[windex[i-1]] != winfo->wton[w]) pred = -1;
+      if (! intree[w]) {
+	len = (pred >= 0) ? wchmm_check_match(winfo, w, windex[pred]) : 0;
+	k = (succ[i] >= 0) ? wchmm_check_match(winfo, w, windex[succ[i]]) : 0;
+	if (k > len) len = k;
+	if (len == winfo->wlen[w]) {
+	  /* the new word is a part of other words: short pause for it
+	     should be inserted before the following phones */
+	  if ((pred < 0 || winfo->wlen[windex[pred]] != len || wchmm_check_match(winfo, w, windex[pred]) != len)
+	      && (succ[i] < 0 || winfo->wlen[windex[succ[i]]] != len || wchmm_check_match(winfo, w, windex[succ[i]]) != len)) {
+	    ok_p = FALSE;
+	    break;
+	  }
+	}
+      }
+      pred = i;
+    }
+    if (! ok_p) {
+      free(succ);
+      free(windex);
+      free(newword);
+      free(intree);
+      return FALSE;
+    }
+  }
+
+  /* assign new grammar */
+  wchmm->winfo = winfo;
+  wchmm->dfa = dfa;
+  wchmm->dfa_forward = dfa_forward;
+
+  /* remove deleted words and renumber */
+  wchmm_update_remap(wchmm, winfo->num, wmap, old_wnum, cmap, remove_flag);
+  if (wchmm->hmminfo->multipath && wchmm->wrk.out_from_len < winfo->maxwn) {
+    wchmm->wrk.out_from = (int *)myrealloc(wchmm->wrk.out_from, sizeof(int) * winfo->maxwn);
+    wchmm->wrk.out_from_next = (int *)myrealloc(wchmm->wrk.out_from_next, sizeof(int) * winfo->maxwn);
+    wchmm->wrk.out_a = (LOGPROB *)myrealloc(wchmm->wrk.out_a, sizeof(LOGPROB) * winfo->maxwn);
+    wchmm->wrk.out_a_next = (LOGPROB *)myrealloc(wchmm->wrk.out_a_next, sizeof(LOGPROB) * winfo->maxwn);
+    wchmm->wrk.out_from_len = winfo->maxwn;
+  }
+
+  ok_p = TRUE;
+
+#ifdef PASS1_IWCD
+#ifndef USE_OLD_IWCD
+  if (wchmm->ccd_flag) {
+    /* category-indexed state sets */
+    old_root = NULL;
+    old_mroot = NULL;
+    if (remove_flag || cate_flag) {
+      /* category ID changed: re-generate all */
+      old_root = wchmm->lcdset_category_root;
+      old_mroot = wchmm->lcdset_mroot;
+      wchmm->lcdset_category_root = NULL;
+      wchmm->lcdset_mroot = NULL;
+      ctxtable_free(&(wchmm->lcdset_category_index));
+      lcdset_register_with_category_all(wchmm);
+    } else {
+      lcdset_register_with_category_words(wchmm, newword, newnum);
+    }
+    /* sets may be re-allocated by expansion, so re-assign them */
+    for(w=0;w<winfo->num;w++) {
+      if (! intree[w]) continue;
+      if (wchmm_update_relink_lset(wchmm, w) == FALSE) {
+	jlog("ERROR: wchmm: at word #%d: no lcdset found for [%s]\n", w, winfo->wseq[w][winfo->wlen[w]-1]->name);
+	ok_p = FALSE;
+      }
+    }
+    if (old_root != NULL) free_cdset(&old_root, &old_mroot);
+  }
+#endif
+#endif /* PASS1_IWCD */
+
+  /* insert new words */
+  pred = -1;
+  bgn = 0;
+  for(i=0;i<num;i++) {
+    w = windex[i];
+    if (i > 0 && winfo->wton[windex[i-1]] != winfo->wton[w]) {
+      pred = -1;
+      bgn = i;
+    }
+    if (! intree[w]) {
+      len = wchmm_update_find_match(wchmm, windex, bgn, i, pred, succ[i], intree, &mw);
+      if (wchmm_add_word(wchmm, w, len, mw, lmconf->enable_iwsp) == FALSE) {
+	jlog("ERROR: wchmm: failed to add word #%d to lexicon tree\n", w);
+	ok_p = FALSE;
+      }
+      intree[w] = TRUE;
+    }
+    pred = i;
+  }
+
+  free(succ);
+  free(windex);
+
+  if (wchmm->hmminfo->multipath) {
+    jlog("STAT: lexicon size: %d nodes\n", wchmm->n);
+  } else {
+    /* duplicate leaf nodes of homophone/embedded words */
+    jlog("STAT: lexicon size: %d", wchmm->n);
+    num_duplicated = wchmm_duplicate_leafnode(wchmm);
+    jlog("+%d=%d\n", num_duplicated, wchmm->n);
+    /* calculate transition probability of word end node to outside */
+    wchmm_calc_wordend_arc(wchmm);
+  }
+
+  if (verbose_flag) {
+    jlog("STAT: wchmm: %d words inserted, %d words kept on tree\n", newnum, winfo->num - newnum);
+  }
+
+  free(newword);
+  free(intree);
+
+  /* check wchmm coherence (internal debug) */
+  check_wchmm(wchmm);
+
+  return ok_p;
+}
+
 
 /** 
  * <JA>
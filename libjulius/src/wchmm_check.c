@@ -520,4 +520,325 @@ check_wchmm(WCHMM_INFO *wchmm)
   jlog("STAT: coordination check passed\n");
 }
 
+/** 
+ * <JA>
+ * 2つの値を混ぜ合わせたハッシュ値を返す. 
+ * 
+ * @param h [in] ハッシュ値
+ * @param v [in] 混ぜる値
+ * 
+ * @return 新しいハッシュ値
+ * </JA>
+ * <EN>
+ * Mix a value into a hash value.
+ * 
+ * @param h [in] hash value
+ * @param v [in] value to be mixed
+ * 
+ * @return the new hash value.
+ * </EN>
+ */
+static unsigned long
+wchmm_hash_mix(unsigned long h, unsigned long v)
+{
+  h ^= v + 0x9e3779b9UL + (h << 6) + (h >> 2);
+  return h;
+}
+
+/** 
+ * <JA>
+ * 対数確率値をハッシュ用の整数値に変換する. 
+ * 
+ * @param a [in] 対数確率
+ * 
+ * @return 整数値
+ * </JA>
+ * <EN>
+ * Convert a log probability to an integer value for hashing.
+ * 
+ * @param a [in] log probability
+ * 
+ * @return the integer value.
+ * </EN>
+ */
+static unsigned long
+wchmm_hash_prob(LOGPROB a)
+{
+  unsigned int v;
+
+  memcpy(&v, &a, sizeof(unsigned int));
+  return (unsigned long)v;
+}
+
+/** 
+ * <JA>
+ * ノードの出力確率の割り付けをハッシュ値にする. 状態集合は
+ * 内容で比較される. 
+ * 
+ * @param wchmm [in] 木構造化辞書
+ * @param n [in] ノード番号
+ * 
+ * @return ハッシュ値
+ * </JA>
+ * <EN>
+ * Compute a hash value of the output probability assignment of a node.
+ * State sets are compared by their contents, not by their address.
+ * 
+ * @param wchmm [in] tree lexicon
+ * @param n [in] node ID
+ * 
+ * @return the hash value.
+ * </EN>
+ */
+static unsigned long
+wchmm_hash_output(WCHMM_INFO *wchmm, int n)
+{
+  unsigned long h;
+#ifdef PASS1_IWCD
+  CD_State_Set *set;
+  int i;
+#endif
+
+  if (wchmm->state[n].out.state == NULL) return 1;
+#ifdef PASS1_IWCD
+  switch(wchmm->outstyle[n]) {
+  case AS_STATE:
+    return (unsigned long)wchmm->state[n].out.state;
+  case AS_LSET:
+    /* order of states in a set does not matter */
+    set = wchmm->state[n].out.lset;
+    h = (unsigned long)set->num;
+    for(i=0;i<set->num;i++) h += wchmm_hash_mix(0, (unsigned long)set->s[i]);
+    return wchmm_hash_mix(2, h);
+  case AS_RSET:
+    h = wchmm_hash_mix(3, (unsigned long)wchmm->state[n].out.rset->hmm);
+    return wchmm_hash_mix(h, wchmm->state[n].out.rset->state_loc);
+  case AS_LRSET:
+    h = wchmm_hash_mix(4, (unsigned long)wchmm->state[n].out.lrset->hmm);
+    h = wchmm_hash_mix(h, wchmm->state[n].out.lrset->state_loc);
+    return wchmm_hash_mix(h, wchmm->state[n].out.lrset->category);
+  }
+  return 0;
+#else
+  h = (unsigned long)wchmm->state[n].out;
+  return h;
+#endif
+}
+
+/** 
+ * <JA>
+ * ノード以下の部分木の形をハッシュ値にする. 
+ * 
+ * @param wchmm [in] 木構造化辞書
+ * @param n [in] ノード番号
+ * @param hash [i/o] 計算済みのハッシュ値 [node]
+ * @param mark [i/o] 計算状態 (0:未計算 1:計算中 2:計算済み) [node]
+ * 
+ * @return ハッシュ値
+ * </JA>
+ * <EN>
+ * Compute a hash value of the shape of sub-tree below a node: output
+ * assignment, transitions and word-end marks.  The value does not
+ * depend on node IDs, so it can be compared between trees.
+ * 
+ * @param wchmm [in] tree lexicon
+ * @param n [in] node ID
+ * @param hash [i/o] computed hash values [node]
+ * @param mark [i/o] status (0: not yet, 1: on the way, 2: done) [node]
+ * 
+ * @return the hash value.
+ * </EN>
+ */
+static unsigned long
+wchmm_hash_node(WCHMM_INFO *wchmm, int n, unsigned long *hash, char *mark)
+{
+  unsigned long h, sum;
+  A_CELL2 *ac;
+  int j;
+
+  if (mark[n] == 2) return hash[n];
+  if (mark[n] == 1) return 5;	/* loop */
+  mark[n] = 1;
+
+  h = wchmm_hash_output(wchmm, n);
+  h = wchmm_hash_mix(h, wchmm_hash_prob(wchmm->self_a[n]));
+  h = wchmm_hash_mix(h, (unsigned long)wchmm->stend[n]);
+  /* outgoing arcs as a set */
+  sum = 0;
+  if (wchmm->next_a[n] != LOG_ZERO && n + 1 < wchmm->n) {
+    sum += wchmm_hash_mix(wchmm_hash_prob(wchmm->next_a[n]), wchmm_hash_node(wchmm, n + 1, hash, mark));
+  }
+  for(ac=wchmm->ac[n];ac;ac=ac->next) {
+    for(j=0;j<ac->n;j++) {
+      if (ac->arc[j] == n) {
+	sum += wchmm_hash_mix(wchmm_hash_prob(ac->a[j]), 6);
+      } else {
+	sum += wchmm_hash_mix(wchmm_hash_prob(ac->a[j]), wchmm_hash_node(wchmm, ac->arc[j], hash, mark));
+      }
+    }
+  }
+  h = wchmm_hash_mix(h, sum);
+
+  hash[n] = h;
+  mark[n] = 2;
+  return h;
+}
+
+/** 
+ * <JA>
+ * ハッシュ値を比較する qsort 関数
+ * 
+ * @param a [in] 要素1
+ * @param b [in] 要素2
+ * 
+ * @return 比較結果
+ * </JA>
+ * <EN>
+ * qsort function to compare hash values.
+ * 
+ * @param a [in] element 1
+ * @param b [in] element 2
+ * 
+ * @return comparison result.
+ * </EN>
+ */
+static int
+compare_hash(unsigned long *a, unsigned long *b)
+{
+  if (*a < *b) return -1;
+  if (*a > *b) return 1;
+  return 0;
+}
+
+/** 
+ * <JA>
+ * 木構造化辞書の各単語先頭からの部分木のハッシュ値を求め，ソートして返す. 
+ * 
+ * @param wchmm [in] 木構造化辞書
+ * 
+ * @return 単語先頭ノードの数だけのハッシュ値の配列
+ * </JA>
+ * <EN>
+ * Compute hash values of sub-trees from all the start nodes with their
+ * category, and return them as a sorted array.
+ * 
+ * @param wchmm [in] tree lexicon
+ * 
+ * @return array of hash values with length of the number of start nodes.
+ * </EN>
+ */
+static unsigned long *
+wchmm_hash_startnodes(WCHMM_INFO *wchmm)
+{
+  unsigned long *hash, *ret;
+  char *mark;
+  int i, n;
+
+  hash = (unsigned long *)mymalloc(sizeof(unsigned long) * (wchmm->n > 0 ? wchmm->n : 1));
+  mark = (char *)mymalloc(sizeof(char) * (wchmm->n > 0 ? wchmm->n : 1));
+  for(n=0;n<wchmm->n;n++) mark[n] = 0;
+  ret = (unsigned long *)mymalloc(sizeof(unsigned long) * (wchmm->startnum > 0 ? wchmm->startnum : 1));
+  for(i=0;i<wchmm->startnum;i++) {
+    ret[i] = wchmm_hash_mix(wchmm_hash_node(wchmm, wchmm->startnode[i], hash, mark), wchmm->winfo->wton[wchmm->start2wid[i]]);
+  }
+  qsort(ret, wchmm->startnum, sizeof(unsigned long), (int (*)(const void *, const void *))compare_hash);
+  free(mark);
+  free(hash);
+  return ret;
+}
+
+/** 
+ * <JA>
+ * 差分更新された木構造化辞書を，同じ文法から一から構築した木構造化辞書と
+ * 比較する（内部デバッグ用, "-check update"）. ノード番号によらず，
+ * 各単語先頭からの部分木の形（出力確率の割り付け，遷移，単語終端）を
+ * 比較する. 
+ * 
+ * @param wchmm [in] 差分更新された木構造化辞書
+ * @param lmconf [in] 言語モデル設定
+ * 
+ * @return 一致すれば TRUE を返す. 
+ * </JA>
+ * <EN>
+ * Compare an incrementally updated tree lexicon with the one built
+ * from scratch with the same grammar (for internal debug, "-check
+ * update").  Shape of sub-trees from word start nodes, namely output
+ * assignment, transitions and word-end marks, are compared regardless
+ * of node IDs.
+ * 
+ * @param wchmm [in] incrementally updated tree lexicon
+ * @param lmconf [in] LM configuration
+ * 
+ * @return TRUE if the two trees match.
+ * </EN>
+ * @callgraph
+ * @callergraph
+ */
+boolean
+wchmm_check_update(WCHMM_INFO *wchmm, JCONF_LM *lmconf)
+{
+  WCHMM_INFO *ref;
+  unsigned long *h1, *h2;
+  int i, diff;
+  WORD_ID w;
+  boolean ok_p;
+
+  ref = wchmm_new();
+  ref->lmtype = wchmm->lmtype;
+  ref->lmvar = wchmm->lmvar;
+  ref->ccd_flag = wchmm->ccd_flag;
+  ref->category_tree = wchmm->category_tree;
+  ref->hmmwrk = wchmm->hmmwrk;
+  ref->dfa = wchmm->dfa;
+  ref->dfa_forward = wchmm->dfa_forward;
+  ref->winfo = wchmm->winfo;
+  ref->hmminfo = wchmm->hmminfo;
+  if (build_wchmm2(ref, lmconf) == FALSE) {
+    jlog("WARNING: wchmm: update check: failed to build reference lexicon tree\n");
+    wchmm_free(ref);
+    return FALSE;
+  }
+
+  ok_p = TRUE;
+  if (wchmm->n != ref->n) {
+    jlog("WARNING: wchmm: update check: %d nodes, should be %d\n", wchmm->n, ref->n);
+    ok_p = FALSE;
+  }
+  if (wchmm->startnum != ref->startnum) {
+    jlog("WARNING: wchmm: update check: %d start nodes, should be %d\n", wchmm->startnum, ref->startnum);
+    ok_p = FALSE;
+  } else {
+    h1 = wchmm_hash_startnodes(wchmm);
+    h2 = wchmm_hash_startnodes(ref);
+    diff = 0;
+    for(i=0;i<wchmm->startnum;i++) {
+      if (h1[i] != h2[i]) diff++;
+    }
+    if (diff > 0) {
+      jlog("WARNING: wchmm: update check: %d of %d sub-trees differ\n", diff, wchmm->startnum);
+      ok_p = FALSE;
+    }
+    free(h2);
+    free(h1);
+  }
+  if (! wchmm->hmminfo->multipath) {
+    diff = 0;
+    for(w=0;w<wchmm->winfo->num;w++) {
+      if (wchmm->wordend_a[w] != ref->wordend_a[w]) diff++;
+    }
+    if (diff > 0) {
+      jlog("WARNING: wchmm: update check: word-end transition differs on %d words\n", diff);
+      ok_p = FALSE;
+    }
+  }
+
+  if (ok_p) {
+    jlog("STAT: wchmm: update check: %d nodes, %d start nodes, same as re-built tree\n", wchmm->n, wchmm->startnum);
+  }
+
+  wchmm_free(ref);
+
+  return ok_p;
+}
+
 /* end of file */
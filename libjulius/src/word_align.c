@@ -117,14 +117,14 @@ make_phseq(WORD_ID *wseq, short num, boolean **has_sp_ret, int *num_ret, int **e
       if (r->ccd_flag) {
 	if (w > 0 && i == 0) {	/* word head */
 	  
-	  if ((ret = get_left_context_HMM(tmpp, ph[pn-1]->name, hmminfo)) != NULL) {
+	  if ((ret = get_left_context_logical(tmpp, ph[pn-1], hmminfo)) != NULL) {
 	    tmpp = ret;
 	  }
 	  /* if triphone not found, fallback to bi/mono-phone  */
 	  /* use pseudo phone when no bi-phone found in alignment... */
 	}
 	if (w < num-1 && i == winfo->wlen[tmpw] - 1) { /* word tail */
-	  if ((ret = get_right_context_HMM(tmpp, winfo->wseq[wseq[w+1]][0]->name, hmminfo)) != NULL) {
+	  if ((ret = get_right_context_logical(tmpp, winfo->wseq[wseq[w+1]][0], hmminfo)) != NULL) {
 	    tmpp = ret;
 	  }
 	}
@@ -164,42 +164,38 @@ make_phseq(WORD_ID *wseq, short num, boolean **has_sp_ret, int *num_ret, int **e
 
 /** 
  * <JA>
- * 文全体のHMMを構築し，Viterbiアラインメントを実行し，結果を出力する. 
+ * アラインメント単位ごとの結果格納用の情報を準備する. 
  * 
  * @param words [in] 文仮説をあらわす単語列
  * @param wnum [in] @a words の長さ
- * @param param [in] 入力特徴パラメータ列
  * @param per_what [in] 単語・音素・状態のどの単位でアラインメントを取るかを指定
- * @param align [out] アラインメント結果を格納するSentence構造体
- * @param r [i/o] 認識処理インスタンス
+ * @param phloc_ret [out] 各ユニットの属する音素の位置 (不要なら NULL)
+ * @param stloc_ret [out] 各ユニットの音素内の状態位置 (不要なら NULL)
+ * @param r [in] 認識処理インスタンス
+ * 
+ * @return アラインメント単位の数
  * </JA>
  * <EN>
- * Build sentence HMM, call viterbi_segment() and output result.
+ * Prepare unit information to store the alignment result.
  * 
  * @param words [in] word sequence of the sentence
  * @param wnum [in] number of words in @a words
- * @param param [in] input parameter vector
  * @param per_what [in] specify the alignment unit (word / phoneme / state)
- * @param s [out] Sentence data area to store the alignment result
- * @param r [i/o] recognition process instance
+ * @param phloc_ret [out] phone location of each unit, or NULL if not needed
+ * @param stloc_ret [out] state location in phone of each unit, or NULL if not needed
+ * @param r [in] recognition process instance
+ * 
+ * @return the number of alignment units.
  * </EN>
  */
-static void
-do_align(WORD_ID *words, short wnum, HTK_Param *param, int per_what, SentenceAlign *align, RecogProcess *r)
+static int
+align_prepare(WORD_ID *words, short wnum, int per_what, int **phloc_ret, int **stloc_ret, RecogProcess *r)
 {
-  HMM_Logical **phones;		/* phoneme sequence */
-  boolean *has_sp;		/* whether phone can follow short pause */
   int k;
-  int phonenum;			/* num of above */
-  HMM *shmm;			/* sentence HMM */
-  int *end_state;		/* state number of word ends */
-  int *end_frame;		/* segmented last frame of words */
-  LOGPROB *end_score;		/* normalized score of each words */
-  LOGPROB allscore;		/* total score of this word sequence */
   WORD_ID w;
-  int i, rlen;
+  int i;
   int end_num = 0;
-  int *id_seq, *phloc = NULL, *stloc = NULL;
+  int *phloc = NULL, *stloc = NULL;
   int j,n,p;
   WORD_INFO *winfo;
   HTK_HMM_INFO *hmminfo;
@@ -263,18 +259,57 @@ do_align(WORD_ID *words, short wnum, HTK_Param *param, int per_what, SentenceAli
     
     break;
   }
-  end_state = (int *)mymalloc(sizeof(int) * end_num);
 
-  /* make phoneme sequence word sequence */
-  phones = make_phseq(words, wnum, &has_sp, &phonenum, &end_state, per_what, r);
-  /* build the sentence HMMs */
-  shmm = new_make_word_hmm(hmminfo, phones, phonenum, has_sp);
-  if (shmm == NULL) {
-    j_internal_error("Error: failed to make word hmm for alignment\n");
-  }
+  *phloc_ret = phloc;
+  *stloc_ret = stloc;
+  return end_num;
+}
 
-  /* call viterbi segmentation function */
-  allscore = viterbi_segment(shmm, param, r->wchmm->hmmwrk, hmminfo->multipath, end_state, end_num, &id_seq, &end_frame, &end_score, &rlen);
+/** 
+ * <JA>
+ * Viterbiセグメンテーションの結果をアラインメント結果として格納する. 
+ * 
+ * @param words [in] 文仮説をあらわす単語列
+ * @param phones [in] 文仮説の音素列
+ * @param per_what [in] アラインメントの単位
+ * @param phloc [in] 各ユニットの属する音素の位置
+ * @param stloc [in] 各ユニットの音素内の状態位置
+ * @param end_num [in] アラインメント単位の数
+ * @param id_seq [in] 区間ごとのユニット番号
+ * @param end_frame [in] 区間ごとの終端フレーム
+ * @param end_score [in] 区間ごとの平均スコア
+ * @param rlen [in] 区間の数
+ * @param allscore [in] 全体のスコア
+ * @param align [out] アラインメント結果を格納する構造体
+ * @param r [in] 認識処理インスタンス
+ * </JA>
+ * <EN>
+ * Store the Viterbi segmentation to the alignment result.
+ * 
+ * @param words [in] word sequence of the sentence
+ * @param phones [in] phone sequence of the sentence
+ * @param per_what [in] alignment unit
+ * @param phloc [in] phone location of each unit
+ * @param stloc [in] state location in phone of each unit
+ * @param end_num [in] number of alignment units
+ * @param id_seq [in] unit id of each segment
+ * @param end_frame [in] last frame of each segment
+ * @param end_score [in] normalized score of each segment
+ * @param rlen [in] number of segments
+ * @param allscore [in] total score
+ * @param align [out] alignment result
+ * @param r [in] recognition process instance
+ * </EN>
+ */
+static void
+align_store(WORD_ID *words, HMM_Logical **phones, int per_what, int *phloc, int *stloc, int end_num, int *id_seq, int *end_frame, LOGPROB *end_score, int rlen, LOGPROB allscore, SentenceAlign *align, RecogProcess *r)
+{
+  int i;
+  HTK_HMM_INFO *hmminfo;
+  boolean enable_iwsp;		/* for multipath */
+
+  hmminfo = r->am->hmminfo;
+  if (hmminfo->multipath) enable_iwsp = r->lm->config->enable_iwsp;
 
   /* store result to s */
   align->num = rlen;
@@ -322,6 +357,65 @@ do_align(WORD_ID *words, short wnum, HTK_Param *param, int per_what, SentenceAli
   }
 
   align->allscore = allscore;
+}
+
+/** 
+ * <JA>
+ * 文全体のHMMを構築し，Viterbiアラインメントを実行し，結果を出力する. 
+ * 
+ * @param words [in] 文仮説をあらわす単語列
+ * @param wnum [in] @a words の長さ
+ * @param param [in] 入力特徴パラメータ列
+ * @param per_what [in] 単語・音素・状態のどの単位でアラインメントを取るかを指定
+ * @param align [out] アラインメント結果を格納するSentence構造体
+ * @param r [i/o] 認識処理インスタンス
+ * </JA>
+ * <EN>
+ * Build sentence HMM, call viterbi_segment() and output result.
+ * 
+ * @param words [in] word sequence of the sentence
+ * @param wnum [in] number of words in @a words
+ * @param param [in] input parameter vector
+ * @param per_what [in] specify the alignment unit (word / phoneme / state)
+ * @param s [out] Sentence data area to store the alignment result
+ * @param r [i/o] recognition process instance
+ * </EN>
+ */
+static void
+do_align(WORD_ID *words, short wnum, HTK_Param *param, int per_what, SentenceAlign *align, RecogProcess *r)
+{
+  HMM_Logical **phones;		/* phoneme sequence */
+  boolean *has_sp;		/* whether phone can follow short pause */
+  int phonenum;			/* num of above */
+  HMM *shmm;			/* sentence HMM */
+  int *end_state;		/* state number of word ends */
+  int *end_frame;		/* segmented last frame of words */
+  LOGPROB *end_score;		/* normalized score of each words */
+  LOGPROB allscore;		/* total score of this word sequence */
+  int rlen;
+  int end_num;
+  int *id_seq, *phloc, *stloc;
+  HTK_HMM_INFO *hmminfo;
+
+  hmminfo = r->am->hmminfo;
+
+  /* initialize result storage buffer */
+  end_num = align_prepare(words, wnum, per_what, &phloc, &stloc, r);
+  end_state = (int *)mymalloc(sizeof(int) * end_num);
+
+  /* make phoneme sequence word sequence */
+  phones = make_phseq(words, wnum, &has_sp, &phonenum, &end_state, per_what, r);
+  /* build the sentence HMMs */
+  shmm = new_make_word_hmm(hmminfo, phones, phonenum, has_sp);
+  if (shmm == NULL) {
+    j_internal_error("Error: failed to make word hmm for alignment\n");
+  }
+
+  /* call viterbi segmentation function */
+  allscore = viterbi_segment(shmm, param, r->wchmm->hmmwrk, hmminfo->multipath, end_state, end_num, &id_seq, &end_frame, &end_score, &rlen);
+
+  /* store result to s */
+  align_store(words, phones, per_what, phloc, stloc, end_num, id_seq, end_frame, end_score, rlen, allscore, align, r);
 
   free_hmm(shmm);
   free(id_seq);
@@ -330,18 +424,8 @@ do_align(WORD_ID *words, short wnum, HTK_Param *param, int per_what, SentenceAli
   free(end_score);
   free(end_frame);
   free(end_state);
-
-  switch(per_what) {
-  case PER_WORD:
-    free(phloc);
-    break;
-  case PER_PHONEME:
-    break;
-  case PER_STATE:
-    free(phloc);
-    free(stloc);
-  }
-  
+  if (phloc) free(phloc);
+  if (stloc) free(stloc);
 }
 
 /** 
@@ -527,15 +611,540 @@ state_rev_align(WORD_ID *revwords, short num, HTK_Param *param, SentenceAlign *a
   free(words);
 }
 
+/** 
+ * Transition score given to a missing arc in the diagonal transition
+ * table of ALIGN_TRELLIS.  It is far below LOG_ZERO, so a path through
+ * a missing arc is never selected.
+ * 
+ */
+#define ALIGN_NOARC (-1.0e+30)
+
+/**
+ * Viterbi trellis of a sentence HMM shared among alignments of the
+ * N-best results.  Whole trellis is held in memory so that the
+ * word, phoneme and state alignments of the same sentence are all
+ * traced back from one Viterbi computation, and sentences sharing
+ * leading states can copy the common part from an earlier sentence.
+ * 
+ */
+typedef struct {
+  HMM *shmm;			///< Sentence HMM
+  int len;			///< Number of states in @a shmm
+  int kmin;			///< Minimum arc distance (to - from)
+  int kmax;			///< Maximum arc distance (to - from)
+  LOGPROB *arc;		///< Transition to state m from m-k at [(k-kmin)*len+m]
+  LOGPROB *score;		///< Viterbi score at [row*len+state]
+  int *from;			///< Back pointer at [row*len+state], -1 if not reached
+  int donor;			///< Index of sentence to copy the leading states from, or -1
+  int prefix;			///< Number of leading states shared with @a donor
+  boolean shared;		///< TRUE if whole trellis is that of @a donor
+  boolean done;			///< TRUE when Viterbi has been computed
+} ALIGN_TRELLIS;
+
+/**
+ * Work area to compute trellises of N-best results in parallel.
+ * 
+ */
+typedef struct {
+  ALIGN_TRELLIS *tr;		///< Trellis of each sentence
+  int num;			///< Number of sentences
+  int nrow;			///< Number of trellis rows
+  int maxlen;			///< Maximum length of sentence HMMs
+  int next;			///< Next sentence to be computed
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t mutex;	///< Mutex for @a next and @a done
+  pthread_cond_t cond;		///< Signalled when a trellis is done
+#endif
+} ALIGN_BATCH;
+
+/** 
+ * <JA>
+ * 文仮説の文HMMを構築し，遷移を距離ごとの表に展開する. 
+ * 
+ * @param tr [out] トレリス
+ * @param words [in] 単語列
+ * @param wnum [in] @a words の長さ
+ * @param r [in] 認識処理インスタンス
+ * </JA>
+ * <EN>
+ * Build sentence HMM of a sentence and expand its transitions to
+ * a table per arc distance.
+ * 
+ * @param tr [out] trellis
+ * @param words [in] word sequence
+ * @param wnum [in] length of @a words
+ * @param r [in] recognition process instance
+ * </EN>
+ */
+static void
+align_trellis_setup(ALIGN_TRELLIS *tr, WORD_ID *words, short wnum, RecogProcess *r)
+{
+  HMM_Logical **phones;
+  boolean *has_sp;
+  int phonenum;
+  int *end_state;
+  A_CELL *ac;
+  int n, k, len;
+  LOGPROB *a;
+
+  end_state = (int *)mymalloc(sizeof(int) * wnum);
+  phones = make_phseq(words, wnum, &has_sp, &phonenum, &end_state, PER_WORD, r);
+  tr->shmm = new_make_word_hmm(r->am->hmminfo, phones, phonenum, has_sp);
+  if (tr->shmm == NULL) {
+    j_internal_error("Error: failed to make word hmm for alignment\n");
+  }
+  free(phones);
+  if (has_sp) free(has_sp);
+  free(end_state);
+
+  len = tr->len = tr->shmm->len;
+  tr->kmin = tr->kmax = 0;
+  for (n = 0; n < len; n++) {
+    for (ac = tr->shmm->state[n].ac; ac; ac = ac->next) {
+      k = ac->arc - n;
+      if (tr->kmin > k) tr->kmin = k;
+      if (tr->kmax < k) tr->kmax = k;
+    }
+  }
+  tr->arc = (LOGPROB *)mymalloc(sizeof(LOGPROB) * len * (tr->kmax - tr->kmin + 1));
+  for (n = 0; n < len * (tr->kmax - tr->kmin + 1); n++) tr->arc[n] = ALIGN_NOARC;
+  for (n = 0; n < len; n++) {
+    for (ac = tr->shmm->state[n].ac; ac; ac = ac->next) {
+      a = &(tr->arc[(ac->arc - n - tr->kmin) * len + ac->arc]);
+      if (*a < ac->a) *a = ac->a;
+    }
+  }
+  tr->score = NULL;
+  tr->from = NULL;
+  tr->donor = -1;
+  tr->prefix = 0;
+  tr->shared = FALSE;
+  tr->done = FALSE;
+}
+
+/** 
+ * <JA>
+ * 2つの文HMMで，同一の Viterbi スコアとなる先頭の状態数を求める. 
+ * 
+ * @param a [in] 先の文のトレリス
+ * @param b [in] 後の文のトレリス
+ * 
+ * @return 共有できる先頭の状態数
+ * </JA>
+ * <EN>
+ * Get number of leading states whose Viterbi scores are the same
+ * between two sentence HMMs.  The states should have the same
+ * output probability and incoming transitions, and no transition
+ * should come into them from outside.
+ * 
+ * @param a [in] trellis of the former sentence
+ * @param b [in] trellis of the latter sentence
+ * 
+ * @return the number of leading states that can be shared.
+ * </EN>
+ */
+static int
+align_trellis_prefix(ALIGN_TRELLIS *a, ALIGN_TRELLIS *b)
+{
+  int m, k, p, q, kmin, kmax;
+  LOGPROB aa, ab;
+  HMM_STATE *sa, *sb;
+
+  kmin = (a->kmin < b->kmin) ? a->kmin : b->kmin;
+  kmax = (a->kmax > b->kmax) ? a->kmax : b->kmax;
+
+  for (m = 0; m < a->len && m < b->len; m++) {
+    sa = &(a->shmm->state[m]);
+    sb = &(b->shmm->state[m]);
+    if (sa->is_pseudo_state != sb->is_pseudo_state) break;
+    if (sa->out.state != sb->out.state) break;
+    for (k = kmin; k <= kmax; k++) {
+      aa = (k < a->kmin || k > a->kmax) ? ALIGN_NOARC : a->arc[(k - a->kmin) * a->len + m];
+      ab = (k < b->kmin || k > b->kmax) ? ALIGN_NOARC : b->arc[(k - b->kmin) * b->len + m];
+      if (aa != ab) break;
+    }
+    if (k <= kmax) break;
+  }
+  /* shrink until no arc comes into the prefix from outside */
+  p = m;
+  do {
+    q = p;
+    for (m = 0; m < q; m++) {
+      for (k = b->kmin; k < 0; k++) {
+	if (b->arc[(k - b->kmin) * b->len + m] != ALIGN_NOARC && m - k >= q) break;
+      }
+      if (k < 0) break;
+    }
+    p = m;
+  } while (p < q);
+
+  return p;
+}
+
+/** 
+ * <JA>
+ * トレリスを確保し，出力確率を埋める. 出力確率はキャッシュ経由で
+ * 文の間で共有される. 
+ * 
+ * @param tr [i/o] トレリス
+ * @param nrow [in] トレリスの行数
+ * @param param [in] 入力特徴パラメータ列
+ * @param wrk [i/o] HMM計算用ワークエリア
+ * @param multipath [in] マルチパスモードなら TRUE
+ * </JA>
+ * <EN>
+ * Allocate trellis and fill in the output probabilities of reachable
+ * states.  Output probabilities are computed here, not in the
+ * (possibly parallel) Viterbi, and shared among sentences through the
+ * outprob cache.
+ * 
+ * @param tr [i/o] trellis
+ * @param nrow [in] number of trellis rows
+ * @param param [in] input parameter vectors
+ * @param wrk [i/o] HMM computation work area
+ * @param multipath [in] TRUE if multi-path mode
+ * </EN>
+ */
+static void
+align_trellis_outprob(ALIGN_TRELLIS *tr, int nrow, HTK_Param *param, HMMWork *wrk, boolean multipath)
+{
+  int len, row, m, k, t;
+  char *reach, *reach_prev, *tmp;
+  LOGPROB *cur, *a;
+  HMM_STATE *s;
+
+  len = tr->len;
+  tr->score = (LOGPROB *)mymalloc(sizeof(LOGPROB) * len * nrow);
+  tr->from = (int *)mymalloc(sizeof(int) * len * nrow);
+
+  /* initial row */
+  for (m = 0; m < len; m++) {
+    tr->score[m] = LOG_ZERO;
+    tr->from[m] = -1;
+  }
+  if (multipath) {
+    tr->score[0] = 0.0;
+  } else {
+    tr->score[0] = outprob(wrk, 0, &(tr->shmm->state[0]), param);
+  }
+
+  reach = (char *)mymalloc(len);
+  reach_prev = (char *)mymalloc(len);
+  for (m = 0; m < len; m++) reach[m] = 0;
+  reach[0] = 1;
+  for (row = 1; row < nrow; row++) {
+    tmp = reach_prev; reach_prev = reach; reach = tmp;
+    for (m = 0; m < len; m++) reach[m] = 0;
+    for (k = tr->kmin; k <= tr->kmax; k++) {
+      a = &(tr->arc[(k - tr->kmin) * len]);
+      for (m = (k > 0) ? k : 0; m < ((k < 0) ? len + k : len); m++) {
+	if (a[m] != ALIGN_NOARC && reach_prev[m - k]) reach[m] = 1;
+      }
+    }
+    t = (multipath ? 0 : 1) + row - 1;
+    cur = &(tr->score[row * len]);
+    for (m = tr->prefix; m < len; m++) {
+      cur[m] = 0.0;
+      if (!reach[m]) continue;
+      s = &(tr->shmm->state[m]);
+      if (multipath) {
+	if (t == param->samplenum) continue;
+	if (s->out.state == NULL) continue;
+      }
+      if (s->is_pseudo_state) {
+	jlog("Warning: vsegment: state %d: pseudo state?\n", m);
+      }
+      cur[m] = outprob(wrk, t, s, param);
+    }
+  }
+  free(reach);
+  free(reach_prev);
+}
+
+/** 
+ * <JA>
+ * トレリス上で Viterbi を計算する. 出力確率の計算を含まないため
+ * 複数の文を並列に計算できる. 
+ * 
+ * @param tr [i/o] トレリス
+ * @param donor [in] 先頭状態をコピーする文のトレリス
+ * @param nrow [in] トレリスの行数
+ * @param best [out] 作業領域 (@a tr->len 以上)
+ * </JA>
+ * <EN>
+ * Compute Viterbi on the trellis.  The score of each state is updated
+ * per arc distance so that the inner loop runs straight over the
+ * states without branches and can be vectorized.  Sources are visited
+ * in ascending order with the strict comparison, so the selected path
+ * is the same as viterbi_segment().  No output probability is computed
+ * here, thus trellises of multiple sentences can be computed in
+ * parallel.
+ * 
+ * @param tr [i/o] trellis
+ * @param donor [in] trellis to copy leading states from
+ * @param nrow [in] number of trellis rows
+ * @param best [out] work area of at least @a tr->len
+ * </EN>
+ */
+static void
+align_trellis_viterbi(ALIGN_TRELLIS *tr, ALIGN_TRELLIS *donor, int nrow, LOGPROB *best)
+{
+  int len, p, row, k, m, lo, hi;
+  LOGPROB *prev, *cur, *a;
+  int *fr;
+  LOGPROB x;
+  boolean c;
+
+  len = tr->len;
+  p = tr->prefix;
+  for (row = 1; row < nrow; row++) {
+    prev = &(tr->score[(row - 1) * len]);
+    cur = &(tr->score[row * len]);
+    fr = &(tr->from[row * len]);
+    if (p > 0) {
+      memcpy(cur, &(donor->score[row * donor->len]), sizeof(LOGPROB) * p);
+      memcpy(fr, &(donor->from[row * donor->len]), sizeof(int) * p);
+    }
+    for (m = p; m < len; m++) {
+      best[m] = LOG_ZERO;
+      fr[m] = -1;
+    }
+    for (k = tr->kmax; k >= tr->kmin; k--) {
+      a = &(tr->arc[(k - tr->kmin) * len]);
+      lo = (k > p) ? k : p;
+      hi = (k < 0) ? len + k : len;
+      for (m = lo; m < hi; m++) {
+	x = prev[m - k] + a[m];
+	c = (prev[m - k] > LOG_ZERO && best[m] < x);
+	best[m] = c ? x : best[m];
+	fr[m] = c ? m - k : fr[m];
+      }
+    }
+    for (m = p; m < len; m++) {
+      cur[m] = (fr[m] != -1) ? best[m] + cur[m] : LOG_ZERO;
+    }
+  }
+}
+
+/** 
+ * <JA>
+ * トレリスをバックトレースし，ユニット単位のセグメンテーションを得る. 
+ * 結果は viterbi_segment() と同じ形式で返される. 
+ * 
+ * @param tr [in] トレリス
+ * @param nrow [in] トレリスの行数
+ * @param multipath [in] マルチパスモードなら TRUE
+ * @param endstates [in] 各ユニットの終端状態番号
+ * @param ulen [in] ユニットの数
+ * @param id_ret [out] 区間ごとのユニット番号
+ * @param seg_ret [out] 区間ごとの終端フレーム
+ * @param uscore_ret [out] 区間ごとの平均スコア
+ * @param slen_ret [out] 区間の数
+ * 
+ * @return 全体のスコア
+ * </JA>
+ * <EN>
+ * Trace back the trellis to get segmentation per unit.  The result is
+ * returned in the same form as viterbi_segment().
+ * 
+ * @param tr [in] trellis
+ * @param nrow [in] number of trellis rows
+ * @param multipath [in] TRUE if multi-path mode
+ * @param endstates [in] end state of each unit
+ * @param ulen [in] number of units
+ * @param id_ret [out] unit id of each segment
+ * @param seg_ret [out] last frame of each segment
+ * @param uscore_ret [out] normalized score of each segment
+ * @param slen_ret [out] number of segments
+ * 
+ * @return the total score.
+ * </EN>
+ */
+static LOGPROB
+align_trellis_trace(ALIGN_TRELLIS *tr, int nrow, boolean multipath, int *endstates, int ulen, int **id_ret, int **seg_ret, LOGPROB **uscore_ret, int *slen_ret)
+{
+  int len, n, f, i, row, t, startt;
+  int *u_unit, *u_start;
+  int *rid, *rseg, nrec;
+  LOGPROB *rscore;
+  int *id, *seg, slen;
+  LOGPROB *uscore;
+  LOGPROB result_score;
+
+  len = tr->len;
+  startt = multipath ? 0 : 1;
+
+  /* u_unit: unit of the state (multipath) or unit ending at the state */
+  u_unit = (int *)mymalloc(sizeof(int) * len);
+  u_start = NULL;
+  if (multipath) {
+    i = 0;
+    for (n = 0; n < len; n++) {
+      while (i < ulen && n > endstates[i]) i++;
+      u_unit[n] = i;
+    }
+  } else {
+    u_start = (int *)mymalloc(sizeof(int) * len);
+    for (n = 0; n < len; n++) {
+      u_start[n] = -1;
+      u_unit[n] = -1;
+    }
+    u_start[0] = 0;
+    u_unit[endstates[0]] = 0;
+    for (i = 1; i < ulen; i++) {
+      u_start[endstates[i-1]+1] = i;
+      u_unit[endstates[i]] = i;
+    }
+  }
+
+  /* trace back the best path, recording transitions between units */
+  rid = (int *)mymalloc(sizeof(int) * nrow);
+  rseg = (int *)mymalloc(sizeof(int) * nrow);
+  rscore = (LOGPROB *)mymalloc(sizeof(LOGPROB) * nrow);
+  nrec = 0;
+  n = len - 1;
+  for (row = nrow - 1; row > 0; row--) {
+    f = tr->from[row * len + n];
+    if (f == -1) break;
+    t = startt + row - 1;
+    if (multipath) {
+      i = u_unit[f];
+      if (i < ulen && n > endstates[i]) {
+	if (t - 1 == -1) break;
+	rid[nrec] = i;
+	rseg[nrec] = t - 1;
+	rscore[nrec] = tr->score[(row - 1) * len + f];
+	nrec++;
+      }
+    } else {
+      if (u_unit[f] != -1 && u_start[n] != -1 && f != n) {
+	rid[nrec] = u_unit[f];
+	rseg[nrec] = t - 1;
+	rscore[nrec] = tr->score[(row - 1) * len + f];
+	nrec++;
+      }
+    }
+    n = f;
+  }
+
+  result_score = tr->score[(nrow - 1) * len + len - 1];
+
+  slen = nrec;
+  if (!multipath) slen++;
+  id = (int *)mymalloc(sizeof(int)*slen);
+  seg = (int *)mymalloc(sizeof(int)*slen);
+  uscore = (LOGPROB *)mymalloc(sizeof(LOGPROB)*slen);
+  if (multipath) {
+    i = slen - 1;
+  } else {
+    id[slen-1] = ulen - 1;
+    seg[slen-1] = startt + nrow - 2;
+    uscore[slen-1] = result_score;
+    i = slen - 2;
+  }
+  for (n = 0; n < nrec; n++, i--) {
+    id[i] = rid[n];
+    seg[i] = rseg[n];
+    uscore[i] = rscore[n];
+  }
+
+  /* normalize scores by frame */
+  for (i=slen-1;i>0;i--) {
+    uscore[i] = (uscore[i] - uscore[i-1]) / (seg[i] - seg[i-1]);
+  }
+  if (slen > 0) uscore[0] = uscore[0] / (seg[0] + 1);
+
+  *id_ret = id;
+  *seg_ret = seg;
+  *uscore_ret = uscore;
+  *slen_ret = slen;
+
+  free(rid);
+  free(rseg);
+  free(rscore);
+  free(u_unit);
+  if (u_start) free(u_start);
+
+  return result_score;
+}
+
+/** 
+ * <JA>
+ * 未計算のトレリスを順に取り出して Viterbi を計算する. 
+ * 
+ * @param arg [i/o] ALIGN_BATCH
+ * 
+ * @return NULL
+ * </JA>
+ * <EN>
+ * Take uncomputed trellises in order and compute Viterbi on them.
+ * A trellis which copies states from another waits for it to be done.
+ * Run as a thread, or called directly without threads.
+ * 
+ * @param arg [i/o] ALIGN_BATCH
+ * 
+ * @return NULL
+ * </EN>
+ */
+static void *
+align_batch_worker(void *arg)
+{
+  ALIGN_BATCH *b = (ALIGN_BATCH *)arg;
+  ALIGN_TRELLIS *tr;
+  LOGPROB *best;
+
+  best = (LOGPROB *)mymalloc(sizeof(LOGPROB) * b->maxlen);
+  for(;;) {
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&(b->mutex));
+#endif
+    if (b->next >= b->num) {
+#ifdef HAVE_PTHREAD
+      pthread_mutex_unlock(&(b->mutex));
+#endif
+      break;
+    }
+    tr = &(b->tr[b->next++]);
+#ifdef HAVE_PTHREAD
+    /* donors always have smaller index and are already taken */
+    while (tr->donor != -1 && b->tr[tr->donor].done == FALSE) {
+      pthread_cond_wait(&(b->cond), &(b->mutex));
+    }
+    pthread_mutex_unlock(&(b->mutex));
+#endif
+    if (tr->shared == FALSE) {
+      align_trellis_viterbi(tr, (tr->donor != -1) ? &(b->tr[tr->donor]) : NULL, b->nrow, best);
+    }
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&(b->mutex));
+    tr->done = TRUE;
+    pthread_cond_broadcast(&(b->cond));
+    pthread_mutex_unlock(&(b->mutex));
+#else
+    tr->done = TRUE;
+#endif
+  }
+  free(best);
+
+  return NULL;
+}
+
 /** 
  * <JA>
  * 認識結果に対して必要なアラインメントを全て実行する．
+ * Viterbi は文ごとに1回だけ計算して各単位で共有し，先行する文と
+ * 先頭の状態が共通する部分はコピーする．"-alignthreads" 指定時は
+ * 文ごとに並列に計算する．
  * 
  * @param r [i/o] 認識処理インスタンス
  * @param param [in] 入力特徴ベクトル列
  * </JA>
  * <EN>
- * Do required forced alignment for the recognition results
+ * Do required forced alignment for the recognition results.
+ * Viterbi is computed once per sentence and traced back for all the
+ * required units, sentences sharing leading states with a preceding
+ * one copy them, and sentences are computed in parallel when
+ * "-alignthreads" is specified.
  * 
  * @param r [i/o] recognition process instance
  * @param param [in] input parameter vectors
@@ -546,35 +1155,138 @@ state_rev_align(WORD_ID *revwords, short num, HTK_Param *param, SentenceAlign *a
 void
 do_alignment_all(RecogProcess *r, HTK_Param *param)
 {
-  int n;
+  int n, i;
   Sentence *s;
   SentenceAlign *now, *prev;
+  ALIGN_BATCH b;
+  ALIGN_TRELLIS *tr;
+  boolean multipath;
+  int per_what[3], per_num;
+  int p, shared_num, total_num;
+  HMM_Logical **phones;
+  boolean *has_sp;
+  int phonenum;
+  int end_num, *end_state, *phloc, *stloc;
+  int *id_seq, *end_frame, rlen;
+  LOGPROB *end_score, allscore;
+#ifdef HAVE_PTHREAD
+  int nthread;
+  pthread_t *threads;
+#endif
+
+  per_num = 0;
+  if (r->config->annotate.align_result_word_flag) per_what[per_num++] = PER_WORD;
+  if (r->config->annotate.align_result_phoneme_flag) per_what[per_num++] = PER_PHONEME;
+  if (r->config->annotate.align_result_state_flag) per_what[per_num++] = PER_STATE;
+  if (per_num == 0 || r->result.sentnum <= 0) return;
+
+  multipath = r->am->hmminfo->multipath;
+  b.num = r->result.sentnum;
+  b.nrow = multipath ? param->samplenum + 2 : param->samplenum;
+  b.maxlen = 0;
+  b.next = 0;
+  b.tr = (ALIGN_TRELLIS *)mymalloc(sizeof(ALIGN_TRELLIS) * b.num);
 
-  for(n = 0; n < r->result.sentnum; n++) {
+  /* build sentence HMMs, and find the longest leading states shared
+     with a preceding sentence for each */
+  shared_num = total_num = 0;
+  for(n = 0; n < b.num; n++) {
     s = &(r->result.sent[n]);
-    /* do forced alignment if needed */
-    if (r->config->annotate.align_result_word_flag) {
-      now = result_align_new();
-      word_align(s->word, s->word_num, param, now, r);
-      if (s->align == NULL) s->align = now;
-      else prev->next = now;
-      prev = now;
+    tr = &(b.tr[n]);
+    align_trellis_setup(tr, s->word, s->word_num, r);
+    if (b.maxlen < tr->len) b.maxlen = tr->len;
+    for(i = 0; i < n; i++) {
+      p = align_trellis_prefix(&(b.tr[i]), tr);
+      if (tr->prefix < p) {
+	tr->prefix = p;
+	tr->donor = i;
+      }
     }
-    if (r->config->annotate.align_result_phoneme_flag) {
-      now = result_align_new();
-      phoneme_align(s->word, s->word_num, param, now, r);
-      if (s->align == NULL) s->align = now;
-      else prev->next = now;
-      prev = now;
+    if (tr->donor != -1 && tr->prefix == tr->len && tr->len == b.tr[tr->donor].len) {
+      tr->shared = TRUE;
+    }
+    shared_num += tr->prefix;
+    total_num += tr->len;
+  }
+
+  /* fill output probabilities, sharing them via the outprob cache */
+  for(n = 0; n < b.num; n++) {
+    tr = &(b.tr[n]);
+    if (tr->shared) {
+      tr->score = b.tr[tr->donor].score;
+      tr->from = b.tr[tr->donor].from;
+    } else {
+      align_trellis_outprob(tr, b.nrow, param, r->wchmm->hmmwrk, multipath);
+    }
+  }
+
+  /* compute Viterbi of the sentences, in parallel if specified */
+#ifdef HAVE_PTHREAD
+  pthread_mutex_init(&(b.mutex), NULL);
+  pthread_cond_init(&(b.cond), NULL);
+  nthread = r->config->annotate.align_threads;
+  if (nthread > b.num) nthread = b.num;
+  threads = NULL;
+  if (nthread > 1) {
+    threads = (pthread_t *)mymalloc(sizeof(pthread_t) * (nthread - 1));
+    for(i = 0; i < nthread - 1; i++) {
+      if (pthread_create(&(threads[i]), NULL, align_batch_worker, &b) != 0) {
+	jlog("WARNING: do_alignment_all: failed to create thread, align with %d threads\n", i + 1);
+	break;
+      }
     }
-    if (r->config->annotate.align_result_state_flag) {
+    nthread = i + 1;
+  }
+  align_batch_worker(&b);
+  if (threads) {
+    for(i = 0; i < nthread - 1; i++) pthread_join(threads[i], NULL);
+    free(threads);
+  }
+  pthread_cond_destroy(&(b.cond));
+  pthread_mutex_destroy(&(b.mutex));
+#else
+  align_batch_worker(&b);
+#endif
+
+  if (verbose_flag) {
+    jlog("STAT: align: %d sentences, %d of %d states shared with preceding sentences\n", b.num, shared_num, total_num);
+  }
+
+  /* trace back each trellis per the required units and store the results */
+  for(n = 0; n < b.num; n++) {
+    s = &(r->result.sent[n]);
+    tr = &(b.tr[n]);
+    for(i = 0; i < per_num; i++) {
       now = result_align_new();
-      state_align(s->word, s->word_num, param, now, r);
+      end_num = align_prepare(s->word, s->word_num, per_what[i], &phloc, &stloc, r);
+      end_state = (int *)mymalloc(sizeof(int) * end_num);
+      phones = make_phseq(s->word, s->word_num, &has_sp, &phonenum, &end_state, per_what[i], r);
+      allscore = align_trellis_trace(tr, b.nrow, multipath, end_state, end_num, &id_seq, &end_frame, &end_score, &rlen);
+      align_store(s->word, phones, per_what[i], phloc, stloc, end_num, id_seq, end_frame, end_score, rlen, allscore, now, r);
+      free(id_seq);
+      free(phones);
+      if (has_sp) free(has_sp);
+      free(end_score);
+      free(end_frame);
+      free(end_state);
+      if (phloc) free(phloc);
+      if (stloc) free(stloc);
       if (s->align == NULL) s->align = now;
       else prev->next = now;
       prev = now;
     }
   }
+
+  for(n = 0; n < b.num; n++) {
+    tr = &(b.tr[n]);
+    free_hmm(tr->shmm);
+    free(tr->arc);
+    if (tr->shared == FALSE) {
+      free(tr->score);
+      free(tr->from);
+    }
+  }
+  free(b.tr);
 } 
 
 /* end of file */
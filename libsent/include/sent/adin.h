@@ -109,6 +109,24 @@ typedef struct {
   int buflen; ///< Length of buffer
 } DS_BUFFER;
 
+#define RS_ALIGN 8		///< Filter length alignment for vectorized inner product
+/**
+ * Polyphase sampling rate converter of rational ratio
+ * 
+ */
+typedef struct {
+  int infreq;			///< Input sampling rate
+  int outfreq;			///< Output sampling rate
+  int up;			///< Up sampling factor L
+  int down;			///< Down sampling factor M
+  int taps;			///< Filter length of each phase, multiple of RS_ALIGN
+  float *coef;			///< [up][taps] filter coefficients in reversed order
+  float *x;			///< Input samples including the history
+  int xlen;			///< Allocated length of @a x
+  int hist;			///< Number of samples held in @a x
+  long t;			///< Up-sampled time of next output relative to @a x
+} RESAMPLER;
+
 /**
  * Work area for zero-cross computation
  * 
@@ -226,6 +244,13 @@ DS_BUFFER *ds48to16_new();
 void ds48to16_free(DS_BUFFER *ds);
 int ds48to16(SP16 *dst, SP16 *src, int srclen, int maxdstlen, DS_BUFFER *ds);
 
+/* adin/resample.c */
+RESAMPLER *resample_new(int infreq, int outfreq);
+void resample_reset(RESAMPLER *rs);
+void resample_free(RESAMPLER *rs);
+int resample_inlen(RESAMPLER *rs, int outlen);
+int resample(SP16 *dst, SP16 *src, int srclen, int maxdstlen, RESAMPLER *rs);
+
 #ifdef __cplusplus
 }
 #endif
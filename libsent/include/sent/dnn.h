@@ -59,6 +59,8 @@ typedef struct {
   float *invec;		    /* input vector holder (32byte aligned) */
   float **work;		    /* working buffer for ff computation */
   float *accum;		    /* working buffer for accumulation */
+  float *batch_buf;	    /* working buffer for batched computation */
+  int batch_alloc;	    /* number of frames allocated for batch_buf */
 #ifdef __NVCC__
   boolean use_cuda;
   boolean use_cuda_shared;
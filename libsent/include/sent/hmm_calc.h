@@ -116,6 +116,10 @@ typedef struct __hmmwork__{
   int outprob_allocframenum;	///< Allocated frames of the cache
   BMALLOC_BASE *croot;	///< Root alloc pointer to state outprob cache
   LOGPROB *last_cache;	///< Local work are to hold cache list of current time
+  int cache_keep_start;	///< First frame of the cache to be carried over to the next input
+  int cache_keep_num;	///< Number of frames to be carried over, 0 if none
+  int cache_kept_frames;	///< Number of frames carried over at the last preparation
+  int cache_kept;	///< Number of cached scores carried over at the last preparation
 
   /* mixture level cache for tied-mixture model */
   MIXCACHE ***mixture_cache; ///< Codebook cache: [time][book_id][0..computed_mixture_num]
@@ -155,9 +159,18 @@ typedef struct __hmmwork__{
   LOGPROB *t_fs;		///< Current fallback_score
   /* GMS gprune local cache */
   int **gms_last_max_id_list;	///< maximum mixture id of last call for each states
+  /* GMS phone lookahead */
+  int *gs_state2phone;		///< Mapping from GS state id to lookahead phone id
+  int gs_phone_num;		///< Number of lookahead phones
+  LOGPROB *gs_la_score;		///< Work area for GS state scores at lookahead frame
 
   boolean batch_computation;
 
+  /* external scheduler for DNN computation */
+  /// If set, called instead of dnn_calc_outprob() to compute a new frame
+  void (*dnn_batch_func)(struct __hmmwork__ *);
+  void *dnn_batch_data;	///< Scheduler data for @a dnn_batch_func
+
 } HMMWork;
 
 #ifdef __cplusplus
@@ -181,6 +194,8 @@ void outprob_set_batch_computation(HMMWork *wrk, boolean flag);
 /* outprob.c */
 boolean outprob_cache_init(HMMWork *wrk);
 boolean outprob_cache_prepare(HMMWork *wrk);
+void outprob_cache_keep(HMMWork *wrk, int start, int num);
+void outprob_cache_carry(HMMWork *dst, HMMWork *src);
 void outprob_cache_free(HMMWork *wrk);
 LOGPROB outprob_state(HMMWork *wrk, int t, HTK_HMM_State *stateinfo, HTK_Param *param);
 void outprob_cd_nbest_init(HMMWork *wrk, int num);
@@ -193,6 +208,9 @@ boolean gms_init(HMMWork *wrk);
 boolean gms_prepare(HMMWork *wrk, int framelen);
 void gms_free(HMMWork *wrk);
 LOGPROB gms_state(HMMWork *wrk);
+int gms_lookahead_init(HMMWork *wrk);
+int gms_lookahead_phone(HMMWork *wrk, HMM_Logical *l);
+void gms_lookahead_frame(HMMWork *wrk, HTK_Param *param, int t, LOGPROB *phone_max);
 /* gms_gprune.c */
 void gms_gprune_init(HMMWork *wrk);
 void gms_gprune_prepare(HMMWork *wrk);
@@ -237,6 +255,7 @@ void dnn_clear(DNNData *dnn);
 void dnn_free(DNNData *dnn);
 boolean dnn_setup(DNNData *dnn, int veclen, int contextlen, int inputnodes, int outputnodes, int hiddennodes, int hiddenlayernum, char **wfile, char **bfile, char *output_wfile, char *output_bfile, char *priorfile, float prior_factor, boolean state_prior_log10nize, int batchsize, int num_threads, char *cuda_mode);
 void dnn_calc_outprob(HMMWork *wrk);
+void dnn_calc_outprob_batch(DNNData *dnn, int num, float **invec, LOGPROB **outcache, int statenum);
 
 /* calc_dnn_*.c */
 void calc_dnn_fma(float *dst, float *src, float *w, float *b, int out, int in, float *fstore);
@@ -108,6 +108,9 @@ typedef struct {
 /// A header qualifier string for V2: has mixture pdf macro def
 #define BINHMM_HEADER_V2_MPDFMACRO 'M'
 
+/// Header string for memory-mappable binary HMM image
+#define BINHMM_HEADER_IMAGE "JBINHMMIMG1"
+
 /// Maximum number of input stream
 #define MAXSTREAMNUM 50
 
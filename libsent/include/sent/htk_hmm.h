@@ -272,6 +272,47 @@ typedef struct {
 } HMM_CDSET_INFO;
 //@}
 
+/**
+ * @ingroup cdset
+ *
+ * @brief Entry of phone context index, keyed by triplet of integers
+ */
+typedef struct {
+  int k1, k2, k3;		///< Key (left context, center, right context)
+  void *data;			///< Pointer to the entry data, NULL if empty
+} HMM_CTX_ENTRY;
+
+/**
+ * @ingroup cdset
+ *
+ * @brief Open-addressing hash table keyed by phone context triplet
+ *
+ * Used to look up a logical %HMM or a pseudo phone set directly from
+ * phone IDs of its left context, center and right context, without
+ * building its name string.
+ */
+typedef struct {
+  HMM_CTX_ENTRY *e;		///< Entries
+  unsigned int size;		///< Allocated number of entries (power of 2)
+  unsigned int num;		///< Number of stored entries
+} HMM_CTX_TABLE;
+
+/**
+ * @ingroup cdset
+ *
+ * @brief Phone context index of logical %HMM and pseudo phone set
+ *
+ * Each phone name appearing in the logical %HMM names is given an
+ * integer ID (starting from 1, 0 means "no context"), and logical %HMMs
+ * and pseudo phone sets are indexed by the ID triplet.
+ */
+typedef struct {
+  boolean enabled;		///< TRUE if the index is available
+  int phnum;			///< Number of phone IDs, including 0
+  HMM_CTX_TABLE lg;		///< Logical %HMM by (lc, c, rc)
+  HMM_CTX_TABLE cd;		///< Pseudo phone set by (lc, c, 0), (0, c, rc) or (0, c, 0)
+} HMM_CTX_INDEX;
+
 /**
  * @ingroup cdset
  *
@@ -297,6 +338,9 @@ typedef struct {
 typedef struct _HMM_logical {
   char *name;			///< Name string of this logical %HMM
   boolean is_pseudo;		///< TRUE if this is mapped to pseudo %HMM
+  int lcid;			///< Phone ID of left context (0 if none)
+  int cid;			///< Phone ID of center phone
+  int rcid;			///< Phone ID of right context (0 if none)
   /// Actual body of state definition
   union {
     HTK_HMM_Data *defined;	///< pointer to the mapped physical %HMM
@@ -375,6 +419,7 @@ typedef struct {
   //@{
   HMM_basephone basephone;	///< Base phone names extracted from logical %HMM
   HMM_CDSET_INFO cdset_info;	///< Context-dependent pseudo phone set
+  HMM_CTX_INDEX ctxindex;	///< Phone context index for logical %HMM and pseudo phone set
   //@}
   
   /**
@@ -415,6 +460,16 @@ typedef struct {
 
   void *hook;			///< General purpose hook
 
+  /**
+   * @name Binary %HMM image (binhmm_image.c)
+   */
+  //@{
+  void *image;			///< Top of the image, NULL if not loaded from image
+  void *image_base;		///< Mapped or allocated area to be released
+  size_t image_size;		///< Size of the image in bytes
+  boolean image_mapped;		///< TRUE if mapped by mmap(), FALSE if read into memory
+  //@}
+
   //@}
 } HTK_HMM_INFO;
 
@@ -496,6 +551,14 @@ HTK_HMM_Data *htk_hmmdata_lookup_physical(HTK_HMM_INFO *, char *);
 HMM_Logical *htk_hmmdata_lookup_logical(HTK_HMM_INFO *, char *);
 void hmm_add_physical_to_logical(HTK_HMM_INFO *);
 void hmm_add_pseudo_phones(HTK_HMM_INFO *hmminfo);
+unsigned int hmm_logical_hash(HTK_HMM_INFO *hmminfo);
+/* hmm_ctxindex.c */
+void ctxtable_init(HMM_CTX_TABLE *t);
+void ctxtable_free(HMM_CTX_TABLE *t);
+void ctxtable_add(HMM_CTX_TABLE *t, int k1, int k2, int k3, void *data);
+void *ctxtable_lookup(HMM_CTX_TABLE *t, int k1, int k2, int k3);
+boolean hmm_ctxindex_build(HTK_HMM_INFO *hmminfo);
+void hmm_ctxindex_free(HTK_HMM_INFO *hmminfo);
 /* chkhmmlist.c */
 void make_hmm_basephone_list(HTK_HMM_INFO *hmminfo);
 
@@ -510,6 +573,8 @@ boolean is_skippable_model(HTK_HMM_Data *d);
 boolean guess_if_cd_hmm(HTK_HMM_INFO *hmm);
 HMM_Logical *get_right_context_HMM(HMM_Logical *base, char *rc_name, HTK_HMM_INFO *hmminfo);
 HMM_Logical *get_left_context_HMM(HMM_Logical *base, char *lc_name, HTK_HMM_INFO *hmminfo);
+HMM_Logical *get_right_context_logical(HMM_Logical *base, HMM_Logical *rc, HTK_HMM_INFO *hmminfo);
+HMM_Logical *get_left_context_logical(HMM_Logical *base, HMM_Logical *lc, HTK_HMM_INFO *hmminfo);
 void add_right_context(char name[], char *rc);
 void add_left_context(char name[], char *lc);
 char *center_name(char *hmmname, char *buf);
@@ -524,6 +589,8 @@ void free_cdset(APATNODE **root, BMALLOC_BASE **mroot);
 CD_Set *cdset_lookup(HTK_HMM_INFO *hmminfo, char *cdstr);
 CD_Set *lcdset_lookup_by_hmmname(HTK_HMM_INFO *hmminfo, char *hmmname);
 CD_Set *rcdset_lookup_by_hmmname(HTK_HMM_INFO *hmminfo, char *hmmname);
+CD_Set *lcdset_lookup_by_logical(HTK_HMM_INFO *hmminfo, HMM_Logical *hmm, HMM_Logical *lc);
+CD_Set *rcdset_lookup_by_logical(HTK_HMM_INFO *hmminfo, HMM_Logical *hmm);
 int hmm_logical_state_num(HMM_Logical *lg);
 HTK_HMM_Trans *hmm_logical_trans(HMM_Logical *lg);
 
@@ -536,6 +603,10 @@ int param_check_and_adjust(HTK_HMM_INFO *hmm, HTK_Param *pinfo, boolean vflag);
 /* binary format */
 boolean write_binhmm(FILE *fp, HTK_HMM_INFO *hmm, Value *para);
 boolean read_binhmm(FILE *fp, HTK_HMM_INFO *hmm, boolean gzfile_p, Value *para);
+boolean write_binhmm_image(FILE *fp, HTK_HMM_INFO *hmm, Value *para);
+boolean is_binhmm_image(char *filename);
+boolean read_binhmm_image(char *filename, HTK_HMM_INFO *hmm, Value *para);
+void binhmm_image_free(HTK_HMM_INFO *hmm);
 
 #ifdef __cplusplus
 }
@@ -140,6 +140,9 @@ typedef struct {
   int B;			///< B coef. for delta computation
 } DeltaBuf;
 
+/// Number of frames computed at once by WMP_calc_block()
+#define WMP_BLOCK 16
+
 /// Work area for MFCC computation
 typedef struct {
   float *bf;			///< Local buffer to hold windowed waveform 
@@ -161,6 +164,10 @@ typedef struct {
   /* sin table for WeightCepstrum */
   double *sintbl_wcep; ///< Sin table for cepstrum weighting
   int sintbl_wcep_len; ///< Length of above
+  /* work area for block computation, allocated at first use */
+  float *blk_re; ///< [fftN][WMP_BLOCK] FFT real part of frames in a block
+  float *blk_im; ///< [fftN][WMP_BLOCK] FFT imaginary part of frames in a block
+  double *blk_fbank; ///< [fbank_num+1][WMP_BLOCK] filterbank of frames in a block
 #endif /* MFCC_SINCOS_TABLE */
   float sqrt2var; ///< Work area that holds value of sqrt(2.0) / fbank_num
   float *ssbuf;			///< Pointer to noise spectrum for SS
@@ -220,6 +227,9 @@ extern "C" {
 /**** mfcc-core.c ****/
 MFCCWork *WMP_work_new(Value *para);
 void WMP_calc(MFCCWork *w, float *mfcc, Value *para);
+#ifdef MFCC_SINCOS_TABLE
+void WMP_calc_block(MFCCWork *w, float **mfcc, Value *para, SP16 *wave, int frame_num);
+#endif
 void WMP_free(MFCCWork *w);
 /* Get filterbank information */
 boolean InitFBank(MFCCWork *w, Value *para);
@@ -187,6 +187,26 @@ typedef struct __ngram_info__ {
 
 } NGRAM_INFO;
 
+/**
+ * @brief Word context resolved for batch N-gram computation
+ *
+ * A word history is resolved once by ngram_context_set() into the
+ * successor tuple range and the back-off weight of each of its suffixes.
+ * Then ngram_prob_batch() computes the probabilities of many words
+ * following the history by scanning the ranges.  Index [j] corresponds
+ * to the context suffix starting at the j-th word, i.e. the (len-j+1)-gram.
+ *
+ */
+typedef struct {
+  int len;			///< Number of context words
+  int maxlen;			///< Allocated length (N-1)
+  WORD_ID last;			///< Last (nearest) context word
+  NNID *left;			///< Beginning tuple ID of successors of each context suffix, or NNID_INVALID if not found or no successor
+  NNID *right;			///< Last tuple ID of successors of each context suffix
+  NNID *pos;			///< Work area to hold current scan point on each range
+  LOGPROB *bo;			///< Back-off weight of each context suffix, 0.0 if not found
+} NGRAM_CONTEXT;
+
 
 /* Definitions for binary N-gram */
 
@@ -229,6 +249,12 @@ LOGPROB ngram_prob(NGRAM_INFO *ndata, int n, WORD_ID *w);
 LOGPROB uni_prob(NGRAM_INFO *ndata, WORD_ID w);
 LOGPROB bi_prob(NGRAM_INFO *ndata, WORD_ID w1, WORD_ID w2);
 void bi_prob_func_set(NGRAM_INFO *ndata);
+void bi_prob_batch(NGRAM_INFO *ndata, WORD_ID w1, WORD_ID *w2, int num, LOGPROB *prob);
+int bi_prob_successor(NGRAM_INFO *ndata, WORD_ID w1, WORD_ID **wlist, LOGPROB **plist, LOGPROB *bo);
+void ngram_context_init(NGRAM_CONTEXT *ctx, NGRAM_INFO *ndata);
+void ngram_context_free(NGRAM_CONTEXT *ctx);
+void ngram_context_set(NGRAM_CONTEXT *ctx, NGRAM_INFO *ndata, WORD_ID *w, int len);
+void ngram_prob_batch(NGRAM_INFO *ndata, NGRAM_CONTEXT *ctx, WORD_ID *w, int num, LOGPROB *prob);
 
 boolean ngram_read_arpa(FILE *fp, NGRAM_INFO *ndata, boolean addition);
 boolean ngram_read_bin(FILE *fp, NGRAM_INFO *ndata);
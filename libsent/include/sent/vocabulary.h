@@ -49,6 +49,18 @@
 /// Memory allocation step in number of words when loading a word dictionary
 #define	MAXWSTEP 4000
 
+/// Identifier string at the top of binary dictionary file
+#define BINDICT_IDSTR "julius_bindict_v1"
+/// Header size of binary dictionary file
+#define BINDICT_HDSIZE 512
+/// Byte order information in the header of binary dictionary
+#define BINDICT_BYTEORDER_HEAD "byteorder="
+#ifdef WORDS_BIGENDIAN
+#define BINDICT_NATURAL_BYTEORDER "BE"
+#else
+#define BINDICT_NATURAL_BYTEORDER "LE"
+#endif
+
 /// Word dictionary structure to hold vocabulary
 typedef struct {
   WORD_ID	maxnum;		///< Allocated number of word space
@@ -110,6 +122,9 @@ boolean voca_load_wordlist(FILE *fp, WORD_INFO *winfo, HTK_HMM_INFO *hmminfo, ch
 boolean voca_load_wordlist_fp(FILE *fp, WORD_INFO *winfo, HTK_HMM_INFO *hmminfo, char *headphone, char *tailphone, char *contextphone);
 boolean voca_load_wordlist_line(char *buf, WORD_ID *vnum, int linenum, WORD_INFO *winfo, HTK_HMM_INFO *hmminfo, boolean do_conv, boolean *ok_flag, char *headphone, char *tailphone, char *contextphone);
 boolean voca_mono2tri(WORD_INFO *winfo, HTK_HMM_INFO *hmminfo);
+boolean voca_is_bin(FILE *fp);
+boolean voca_load_bin(FILE *fp, WORD_INFO *winfo, HTK_HMM_INFO *hmminfo, boolean ignore_tri_conv);
+boolean voca_write_bin(FILE *fp, WORD_INFO *winfo, HTK_HMM_INFO *hmminfo, char *headerstr);
 WORD_ID voca_lookup_wid(char *, WORD_INFO *);
 WORD_ID *new_str2wordseq(WORD_INFO *, char *, int *);
 char *cycle_triphone(char *p);
@@ -0,0 +1,328 @@
+/**
+ * @file   resample.c
+ *
+ * <JA>
+ * @brief  ポリフェーズ FIR による任意有理比のサンプリング周波数変換
+ *
+ * 入力周波数と出力周波数の比を既約分数 L/M とし，L 倍アップサンプル→
+ * 低域通過フィルタ→ 1/M ダウンサンプルを，必要な出力点のみポリフェーズ
+ * 分解したフィルタで計算する. 各位相のフィルタ係数は時間反転して連続に
+ * 格納し，内積計算をベクトル化可能な形で行う.
+ * </JA>
+ * <EN>
+ * @brief  Sampling rate conversion of arbitrary rational ratio by polyphase FIR
+ *
+ * The ratio of output and input rate is reduced to L/M, and the
+ * L-times up sampling, low-pass filtering and 1/M down sampling is
+ * performed only at the output points by the polyphase decomposed
+ * filter.  The coefficients of each phase are stored in reversed
+ * order on a contiguous area, so that the inner product is
+ * vectorized by the compiler.
+ * </EN>
+ *
+ * @author Akinobu LEE
+ * @date   Mon Oct 19 14:20:41 2026
+ *
+ * $Revision: 1.1 $
+ *
+ */
+/*
+ * Copyright (c) 1991-2013 Kawahara Lab., Kyoto University
+ * Copyright (c) 2000-2005 Shikano Lab., Nara Institute of Science and Technology
+ * Copyright (c) 2005-2013 Julius project team, Nagoya Institute of Technology
+ * All rights reserved
+ */
+
+#include <sent/stddefs.h>
+#include <sent/adin.h>
+
+#define RS_ZERO_CROSS 16	///< Number of zero crossings at each side of the filter
+#define RS_ROLLOFF 0.92		///< Pass band edge relative to the Nyquist frequency
+#define RS_KAISER_BETA 8.6	///< Kaiser window parameter (about 85dB stop band)
+#define RS_MAXUP 4096		///< Maximum up sampling factor
+
+/* greatest common divisor */
+static int
+gcd(int a, int b)
+{
+  int c;
+  while (b != 0) {
+    c = a % b;
+    a = b;
+    b = c;
+  }
+  return a;
+}
+
+/* modified Bessel function of order 0 */
+static double
+bessel_i0(double x)
+{
+  double sum, term, y;
+  int k;
+
+  sum = 1.0;
+  term = 1.0;
+  y = x * x / 4.0;
+  for(k=1;k<100;k++) {
+    term *= y / ((double)k * (double)k);
+    sum += term;
+    if (term < sum * 1.0e-12) break;
+  }
+  return sum;
+}
+
+/**
+ * Inner product of the filter and input samples.  The length should
+ * be a multiple of RS_ALIGN, and the fixed-width partial sums are
+ * vectorized by the compiler.
+ *
+ * @param c [in] filter coefficients
+ * @param x [in] input samples
+ * @param len [in] length
+ *
+ * @return the inner product.
+ */
+static float
+fir_dot(float *c, float *x, int len)
+{
+  float acc[RS_ALIGN];
+  float sum;
+  int i, j;
+
+  for(j=0;j<RS_ALIGN;j++) acc[j] = 0.0;
+  for(i=0;i<len;i+=RS_ALIGN) {
+    for(j=0;j<RS_ALIGN;j++) {
+      acc[j] += c[i+j] * x[i+j];
+    }
+  }
+  sum = 0.0;
+  for(j=0;j<RS_ALIGN;j++) sum += acc[j];
+
+  return sum;
+}
+
+/**
+ * <JA>
+ * サンプリング周波数変換器を生成する.
+ *
+ * @param infreq [in] 入力サンプリング周波数 (Hz)
+ * @param outfreq [in] 出力サンプリング周波数 (Hz)
+ *
+ * @return 新たに確保された変換器，比が扱えない場合は NULL
+ * </JA>
+ * <EN>
+ * Create a new sampling rate converter.
+ *
+ * @param infreq [in] input sampling rate in Hz
+ * @param outfreq [in] output sampling rate in Hz
+ *
+ * @return newly allocated converter, or NULL if the ratio is not supported.
+ * </EN>
+ */
+RESAMPLER *
+resample_new(int infreq, int outfreq)
+{
+  RESAMPLER *rs;
+  int g, up, down, taps, len;
+  double fc, center, half, t, h, w;
+  int p, k, j;
+
+  if (infreq <= 0 || outfreq <= 0) {
+    jlog("Error: resample: invalid sampling rate: %d -> %d\n", infreq, outfreq);
+    return NULL;
+  }
+  g = gcd(infreq, outfreq);
+  up = outfreq / g;
+  down = infreq / g;
+  if (up > RS_MAXUP) {
+    jlog("Error: resample: ratio %d/%d too complex for %d -> %d\n", up, down, infreq, outfreq);
+    return NULL;
+  }
+
+  /* cut-off frequency relative to the up-sampled rate */
+  fc = RS_ROLLOFF * 0.5 / (double)(up > down ? up : down);
+  /* taps per phase, covering RS_ZERO_CROSS zero crossings at each side */
+  taps = (int)ceil(2.0 * RS_ZERO_CROSS / (2.0 * fc) / (double)up);
+  taps = (taps + RS_ALIGN - 1) / RS_ALIGN * RS_ALIGN;
+  len = taps * up;
+
+  rs = (RESAMPLER *)mymalloc(sizeof(RESAMPLER));
+  rs->infreq = infreq;
+  rs->outfreq = outfreq;
+  rs->up = up;
+  rs->down = down;
+  rs->taps = taps;
+  rs->coef = (float *)mymalloc(sizeof(float) * len);
+
+  /* windowed sinc, with the gain of up sampling.  The center is put
+     on a sample point so that the delay is an integer */
+  center = (double)((len - 1) / 2);
+  half = (double)len / 2.0;
+  for(p=0;p<up;p++) {
+    for(k=0;k<taps;k++) {
+      /* tap k of phase p is h[p + k * up], stored in reversed order */
+      j = p + k * up;
+      t = (double)j - center;
+      if (t == 0.0) {
+	h = 2.0 * fc;
+      } else {
+	h = sin(2.0 * PI * fc * t) / (PI * t);
+      }
+      w = t / half;
+      w = (w >= 1.0 || w <= -1.0) ? 0.0 : bessel_i0(RS_KAISER_BETA * sqrt(1.0 - w * w)) / bessel_i0(RS_KAISER_BETA);
+      rs->coef[p * taps + (taps - 1 - k)] = h * w * (double)up;
+    }
+  }
+
+  /* input history buffer, starting with zeros before the first sample */
+  rs->xlen = taps * 2;
+  rs->x = (float *)mymalloc(sizeof(float) * rs->xlen);
+  resample_reset(rs);
+
+  jlog("Stat: resample: %d -> %d Hz (%d/%d), %d taps x %d phases\n", infreq, outfreq, up, down, taps, up);
+
+  return rs;
+}
+
+/**
+ * <JA>
+ * 変換器の内部状態を初期化する.
+ *
+ * @param rs [i/o] 変換器
+ * </JA>
+ * <EN>
+ * Reset the internal state of the converter.
+ *
+ * @param rs [i/o] converter
+ * </EN>
+ */
+void
+resample_reset(RESAMPLER *rs)
+{
+  int i;
+
+  rs->hist = rs->taps - 1;
+  for(i=0;i<rs->hist;i++) rs->x[i] = 0.0;
+  /* the first output is at the filter center, to compensate the delay */
+  rs->t = (rs->taps * rs->up - 1) / 2 + (long)(rs->taps - 1) * rs->up;
+}
+
+/**
+ * <JA>
+ * 変換器を解放する.
+ *
+ * @param rs [i/o] 変換器
+ * </JA>
+ * <EN>
+ * Free the converter.
+ *
+ * @param rs [i/o] converter
+ * </EN>
+ */
+void
+resample_free(RESAMPLER *rs)
+{
+  free(rs->x);
+  free(rs->coef);
+  free(rs);
+}
+
+/**
+ * <JA>
+ * 出力が指定長を超えない最大の入力サンプル数を返す.
+ *
+ * @param rs [in] 変換器
+ * @param outlen [in] 出力可能なサンプル数
+ *
+ * @return 入力サンプル数
+ * </JA>
+ * <EN>
+ * Get the maximum number of input samples whose output does not
+ * exceed the given length.
+ *
+ * @param rs [in] converter
+ * @param outlen [in] number of output samples that can be stored
+ *
+ * @return the number of input samples.
+ * </EN>
+ */
+int
+resample_inlen(RESAMPLER *rs, int outlen)
+{
+  long n;
+
+  n = ((long)outlen * rs->down + rs->t) / rs->up - rs->hist;
+  if (n < 0) n = 0;
+  return((int)n);
+}
+
+/**
+ * <JA>
+ * 入力サンプルのサンプリング周波数を変換する. 入力は連続したストリームの
+ * 一部として扱われ，フィルタ遅延分の過去サンプルは次の呼び出しに持ち越される.
+ *
+ * @param dst [out] 変換後のサンプルの格納先
+ * @param src [in] 入力サンプル
+ * @param srclen [in] 入力サンプル数
+ * @param maxdstlen [in] @a dst の最大長
+ * @param rs [i/o] 変換器
+ *
+ * @return @a dst に書き込んだサンプル数，エラー時は -1
+ * </JA>
+ * <EN>
+ * Convert sampling rate of input samples.  The input is treated as a
+ * part of continuous stream, and the past samples needed by the
+ * filter are carried over to the next call.
+ *
+ * @param dst [out] store the resulting samples
+ * @param src [in] input samples
+ * @param srclen [in] number of input samples
+ * @param maxdstlen [in] maximum length of @a dst
+ * @param rs [i/o] converter
+ *
+ * @return the number of samples written to @a dst, or -1 on error.
+ * </EN>
+ */
+int
+resample(SP16 *dst, SP16 *src, int srclen, int maxdstlen, RESAMPLER *rs)
+{
+  int n, i, s, dstlen;
+  long t;
+  float v;
+
+  n = rs->hist + srclen;
+  if (rs->xlen < n) {
+    rs->xlen = n;
+    rs->x = (float *)myrealloc(rs->x, sizeof(float) * rs->xlen);
+  }
+  for(i=0;i<srclen;i++) rs->x[rs->hist + i] = src[i];
+
+  dstlen = 0;
+  t = rs->t;
+  while ((i = t / rs->up) < n) {
+    if (dstlen >= maxdstlen) {
+      jlog("Error: resample: buffer overflow in resampling, inputs may be lost!\n");
+      return -1;
+    }
+    v = fir_dot(&(rs->coef[(t % rs->up) * rs->taps]), &(rs->x[i - rs->taps + 1]), rs->taps);
+    v += (v >= 0.0) ? 0.5 : -0.5;
+    if (v > 32767.0) v = 32767.0;
+    if (v < -32768.0) v = -32768.0;
+    dst[dstlen++] = (SP16)v;
+    t += rs->down;
+  }
+
+  /* drop samples no longer needed by the following outputs */
+  s = t / rs->up - rs->taps + 1;
+  if (s > n) s = n;
+  if (s > 0) {
+    memmove(rs->x, &(rs->x[s]), sizeof(float) * (n - s));
+    t -= (long)s * rs->up;
+    n -= s;
+  }
+  rs->hist = n;
+  rs->t = t;
+
+  return dstlen;
+}
@@ -39,6 +39,10 @@
 #include <sent/stddefs.h>
 #include <sent/adin.h>
 
+#if defined(HAS_SIMD_SSE) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /** 
  * Allocate buffers for zerocross counting.
  *
@@ -102,18 +106,15 @@ free_count_zc_e(ZEROCROSS *zc)
 }
 
 /** 
- * Adding buf[0..step-1] to the cycle buffer and update the count of
- * zero cross.   Also swap them with the oldest ones in the cycle buffer.
- * Also get the maximum level in the cycle buffer.
+ * Sample-by-sample version of count_zc_e(), used when the block
+ * version cannot be applied.
  * 
  * @param zc [i/o] zerocross work area 
- * @param buf [I/O] new samples, will be swapped by old samples when returned.
+ * @param buf [in] new samples
  * @param step [in] length of above.
- * 
- * @return zero-cross count of the samples in the cycle buffer.
  */
-int
-count_zc_e(ZEROCROSS *zc, SP16 *buf, int step)
+static void
+count_zc_e_sample(ZEROCROSS *zc, SP16 *buf, int step)
 {
   int i;
   SP16 tmp, level;
@@ -151,6 +152,221 @@ count_zc_e(ZEROCROSS *zc, SP16 *buf, int step)
     }
   }
   zc->level = (int)level;
+}
+
+/** 
+ * Find the first sample whose absolute level exceeds the trigger.
+ * 
+ * @param buf [in] samples
+ * @param from [in] start point
+ * @param to [in] end point (exclusive)
+ * @param offset [in] DC offset to be added to the samples
+ * @param trigger [in] level threshold, should be in 0..32767
+ * 
+ * @return the found point, or @a to if not found.
+ */
+static int
+zc_find_level(SP16 *buf, int from, int to, int offset, int trigger)
+{
+  int i;
+  SP16 tmp;
+
+  i = from;
+#if defined(HAS_SIMD_SSE) && defined(__SSE2__)
+  {
+    __m128i off = _mm_set1_epi16((short)offset);
+    __m128i hi = _mm_set1_epi16((short)trigger);
+    __m128i lo = _mm_set1_epi16((short)-trigger);
+    __m128i x;
+    for (; i + 8 <= to; i += 8) {
+      x = _mm_add_epi16(_mm_loadu_si128((__m128i *)&(buf[i])), off);
+      if (_mm_movemask_epi8(_mm_or_si128(_mm_cmpgt_epi16(x, hi), _mm_cmplt_epi16(x, lo))) != 0) break;
+    }
+  }
+#endif
+  for (; i < to; i++) {
+    tmp = buf[i] + offset;
+    if (abs(tmp) > trigger) break;
+  }
+  return i;
+}
+
+/** 
+ * Find the first sample whose sign is the opposite of the current one.
+ * 
+ * @param buf [in] samples
+ * @param from [in] start point
+ * @param to [in] end point (exclusive)
+ * @param offset [in] DC offset to be added to the samples
+ * @param sign [in] current sign, ZC_POSITIVE or ZC_NEGATIVE
+ * 
+ * @return the found point, or @a to if not found.
+ */
+static int
+zc_find_cross(SP16 *buf, int from, int to, int offset, int sign)
+{
+  int i;
+  SP16 tmp;
+
+  i = from;
+#if defined(HAS_SIMD_SSE) && defined(__SSE2__)
+  {
+    __m128i off = _mm_set1_epi16((short)offset);
+    __m128i zero = _mm_setzero_si128();
+    __m128i x;
+    if (sign == ZC_POSITIVE) {
+      for (; i + 8 <= to; i += 8) {
+	x = _mm_add_epi16(_mm_loadu_si128((__m128i *)&(buf[i])), off);
+	if (_mm_movemask_epi8(_mm_cmplt_epi16(x, zero)) != 0) break;
+      }
+    } else {
+      for (; i + 8 <= to; i += 8) {
+	x = _mm_add_epi16(_mm_loadu_si128((__m128i *)&(buf[i])), off);
+	if (_mm_movemask_epi8(_mm_cmpgt_epi16(x, zero)) != 0) break;
+      }
+    }
+  }
+#endif
+  if (sign == ZC_POSITIVE) {
+    for (; i < to; i++) {
+      tmp = buf[i] + offset;
+      if (tmp < 0) break;
+    }
+  } else {
+    for (; i < to; i++) {
+      tmp = buf[i] + offset;
+      if (tmp > 0) break;
+    }
+  }
+  return i;
+}
+
+/** 
+ * Get maximum absolute level of samples.
+ * 
+ * @param buf [in] samples
+ * @param step [in] length of above
+ * @param offset [in] DC offset to be added to the samples
+ * @param level_ret [out] maximum absolute level
+ * 
+ * @return TRUE on success, or FALSE when a sample of -32768 is found,
+ * whose level cannot be held in SP16.
+ */
+static boolean
+zc_get_level(SP16 *buf, int step, int offset, int *level_ret)
+{
+  int i;
+  int maxv, minv;
+  SP16 tmp;
+
+  maxv = minv = 0;
+  i = 0;
+#if defined(HAS_SIMD_SSE) && defined(__SSE2__)
+  {
+    __m128i off = _mm_set1_epi16((short)offset);
+    __m128i vmax = _mm_setzero_si128();
+    __m128i vmin = _mm_setzero_si128();
+    __m128i x;
+    short m[8];
+    int k;
+    for (; i + 8 <= step; i += 8) {
+      x = _mm_add_epi16(_mm_loadu_si128((__m128i *)&(buf[i])), off);
+      vmax = _mm_max_epi16(vmax, x);
+      vmin = _mm_min_epi16(vmin, x);
+    }
+    _mm_storeu_si128((__m128i *)m, vmax);
+    for (k=0;k<8;k++) if (maxv < m[k]) maxv = m[k];
+    _mm_storeu_si128((__m128i *)m, vmin);
+    for (k=0;k<8;k++) if (minv > m[k]) minv = m[k];
+  }
+#endif
+  for (; i < step; i++) {
+    tmp = buf[i] + offset;
+    if (maxv < tmp) maxv = tmp;
+    if (minv > tmp) minv = tmp;
+  }
+  if (minv < -32767) return FALSE;
+  *level_ret = (maxv > -minv) ? maxv : -minv;
+  return TRUE;
+}
+
+/** 
+ * Adding buf[0..step-1] to the cycle buffer and update the count of
+ * zero cross.   Also swap them with the oldest ones in the cycle buffer.
+ * Also get the maximum level in the cycle buffer.
+ *
+ * The samples are processed per block: the level is computed over the
+ * whole block, and the zero-cross status is updated by skipping to the
+ * next sample over the level threshold or the next sign change.  The
+ * result is the same as processing them sample by sample.
+ * 
+ * @param zc [i/o] zerocross work area 
+ * @param buf [I/O] new samples, will be swapped by old samples when returned.
+ * @param step [in] length of above.
+ * 
+ * @return zero-cross count of the samples in the cycle buffer.
+ */
+int
+count_zc_e(ZEROCROSS *zc, SP16 *buf, int step)
+{
+  int i, j, k, n;
+  int top;
+  SP16 tmp;
+
+  if (step > zc->length || zc->trigger < 0 || zc->trigger > 32767) {
+    count_zc_e_sample(zc, buf, step);
+    return (zc->zero_cross);
+  }
+
+  /* level */
+  if (zc_get_level(buf, step, zc->offset, &(zc->level)) == FALSE) {
+    count_zc_e_sample(zc, buf, step);
+    return (zc->zero_cross);
+  }
+
+  /* drop old zero-cross marks and store new samples to the cycle buffer */
+  top = zc->top;
+  for (i = 0; i < step; i += n) {
+    k = (top + i) % zc->length;
+    n = zc->length - k;
+    if (n > step - i) n = step - i;
+    if (zc->zero_cross == 0) {
+      /* no mark in the cycle buffer */
+      memset(&(zc->is_zc[k]), 0, sizeof(int) * n);
+    } else {
+      for (j = k; j < k + n; j++) {
+	if (zc->is_zc[j] == TRUE) zc->zero_cross--;
+	zc->is_zc[j] = FALSE;
+      }
+    }
+    memcpy(&(zc->data[k]), &(buf[i]), sizeof(SP16) * n);
+  }
+
+  /* update zero-cross status */
+  i = 0;
+  while (i < step) {
+    if (! zc->is_trig) {
+      /* no zero cross until the level exceeds the threshold */
+      i = zc_find_level(buf, i, step, zc->offset, zc->trigger);
+      if (i >= step) break;
+      zc->is_trig = TRUE;
+    } else {
+      /* next sign change is a zero cross */
+      i = zc_find_cross(buf, i, step, zc->offset, zc->sign);
+      if (i >= step) break;
+      zc->zero_cross++;
+      zc->is_zc[(top + i) % zc->length] = TRUE;
+      zc->sign = (zc->sign == ZC_POSITIVE) ? ZC_NEGATIVE : ZC_POSITIVE;
+      tmp = buf[i] + zc->offset;
+      zc->is_trig = (abs(tmp) > zc->trigger) ? TRUE : FALSE;
+    }
+    i++;
+  }
+
+  top += step;
+  if (zc->valid_len < top) zc->valid_len = (top > zc->length) ? zc->length : top;
+  zc->top = top % zc->length;
+
   return (zc->zero_cross);
 }
 
@@ -147,7 +147,7 @@ rddfa_line(char *line, DFA_INFO *dinfo, int *state_max, int *arc_num, int *termi
   unsigned int status;
   char *p;
 
-  if (strmatch(buf, "DFAEND")) return(FALSE);
+  if (strmatch(line, "DFAEND")) return(FALSE);
   /* format: state terminalID nextstate statuscode_of_state */
   if ((p = strtok(line, DELM)) == NULL) {
     jlog("Error: rddfa: failed to parse, corrupted or invalid data?\n");
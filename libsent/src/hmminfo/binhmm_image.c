@@ -0,0 +1,1018 @@
+/**
+ * @file   binhmm_image.c
+ *
+ * <JA>
+ * @brief  メモリマップ可能なバイナリ %HMM イメージの読み書き
+ *
+ * バイナリ %HMM のもう一つの形式として，ファイルをそのままメモリに
+ * マップして使えるイメージ形式をサポートする. 各定義はファイル先頭からの
+ * オフセットと番号で相互参照され，平均・分散ベクトル，混合重み，遷移確率は
+ * 一つの float プールにまとめて格納される. 平均と分散の各ベクトルは
+ * 8要素 (32バイト) 境界に揃えられている. 分散は常に逆数で保存される.
+ *
+ * 読み込み時はファイルを mmap() し，ベクトル値はマップ領域を直接参照する.
+ * 構造体の生成とリンクのみを行うため，ロードはほぼ解析なしで済み，
+ * 同じモデルを使う複数のプロセス間でページキャッシュが共有される.
+ * mmap() が使えない環境や gzip 圧縮されたファイルでは全体をメモリに
+ * 読み込んで同様に扱う. バイトオーダは作成したマシンのものであり，
+ * 異なる場合は読み込み時に変換する.
+ *
+ * イメージはツール mkbinhmm の "-image" オプションで作成する.
+ * </JA>
+ *
+ * <EN>
+ * @brief  Read / write memory-mappable binary %HMM image
+ *
+ * Besides the stream binary %HMM format, Julius supports an image
+ * format which can be used by mapping the file directly into memory.
+ * All definitions refer to each other by offsets and indices, and
+ * the mean and variance vectors, mixture weights and transition
+ * probabilities are packed into one float pool.  Each mean and
+ * variance vector begins at an 8-element (32 bytes) boundary.
+ * Variances are always stored inverted.
+ *
+ * At loading, the file is mmap()ed and the vector values are
+ * referred to directly in the mapped area.  Only the structures are
+ * allocated and linked, so loading needs almost no parsing, and the
+ * page cache is shared among processes using the same model.  When
+ * mmap() is not available or the file is gzipped, the whole file is
+ * read into memory and used the same way.  The image is written in
+ * the byte order of the machine that made it, and converted at
+ * loading if it differs.
+ *
+ * The tool "mkbinhmm" writes this format with option "-image".
+ * </EN>
+ *
+ * @author Akinobu LEE
+ * @date   Mon Oct 19 20:14:37 2026
+ *
+ * $Revision: 1.1 $
+ *
+ */
+/*
+ * Copyright (c) 2003-2005 Shikano Lab., Nara Institute of Science and Technology
+ * Copyright (c) 2005-2013 Julius project team, Nagoya Institute of Technology
+ * All rights reserved
+ */
+
+#include <sent/stddefs.h>
+#include <sent/htk_param.h>
+#include <sent/htk_hmm.h>
+
+#if !defined(_WIN32) || defined(__CYGWIN32__)
+#define BINHMM_IMAGE_USE_MMAP	///< Map the image file by mmap()
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define IMG_ALIGN 64		///< Alignment of each section in bytes
+#define IMG_VECALIGN 8		///< Alignment of each vector in the float pool, in elements
+#define IMG_NONE 0xffffffff	///< Index value for NULL
+#define IMG_BYTEORDER 0x01020304 ///< Byte order mark, written in native order
+
+#define IMG_FLAG_PARA 0x01	///< Acoustic analysis parameters are embedded
+
+/* section ID */
+#define SEC_STR    0		///< Name strings (num = bytes)
+#define SEC_TRANS  1		///< Transition matrices
+#define SEC_VAR    2		///< Variance vectors
+#define SEC_DENS   3		///< Gaussian densities
+#define SEC_SW     4		///< Stream weights
+#define SEC_TMIX   5		///< Tied-mixture codebooks
+#define SEC_PDF    6		///< Mixture PDFs
+#define SEC_STATE  7		///< States
+#define SEC_DATA   8		///< %HMM models
+#define SEC_ID     9		///< Index lists referred from above
+#define SEC_FLOAT 10		///< Float pool of vectors, weights and transitions
+#define SEC_GCONST 11		///< gconst values per density
+#define SEC_NUM   12		///< Number of sections
+
+/// Section location in the image
+typedef struct {
+  unsigned int offset;		///< Byte offset from the file top
+  unsigned int num;		///< Number of elements
+} IMG_SECTION;
+
+/// Image header.  All members after @a magic are 4-byte words.
+typedef struct {
+  char magic[16];		///< Identifier string
+  unsigned int byteorder;	///< Byte order mark
+  unsigned int filesize;	///< Total size of the image in bytes
+  unsigned int flags;		///< Format flags
+  int stream_num;		///< Number of streams
+  int vsize[MAXSTREAMNUM];	///< Vector size of each stream
+  int vec_size;			///< Total vector size
+  int cov_type;			///< Covariance type
+  int dur_type;			///< Duration type
+  int param_type;		///< Parameter type
+  int is_tied_mixture;		///< TRUE if tied-mixture model
+  int maxmixturenum;		///< Maximum number of mixtures per PDF
+  int smp_period;		///< Embedded analysis parameters from here
+  int smp_freq;
+  int framesize;
+  int frameshift;
+  float preEmph;
+  int lifter;
+  int fbank_num;
+  int delWin;
+  int accWin;
+  float silFloor;
+  float escale;
+  int hipass;
+  int lopass;
+  int enormal;
+  int raw_e;
+  int zmeanframe;
+  int usepower;
+  IMG_SECTION sec[SEC_NUM];	///< Section table
+} IMG_HEADER;
+
+/* records.  "name" is an offset in SEC_STR, list members are offsets
+   in SEC_ID and vector members are offsets in SEC_FLOAT */
+typedef struct { unsigned int name, statenum, a; } IMG_TRANS;
+typedef struct { unsigned int name, len, vec; } IMG_VAR;
+typedef struct { unsigned int name, meanlen, mean, var; } IMG_DENS;
+typedef struct { unsigned int name, len, weight; } IMG_SW;
+typedef struct { unsigned int name, id, num, d; } IMG_TMIX;
+typedef struct { unsigned int name, stream_id, mix_num, tmix, b, bweight; } IMG_PDF;
+typedef struct { unsigned int name, id, nstream, pdf, w; } IMG_STATE;
+typedef struct { unsigned int name, state_num, s, tr; } IMG_DATA;
+
+/// Element size of each section
+static unsigned int sec_unitsize[SEC_NUM] = {
+  1, sizeof(IMG_TRANS), sizeof(IMG_VAR), sizeof(IMG_DENS),
+  sizeof(IMG_SW), sizeof(IMG_TMIX), sizeof(IMG_PDF), sizeof(IMG_STATE),
+  sizeof(IMG_DATA), sizeof(unsigned int), sizeof(float), sizeof(float)
+};
+
+static char *binhmm_header_image = BINHMM_HEADER_IMAGE; ///< Identifier string
+
+/**
+ * Round up to the section alignment.
+ *
+ * @param x [in] byte offset
+ *
+ * @return the aligned offset.
+ */
+static unsigned int
+img_align(unsigned int x)
+{
+  return((x + IMG_ALIGN - 1) & ~(IMG_ALIGN - 1));
+}
+
+/**
+ * Round up vector length to the vector alignment in the float pool.
+ *
+ * @param len [in] vector length
+ *
+ * @return the padded length.
+ */
+static unsigned int
+img_veclen(unsigned int len)
+{
+  return((len + IMG_VECALIGN - 1) & ~(IMG_VECALIGN - 1));
+}
+
+/**********************************************************************/
+/* write */
+/**********************************************************************/
+
+/// Pair of a data pointer and its index, for looking up the index by pointer
+typedef struct {
+  void *p;			///< Data pointer
+  unsigned int id;		///< Index in the section
+} PTRID;
+
+/// Pointer-to-index map of a section
+typedef struct {
+  PTRID *list;			///< Sorted by pointer
+  unsigned int num;		///< Length of @a list
+} PTRMAP;
+
+static int
+ptrid_cmp(PTRID *a, PTRID *b)
+{
+  if (a->p < b->p) return -1;
+  if (a->p > b->p) return 1;
+  return 0;
+}
+
+/**
+ * Make a pointer-to-index map from an array of pointers.
+ *
+ * @param map [out] map to build
+ * @param ptrs [in] data pointers, whose array index will be the index
+ * @param num [in] length of @a ptrs
+ */
+static void
+ptrmap_make(PTRMAP *map, void **ptrs, unsigned int num)
+{
+  unsigned int i;
+
+  map->num = num;
+  map->list = NULL;
+  if (num == 0) return;
+  map->list = (PTRID *)mymalloc(sizeof(PTRID) * num);
+  for(i=0;i<num;i++) {
+    map->list[i].p = ptrs[i];
+    map->list[i].id = i;
+  }
+  qsort(map->list, num, sizeof(PTRID), (int (*)(const void *, const void *))ptrid_cmp);
+}
+
+/**
+ * Look up the index of a data pointer.
+ *
+ * @param map [in] map built by ptrmap_make()
+ * @param p [in] data pointer to look up
+ *
+ * @return the index, or IMG_NONE if @a p is NULL or not found.
+ */
+static unsigned int
+ptrmap_lookup(PTRMAP *map, void *p)
+{
+  PTRID key, *ret;
+
+  if (p == NULL || map->num == 0) return IMG_NONE;
+  key.p = p;
+  ret = (PTRID *)bsearch(&key, map->list, map->num, sizeof(PTRID), (int (*)(const void *, const void *))ptrid_cmp);
+  if (ret == NULL) return IMG_NONE;
+  return(ret->id);
+}
+
+static void
+ptrmap_free(PTRMAP *map)
+{
+  if (map->list) free(map->list);
+}
+
+static GCODEBOOK **tm_list;	///< Work area to gather codebooks
+static unsigned int tm_idx;	///< Current index in @a tm_list
+
+static void
+tmix_list_callback(void *p)
+{
+  tm_list[tm_idx++] = (GCODEBOOK *)p;
+}
+
+/// Work area for building an image
+typedef struct {
+  char *buf;			///< Image buffer
+  IMG_HEADER *h;		///< Header in @a buf
+  unsigned int strlen;		///< Current length of string pool
+  unsigned int idlen;		///< Current length of index pool
+  unsigned int fltlen;		///< Current length of float pool
+} IMG_BUILD;
+
+static unsigned int
+put_str(IMG_BUILD *b, char *s)
+{
+  unsigned int off;
+  int len;
+
+  if (s == NULL) return IMG_NONE;
+  len = strlen(s) + 1;
+  off = b->strlen;
+  memcpy(b->buf + b->h->sec[SEC_STR].offset + off, s, len);
+  b->strlen += len;
+  return(off);
+}
+
+static unsigned int
+put_float(IMG_BUILD *b, float *v, unsigned int len, boolean inverse)
+{
+  unsigned int off, i;
+  float *dst;
+
+  off = b->fltlen;
+  dst = (float *)(b->buf + b->h->sec[SEC_FLOAT].offset) + off;
+  if (inverse) {
+    for(i=0;i<len;i++) dst[i] = 1.0 / v[i];
+  } else {
+    memcpy(dst, v, sizeof(float) * len);
+  }
+  b->fltlen += img_veclen(len);
+  return(off);
+}
+
+static unsigned int *
+put_id(IMG_BUILD *b, unsigned int len, unsigned int *off_ret)
+{
+  unsigned int *dst;
+
+  *off_ret = b->idlen;
+  dst = (unsigned int *)(b->buf + b->h->sec[SEC_ID].offset) + b->idlen;
+  b->idlen += len;
+  return(dst);
+}
+
+/**
+ * Write %HMM definitions in the memory-mappable image format.
+ * Variances are written inverted regardless of the current status.
+ *
+ * @param fp [in] file pointer to write
+ * @param hmm [in] %HMM definition data
+ * @param para [in] acoustic analysis parameters to embed, or NULL
+ *
+ * @return TRUE on success, FALSE on failure.
+ */
+boolean
+write_binhmm_image(FILE *fp, HTK_HMM_INFO *hmm, Value *para)
+{
+  HTK_HMM_Trans *t;
+  HTK_HMM_Var *v;
+  HTK_HMM_Dens *d;
+  HTK_HMM_StreamWeight *sw;
+  HTK_HMM_PDF *m;
+  HTK_HMM_State *s;
+  HTK_HMM_Data *dt;
+  GCODEBOOK *tm;
+  void **ptrs[SEC_NUM];
+  PTRMAP map[SEC_NUM];
+  unsigned int n[SEC_NUM];
+  unsigned int strlen_total, id_total, flt_total;
+  unsigned int off, i, k, *ids;
+  IMG_BUILD b;
+  IMG_HEADER *h;
+  int j;
+
+  /* gather all definitions in list order */
+  for(i=0;i<SEC_NUM;i++) {
+    n[i] = 0;
+    ptrs[i] = NULL;
+  }
+  for(t=hmm->trstart;t;t=t->next) n[SEC_TRANS]++;
+  for(v=hmm->vrstart;v;v=v->next) n[SEC_VAR]++;
+  for(d=hmm->dnstart;d;d=d->next) n[SEC_DENS]++;
+  for(sw=hmm->swstart;sw;sw=sw->next) n[SEC_SW]++;
+  n[SEC_TMIX] = hmm->codebooknum;
+  for(m=hmm->pdfstart;m;m=m->next) n[SEC_PDF]++;
+  for(s=hmm->ststart;s;s=s->next) n[SEC_STATE]++;
+  for(dt=hmm->start;dt;dt=dt->next) n[SEC_DATA]++;
+  for(i=SEC_TRANS;i<=SEC_DATA;i++) {
+    ptrs[i] = (void **)mymalloc(sizeof(void *) * (n[i] + 1));
+  }
+  strlen_total = id_total = flt_total = 0;
+  k = 0;
+  for(t=hmm->trstart;t;t=t->next) {
+    ptrs[SEC_TRANS][k++] = t;
+    if (t->name) strlen_total += strlen(t->name) + 1;
+    flt_total += img_veclen(t->statenum * t->statenum);
+  }
+  k = 0;
+  for(v=hmm->vrstart;v;v=v->next) {
+    ptrs[SEC_VAR][k++] = v;
+    if (v->name) strlen_total += strlen(v->name) + 1;
+    flt_total += img_veclen(v->len);
+  }
+  k = 0;
+  for(d=hmm->dnstart;d;d=d->next) {
+    ptrs[SEC_DENS][k++] = d;
+    if (d->name) strlen_total += strlen(d->name) + 1;
+    flt_total += img_veclen(d->meanlen);
+  }
+  k = 0;
+  for(sw=hmm->swstart;sw;sw=sw->next) {
+    ptrs[SEC_SW][k++] = sw;
+    if (sw->name) strlen_total += strlen(sw->name) + 1;
+    flt_total += img_veclen(sw->len);
+  }
+  if (n[SEC_TMIX] > 0) {
+    tm_list = (GCODEBOOK **)ptrs[SEC_TMIX];
+    tm_idx = 0;
+    aptree_traverse_and_do(hmm->codebook_root, tmix_list_callback);
+    for(k=0;k<n[SEC_TMIX];k++) {
+      tm = tm_list[k];
+      if (tm->name) strlen_total += strlen(tm->name) + 1;
+      id_total += tm->num;
+    }
+  }
+  k = 0;
+  for(m=hmm->pdfstart;m;m=m->next) {
+    ptrs[SEC_PDF][k++] = m;
+    if (m->name) strlen_total += strlen(m->name) + 1;
+    if (! m->tmix) id_total += m->mix_num;
+    flt_total += img_veclen(m->mix_num);
+  }
+  k = 0;
+  for(s=hmm->ststart;s;s=s->next) {
+    ptrs[SEC_STATE][k++] = s;
+    if (s->name) strlen_total += strlen(s->name) + 1;
+    id_total += s->nstream;
+  }
+  k = 0;
+  for(dt=hmm->start;dt;dt=dt->next) {
+    ptrs[SEC_DATA][k++] = dt;
+    if (dt->name) strlen_total += strlen(dt->name) + 1;
+    id_total += dt->state_num;
+  }
+  for(i=SEC_TRANS;i<=SEC_DATA;i++) {
+    ptrmap_make(&(map[i]), ptrs[i], n[i]);
+  }
+  n[SEC_STR] = strlen_total;
+  n[SEC_ID] = id_total;
+  n[SEC_FLOAT] = flt_total;
+  n[SEC_GCONST] = n[SEC_DENS];
+
+  /* lay out sections */
+  b.buf = NULL;
+  off = img_align(sizeof(IMG_HEADER));
+  {
+    IMG_SECTION sec[SEC_NUM];
+    for(i=0;i<SEC_NUM;i++) {
+      sec[i].offset = off;
+      sec[i].num = n[i];
+      off = img_align(off + n[i] * sec_unitsize[i]);
+    }
+    b.buf = (char *)mymalloc(off);
+    memset(b.buf, 0, off);
+    h = b.h = (IMG_HEADER *)b.buf;
+    memcpy(h->sec, sec, sizeof(IMG_SECTION) * SEC_NUM);
+  }
+  b.strlen = b.idlen = b.fltlen = 0;
+
+  /* header */
+  strncpy(h->magic, binhmm_header_image, sizeof(h->magic));
+  h->byteorder = IMG_BYTEORDER;
+  h->filesize = off;
+  h->flags = 0;
+  h->stream_num = hmm->opt.stream_info.num;
+  for(j=0;j<MAXSTREAMNUM;j++) h->vsize[j] = hmm->opt.stream_info.vsize[j];
+  h->vec_size = hmm->opt.vec_size;
+  h->cov_type = hmm->opt.cov_type;
+  h->dur_type = hmm->opt.dur_type;
+  h->param_type = hmm->opt.param_type;
+  h->is_tied_mixture = hmm->is_tied_mixture;
+  h->maxmixturenum = hmm->maxmixturenum;
+  if (para) {
+    h->flags |= IMG_FLAG_PARA;
+    h->smp_period = para->smp_period;
+    h->smp_freq = para->smp_freq;
+    h->framesize = para->framesize;
+    h->frameshift = para->frameshift;
+    h->preEmph = para->preEmph;
+    h->lifter = para->lifter;
+    h->fbank_num = para->fbank_num;
+    h->delWin = para->delWin;
+    h->accWin = para->accWin;
+    h->silFloor = para->silFloor;
+    h->escale = para->escale;
+    h->hipass = para->hipass;
+    h->lopass = para->lopass;
+    h->enormal = para->enormal;
+    h->raw_e = para->raw_e;
+    h->zmeanframe = para->zmeanframe;
+    h->usepower = para->usepower;
+  }
+
+  /* records */
+  for(k=0;k<n[SEC_TRANS];k++) {
+    IMG_TRANS *r = (IMG_TRANS *)(b.buf + h->sec[SEC_TRANS].offset) + k;
+    float *dst;
+    t = ptrs[SEC_TRANS][k];
+    r->name = put_str(&b, t->name);
+    r->statenum = t->statenum;
+    /* rows of a transition matrix may not be contiguous */
+    r->a = b.fltlen;
+    dst = (float *)(b.buf + h->sec[SEC_FLOAT].offset) + b.fltlen;
+    for(j=0;j<t->statenum;j++) {
+      memcpy(&(dst[j * t->statenum]), t->a[j], sizeof(PROB) * t->statenum);
+    }
+    b.fltlen += img_veclen(t->statenum * t->statenum);
+  }
+  for(k=0;k<n[SEC_VAR];k++) {
+    IMG_VAR *r = (IMG_VAR *)(b.buf + h->sec[SEC_VAR].offset) + k;
+    v = ptrs[SEC_VAR][k];
+    r->name = put_str(&b, v->name);
+    r->len = v->len;
+    r->vec = put_float(&b, v->vec, v->len, hmm->variance_inversed ? FALSE : TRUE);
+  }
+  for(k=0;k<n[SEC_DENS];k++) {
+    IMG_DENS *r = (IMG_DENS *)(b.buf + h->sec[SEC_DENS].offset) + k;
+    d = ptrs[SEC_DENS][k];
+    r->name = put_str(&b, d->name);
+    r->meanlen = d->meanlen;
+    r->mean = put_float(&b, d->mean, d->meanlen, FALSE);
+    r->var = ptrmap_lookup(&(map[SEC_VAR]), d->var);
+    ((float *)(b.buf + h->sec[SEC_GCONST].offset))[k] = d->gconst;
+  }
+  for(k=0;k<n[SEC_SW];k++) {
+    IMG_SW *r = (IMG_SW *)(b.buf + h->sec[SEC_SW].offset) + k;
+    sw = ptrs[SEC_SW][k];
+    r->name = put_str(&b, sw->name);
+    r->len = sw->len;
+    r->weight = put_float(&b, sw->weight, sw->len, FALSE);
+  }
+  for(k=0;k<n[SEC_TMIX];k++) {
+    IMG_TMIX *r = (IMG_TMIX *)(b.buf + h->sec[SEC_TMIX].offset) + k;
+    tm = ptrs[SEC_TMIX][k];
+    r->name = put_str(&b, tm->name);
+    r->id = tm->id;
+    r->num = tm->num;
+    ids = put_id(&b, tm->num, &(r->d));
+    for(j=0;j<tm->num;j++) ids[j] = ptrmap_lookup(&(map[SEC_DENS]), tm->d[j]);
+  }
+  for(k=0;k<n[SEC_PDF];k++) {
+    IMG_PDF *r = (IMG_PDF *)(b.buf + h->sec[SEC_PDF].offset) + k;
+    m = ptrs[SEC_PDF][k];
+    r->name = put_str(&b, m->name);
+    r->stream_id = m->stream_id;
+    r->mix_num = m->mix_num;
+    if (m->tmix) {
+      r->tmix = ptrmap_lookup(&(map[SEC_TMIX]), m->b);
+      r->b = IMG_NONE;
+    } else {
+      r->tmix = IMG_NONE;
+      ids = put_id(&b, m->mix_num, &(r->b));
+      for(j=0;j<m->mix_num;j++) ids[j] = ptrmap_lookup(&(map[SEC_DENS]), m->b[j]);
+    }
+    r->bweight = put_float(&b, m->bweight, m->mix_num, FALSE);
+  }
+  for(k=0;k<n[SEC_STATE];k++) {
+    IMG_STATE *r = (IMG_STATE *)(b.buf + h->sec[SEC_STATE].offset) + k;
+    s = ptrs[SEC_STATE][k];
+    r->name = put_str(&b, s->name);
+    r->id = s->id;
+    r->nstream = s->nstream;
+    ids = put_id(&b, s->nstream, &(r->pdf));
+    for(j=0;j<s->nstream;j++) ids[j] = ptrmap_lookup(&(map[SEC_PDF]), s->pdf[j]);
+    r->w = ptrmap_lookup(&(map[SEC_SW]), s->w);
+  }
+  for(k=0;k<n[SEC_DATA];k++) {
+    IMG_DATA *r = (IMG_DATA *)(b.buf + h->sec[SEC_DATA].offset) + k;
+    dt = ptrs[SEC_DATA][k];
+    r->name = put_str(&b, dt->name);
+    r->state_num = dt->state_num;
+    ids = put_id(&b, dt->state_num, &(r->s));
+    for(j=0;j<dt->state_num;j++) ids[j] = ptrmap_lookup(&(map[SEC_STATE]), dt->s[j]);
+    r->tr = ptrmap_lookup(&(map[SEC_TRANS]), dt->tr);
+  }
+
+  for(i=SEC_TRANS;i<=SEC_DATA;i++) {
+    ptrmap_free(&(map[i]));
+    free(ptrs[i]);
+  }
+
+  if (myfwrite(b.buf, 1, h->filesize, fp) < h->filesize) {
+    jlog("Error: binhmm_image: failed to write %u bytes\n", h->filesize);
+    free(b.buf);
+    return FALSE;
+  }
+  jlog("Stat: binhmm_image: %u bytes written (%u trans, %u var, %u dens, %u pdf, %u state, %u model)\n", h->filesize, n[SEC_TRANS], n[SEC_VAR], n[SEC_DENS], n[SEC_PDF], n[SEC_STATE], n[SEC_DATA]);
+  free(b.buf);
+
+  return TRUE;
+}
+
+/**********************************************************************/
+/* read */
+/**********************************************************************/
+
+#define IMG_CHECK(A) if (!(A)) { jlog("Error: binhmm_image: broken image: %s\n", #A); return FALSE; }
+
+/**
+ * Check if the file is a binary %HMM image by the identifier at the top.
+ *
+ * @param filename [in] file name
+ *
+ * @return TRUE if the file is a binary %HMM image, FALSE if not.
+ */
+boolean
+is_binhmm_image(char *filename)
+{
+  FILE *fp;
+  char buf[sizeof(BINHMM_HEADER_IMAGE)];
+  boolean ret;
+
+  if ((fp = fopen_readfile(filename)) == NULL) return FALSE;
+  ret = FALSE;
+  if (myfread(buf, 1, sizeof(BINHMM_HEADER_IMAGE), fp) == sizeof(BINHMM_HEADER_IMAGE)) {
+    if (strnmatch(buf, binhmm_header_image, sizeof(BINHMM_HEADER_IMAGE))) ret = TRUE;
+  }
+  fclose_readfile(fp);
+
+  return(ret);
+}
+
+#ifdef BINHMM_IMAGE_USE_MMAP
+/**
+ * Map the image file into memory.
+ *
+ * @param filename [in] file name
+ * @param hmm [out] mapped area will be stored
+ *
+ * @return TRUE if mapped with valid header in native byte order, FALSE
+ * if not.
+ */
+static boolean
+image_map(char *filename, HTK_HMM_INFO *hmm)
+{
+  int fd;
+  struct stat st;
+  void *p;
+  IMG_HEADER *h;
+
+  if ((fd = open(filename, O_RDONLY)) < 0) return FALSE;
+  if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(IMG_HEADER)) {
+    close(fd);
+    return FALSE;
+  }
+  p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return FALSE;
+  h = (IMG_HEADER *)p;
+  if (! strnmatch(h->magic, binhmm_header_image, sizeof(BINHMM_HEADER_IMAGE))
+      || h->byteorder != IMG_BYTEORDER
+      || h->filesize != (unsigned int)st.st_size) {
+    /* gzipped, or needs byte swapping */
+    munmap(p, st.st_size);
+    return FALSE;
+  }
+  hmm->image = p;
+  hmm->image_base = p;
+  hmm->image_size = st.st_size;
+  hmm->image_mapped = TRUE;
+
+  return TRUE;
+}
+#endif
+
+/**
+ * Read the whole image file into an aligned memory area, with byte
+ * swapping if needed.
+ *
+ * @param filename [in] file name
+ * @param hmm [out] read area will be stored
+ *
+ * @return TRUE on success, FALSE on failure.
+ */
+static boolean
+image_read(char *filename, HTK_HMM_INFO *hmm)
+{
+  FILE *fp;
+  IMG_HEADER hd, *h;
+  boolean need_swap;
+  char *p;
+  unsigned int i;
+
+  if ((fp = fopen_readfile(filename)) == NULL) return FALSE;
+  if (myfread(&hd, sizeof(IMG_HEADER), 1, fp) < 1) {
+    jlog("Error: binhmm_image: failed to read header\n");
+    fclose_readfile(fp);
+    return FALSE;
+  }
+  need_swap = FALSE;
+  if (hd.byteorder != IMG_BYTEORDER) {
+    swap_bytes((char *)&(hd.byteorder), sizeof(unsigned int), 1);
+    if (hd.byteorder != IMG_BYTEORDER) {
+      jlog("Error: binhmm_image: unknown byte order mark\n");
+      fclose_readfile(fp);
+      return FALSE;
+    }
+    need_swap = TRUE;
+    swap_bytes((char *)&(hd.filesize), sizeof(unsigned int), 1);
+  }
+  if (hd.filesize < sizeof(IMG_HEADER)) {
+    jlog("Error: binhmm_image: broken header\n");
+    fclose_readfile(fp);
+    return FALSE;
+  }
+  hmm->image_base = mymalloc(hd.filesize + IMG_ALIGN);
+  p = (char *)(((size_t)hmm->image_base + IMG_ALIGN - 1) & ~((size_t)IMG_ALIGN - 1));
+  memcpy(p, &hd, sizeof(IMG_HEADER));
+  hmm->image = p;
+  hmm->image_size = hd.filesize;
+  hmm->image_mapped = FALSE;
+  if (myfread(p + sizeof(IMG_HEADER), 1, hd.filesize - sizeof(IMG_HEADER), fp) < hd.filesize - sizeof(IMG_HEADER)) {
+    jlog("Error: binhmm_image: failed to read %u bytes\n", hd.filesize);
+    fclose_readfile(fp);
+    return FALSE;
+  }
+  if (fclose_readfile(fp) < 0) return FALSE;
+
+  if (need_swap) {
+    h = (IMG_HEADER *)p;
+    /* all members but magic, byteorder and filesize */
+    swap_bytes((char *)&(h->flags), sizeof(unsigned int), (sizeof(IMG_HEADER) - ((char *)&(h->flags) - (char *)h)) / sizeof(unsigned int));
+    /* every section except strings consists of 4-byte words */
+    for(i=SEC_TRANS;i<SEC_NUM;i++) {
+      IMG_CHECK(h->sec[i].offset + (size_t)h->sec[i].num * sec_unitsize[i] <= h->filesize);
+      swap_bytes(p + h->sec[i].offset, sizeof(unsigned int), h->sec[i].num * sec_unitsize[i] / sizeof(unsigned int));
+    }
+    jlog("Stat: binhmm_image: byte order converted\n");
+  }
+
+  return TRUE;
+}
+
+/**
+ * Release the image area of %HMM definition.
+ *
+ * @param hmm [i/o] %HMM definition data
+ */
+void
+binhmm_image_free(HTK_HMM_INFO *hmm)
+{
+  if (hmm->image_base == NULL) return;
+#ifdef BINHMM_IMAGE_USE_MMAP
+  if (hmm->image_mapped) {
+    munmap(hmm->image_base, hmm->image_size);
+  } else {
+    free(hmm->image_base);
+  }
+#else
+  free(hmm->image_base);
+#endif
+  hmm->image = hmm->image_base = NULL;
+  hmm->image_size = 0;
+}
+
+/**
+ * Read a memory-mappable binary %HMM image.  The vectors of the
+ * resulting %HMM definition refer to the image, which is kept until
+ * hmminfo_free().
+ *
+ * @param filename [in] file name
+ * @param hmm [out] %HMM definition data to store
+ * @param para [out] embedded acoustic analysis parameters will be stored
+ *
+ * @return TRUE on success, FALSE on failure.
+ */
+boolean
+read_binhmm_image(char *filename, HTK_HMM_INFO *hmm, Value *para)
+{
+  char *img, *str;
+  IMG_HEADER *h;
+  IMG_SECTION *sec;
+  unsigned int *idpool;
+  float *flt;
+  void **ptrpool;
+  HTK_HMM_Trans *t;
+  HTK_HMM_Var *v;
+  HTK_HMM_Dens *d;
+  HTK_HMM_StreamWeight *sw;
+  GCODEBOOK *tm;
+  HTK_HMM_PDF *m;
+  HTK_HMM_State *s;
+  HTK_HMM_Data *dt;
+  PROB **rows;
+  unsigned int i, k, x, rownum;
+  int j;
+
+  hmm->image_base = NULL;
+#ifdef BINHMM_IMAGE_USE_MMAP
+  if (image_map(filename, hmm) == FALSE) {
+    if (image_read(filename, hmm) == FALSE) return FALSE;
+  }
+#else
+  if (image_read(filename, hmm) == FALSE) return FALSE;
+#endif
+  img = hmm->image;
+  h = (IMG_HEADER *)img;
+  sec = h->sec;
+
+  jlog("Stat: binhmm_image: %s binary HMM image (%u bytes)\n", hmm->image_mapped ? "mapped" : "loaded", hmm->image_size);
+
+  /* check section boundaries */
+  for(i=0;i<SEC_NUM;i++) {
+    IMG_CHECK(sec[i].offset % IMG_ALIGN == 0);
+    IMG_CHECK(sec[i].offset + (size_t)sec[i].num * sec_unitsize[i] <= h->filesize);
+  }
+  str = img + sec[SEC_STR].offset;
+  IMG_CHECK(sec[SEC_STR].num == 0 || str[sec[SEC_STR].num - 1] == '\0');
+  idpool = (unsigned int *)(img + sec[SEC_ID].offset);
+  flt = (float *)(img + sec[SEC_FLOAT].offset);
+#define IMG_NAME(A) (((A) == IMG_NONE) ? NULL : str + (A))
+#define IMG_NAME_CHECK(A) IMG_CHECK((A) == IMG_NONE || (A) < sec[SEC_STR].num)
+#define IMG_ID_CHECK(A,B) IMG_CHECK((A) <= sec[SEC_ID].num && (B) <= sec[SEC_ID].num - (A))
+#define IMG_FLT_CHECK(A,B) IMG_CHECK((A) <= sec[SEC_FLOAT].num && (B) <= sec[SEC_FLOAT].num - (A))
+
+  /* options */
+  hmm->opt.stream_info.num = h->stream_num;
+  for(j=0;j<MAXSTREAMNUM;j++) hmm->opt.stream_info.vsize[j] = h->vsize[j];
+  hmm->opt.vec_size = h->vec_size;
+  hmm->opt.cov_type = h->cov_type;
+  hmm->opt.dur_type = h->dur_type;
+  hmm->opt.param_type = h->param_type;
+  hmm->is_tied_mixture = h->is_tied_mixture;
+  hmm->maxmixturenum = h->maxmixturenum;
+  hmm->variance_inversed = TRUE;
+  if (h->flags & IMG_FLAG_PARA) {
+    para->loaded = 1;
+    para->smp_period = h->smp_period;
+    para->smp_freq = h->smp_freq;
+    para->framesize = h->framesize;
+    para->frameshift = h->frameshift;
+    para->preEmph = h->preEmph;
+    para->lifter = h->lifter;
+    para->fbank_num = h->fbank_num;
+    para->delWin = h->delWin;
+    para->accWin = h->accWin;
+    para->silFloor = h->silFloor;
+    para->escale = h->escale;
+    para->hipass = h->hipass;
+    para->lopass = h->lopass;
+    para->enormal = h->enormal;
+    para->raw_e = h->raw_e;
+    para->zmeanframe = h->zmeanframe;
+    para->usepower = h->usepower;
+    jlog("Stat: binhmm_image: has acoutic analysis configurations in its header\n");
+  }
+
+  /* all pointer lists share the layout of index pool */
+  ptrpool = (void **)mybmalloc2(sizeof(void *) * (sec[SEC_ID].num + 1), &(hmm->mroot));
+
+  /* each definition list is built backward to keep the original order */
+
+  /* transition matrices */
+  rownum = 0;
+  for(k=0;k<sec[SEC_TRANS].num;k++) {
+    rownum += ((IMG_TRANS *)(img + sec[SEC_TRANS].offset))[k].statenum;
+  }
+  t = (HTK_HMM_Trans *)mybmalloc2(sizeof(HTK_HMM_Trans) * (sec[SEC_TRANS].num + 1), &(hmm->mroot));
+  rows = (PROB **)mybmalloc2(sizeof(PROB *) * (rownum + 1), &(hmm->mroot));
+  hmm->trstart = NULL;
+  hmm->tr_root = NULL;
+  for(k=sec[SEC_TRANS].num;k-->0;) {
+    IMG_TRANS *r = (IMG_TRANS *)(img + sec[SEC_TRANS].offset) + k;
+    IMG_NAME_CHECK(r->name);
+    IMG_FLT_CHECK(r->a, r->statenum * r->statenum);
+    t[k].name = IMG_NAME(r->name);
+    t[k].statenum = r->statenum;
+    rownum -= r->statenum;
+    t[k].a = &(rows[rownum]);
+    for(j=0;j<t[k].statenum;j++) t[k].a[j] = &(flt[r->a + j * r->statenum]);
+    trans_add(hmm, &(t[k]));
+  }
+
+  /* variances */
+  v = (HTK_HMM_Var *)mybmalloc2(sizeof(HTK_HMM_Var) * (sec[SEC_VAR].num + 1), &(hmm->mroot));
+  hmm->vrstart = NULL;
+  hmm->vr_root = NULL;
+  for(k=sec[SEC_VAR].num;k-->0;) {
+    IMG_VAR *r = (IMG_VAR *)(img + sec[SEC_VAR].offset) + k;
+    IMG_NAME_CHECK(r->name);
+    IMG_FLT_CHECK(r->vec, r->len);
+    v[k].name = IMG_NAME(r->name);
+    v[k].len = r->len;
+    v[k].vec = &(flt[r->vec]);
+    var_add(hmm, &(v[k]));
+  }
+
+  /* densities */
+  d = (HTK_HMM_Dens *)mybmalloc2(sizeof(HTK_HMM_Dens) * (sec[SEC_DENS].num + 1), &(hmm->mroot));
+  hmm->totalmixnum = sec[SEC_DENS].num;
+  hmm->dnstart = NULL;
+  hmm->dn_root = NULL;
+  IMG_CHECK(sec[SEC_GCONST].num == sec[SEC_DENS].num);
+  for(k=sec[SEC_DENS].num;k-->0;) {
+    IMG_DENS *r = (IMG_DENS *)(img + sec[SEC_DENS].offset) + k;
+    IMG_NAME_CHECK(r->name);
+    IMG_FLT_CHECK(r->mean, r->meanlen);
+    IMG_CHECK(r->var == IMG_NONE || r->var < sec[SEC_VAR].num);
+    d[k].name = IMG_NAME(r->name);
+    d[k].meanlen = r->meanlen;
+    d[k].mean = &(flt[r->mean]);
+    d[k].var = (r->var == IMG_NONE) ? NULL : &(v[r->var]);
+    d[k].gconst = ((float *)(img + sec[SEC_GCONST].offset))[k];
+    dens_add(hmm, &(d[k]));
+  }
+
+  /* stream weights */
+  sw = (HTK_HMM_StreamWeight *)mybmalloc2(sizeof(HTK_HMM_StreamWeight) * (sec[SEC_SW].num + 1), &(hmm->mroot));
+  hmm->swstart = NULL;
+  hmm->sw_root = NULL;
+  for(k=sec[SEC_SW].num;k-->0;) {
+    IMG_SW *r = (IMG_SW *)(img + sec[SEC_SW].offset) + k;
+    IMG_NAME_CHECK(r->name);
+    IMG_FLT_CHECK(r->weight, r->len);
+    sw[k].name = IMG_NAME(r->name);
+    sw[k].len = r->len;
+    sw[k].weight = &(flt[r->weight]);
+    sw_add(hmm, &(sw[k]));
+  }
+
+  /* tied-mixture codebooks */
+  tm = (GCODEBOOK *)mybmalloc2(sizeof(GCODEBOOK) * (sec[SEC_TMIX].num + 1), &(hmm->mroot));
+  hmm->codebooknum = sec[SEC_TMIX].num;
+  hmm->maxcodebooksize = 0;
+  hmm->codebook_root = NULL;
+  for(k=0;k<sec[SEC_TMIX].num;k++) {
+    IMG_TMIX *r = (IMG_TMIX *)(img + sec[SEC_TMIX].offset) + k;
+    IMG_NAME_CHECK(r->name);
+    IMG_ID_CHECK(r->d, r->num);
+    tm[k].name = IMG_NAME(r->name);
+    tm[k].id = r->id;
+    tm[k].num = r->num;
+    if (hmm->maxcodebooksize < tm[k].num) hmm->maxcodebooksize = tm[k].num;
+    tm[k].d = (HTK_HMM_Dens **)&(ptrpool[r->d]);
+    for(j=0;j<tm[k].num;j++) {
+      x = idpool[r->d + j];
+      IMG_CHECK(x == IMG_NONE || x < sec[SEC_DENS].num);
+      tm[k].d[j] = (x == IMG_NONE) ? NULL : &(d[x]);
+    }
+    codebook_add(hmm, &(tm[k]));
+  }
+
+  /* mixture PDFs */
+  m = (HTK_HMM_PDF *)mybmalloc2(sizeof(HTK_HMM_PDF) * (sec[SEC_PDF].num + 1), &(hmm->mroot));
+  hmm->totalpdfnum = sec[SEC_PDF].num;
+  hmm->pdfstart = NULL;
+  hmm->pdf_root = NULL;
+  for(k=sec[SEC_PDF].num;k-->0;) {
+    IMG_PDF *r = (IMG_PDF *)(img + sec[SEC_PDF].offset) + k;
+    IMG_NAME_CHECK(r->name);
+    IMG_FLT_CHECK(r->bweight, r->mix_num);
+    m[k].name = IMG_NAME(r->name);
+    m[k].stream_id = r->stream_id;
+    m[k].mix_num = r->mix_num;
+    if (r->tmix != IMG_NONE) {
+      IMG_CHECK(r->tmix < sec[SEC_TMIX].num);
+      m[k].b = (HTK_HMM_Dens **)&(tm[r->tmix]);
+      m[k].tmix = TRUE;
+    } else {
+      IMG_ID_CHECK(r->b, r->mix_num);
+      m[k].b = (HTK_HMM_Dens **)&(ptrpool[r->b]);
+      for(j=0;j<m[k].mix_num;j++) {
+	x = idpool[r->b + j];
+	IMG_CHECK(x == IMG_NONE || x < sec[SEC_DENS].num);
+	m[k].b[j] = (x == IMG_NONE) ? NULL : &(d[x]);
+      }
+      m[k].tmix = FALSE;
+    }
+    m[k].bweight = &(flt[r->bweight]);
+    mpdf_add(hmm, &(m[k]));
+  }
+
+  /* states */
+  s = (HTK_HMM_State *)mybmalloc2(sizeof(HTK_HMM_State) * (sec[SEC_STATE].num + 1), &(hmm->mroot));
+  hmm->totalstatenum = sec[SEC_STATE].num;
+  hmm->ststart = NULL;
+  hmm->st_root = NULL;
+  for(k=sec[SEC_STATE].num;k-->0;) {
+    IMG_STATE *r = (IMG_STATE *)(img + sec[SEC_STATE].offset) + k;
+    IMG_NAME_CHECK(r->name);
+    IMG_ID_CHECK(r->pdf, r->nstream);
+    IMG_CHECK(r->w == IMG_NONE || r->w < sec[SEC_SW].num);
+    s[k].name = IMG_NAME(r->name);
+    s[k].id = r->id;
+    s[k].nstream = r->nstream;
+    s[k].pdf = (HTK_HMM_PDF **)&(ptrpool[r->pdf]);
+    for(j=0;j<s[k].nstream;j++) {
+      x = idpool[r->pdf + j];
+      IMG_CHECK(x == IMG_NONE || x < sec[SEC_PDF].num);
+      s[k].pdf[j] = (x == IMG_NONE) ? NULL : &(m[x]);
+    }
+    s[k].w = (r->w == IMG_NONE) ? NULL : &(sw[r->w]);
+    state_add(hmm, &(s[k]));
+  }
+
+  /* models */
+  dt = (HTK_HMM_Data *)mybmalloc2(sizeof(HTK_HMM_Data) * (sec[SEC_DATA].num + 1), &(hmm->mroot));
+  hmm->totalhmmnum = sec[SEC_DATA].num;
+  hmm->maxstatenum = 0;
+  hmm->start = NULL;
+  hmm->physical_root = NULL;
+  for(k=sec[SEC_DATA].num;k-->0;) {
+    IMG_DATA *r = (IMG_DATA *)(img + sec[SEC_DATA].offset) + k;
+    IMG_NAME_CHECK(r->name);
+    IMG_ID_CHECK(r->s, r->state_num);
+    IMG_CHECK(r->tr < sec[SEC_TRANS].num);
+    dt[k].name = IMG_NAME(r->name);
+    dt[k].state_num = r->state_num;
+    if (hmm->maxstatenum < dt[k].state_num) hmm->maxstatenum = dt[k].state_num;
+    dt[k].s = (HTK_HMM_State **)&(ptrpool[r->s]);
+    for(j=0;j<dt[k].state_num;j++) {
+      x = idpool[r->s + j];
+      IMG_CHECK(x == IMG_NONE || x < sec[SEC_STATE].num);
+      dt[k].s[j] = (x == IMG_NONE) ? NULL : &(s[x]);
+    }
+    dt[k].tr = &(t[r->tr]);
+    htk_hmmdata_add(hmm, &(dt[k]));
+  }
+
+  /* same setup as read_binhmm() */
+  if (htk_hmm_check_sid(hmm) == FALSE) {
+    jlog("Error: binhmm_image: error in SID\n");
+    return FALSE;
+  }
+  k = 0;
+  for(t = hmm->trstart; t; t = t->next) t->id = k++;
+  hmm->totaltransnum = k;
+
+  hmm->need_multipath = htk_hmm_has_several_arc_on_edge(hmm);
+  if (hmm->need_multipath) {
+    jlog("Stat: binhmm_image: this HMM requires multipath handling at decoding\n");
+  } else {
+    jlog("Stat: binhmm_image: this HMM does not need multipath handling\n");
+  }
+
+#ifdef ENABLE_MSD
+  htk_hmm_check_msd(hmm);
+#endif
+
+  return TRUE;
+}
@@ -73,7 +73,7 @@ void
 add_left_context(char name[], char *lc)
 {
   char *p;
-  static char buf[MAX_HMMNAME_LEN];
+  char buf[MAX_HMMNAME_LEN];
 
   if ((p = strchr(name, HMM_LC_DLIM_C)) != NULL) {
     p++;
@@ -86,8 +86,6 @@ add_left_context(char name[], char *lc)
   strcpy(name, buf);
 }
 
-static char gbuf[MAX_HMMNAME_LEN]; ///< Work area for get_{right|left}_context_HMM
-
 /**
  *
  * @brief  Search for right context %HMM in logical %HMM
@@ -106,6 +104,8 @@ static char gbuf[MAX_HMMNAME_LEN]; ///< Work area for get_{right|left}_context_H
 HMM_Logical *
 get_right_context_HMM(HMM_Logical *base, char *rc_name, HTK_HMM_INFO *hmminfo)
 {
+  char gbuf[MAX_HMMNAME_LEN];
+
   strcpy(gbuf, base->name);
   add_right_context(gbuf, rc_name);
   return(htk_hmmdata_lookup_logical(hmminfo, gbuf));
@@ -128,10 +128,58 @@ get_right_context_HMM(HMM_Logical *base, char *rc_name, HTK_HMM_INFO *hmminfo)
 HMM_Logical *
 get_left_context_HMM(HMM_Logical *base, char *lc_name, HTK_HMM_INFO *hmminfo)
 {
+  char gbuf[MAX_HMMNAME_LEN];
+
   strcpy(gbuf, base->name);
   add_left_context(gbuf, lc_name);
   return(htk_hmmdata_lookup_logical(hmminfo, gbuf));
 }
+
+/**
+ * @brief  Search for right context %HMM by phone context index
+ *
+ * Same as get_right_context_HMM(), but the right context is given as
+ * a logical %HMM and the result is looked up by the phone context IDs
+ * without building the name string.  When the phone context index is
+ * not available, falls back to get_right_context_HMM().
+ * 
+ * @param base [in] base phone %HMM
+ * @param rc [in] logical %HMM whose center phone is the right context
+ * @param hmminfo [in] HTK %HMM definition data
+ * 
+ * @return the pointer to the logical %HMM, or NULL if not found.
+ */
+HMM_Logical *
+get_right_context_logical(HMM_Logical *base, HMM_Logical *rc, HTK_HMM_INFO *hmminfo)
+{
+  if (! hmminfo->ctxindex.enabled) {
+    return(get_right_context_HMM(base, rc->name, hmminfo));
+  }
+  return(ctxtable_lookup(&(hmminfo->ctxindex.lg), base->lcid, base->cid, rc->cid));
+}
+
+/**
+ * @brief  Search for left context %HMM by phone context index
+ *
+ * Same as get_left_context_HMM(), but the left context is given as
+ * a logical %HMM and the result is looked up by the phone context IDs
+ * without building the name string.  When the phone context index is
+ * not available, falls back to get_left_context_HMM().
+ * 
+ * @param base [in] base phone %HMM
+ * @param lc [in] logical %HMM whose center phone is the left context
+ * @param hmminfo [in] HTK %HMM definition data
+ * 
+ * @return the pointer to the logical %HMM, or NULL if not found.
+ */
+HMM_Logical *
+get_left_context_logical(HMM_Logical *base, HMM_Logical *lc, HTK_HMM_INFO *hmminfo)
+{
+  if (! hmminfo->ctxindex.enabled) {
+    return(get_left_context_HMM(base, lc->name, hmminfo));
+  }
+  return(ctxtable_lookup(&(hmminfo->ctxindex.lg), lc->cid, base->cid, base->rcid));
+}
   
 /** 
  * Extract the center phone name and copy to the specified buffer.
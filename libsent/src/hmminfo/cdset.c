@@ -154,6 +154,48 @@ rcdset_lookup_by_hmmname(HTK_HMM_INFO *hmminfo, char *hmmname)
   return(cdset_lookup(hmminfo, rightcenter_name(hmmname, buf)));
 }
 
+/** 
+ * Look up for a pseudo phone by the "left - center" context of the given
+ * logical %HMM, using the phone context index.  If @a lc is given, its
+ * center phone is used as the left context instead of that of @a hmm.
+ * 
+ * @param hmminfo [in] %HMM information to search for.
+ * @param hmm [in] logical %HMM
+ * @param lc [in] logical %HMM to be the left context, or NULL
+ * 
+ * @return pointer to the pseudo phone if found, or NULL if not found.
+ */
+CD_Set *
+lcdset_lookup_by_logical(HTK_HMM_INFO *hmminfo, HMM_Logical *hmm, HMM_Logical *lc)
+{
+  char buf[MAX_HMMNAME_LEN];
+
+  if (! hmminfo->ctxindex.enabled) {
+    strcpy(buf, hmm->name);
+    if (lc != NULL) add_left_context(buf, lc->name);
+    return(lcdset_lookup_by_hmmname(hmminfo, buf));
+  }
+  return(ctxtable_lookup(&(hmminfo->ctxindex.cd), (lc != NULL) ? lc->cid : hmm->lcid, hmm->cid, 0));
+}
+
+/** 
+ * Look up for a pseudo phone by the "center + right" context of the given
+ * logical %HMM, using the phone context index.
+ * 
+ * @param hmminfo [in] %HMM information to search for.
+ * @param hmm [in] logical %HMM
+ * 
+ * @return pointer to the pseudo phone if found, or NULL if not found.
+ */
+CD_Set *
+rcdset_lookup_by_logical(HTK_HMM_INFO *hmminfo, HMM_Logical *hmm)
+{
+  if (! hmminfo->ctxindex.enabled) {
+    return(rcdset_lookup_by_hmmname(hmminfo, hmm->name));
+  }
+  return(ctxtable_lookup(&(hmminfo->ctxindex.cd), 0, hmm->cid, hmm->rcid));
+}
+
 
 /** 
  * Output text information of a pseudo phone to stdout.
@@ -0,0 +1,359 @@
+/**
+ * @file   hmm_ctxindex.c
+ *
+ * <JA>
+ * @brief  音素コンテキストの整数IDによる論理%HMMの索引
+ *
+ * 論理%HMM名に現れる音素名に整数IDを割り振り，(左コンテキスト, 中心音素,
+ * 右コンテキスト) のID三つ組から論理%HMM および pseudo phone set を
+ * ハッシュ表で直接引けるようにします．単語間のコンテキスト解決で
+ * "a-k+i" のような名前文字列を作って木を検索する処理を置き換えます．
+ * </JA>
+ *
+ * <EN>
+ * @brief  Integer-keyed phone context index of logical %HMM
+ *
+ * Each phone name appearing in the logical %HMM names is assigned an
+ * integer ID, and logical %HMMs and pseudo phone sets are stored in
+ * hash tables keyed by the ID triplet (left context, center, right
+ * context).  This replaces building name strings such as "a-k+i" and
+ * searching the index tree by them when resolving cross-word context.
+ * </EN>
+ *
+ */
+/*
+ * Copyright (c) 1991-2013 Kawahara Lab., Kyoto University
+ * Copyright (c) 2000-2005 Shikano Lab., Nara Institute of Science and Technology
+ * Copyright (c) 2005-2013 Julius project team, Nagoya Institute of Technology
+ * All rights reserved
+ */
+
+#include <sent/stddefs.h>
+#include <sent/htk_hmm.h>
+#include <sent/ptree.h>
+
+#define CTXTABLE_INITSIZE 64	///< Initial size of context hash table
+
+/// Phone name entry used while assigning phone IDs
+typedef struct {
+  char *name;			///< Phone name
+  int id;			///< Assigned phone ID
+} CTX_PHONE;
+
+/**
+ * Hash function of a key triplet.
+ *
+ * @param k1 [in] first key
+ * @param k2 [in] second key
+ * @param k3 [in] third key
+ *
+ * @return the hash value.
+ */
+static unsigned int
+ctxtable_hash(int k1, int k2, int k3)
+{
+  unsigned int h;
+
+  h = (unsigned int)k1 * 0x9E3779B1U;
+  h ^= (unsigned int)k2 * 0x85EBCA77U;
+  h ^= (unsigned int)k3 * 0xC2B2AE3DU;
+  h ^= h >> 15;
+  return(h);
+}
+
+/**
+ * Initialize a context hash table as empty.
+ *
+ * @param t [out] hash table
+ */
+void
+ctxtable_init(HMM_CTX_TABLE *t)
+{
+  t->e = NULL;
+  t->size = 0;
+  t->num = 0;
+}
+
+/**
+ * Free a context hash table.  The data pointed by the entries are not freed.
+ *
+ * @param t [i/o] hash table
+ */
+void
+ctxtable_free(HMM_CTX_TABLE *t)
+{
+  if (t->e != NULL) free(t->e);
+  ctxtable_init(t);
+}
+
+/**
+ * Store an entry to the table without expansion.
+ *
+ * @param e [i/o] entries
+ * @param size [in] size of @a e
+ * @param k1 [in] first key
+ * @param k2 [in] second key
+ * @param k3 [in] third key
+ * @param data [in] data to store
+ *
+ * @return TRUE if stored, or FALSE if the key already exists.
+ */
+static boolean
+ctxtable_put(HMM_CTX_ENTRY *e, unsigned int size, int k1, int k2, int k3, void *data)
+{
+  unsigned int i;
+
+  i = ctxtable_hash(k1, k2, k3) & (size - 1);
+  while (e[i].data != NULL) {
+    if (e[i].k1 == k1 && e[i].k2 == k2 && e[i].k3 == k3) return FALSE;
+    i = (i + 1) & (size - 1);
+  }
+  e[i].k1 = k1;
+  e[i].k2 = k2;
+  e[i].k3 = k3;
+  e[i].data = data;
+  return TRUE;
+}
+
+/**
+ * Expand a context hash table to the given size and re-hash the entries.
+ *
+ * @param t [i/o] hash table
+ * @param size [in] new size (power of 2)
+ */
+static void
+ctxtable_expand(HMM_CTX_TABLE *t, unsigned int size)
+{
+  HMM_CTX_ENTRY *e;
+  unsigned int i;
+
+  e = (HMM_CTX_ENTRY *)mymalloc(sizeof(HMM_CTX_ENTRY) * size);
+  for(i=0;i<size;i++) e[i].data = NULL;
+  for(i=0;i<t->size;i++) {
+    if (t->e[i].data != NULL) {
+      ctxtable_put(e, size, t->e[i].k1, t->e[i].k2, t->e[i].k3, t->e[i].data);
+    }
+  }
+  if (t->e != NULL) free(t->e);
+  t->e = e;
+  t->size = size;
+}
+
+/**
+ * Add an entry to a context hash table.  The table will be expanded
+ * when needed.  If the key already exists, the old entry is kept.
+ *
+ * @param t [i/o] hash table
+ * @param k1 [in] first key
+ * @param k2 [in] second key
+ * @param k3 [in] third key
+ * @param data [in] data to store (should not be NULL)
+ */
+void
+ctxtable_add(HMM_CTX_TABLE *t, int k1, int k2, int k3, void *data)
+{
+  if ((t->num + 1) * 2 > t->size) {
+    /* keep load factor below 0.5 */
+    ctxtable_expand(t, (t->size == 0) ? CTXTABLE_INITSIZE : t->size * 2);
+  }
+  if (ctxtable_put(t->e, t->size, k1, k2, k3, data)) t->num++;
+}
+
+/**
+ * Look up an entry in a context hash table.
+ *
+ * @param t [in] hash table
+ * @param k1 [in] first key
+ * @param k2 [in] second key
+ * @param k3 [in] third key
+ *
+ * @return the stored data, or NULL if not found.
+ */
+void *
+ctxtable_lookup(HMM_CTX_TABLE *t, int k1, int k2, int k3)
+{
+  HMM_CTX_ENTRY *e;
+  unsigned int i;
+
+  if (t->size == 0) return NULL;
+  i = ctxtable_hash(k1, k2, k3) & (t->size - 1);
+  while ((e = &(t->e[i]))->data != NULL) {
+    if (e->k1 == k1 && e->k2 == k2 && e->k3 == k3) return(e->data);
+    i = (i + 1) & (t->size - 1);
+  }
+  return NULL;
+}
+
+/**
+ * Get phone ID of a phone name, assigning a new one if not exist yet.
+ *
+ * @param name [in] phone name
+ * @param root [i/o] index tree of phone names
+ * @param mroot [i/o] memory allocation base for the index tree
+ * @param num [i/o] number of phone IDs already assigned
+ *
+ * @return the phone ID.
+ */
+static int
+ctx_phone_id(char *name, APATNODE **root, BMALLOC_BASE **mroot, int *num)
+{
+  CTX_PHONE *p, *match = NULL;
+
+  if (*root != NULL) {
+    match = aptree_search_data(name, *root);
+    if (match != NULL && strmatch(match->name, name)) return(match->id);
+  }
+  p = (CTX_PHONE *)mybmalloc2(sizeof(CTX_PHONE), mroot);
+  p->name = mybstrdup2(name, mroot);
+  p->id = (*num)++;
+  if (*root == NULL) {
+    *root = aptree_make_root_node(p, mroot);
+  } else {
+    aptree_add_entry(p->name, p, match->name, root, mroot);
+  }
+  return(p->id);
+}
+
+/**
+ * Split a logical %HMM name into left context, center and right context
+ * in the same way as center_name(), leftcenter_name() and
+ * rightcenter_name().  Names which cannot be re-composed from the
+ * three parts are rejected.
+ *
+ * @param name [in] logical %HMM name
+ * @param lc [out] left context phone name, empty if none
+ * @param c [out] center phone name
+ * @param rc [out] right context phone name, empty if none
+ *
+ * @return TRUE on success, FALSE if the name is not a canonical context
+ * dependent phone name.
+ */
+static boolean
+ctx_split_name(char *name, char *lc, char *c, char *rc)
+{
+  char *p, *q;
+
+  lc[0] = rc[0] = '\0';
+  if ((p = strchr(name, HMM_LC_DLIM_C)) != NULL) {
+    strncpy(lc, name, p - name);
+    lc[p - name] = '\0';
+    p++;
+  } else {
+    p = name;
+  }
+  if ((q = strchr(p, HMM_RC_DLIM_C)) != NULL) {
+    strncpy(c, p, q - p);
+    c[q - p] = '\0';
+    strcpy(rc, q + 1);
+  } else {
+    strcpy(c, p);
+  }
+  if (c[0] == '\0') return FALSE;
+  if (p != name && lc[0] == '\0') return FALSE;
+  if (q != NULL && rc[0] == '\0') return FALSE;
+  if (strchr(lc, HMM_RC_DLIM_C) != NULL) return FALSE;
+  if (strchr(rc, HMM_LC_DLIM_C) != NULL || strchr(rc, HMM_RC_DLIM_C) != NULL) return FALSE;
+  return TRUE;
+}
+
+/**
+ * @brief  Build phone context index of logical %HMM and pseudo phone sets.
+ *
+ * Assign phone IDs to all logical %HMMs and index them, together with
+ * the pseudo phone sets, by the (left context, center, right context)
+ * triplet.  This should be called after all the logical %HMMs including
+ * pseudo phones are registered.  If a logical name is not a canonical
+ * context-dependent name, the index is disabled and the lookup
+ * functions fall back to name-based search.
+ *
+ * @param hmminfo [i/o] %HMM definition
+ *
+ * @return TRUE on success, FALSE if the index was not built.
+ */
+boolean
+hmm_ctxindex_build(HTK_HMM_INFO *hmminfo)
+{
+  HMM_CTX_INDEX *x;
+  HMM_Logical *lg;
+  CD_Set *cd;
+  APATNODE *root = NULL;
+  BMALLOC_BASE *mroot = NULL;
+  char lc[MAX_HMMNAME_LEN], c[MAX_HMMNAME_LEN], rc[MAX_HMMNAME_LEN];
+  char lastlc[MAX_HMMNAME_LEN], lastc[MAX_HMMNAME_LEN];
+  char buf[MAX_HMMNAME_LEN];
+  int num, lcid, cid;
+  unsigned int size;
+
+  x = &(hmminfo->ctxindex);
+  hmm_ctxindex_free(hmminfo);
+
+  /* ID 0 is reserved for "no context" */
+  num = 1;
+  lcid = cid = 0;
+  for (size = CTXTABLE_INITSIZE; size < hmminfo->totallogicalnum * 2; size *= 2);
+  ctxtable_expand(&(x->lg), size);
+  for (lg = hmminfo->lgstart; lg; lg = lg->next) {
+    if (ctx_split_name(lg->name, lc, c, rc) == FALSE) {
+      jlog("Warning: hmm_ctxindex: \"%s\" is not a context-dependent name, phone context index disabled\n", lg->name);
+      hmm_ctxindex_free(hmminfo);
+      if (mroot != NULL) mybfree2(&mroot);
+      return FALSE;
+    }
+    /* logical names are mostly sorted, so reuse the IDs of the last one */
+    if (lc[0] == '\0') lcid = 0;
+    else if (lcid == 0 || ! strmatch(lc, lastlc)) {
+      lcid = ctx_phone_id(lc, &root, &mroot, &num);
+      strcpy(lastlc, lc);
+    }
+    if (cid == 0 || ! strmatch(c, lastc)) {
+      cid = ctx_phone_id(c, &root, &mroot, &num);
+      strcpy(lastc, c);
+    }
+    lg->lcid = lcid;
+    lg->cid = cid;
+    lg->rcid = (rc[0] == '\0') ? 0 : ctx_phone_id(rc, &root, &mroot, &num);
+    ctxtable_add(&(x->lg), lg->lcid, lg->cid, lg->rcid, lg);
+    /* pseudo phone sets for this logical HMM, if not indexed yet */
+    if (lg->lcid != 0 && ctxtable_lookup(&(x->cd), lg->lcid, lg->cid, 0) == NULL) {
+      snprintf(buf, MAX_HMMNAME_LEN, "%s%s%s", lc, HMM_LC_DLIM, c);
+      if ((cd = cdset_lookup(hmminfo, buf)) != NULL) {
+	ctxtable_add(&(x->cd), lg->lcid, lg->cid, 0, cd);
+      }
+    }
+    if (lg->rcid != 0 && ctxtable_lookup(&(x->cd), 0, lg->cid, lg->rcid) == NULL) {
+      snprintf(buf, MAX_HMMNAME_LEN, "%s%s%s", c, HMM_RC_DLIM, rc);
+      if ((cd = cdset_lookup(hmminfo, buf)) != NULL) {
+	ctxtable_add(&(x->cd), 0, lg->cid, lg->rcid, cd);
+      }
+    }
+    if (ctxtable_lookup(&(x->cd), 0, lg->cid, 0) == NULL && (cd = cdset_lookup(hmminfo, c)) != NULL) {
+      ctxtable_add(&(x->cd), 0, lg->cid, 0, cd);
+    }
+  }
+  if (mroot != NULL) mybfree2(&mroot);
+
+  x->phnum = num;
+  x->enabled = TRUE;
+  jlog("Stat: hmm_ctxindex: %d phones, %d logical HMMs and %d pseudo sets indexed\n", num - 1, x->lg.num, x->cd.num);
+
+  return TRUE;
+}
+
+/**
+ * Free the phone context index of logical %HMM.
+ *
+ * @param hmminfo [i/o] %HMM definition
+ */
+void
+hmm_ctxindex_free(HTK_HMM_INFO *hmminfo)
+{
+  HMM_CTX_INDEX *x;
+
+  x = &(hmminfo->ctxindex);
+  ctxtable_free(&(x->lg));
+  ctxtable_free(&(x->cd));
+  x->phnum = 0;
+  x->enabled = FALSE;
+}
+
+/* end of file */
@@ -140,6 +140,7 @@ hmm_add_physical_to_logical(HTK_HMM_INFO *hmminfo)
     strcpy(new->name, ph->name);
     new->is_pseudo = FALSE;
     new->body.defined = ph;
+    new->lcid = new->cid = new->rcid = 0;
     new->next = hmminfo->lgstart;
     hmminfo->lgstart = new;
     if (hmminfo->logical_root == NULL) {
@@ -184,6 +185,7 @@ hmm_add_pseudo_phones_sub(HTK_HMM_INFO *hmminfo, char *name)
     new->name = (char *)mybmalloc2(strlen(name) + 1, &(hmminfo->lroot));
     strcpy(new->name, name);
     new->is_pseudo = TRUE;
+    new->lcid = new->cid = new->rcid = 0;
     new->body.pseudo = cdset_lookup(hmminfo, name);
     if (new->body.pseudo == NULL) {	/* should never happen */
       jlog("Error: hmm_lookup: tried to add pseudo phone \"%s\" to logical HMM, but no corresponding CD_Set found.  Why??\n");
@@ -203,7 +205,7 @@ hmm_add_pseudo_phones_sub(HTK_HMM_INFO *hmminfo, char *name)
     
 /** 
  * Update logical %HMM list by adding all the possible pseudo monophone
- * and biphone to the list.
+ * and biphone to the list.  The phone context index is also built here.
  * 
  * @param hmminfo [in] %HMM definition data.
  */
@@ -242,6 +244,44 @@ hmm_add_pseudo_phones(HTK_HMM_INFO *hmminfo)
   jlog("Stat: hmm_lookup: %d pseudo phones are added to logical HMM list\n", hmminfo->totalpseudonum);
   /* re-count total number */
   hmm_count_logical_num(hmminfo);
+  /* index all logical HMMs and pseudo phone sets by phone context IDs */
+  hmm_ctxindex_build(hmminfo);
+}
+
+/** 
+ * Compute a hash value of the logical %HMM list.  It covers the order
+ * of the list, name of each logical %HMM and the physical or pseudo
+ * %HMM it is mapped to, so the index of a logical %HMM in the list is
+ * valid while the hash value matches.
+ * 
+ * @param hmminfo [in] %HMM definition data.
+ * 
+ * @return the hash value.
+ */
+unsigned int
+hmm_logical_hash(HTK_HMM_INFO *hmminfo)
+{
+  HMM_Logical *lg;
+  unsigned int h;
+  char *p;
+
+  /* FNV-1a */
+  h = 2166136261U;
+  for (lg = hmminfo->lgstart; lg; lg = lg->next) {
+    for (p = lg->name; *p != '\0'; p++) {
+      h ^= (unsigned char)*p;
+      h *= 16777619U;
+    }
+    h ^= (lg->is_pseudo ? 2 : 1);
+    h *= 16777619U;
+    p = lg->is_pseudo ? lg->body.pseudo->name : lg->body.defined->name;
+    for (; *p != '\0'; p++) {
+      h ^= (unsigned char)*p;
+      h *= 16777619U;
+    }
+    h *= 16777619U;		/* terminator */
+  }
+  return(h);
 }
 
 /** 
@@ -41,6 +41,10 @@ hmminfo_new()
   new->lroot = NULL;
   new->cdset_root = NULL;
   new->tmp_mixnum = NULL;
+  new->image = NULL;
+  new->image_base = NULL;
+  new->image_size = 0;
+  new->image_mapped = FALSE;
 
   new->opt.stream_info.num = 0;
   new->opt.cov_type = C_DIAG_C;
@@ -77,6 +81,10 @@ hmminfo_new()
   new->sp = NULL;
   new->basephone.root = NULL;
   new->cdset_info.cdtree = NULL;
+  new->ctxindex.enabled = FALSE;
+  new->ctxindex.phnum = 0;
+  ctxtable_init(&(new->ctxindex.lg));
+  ctxtable_init(&(new->ctxindex.cd));
   new->variance_inversed = FALSE;
 
 #ifdef ENABLE_MSD
@@ -103,11 +111,15 @@ hmminfo_free(HTK_HMM_INFO *hmm)
     /* cdset does not use bmalloc, so free them separately */
     free_cdset(&(hmm->cdset_info.cdtree), &(hmm->cdset_root));
   }
+  hmm_ctxindex_free(hmm);
 
   /* free all memory that has been allocated by bmalloc2() */
   if (hmm->mroot != NULL) mybfree2(&(hmm->mroot));
   if (hmm->lroot != NULL) mybfree2(&(hmm->lroot));
 
+  /* release binary HMM image referred from the definitions */
+  binhmm_image_free(hmm);
+
   /* free whole */
   free(hmm);
 
@@ -117,7 +129,8 @@ hmminfo_free(HTK_HMM_INFO *hmm)
 /** 
  * @brief Load HTK %HMM definition file and HMMList file, and setup phone %HMM information.
  *
- * First try ascii format, then try binary format.
+ * First check if it is a binary image, then try ascii format, then
+ * binary format.
  * 
  * @param hmminfo [out] pointer to store all the %HMM definition data.
  * @param hmmfilename [in] file name of HTK %HMM definition file, NULL if not.
@@ -135,17 +148,27 @@ init_hmminfo(HTK_HMM_INFO *hmminfo, char *hmmfilename, char *namemapfile, Value
 
   /* read hmmdef file */
   jlog("Stat: init_phmm: Reading in HMM definition\n");
-  /* first, try ascii format */
-  if ((fp = fopen_readfile(hmmfilename)) == NULL) {
-    jlog("Error: init_phmm: failed to open %s\n",hmmfilename);
-    return FALSE;
-  }
-  if (rdhmmdef(fp, hmminfo) == TRUE) {
+  if (is_binhmm_image(hmmfilename)) {
+    /* binary image, map it */
+    if (read_binhmm_image(hmmfilename, hmminfo, para) == FALSE) {
+      jlog("Error: init_phmm: failed to read %s\n", hmmfilename);
+      return FALSE;
+    }
     ok_p = TRUE;
   }
-  if (fclose_readfile(fp) < 0) {
-    jlog("Error: init_phmm: failed to close %s\n", hmmfilename);
-    return FALSE;
+  if (ok_p == FALSE) {
+    /* first, try ascii format */
+    if ((fp = fopen_readfile(hmmfilename)) == NULL) {
+      jlog("Error: init_phmm: failed to open %s\n",hmmfilename);
+      return FALSE;
+    }
+    if (rdhmmdef(fp, hmminfo) == TRUE) {
+      ok_p = TRUE;
+    }
+    if (fclose_readfile(fp) < 0) {
+      jlog("Error: init_phmm: failed to close %s\n", hmmfilename);
+      return FALSE;
+    }
   }
   if (ok_p == FALSE) {
     /* second, try binary format */
@@ -117,6 +117,7 @@ rdhmmlist(FILE *fp, HTK_HMM_INFO *hmminfo)
     new->name = mybstrdup2(lname, &(hmminfo->lroot));
     new->is_pseudo = FALSE;
     new->body.defined = mapped;
+    new->lcid = new->cid = new->rcid = 0;
     new->next = hmminfo->lgstart;
     hmminfo->lgstart = new;
     /* add index to search index tree */
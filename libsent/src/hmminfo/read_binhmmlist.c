@@ -75,6 +75,7 @@ load_hmmlist_callback(void **data_p, void *data, FILE *fp)
 
   new = (HMM_Logical *)mybmalloc2(sizeof(HMM_Logical), &(hmminfo->lroot));
   if (myfread(&(new->is_pseudo), sizeof(boolean), 1, fp) < 1) return FALSE;
+  new->lcid = new->cid = new->rcid = 0;
   if (myfread(&len, sizeof(int), 1, fp) < 1) return FALSE;
   new->name = (char *)mybmalloc2(len, &(hmminfo->lroot));
   if (myfread(new->name, len, 1, fp) < 1) return FALSE;
@@ -28,6 +28,49 @@
 
 #undef ADEBUG
 
+/**
+ * Get the range of n-gram tuples whose context is the given (n-1)-gram
+ * tuple.
+ *
+ * @param ndata [in] word/class N-gram
+ * @param n [in] N of N-gram
+ * @param nid_prev [in] context (N-1)-gram tuple ID
+ * @param left [out] ID of the first tuple in the range
+ * @param right [out] ID of the last tuple in the range
+ *
+ * @return TRUE if found, or FALSE if the context has no n-gram tuple.
+ */
+static boolean
+ngram_successor_range(NGRAM_INFO *ndata, int n, NNID nid_prev, NNID *left, NNID *right)
+{
+  NGRAM_TUPLE_INFO *t, *tprev;
+  NNID nnid;
+  NNID l;
+
+  t = &(ndata->d[n-1]);
+  tprev = &(ndata->d[n-2]);
+  
+  if (tprev->ct_compaction) {
+    nnid = tprev->nnid2ctid_upper[nid_prev];
+    if (nnid == NNID_INVALID_UPPER) return FALSE;
+    nnid = (nnid << 16) + (NNID)(tprev->nnid2ctid_lower[nid_prev]);
+  } else {
+    nnid = nid_prev;
+  }
+  if (t->is24bit) {
+    l = t->bgn_upper[nnid];
+    if (l == NNID_INVALID_UPPER) return FALSE;
+    l = (l << 16) + (NNID)(t->bgn_lower[nnid]);
+  } else {
+    l = t->bgn[nnid];
+    if (l == NNID_INVALID) return FALSE;
+  }
+  *left = l;
+  *right = l + t->num[nnid] - 1;
+
+  return TRUE;
+}
+
 /** 
  * Search for n-gram tuple.
  * 
@@ -42,8 +85,7 @@
 static NNID
 search_ngram_core(NGRAM_INFO *ndata, int n, NNID nid_prev, WORD_ID wkey)
 {
-  NGRAM_TUPLE_INFO *t, *tprev;
-  NNID nnid;
+  NGRAM_TUPLE_INFO *t;
   NNID left,right,mid;
   NNID x;
 
@@ -56,24 +98,10 @@ search_ngram_core(NGRAM_INFO *ndata, int n, NNID nid_prev, WORD_ID wkey)
   }
 
   t = &(ndata->d[n-1]);
-  tprev = &(ndata->d[n-2]);
-  
-  if (tprev->ct_compaction) {
-    nnid = tprev->nnid2ctid_upper[nid_prev];
-    if (nnid == NNID_INVALID_UPPER) return (NNID_INVALID);
-    nnid = (nnid << 16) + (NNID)(tprev->nnid2ctid_lower[nid_prev]);
-  } else {
-    nnid = nid_prev;
-  }
-  if (t->is24bit) {
-    left = t->bgn_upper[nnid];
-    if (left == NNID_INVALID_UPPER) return (NNID_INVALID);
-    left = (left << 16) + (NNID)(t->bgn_lower[nnid]);
-  } else {
-    left = t->bgn[nnid];
-    if (left == NNID_INVALID) return (NNID_INVALID);
+
+  if (ngram_successor_range(ndata, n, nid_prev, &left, &right) == FALSE) {
+    return (NNID_INVALID);
   }
-  right = left + t->num[nnid] - 1;
 
   while(left < right) {
     mid = (left + right) / 2;
@@ -90,6 +118,89 @@ search_ngram_core(NGRAM_INFO *ndata, int n, NNID nid_prev, WORD_ID wkey)
   }
 }
 
+/**
+ * Get back-off weight of a context tuple.
+ *
+ * @param ndata [in] word/class N-gram
+ * @param n [in] N of the context tuple
+ * @param nid [in] tuple ID of the context
+ *
+ * @return the back-off weight, or 0.0 if not defined.
+ */
+static LOGPROB
+ngram_bo_wt(NGRAM_INFO *ndata, int n, NNID nid)
+{
+  NGRAM_TUPLE_INFO *t;
+  NNID bid;
+
+  t = &(ndata->d[n-1]);
+  if (t->ct_compaction) {
+    if ((bid = t->nnid2ctid_upper[nid]) == NNID_INVALID_UPPER) {
+      /* in case back-off entry not found, it means bo_wt == 0.0 */
+      return 0.0;
+    }
+    bid = (bid << 16) + (NNID)(t->nnid2ctid_lower[nid]);
+  } else {
+    bid = nid;
+  }
+  return(t->bo_wt[bid]);
+}
+
+/**
+ * Find a word in a sorted range of tuples, starting from the point where
+ * the last search has ended.  The scan point will be moved forward by
+ * galloping to the first tuple whose word is equal to or larger than
+ * the key, so looking up a sorted word list costs a merge-join of the
+ * list and the range.
+ *
+ * @param nnid2wid [in] list of edge words of tuples
+ * @param pos [i/o] current scan point
+ * @param right [in] last tuple ID of the range
+ * @param wkey [in] the target word ID
+ *
+ * @return the tuple ID if found, or NNID_INVALID if not found.
+ */
+static NNID
+ngram_scan_range(WORD_ID *nnid2wid, NNID *pos, NNID right, WORD_ID wkey)
+{
+  NNID lo, hi, mid, step;
+
+  lo = *pos;
+  if (lo > right) return NNID_INVALID;
+  if (nnid2wid[lo] < wkey) {
+    /* gallop to find (lo, hi] that contains the key */
+    step = 1;
+    hi = lo + 1;
+    while (hi <= right && nnid2wid[hi] < wkey) {
+      lo = hi;
+      step <<= 1;
+      hi = lo + step;
+    }
+    if (hi > right) hi = right;
+    if (hi == lo) {
+      /* all words in the range are smaller than the key */
+      *pos = right + 1;
+      return NNID_INVALID;
+    }
+    lo++;
+    while(lo < hi) {
+      mid = (lo + hi) / 2;
+      if (nnid2wid[mid] < wkey) {
+	lo = mid + 1;
+      } else {
+	hi = mid;
+      }
+    }
+    if (nnid2wid[lo] < wkey) {
+      *pos = right + 1;
+      return NNID_INVALID;
+    }
+  }
+  *pos = lo;
+  if (nnid2wid[lo] == wkey) return lo;
+  return NNID_INVALID;
+}
+
 /** 
  * Search for N-tuples.
  * 
@@ -214,6 +325,142 @@ ngram_prob(NGRAM_INFO *ndata, int n, WORD_ID *w)
   return(p);
 }
 
+/* ---------------------------------------------------------------------- */
+/* batch computation for a fixed word context */
+
+/**
+ * Allocate work area of a word context for the N-gram.
+ *
+ * @param ctx [out] word context
+ * @param ndata [in] word/class N-gram
+ */
+void
+ngram_context_init(NGRAM_CONTEXT *ctx, NGRAM_INFO *ndata)
+{
+  ctx->maxlen = ndata->n - 1;
+  ctx->len = 0;
+  ctx->last = WORD_INVALID;
+  ctx->left = (NNID *)mymalloc(sizeof(NNID) * (ctx->maxlen + 1));
+  ctx->right = (NNID *)mymalloc(sizeof(NNID) * (ctx->maxlen + 1));
+  ctx->pos = (NNID *)mymalloc(sizeof(NNID) * (ctx->maxlen + 1));
+  ctx->bo = (LOGPROB *)mymalloc(sizeof(LOGPROB) * (ctx->maxlen + 1));
+}
+
+/**
+ * Free work area of a word context.
+ *
+ * @param ctx [i/o] word context
+ */
+void
+ngram_context_free(NGRAM_CONTEXT *ctx)
+{
+  free(ctx->left);
+  free(ctx->right);
+  free(ctx->pos);
+  free(ctx->bo);
+}
+
+/**
+ * Resolve a word context for ngram_prob_batch().  For each suffix of
+ * the context, the range of its successor tuples and the back-off
+ * weight are looked up here only once.
+ *
+ * @param ctx [out] word context, already allocated by ngram_context_init()
+ * @param ndata [in] word/class N-gram
+ * @param w [in] context words, in the same order as ngram_prob()
+ * @param len [in] number of words in @a w.  Only the last N-1 words are used.
+ */
+void
+ngram_context_set(NGRAM_CONTEXT *ctx, NGRAM_INFO *ndata, WORD_ID *w, int len)
+{
+  int j, m;
+  NNID nid;
+
+  if (len > ctx->maxlen) {
+    w += len - ctx->maxlen;
+    len = ctx->maxlen;
+  }
+  ctx->len = len;
+  ctx->last = (len > 0) ? w[len-1] : WORD_INVALID;
+  for(j=0;j<len;j++) {
+    m = len - j;		/* length of this context suffix */
+    nid = search_ngram(ndata, m, &(w[j]));
+    if (nid == NNID_INVALID) {
+      /* context not found, fallback to shorter one without back-off */
+      ctx->left[j] = NNID_INVALID;
+      ctx->bo[j] = 0.0;
+      continue;
+    }
+    /* context found: its back-off weight applies even if it has no
+       successor tuple */
+    ctx->bo[j] = ngram_bo_wt(ndata, m, nid);
+    if (ndata->bigram_index_reversed && m == 1) {
+      /* 2-gram index is not grouped by context, look up each word */
+      ctx->left[j] = 0;
+      ctx->right[j] = 0;
+    } else if (ngram_successor_range(ndata, m + 1, nid, &(ctx->left[j]), &(ctx->right[j])) == FALSE) {
+      ctx->left[j] = NNID_INVALID;
+    }
+  }
+}
+
+/**
+ * Compute N-gram probabilities of words following the word context.
+ * The result is the same as calling ngram_prob() for each word with
+ * the context, but the context is not parsed again and the successor
+ * tuples of each context are scanned at most once when @a w is sorted
+ * in ascending order.  Unsorted list is also allowed, at the cost of
+ * restarting the scan.
+ *
+ * @param ndata [in] word/class N-gram
+ * @param ctx [i/o] word context set by ngram_context_set()
+ * @param w [in] list of target word IDs in N-gram
+ * @param num [in] number of words in @a w
+ * @param prob [out] resulting log probabilities, in the same order as @a w
+ */
+void
+ngram_prob_batch(NGRAM_INFO *ndata, NGRAM_CONTEXT *ctx, WORD_ID *w, int num, LOGPROB *prob)
+{
+  int i, j, k, m;
+  NNID nid;
+  WORD_ID wkey;
+  LOGPROB p;
+
+  m = 0;
+  nid = NNID_INVALID;
+  for(j=0;j<ctx->len;j++) ctx->pos[j] = ctx->left[j];
+  for(k=0;k<num;k++) {
+    wkey = w[k];
+    if (k > 0 && wkey < w[k-1]) {
+      /* not sorted, restart scan */
+      for(j=0;j<ctx->len;j++) ctx->pos[j] = ctx->left[j];
+    }
+    /* look up from the longest context */
+    for(j=0;j<ctx->len;j++) {
+      if (ctx->left[j] == NNID_INVALID) continue;
+      m = ctx->len - j + 1;
+      if (ndata->bigram_index_reversed && m == 2) {
+	nid = search_ngram_core(ndata, 2, ctx->last, wkey);
+      } else {
+	nid = ngram_scan_range(ndata->d[m-1].nnid2wid, &(ctx->pos[j]), ctx->right[j], wkey);
+      }
+      if (nid != NNID_INVALID) break;
+    }
+    if (j < ctx->len) {
+      p = ndata->d[m-1].prob[nid];
+    } else {
+      p = ndata->d[0].prob[wkey];
+    }
+    if (wkey == ndata->unk_id) p -= ndata->unk_num_log;
+    /* add back-off weights of longer contexts in the same order as
+       ngram_prob() to get exactly the same value.  The weight is 0.0
+       for a context not found, and is added also for a context without
+       successors */
+    for(i=j-1;i>=0;i--) p += ctx->bo[i];
+    prob[k] = p;
+  }
+}
+
 /* ---------------------------------------------------------------------- */
 /* separate access functions for the 1st pass */
 
@@ -437,6 +684,102 @@ bi_prob(NGRAM_INFO *ndata, WORD_ID w1, WORD_ID w2)
   return p;
 }
 
+/**
+ * Get 2-gram probabilities of words following a word on the 1st pass.
+ * The result is the same as calling ndata->bigram_prob for each word.
+ * When the 2-gram is indexed by the left context, the successor tuples
+ * of @a w1 are scanned at most once if @a w2 is sorted in ascending order.
+ *
+ * @param ndata [in] N-gram data that holds the 2-gram
+ * @param w1 [in] left context word
+ * @param w2 [in] list of right target words
+ * @param num [in] number of words in @a w2
+ * @param prob [out] resulting log probabilities P(w2|w1), in the same order as @a w2
+ */
+void
+bi_prob_batch(NGRAM_INFO *ndata, WORD_ID w1, WORD_ID *w2, int num, LOGPROB *prob)
+{
+  NGRAM_TUPLE_INFO *t;
+  NNID pos, left, right, n2;
+  LOGPROB *p2, bo;
+  int k;
+
+  if (!ndata->bigram_index_reversed && ndata->dir != DIR_LR) {
+    /* index is RL, no merit of batch */
+    for(k=0;k<num;k++) prob[k] = (*(ndata->bigram_prob))(ndata, w1, w2[k]);
+    return;
+  }
+
+  /* index is LR: assume ct_compaction and is24bit is FALSE on 2-gram */
+  t = &(ndata->d[1]);
+  if (ndata->bigram_index_reversed) {
+    p2 = ndata->p_2;
+    bo = ndata->bo_wt_1[w1];
+  } else {
+    p2 = t->prob;
+    bo = ndata->d[0].bo_wt[w1];
+  }
+  left = t->bgn[w1];
+  right = (left == NNID_INVALID) ? 0 : left + t->num[w1] - 1;
+  pos = left;
+  for(k=0;k<num;k++) {
+    if (left == NNID_INVALID) {
+      n2 = NNID_INVALID;
+    } else {
+      if (k > 0 && w2[k] < w2[k-1]) pos = left;
+      n2 = ngram_scan_range(t->nnid2wid, &pos, right, w2[k]);
+    }
+    if (n2 != NNID_INVALID) {
+      prob[k] = p2[n2];
+    } else {
+      prob[k] = bo + ndata->d[0].prob[w2[k]];
+    }
+    if (w2[k] == ndata->unk_id) prob[k] -= ndata->unk_num_log;
+  }
+}
+
+/**
+ * Get the explicit 2-gram tuples following a word on the 1st pass.
+ * For words not in the list, ndata->bigram_prob returns the back-off
+ * weight @a bo plus the 1-gram probability.  The lists point into the
+ * N-gram data and are sorted by word ID.  This is available only when
+ * the 2-gram is indexed by the left context.
+ *
+ * @param ndata [in] N-gram data that holds the 2-gram
+ * @param w1 [in] left context word
+ * @param wlist [out] pointer to the list of successor words of @a w1
+ * @param plist [out] pointer to the list of their 2-gram log probabilities
+ * @param bo [out] back-off weight of @a w1
+ *
+ * @return the number of successor words, or -1 if the 2-gram is
+ * indexed by the right context.
+ */
+int
+bi_prob_successor(NGRAM_INFO *ndata, WORD_ID w1, WORD_ID **wlist, LOGPROB **plist, LOGPROB *bo)
+{
+  NGRAM_TUPLE_INFO *t;
+  NNID left;
+
+  if (!ndata->bigram_index_reversed && ndata->dir != DIR_LR) return -1;
+
+  /* index is LR: assume ct_compaction and is24bit is FALSE on 2-gram */
+  t = &(ndata->d[1]);
+  left = t->bgn[w1];
+  if (ndata->bigram_index_reversed) {
+    *bo = ndata->bo_wt_1[w1];
+    *plist = (left == NNID_INVALID) ? NULL : &(ndata->p_2[left]);
+  } else {
+    *bo = ndata->d[0].bo_wt[w1];
+    *plist = (left == NNID_INVALID) ? NULL : &(t->prob[left]);
+  }
+  if (left == NNID_INVALID) {
+    *wlist = NULL;
+    return 0;
+  }
+  *wlist = &(t->nnid2wid[left]);
+  return t->num[w1];
+}
+
 /** 
  * Determinte which bi-gram computation function to be used according to
  * the N-gram type, and set pointer to the proper function into the
@@ -493,6 +493,9 @@ void dnn_clear(DNNData *dnn)
 #ifdef SIMD_ENABLED
   if (dnn->invec) myfree_simd_aligned(dnn->invec);
   if (dnn->accum) myfree_aligned(dnn->accum);
+  if (dnn->batch_buf) myfree_simd_aligned(dnn->batch_buf);
+#else
+  if (dnn->batch_buf) free(dnn->batch_buf);
 #endif
 
   memset(dnn, 0, sizeof(DNNData));
@@ -866,3 +869,141 @@ void dnn_calc_outprob(HMMWork *wrk)
   }
 #endif /* NO_SUM_COMPUTATION */
 }
+
+/************************************************************************/
+/* batched feed-forward for multiple input frames */
+
+/* size of weight block in bytes to be kept on cache while applied to all frames in a batch */
+#define DNN_BATCH_BLOCK_BYTES 131072
+
+/* round up vector length for keeping each vector SIMD-aligned */
+#define DNN_BATCH_ALIGNLEN(x) (((x) + 7) & ~7)
+
+/* prepare working buffer for num frames */
+static void
+dnn_batch_buf_prepare(DNNData *dnn, int num)
+{
+  int len;
+
+  if (dnn->batch_alloc >= num) return;
+  if (dnn->batch_buf) {
+#ifdef SIMD_ENABLED
+    myfree_simd_aligned(dnn->batch_buf);
+#else
+    free(dnn->batch_buf);
+#endif
+  }
+  /* per frame: input vector and two hidden layer outputs */
+  len = DNN_BATCH_ALIGNLEN(dnn->inputnodenum) + DNN_BATCH_ALIGNLEN(dnn->hiddennodenum) * 2;
+#ifdef SIMD_ENABLED
+  dnn->batch_buf = (float *)mymalloc_simd_aligned(sizeof(float) * len * num);
+#else
+  dnn->batch_buf = (float *)mymalloc(sizeof(float) * len * num);
+#endif
+  dnn->batch_alloc = num;
+}
+
+/* apply a layer to all frames, splitting output nodes into blocks so that
+   the weight block is read from memory once per batch */
+static void
+dnn_batch_layer(DNNData *dnn, DNNLayer *l, int num, float **src, float **dst)
+{
+  int rows, r, n, k;
+
+  rows = DNN_BATCH_BLOCK_BYTES / (sizeof(float) * l->in);
+  /* keep blocks in multiple of 4 rows to get the same result as the
+     4-row SIMD sub functions would give at once */
+  rows &= ~3;
+  if (rows < 4) rows = 4;
+
+  for (r = 0; r < l->out; r += rows) {
+    n = l->out - r;
+    if (n > rows) n = rows;
+    for (k = 0; k < num; k++) {
+      (*dnn->subfunc)(dst[k] + r, src[k], l->w + r * l->in, l->b + r, n, l->in, dnn->accum);
+    }
+  }
+}
+
+/**
+ * <JA>
+ * 複数フレームの入力に対して DNN の出力確率を一括計算する. 
+ * 各層の重みをブロックに分割し，ブロックごとに全フレームへ適用することで，
+ * 重みの読み出しをバッチあたり1回にする. 結果は dnn_calc_outprob() と同一. 
+ * </JA>
+ * <EN>
+ * Compute DNN state output probabilities for multiple input frames at once.
+ * Each layer is applied block by block to all frames, so the weights are
+ * read from memory once per batch instead of once per frame.  The results
+ * are identical to those of dnn_calc_outprob().
+ * </EN>
+ *
+ * @param dnn [i/o] DNN data
+ * @param num [in] number of frames
+ * @param invec [in] input vectors for each frame [0..num-1]
+ * @param outcache [out] buffers to store state output probabilities for each frame [0..num-1]
+ * @param statenum [in] number of states to store
+ */
+void
+dnn_calc_outprob_batch(DNNData *dnn, int num, float **invec, LOGPROB **outcache, int statenum)
+{
+  float **src, **dst, **tmp;
+  float *p;
+  int hidx, k, i;
+  DNNLayer *h;
+
+  if (num <= 0) return;
+
+  dnn_batch_buf_prepare(dnn, num);
+  src = (float **)mymalloc(sizeof(float *) * num * 3);
+  dst = src + num;
+  tmp = dst + num;
+
+  p = dnn->batch_buf;
+  for (k = 0; k < num; k++) {
+    src[k] = p;
+    memcpy(src[k], invec[k], sizeof(float) * dnn->inputnodenum);
+    p += DNN_BATCH_ALIGNLEN(dnn->inputnodenum);
+    dst[k] = p;
+    p += DNN_BATCH_ALIGNLEN(dnn->hiddennodenum);
+    tmp[k] = p;
+    p += DNN_BATCH_ALIGNLEN(dnn->hiddennodenum);
+  }
+
+  /* feed forward through hidden layers by standard logistic function */
+  for (hidx = 0; hidx < dnn->hnum; hidx++) {
+    h = &(dnn->h[hidx]);
+    dnn_batch_layer(dnn, h, num, src, dst);
+    for (k = 0; k < num; k++) {
+      for (i = 0; i < h->out; i++) {
+	dst[k][i] = logistic_func(dst[k][i]);
+      }
+    }
+    if (hidx == 0) {
+      /* input vectors are not needed any more, use the tmp buffers */
+      for (k = 0; k < num; k++) src[k] = tmp[k];
+    }
+    /* swap */
+    for (k = 0; k < num; k++) {
+      p = src[k]; src[k] = dst[k]; dst[k] = p;
+    }
+  }
+  /* compute output layer */
+  dnn_batch_layer(dnn, &(dnn->o), num, src, outcache);
+
+  /* do softmax */
+  for (k = 0; k < num; k++) {
+#ifdef NO_SUM_COMPUTATION
+    for (i = 0; i < statenum; i++) {
+      outcache[k][i] = INV_LOG_TEN * outcache[k][i] - dnn->state_prior[i];
+    }
+#else
+    float logprob = addlog_array(outcache[k], statenum);
+    for (i = 0; i < statenum; i++) {
+      outcache[k][i] = INV_LOG_TEN * (outcache[k][i] - logprob) - dnn->state_prior[i];
+    }
+#endif /* NO_SUM_COMPUTATION */
+  }
+
+  free(src);
+}
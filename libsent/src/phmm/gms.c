@@ -309,6 +309,8 @@ gms_init(HMMWork *wrk)
 
   /* init cache status */
   wrk->fallback_score = NULL;
+  wrk->gs_state2phone = NULL;
+  wrk->gs_la_score = NULL;
   wrk->gms_is_selected = NULL;
   wrk->gms_allocframenum = -1;
 
@@ -374,6 +376,12 @@ gms_free(HMMWork *wrk)
     free(wrk->gms_is_selected);
   }
   gms_gprune_free(wrk);
+  if (wrk->gs_state2phone != NULL) {
+    free(wrk->gs_state2phone);
+    free(wrk->gs_la_score);
+    wrk->gs_state2phone = NULL;
+    wrk->gs_la_score = NULL;
+  }
 }
 
 
@@ -410,3 +418,92 @@ gms_state(HMMWork *wrk)
   /* selected: calculate the real outprob of the state */
   return((*(wrk->calc_outprob))(wrk));
 }
+
+/**
+ * Prepare phone lookahead with GS %HMM.  Each GS %HMM is regarded as a
+ * phone, and the GS states are mapped to it.
+ * 
+ * @param wrk [i/o] HMM computation work area
+ * 
+ * @return the number of lookahead phones.
+ */
+int
+gms_lookahead_init(HMMWork *wrk)
+{
+  HTK_HMM_Data *dt;
+  int i, n;
+
+  if (wrk->gs_state2phone != NULL) return(wrk->gs_phone_num);
+
+  wrk->gs_state2phone = (int *)mymalloc(sizeof(int) * wrk->gsset_num);
+  for(i=0;i<wrk->gsset_num;i++) wrk->gs_state2phone[i] = -1;
+  n = 0;
+  for(dt = wrk->OP_gshmm->start; dt; dt=dt->next) {
+    for(i=1;i<dt->state_num-1;i++) {
+      if (dt->s[i] == NULL) continue;
+      wrk->gs_state2phone[dt->s[i]->id] = n;
+    }
+    n++;
+  }
+  wrk->gs_phone_num = n;
+  wrk->gs_la_score = (LOGPROB *)mymalloc(sizeof(LOGPROB) * wrk->gsset_num);
+
+  return(n);
+}
+
+/**
+ * Get lookahead phone ID of a logical %HMM, namely the ID of the GS %HMM
+ * whose first state corresponds to its base phone.
+ * 
+ * @param wrk [in] HMM computation work area
+ * @param l [in] logical %HMM
+ * 
+ * @return the lookahead phone ID, or -1 if not found.
+ */
+int
+gms_lookahead_phone(HMMWork *wrk, HMM_Logical *l)
+{
+  char gstr[MAX_HMMNAME_LEN], cbuf[MAX_HMMNAME_LEN];
+  HTK_HMM_State *cr;
+
+  if (strlen(l->name) >= MAX_HMMNAME_LEN - 2) return -1;
+  sprintf(gstr, "%s2m", center_name(l->name, cbuf));
+  if ((cr = state_lookup(wrk->OP_gshmm, gstr)) == NULL) return -1;
+  return(wrk->gs_state2phone[cr->id]);
+}
+
+/**
+ * Compute the best GS state score of each lookahead phone at a frame.
+ * The GMS status of the current frame is kept untouched.
+ * 
+ * @param wrk [i/o] HMM computation work area
+ * @param param [in] input parameter
+ * @param t [in] frame to compute
+ * @param phone_max [out] best score of each phone [0..gs_phone_num-1]
+ */
+void
+gms_lookahead_frame(HMMWork *wrk, HTK_Param *param, int t, LOGPROB *phone_max)
+{
+  VECT *vec_save[MAXSTREAMNUM];
+  LOGPROB *fs_save;
+  int i, d, p;
+
+  for(i=0;i<wrk->OP_nstream;i++) vec_save[i] = wrk->OP_vec_stream[i];
+  fs_save = wrk->t_fs;
+
+  for(d=0,i=0;i<wrk->OP_nstream;i++) {
+    wrk->OP_vec_stream[i] = &(param->parvec[t][d]);
+    d += wrk->OP_veclen_stream[i];
+  }
+  wrk->t_fs = wrk->gs_la_score;
+  compute_gs_scores(wrk);
+
+  for(p=0;p<wrk->gs_phone_num;p++) phone_max[p] = LOG_ZERO;
+  for(i=0;i<wrk->gsset_num;i++) {
+    p = wrk->gs_state2phone[i];
+    if (p >= 0 && phone_max[p] < wrk->gs_la_score[i]) phone_max[p] = wrk->gs_la_score[i];
+  }
+
+  for(i=0;i<wrk->OP_nstream;i++) wrk->OP_vec_stream[i] = vec_save[i];
+  wrk->t_fs = fs_save;
+}
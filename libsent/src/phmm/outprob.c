@@ -82,11 +82,16 @@ outprob_cache_init(HMMWork *wrk)
   wrk->outprob_allocframenum = 0;
   wrk->OP_time = -1;
   wrk->croot = NULL;
+  wrk->cache_keep_num = 0;
+  wrk->cache_kept_frames = 0;
+  wrk->cache_kept = 0;
   return TRUE;
 }
 
 /** 
  * Prepare cache for the next input, by clearing the existing cache.
+ * If frames are marked by outprob_cache_keep(), they are moved to the
+ * head of the cache and kept for the next input.
  * 
  * @param wrk [i/o] HMM computation work area
  * 
@@ -96,9 +101,30 @@ boolean
 outprob_cache_prepare(HMMWork *wrk)
 {
   int s,t;
+  LOGPROB **tmp;
+
+  wrk->cache_kept_frames = 0;
+  wrk->cache_kept = 0;
+  if (wrk->cache_keep_num > 0) {
+    /* rotate the kept frames to the head */
+    if (wrk->cache_keep_start > 0) {
+      tmp = (LOGPROB **)mymalloc(sizeof(LOGPROB *) * wrk->cache_keep_start);
+      memcpy(tmp, wrk->outprob_cache, sizeof(LOGPROB *) * wrk->cache_keep_start);
+      memmove(wrk->outprob_cache, &(wrk->outprob_cache[wrk->cache_keep_start]), sizeof(LOGPROB *) * (wrk->outprob_allocframenum - wrk->cache_keep_start));
+      memcpy(&(wrk->outprob_cache[wrk->outprob_allocframenum - wrk->cache_keep_start]), tmp, sizeof(LOGPROB *) * wrk->cache_keep_start);
+      free(tmp);
+    }
+    for (t = 0; t < wrk->cache_keep_num; t++) {
+      for (s = 0; s < wrk->statenum; s++) {
+	if (wrk->outprob_cache[t][s] != LOG_UNDEF) wrk->cache_kept++;
+      }
+    }
+    wrk->cache_kept_frames = wrk->cache_keep_num;
+    wrk->cache_keep_num = 0;
+  }
 
   /* clear already allocated area */
-  for (t = 0; t < wrk->outprob_allocframenum; t++) {
+  for (t = wrk->cache_kept_frames; t < wrk->outprob_allocframenum; t++) {
     for (s = 0; s < wrk->statenum; s++) {
       wrk->outprob_cache[t][s] = LOG_UNDEF;
     }
@@ -148,6 +174,51 @@ outprob_cache_extend(HMMWork *wrk, int reqframe)
   wrk->outprob_allocframenum = newnum;
 }
 
+/** 
+ * Mark frames of the cache to be carried over to the next input.  At
+ * the next outprob_prepare(), the cached scores of frames
+ * [start..start+num-1] are kept as frames [0..num-1], instead of
+ * being cleared.  The caller should make sure that the next input
+ * begins with the same input vectors.
+ * 
+ * @param wrk [i/o] HMM computation work area
+ * @param start [in] first frame to be kept
+ * @param num [in] number of frames to be kept, 0 to cancel
+ */
+void
+outprob_cache_keep(HMMWork *wrk, int start, int num)
+{
+  if (start < 0 || start >= wrk->outprob_allocframenum) num = 0;
+  if (num > wrk->outprob_allocframenum - start) num = wrk->outprob_allocframenum - start;
+  wrk->cache_keep_start = start;
+  wrk->cache_keep_num = (num > 0) ? num : 0;
+}
+
+/** 
+ * Move the frames marked by outprob_cache_keep() to another work area
+ * of the same %HMM, when the work areas are swapped before the next input.
+ * 
+ * @param dst [i/o] HMM computation work area to be used for the next input
+ * @param src [i/o] HMM computation work area that has the marked frames
+ */
+void
+outprob_cache_carry(HMMWork *dst, HMMWork *src)
+{
+  int t, end;
+
+  dst->cache_keep_num = 0;
+  if (src->cache_keep_num > 0 && dst->statenum == src->statenum) {
+    end = src->cache_keep_start + src->cache_keep_num;
+    outprob_cache_extend(dst, end - 1);
+    for (t = src->cache_keep_start; t < end; t++) {
+      memcpy(dst->outprob_cache[t], src->outprob_cache[t], sizeof(LOGPROB) * src->statenum);
+    }
+    dst->cache_keep_start = src->cache_keep_start;
+    dst->cache_keep_num = src->cache_keep_num;
+  }
+  src->cache_keep_num = 0;
+}
+
 /**
  * Free work area for cache.
  * 
@@ -219,7 +290,12 @@ outprob_state(HMMWork *wrk, int t, HTK_HMM_State *stateinfo, HTK_Param *param)
     /* for DNN, if the frame is not computed yet, batch-compute for the frame and save them to current cache */
     s = wrk->OP_hmminfo->ststart;
     if (wrk->last_cache[s->id] == LOG_UNDEF) {
-      dnn_calc_outprob(wrk);
+      if (wrk->dnn_batch_func != NULL) {
+	/* let the scheduler compute it together with other streams */
+	(*(wrk->dnn_batch_func))(wrk);
+      } else {
+	dnn_calc_outprob(wrk);
+      }
     }
     wrk->OP_state = stateinfo;
     wrk->OP_state_id = sid;
@@ -157,6 +157,8 @@ outprob_init(HMMWork *wrk, HTK_HMM_INFO *hmminfo,
   wrk->OP_hmminfo = hmminfo;
   wrk->OP_gshmm = gshmm;		/* NULL if GMS not used */
   wrk->OP_dnn = dnn;			/* NULL if DNN not used */
+  wrk->dnn_batch_func = NULL;		/* set by external scheduler */
+  wrk->dnn_batch_data = NULL;
   wrk->OP_gprune_num = gprune_mixnum;
 
   /* store multi-stream data */
@@ -27,7 +27,8 @@
 #include <sent/vocabulary.h>
 
 /** 
- * Load and initialize a word dictionary.
+ * Load and initialize a word dictionary.  Binary dictionary made by
+ * mkbindict is detected automatically.
  * 
  * @param winfo [out] pointer to a word dictionary data to store the read data
  * @param filename [in] file name of the word dictionary to read
@@ -46,7 +47,15 @@ init_voca(WORD_INFO *winfo, char *filename, HTK_HMM_INFO *hmminfo, boolean not_c
     jlog("Error: init_voca: failed to open %s\n",filename);
     return(FALSE);
   }
-  if (!voca_load_htkdict(fd, winfo, hmminfo, not_conv_tri)) {
+  if (voca_is_bin(fd)) {
+    /* binary dictionary made by mkbindict */
+    jlog("Stat: init_voca: reading binary dictionary\n");
+    if (!voca_load_bin(fd, winfo, hmminfo, not_conv_tri)) {
+      jlog("Error: init_voca: error in reading binary dictionary %s\n", filename);
+      fclose_readfile(fd);
+      return(FALSE);
+    }
+  } else if (!voca_load_htkdict(fd, winfo, hmminfo, not_conv_tri)) {
     if (force_dict) {
       jlog("Warning: init_voca: the word errors are ignored\n");
     } else {
@@ -0,0 +1,524 @@
+/**
+ * @file   voca_bin.c
+ *
+ * <JA>
+ * @brief  バイナリ形式の単語辞書の読み書き
+ *
+ * 単語辞書をあらかじめトライフォン変換を済ませたバイナリ形式で保存し，
+ * 読み込み時のテキスト解析と論理 %HMM の検索を省略する. 音素列は
+ * 論理 %HMM リスト中の番号で保存されるため，作成時と同じ %HMM 定義と
+ * HMMList でのみ使用できる. 読み込み時には論理 %HMM リストのハッシュ値で
+ * これを確認する.
+ *
+ * バイナリ辞書はツール mkbindict で作成する.
+ * </JA>
+ *
+ * <EN>
+ * @brief  Read / write word dictionary in binary format
+ *
+ * The word dictionary can be stored in binary format, in which
+ * triphone conversion has already been done.  Loading it skips text
+ * parsing and logical %HMM lookup per phone.  Since the phone sequences
+ * are stored as indices in the logical %HMM list, the binary dictionary
+ * can only be used with the same %HMM definition and HMMList used at
+ * conversion.  This is checked by a hash value of the logical %HMM list
+ * at loading.
+ *
+ * The tool "mkbindict" converts a text dictionary to this format.
+ * </EN>
+ *
+ * @author Akinobu LEE
+ * @date   Mon Oct 19 18:02:11 2026
+ *
+ * $Revision: 1.1 $
+ *
+ */
+/*
+ * Copyright (c) 1991-2013 Kawahara Lab., Kyoto University
+ * Copyright (c) 2000-2005 Shikano Lab., Nara Institute of Science and Technology
+ * Copyright (c) 2005-2013 Julius project team, Nagoya Institute of Technology
+ * All rights reserved
+ */
+
+#include <sent/stddefs.h>
+#include <sent/vocabulary.h>
+#include <sent/htk_hmm.h>
+
+/* flags in the binary dictionary */
+#define BINDICT_HAS_PHONE  0x01	///< Phone sequences are stored
+#define BINDICT_TRICONV    0x02	///< Phones are converted to word-internal triphones
+#define BINDICT_HAS_CPROB  0x04	///< In-class word probabilities are stored
+#define BINDICT_HAS_WEIGHT 0x08	///< Word weights for MBR are stored
+#define BINDICT_FLAGS      0x0f	///< All known flags
+
+#define BINDICT_MAXBODY 0x7fffffff ///< Maximum size of body in bytes
+#define BINDICT_READUNIT 1048576   ///< Initial buffer size for reading body
+
+static boolean need_swap;	///< TRUE if need byte swap
+
+#define wrt(A,B,C,D) if (wrtfunc(A,B,C,D) == FALSE) return FALSE
+#define rdn(A,B,C,D) if (rdnfunc(A,B,C,D) == FALSE) return FALSE
+
+/**
+ * Binary write function.
+ *
+ * @param fp [in] file pointer
+ * @param buf [in] data buffer to write
+ * @param unitbyte [in] unit size in bytes
+ * @param unitnum [in] number of unit to write
+ */
+static boolean
+wrtfunc(FILE *fp, void *buf, size_t unitbyte, size_t unitnum)
+{
+  if (unitnum == 0) return TRUE;
+  if (myfwrite(buf, unitbyte, unitnum, fp) < unitnum) {
+    jlog("Error: voca_bin: failed to write %d bytes\n", (int)(unitbyte * unitnum));
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ * Binary read function with byte swapping if needed.
+ *
+ * @param fp [in] file pointer
+ * @param buf [out] data buffer to store the read data
+ * @param unitbyte [in] unit size in bytes
+ * @param unitnum [in] number of unit to read
+ */
+static boolean
+rdnfunc(FILE *fp, void *buf, size_t unitbyte, size_t unitnum)
+{
+  if (unitnum == 0) return TRUE;
+  if (myfread(buf, unitbyte, unitnum, fp) < unitnum) {
+    jlog("Error: voca_bin: failed to read %d bytes\n", (int)(unitbyte * unitnum));
+    return FALSE;
+  }
+  if (need_swap && unitbyte != 1) {
+    swap_bytes((char *)buf, unitbyte, unitnum);
+  }
+  return TRUE;
+}
+
+/**
+ * Add size of an area in the body, checking the number of units and
+ * the total size.
+ *
+ * @param size [i/o] total size in bytes
+ * @param num [in] number of units in the area
+ * @param unitbyte [in] unit size in bytes
+ *
+ * @return TRUE on success, FALSE if @a num is negative or too large.
+ */
+static boolean
+add_area(size_t *size, int num, size_t unitbyte)
+{
+  if (num < 0 || (size_t)num > (BINDICT_MAXBODY - *size) / unitbyte) return FALSE;
+  *size += unitbyte * num;
+  return TRUE;
+}
+
+/**
+ * Read the body of the given size.  The buffer grows as the data
+ * arrives, so a broken header does not make a buffer larger than the
+ * actual file.
+ *
+ * @param fp [in] file pointer
+ * @param size [in] size of the body in bytes
+ *
+ * @return newly allocated buffer holding the body, or NULL on failure.
+ */
+static char *
+read_body(FILE *fp, size_t size)
+{
+  char *buf;
+  size_t len, alloc, n;
+
+  alloc = (size < BINDICT_READUNIT) ? size : BINDICT_READUNIT;
+  buf = (char *)mymalloc(alloc > 0 ? alloc : 1);
+  len = 0;
+  while (len < size) {
+    if (len == alloc) {
+      alloc = (alloc > size - alloc) ? size : alloc * 2;
+      buf = (char *)myrealloc(buf, alloc);
+    }
+    n = myfread(&(buf[len]), 1, alloc - len, fp);
+    if (n == 0 || n == (size_t)-1) {
+      jlog("Error: voca_bin: failed to read %d bytes, file too short\n", (int)size);
+      free(buf);
+      return NULL;
+    }
+    len += n;
+  }
+  return buf;
+}
+
+/// Pair of logical %HMM and its index, for looking up the index by pointer
+typedef struct {
+  HMM_Logical *lg;		///< Logical %HMM
+  int id;			///< Index in the logical %HMM list
+} LGID;
+
+static int
+lgid_cmp(LGID *a, LGID *b)
+{
+  if (a->lg < b->lg) return -1;
+  if (a->lg > b->lg) return 1;
+  return 0;
+}
+
+/**
+ * Check if the file is a binary dictionary by the identifier at the
+ * top.  The file position is rewound to the beginning.
+ *
+ * @param fp [in] file pointer opened by fopen_readfile()
+ *
+ * @return TRUE if the file is a binary dictionary, FALSE if not.
+ */
+boolean
+voca_is_bin(FILE *fp)
+{
+  char buf[sizeof(BINDICT_IDSTR)];
+  boolean ret;
+
+  ret = FALSE;
+  if (myfread(buf, 1, sizeof(BINDICT_IDSTR) - 1, fp) == sizeof(BINDICT_IDSTR) - 1) {
+    if (strnmatch(buf, BINDICT_IDSTR, sizeof(BINDICT_IDSTR) - 1)) ret = TRUE;
+  }
+  myfrewind(fp);
+
+  return(ret);
+}
+
+/**
+ * Write a word dictionary in binary format.  The phone sequences
+ * are stored as indices in the logical %HMM list of @a hmminfo,
+ * which should be the one used when the dictionary was read.
+ *
+ * @param fp [in] file pointer
+ * @param winfo [in] word dictionary to write
+ * @param hmminfo [in] %HMM definition used when reading @a winfo, or NULL
+ * @param headerstr [in] user header string
+ *
+ * @return TRUE on success, FALSE on failure.
+ */
+boolean
+voca_write_bin(FILE *fp, WORD_INFO *winfo, HTK_HMM_INFO *hmminfo, char *headerstr)
+{
+  char hbuf[BINDICT_HDSIZE];
+  LGID *lgid, key, *match;
+  HMM_Logical *lg;
+  int num, flags, lgnum, seqnum, strbytes;
+  unsigned int hash;
+  int *seq;
+  unsigned char *trans;
+  WORD_ID w;
+  int i, n, len;
+
+  /* header */
+  for(i=0;i<BINDICT_HDSIZE;i++) hbuf[i] = EOF;
+  len = strlen(BINDICT_IDSTR) + 1 + strlen(BINDICT_BYTEORDER_HEAD) + strlen(BINDICT_NATURAL_BYTEORDER) + 1;
+  snprintf(hbuf, BINDICT_HDSIZE, "%s\n%s%s\n%s", BINDICT_IDSTR, BINDICT_BYTEORDER_HEAD, BINDICT_NATURAL_BYTEORDER, headerstr ? headerstr : "");
+  if (headerstr && len + strlen(headerstr) >= BINDICT_HDSIZE) {
+    jlog("Warning: voca_bin: header too long, last will be truncated\n");
+  }
+  wrt(fp, hbuf, 1, BINDICT_HDSIZE);
+
+  num = winfo->num;
+  flags = 0;
+  hash = 0;
+  lgnum = 0;
+  seqnum = 0;
+  strbytes = 0;
+  if (hmminfo != NULL) {
+    flags |= BINDICT_HAS_PHONE;
+    if (winfo->do_conv) flags |= BINDICT_TRICONV;
+    hash = hmm_logical_hash(hmminfo);
+    for (lg = hmminfo->lgstart; lg; lg = lg->next) lgnum++;
+    for (w=0;w<num;w++) seqnum += winfo->wlen[w];
+  }
+#ifdef CLASS_NGRAM
+  flags |= BINDICT_HAS_CPROB;
+#endif
+#ifdef USE_MBR
+  if (winfo->weight) flags |= BINDICT_HAS_WEIGHT;
+#endif
+  for (w=0;w<num;w++) {
+    strbytes += strlen(winfo->wname[w]) + 1 + strlen(winfo->woutput[w]) + 1;
+  }
+  wrt(fp, &num, sizeof(int), 1);
+  wrt(fp, &flags, sizeof(int), 1);
+  wrt(fp, &hash, sizeof(unsigned int), 1);
+  wrt(fp, &lgnum, sizeof(int), 1);
+  wrt(fp, &seqnum, sizeof(int), 1);
+  wrt(fp, &strbytes, sizeof(int), 1);
+
+  /* phone sequences as logical HMM indices */
+  if (flags & BINDICT_HAS_PHONE) {
+    lgid = (LGID *)mymalloc(sizeof(LGID) * lgnum);
+    i = 0;
+    for (lg = hmminfo->lgstart; lg; lg = lg->next) {
+      lgid[i].lg = lg;
+      lgid[i].id = i;
+      i++;
+    }
+    qsort(lgid, lgnum, sizeof(LGID), (int (*)(const void *, const void *))lgid_cmp);
+    seq = (int *)mymalloc(sizeof(int) * (seqnum > 0 ? seqnum : 1));
+    n = 0;
+    for (w=0;w<num;w++) {
+      for (i=0;i<winfo->wlen[w];i++) {
+	key.lg = winfo->wseq[w][i];
+	match = (LGID *)bsearch(&key, lgid, lgnum, sizeof(LGID), (int (*)(const void *, const void *))lgid_cmp);
+	if (match == NULL) {
+	  jlog("Error: voca_bin: word \"%s\": phone \"%s\" not in logical HMM list\n", winfo->wname[w], winfo->wseq[w][i]->name);
+	  free(seq);
+	  free(lgid);
+	  return FALSE;
+	}
+	seq[n++] = match->id;
+      }
+    }
+    free(lgid);
+    if (wrtfunc(fp, seq, sizeof(int), seqnum) == FALSE) {
+      free(seq);
+      return FALSE;
+    }
+    free(seq);
+  }
+#ifdef CLASS_NGRAM
+  wrt(fp, winfo->cprob, sizeof(LOGPROB), num);
+#endif
+#ifdef USE_MBR
+  if (flags & BINDICT_HAS_WEIGHT) {
+    wrt(fp, winfo->weight, sizeof(LOGPROB), num);
+  }
+#endif
+  if (flags & BINDICT_HAS_PHONE) {
+    wrt(fp, winfo->wlen, sizeof(unsigned char), num);
+  }
+  trans = (unsigned char *)mymalloc(sizeof(unsigned char) * (num > 0 ? num : 1));
+  for (w=0;w<num;w++) trans[w] = winfo->is_transparent[w] ? 1 : 0;
+  if (wrtfunc(fp, trans, sizeof(unsigned char), num) == FALSE) {
+    free(trans);
+    return FALSE;
+  }
+  free(trans);
+  for (w=0;w<num;w++) {
+    wrt(fp, winfo->wname[w], 1, strlen(winfo->wname[w]) + 1);
+    wrt(fp, winfo->woutput[w], 1, strlen(winfo->woutput[w]) + 1);
+  }
+
+  return TRUE;
+}
+
+/**
+ * Read a word dictionary in binary format.  The whole body is read
+ * at once, and the word names and phone sequences are set directly
+ * from it.  When @a hmminfo is given, the logical %HMM list should
+ * match the one used at conversion.  The counts in the header are
+ * checked against the body before any word is set.
+ *
+ * @param fp [in] file pointer
+ * @param winfo [out] pointer to word dictionary to store the read data.
+ * @param hmminfo [in] HTK %HMM definition data.  if NULL, phonemes are ignored.
+ * @param ignore_tri_conv [in] TRUE if triphone conversion is ignored
+ *
+ * @return TRUE on success, FALSE on failure.
+ */
+boolean
+voca_load_bin(FILE *fp, WORD_INFO *winfo, HTK_HMM_INFO *hmminfo, boolean ignore_tri_conv)
+{
+  char hbuf[BINDICT_HDSIZE], *p, *q, *end;
+  int num, flags, lgnum, seqnum, strbytes;
+  unsigned int hash;
+  size_t size;
+  char *body, *tmp;
+  int *seq;
+  LOGPROB *cprob, *weight;
+  unsigned char *wlen, *trans;
+  HMM_Logical **lgarray, **seqarea, *lg;
+  WORD_ID w;
+  int i, n;
+
+  /* header */
+  need_swap = FALSE;
+  rdn(fp, hbuf, 1, BINDICT_HDSIZE);
+  hbuf[BINDICT_HDSIZE - 1] = '\0';
+  if (! strnmatch(hbuf, BINDICT_IDSTR, strlen(BINDICT_IDSTR))) {
+    jlog("Error: voca_bin: invalid header\n");
+    return FALSE;
+  }
+  p = strstr(hbuf, BINDICT_BYTEORDER_HEAD);
+  if (p == NULL) {
+    jlog("Error: voca_bin: no byte order information in header\n");
+    return FALSE;
+  }
+  p += strlen(BINDICT_BYTEORDER_HEAD);
+  if (! strnmatch(p, BINDICT_NATURAL_BYTEORDER, strlen(BINDICT_NATURAL_BYTEORDER))) {
+    need_swap = TRUE;
+  }
+
+  rdn(fp, &num, sizeof(int), 1);
+  rdn(fp, &flags, sizeof(int), 1);
+  rdn(fp, &hash, sizeof(unsigned int), 1);
+  rdn(fp, &lgnum, sizeof(int), 1);
+  rdn(fp, &seqnum, sizeof(int), 1);
+  rdn(fp, &strbytes, sizeof(int), 1);
+  if (flags & ~BINDICT_FLAGS) {
+    jlog("Error: voca_bin: unknown flags 0x%x in header\n", flags);
+    return FALSE;
+  }
+  if (num < 0 || num > MAX_WORD_NUM) {
+    jlog("Error: voca_bin: invalid number of words %d, should be 0..%d\n", num, MAX_WORD_NUM);
+    return FALSE;
+  }
+  if (lgnum < 0 || seqnum < 0 || strbytes < 0) {
+    jlog("Error: voca_bin: invalid header\n");
+    return FALSE;
+  }
+  /* each word has at least two terminated strings */
+  if (strbytes / 2 < num) {
+    jlog("Error: voca_bin: string area too small for %d words\n", num);
+    return FALSE;
+  }
+
+  voca_load_start(winfo, hmminfo, ignore_tri_conv);
+
+  if (hmminfo != NULL) {
+    /* check if the phone indices are valid for this HMM */
+    if (!(flags & BINDICT_HAS_PHONE)) {
+      jlog("Error: voca_bin: binary dictionary has no phone sequence\n");
+      return FALSE;
+    }
+    n = 0;
+    for (lg = hmminfo->lgstart; lg; lg = lg->next) n++;
+    if (n != lgnum || hash != hmm_logical_hash(hmminfo)) {
+      jlog("Error: voca_bin: binary dictionary was made for another HMM or HMMList\n");
+      return FALSE;
+    }
+    if (((flags & BINDICT_TRICONV) ? TRUE : FALSE) != winfo->do_conv) {
+      jlog("Error: voca_bin: triphone conversion %s at conversion, but %s now\n", (flags & BINDICT_TRICONV) ? "done" : "not done", winfo->do_conv ? "required" : "not required");
+      return FALSE;
+    }
+  }
+
+  /* read whole body at once */
+  size = 0;
+  if (((flags & BINDICT_HAS_PHONE) && !add_area(&size, seqnum, sizeof(int)))
+      || ((flags & BINDICT_HAS_CPROB) && !add_area(&size, num, sizeof(LOGPROB)))
+      || ((flags & BINDICT_HAS_WEIGHT) && !add_area(&size, num, sizeof(LOGPROB)))
+      || ((flags & BINDICT_HAS_PHONE) && !add_area(&size, num, sizeof(unsigned char)))
+      || !add_area(&size, num, sizeof(unsigned char))
+      || !add_area(&size, strbytes, 1)) {
+    jlog("Error: voca_bin: body size exceeds limit (%d bytes)\n", BINDICT_MAXBODY);
+    return FALSE;
+  }
+  if ((tmp = read_body(fp, size)) == NULL) return FALSE;
+  body = (char *)mybmalloc2(size, &(winfo->mroot));
+  memcpy(body, tmp, size);
+  free(tmp);
+
+  while (winfo->maxnum < num) {
+    if (winfo_expand(winfo) == FALSE) return FALSE;
+  }
+
+  p = body;
+  seq = NULL;
+  cprob = weight = NULL;
+  wlen = NULL;
+  if (flags & BINDICT_HAS_PHONE) {
+    seq = (int *)p;
+    p += sizeof(int) * seqnum;
+    if (need_swap) swap_bytes((char *)seq, sizeof(int), seqnum);
+  }
+  if (flags & BINDICT_HAS_CPROB) {
+    cprob = (LOGPROB *)p;
+    p += sizeof(LOGPROB) * num;
+    if (need_swap) swap_bytes((char *)cprob, sizeof(LOGPROB), num);
+  }
+  if (flags & BINDICT_HAS_WEIGHT) {
+    weight = (LOGPROB *)p;
+    p += sizeof(LOGPROB) * num;
+    if (need_swap) swap_bytes((char *)weight, sizeof(LOGPROB), num);
+  }
+  if (flags & BINDICT_HAS_PHONE) {
+    wlen = (unsigned char *)p;
+    p += sizeof(unsigned char) * num;
+  }
+  trans = (unsigned char *)p;
+  p += sizeof(unsigned char) * num;
+  end = p + strbytes;
+
+  /* word name and output string, each should end within the area */
+  for (w=0;w<num;w++) {
+    if ((q = memchr(p, '\0', end - p)) == NULL) {
+      jlog("Error: voca_bin: corrupted string area\n");
+      return FALSE;
+    }
+    winfo->wname[w] = p;
+    p = q + 1;
+    if ((q = memchr(p, '\0', end - p)) == NULL) {
+      jlog("Error: voca_bin: corrupted string area\n");
+      return FALSE;
+    }
+    winfo->woutput[w] = p;
+    p = q + 1;
+    winfo->is_transparent[w] = trans[w] ? TRUE : FALSE;
+  }
+  if (p != end) {
+    jlog("Error: voca_bin: corrupted string area\n");
+    return FALSE;
+  }
+
+  /* phone sequence */
+  if (hmminfo == NULL) {
+    for (w=0;w<num;w++) {
+      winfo->wseq[w] = NULL;
+      winfo->wlen[w] = 0;
+    }
+  } else {
+    lgarray = (HMM_Logical **)mymalloc(sizeof(HMM_Logical *) * (lgnum > 0 ? lgnum : 1));
+    i = 0;
+    for (lg = hmminfo->lgstart; lg; lg = lg->next) lgarray[i++] = lg;
+    seqarea = (HMM_Logical **)mybmalloc2(sizeof(HMM_Logical *) * (seqnum > 0 ? seqnum : 1), &(winfo->mroot));
+    n = 0;
+    for (w=0;w<num;w++) {
+      if (n + wlen[w] > seqnum) {
+	jlog("Error: voca_bin: corrupted phone sequence area\n");
+	free(lgarray);
+	return FALSE;
+      }
+      winfo->wlen[w] = wlen[w];
+      winfo->wseq[w] = &(seqarea[n]);
+      for (i=0;i<wlen[w];i++) {
+	if (seq[n] < 0 || seq[n] >= lgnum) {
+	  jlog("Error: voca_bin: word \"%s\": invalid phone index %d\n", winfo->wname[w], seq[n]);
+	  free(lgarray);
+	  return FALSE;
+	}
+	seqarea[n] = lgarray[seq[n]];
+	n++;
+      }
+    }
+    free(lgarray);
+  }
+
+#ifdef CLASS_NGRAM
+  winfo->cwnum = 0;
+  for (w=0;w<num;w++) {
+    winfo->cprob[w] = cprob ? cprob[w] : 0.0;
+    if (winfo->cprob[w] != 0.0) winfo->cwnum++;
+  }
+#endif
+#ifdef USE_MBR
+  if (weight != NULL) {
+    winfo->weight = (LOGPROB *)mymalloc(sizeof(LOGPROB) * winfo->maxnum);
+    memcpy(winfo->weight, weight, sizeof(LOGPROB) * num);
+  }
+#endif
+
+  winfo->num = num;
+  winfo->linenum = num;
+
+  return(voca_load_end(winfo));
+}
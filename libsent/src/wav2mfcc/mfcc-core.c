@@ -722,6 +722,229 @@ WMP_calc(MFCCWork *w, float *mfcc, Value *para)
   if (para->energy) mfcc[p++] = energy;
 }
 
+#ifdef MFCC_SINCOS_TABLE
+
+/** 
+ * FFT of all frames in a block at once.  Same as FFT(), with each
+ * butterfly applied to the WMP_BLOCK frames stored side by side.
+ * 
+ * @param xRe [i/o] [n][WMP_BLOCK] real part
+ * @param xIm [i/o] [n][WMP_BLOCK] imaginary part
+ * @param p [in] log2(n)
+ * @param w [i/o] MFCC calculation work area
+ */
+static void
+FFT_block(float *xRe, float *xIm, int p, MFCCWork *w)
+{
+  int i, ip, j, k, m, me, me1, n, nv2, b;
+  double uRe, uIm, vRe, vIm, wRe, wIm, tRe, tIm;
+  float *ar, *ai, *br, *bi;
+  
+  n = 1<<p;
+  nv2 = n / 2;
+  
+  j = 0;
+  for(i = 0; i < n-1; i++){
+    if(j > i){
+      for(b = 0; b < WMP_BLOCK; b++) {
+	tRe = xRe[j*WMP_BLOCK+b];   tIm = xIm[j*WMP_BLOCK+b];
+	xRe[j*WMP_BLOCK+b] = xRe[i*WMP_BLOCK+b];   xIm[j*WMP_BLOCK+b] = xIm[i*WMP_BLOCK+b];
+	xRe[i*WMP_BLOCK+b] = tRe;   xIm[i*WMP_BLOCK+b] = tIm;
+      }
+    }
+    k = nv2;
+    while(j >= k){
+      j -= k;      k /= 2;
+    }
+    j += k;
+  }
+
+  for(m = 1; m <= p; m++){
+    me = 1<<m;                me1 = me / 2;
+    uRe = 1.0;                uIm = 0.0;
+    wRe = w->costbl_fft[m-1];    wIm = w->sintbl_fft[m-1];
+    for(j = 0; j < me1; j++){
+      for(i = j; i < n; i += me){
+	ip = i + me1;
+	ar = &(xRe[i * WMP_BLOCK]);   ai = &(xIm[i * WMP_BLOCK]);
+	br = &(xRe[ip * WMP_BLOCK]);  bi = &(xIm[ip * WMP_BLOCK]);
+	for(b = 0; b < WMP_BLOCK; b++) {
+	  tRe = br[b] * uRe - bi[b] * uIm;
+	  tIm = br[b] * uIm + bi[b] * uRe;
+	  br[b] = ar[b] - tRe;   bi[b] = ai[b] - tIm;
+	  ar[b] += tRe;          ai[b] += tIm;
+	}
+      }
+      vRe = uRe * wRe - uIm * wIm;   vIm = uRe * wIm + uIm * wRe;
+      uRe = vRe;                     uIm = vIm;
+    }
+  }
+}
+
+/** 
+ * Calculate MFCC and log energy for successive frames, WMP_BLOCK
+ * frames at a time.  Windowing is done per frame, and FFT, filterbank
+ * and DCT are performed for all frames in a block at once, with
+ * the frames on the innermost loop.  Each frame goes through exactly
+ * the same operations as WMP_calc(), so the result is identical.
+ * 
+ * @param w [i/o] MFCC calculation work area
+ * @param mfcc [out] buffer to hold the resulting MFCC vectors
+ * @param para [in] configuration parameters
+ * @param wave [in] waveform, frame t begins at t * frameshift
+ * @param frame_num [in] number of frames to compute
+ */
+void
+WMP_calc_block(MFCCWork *w, float **mfcc, Value *para, SP16 *wave, int frame_num)
+{
+  float energy[WMP_BLOCK];
+  float c0[WMP_BLOCK];
+  float acc[WMP_BLOCK];
+  double a[WMP_BLOCK];
+  float *re, *im, *xr, *xi, *vec;
+  double *fb, *f;
+  double Re, Im, A, P, NP, H, wt, temp;
+  int t0, nb, b, i, j, k, bin, p, fftN, fbank_num;
+
+  fftN = w->fb.fftN;
+  fbank_num = para->fbank_num;
+  if (w->blk_re == NULL) {
+    w->blk_re = (float *)mymalloc(sizeof(float) * fftN * WMP_BLOCK);
+    w->blk_im = (float *)mymalloc(sizeof(float) * fftN * WMP_BLOCK);
+    w->blk_fbank = (double *)mymalloc(sizeof(double) * (fbank_num + 1) * WMP_BLOCK);
+  }
+  re = w->blk_re;
+  im = w->blk_im;
+  fb = w->blk_fbank;
+
+  for(t0 = 0; t0 < frame_num; t0 += WMP_BLOCK) {
+    nb = frame_num - t0;
+    if (nb > WMP_BLOCK) nb = WMP_BLOCK;
+
+    /* windowing per frame, and store them side by side */
+    for(b = 0; b < nb; b++) {
+      for(k = 1; k <= para->framesize; k++) {
+	w->bf[k] = (float)wave[(t0 + b) * para->frameshift + k - 1];
+      }
+      energy[b] = 0.0;
+      if (para->zmeanframe) {
+	ZMeanFrame(w->bf, para->framesize);
+      }
+      if (para->energy && para->raw_e) {
+	energy[b] = CalcLogRawE(w->bf, para->framesize);
+      }
+      PreEmphasise(w->bf, para->framesize, para->preEmph);
+      Hamming(w->bf, para->framesize, w);
+      if (para->energy && ! para->raw_e) {
+	energy[b] = CalcLogRawE(w->bf, para->framesize);
+      }
+      for(k = 1; k <= para->framesize; k++) re[(k - 1) * WMP_BLOCK + b] = w->bf[k];
+    }
+    /* unused slots of the last block */
+    for(b = nb; b < WMP_BLOCK; b++) {
+      for(k = 0; k < para->framesize; k++) re[k * WMP_BLOCK + b] = 0.0;
+    }
+    for(k = para->framesize * WMP_BLOCK; k < fftN * WMP_BLOCK; k++) re[k] = 0.0;
+    for(k = 0; k < fftN * WMP_BLOCK; k++) im[k] = 0.0;
+
+    /* Take FFT */
+    FFT_block(re, im, w->fb.n, w);
+
+    if (w->ssbuf != NULL) {
+      /* Spectral Subtraction */
+      for(k = 1; k <= fftN; k++){
+	NP = w->ssbuf[k - 1];
+	for(b = 0; b < nb; b++) {
+	  Re = re[(k - 1) * WMP_BLOCK + b];  Im = im[(k - 1) * WMP_BLOCK + b];
+	  P = sqrt(Re * Re + Im * Im);
+	  if((P * P -  w->ss_alpha * NP * NP) < 0){
+	    H = w->ss_floor;
+	  }else{
+	    H = sqrt(P * P - w->ss_alpha * NP * NP) / P;
+	  }
+	  re[(k - 1) * WMP_BLOCK + b] = H * Re;
+	  im[(k - 1) * WMP_BLOCK + b] = H * Im;
+	}
+      }
+    }
+
+    /* Fill filterbank channels: each FFT bin is shared by two
+       adjacent channels by loWt, so the filterbank matrix is
+       held as (loChan, loWt) per bin */
+    for(k = 0; k < (fbank_num + 1) * WMP_BLOCK; k++) fb[k] = 0.0;
+    for(k = w->fb.klo; k <= w->fb.khi; k++){
+      xr = &(re[(k - 1) * WMP_BLOCK]);
+      xi = &(im[(k - 1) * WMP_BLOCK]);
+      for(b = 0; b < WMP_BLOCK; b++) {
+	Re = xr[b]; Im = xi[b];
+	a[b] = Re * Re + Im * Im;
+      }
+      if (! para->usepower) {
+	for(b = 0; b < WMP_BLOCK; b++) a[b] = sqrt(a[b]);
+      }
+      bin = w->fb.loChan[k];
+      wt = w->fb.loWt[k];
+      if(bin > 0) {
+	f = &(fb[bin * WMP_BLOCK]);
+	for(b = 0; b < WMP_BLOCK; b++) f[b] += wt * a[b];
+      }
+      if(bin < fbank_num) {
+	f = &(fb[(bin + 1) * WMP_BLOCK]);
+	for(b = 0; b < WMP_BLOCK; b++) f[b] += a[b] - wt * a[b];
+      }
+    }
+    if (w->log_fbank) {
+      /* Take logs */
+      for(k = WMP_BLOCK; k < (fbank_num + 1) * WMP_BLOCK; k++) {
+	temp = fb[k];
+	if(temp < 1.0) temp = 1.0;
+	fb[k] = log(temp);
+      }
+    }
+
+    if (w->fbank_only) {
+      /* return the filterbank */
+      for(b = 0; b < nb; b++) {
+	for (p = 0; p < para->mfcc_dim; p++) {
+	  mfcc[t0 + b][p] = fb[(p + 1) * WMP_BLOCK + b];
+	}
+      }
+      continue;
+    }
+
+    /* 0'th cepstral parameter */
+    if (para->c0) {
+      for(b = 0; b < WMP_BLOCK; b++) acc[b] = 0.0;
+      for(j = 1; j <= fbank_num; j++) {
+	for(b = 0; b < WMP_BLOCK; b++) acc[b] += fb[j * WMP_BLOCK + b];
+      }
+      for(b = 0; b < WMP_BLOCK; b++) c0[b] = acc[b] * w->sqrt2var;
+    }
+    /* MFCC: DCT as matrix product of cos table and filterbank of the block,
+       then weight cepstrum */
+    for(i = 0; i < para->mfcc_dim; i++){
+      for(b = 0; b < WMP_BLOCK; b++) acc[b] = 0.0;
+      for(j = 1; j <= fbank_num; j++) {
+	A = w->costbl_makemfcc[i * fbank_num + j - 1];
+	for(b = 0; b < WMP_BLOCK; b++) acc[b] += fb[j * WMP_BLOCK + b] * A;
+      }
+      for(b = 0; b < nb; b++) {
+	vec = mfcc[t0 + b];
+	vec[i] = acc[b] * w->sqrt2var;
+	vec[i] *= w->sintbl_wcep[i];
+      }
+    }
+    /* set energy to mfcc */
+    for(b = 0; b < nb; b++) {
+      p = para->mfcc_dim;
+      if (para->c0) mfcc[t0 + b][p++] = c0[b];
+      if (para->energy) mfcc[t0 + b][p++] = energy[b];
+    }
+  }
+}
+
+#endif /* MFCC_SINCOS_TABLE */
+
 /** 
  * Free all work area for MFCC computation
  * 
@@ -738,6 +961,12 @@ WMP_free(MFCCWork *w)
     w->bf = NULL;
   }
 #ifdef MFCC_SINCOS_TABLE
+  if (w->blk_re) {
+    free(w->blk_re);
+    free(w->blk_im);
+    free(w->blk_fbank);
+    w->blk_re = NULL;
+  }
   if (w->costbl_hamming) {
     free(w->costbl_hamming);
     w->costbl_hamming = NULL;
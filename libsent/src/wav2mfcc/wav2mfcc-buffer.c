@@ -56,8 +56,10 @@
 int
 Wav2MFCC(SP16 *wave, float **mfcc, Value *para, int nSamples, MFCCWork *w, CMNWork *c)
 {
+#ifndef MFCC_SINCOS_TABLE
   int i, k, t;
   int end = 0, start = 1;
+#endif
   int frame_num;                    /* Number of samples in output file */
 
   /* set noise spectrum if any */
@@ -71,6 +73,10 @@ Wav2MFCC(SP16 *wave, float **mfcc, Value *para, int nSamples, MFCCWork *w, CMNWo
 
   frame_num = (int)((nSamples - para->framesize) / para->frameshift) + 1;
   
+#ifdef MFCC_SINCOS_TABLE
+  /* whole input is here, compute base MFCC coefficients by blocks */
+  WMP_calc_block(w, mfcc, para, wave, frame_num);
+#else
   for(t = 0; t < frame_num; t++){
     if(end != 0) start = end - (para->framesize - para->frameshift) - 1;
 
@@ -83,6 +89,7 @@ Wav2MFCC(SP16 *wave, float **mfcc, Value *para, int nSamples, MFCCWork *w, CMNWo
     /* Calculate base MFCC coefficients */
     WMP_calc(w, mfcc[t], para);
   }
+#endif
   
   /* Normalise Log Energy */
   if (para->energy && para->enormal) NormaliseLogE(mfcc, frame_num, para);
@@ -142,31 +149,41 @@ void NormaliseLogE(float **mfcc, int frame_num, Value *para)
 void Delta(float **c, int frame, Value *para)
 {
   int theta, t, n, B = 0;
-  float A1, A2, sum;
+  int baselen;
+  float *d, *sum, *A1, *A2;
 
   for(theta = 1; theta <= para->delWin; theta++)
     B += theta * theta;
 
-  for(n = para->baselen - 1; n >=0; n--){
-    for(t = 0; t < frame; t++){
-      sum = 0;
-      for(theta = 1; theta <= para->delWin; theta++){
-	/* Replicate the first or last vector */
-	/* at the beginning and end of speech */
-	if (t - theta < 0) A1 = c[0][n];
-	else A1 = c[t - theta][n];
-	if (t + theta >= frame) A2 = c[frame - 1][n];
-	else A2 = c[t + theta][n];
-	sum += theta * (A2 - A1);
-      }
-      sum /= (2.0 * B);
-      if (para->absesup) {
-	c[t][para->baselen + n - 1] = sum;
-      } else {
-	c[t][para->baselen + n] = sum;
-      }
+  baselen = para->baselen;
+  /* the delta of the last base coef. will be overwritten by that of the
+     first when absesup, so compute all before storing them */
+  d = (float *)mymalloc(sizeof(float) * frame * baselen);
+
+  for(t = 0; t < frame; t++){
+    sum = &(d[t * baselen]);
+    for(n = 0; n < baselen; n++) sum[n] = 0;
+    for(theta = 1; theta <= para->delWin; theta++){
+      /* Replicate the first or last vector */
+      /* at the beginning and end of speech */
+      if (t - theta < 0) A1 = c[0];
+      else A1 = c[t - theta];
+      if (t + theta >= frame) A2 = c[frame - 1];
+      else A2 = c[t + theta];
+      for(n = 0; n < baselen; n++) sum[n] += theta * (A2[n] - A1[n]);
     }
+    for(n = 0; n < baselen; n++) sum[n] /= (2.0 * B);
   }
+  for(t = 0; t < frame; t++){
+    sum = &(d[t * baselen]);
+    if (para->absesup) {
+      for(n = 0; n < baselen; n++) c[t][baselen + n - 1] = sum[n];
+    } else {
+      for(n = 0; n < baselen; n++) c[t][baselen + n] = sum[n];
+    }
+  }
+
+  free(d);
 }
 
 
@@ -181,31 +198,31 @@ void Accel(float **c, int frame, Value *para)
 {
   int theta, t, n, B = 0;
   int src, dst;
-  float A1, A2, sum;
+  float *sum, *A1, *A2;
 
   for(theta = 1; theta <= para->accWin; theta++)
     B += theta * theta;
 
+  /* first column of the delta coef. and that of the acceleration */
+  src = para->baselen;
+  if (para->absesup) src--;
+  dst = src + para->baselen;
+
+  sum = (float *)mymalloc(sizeof(float) * para->baselen);
   for(t = 0; t < frame; t++){
-    src = para->baselen * 2 - 1;
-    if (para->absesup) src--;
-    dst = src + para->baselen;
-    for(n = 0; n < para->baselen; n++){
-      sum = 0;
-      for(theta = 1; theta <= para->accWin; theta++){
-	/* Replicate the first or last vector */
-	/* at the beginning and end of speech */
-	if (t - theta < 0) A1 = c[0][src];
-	else A1 = c[t - theta][src];
-	if (t + theta >= frame) A2 = c[frame - 1][src];
-	else A2 = c[t + theta][src];
-	sum += theta * (A2 - A1);
-      }
-      c[t][dst] = sum / (2 * B);
-      src--;
-      dst--;
+    for(n = 0; n < para->baselen; n++) sum[n] = 0;
+    for(theta = 1; theta <= para->accWin; theta++){
+      /* Replicate the first or last vector */
+      /* at the beginning and end of speech */
+      if (t - theta < 0) A1 = &(c[0][src]);
+      else A1 = &(c[t - theta][src]);
+      if (t + theta >= frame) A2 = &(c[frame - 1][src]);
+      else A2 = &(c[t + theta][src]);
+      for(n = 0; n < para->baselen; n++) sum[n] += theta * (A2[n] - A1[n]);
     }
+    for(n = 0; n < para->baselen; n++) c[t][dst + n] = sum[n] / (2 * B);
   }
+  free(sum);
 }
 
 /** 
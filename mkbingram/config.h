@@ -0,0 +1,7 @@
+/* config.h.  Generated from config.h.in by configure.  */
+/* Define if you have winnls */
+/* #undef HAVE_WINNLS_H */
+
+/* Define if you have iconv function */
+#define HAVE_ICONV 1
+
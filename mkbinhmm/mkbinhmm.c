@@ -21,7 +21,8 @@ static void
 usage(char *s)
 {
   printf("mkbinhmm: convert HMM definition file to binary format for Julius\n");
-  printf("usage: %s [-htkconf HTKConfig] hmmdefs binhmm\n", s);
+  printf("usage: %s [-htkconf HTKConfig] [-image] hmmdefs binhmm\n", s);
+  printf("  -image: write memory-mappable image format\n");
   printf("\nLibrary configuration: ");
   confout_version(stdout);
   confout_am(stdout);
@@ -36,9 +37,11 @@ main(int argc, char *argv[])
   char *infile;
   char *outfile;
   char *conffile;
+  boolean image;
   int i;
 
   infile = outfile = conffile = NULL;
+  image = FALSE;
   for(i=1;i<argc;i++) {
     if (strmatch(argv[i], "-C") || strmatch(argv[i], "-htkconf")) {
       if (++i >= argc) {
@@ -46,6 +49,8 @@ main(int argc, char *argv[])
 	return -1;
       }
       conffile = argv[i];
+    } else if (strmatch(argv[i], "-image")) {
+      image = TRUE;
     } else {
       if (infile == NULL) {
 	infile = argv[i];
@@ -116,9 +121,16 @@ main(int argc, char *argv[])
     fprintf(stderr, "failed to open %s for writing\n", outfile);
     return -1;
   }
-  if (write_binhmm(fp, hmminfo, (para.loaded == 1) ? &para : NULL) == FALSE) {
-    fprintf(stderr, "failed to write to %s\n", outfile);
-    return -1;
+  if (image) {
+    if (write_binhmm_image(fp, hmminfo, (para.loaded == 1) ? &para : NULL) == FALSE) {
+      fprintf(stderr, "failed to write to %s\n", outfile);
+      return -1;
+    }
+  } else {
+    if (write_binhmm(fp, hmminfo, (para.loaded == 1) ? &para : NULL) == FALSE) {
+      fprintf(stderr, "failed to write to %s\n", outfile);
+      return -1;
+    }
   }
   if (fclose_writefile(fp) != 0) {
     fprintf(stderr, "failed to close %s\n", outfile);